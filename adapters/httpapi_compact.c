@@ -14,6 +14,7 @@
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 
 #ifdef _MSC_VER
@@ -38,9 +39,49 @@
 #define MAX_RECEIVE_RETRY   200
 /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
 #define RETRY_INTERVAL_IN_MICROSECONDS  100
+/*Codes_SRS_HTTPAPI_COMPACT_01_014: [ If nothing is received for 30 seconds, the asynchronous request shall complete with HTTPAPI_READ_DATA_FAILED. ]*/
+#define ASYNC_REQUEST_IDLE_TIMEOUT_IN_MILLISECONDS  ((MAX_OPEN_RETRY + MAX_RECEIVE_RETRY) * RETRY_INTERVAL_IN_MICROSECONDS)
 
 DEFINE_ENUM_STRINGS(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES)
 
+typedef enum HTTP_ASYNC_STATE_TAG
+{
+    HTTP_ASYNC_STATE_OPENING,
+    HTTP_ASYNC_STATE_STATUS_LINE,
+    HTTP_ASYNC_STATE_HEADERS,
+    HTTP_ASYNC_STATE_BODY,
+    HTTP_ASYNC_STATE_CHUNK_SIZE,
+    HTTP_ASYNC_STATE_CHUNK_DATA,
+    HTTP_ASYNC_STATE_CHUNK_DATA_END,
+    HTTP_ASYNC_STATE_TRAILER,
+    HTTP_ASYNC_STATE_COMPLETE
+} HTTP_ASYNC_STATE;
+
+/*a request started by HTTPAPI_ExecuteRequestAsync, the response is parsed as the bytes arrive*/
+typedef struct HTTP_ASYNC_REQUEST_TAG
+{
+    HTTP_ASYNC_STATE state;
+    HTTPAPI_RESULT result;
+    unsigned char* request_bytes;
+    size_t request_size;
+    bool is_head;
+    bool is_interim_response;
+    bool is_chunked;
+    bool close_connection;
+    unsigned int status_code;
+    size_t body_length;
+    size_t body_remaining;
+    size_t body_received;
+    HTTP_HEADERS_HANDLE response_headers;
+    BUFFER_HANDLE response_content;
+    tickcounter_ms_t last_activity;
+    ON_HTTPAPI_REQUEST_COMPLETE on_request_complete;
+    void* callback_context;
+    size_t line_length;
+    char line[TEMP_BUFFER_SIZE];
+    struct HTTP_ASYNC_REQUEST_TAG* next; /*the request whose response follows on the connection, when pipelining*/
+} HTTP_ASYNC_REQUEST;
+
 typedef struct HTTP_HANDLE_DATA_TAG
 {
     char*           certificate;
@@ -49,6 +90,8 @@ typedef struct HTTP_HANDLE_DATA_TAG
     XIO_HANDLE      xio_handle;
     size_t          received_bytes_count;
     unsigned char*  received_bytes;
+    HTTP_ASYNC_REQUEST* async_request;
+    TICK_COUNTER_HANDLE tick_counter;
     unsigned int    is_io_error : 1;
     unsigned int    is_connected : 1;
     unsigned int    send_completed : 1;
@@ -240,6 +283,8 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                 http_instance->is_io_error = 0;
                 http_instance->received_bytes_count = 0;
                 http_instance->received_bytes = NULL;
+                http_instance->async_request = NULL;
+                http_instance->tick_counter = NULL;
                 http_instance->certificate = NULL;
                 http_instance->x509ClientCertificate = NULL;
                 http_instance->x509ClientPrivateKey = NULL;
@@ -268,6 +313,17 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
     /*Codes_SRS_HTTPAPI_COMPACT_21_020: [ If the connection handle is NULL, the HTTPAPI_CloseConnection shall not do anything. ]*/
     if (http_instance != NULL)
     {
+        if (http_instance->async_request != NULL)
+        {
+            HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+            http_instance->async_request = NULL;
+
+            /*Codes_SRS_HTTPAPI_COMPACT_01_017: [ If an asynchronous request is in progress, the HTTPAPI_CloseConnection shall call its on_request_complete with HTTPAPI_ERROR before closing the connection. ]*/
+            async_request->on_request_complete(async_request->callback_context, HTTPAPI_ERROR, 0);
+            free(async_request->request_bytes);
+            free(async_request);
+        }
+
         /*Codes_SRS_HTTPAPI_COMPACT_21_019: [ If there is no previous connection, the HTTPAPI_CloseConnection shall not do anything. ]*/
         if (http_instance->xio_handle != NULL)
         {
@@ -328,6 +384,11 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
         {
             free(http_instance->x509ClientPrivateKey);
         }
+
+        if (http_instance->tick_counter != NULL)
+        {
+            tickcounter_destroy(http_instance->tick_counter);
+        }
         free(http_instance);
     }
 }
@@ -396,6 +457,308 @@ static int InternStrnicmp(const char* s1, const char* s2, size_t n)
     return result;
 }
 
+static void async_request_set_result(HTTP_ASYNC_REQUEST* async_request, HTTPAPI_RESULT result)
+{
+    if (result != HTTPAPI_OK)
+    {
+        LogError("Asynchronous HTTP request failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    async_request->result = result;
+    async_request->state = HTTP_ASYNC_STATE_COMPLETE;
+}
+
+static void async_request_on_headers_end(HTTP_ASYNC_REQUEST* async_request)
+{
+    if (async_request->is_interim_response)
+    {
+        /*a 1xx response is followed by the final response*/
+        async_request->is_interim_response = false;
+        async_request->body_length = 0;
+        async_request->is_chunked = false;
+        async_request->state = HTTP_ASYNC_STATE_STATUS_LINE;
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_42_084: [ The message received by the HTTPAPI_ExecuteRequest should not contain http body. ]*/
+    else if (async_request->is_head || (async_request->status_code == 204) || (async_request->status_code == 304))
+    {
+        async_request_set_result(async_request, HTTPAPI_OK);
+    }
+    else if (async_request->is_chunked)
+    {
+        /*the chunks are appended to an empty content, BUFFER_unbuild fails only if it is already empty*/
+        if (async_request->response_content != NULL)
+        {
+            (void)BUFFER_unbuild(async_request->response_content);
+        }
+        async_request->body_received = 0;
+        async_request->state = HTTP_ASYNC_STATE_CHUNK_SIZE;
+    }
+    else if (async_request->body_length == 0)
+    {
+        async_request_set_result(async_request, HTTPAPI_OK);
+    }
+    else if ((async_request->response_content != NULL) &&
+        (BUFFER_pre_build(async_request->response_content, async_request->body_length) != 0))
+    {
+        async_request_set_result(async_request, HTTPAPI_ALLOC_FAILED);
+    }
+    else
+    {
+        async_request->body_remaining = async_request->body_length;
+        async_request->body_received = 0;
+        async_request->state = HTTP_ASYNC_STATE_BODY;
+    }
+}
+
+static void async_request_on_header_line(HTTP_ASYNC_REQUEST* async_request, char* line)
+{
+    const char ContentLength[] = "content-length:";
+    const size_t ContentLengthSize = sizeof(ContentLength) - 1;
+    const char TransferEncoding[] = "transfer-encoding:";
+    const size_t TransferEncodingSize = sizeof(TransferEncoding) - 1;
+    const char Chunked[] = "chunked";
+    const size_t ChunkedSize = sizeof(Chunked) - 1;
+    const char Connection[] = "connection:";
+    const size_t ConnectionSize = sizeof(Connection) - 1;
+    const char Close[] = "close";
+    const size_t CloseSize = sizeof(Close) - 1;
+
+    if (InternStrnicmp(line, ContentLength, ContentLengthSize) == 0)
+    {
+        int lengthInMsg;
+        if ((ParseStringToDecimal(line + ContentLengthSize, &lengthInMsg) != 1) || (lengthInMsg < 0))
+        {
+            async_request_set_result(async_request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+        }
+        else
+        {
+            async_request->body_length = (size_t)lengthInMsg;
+        }
+    }
+    else if (InternStrnicmp(line, TransferEncoding, TransferEncodingSize) == 0)
+    {
+        const char* substr = line + TransferEncodingSize;
+        while (isspace((unsigned char)*substr)) substr++;
+        if (InternStrnicmp(substr, Chunked, ChunkedSize) == 0)
+        {
+            async_request->is_chunked = true;
+        }
+    }
+    else if (InternStrnicmp(line, Connection, ConnectionSize) == 0)
+    {
+        const char* substr = line + ConnectionSize;
+        while (isspace((unsigned char)*substr)) substr++;
+        if (InternStrnicmp(substr, Close, CloseSize) == 0)
+        {
+            async_request->close_connection = true;
+        }
+    }
+
+    if ((async_request->state != HTTP_ASYNC_STATE_COMPLETE) &&
+        (async_request->response_headers != NULL) &&
+        !async_request->is_interim_response)
+    {
+        char* whereIsColon = strchr(line, ':');
+        if (whereIsColon != NULL)
+        {
+            *whereIsColon = '\0';
+            /*Codes_SRS_HTTPAPI_COMPACT_01_009: [ The response headers shall be added to the responseHeadersHandle, if it is not NULL. ]*/
+            if (HTTPHeaders_AddHeaderNameValuePair(async_request->response_headers, line, whereIsColon + 1) != HTTP_HEADERS_OK)
+            {
+                async_request_set_result(async_request, HTTPAPI_HTTP_HEADERS_FAILED);
+            }
+        }
+    }
+}
+
+static void async_request_on_line(HTTP_ASYNC_REQUEST* async_request)
+{
+    char* line = async_request->line;
+
+    switch (async_request->state)
+    {
+    default:
+        break;
+
+    case HTTP_ASYNC_STATE_STATUS_LINE:
+    {
+        int status;
+        if ((ParseHttpResponse(line, &status) != 1) || (status < 0))
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_013: [ If the response cannot be parsed, the asynchronous request shall complete with HTTPAPI_RECEIVE_RESPONSE_FAILED; if a memory allocation fails, with HTTPAPI_ALLOC_FAILED; if the transport reports an error, with HTTPAPI_READ_DATA_FAILED. ]*/
+            async_request_set_result(async_request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+        }
+        else
+        {
+            async_request->status_code = (unsigned int)status;
+            async_request->is_interim_response = (status >= 100) && (status < 200);
+            async_request->state = HTTP_ASYNC_STATE_HEADERS;
+        }
+        break;
+    }
+
+    case HTTP_ASYNC_STATE_HEADERS:
+        if (line[0] == '\0')
+        {
+            async_request_on_headers_end(async_request);
+        }
+        else
+        {
+            async_request_on_header_line(async_request, line);
+        }
+        break;
+
+    case HTTP_ASYNC_STATE_CHUNK_SIZE:
+    {
+        size_t chunkSize;
+        if (ParseStringToHexadecimal(line, &chunkSize) != 1)
+        {
+            async_request_set_result(async_request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+        }
+        else if (chunkSize == 0)
+        {
+            async_request->state = HTTP_ASYNC_STATE_TRAILER;
+        }
+        else if ((async_request->response_content != NULL) &&
+            (BUFFER_enlarge(async_request->response_content, chunkSize) != 0))
+        {
+            async_request_set_result(async_request, HTTPAPI_ALLOC_FAILED);
+        }
+        else
+        {
+            async_request->body_remaining = chunkSize;
+            async_request->state = HTTP_ASYNC_STATE_CHUNK_DATA;
+        }
+        break;
+    }
+
+    case HTTP_ASYNC_STATE_CHUNK_DATA_END:
+        if (line[0] != '\0')
+        {
+            async_request_set_result(async_request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+        }
+        else
+        {
+            async_request->state = HTTP_ASYNC_STATE_CHUNK_SIZE;
+        }
+        break;
+
+    case HTTP_ASYNC_STATE_TRAILER:
+        /*trailer fields are ignored, an empty line ends the response*/
+        if (line[0] == '\0')
+        {
+            async_request_set_result(async_request, HTTPAPI_OK);
+        }
+        break;
+    }
+}
+
+/*moves to the next pipelined request once a response is complete, returns false if there is none to wait for*/
+static bool async_request_advance(HTTP_HANDLE_DATA* http_instance)
+{
+    bool result;
+    HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_024: [ After a failed response, or a response with `Connection: close`, the following requests of the batch shall not be waited for and shall be reported with HTTPAPI_ERROR. ]*/
+    if ((async_request->next == NULL) ||
+        (async_request->result != HTTPAPI_OK) ||
+        async_request->close_connection)
+    {
+        result = false;
+    }
+    else
+    {
+        http_instance->async_request = async_request->next;
+        (void)tickcounter_get_current_ms(http_instance->tick_counter, &http_instance->async_request->last_activity);
+        result = true;
+    }
+
+    return result;
+}
+
+/*Codes_SRS_HTTPAPI_COMPACT_01_008: [ The response shall be parsed incrementally, as the bytes are delivered by the transport. ]*/
+static void async_request_on_bytes_received(HTTP_HANDLE_DATA* http_instance, const unsigned char* buffer, size_t size)
+{
+    HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+
+    (void)tickcounter_get_current_ms(http_instance->tick_counter, &async_request->last_activity);
+
+    while (size > 0)
+    {
+        if (async_request->state == HTTP_ASYNC_STATE_COMPLETE)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_023: [ The responses of a batch shall be parsed in the order of the requests, the bytes that follow a complete response belong to the next one. ]*/
+            if (!async_request_advance(http_instance))
+            {
+                break;
+            }
+            async_request = http_instance->async_request;
+        }
+        else if ((async_request->state == HTTP_ASYNC_STATE_BODY) ||
+            (async_request->state == HTTP_ASYNC_STATE_CHUNK_DATA))
+        {
+            size_t toCopy = (size < async_request->body_remaining) ? size : async_request->body_remaining;
+
+            /*Codes_SRS_HTTPAPI_COMPACT_01_010: [ A body sent with Content-Length or chunked transfer encoding shall be copied into responseContent; if responseContent is NULL, it shall be ignored. ]*/
+            if (async_request->response_content != NULL)
+            {
+                (void)memcpy(BUFFER_u_char(async_request->response_content) + async_request->body_received, buffer, toCopy);
+            }
+            async_request->body_received += toCopy;
+            async_request->body_remaining -= toCopy;
+            buffer += toCopy;
+            size -= toCopy;
+
+            if (async_request->body_remaining == 0)
+            {
+                if (async_request->state == HTTP_ASYNC_STATE_BODY)
+                {
+                    async_request_set_result(async_request, HTTPAPI_OK);
+                }
+                else
+                {
+                    async_request->state = HTTP_ASYNC_STATE_CHUNK_DATA_END;
+                }
+            }
+        }
+        else
+        {
+            /*lines are gathered up to the '\n', the '\r' before it is dropped*/
+            const unsigned char* endOfLine = (const unsigned char*)memchr(buffer, '\n', size);
+            size_t toCopy = (endOfLine == NULL) ? size : (size_t)(endOfLine - buffer);
+
+            if (toCopy >= (sizeof(async_request->line) - async_request->line_length))
+            {
+                LogError("Received message is bigger than the http buffer");
+                async_request_set_result(async_request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+            }
+            else
+            {
+                (void)memcpy(async_request->line + async_request->line_length, buffer, toCopy);
+                async_request->line_length += toCopy;
+
+                if (endOfLine == NULL)
+                {
+                    size = 0;
+                }
+                else
+                {
+                    buffer += toCopy + 1;
+                    size -= toCopy + 1;
+
+                    if ((async_request->line_length > 0) && (async_request->line[async_request->line_length - 1] == '\r'))
+                    {
+                        async_request->line_length--;
+                    }
+                    async_request->line[async_request->line_length] = '\0';
+                    async_request->line_length = 0;
+
+                    async_request_on_line(async_request);
+                }
+            }
+        }
+    }
+}
+
 static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     unsigned char* new_received_bytes;
@@ -409,6 +772,10 @@ static void on_bytes_received(void* context, const unsigned char* buffer, size_t
             http_instance->is_io_error = 1;
             LogError("NULL pointer error");
         }
+        else if (http_instance->async_request != NULL)
+        {
+            async_request_on_bytes_received(http_instance, buffer, size);
+        }
         else
         {
             /* Here we got some bytes so we'll buffer them so the receive functions can consumer it */
@@ -553,10 +920,15 @@ static int readLine(HTTP_HANDLE_DATA* http_instance, char* buf, const size_t max
                             break;
                         }
                     }
+                    else if ((receivedByte + 1) >= (http_instance->received_bytes + http_instance->received_bytes_count))
+                    {
+                        /*the '\n' that follows the '\r' has not arrived yet, it shall not be left for the next read*/
+                        break;
+                    }
                     else
                     {
                         receivedByte++;
-                        if ((receivedByte < (http_instance->received_bytes + http_instance->received_bytes_count)) && ((*receivedByte) == '\n'))
+                        if ((*receivedByte) == '\n')
                         {
                             receivedByte++;
                         }
@@ -689,6 +1061,42 @@ static int skipN(HTTP_HANDLE_DATA* http_instance, size_t n)
 }
 
 
+static HTTPAPI_RESULT SetTransportOptions(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTPAPI_RESULT result;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_21_022: [ If a Certificate was provided, the HTTPAPI_ExecuteRequest shall set this option on the transport layer. ]*/
+    if ((http_instance->certificate != NULL) &&
+        (xio_setoption(http_instance->xio_handle, OPTION_TRUSTED_CERT, http_instance->certificate) != 0))
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_023: [ If the transport failed setting the Certificate, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ]*/
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogInfo("Could not load certificate");
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_06_003: [ If the x509 client certificate is provided, the HTTPAPI_ExecuteRequest shall set this option on the transport layer. ]*/
+    else if ((http_instance->x509ClientCertificate != NULL) &&
+        (xio_setoption(http_instance->xio_handle, SU_OPTION_X509_CERT, http_instance->x509ClientCertificate) != 0))
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_06_005: [ If the transport failed setting the client certificate, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ]*/
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogInfo("Could not load the client certificate");
+    }
+    else if ((http_instance->x509ClientPrivateKey != NULL) &&
+        (xio_setoption(http_instance->xio_handle, SU_OPTION_X509_PRIVATE_KEY, http_instance->x509ClientPrivateKey) != 0))
+    {
+
+        /*Codes_SRS_HTTPAPI_COMPACT_06_006: [ If the transport failed setting the client certificate private key, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ] */
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogInfo("Could not load the client certificate private key");
+    }
+    else
+    {
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
 /*Codes_SRS_HTTPAPI_COMPACT_21_021: [ The HTTPAPI_ExecuteRequest shall execute the http communtication with the provided host, sending a request and reciving the response. ]*/
 static HTTPAPI_RESULT OpenXIOConnection(HTTP_HANDLE_DATA* http_instance)
 {
@@ -703,31 +1111,7 @@ static HTTPAPI_RESULT OpenXIOConnection(HTTP_HANDLE_DATA* http_instance)
     {
         http_instance->is_io_error = 0;
 
-        /*Codes_SRS_HTTPAPI_COMPACT_21_022: [ If a Certificate was provided, the HTTPAPI_ExecuteRequest shall set this option on the transport layer. ]*/
-        if ((http_instance->certificate != NULL) &&
-            (xio_setoption(http_instance->xio_handle, OPTION_TRUSTED_CERT, http_instance->certificate) != 0))
-        {
-            /*Codes_SRS_HTTPAPI_COMPACT_21_023: [ If the transport failed setting the Certificate, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ]*/
-            result = HTTPAPI_SET_OPTION_FAILED;
-            LogInfo("Could not load certificate");
-        }
-        /*Codes_SRS_HTTPAPI_COMPACT_06_003: [ If the x509 client certificate is provided, the HTTPAPI_ExecuteRequest shall set this option on the transport layer. ]*/
-        else if ((http_instance->x509ClientCertificate != NULL) &&
-            (xio_setoption(http_instance->xio_handle, SU_OPTION_X509_CERT, http_instance->x509ClientCertificate) != 0))
-        {
-            /*Codes_SRS_HTTPAPI_COMPACT_06_005: [ If the transport failed setting the client certificate, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ]*/
-            result = HTTPAPI_SET_OPTION_FAILED;
-            LogInfo("Could not load the client certificate");
-        }
-        else if ((http_instance->x509ClientPrivateKey != NULL) &&
-            (xio_setoption(http_instance->xio_handle, SU_OPTION_X509_PRIVATE_KEY, http_instance->x509ClientPrivateKey) != 0))
-        {
-
-            /*Codes_SRS_HTTPAPI_COMPACT_06_006: [ If the transport failed setting the client certificate private key, the HTTPAPI_ExecuteRequest shall not send any request and return HTTPAPI_SET_OPTION_FAILED. ] */
-            result = HTTPAPI_SET_OPTION_FAILED;
-            LogInfo("Could not load the client certificate private key");
-        }
-        else
+        if ((result = SetTransportOptions(http_instance)) == HTTPAPI_OK)
         {
             /*Codes_SRS_HTTPAPI_COMPACT_21_024: [ The HTTPAPI_ExecuteRequest shall open the transport connection with the host to send the request. ]*/
             if (xio_open(http_instance->xio_handle, on_io_open_complete, http_instance, on_bytes_received, http_instance, on_io_error, http_instance) != 0)
@@ -824,49 +1208,54 @@ const char* get_request_type(HTTPAPI_REQUEST_TYPE requestType)
 }
 
 /*Codes_SRS_HTTPAPI_COMPACT_21_026: [ If the open process succeed, the HTTPAPI_ExecuteRequest shall send the request message to the host. ]*/
-static HTTPAPI_RESULT SendHeadsToXIO(HTTP_HANDLE_DATA* http_instance, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle, size_t headersCount)
+static HTTPAPI_RESULT SendHeadsToXIO(HTTP_HANDLE_DATA* http_instance, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle)
 {
     HTTPAPI_RESULT result;
     char    buf[TEMP_BUFFER_SIZE];
+    char*   heads = buf;
+    size_t  headersSize;
     int     ret;
 
-    //Send request
+    //Build the request line, the headers and the blank line that closes them, to send them in one piece
     /*Codes_SRS_HTTPAPI_COMPACT_21_038: [ The HTTPAPI_ExecuteRequest shall execute the resquest for the path in relativePath parameter. ]*/
     /*Codes_SRS_HTTPAPI_COMPACT_21_036: [ The request type shall be provided in the parameter requestType. ]*/
-    if (((ret = snprintf(buf, sizeof(buf), "%s %s HTTP/1.1\r\n", get_request_type(requestType), relativePath)) < 0) ||
-        ((size_t)ret >= sizeof(buf)))
+    if (((ret = snprintf(buf, sizeof(buf) - 2, "%s %s HTTP/1.1\r\n", get_request_type(requestType), relativePath)) < 0) ||
+        ((size_t)ret >= sizeof(buf) - 2))
     {
         /*Codes_SRS_HTTPAPI_COMPACT_21_027: [ If the HTTPAPI_ExecuteRequest cannot create a buffer to send the request, it shall not send any request and return HTTPAPI_STRING_PROCESSING_ERROR. ]*/
         result = HTTPAPI_STRING_PROCESSING_ERROR;
     }
-        /*Codes_SRS_HTTPAPI_COMPACT_21_028: [ If the HTTPAPI_ExecuteRequest cannot send the request header, it shall return HTTPAPI_HTTP_HEADERS_FAILED. ]*/
-    else if ((result = conn_send_all(http_instance, (const unsigned char*)buf, strlen(buf))) == HTTPAPI_OK)
+    else
     {
-        size_t i;
-        //Send default headers
-        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-        for (i = 0; ((i < headersCount) && (result == HTTPAPI_OK)); i++)
+        HTTP_HEADERS_RESULT headersResult = HTTPHeaders_SerializeTo(httpHeadersHandle, buf + ret, sizeof(buf) - 2 - (size_t)ret, &headersSize);
+
+        /*the headers that do not fit in the stack buffer are serialized again in one allocated to their size*/
+        if ((headersResult == HTTP_HEADERS_INSUFFICIENT_BUFFER) &&
+            ((heads = (char*)malloc((size_t)ret + headersSize + 2)) != NULL))
         {
-            char* header;
-            if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &header) != HTTP_HEADERS_OK)
-            {
-                /*Codes_SRS_HTTPAPI_COMPACT_21_027: [ If the HTTPAPI_ExecuteRequest cannot create a buffer to send the request, it shall not send any request and return HTTPAPI_STRING_PROCESSING_ERROR. ]*/
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
-            }
-            else
-            {
-                if ((result = conn_send_all(http_instance, (const unsigned char*)header, strlen(header))) == HTTPAPI_OK)
-                {
-                    result = conn_send_all(http_instance, (const unsigned char*)"\r\n", (size_t)2);
-                }
-                free(header);
-            }
+            (void)memcpy(heads, buf, (size_t)ret);
+            headersResult = HTTPHeaders_SerializeTo(httpHeadersHandle, heads + ret, headersSize, &headersSize);
         }
 
-        //Close headers
-        if (result == HTTPAPI_OK)
+        if ((heads == NULL) || (headersResult != HTTP_HEADERS_OK))
         {
-            result = conn_send_all(http_instance, (const unsigned char*)"\r\n", (size_t)2);
+            /*Codes_SRS_HTTPAPI_COMPACT_21_027: [ If the HTTPAPI_ExecuteRequest cannot create a buffer to send the request, it shall not send any request and return HTTPAPI_STRING_PROCESSING_ERROR. ]*/
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
+        }
+        else
+        {
+            //Close headers
+            heads[(size_t)ret + headersSize] = '\r';
+            heads[(size_t)ret + headersSize + 1] = '\n';
+
+            /*Codes_SRS_HTTPAPI_COMPACT_21_028: [ If the HTTPAPI_ExecuteRequest cannot send the request header, it shall return HTTPAPI_HTTP_HEADERS_FAILED. ]*/
+            /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
+            result = conn_send_all(http_instance, (const unsigned char*)heads, (size_t)ret + headersSize + 2);
+        }
+
+        if ((heads != NULL) && (heads != buf))
+        {
+            free(heads);
         }
     }
     return result;
@@ -1204,13 +1593,19 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
         result = HTTPAPI_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
+    /*Codes_SRS_HTTPAPI_COMPACT_01_016: [ The HTTPAPI_ExecuteRequest shall return HTTPAPI_ERROR while an asynchronous request is in progress on the connection. ]*/
+    else if (http_instance->async_request != NULL)
+    {
+        result = HTTPAPI_ERROR;
+        LogError("An asynchronous request is in progress (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
     /*Codes_SRS_HTTPAPI_COMPACT_21_024: [ The HTTPAPI_ExecuteRequest shall open the transport connection with the host to send the request. ]*/
     else if ((result = OpenXIOConnection(http_instance)) != HTTPAPI_OK)
     {
         LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
     /*Codes_SRS_HTTPAPI_COMPACT_21_026: [ If the open process succeed, the HTTPAPI_ExecuteRequest shall send the request message to the host. ]*/
-    else if ((result = SendHeadsToXIO(http_instance, requestType, relativePath, httpHeadersHandle, headersCount)) != HTTPAPI_OK)
+    else if ((result = SendHeadsToXIO(http_instance, requestType, relativePath, httpHeadersHandle)) != HTTPAPI_OK)
     {
         LogError("Send heads to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
@@ -1245,6 +1640,467 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
     return result;
 }
 
+static HTTPAPI_RESULT AppendToRequest(HTTP_ASYNC_REQUEST* async_request, const void* bytes, size_t length, bool endLine)
+{
+    HTTPAPI_RESULT result;
+    size_t newSize = async_request->request_size + length + (endLine ? 2 : 0);
+    unsigned char* newBytes = (unsigned char*)realloc(async_request->request_bytes, newSize);
+
+    if (newBytes == NULL)
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+    }
+    else
+    {
+        (void)memcpy(newBytes + async_request->request_size, bytes, length);
+        if (endLine)
+        {
+            newBytes[newSize - 2] = '\r';
+            newBytes[newSize - 1] = '\n';
+        }
+        async_request->request_bytes = newBytes;
+        async_request->request_size = newSize;
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+static HTTPAPI_RESULT AppendHeadersToRequest(HTTP_ASYNC_REQUEST* async_request, HTTP_HEADERS_HANDLE httpHeadersHandle)
+{
+    HTTPAPI_RESULT result;
+    size_t headersSize;
+    HTTP_HEADERS_RESULT headersResult = HTTPHeaders_SerializeTo(httpHeadersHandle, NULL, 0, &headersSize);
+
+    if ((headersResult != HTTP_HEADERS_OK) && (headersResult != HTTP_HEADERS_INSUFFICIENT_BUFFER))
+    {
+        result = HTTPAPI_STRING_PROCESSING_ERROR;
+    }
+    else
+    {
+        /*the headers are serialized in place, followed by the blank line that closes them*/
+        size_t newSize = async_request->request_size + headersSize + 2;
+        unsigned char* newBytes = (unsigned char*)realloc(async_request->request_bytes, newSize);
+
+        if (newBytes == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+        else
+        {
+            async_request->request_bytes = newBytes;
+            if (HTTPHeaders_SerializeTo(httpHeadersHandle, (char*)newBytes + async_request->request_size, headersSize, &headersSize) != HTTP_HEADERS_OK)
+            {
+                result = HTTPAPI_STRING_PROCESSING_ERROR;
+            }
+            else
+            {
+                newBytes[newSize - 2] = '\r';
+                newBytes[newSize - 1] = '\n';
+                async_request->request_size = newSize;
+                result = HTTPAPI_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*Codes_SRS_HTTPAPI_COMPACT_01_003: [ The HTTPAPI_ExecuteRequestAsync shall build the request line, the headers and the content in a single buffer; if it cannot, it shall return HTTPAPI_STRING_PROCESSING_ERROR or HTTPAPI_ALLOC_FAILED. ]*/
+static HTTPAPI_RESULT BuildRequest(HTTP_ASYNC_REQUEST* async_request, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength)
+{
+    HTTPAPI_RESULT result;
+    char    buf[TEMP_BUFFER_SIZE];
+    int     ret;
+
+    if (((ret = snprintf(buf, sizeof(buf), "%s %s HTTP/1.1", get_request_type(requestType), relativePath)) < 0) ||
+        ((size_t)ret >= sizeof(buf)))
+    {
+        result = HTTPAPI_STRING_PROCESSING_ERROR;
+    }
+    else if (((result = AppendToRequest(async_request, buf, (size_t)ret, true)) == HTTPAPI_OK) &&
+        ((result = AppendHeadersToRequest(async_request, httpHeadersHandle)) == HTTPAPI_OK) &&
+        (content != NULL) && (contentLength > 0))
+    {
+        result = AppendToRequest(async_request, content, contentLength, false);
+    }
+
+    return result;
+}
+
+static HTTP_ASYNC_REQUEST* CreateAsyncRequest(HTTPAPI_REQUEST_TYPE requestType, HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent,
+    ON_HTTPAPI_REQUEST_COMPLETE on_request_complete, void* callback_context)
+{
+    HTTP_ASYNC_REQUEST* async_request = (HTTP_ASYNC_REQUEST*)malloc(sizeof(HTTP_ASYNC_REQUEST));
+
+    if (async_request != NULL)
+    {
+        async_request->state = HTTP_ASYNC_STATE_OPENING;
+        async_request->result = HTTPAPI_ERROR;
+        async_request->request_bytes = NULL;
+        async_request->request_size = 0;
+        async_request->is_head = (requestType == HTTPAPI_REQUEST_HEAD);
+        async_request->is_interim_response = false;
+        async_request->is_chunked = false;
+        async_request->close_connection = false;
+        async_request->status_code = 0;
+        async_request->body_length = 0;
+        async_request->body_remaining = 0;
+        async_request->body_received = 0;
+        async_request->response_headers = responseHeadersHandle;
+        async_request->response_content = responseContent;
+        async_request->on_request_complete = on_request_complete;
+        async_request->callback_context = callback_context;
+        async_request->line_length = 0;
+        async_request->next = NULL;
+    }
+
+    return async_request;
+}
+
+static void DestroyAsyncRequest(HTTP_ASYNC_REQUEST* async_request)
+{
+    if (async_request->request_bytes != NULL)
+    {
+        free(async_request->request_bytes);
+    }
+    free(async_request);
+}
+
+static void SendAsyncRequest(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+
+    http_instance->send_completed = 0;
+    async_request->state = HTTP_ASYNC_STATE_STATUS_LINE;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_007: [ Once the connection is open, the request shall be sent with a single xio_send; if it fails, the request shall complete with HTTPAPI_SEND_REQUEST_FAILED. ]*/
+    if (xio_send(http_instance->xio_handle, async_request->request_bytes, async_request->request_size, on_send_complete, http_instance) != 0)
+    {
+        async_request_set_result(async_request, HTTPAPI_SEND_REQUEST_FAILED);
+    }
+}
+
+static void CheckAsyncRequestProgress(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+    tickcounter_ms_t now;
+
+    if (async_request->state == HTTP_ASYNC_STATE_OPENING)
+    {
+        if (http_instance->is_io_error != 0)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_012: [ If the connection cannot be opened, the request shall complete with HTTPAPI_OPEN_REQUEST_FAILED. ]*/
+            async_request_set_result(async_request, HTTPAPI_OPEN_REQUEST_FAILED);
+        }
+        else if (http_instance->is_connected != 0)
+        {
+            (void)tickcounter_get_current_ms(http_instance->tick_counter, &async_request->last_activity);
+            SendAsyncRequest(http_instance);
+        }
+    }
+    else if ((async_request->state != HTTP_ASYNC_STATE_COMPLETE) &&
+        (http_instance->is_io_error != 0))
+    {
+        async_request_set_result(async_request, (http_instance->send_completed != 0) ? HTTPAPI_READ_DATA_FAILED : HTTPAPI_SEND_REQUEST_FAILED);
+    }
+
+    if ((async_request->state != HTTP_ASYNC_STATE_COMPLETE) &&
+        (tickcounter_get_current_ms(http_instance->tick_counter, &now) == 0) &&
+        ((now - async_request->last_activity) > ASYNC_REQUEST_IDLE_TIMEOUT_IN_MILLISECONDS))
+    {
+        LogError("Receive timeout. The HTTP request is incomplete");
+        async_request_set_result(async_request, HTTPAPI_READ_DATA_FAILED);
+    }
+}
+
+static void CompleteAsyncRequest(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTP_ASYNC_REQUEST* async_request = http_instance->async_request;
+
+    /*detached first, so the callback can start the next request or close the connection*/
+    http_instance->async_request = NULL;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_015: [ After a failed request, or a response with `Connection: close`, the connection shall be closed and the next request shall open it again. ]*/
+    if ((async_request->result != HTTPAPI_OK) || async_request->close_connection)
+    {
+        (void)xio_close(http_instance->xio_handle, on_io_close_complete, http_instance);
+        http_instance->is_connected = 0;
+    }
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_011: [ When the response is complete, the HTTPAPI_DoWork shall call on_request_complete with the result and the status code of the response. ]*/
+    async_request->on_request_complete(async_request->callback_context, async_request->result, async_request->status_code);
+    DestroyAsyncRequest(async_request);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestAsync(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent,
+    ON_HTTPAPI_REQUEST_COMPLETE on_request_complete, void* callback_context)
+{
+    HTTPAPI_RESULT result;
+    size_t headersCount;
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
+    HTTP_ASYNC_REQUEST* async_request;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_001: [ If handle, relativePath, httpHeadersHandle or on_request_complete is NULL, the requestType is unknown or the number of headers cannot be obtained, the HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_INVALID_ARG. ]*/
+    if (http_instance == NULL ||
+        relativePath == NULL ||
+        httpHeadersHandle == NULL ||
+        on_request_complete == NULL ||
+        !validRequestType(requestType) ||
+        HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_01_002: [ If a request is already in progress on the connection, the HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_ERROR. ]*/
+    else if (http_instance->async_request != NULL)
+    {
+        result = HTTPAPI_ERROR;
+        LogError("An asynchronous request is already in progress (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((http_instance->tick_counter == NULL) &&
+        ((http_instance->tick_counter = tickcounter_create()) == NULL))
+    {
+        result = HTTPAPI_ERROR;
+        LogError("Failed creating the tick counter (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((async_request = CreateAsyncRequest(requestType, responseHeadersHandle, responseContent, on_request_complete, callback_context)) == NULL)
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+        LogError("There is no memory to control the http request (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        if ((result = BuildRequest(async_request, requestType, relativePath, httpHeadersHandle, content, contentLength)) != HTTPAPI_OK)
+        {
+            LogError("Failed building the HTTP request (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            DestroyAsyncRequest(async_request);
+        }
+        else if (tickcounter_get_current_ms(http_instance->tick_counter, &async_request->last_activity) != 0)
+        {
+            result = HTTPAPI_ERROR;
+            LogError("Failed reading the tick counter (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            DestroyAsyncRequest(async_request);
+        }
+        else
+        {
+            http_instance->async_request = async_request;
+            http_instance->is_io_error = 0;
+
+            if (http_instance->is_connected != 0)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_01_005: [ The HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_OK without waiting for the request to complete. ]*/
+                SendAsyncRequest(http_instance);
+            }
+            /*Codes_SRS_HTTPAPI_COMPACT_01_004: [ If the connection is not open, the HTTPAPI_ExecuteRequestAsync shall set the transport options and start opening it; if this fails, it shall return HTTPAPI_SET_OPTION_FAILED or HTTPAPI_OPEN_REQUEST_FAILED. ]*/
+            else if ((result = SetTransportOptions(http_instance)) != HTTPAPI_OK)
+            {
+                http_instance->async_request = NULL;
+                DestroyAsyncRequest(async_request);
+            }
+            else if (xio_open(http_instance->xio_handle, on_io_open_complete, http_instance, on_bytes_received, http_instance, on_io_error, http_instance) != 0)
+            {
+                result = HTTPAPI_OPEN_REQUEST_FAILED;
+                LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                http_instance->async_request = NULL;
+                DestroyAsyncRequest(async_request);
+            }
+            else
+            {
+                /*the request is sent from HTTPAPI_DoWork once the connection is open*/
+                result = HTTPAPI_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+void HTTPAPI_DoWork(HTTP_HANDLE handle)
+{
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_018: [ If the handle is NULL or no asynchronous request is in progress, the HTTPAPI_DoWork shall not do anything. ]*/
+    if ((http_instance != NULL) && (http_instance->async_request != NULL))
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_01_006: [ The HTTPAPI_DoWork shall call xio_dowork once and return without sleeping. ]*/
+        xio_dowork(http_instance->xio_handle);
+
+        CheckAsyncRequestProgress(http_instance);
+
+        if (http_instance->async_request->state == HTTP_ASYNC_STATE_COMPLETE)
+        {
+            CompleteAsyncRequest(http_instance);
+        }
+    }
+}
+
+static HTTPAPI_RESULT BuildBatch(HTTP_HANDLE_DATA* http_instance, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    HTTP_ASYNC_REQUEST** last = &http_instance->async_request;
+    size_t i;
+
+    for (i = 0; (i < requestCount) && (result == HTTPAPI_OK); i++)
+    {
+        size_t headersCount;
+
+        requests[i].statusCode = 0;
+        requests[i].result = HTTPAPI_ERROR;
+
+        /*Codes_SRS_HTTPAPI_COMPACT_01_019: [ If handle or requests is NULL, requestCount is 0, or any of the requests has a NULL relativePath or httpHeadersHandle, an unknown requestType or headers whose number cannot be obtained, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_INVALID_ARG. ]*/
+        if ((requests[i].relativePath == NULL) ||
+            (requests[i].httpHeadersHandle == NULL) ||
+            !validRequestType(requests[i].requestType) ||
+            (HTTPHeaders_GetHeaderCount(requests[i].httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK))
+        {
+            result = HTTPAPI_INVALID_ARG;
+            LogError("Invalid request %lu in the batch (result = %s)", (unsigned long)i, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if ((*last = CreateAsyncRequest(requests[i].requestType, requests[i].responseHeadersHandle, requests[i].responseContent, NULL, NULL)) == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("There is no memory to control the http request (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_021: [ The HTTPAPI_ExecuteRequestBatch shall build all the requests back to back in a single buffer and send it, without waiting for any response. ]*/
+            /*all the requests are written in the buffer of the first one*/
+            result = BuildRequest(http_instance->async_request, requests[i].requestType, requests[i].relativePath, requests[i].httpHeadersHandle, requests[i].content, requests[i].contentLength);
+            (*last)->state = HTTP_ASYNC_STATE_STATUS_LINE;
+            last = &(*last)->next;
+        }
+    }
+
+    return result;
+}
+
+static HTTPAPI_RESULT ReceiveBatchResponses(HTTP_HANDLE_DATA* http_instance)
+{
+    bool isDone = false;
+
+    while (!isDone)
+    {
+        if (http_instance->async_request->state == HTTP_ASYNC_STATE_COMPLETE)
+        {
+            isDone = !async_request_advance(http_instance);
+        }
+        else
+        {
+            xio_dowork(http_instance->xio_handle);
+            CheckAsyncRequestProgress(http_instance);
+
+            if (http_instance->async_request->state != HTTP_ASYNC_STATE_COMPLETE)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
+                ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
+            }
+        }
+    }
+
+    return http_instance->async_request->result;
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_019: [ If handle or requests is NULL, requestCount is 0, or any of the requests has a NULL relativePath or httpHeadersHandle, an unknown requestType or headers whose number cannot be obtained, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_INVALID_ARG. ]*/
+    if ((http_instance == NULL) ||
+        (requests == NULL) ||
+        (requestCount == 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_01_020: [ If an asynchronous request is in progress on the connection, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_ERROR. ]*/
+    else if (http_instance->async_request != NULL)
+    {
+        result = HTTPAPI_ERROR;
+        LogError("An asynchronous request is in progress (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((http_instance->tick_counter == NULL) &&
+        ((http_instance->tick_counter = tickcounter_create()) == NULL))
+    {
+        result = HTTPAPI_ERROR;
+        LogError("Failed creating the tick counter (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        /*the requests are chained from http_instance->async_request, so the response bytes go to the parser*/
+        HTTP_ASYNC_REQUEST* head;
+        HTTP_ASYNC_REQUEST* async_request;
+        size_t i;
+
+        result = BuildBatch(http_instance, requests, requestCount);
+        head = http_instance->async_request;
+
+        if (result != HTTPAPI_OK)
+        {
+            LogError("Failed building the HTTP requests (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            /*nothing is expected while opening*/
+            http_instance->async_request = NULL;
+            result = OpenXIOConnection(http_instance);
+            http_instance->async_request = head;
+
+            if (result != HTTPAPI_OK)
+            {
+                LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                conn_receive_discard_buffer(http_instance);
+                (void)tickcounter_get_current_ms(http_instance->tick_counter, &head->last_activity);
+
+                if ((result = conn_send_all(http_instance, head->request_bytes, head->request_size)) != HTTPAPI_OK)
+                {
+                    LogError("Send the HTTP requests failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                /*Codes_SRS_HTTPAPI_COMPACT_01_022: [ The HTTPAPI_ExecuteRequestBatch shall wait for the responses and write the status code and the result of each request in the batch. ]*/
+                else if ((result = ReceiveBatchResponses(http_instance)) != HTTPAPI_OK)
+                {
+                    LogError("Receive the HTTP responses failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else if (http_instance->async_request->next != NULL)
+                {
+                    /*Codes_SRS_HTTPAPI_COMPACT_01_024: [ After a failed response, or a response with `Connection: close`, the following requests of the batch shall not be waited for and shall be reported with HTTPAPI_ERROR. ]*/
+                    result = HTTPAPI_ERROR;
+                    LogError("The server closed the connection before answering all the requests (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+            }
+
+            /*Codes_SRS_HTTPAPI_COMPACT_01_025: [ If any request of the batch failed, or a response had `Connection: close`, the HTTPAPI_ExecuteRequestBatch shall close the connection so the next request opens it again. ]*/
+            if ((http_instance->is_connected != 0) &&
+                ((result != HTTPAPI_OK) || http_instance->async_request->close_connection))
+            {
+                (void)xio_close(http_instance->xio_handle, on_io_close_complete, http_instance);
+                http_instance->is_connected = 0;
+            }
+        }
+
+        http_instance->async_request = NULL;
+        for (i = 0, async_request = head; async_request != NULL; i++)
+        {
+            HTTP_ASYNC_REQUEST* next = async_request->next;
+            if (async_request->state == HTTP_ASYNC_STATE_COMPLETE)
+            {
+                requests[i].result = async_request->result;
+                requests[i].statusCode = async_request->status_code;
+            }
+            DestroyAsyncRequest(async_request);
+            async_request = next;
+        }
+    }
+
+    return result;
+}
+
 /*Codes_SRS_HTTPAPI_COMPACT_21_056: [ The HTTPAPI_SetOption shall change the HTTP options. ]*/
 /*Codes_SRS_HTTPAPI_COMPACT_21_057: [ The HTTPAPI_SetOption shall receive a handle that identiry the HTTP connection. ]*/
 /*Codes_SRS_HTTPAPI_COMPACT_21_058: [ The HTTPAPI_SetOption shall receive the option as a pair optionName/value. ]*/
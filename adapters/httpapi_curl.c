@@ -7,11 +7,14 @@
 #include <stddef.h>
 #include <ctype.h>
 
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/httpapi.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "curl/curl.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/xlogging.h"
 #ifdef USE_OPENSSL
 #include "azure_c_shared_utility/x509_openssl.h"
@@ -24,12 +27,22 @@
 #include "azure_c_shared_utility/shared_util_options.h"
 
 #define TEMP_BUFFER_SIZE 1024
+#define MAX_WAIT_MS 1000
+#define NO_SOCKET_WAIT_MS 100
 
 DEFINE_ENUM_STRINGS(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES);
 
+typedef struct HTTP_RESPONSE_CONTENT_BUFFER_TAG
+{
+    unsigned char* buffer;
+    size_t bufferSize;
+    unsigned char error;
+} HTTP_RESPONSE_CONTENT_BUFFER;
+
 typedef struct HTTP_HANDLE_DATA_TAG
 {
     CURL* curl;
+    CURLM* multi;
     char* hostURL;
     long timeout;
     long lowSpeedLimit;
@@ -40,17 +53,110 @@ typedef struct HTTP_HANDLE_DATA_TAG
     const char* x509privatekey;
     const char* x509certificate;
     const char* certificates; /*a list of CA certificates*/
+
+    /*the request in progress, the easy handle is in the multi handle between HTTPAPI_ExecuteRequestAsync and its completion*/
+    int isRequestInProgress;
+    struct curl_slist* requestHeaders;
+    HTTP_RESPONSE_CONTENT_BUFFER responseContentBuffer;
+    BUFFER_HANDLE responseContent;
+    ON_HTTPAPI_REQUEST_COMPLETE on_request_complete;
+    void* callback_context;
 } HTTP_HANDLE_DATA;
 
-typedef struct HTTP_RESPONSE_CONTENT_BUFFER_TAG
+typedef struct SYNC_REQUEST_TAG
 {
-    unsigned char* buffer;
-    size_t bufferSize;
-    unsigned char error;
-} HTTP_RESPONSE_CONTENT_BUFFER;
+    int isComplete;
+    HTTPAPI_RESULT result;
+    unsigned int statusCode;
+} SYNC_REQUEST;
 
 static size_t nUsersOfHTTPAPI = 0; /*used for reference counting (a weak one)*/
 
+/*DNS cache, TLS sessions and (when libcurl supports it) the connection cache are shared by all the connections of the process*/
+static CURLSH* curlShare = NULL;
+static LOCK_HANDLE shareLocks[CURL_LOCK_DATA_LAST];
+
+static void share_lock_function(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr)
+{
+    (void)handle;
+    (void)access;
+    (void)userptr;
+
+    if (((int)data < 0) || ((int)data >= CURL_LOCK_DATA_LAST) || (Lock(shareLocks[data]) != LOCK_OK))
+    {
+        LogError("unable to lock the shared data %d", (int)data);
+    }
+}
+
+static void share_unlock_function(CURL* handle, curl_lock_data data, void* userptr)
+{
+    (void)handle;
+    (void)userptr;
+
+    if (((int)data < 0) || ((int)data >= CURL_LOCK_DATA_LAST) || (Unlock(shareLocks[data]) != LOCK_OK))
+    {
+        LogError("unable to unlock the shared data %d", (int)data);
+    }
+}
+
+static void destroyShareLocks(size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        (void)Lock_Deinit(shareLocks[i]);
+        shareLocks[i] = NULL;
+    }
+}
+
+static CURLSH* createShare(void)
+{
+    CURLSH* result;
+    size_t i;
+
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+    {
+        if ((shareLocks[i] = Lock_Init()) == NULL)
+        {
+            break;
+        }
+    }
+
+    if (i < CURL_LOCK_DATA_LAST)
+    {
+        LogError("unable to create the locks of the curl share");
+        destroyShareLocks(i);
+        result = NULL;
+    }
+    else if ((result = curl_share_init()) == NULL)
+    {
+        LogError("unable to curl_share_init");
+        destroyShareLocks(CURL_LOCK_DATA_LAST);
+    }
+    else if ((curl_share_setopt(result, CURLSHOPT_LOCKFUNC, share_lock_function) != CURLSHE_OK) ||
+        (curl_share_setopt(result, CURLSHOPT_UNLOCKFUNC, share_unlock_function) != CURLSHE_OK) ||
+        (curl_share_setopt(result, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) != CURLSHE_OK) ||
+        (curl_share_setopt(result, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) != CURLSHE_OK))
+    {
+        LogError("unable to curl_share_setopt");
+        (void)curl_share_cleanup(result);
+        destroyShareLocks(CURL_LOCK_DATA_LAST);
+        result = NULL;
+    }
+    else
+    {
+#if LIBCURL_VERSION_NUM >= 0x073900
+        /*sharing the connection cache needs libcurl 7.57.0, older versions only share DNS and TLS sessions*/
+        if (curl_share_setopt(result, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != CURLSHE_OK)
+        {
+            LogInfo("unable to share the connection cache, connections are kept per HTTP handle");
+        }
+#endif
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_Init(void)
 {
     HTTPAPI_RESULT result;
@@ -63,6 +169,8 @@ HTTPAPI_RESULT HTTPAPI_Init(void)
         }
         else
         {
+            /*the share is only a cache, the connections work without it*/
+            curlShare = createShare();
             nUsersOfHTTPAPI++;
             result = HTTPAPI_OK;
         }
@@ -83,11 +191,65 @@ void HTTPAPI_Deinit(void)
         nUsersOfHTTPAPI--;
         if (nUsersOfHTTPAPI == 0)
         {
+            if (curlShare != NULL)
+            {
+                if (curl_share_cleanup(curlShare) != CURLSHE_OK)
+                {
+                    LogError("unable to curl_share_cleanup, a connection is still using the share");
+                }
+                else
+                {
+                    destroyShareLocks(CURL_LOCK_DATA_LAST);
+                }
+                curlShare = NULL;
+            }
             curl_global_cleanup();
         }
     }
 }
 
+static size_t ContentWriteFunction(void *ptr, size_t size, size_t nmemb, void *userdata);
+
+/*the options that do not change from one request to the next are given to the easy handle once, HTTPAPI_SetOption updates them*/
+static int setConnectionOptions(HTTP_HANDLE_DATA* httpHandleData)
+{
+    int result;
+
+    if ((curlShare != NULL) &&
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_SHARE, curlShare) != CURLE_OK))
+    {
+        LogError("failed to set CURLOPT_SHARE");
+        result = __FAILURE__;
+    }
+    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1) != CURLE_OK)
+    {
+        LogError("failed to set CURLOPT_HTTP_VERSION");
+        result = __FAILURE__;
+    }
+    else if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEFUNCTION, ContentWriteFunction) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEDATA, &httpHandleData->responseContentBuffer) != CURLE_OK))
+    {
+        LogError("failed to set CURLOPT_WRITEFUNCTION");
+        result = __FAILURE__;
+    }
+    else if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_TIMEOUT_MS, httpHandleData->timeout) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_LIMIT, httpHandleData->lowSpeedLimit) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_TIME, httpHandleData->lowSpeedTime) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_FRESH_CONNECT, httpHandleData->freshConnect) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_FORBID_REUSE, httpHandleData->forbidReuse) != CURLE_OK) ||
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_VERBOSE, httpHandleData->verbose) != CURLE_OK))
+    {
+        LogError("failed to set the default options");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
 HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
 {
     HTTP_HANDLE_DATA* httpHandleData;
@@ -122,6 +284,14 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                         free(httpHandleData);
                         httpHandleData = NULL;
                     }
+                    else if ((httpHandleData->multi = curl_multi_init()) == NULL)
+                    {
+                        LogError("unable to curl_multi_init");
+                        curl_easy_cleanup(httpHandleData->curl);
+                        free(httpHandleData->hostURL);
+                        free(httpHandleData);
+                        httpHandleData = NULL;
+                    }
                     else
                     {
                         httpHandleData->timeout = 242 * 1000; /*242 seconds seems like a nice enough time. Reasone for 242:
@@ -135,6 +305,23 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                         httpHandleData->x509certificate = NULL;
                         httpHandleData->x509privatekey = NULL;
                         httpHandleData->certificates = NULL;
+                        httpHandleData->isRequestInProgress = 0;
+                        httpHandleData->requestHeaders = NULL;
+                        httpHandleData->responseContentBuffer.buffer = NULL;
+                        httpHandleData->responseContentBuffer.bufferSize = 0;
+                        httpHandleData->responseContentBuffer.error = 0;
+                        httpHandleData->responseContent = NULL;
+                        httpHandleData->on_request_complete = NULL;
+                        httpHandleData->callback_context = NULL;
+
+                        if (setConnectionOptions(httpHandleData) != 0)
+                        {
+                            (void)curl_multi_cleanup(httpHandleData->multi);
+                            curl_easy_cleanup(httpHandleData->curl);
+                            free(httpHandleData->hostURL);
+                            free(httpHandleData);
+                            httpHandleData = NULL;
+                        }
                     }
                 }
                 else
@@ -150,13 +337,22 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
     return (HTTP_HANDLE)httpHandleData;
 }
 
+static void completeRequest(HTTP_HANDLE_DATA* httpHandleData, HTTPAPI_RESULT transferResult);
+
 void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 {
     HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
     if (httpHandleData != NULL)
     {
+        if (httpHandleData->isRequestInProgress != 0)
+        {
+            /*the request in progress is abandoned, its owner still gets the completion*/
+            completeRequest(httpHandleData, HTTPAPI_ERROR);
+        }
+
         free(httpHandleData->hostURL);
         curl_easy_cleanup(httpHandleData->curl);
+        (void)curl_multi_cleanup(httpHandleData->multi);
         free(httpHandleData);
     }
 }
@@ -211,6 +407,8 @@ static size_t ContentWriteFunction(void *ptr, size_t size, size_t nmemb, void *u
             if (responseContentBuffer->buffer != NULL)
             {
                 free(responseContentBuffer->buffer);
+                responseContentBuffer->buffer = NULL;
+                responseContentBuffer->bufferSize = 0;
             }
         }
     }
@@ -290,387 +488,598 @@ static CURLcode ssl_ctx_callback(CURL *curl, void *ssl_ctx, void *userptr)
     return result;
 }
 
-HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
-                                      HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
-                                      size_t contentLength, unsigned int* statusCode,
-                                      HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+static HTTPAPI_RESULT setRequestOptions(HTTP_HANDLE_DATA* httpHandleData, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                        HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+                                        size_t contentLength, HTTP_HEADERS_HANDLE responseHeadersHandle)
 {
     HTTPAPI_RESULT result;
-    HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
-    size_t headersCount;
-    HTTP_RESPONSE_CONTENT_BUFFER responseContentBuffer;
-
-    if ((httpHandleData == NULL) ||
-        (relativePath == NULL) ||
-        (httpHeadersHandle == NULL) ||
-        ((content == NULL) && (contentLength > 0))
-    )
-    {
-        result = HTTPAPI_INVALID_ARG;
-        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-    }
-    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    char* tempHostURL;
+    size_t tempHostURL_size = strlen(httpHandleData->hostURL) + strlen(relativePath) + 1;
+    tempHostURL = malloc(tempHostURL_size);
+    if (tempHostURL == NULL)
     {
-        result = HTTPAPI_INVALID_ARG;
+        result = HTTPAPI_ERROR;
         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
     else
     {
-        char* tempHostURL;
-        size_t tempHostURL_size = strlen(httpHandleData->hostURL) + strlen(relativePath) + 1;
-        tempHostURL = malloc(tempHostURL_size);
-        if (tempHostURL == NULL)
+        if ((strcpy_s(tempHostURL, tempHostURL_size, httpHandleData->hostURL) != 0) ||
+            (strcat_s(tempHostURL, tempHostURL_size, relativePath) != 0))
         {
-            result = HTTPAPI_ERROR;
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
         }
+        /* set the URL, libcurl keeps its own copy */
+        else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_URL, tempHostURL) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("failed to set CURLOPT_URL (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
         else
         {
-            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_VERBOSE, httpHandleData->verbose) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_VERBOSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if ((strcpy_s(tempHostURL, tempHostURL_size, httpHandleData->hostURL) != 0) ||
-                (strcat_s(tempHostURL, tempHostURL_size, relativePath) != 0))
+            result = HTTPAPI_OK;
+
+            switch (requestType)
             {
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
+            default:
+                result = HTTPAPI_INVALID_ARG;
                 LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            /* set the URL */
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_URL, tempHostURL) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_URL (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_TIMEOUT_MS, httpHandleData->timeout) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_TIMEOUT_MS (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_LIMIT, httpHandleData->lowSpeedLimit) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_LOW_SPEED_LIMIT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_TIME, httpHandleData->lowSpeedTime) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_LOW_SPEED_TIME (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FRESH_CONNECT, httpHandleData->freshConnect) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_FRESH_CONNECT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FORBID_REUSE, httpHandleData->forbidReuse) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_FORBID_REUSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_HTTP_VERSION (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else
-            {
-                result = HTTPAPI_OK;
+                break;
 
-                switch (requestType)
+            case HTTPAPI_REQUEST_GET:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
                 {
-                default:
-                    result = HTTPAPI_INVALID_ARG;
+                    result = HTTPAPI_SET_OPTION_FAILED;
                     LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    break;
-
-                case HTTPAPI_REQUEST_GET:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
+                }
+                else
+                {
+                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
                     {
                         result = HTTPAPI_SET_OPTION_FAILED;
                         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                     }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
+                }
 
-                    break;
+                break;
 
-                case HTTPAPI_REQUEST_HEAD:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_NOBODY, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
+            case HTTPAPI_REQUEST_HEAD:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_NOBODY, 1L) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
 
-                    break;
+                break;
 
-                case HTTPAPI_REQUEST_POST:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+            case HTTPAPI_REQUEST_POST:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
                     {
                         result = HTTPAPI_SET_OPTION_FAILED;
                         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                     }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
+                }
 
-                    break;
+                break;
 
-                case HTTPAPI_REQUEST_PUT:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L))
+            case HTTPAPI_REQUEST_PUT:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L))
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PUT") != CURLE_OK)
                     {
                         result = HTTPAPI_SET_OPTION_FAILED;
                         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                     }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PUT") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-                    break;
+                }
+                break;
 
-                case HTTPAPI_REQUEST_DELETE:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+            case HTTPAPI_REQUEST_DELETE:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "DELETE") != CURLE_OK)
                     {
                         result = HTTPAPI_SET_OPTION_FAILED;
                         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                     }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "DELETE") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-                    break;
+                }
+                break;
 
-                case HTTPAPI_REQUEST_PATCH:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+            case HTTPAPI_REQUEST_PATCH:
+                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PATCH") != CURLE_OK)
                     {
                         result = HTTPAPI_SET_OPTION_FAILED;
                         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                     }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PATCH") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-
-                    break;
                 }
 
-                if (result == HTTPAPI_OK)
+                break;
+            }
+
+            if (result == HTTPAPI_OK)
+            {
+                /* add headers, the list lives until the request completes */
+                struct curl_slist* headers = NULL;
+                size_t headersCount;
+
+                if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
                 {
-                    /* add headers */
-                    struct curl_slist* headers = NULL;
+                    result = HTTPAPI_HTTP_HEADERS_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    /* every header is handed to curl as "name: value", which curl copies, so one stack buffer serves all the usual headers */
+                    char buffer[TEMP_BUFFER_SIZE];
                     size_t i;
 
                     for (i = 0; i < headersCount; i++)
                     {
-                        char *tempBuffer;
-                        if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &tempBuffer) != HTTP_HEADERS_OK)
+                        const char* name;
+                        const char* value;
+
+                        if (HTTPHeaders_GetHeaderNameValue(httpHeadersHandle, i, &name, &value) != HTTP_HEADERS_OK)
                         {
-                            /* error */
                             result = HTTPAPI_HTTP_HEADERS_FAILED;
                             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                             break;
                         }
                         else
                         {
-                            struct curl_slist* newHeaders = curl_slist_append(headers, tempBuffer);
-                            if (newHeaders == NULL)
+                            size_t nameLength = strlen(name);
+                            size_t valueLength = strlen(value);
+                            size_t lineSize = nameLength + /*COLON_AND_SPACE_LENGTH*/ 2 + valueLength + /*EOL*/ 1;
+                            char* line = (lineSize <= sizeof(buffer)) ? buffer : (char*)malloc(lineSize);
+
+                            if (line == NULL)
                             {
                                 result = HTTPAPI_ALLOC_FAILED;
                                 LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                free(tempBuffer);
                                 break;
                             }
                             else
                             {
-                                free(tempBuffer);
+                                struct curl_slist* newHeaders;
+
+                                (void)memcpy(line, name, nameLength);
+                                line[nameLength] = ':';
+                                line[nameLength + 1] = ' ';
+                                (void)memcpy(line + nameLength + 2, value, valueLength + 1);
+
+                                newHeaders = curl_slist_append(headers, line);
+                                if (line != buffer)
+                                {
+                                    free(line);
+                                }
+
+                                if (newHeaders == NULL)
+                                {
+                                    result = HTTPAPI_ALLOC_FAILED;
+                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                                    break;
+                                }
                                 headers = newHeaders;
                             }
                         }
                     }
+                }
 
-                    if (result == HTTPAPI_OK)
+                if (result != HTTPAPI_OK)
+                {
+                    curl_slist_free_all(headers);
+                }
+                else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPHEADER, headers) != CURLE_OK)
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                    curl_slist_free_all(headers);
+                }
+                else
+                {
+                    httpHandleData->requestHeaders = headers;
+
+                    /* add content, libcurl copies it so the caller does not have to keep it until the request completes */
+                    if ((content != NULL) &&
+                        (contentLength > 0))
                     {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPHEADER, headers) != CURLE_OK)
+                        if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDSIZE, (long)contentLength) != CURLE_OK) ||
+                            (curl_easy_setopt(httpHandleData->curl, CURLOPT_COPYPOSTFIELDS, (const char*)content) != CURLE_OK))
                         {
                             result = HTTPAPI_SET_OPTION_FAILED;
                             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                         }
-                        else
+                    }
+                    else
+                    {
+                        if (requestType != HTTPAPI_REQUEST_GET)
                         {
-                            /* add content */
-                            if ((content != NULL) &&
-                                (contentLength > 0))
-                            {
-                                if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDS, (void*)content) != CURLE_OK) ||
-                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDSIZE, contentLength) != CURLE_OK))
-                                {
-                                    result = HTTPAPI_SET_OPTION_FAILED;
-                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                }
-                            }
-                            else
+                            if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDS, (void*)NULL) != CURLE_OK) ||
+                                (curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDSIZE, 0L) != CURLE_OK))
                             {
-                                if (requestType != HTTPAPI_REQUEST_GET)
-                                {
-                                    if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDS, (void*)NULL) != CURLE_OK) ||
-                                        (curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDSIZE, 0) != CURLE_OK))
-                                    {
-                                        result = HTTPAPI_SET_OPTION_FAILED;
-                                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                    }
-                                }
-                                else
-                                {
-                                    /*GET request cannot POST, so "do nothing*/
-                                }
+                                result = HTTPAPI_SET_OPTION_FAILED;
+                                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                             }
+                        }
+                        else
+                        {
+                            /*GET request cannot POST, so "do nothing*/
+                        }
+                    }
 
-                            if (result == HTTPAPI_OK)
-                            {
-                                if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEHEADER, NULL) != CURLE_OK) ||
-                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_HEADERFUNCTION, NULL) != CURLE_OK) ||
-                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEFUNCTION, ContentWriteFunction) != CURLE_OK))
-                                {
-                                    result = HTTPAPI_SET_OPTION_FAILED;
-                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                }
-                                else
-                                {
-                                    if (responseHeadersHandle != NULL)
-                                    {
-                                        /* setup the code to get the response headers */
-                                        if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEHEADER, responseHeadersHandle) != CURLE_OK) ||
-                                            (curl_easy_setopt(httpHandleData->curl, CURLOPT_HEADERFUNCTION, HeadersWriteFunction) != CURLE_OK))
-                                        {
-                                            result = HTTPAPI_SET_OPTION_FAILED;
-                                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                        }
-                                    }
-
-                                    if (result == HTTPAPI_OK)
-                                    {
-                                        responseContentBuffer.buffer = NULL;
-                                        responseContentBuffer.bufferSize = 0;
-                                        responseContentBuffer.error = 0;
-
-                                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEDATA, &responseContentBuffer) != CURLE_OK)
-                                        {
-                                            result = HTTPAPI_SET_OPTION_FAILED;
-                                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                        }
-
-                                        if (result == HTTPAPI_OK)
-                                        {
-                                            /* Execute request */
-                                            CURLcode curlRes = curl_easy_perform(httpHandleData->curl);
-                                            if (curlRes != CURLE_OK)
-                                            {
-                                                LogError("curl_easy_perform() failed: %s\n", curl_easy_strerror(curlRes));
-                                                result = HTTPAPI_OPEN_REQUEST_FAILED;
-                                                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                            }
-                                            else
-                                            {
-                                                long httpCode;
-
-                                                /* get the status code */
-                                                if (curl_easy_getinfo(httpHandleData->curl, CURLINFO_RESPONSE_CODE, &httpCode) != CURLE_OK)
-                                                {
-                                                    result = HTTPAPI_QUERY_HEADERS_FAILED;
-                                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                                }
-                                                else if (responseContentBuffer.error)
-                                                {
-                                                    result = HTTPAPI_READ_DATA_FAILED;
-                                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                                }
-                                                else
-                                                {
-                                                    if (statusCode != NULL)
-                                                    {
-                                                        *statusCode = (unsigned int)httpCode;
-                                                    }
-
-                                                    /* fill response content length */
-                                                    if (responseContent != NULL)
-                                                    {
-                                                        if ((responseContentBuffer.bufferSize > 0) && (BUFFER_build(responseContent, responseContentBuffer.buffer, responseContentBuffer.bufferSize) != 0))
-                                                        {
-                                                            result = HTTPAPI_INSUFFICIENT_RESPONSE_BUFFER;
-                                                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                                        }
-                                                        else
-                                                        {
-                                                            /*all nice*/
-                                                        }
-                                                    }
-
-                                                    if (httpCode >= 300)
-                                                    {
-                                                        LogError("Failure in HTTP communication: server reply code is %ld", httpCode);
-                                                        LogInfo("HTTP Response:%*.*s", (int)responseContentBuffer.bufferSize,
-                                                            (int)responseContentBuffer.bufferSize, responseContentBuffer.buffer);
-                                                    }
-                                                    else
-                                                    {
-                                                        result = HTTPAPI_OK;
-                                                    }
-                                                }
-                                            }
-                                        }
-
-                                        if (responseContentBuffer.buffer != NULL)
-                                        {
-                                            free(responseContentBuffer.buffer);
-                                        }
-                                    }
-                                }
-                            }
+                    if (result == HTTPAPI_OK)
+                    {
+                        /* setup the code to get the response headers */
+                        if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEHEADER, responseHeadersHandle) != CURLE_OK) ||
+                            (curl_easy_setopt(httpHandleData->curl, CURLOPT_HEADERFUNCTION, (responseHeadersHandle != NULL) ? HeadersWriteFunction : NULL) != CURLE_OK))
+                        {
+                            result = HTTPAPI_SET_OPTION_FAILED;
+                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                         }
                     }
-                    curl_slist_free_all(headers);
                 }
             }
-            free(tempHostURL);
+        }
+        free(tempHostURL);
+    }
+
+    return result;
+}
+
+static void completeRequest(HTTP_HANDLE_DATA* httpHandleData, HTTPAPI_RESULT transferResult)
+{
+    HTTPAPI_RESULT result;
+    unsigned int statusCode = 0;
+    ON_HTTPAPI_REQUEST_COMPLETE on_request_complete = httpHandleData->on_request_complete;
+    void* callback_context = httpHandleData->callback_context;
+
+    (void)curl_multi_remove_handle(httpHandleData->multi, httpHandleData->curl);
+    curl_slist_free_all(httpHandleData->requestHeaders);
+    httpHandleData->requestHeaders = NULL;
+
+    if (transferResult != HTTPAPI_OK)
+    {
+        result = transferResult;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        long httpCode;
+
+        /* get the status code */
+        if (curl_easy_getinfo(httpHandleData->curl, CURLINFO_RESPONSE_CODE, &httpCode) != CURLE_OK)
+        {
+            result = HTTPAPI_QUERY_HEADERS_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (httpHandleData->responseContentBuffer.error)
+        {
+            result = HTTPAPI_READ_DATA_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            result = HTTPAPI_OK;
+            statusCode = (unsigned int)httpCode;
+
+            /* fill response content length */
+            if (httpHandleData->responseContent != NULL)
+            {
+                if ((httpHandleData->responseContentBuffer.bufferSize > 0) &&
+                    (BUFFER_build(httpHandleData->responseContent, httpHandleData->responseContentBuffer.buffer, httpHandleData->responseContentBuffer.bufferSize) != 0))
+                {
+                    result = HTTPAPI_INSUFFICIENT_RESPONSE_BUFFER;
+                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                }
+                else
+                {
+                    /*all nice*/
+                }
+            }
+
+            if (httpCode >= 300)
+            {
+                LogError("Failure in HTTP communication: server reply code is %ld", httpCode);
+                LogInfo("HTTP Response:%*.*s", (int)httpHandleData->responseContentBuffer.bufferSize,
+                    (int)httpHandleData->responseContentBuffer.bufferSize, httpHandleData->responseContentBuffer.buffer);
+            }
+        }
+    }
+
+    if (httpHandleData->responseContentBuffer.buffer != NULL)
+    {
+        free(httpHandleData->responseContentBuffer.buffer);
+        httpHandleData->responseContentBuffer.buffer = NULL;
+    }
+    httpHandleData->responseContentBuffer.bufferSize = 0;
+    httpHandleData->responseContentBuffer.error = 0;
+    httpHandleData->responseContent = NULL;
+    httpHandleData->on_request_complete = NULL;
+    httpHandleData->callback_context = NULL;
+    httpHandleData->isRequestInProgress = 0;
+
+    /*the connection is ready for the next request before the callback runs, so the callback can start one*/
+    on_request_complete(callback_context, result, statusCode);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestAsync(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                           HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength,
+                                           HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent,
+                                           ON_HTTPAPI_REQUEST_COMPLETE on_request_complete, void* callback_context)
+{
+    HTTPAPI_RESULT result;
+    HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
+    size_t headersCount;
+
+    if ((httpHandleData == NULL) ||
+        (relativePath == NULL) ||
+        (httpHeadersHandle == NULL) ||
+        (on_request_complete == NULL) ||
+        ((content == NULL) && (contentLength > 0))
+    )
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (httpHandleData->isRequestInProgress != 0)
+    {
+        result = HTTPAPI_ERROR;
+        LogError("A request is already in progress (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((result = setRequestOptions(httpHandleData, requestType, relativePath, httpHeadersHandle, content, contentLength, responseHeadersHandle)) != HTTPAPI_OK)
+    {
+        LogError("unable to set the request options (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        curl_slist_free_all(httpHandleData->requestHeaders);
+        httpHandleData->requestHeaders = NULL;
+    }
+    else
+    {
+        CURLMcode multiResult;
+
+        httpHandleData->responseContentBuffer.buffer = NULL;
+        httpHandleData->responseContentBuffer.bufferSize = 0;
+        httpHandleData->responseContentBuffer.error = 0;
+        httpHandleData->responseContent = responseContent;
+        httpHandleData->on_request_complete = on_request_complete;
+        httpHandleData->callback_context = callback_context;
+
+        if ((multiResult = curl_multi_add_handle(httpHandleData->multi, httpHandleData->curl)) != CURLM_OK)
+        {
+            result = HTTPAPI_ERROR;
+            LogError("curl_multi_add_handle() failed: %s (result = %s)", curl_multi_strerror(multiResult), ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            curl_slist_free_all(httpHandleData->requestHeaders);
+            httpHandleData->requestHeaders = NULL;
+            httpHandleData->responseContent = NULL;
+            httpHandleData->on_request_complete = NULL;
+            httpHandleData->callback_context = NULL;
+        }
+        else
+        {
+            httpHandleData->isRequestInProgress = 1;
+            result = HTTPAPI_OK;
+        }
+    }
+
+    return result;
+}
+
+void HTTPAPI_DoWork(HTTP_HANDLE handle)
+{
+    HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
+
+    if ((httpHandleData != NULL) &&
+        (httpHandleData->isRequestInProgress != 0))
+    {
+        int runningHandles;
+        CURLMcode multiResult = curl_multi_perform(httpHandleData->multi, &runningHandles);
+        if (multiResult != CURLM_OK)
+        {
+            LogError("curl_multi_perform() failed: %s", curl_multi_strerror(multiResult));
+            completeRequest(httpHandleData, HTTPAPI_ERROR);
+        }
+        else
+        {
+            int messagesInQueue;
+            CURLMsg* message;
+
+            /*there is only one easy handle in the multi handle, so at most one message*/
+            if (((message = curl_multi_info_read(httpHandleData->multi, &messagesInQueue)) != NULL) &&
+                (message->msg == CURLMSG_DONE))
+            {
+                CURLcode curlRes = message->data.result;
+                if (curlRes != CURLE_OK)
+                {
+                    LogError("curl transfer failed: %s", curl_easy_strerror(curlRes));
+                    completeRequest(httpHandleData, HTTPAPI_OPEN_REQUEST_FAILED);
+                }
+                else
+                {
+                    completeRequest(httpHandleData, HTTPAPI_OK);
+                }
+            }
+        }
+    }
+}
+
+static void on_sync_request_complete(void* context, HTTPAPI_RESULT result, unsigned int statusCode)
+{
+    SYNC_REQUEST* syncRequest = (SYNC_REQUEST*)context;
+    syncRequest->result = result;
+    syncRequest->statusCode = statusCode;
+    syncRequest->isComplete = 1;
+}
+
+/*blocks until there is activity on the sockets of the transfer or for at most a second, so the curl timers are served*/
+static int waitForTransfer(HTTP_HANDLE_DATA* httpHandleData)
+{
+    int result;
+    CURLMcode multiResult;
+#if LIBCURL_VERSION_NUM >= 0x074200
+    multiResult = curl_multi_poll(httpHandleData->multi, NULL, 0, MAX_WAIT_MS, NULL);
+#else
+    int numfds;
+    multiResult = curl_multi_wait(httpHandleData->multi, NULL, 0, MAX_WAIT_MS, &numfds);
+    if ((multiResult == CURLM_OK) && (numfds == 0))
+    {
+        /*curl_multi_wait returns at once when there is no socket to wait for yet (for example while resolving)*/
+        ThreadAPI_Sleep(NO_SOCKET_WAIT_MS);
+    }
+#endif
+    if (multiResult != CURLM_OK)
+    {
+        LogError("waiting for the transfer failed: %s", curl_multi_strerror(multiResult));
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                      HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+                                      size_t contentLength, unsigned int* statusCode,
+                                      HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+    SYNC_REQUEST syncRequest;
+
+    syncRequest.isComplete = 0;
+    syncRequest.result = HTTPAPI_ERROR;
+    syncRequest.statusCode = 0;
+
+    /*the synchronous call is the asynchronous one driven until it completes*/
+    if ((result = HTTPAPI_ExecuteRequestAsync(handle, requestType, relativePath, httpHeadersHandle, content, contentLength,
+        responseHeadersHandle, responseContent, on_sync_request_complete, &syncRequest)) != HTTPAPI_OK)
+    {
+        LogError("unable to start the request (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
+
+        HTTPAPI_DoWork(handle);
+        while (syncRequest.isComplete == 0)
+        {
+            if (waitForTransfer(httpHandleData) != 0)
+            {
+                completeRequest(httpHandleData, HTTPAPI_ERROR);
+            }
+            else
+            {
+                HTTPAPI_DoWork(handle);
+            }
+        }
+
+        result = syncRequest.result;
+        if ((statusCode != NULL) &&
+            (syncRequest.statusCode != 0))
+        {
+            *statusCode = syncRequest.statusCode;
         }
     }
 
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+
+    if ((handle == NULL) || (requests == NULL) || (requestCount == 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        size_t i;
+
+        /*this adapter does not pipeline, the requests are executed one after the other on the same handle*/
+        result = HTTPAPI_OK;
+        for (i = 0; i < requestCount; i++)
+        {
+            requests[i].result = HTTPAPI_ExecuteRequest(handle, requests[i].requestType, requests[i].relativePath, requests[i].httpHeadersHandle,
+                requests[i].content, requests[i].contentLength, &requests[i].statusCode, requests[i].responseHeadersHandle, requests[i].responseContent);
+            if ((requests[i].result != HTTPAPI_OK) && (result == HTTPAPI_OK))
+            {
+                result = requests[i].result;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*the TLS credentials and trusted certificates are added by ssl_ctx_callback, libcurl cannot tell them apart when it looks for
+a cached TLS session or connection, so a handle that uses them stops sharing those with the other handles*/
+static HTTPAPI_RESULT setSslCtxCallback(HTTP_HANDLE_DATA* httpHandleData)
+{
+    HTTPAPI_RESULT result;
+
+    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_FUNCTION, ssl_ctx_callback) != CURLE_OK)
+    {
+        LogError("failure in curl_easy_setopt - CURLOPT_SSL_CTX_FUNCTION");
+        result = HTTPAPI_ERROR;
+    }
+    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_DATA, httpHandleData) != CURLE_OK)
+    {
+        LogError("failure in curl_easy_setopt - CURLOPT_SSL_CTX_DATA");
+        result = HTTPAPI_ERROR;
+    }
+    else if ((curlShare != NULL) &&
+        (curl_easy_setopt(httpHandleData->curl, CURLOPT_SHARE, NULL) != CURLE_OK))
+    {
+        LogError("failure in curl_easy_setopt - CURLOPT_SHARE");
+        result = HTTPAPI_ERROR;
+    }
+    else
+    {
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -689,56 +1098,88 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, con
         if (strcmp(OPTION_HTTP_TIMEOUT, optionName) == 0)
         {
             long timeout = (long)(*(unsigned int*)value);
-            httpHandleData->timeout = timeout;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_TIMEOUT_MS, timeout) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_TIMEOUT_MS (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->timeout = timeout;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(OPTION_CURL_LOW_SPEED_LIMIT, optionName) == 0)
         {
-            httpHandleData->lowSpeedLimit = *(const long*)value;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_LIMIT, *(const long*)value) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_LOW_SPEED_LIMIT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->lowSpeedLimit = *(const long*)value;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(OPTION_CURL_LOW_SPEED_TIME, optionName) == 0)
         {
-            httpHandleData->lowSpeedTime = *(const long*)value;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_TIME, *(const long*)value) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_LOW_SPEED_TIME (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->lowSpeedTime = *(const long*)value;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(OPTION_CURL_FRESH_CONNECT, optionName) == 0)
         {
-            httpHandleData->freshConnect = *(const long*)value;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FRESH_CONNECT, *(const long*)value) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_FRESH_CONNECT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->freshConnect = *(const long*)value;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(OPTION_CURL_FORBID_REUSE, optionName) == 0)
         {
-            httpHandleData->forbidReuse = *(const long*)value;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FORBID_REUSE, *(const long*)value) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_FORBID_REUSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->forbidReuse = *(const long*)value;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(OPTION_CURL_VERBOSE, optionName) == 0)
         {
-            httpHandleData->verbose = *(const long*)value;
-            result = HTTPAPI_OK;
+            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_VERBOSE, *(const long*)value) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_VERBOSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->verbose = *(const long*)value;
+                result = HTTPAPI_OK;
+            }
         }
         else if (strcmp(SU_OPTION_X509_PRIVATE_KEY, optionName) == 0 || strcmp(OPTION_X509_ECC_KEY, optionName) == 0)
         {
             httpHandleData->x509privatekey = value;
             if (httpHandleData->x509certificate != NULL)
             {
-                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_FUNCTION, ssl_ctx_callback) != CURLE_OK)
-                {
-                    LogError("unable to curl_easy_setopt");
-                    result = HTTPAPI_ERROR;
-                }
-                else
-                {
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_DATA, httpHandleData) != CURLE_OK)
-                    {
-                        LogError("unable to curl_easy_setopt");
-                        result = HTTPAPI_ERROR;
-                    }
-                    else
-                    {
-                        result = HTTPAPI_OK;
-                    }
-                }
+                result = setSslCtxCallback(httpHandleData);
             }
             else
             {
@@ -751,23 +1192,7 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, con
             httpHandleData->x509certificate = value;
             if (httpHandleData->x509privatekey != NULL)
             {
-                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_FUNCTION, ssl_ctx_callback) != CURLE_OK)
-                {
-                    LogError("unable to curl_easy_setopt");
-                    result = HTTPAPI_ERROR;
-                }
-                else
-                {
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_DATA, httpHandleData) != CURLE_OK)
-                    {
-                        LogError("unable to curl_easy_setopt");
-                        result = HTTPAPI_ERROR;
-                    }
-                    else
-                    {
-                        result = HTTPAPI_OK;
-                    }
-                }
+                result = setSslCtxCallback(httpHandleData);
             }
             else
             {
@@ -838,23 +1263,9 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, con
         else if (strcmp("TrustedCerts", optionName) == 0)
         {
             /*TrustedCerts needs to trigger the CURLOPT_SSL_CTX_FUNCTION in curl so we can pass the CAs*/
-            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_FUNCTION, ssl_ctx_callback) != CURLE_OK)
+            if ((result = setSslCtxCallback(httpHandleData)) == HTTPAPI_OK)
             {
-                LogError("failure in curl_easy_setopt - CURLOPT_SSL_CTX_FUNCTION");
-                result = HTTPAPI_ERROR;
-            }
-            else
-            {
-                if (curl_easy_setopt(httpHandleData->curl, CURLOPT_SSL_CTX_DATA, httpHandleData) != CURLE_OK)
-                {
-                    LogError("failure in curl_easy_setopt - CURLOPT_SSL_CTX_DATA");
-                    result = HTTPAPI_ERROR;
-                }
-                else
-                {
-                    httpHandleData->certificates = (const char*)value;
-                    result = HTTPAPI_OK;
-                }
+                httpHandleData->certificates = (const char*)value;
             }
         }
         else
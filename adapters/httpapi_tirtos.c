@@ -285,6 +285,32 @@ headersDone:
     return (HTTPAPI_OK);
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle,
+        HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    size_t i;
+
+    if (handle == NULL || requests == NULL || requestCount == 0) {
+        LogError("Invalid arguments");
+        return (HTTPAPI_INVALID_ARG);
+    }
+
+    /* No pipelining, the requests are executed one after the other */
+    for (i = 0; i < requestCount; i++) {
+        requests[i].result = HTTPAPI_ExecuteRequest(handle,
+                requests[i].requestType, requests[i].relativePath,
+                requests[i].httpHeadersHandle, requests[i].content,
+                requests[i].contentLength, &requests[i].statusCode,
+                requests[i].responseHeadersHandle, requests[i].responseContent);
+        if (requests[i].result != HTTPAPI_OK && result == HTTPAPI_OK) {
+            result = requests[i].result;
+        }
+    }
+
+    return (result);
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName,
         const void* value)
 {
@@ -597,6 +597,35 @@ exit:
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+
+    if ((handle == NULL) || (requests == NULL) || (requestCount == 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        size_t i;
+
+        /*this adapter does not pipeline, the requests are executed one after the other on the same handle*/
+        result = HTTPAPI_OK;
+        for (i = 0; i < requestCount; i++)
+        {
+            requests[i].result = HTTPAPI_ExecuteRequest(handle, requests[i].requestType, requests[i].relativePath, requests[i].httpHeadersHandle,
+                requests[i].content, requests[i].contentLength, &requests[i].statusCode, requests[i].responseHeadersHandle, requests[i].responseContent);
+            if ((requests[i].result != HTTPAPI_OK) && (result == HTTPAPI_OK))
+            {
+                result = requests[i].result;
+            }
+        }
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -48,77 +48,33 @@ static size_t nUsersOfHTTPAPI = 0; /*used for reference counting (a weak one)*/
 static const char* ConstructHeadersString(HTTP_HEADERS_HANDLE httpHeadersHandle)
 {
     char* result;
-    size_t headersCount;
+    size_t serializedSize;
+    HTTP_HEADERS_RESULT headersResult = HTTPHeaders_SerializeTo(httpHeadersHandle, NULL, 0, &serializedSize);
 
-    if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    /*the headers are serialized as "name: value\r\n" lines, once their total size is known*/
+    if ((headersResult != HTTP_HEADERS_OK) && (headersResult != HTTP_HEADERS_INSUFFICIENT_BUFFER))
     {
         result = NULL;
-        LogError("HTTPHeaders_GetHeaderCount failed.");
+        LogError("HTTPHeaders_SerializeTo failed.");
     }
     else
     {
-        size_t i;
+        result = (char*)malloc(serializedSize*sizeof(char) + 1);
 
-        /*the total size of all the headers is given by sumof(lengthof(everyheader)+2)*/
-        size_t toAlloc = 0;
-        for (i = 0; i < headersCount; i++)
+        if (result == NULL)
         {
-            char *temp;
-            if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &temp) == HTTP_HEADERS_OK)
-            {
-                toAlloc += strlen(temp);
-                toAlloc += 2;
-                free(temp);
-            }
-            else
-            {
-                LogError("HTTPHeaders_GetHeader failed");
-                break;
-            }
+            LogError("unable to malloc");
+            /*let it be returned*/
         }
-
-        if (i < headersCount)
+        else if (HTTPHeaders_SerializeTo(httpHeadersHandle, result, serializedSize, &serializedSize) != HTTP_HEADERS_OK)
         {
+            LogError("unable to HTTPHeaders_SerializeTo");
+            free(result);
             result = NULL;
         }
         else
         {
-            result = (char*)malloc(toAlloc*sizeof(char) + 1 );
-
-            if (result == NULL)
-            {
-                LogError("unable to malloc");
-                /*let it be returned*/
-            }
-            else
-            {
-                result[0] = '\0';
-                for (i = 0; i < headersCount; i++)
-                {
-                    char* temp;
-                    if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &temp) != HTTP_HEADERS_OK)
-                    {
-                        LogError("unable to HTTPHeaders_GetHeader");
-                        break;
-                    }
-                    else
-                    {
-                        (void)strcat(result, temp);
-                        (void)strcat(result, "\r\n");
-                        free(temp);
-                    }
-                }
-
-                if (i < headersCount)
-                {
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    /*all is good*/
-                }
-            }
+            result[serializedSize] = '\0';
         }
     }
 
@@ -764,6 +720,35 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+
+    if ((handle == NULL) || (requests == NULL) || (requestCount == 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        size_t i;
+
+        /*this adapter does not pipeline, the requests are executed one after the other on the same handle*/
+        result = HTTPAPI_OK;
+        for (i = 0; i < requestCount; i++)
+        {
+            requests[i].result = HTTPAPI_ExecuteRequest(handle, requests[i].requestType, requests[i].relativePath, requests[i].httpHeadersHandle,
+                requests[i].content, requests[i].contentLength, &requests[i].statusCode, requests[i].responseHeadersHandle, requests[i].responseContent);
+            if ((requests[i].result != HTTPAPI_OK) && (result == HTTPAPI_OK))
+            {
+                result = requests[i].result;
+            }
+        }
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -73,3 +73,14 @@ time_t get_time_s()
     return (time_t)ts.tv_sec;
 }
 
+int64_t get_time_ms()
+{
+    struct timespec ts;
+    if (get_time_ns(&ts) != 0)
+    {
+        LogError("Failed to get the current time");
+        return INVALID_TIME_VALUE_MS;
+    }
+
+    return ((int64_t)ts.tv_sec * MILLISECONDS_IN_1_SECOND) + (ts.tv_nsec / NANOSECONDS_IN_1_MILLISECOND);
+}
@@ -6,6 +6,7 @@
 
 #include <time.h>
 #include <pthread.h>
+#include <stdint.h>
 
 #ifndef __MACH__
 extern clockid_t time_basis;
@@ -14,8 +15,10 @@ extern clockid_t time_basis;
 extern void set_time_basis(void);
 extern int get_time_ns(struct timespec* ts);
 extern time_t get_time_s(void);
+extern int64_t get_time_ms(void);
 
 #define INVALID_TIME_VALUE      (time_t)(-1)
+#define INVALID_TIME_VALUE_MS   (int64_t)(-1)
 
 
 #define NANOSECONDS_IN_1_SECOND 1000000000L
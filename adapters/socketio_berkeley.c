@@ -18,6 +18,8 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -25,6 +27,9 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <limits.h>
 #ifdef TIZENRT
 #include <net/lwip/tcp.h>
 #else
@@ -42,11 +47,22 @@
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/const_defines.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "dns_async.h"
+#include "socketio_berkeley.h"
+#ifdef USE_IO_URING
+#include "azure_c_shared_utility/socketio_uring.h"
+#endif
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/un.h>
 
+#if defined(__linux__) && !defined(TIZENRT)
+#include <sys/epoll.h>
+#define SOCKETIO_EVENT_LOOP_SUPPORTED
+#endif
+
 #define SOCKET_SUCCESS                 0
 #define INVALID_SOCKET                 -1
 #define MAC_ADDRESS_STRING_LENGTH      18
@@ -58,6 +74,36 @@
 // connect timeout in seconds
 #define CONNECT_TIMEOUT         10
 
+// delay before the next address is raced against the connection attempts still in progress (RFC 8305 Connection Attempt Delay)
+#ifndef CONNECTION_ATTEMPT_DELAY_MS
+#define CONNECTION_ATTEMPT_DELAY_MS    250
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX                 16
+#endif
+
+// largest receive buffer when OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE is not set, the buffer starts at RECEIVE_BYTES_VALUE
+#ifndef DEFAULT_MAX_RECEIVE_BUFFER_SIZE
+#define DEFAULT_MAX_RECEIVE_BUFFER_SIZE    (16 * 1024)
+#endif
+
+// number of consecutive reads filling the whole receive buffer after which its size is doubled
+#define RECEIVE_BUFFER_GROWTH_THRESHOLD    4
+
+// number of segments socketio_send_vectored handles without allocating
+#define SEND_VECTORED_STACK_SEGMENTS    8
+
+// maximum number of ready sockets reported by a single epoll_wait in socketio_dowork_all
+#ifndef EVENT_LOOP_MAX_EVENTS
+#define EVENT_LOOP_MAX_EVENTS   64
+#endif
+
+// longest wait of socketio_dowork_all while an instance in the event loop is still opening, its lookup and connection attempts being polled
+#ifndef EVENT_LOOP_OPENING_POLL_MS
+#define EVENT_LOOP_OPENING_POLL_MS    10
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_CLOSED,
@@ -69,13 +115,43 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
+    /* copy of the data owned by the pending IO, NULL when the caller's segments are referenced */
     unsigned char* bytes;
-    size_t size;
+    /* segments left to send, advanced in place as bytes get written */
+    struct iovec* iov;
+    size_t iov_count;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
 } PENDING_SOCKET_IO;
 
+typedef enum SOCKET_OPTION_TAG
+{
+    SOCKET_OPTION_SO_RCVBUF,
+    SOCKET_OPTION_SO_SNDBUF,
+    SOCKET_OPTION_TCP_NODELAY,
+    SOCKET_OPTION_TCP_QUICKACK,
+    SOCKET_OPTION_SO_KEEPALIVE,
+    SOCKET_OPTION_TCP_KEEPIDLE,
+    SOCKET_OPTION_TCP_KEEPINTVL,
+    SOCKET_OPTION_COUNT
+} SOCKET_OPTION;
+
+#define SOCKET_OPTION_NOT_SET    -1
+
+typedef struct CONNECT_ATTEMPT_TAG
+{
+    union
+    {
+        struct sockaddr addr;
+        struct sockaddr_in addr_in;
+        struct sockaddr_in6 addr_in6;
+        struct sockaddr_un addr_un;
+    } address;
+    socklen_t address_length;
+    int socket;
+} CONNECT_ATTEMPT;
+
 typedef struct SOCKET_IO_INSTANCE_TAG
 {
     int socket;
@@ -84,14 +160,49 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     ON_IO_ERROR on_io_error;
     void* on_bytes_received_context;
     void* on_io_error_context;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    /* lookup of hostname while the instance is opening */
+    DNS_ASYNC_HANDLE dns;
+    /* addresses raced once the lookup is done, attempts below next_connect_attempt have been started */
+    CONNECT_ATTEMPT* connect_attempts;
+    size_t connect_attempt_count;
+    size_t next_connect_attempt;
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t connect_start_ms;
+    tickcounter_ms_t last_connect_attempt_ms;
     char* hostname;
     int port;
     char* target_mac_address;
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
-    unsigned char recv_bytes[RECEIVE_BYTES_VALUE];
+    bool use_event_loop;
+    bool in_event_loop;
+    uint32_t event_loop_events;
+    /* link in the list of event loop instances that socketio_dowork_all keeps opening */
+    struct SOCKET_IO_INSTANCE_TAG* next_opening_instance;
+    /* values given to socketio_setoption, SOCKET_OPTION_NOT_SET for the options left to the system */
+    int socket_options[SOCKET_OPTION_COUNT];
+    /* grows from RECEIVE_BYTES_VALUE up to max_recv_bytes_size while reads keep filling it */
+    unsigned char* recv_bytes;
+    size_t recv_bytes_size;
+    size_t max_recv_bytes_size;
+    size_t full_receive_count;
 } SOCKET_IO_INSTANCE;
 
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+/* The event loop is shared by all instances that opt in with OPTION_SOCKETIO_USE_EVENT_LOOP.
+   It is not thread safe: those instances must be opened, closed and serviced from the thread calling socketio_dowork_all. */
+static int event_loop_fd = INVALID_SOCKET;
+static size_t event_loop_instance_count = 0;
+static struct epoll_event* event_loop_dispatch_events = NULL;
+static int event_loop_dispatch_index = 0;
+static int event_loop_dispatch_count = 0;
+/* instances opened with the event loop option that have not connected yet, and the next one socketio_dowork_all advances */
+static SOCKET_IO_INSTANCE* event_loop_opening_instances = NULL;
+static SOCKET_IO_INSTANCE* event_loop_opening_cursor = NULL;
+#endif
+
 typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
 {
     char* name;
@@ -100,6 +211,79 @@ typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
     struct NETWORK_INTERFACE_DESCRIPTION_TAG* next;
 } NETWORK_INTERFACE_DESCRIPTION;
 
+/* Returns the socket option set with the option name, or SOCKET_OPTION_COUNT when the name is not a socket option */
+static SOCKET_OPTION get_socket_option(const char* name)
+{
+    SOCKET_OPTION result;
+
+    if (strcmp(name, OPTION_SOCKETIO_SO_RCVBUF) == 0)
+    {
+        result = SOCKET_OPTION_SO_RCVBUF;
+    }
+    else if (strcmp(name, OPTION_SOCKETIO_SO_SNDBUF) == 0)
+    {
+        result = SOCKET_OPTION_SO_SNDBUF;
+    }
+    else if (strcmp(name, OPTION_SOCKETIO_TCP_NODELAY) == 0)
+    {
+        result = SOCKET_OPTION_TCP_NODELAY;
+    }
+    else if (strcmp(name, OPTION_SOCKETIO_TCP_QUICKACK) == 0)
+    {
+        result = SOCKET_OPTION_TCP_QUICKACK;
+    }
+    else if (strcmp(name, "tcp_keepalive") == 0)
+    {
+        result = SOCKET_OPTION_SO_KEEPALIVE;
+    }
+    else if (strcmp(name, "tcp_keepalive_time") == 0)
+    {
+        result = SOCKET_OPTION_TCP_KEEPIDLE;
+    }
+    else if (strcmp(name, "tcp_keepalive_interval") == 0)
+    {
+        result = SOCKET_OPTION_TCP_KEEPINTVL;
+    }
+    else
+    {
+        result = SOCKET_OPTION_COUNT;
+    }
+
+    return result;
+}
+
+static const char* get_socket_option_name(SOCKET_OPTION socket_option)
+{
+    const char* result;
+
+    switch (socket_option)
+    {
+    case SOCKET_OPTION_SO_RCVBUF:
+        result = OPTION_SOCKETIO_SO_RCVBUF;
+        break;
+    case SOCKET_OPTION_SO_SNDBUF:
+        result = OPTION_SOCKETIO_SO_SNDBUF;
+        break;
+    case SOCKET_OPTION_TCP_NODELAY:
+        result = OPTION_SOCKETIO_TCP_NODELAY;
+        break;
+    case SOCKET_OPTION_TCP_QUICKACK:
+        result = OPTION_SOCKETIO_TCP_QUICKACK;
+        break;
+    case SOCKET_OPTION_SO_KEEPALIVE:
+        result = "tcp_keepalive";
+        break;
+    case SOCKET_OPTION_TCP_KEEPIDLE:
+        result = "tcp_keepalive_time";
+        break;
+    default:
+        result = "tcp_keepalive_interval";
+        break;
+    }
+
+    return result;
+}
+
 /*this function will clone an option given by name and value*/
 static void* socketio_CloneOption(const char* name, const void* value)
 {
@@ -129,6 +313,51 @@ static void* socketio_CloneOption(const char* name, const void* value)
                 }
             }
         }
+        else if (strcmp(name, OPTION_SOCKETIO_USE_EVENT_LOOP) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(bool*)result = *(const bool*)value;
+            }
+        }
+        else if (strcmp(name, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(size_t*)result = *(const size_t*)value;
+            }
+        }
+        else if (get_socket_option(name) != SOCKET_OPTION_COUNT)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(int))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(int*)result = *(const int*)value;
+            }
+        }
         else
         {
             LogError("Cannot clone option %s (not suppported)", name);
@@ -146,14 +375,17 @@ static void socketio_DestroyOption(const char* name, const void* value)
 {
     if (name != NULL)
     {
-        if (strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 && value != NULL)
+        if ((strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 ||
+             strcmp(name, OPTION_SOCKETIO_USE_EVENT_LOOP) == 0 ||
+             strcmp(name, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE) == 0 ||
+             get_socket_option(name) != SOCKET_OPTION_COUNT) && value != NULL)
         {
             free((void*)value);
         }
     }
 }
 
-static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
+OPTIONHANDLER_HANDLE socketio_berkeley_retrieve_options(CONCRETE_IO_HANDLE handle, pfSetOption set_option)
 {
     OPTIONHANDLER_HANDLE result;
 
@@ -166,7 +398,7 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)handle;
 
-        result = OptionHandler_Create(socketio_CloneOption, socketio_DestroyOption, socketio_setoption);
+        result = OptionHandler_Create(socketio_CloneOption, socketio_DestroyOption, set_option);
         if (result == NULL)
         {
             LogError("unable to OptionHandler_Create");
@@ -178,11 +410,45 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
             OptionHandler_Destroy(result);
             result = NULL;
         }
+        else if (socket_io_instance->use_event_loop &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_USE_EVENT_LOOP, &socket_io_instance->use_event_loop) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding use_event_loop)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->max_recv_bytes_size != DEFAULT_MAX_RECEIVE_BUFFER_SIZE &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE, &socket_io_instance->max_recv_bytes_size) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding receive_buffer_size)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            int i;
+            for (i = 0; i < SOCKET_OPTION_COUNT; i++)
+            {
+                if (socket_io_instance->socket_options[i] != SOCKET_OPTION_NOT_SET &&
+                    OptionHandler_AddOption(result, get_socket_option_name((SOCKET_OPTION)i), &socket_io_instance->socket_options[i]) != OPTIONHANDLER_OK)
+                {
+                    LogError("failed retrieving options (failed adding %s)", get_socket_option_name((SOCKET_OPTION)i));
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                    break;
+                }
+            }
+        }
     }
 
     return result;
 }
 
+static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
+{
+    return socketio_berkeley_retrieve_options(handle, socketio_setoption);
+}
+
 static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
 {
     socketio_retrieveoptions,
@@ -192,7 +458,8 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_send_vectored
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -204,192 +471,240 @@ static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
     }
 }
 
-static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+/* the pending IO, its segments and, when copy_bytes is true, a copy of the data live in a single allocation */
+static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const struct iovec* iov, size_t iov_count, bool copy_bytes, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
-    PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO));
+    size_t bytes_size = 0;
+    size_t i;
+    PENDING_SOCKET_IO* pending_socket_io;
+
+    if (copy_bytes)
+    {
+        for (i = 0; i < iov_count; i++)
+        {
+            bytes_size += iov[i].iov_len;
+        }
+
+        pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO) + sizeof(struct iovec) + bytes_size);
+    }
+    else
+    {
+        pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO) + (iov_count * sizeof(struct iovec)));
+    }
+
     if (pending_socket_io == NULL)
     {
+        LogError("Allocation Failure: Unable to allocate pending list.");
         result = __FAILURE__;
     }
     else
     {
-        pending_socket_io->bytes = (unsigned char*)malloc(size);
-        if (pending_socket_io->bytes == NULL)
+        pending_socket_io->iov = (struct iovec*)(pending_socket_io + 1);
+        pending_socket_io->on_send_complete = on_send_complete;
+        pending_socket_io->callback_context = callback_context;
+        pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
+
+        if (copy_bytes)
+        {
+            size_t offset = 0;
+
+            pending_socket_io->bytes = (unsigned char*)(pending_socket_io->iov + 1);
+            for (i = 0; i < iov_count; i++)
+            {
+                (void)memcpy(pending_socket_io->bytes + offset, iov[i].iov_base, iov[i].iov_len);
+                offset += iov[i].iov_len;
+            }
+
+            pending_socket_io->iov[0].iov_base = pending_socket_io->bytes;
+            pending_socket_io->iov[0].iov_len = bytes_size;
+            pending_socket_io->iov_count = 1;
+        }
+        else
+        {
+            pending_socket_io->bytes = NULL;
+            (void)memcpy(pending_socket_io->iov, iov, iov_count * sizeof(struct iovec));
+            pending_socket_io->iov_count = iov_count;
+        }
+
+        if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
         {
-            LogError("Allocation Failure: Unable to allocate pending list.");
+            LogError("Failure: Unable to add socket to pending list.");
             free(pending_socket_io);
             result = __FAILURE__;
         }
         else
         {
-            pending_socket_io->size = size;
-            pending_socket_io->on_send_complete = on_send_complete;
-            pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
-            (void)memcpy(pending_socket_io->bytes, buffer, size);
-
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
-            {
-                LogError("Failure: Unable to add socket to pending list.");
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            result = 0;
         }
     }
+
     return result;
 }
 
-static STATIC_VAR_UNUSED void signal_callback(int signum)
+static ssize_t send_iov(int socket, struct iovec* iov, size_t iov_count)
 {
-    AZURE_UNREFERENCED_PARAMETER(signum);
-    LogError("Socket received signal %d.", signum);
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (iov_count > IOV_MAX) ? IOV_MAX : iov_count;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    return sendmsg(socket, &msg, 0);
 }
 
-static int lookup_address_and_initiate_socket_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+/* advances the segments past the sent bytes, returns true when nothing is left to send */
+static bool consume_iov(struct iovec** iov, size_t* iov_count, size_t sent)
 {
-    int result;
-    int err;
-
-    struct addrinfo addrInfoHintIp;
-    struct sockaddr_un addrInfoUn;
-    struct sockaddr* connect_addr = NULL;
-    socklen_t connect_addr_len;
-    struct addrinfo* addrInfoIp = NULL;
+    while ((*iov_count > 0) && (sent >= (*iov)->iov_len))
+    {
+        sent -= (*iov)->iov_len;
+        (*iov)++;
+        (*iov_count)--;
+    }
 
-    if (socket_io_instance->address_type == ADDRESS_TYPE_IP)
+    if (*iov_count > 0)
     {
-        char portString[16];
+        (*iov)->iov_base = (unsigned char*)(*iov)->iov_base + sent;
+        (*iov)->iov_len -= sent;
+    }
 
-        memset(&addrInfoHintIp, 0, sizeof(addrInfoHintIp));
-        addrInfoHintIp.ai_family = AF_INET;
-        addrInfoHintIp.ai_socktype = SOCK_STREAM;
+    return (*iov_count == 0);
+}
 
-        sprintf(portString, "%u", socket_io_instance->port);
-        err = getaddrinfo(socket_io_instance->hostname, portString, &addrInfoHintIp, &addrInfoIp);
-        if (err != 0)
-        {
-            LogError("Failure: getaddrinfo failure %d.", err);
-            result = __FAILURE__;
-        }
-        else
-        {
-            connect_addr = addrInfoIp->ai_addr;
-            connect_addr_len = sizeof(*addrInfoIp->ai_addr);
-            result = 0;
-        }
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+static int event_loop_register(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+
+    if (event_loop_fd == INVALID_SOCKET &&
+        (event_loop_fd = epoll_create1(EPOLL_CLOEXEC)) == INVALID_SOCKET)
+    {
+        LogError("Failure: epoll_create1 failed. errno=%d (%s).", errno, strerror(errno));
+        result = __FAILURE__;
     }
     else
     {
-        size_t hostname_len = strlen(socket_io_instance->hostname);
-        if (hostname_len + 1 > sizeof(addrInfoUn.sun_path))
+        struct epoll_event event;
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = socket_io_instance;
+
+        if (epoll_ctl(event_loop_fd, EPOLL_CTL_ADD, socket_io_instance->socket, &event) != 0)
         {
-            LogError("Hostname %s is too long for a unix socket (max len = %zu)", socket_io_instance->hostname, sizeof(addrInfoUn.sun_path));
+            LogError("Failure: epoll_ctl failed adding socket. errno=%d (%s).", errno, strerror(errno));
+            if (event_loop_instance_count == 0)
+            {
+                (void)close(event_loop_fd);
+                event_loop_fd = INVALID_SOCKET;
+            }
             result = __FAILURE__;
         }
         else
         {
-            memset(&addrInfoUn, 0, sizeof(addrInfoUn));
-            addrInfoUn.sun_family = AF_UNIX;
-            // No need to add NULL terminator due to the above memset
-            (void)memcpy(addrInfoUn.sun_path, socket_io_instance->hostname, hostname_len);
-
-            connect_addr = (struct sockaddr*)&addrInfoUn;
-            connect_addr_len = sizeof(addrInfoUn);
+            socket_io_instance->in_event_loop = true;
+            socket_io_instance->event_loop_events = event.events;
+            event_loop_instance_count++;
             result = 0;
         }
     }
 
-    if (result == 0)
+    return result;
+}
+
+static void event_loop_unregister(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->in_event_loop)
     {
-        int flags;
+        int i;
 
-        if ((-1 == (flags = fcntl(socket_io_instance->socket, F_GETFL, 0))) ||
-            (fcntl(socket_io_instance->socket, F_SETFL, flags | O_NONBLOCK) == -1))
-        {
-            LogError("Failure: fcntl failure.");
-            result = __FAILURE__;
-        }
-        else
+        /* the socket is about to be closed, which removes it from the epoll set, but it is removed explicitly to be safe with duplicated descriptors */
+        (void)epoll_ctl(event_loop_fd, EPOLL_CTL_DEL, socket_io_instance->socket, NULL);
+        socket_io_instance->in_event_loop = false;
+
+        /* drop any event still being dispatched in this round so that a callback closing or destroying an instance does not leave a dangling pointer */
+        for (i = event_loop_dispatch_index; i < event_loop_dispatch_count; i++)
         {
-            err = connect(socket_io_instance->socket, connect_addr, connect_addr_len);
-            if ((err != 0) && (errno != EINPROGRESS))
+            if (event_loop_dispatch_events[i].data.ptr == socket_io_instance)
             {
-                LogError("Failure: connect failure %d.", errno);
-                result = __FAILURE__;
+                event_loop_dispatch_events[i].data.ptr = NULL;
             }
         }
-    }
 
-    if (addrInfoIp != NULL)
-    {
-        freeaddrinfo(addrInfoIp);
+        if (--event_loop_instance_count == 0)
+        {
+            (void)close(event_loop_fd);
+            event_loop_fd = INVALID_SOCKET;
+        }
     }
-
-    return result;
 }
 
-static int wait_for_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+static void event_loop_add_opening(SOCKET_IO_INSTANCE* socket_io_instance)
 {
-    int result;
-    int err;
-    int retval;
-    int select_errno = 0;
+    socket_io_instance->next_opening_instance = event_loop_opening_instances;
+    event_loop_opening_instances = socket_io_instance;
+}
 
-    fd_set fdset;
-    struct timeval tv;
+static void event_loop_remove_opening(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    SOCKET_IO_INSTANCE** link = &event_loop_opening_instances;
 
-    FD_ZERO(&fdset);
-    FD_SET(socket_io_instance->socket, &fdset);
-    tv.tv_sec = CONNECT_TIMEOUT;
-    tv.tv_usec = 0;
+    while (*link != NULL && *link != socket_io_instance)
+    {
+        link = &(*link)->next_opening_instance;
+    }
 
-    do
+    if (*link != NULL)
     {
-        retval = select(socket_io_instance->socket + 1, NULL, &fdset, NULL, &tv);
+        *link = socket_io_instance->next_opening_instance;
 
-        if (retval < 0)
+        /* an open completing from socketio_dowork_all may close or destroy the instance it would advance next */
+        if (event_loop_opening_cursor == socket_io_instance)
         {
-            select_errno = errno;
+            event_loop_opening_cursor = socket_io_instance->next_opening_instance;
         }
-    } while (retval < 0 && select_errno == EINTR);
 
-    if (retval != 1)
-    {
-        LogError("Failure: select failure.");
-        result = __FAILURE__;
+        socket_io_instance->next_opening_instance = NULL;
     }
-    else
+}
+
+static void event_loop_update_write_interest(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->in_event_loop)
     {
-        int so_error = 0;
-        socklen_t len = sizeof(so_error);
-        err = getsockopt(socket_io_instance->socket, SOL_SOCKET, SO_ERROR, &so_error, &len);
-        if (err != 0)
-        {
-            LogError("Failure: getsockopt failure %d.", errno);
-            result = __FAILURE__;
-        }
-        else if (so_error != 0)
+        struct epoll_event event;
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        if (singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL)
         {
-            err = so_error;
-            LogError("Failure: connect failure %d.", so_error);
-            result = __FAILURE__;
+            event.events |= EPOLLOUT;
         }
-        else
+        event.data.ptr = socket_io_instance;
+
+        if (event.events != socket_io_instance->event_loop_events)
         {
-            result = 0;
+            if (epoll_ctl(event_loop_fd, EPOLL_CTL_MOD, socket_io_instance->socket, &event) != 0)
+            {
+                LogError("Failure: epoll_ctl failed updating socket. errno=%d (%s).", errno, strerror(errno));
+            }
+            else
+            {
+                socket_io_instance->event_loop_events = event.events;
+            }
         }
     }
-
-    return result;
 }
+#endif
 
-
+static STATIC_VAR_UNUSED void signal_callback(int signum)
+{
+    AZURE_UNREFERENCED_PARAMETER(signum);
+    LogError("Socket received signal %d.", signum);
+}
 
 #ifndef __APPLE__
 static void destroy_network_interface_descriptions(NETWORK_INTERFACE_DESCRIPTION* nid)
@@ -608,40 +923,502 @@ static int set_target_network_interface(int socket, char* mac_address)
 }
 #endif //__APPLE__
 
-CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
+static int set_socket_option(int socket, SOCKET_OPTION socket_option, int value)
 {
-    SOCKETIO_CONFIG* socket_io_config = io_create_parameters;
-    SOCKET_IO_INSTANCE* result;
+    int result;
 
-    if (socket_io_config == NULL)
+    switch (socket_option)
     {
-        LogError("Invalid argument: socket_io_config is NULL");
-        result = NULL;
+    case SOCKET_OPTION_SO_RCVBUF:
+        result = setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+        break;
+    case SOCKET_OPTION_SO_SNDBUF:
+        result = setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+        break;
+    case SOCKET_OPTION_TCP_NODELAY:
+        result = setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+        break;
+    case SOCKET_OPTION_TCP_QUICKACK:
+#ifdef TCP_QUICKACK
+        result = setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+#else
+        errno = ENOPROTOOPT;
+        result = -1;
+#endif
+        break;
+    case SOCKET_OPTION_SO_KEEPALIVE:
+        result = setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(value));
+        break;
+    case SOCKET_OPTION_TCP_KEEPIDLE:
+#ifdef __APPLE__
+        result = setsockopt(socket, IPPROTO_TCP, TCP_KEEPALIVE, &value, sizeof(value));
+#else
+        result = setsockopt(socket, IPPROTO_TCP, TCP_KEEPIDLE, &value, sizeof(value));
+#endif
+        break;
+    default:
+        result = setsockopt(socket, IPPROTO_TCP, TCP_KEEPINTVL, &value, sizeof(value));
+        break;
     }
-    else
+
+    if (result != 0)
     {
-        result = malloc(sizeof(SOCKET_IO_INSTANCE));
-        if (result != NULL)
-        {
-            result->address_type = ADDRESS_TYPE_IP;
-            result->pending_io_list = singlylinkedlist_create();
-            if (result->pending_io_list == NULL)
-            {
-                LogError("Failure: singlylinkedlist_create unable to create pending list.");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                if (socket_io_config->hostname != NULL)
-                {
-                    result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
-                    if (result->hostname != NULL)
-                    {
-                        (void)strcpy(result->hostname, socket_io_config->hostname);
-                    }
+        LogError("Failure: setting %s failed. errno=%d (%s).", get_socket_option_name(socket_option), errno, strerror(errno));
+        result = __FAILURE__;
+    }
 
-                    result->socket = INVALID_SOCKET;
+    return result;
+}
+
+/* Gives the options set with socketio_setoption to a socket, the TCP ones only when it is not a unix domain socket */
+static int set_socket_options(SOCKET_IO_INSTANCE* socket_io_instance, int socket)
+{
+    int result = 0;
+    int i;
+
+    for (i = 0; i < SOCKET_OPTION_COUNT && result == 0; i++)
+    {
+        if (socket_io_instance->socket_options[i] != SOCKET_OPTION_NOT_SET &&
+            (socket_io_instance->address_type == ADDRESS_TYPE_IP || i == SOCKET_OPTION_SO_RCVBUF || i == SOCKET_OPTION_SO_SNDBUF || i == SOCKET_OPTION_SO_KEEPALIVE))
+        {
+            result = set_socket_option(socket, (SOCKET_OPTION)i, socket_io_instance->socket_options[i]);
+        }
+    }
+
+    return result;
+}
+
+static int initiate_socket_connection(SOCKET_IO_INSTANCE* socket_io_instance, CONNECT_ATTEMPT* connect_attempt)
+{
+    int result;
+    int flags;
+
+    connect_attempt->socket = socket(connect_attempt->address.addr.sa_family, SOCK_STREAM, 0);
+    if (connect_attempt->socket < SOCKET_SUCCESS)
+    {
+        LogError("Failure: socket create failure %d.", connect_attempt->socket);
+        result = __FAILURE__;
+    }
+#ifndef __APPLE__
+    else if (socket_io_instance->target_mac_address != NULL &&
+             set_target_network_interface(connect_attempt->socket, socket_io_instance->target_mac_address) != 0)
+    {
+        LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
+        result = __FAILURE__;
+    }
+#endif //__APPLE__
+    else if ((-1 == (flags = fcntl(connect_attempt->socket, F_GETFL, 0))) ||
+             (fcntl(connect_attempt->socket, F_SETFL, flags | O_NONBLOCK) == -1))
+    {
+        LogError("Failure: fcntl failure.");
+        result = __FAILURE__;
+    }
+    /* the receive buffer size decides the TCP window scale, which is only negotiated while connecting */
+    else if (set_socket_options(socket_io_instance, connect_attempt->socket) != 0)
+    {
+        LogError("Failure: unable to set the socket options.");
+        result = __FAILURE__;
+    }
+    else if ((connect(connect_attempt->socket, &connect_attempt->address.addr, connect_attempt->address_length) != 0) && (errno != EINPROGRESS))
+    {
+        LogError("Failure: connect failure %d.", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result != 0 && connect_attempt->socket >= SOCKET_SUCCESS)
+    {
+        close(connect_attempt->socket);
+    }
+    if (result != 0)
+    {
+        connect_attempt->socket = INVALID_SOCKET;
+    }
+
+    return result;
+}
+
+static int create_unix_socket_attempt(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    size_t hostname_len = strlen(socket_io_instance->hostname);
+
+    if (hostname_len + 1 > sizeof(((struct sockaddr_un*)NULL)->sun_path))
+    {
+        LogError("Hostname %s is too long for a unix socket (max len = %zu)", socket_io_instance->hostname, sizeof(((struct sockaddr_un*)NULL)->sun_path));
+        result = __FAILURE__;
+    }
+    else if ((socket_io_instance->connect_attempts = (CONNECT_ATTEMPT*)malloc(sizeof(CONNECT_ATTEMPT))) == NULL)
+    {
+        LogError("Failure: unable to allocate the connection attempt.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CONNECT_ATTEMPT* connect_attempt = &socket_io_instance->connect_attempts[0];
+
+        memset(connect_attempt, 0, sizeof(CONNECT_ATTEMPT));
+        connect_attempt->address.addr_un.sun_family = AF_UNIX;
+        // No need to add NULL terminator due to the above memset
+        (void)memcpy(connect_attempt->address.addr_un.sun_path, socket_io_instance->hostname, hostname_len);
+        connect_attempt->address_length = sizeof(connect_attempt->address.addr_un);
+        connect_attempt->socket = INVALID_SOCKET;
+
+        socket_io_instance->connect_attempt_count = 1;
+        socket_io_instance->next_connect_attempt = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Orders the resolved addresses as RFC 8305 section 4 asks: alternating address families, starting with the family the resolver preferred */
+static int create_resolved_address_attempts(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    size_t address_count = dns_async_get_address_count(socket_io_instance->dns);
+    DNS_ASYNC_ADDRESS* addresses;
+
+    if (address_count == 0)
+    {
+        LogError("Failure: no address found for %s.", socket_io_instance->hostname);
+        result = __FAILURE__;
+    }
+    else if ((addresses = (DNS_ASYNC_ADDRESS*)malloc(address_count * sizeof(DNS_ASYNC_ADDRESS))) == NULL)
+    {
+        LogError("Failure: unable to allocate the resolved addresses.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+        for (i = 0; i < address_count; i++)
+        {
+            if (dns_async_get_address(socket_io_instance->dns, i, &addresses[i]) != 0)
+            {
+                LogError("Failure: dns_async_get_address failed.");
+                result = __FAILURE__;
+                break;
+            }
+        }
+
+        if (result == 0)
+        {
+            if ((socket_io_instance->connect_attempts = (CONNECT_ATTEMPT*)malloc(address_count * sizeof(CONNECT_ATTEMPT))) == NULL)
+            {
+                LogError("Failure: unable to allocate the connection attempts.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* next_address[type] is where the search for the next address of that family resumes */
+                size_t next_address[2] = { 0, 0 };
+                DNS_ASYNC_ADDRESS_TYPE family = addresses[0].type;
+
+                for (i = 0; i < address_count; i++)
+                {
+                    CONNECT_ATTEMPT* connect_attempt = &socket_io_instance->connect_attempts[i];
+                    DNS_ASYNC_ADDRESS* address = NULL;
+                    int pass;
+
+                    /* take the next address of the current family, or of the other one when the current family is exhausted */
+                    for (pass = 0; pass < 2 && address == NULL; pass++)
+                    {
+                        while (next_address[family] < address_count && addresses[next_address[family]].type != family)
+                        {
+                            next_address[family]++;
+                        }
+
+                        if (next_address[family] < address_count)
+                        {
+                            address = &addresses[next_address[family]];
+                            next_address[family]++;
+                        }
+
+                        family = (family == DNS_ASYNC_ADDRESS_TYPE_IPV4) ? DNS_ASYNC_ADDRESS_TYPE_IPV6 : DNS_ASYNC_ADDRESS_TYPE_IPV4;
+                    }
+
+                    memset(connect_attempt, 0, sizeof(CONNECT_ATTEMPT));
+                    connect_attempt->socket = INVALID_SOCKET;
+                    if (address->type == DNS_ASYNC_ADDRESS_TYPE_IPV4)
+                    {
+                        connect_attempt->address.addr_in.sin_family = AF_INET;
+                        connect_attempt->address.addr_in.sin_port = htons((uint16_t)socket_io_instance->port);
+                        (void)memcpy(&connect_attempt->address.addr_in.sin_addr, address->address, sizeof(connect_attempt->address.addr_in.sin_addr));
+                        connect_attempt->address_length = sizeof(connect_attempt->address.addr_in);
+                    }
+                    else
+                    {
+                        connect_attempt->address.addr_in6.sin6_family = AF_INET6;
+                        connect_attempt->address.addr_in6.sin6_port = htons((uint16_t)socket_io_instance->port);
+                        (void)memcpy(&connect_attempt->address.addr_in6.sin6_addr, address->address, sizeof(connect_attempt->address.addr_in6.sin6_addr));
+                        connect_attempt->address.addr_in6.sin6_scope_id = address->scope_id;
+                        connect_attempt->address_length = sizeof(connect_attempt->address.addr_in6);
+                    }
+                }
+
+                socket_io_instance->connect_attempt_count = address_count;
+                socket_io_instance->next_connect_attempt = 0;
+            }
+        }
+
+        free(addresses);
+    }
+
+    return result;
+}
+
+/* Closes every connection attempt but the one at winner_index, which becomes the socket of the instance. Pass connect_attempt_count to close them all. */
+static void stop_connecting(SOCKET_IO_INSTANCE* socket_io_instance, size_t winner_index)
+{
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+    event_loop_remove_opening(socket_io_instance);
+#endif
+
+    if (socket_io_instance->dns != NULL)
+    {
+        dns_async_destroy(socket_io_instance->dns);
+        socket_io_instance->dns = NULL;
+    }
+
+    if (socket_io_instance->connect_attempts != NULL)
+    {
+        size_t i;
+        for (i = 0; i < socket_io_instance->next_connect_attempt; i++)
+        {
+            if (i == winner_index)
+            {
+                socket_io_instance->socket = socket_io_instance->connect_attempts[i].socket;
+            }
+            else if (socket_io_instance->connect_attempts[i].socket != INVALID_SOCKET)
+            {
+                close(socket_io_instance->connect_attempts[i].socket);
+            }
+        }
+
+        free(socket_io_instance->connect_attempts);
+        socket_io_instance->connect_attempts = NULL;
+        socket_io_instance->connect_attempt_count = 0;
+        socket_io_instance->next_connect_attempt = 0;
+    }
+}
+
+static void complete_open(SOCKET_IO_INSTANCE* socket_io_instance, size_t winner_index)
+{
+    int result;
+    ON_IO_OPEN_COMPLETE on_io_open_complete = socket_io_instance->on_io_open_complete;
+
+    stop_connecting(socket_io_instance, winner_index);
+    socket_io_instance->on_io_open_complete = NULL;
+
+    if (socket_io_instance->socket == INVALID_SOCKET)
+    {
+        LogError("Failure: unable to connect to %s.", socket_io_instance->hostname);
+        result = __FAILURE__;
+    }
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+    else if (socket_io_instance->use_event_loop && (result = event_loop_register(socket_io_instance)) != 0)
+    {
+        LogError("Failure: unable to add the socket to the event loop.");
+    }
+#endif
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        socket_io_instance->io_state = IO_STATE_OPEN;
+    }
+    else
+    {
+        if (socket_io_instance->socket != INVALID_SOCKET)
+        {
+            close(socket_io_instance->socket);
+        }
+        socket_io_instance->socket = INVALID_SOCKET;
+        socket_io_instance->io_state = IO_STATE_CLOSED;
+    }
+
+    if (on_io_open_complete != NULL)
+    {
+        on_io_open_complete(socket_io_instance->on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
+    }
+}
+
+/* Returns the index of the attempt that connected, or connect_attempt_count if none has connected yet. Failed attempts are closed. */
+static size_t check_connect_attempts(SOCKET_IO_INSTANCE* socket_io_instance, bool* has_attempt_in_progress)
+{
+    size_t result = socket_io_instance->connect_attempt_count;
+    size_t i;
+
+    *has_attempt_in_progress = false;
+    for (i = 0; i < socket_io_instance->next_connect_attempt && result == socket_io_instance->connect_attempt_count; i++)
+    {
+        CONNECT_ATTEMPT* connect_attempt = &socket_io_instance->connect_attempts[i];
+        if (connect_attempt->socket != INVALID_SOCKET)
+        {
+            struct pollfd poll_fd;
+            int poll_result;
+
+            poll_fd.fd = connect_attempt->socket;
+            poll_fd.events = POLLOUT;
+            poll_fd.revents = 0;
+
+            do
+            {
+                poll_result = poll(&poll_fd, 1, 0);
+            } while (poll_result < 0 && errno == EINTR);
+
+            if (poll_result == 0)
+            {
+                *has_attempt_in_progress = true;
+            }
+            else
+            {
+                int so_error = 0;
+                socklen_t len = sizeof(so_error);
+
+                if (poll_result < 0)
+                {
+                    LogError("Failure: poll failure %d.", errno);
+                    so_error = errno;
+                }
+                else if (getsockopt(connect_attempt->socket, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0)
+                {
+                    LogError("Failure: getsockopt failure %d.", errno);
+                    so_error = errno;
+                }
+
+                if (so_error == 0)
+                {
+                    result = i;
+                }
+                else
+                {
+                    LogInfo("Connection attempt %lu to %s failed: %d.", (unsigned long)i, socket_io_instance->hostname, so_error);
+                    close(connect_attempt->socket);
+                    connect_attempt->socket = INVALID_SOCKET;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Advances an opening instance without blocking: waits for the lookup, then races the connection attempts (RFC 8305) and completes the open */
+static void continue_opening(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    tickcounter_ms_t current_ms;
+
+    if (tickcounter_get_current_ms(socket_io_instance->tick_counter, &current_ms) != 0)
+    {
+        LogError("Failure: tickcounter_get_current_ms failed.");
+        complete_open(socket_io_instance, socket_io_instance->connect_attempt_count);
+    }
+    else if (socket_io_instance->dns != NULL && socket_io_instance->connect_attempts == NULL)
+    {
+        if (!dns_async_is_lookup_complete(socket_io_instance->dns))
+        {
+            if (current_ms - socket_io_instance->connect_start_ms >= CONNECT_TIMEOUT * 1000)
+            {
+                LogError("Failure: lookup of %s timed out.", socket_io_instance->hostname);
+                complete_open(socket_io_instance, socket_io_instance->connect_attempt_count);
+            }
+        }
+        else if (create_resolved_address_attempts(socket_io_instance) != 0)
+        {
+            complete_open(socket_io_instance, socket_io_instance->connect_attempt_count);
+        }
+        else
+        {
+            /* the addresses are copied, the lookup is not needed anymore */
+            dns_async_destroy(socket_io_instance->dns);
+            socket_io_instance->dns = NULL;
+            continue_opening(socket_io_instance);
+        }
+    }
+    else
+    {
+        bool has_attempt_in_progress;
+        size_t winner_index = check_connect_attempts(socket_io_instance, &has_attempt_in_progress);
+
+        /* start the next address when the previous attempts failed or have been given their head start */
+        while (winner_index == socket_io_instance->connect_attempt_count &&
+               socket_io_instance->next_connect_attempt < socket_io_instance->connect_attempt_count &&
+               (!has_attempt_in_progress || current_ms - socket_io_instance->last_connect_attempt_ms >= CONNECTION_ATTEMPT_DELAY_MS))
+        {
+            CONNECT_ATTEMPT* connect_attempt = &socket_io_instance->connect_attempts[socket_io_instance->next_connect_attempt];
+
+            socket_io_instance->next_connect_attempt++;
+            if (initiate_socket_connection(socket_io_instance, connect_attempt) == 0)
+            {
+                socket_io_instance->last_connect_attempt_ms = current_ms;
+                has_attempt_in_progress = true;
+
+                /* a connection to a local peer may already be established */
+                winner_index = check_connect_attempts(socket_io_instance, &has_attempt_in_progress);
+            }
+        }
+
+        if (winner_index != socket_io_instance->connect_attempt_count)
+        {
+            complete_open(socket_io_instance, winner_index);
+        }
+        else if (!has_attempt_in_progress && socket_io_instance->next_connect_attempt == socket_io_instance->connect_attempt_count)
+        {
+            LogError("Failure: every address of %s refused the connection.", socket_io_instance->hostname);
+            complete_open(socket_io_instance, socket_io_instance->connect_attempt_count);
+        }
+        else if (current_ms - socket_io_instance->connect_start_ms >= CONNECT_TIMEOUT * 1000)
+        {
+            LogError("Failure: connection to %s timed out.", socket_io_instance->hostname);
+            complete_open(socket_io_instance, socket_io_instance->connect_attempt_count);
+        }
+    }
+}
+
+CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
+{
+    SOCKETIO_CONFIG* socket_io_config = io_create_parameters;
+    SOCKET_IO_INSTANCE* result;
+
+    if (socket_io_config == NULL)
+    {
+        LogError("Invalid argument: socket_io_config is NULL");
+        result = NULL;
+    }
+    else
+    {
+        result = malloc(sizeof(SOCKET_IO_INSTANCE));
+        if (result != NULL)
+        {
+            result->address_type = ADDRESS_TYPE_IP;
+            result->pending_io_list = singlylinkedlist_create();
+            if (result->pending_io_list == NULL)
+            {
+                LogError("Failure: singlylinkedlist_create unable to create pending list.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                if (socket_io_config->hostname != NULL)
+                {
+                    result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
+                    if (result->hostname != NULL)
+                    {
+                        (void)strcpy(result->hostname, socket_io_config->hostname);
+                    }
+
+                    result->socket = INVALID_SOCKET;
                 }
                 else
                 {
@@ -656,15 +1433,53 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
                     free(result);
                     result = NULL;
                 }
+                else if ((result->tick_counter = tickcounter_create()) == NULL)
+                {
+                    LogError("Failure: tickcounter_create failed.");
+                    singlylinkedlist_destroy(result->pending_io_list);
+                    free(result->hostname);
+                    free(result);
+                    result = NULL;
+                }
+                else if ((result->recv_bytes = (unsigned char*)malloc(RECEIVE_BYTES_VALUE)) == NULL)
+                {
+                    LogError("Failure: unable to allocate the receive buffer.");
+                    tickcounter_destroy(result->tick_counter);
+                    singlylinkedlist_destroy(result->pending_io_list);
+                    free(result->hostname);
+                    free(result);
+                    result = NULL;
+                }
                 else
                 {
+                    int i;
+
                     result->port = socket_io_config->port;
                     result->target_mac_address = NULL;
                     result->on_bytes_received = NULL;
                     result->on_io_error = NULL;
                     result->on_bytes_received_context = NULL;
                     result->on_io_error_context = NULL;
+                    result->on_io_open_complete = NULL;
+                    result->on_io_open_complete_context = NULL;
+                    result->dns = NULL;
+                    result->connect_attempts = NULL;
+                    result->connect_attempt_count = 0;
+                    result->next_connect_attempt = 0;
+                    result->connect_start_ms = 0;
+                    result->last_connect_attempt_ms = 0;
                     result->io_state = IO_STATE_CLOSED;
+                    result->use_event_loop = false;
+                    result->in_event_loop = false;
+                    result->event_loop_events = 0;
+                    result->next_opening_instance = NULL;
+                    for (i = 0; i < SOCKET_OPTION_COUNT; i++)
+                    {
+                        result->socket_options[i] = SOCKET_OPTION_NOT_SET;
+                    }
+                    result->recv_bytes_size = RECEIVE_BYTES_VALUE;
+                    result->max_recv_bytes_size = DEFAULT_MAX_RECEIVE_BUFFER_SIZE;
+                    result->full_receive_count = 0;
                 }
             }
         }
@@ -682,6 +1497,11 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+        event_loop_unregister(socket_io_instance);
+#endif
+        stop_connecting(socket_io_instance, socket_io_instance->connect_attempt_count);
+
         /* we cannot do much if the close fails, so just ignore the result */
         if (socket_io_instance->socket != INVALID_SOCKET)
         {
@@ -695,7 +1515,12 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
             PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
             if (pending_socket_io != NULL)
             {
-                free(pending_socket_io->bytes);
+                /* the caller owns the memory of a vectored send and has to learn it is no longer referenced */
+                if ((pending_socket_io->bytes == NULL) && (pending_socket_io->on_send_complete != NULL))
+                {
+                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_CANCELLED);
+                }
+
                 free(pending_socket_io);
             }
 
@@ -704,6 +1529,8 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
         }
 
         singlylinkedlist_destroy(socket_io_instance->pending_io_list);
+        tickcounter_destroy(socket_io_instance->tick_counter);
+        free(socket_io_instance->recv_bytes);
         free(socket_io_instance->hostname);
         free(socket_io_instance->target_mac_address);
         free(socket_io);
@@ -713,6 +1540,7 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
 int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
 {
     int result;
+    bool is_open_pending = false;
 
     SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
     if (socket_io == NULL)
@@ -735,33 +1563,43 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
             socket_io_instance->on_io_error = on_io_error;
             socket_io_instance->on_io_error_context = on_io_error_context;
 
-            socket_io_instance->io_state = IO_STATE_OPEN;
-
-            result = 0;
-        }
-        else
-        {
-            socket_io_instance->socket = socket (socket_io_instance->address_type == ADDRESS_TYPE_IP ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
-            if (socket_io_instance->socket < SOCKET_SUCCESS)
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+            if (socket_io_instance->use_event_loop && event_loop_register(socket_io_instance) != 0)
             {
-                LogError("Failure: socket create failure %d.", socket_io_instance->socket);
+                LogError("Failure: unable to add the socket to the event loop.");
                 result = __FAILURE__;
             }
-#ifndef __APPLE__
-            else if (socket_io_instance->target_mac_address != NULL &&
-                     set_target_network_interface(socket_io_instance->socket, socket_io_instance->target_mac_address) != 0)
+            else
+#endif
             {
-                LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
-                result = __FAILURE__;
+                socket_io_instance->io_state = IO_STATE_OPEN;
+                result = 0;
             }
-#endif //__APPLE__
-            else if ((result = lookup_address_and_initiate_socket_connection(socket_io_instance)) != 0)
+        }
+        else
+        {
+            if (socket_io_instance->address_type == ADDRESS_TYPE_IP)
+            {
+                /* the lookup is shared with every other connection to the same host and cached, so only a cache miss waits for the resolver */
+                if ((socket_io_instance->dns = dns_async_create(socket_io_instance->hostname, NULL)) == NULL)
+                {
+                    LogError("Failure: dns_async_create failed.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+            else if ((result = create_unix_socket_attempt(socket_io_instance)) != 0)
             {
-                LogError("lookup_address_and_connect_socket failed");
+                LogError("create_unix_socket_attempt failed");
             }
-            else if ((result = wait_for_connection(socket_io_instance)) != 0)
+
+            if (result == 0 && tickcounter_get_current_ms(socket_io_instance->tick_counter, &socket_io_instance->connect_start_ms) != 0)
             {
-                LogError("wait_for_connection failed");
+                LogError("Failure: tickcounter_get_current_ms failed.");
+                result = __FAILURE__;
             }
 
             if (result == 0)
@@ -772,20 +1610,30 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
                 socket_io_instance->on_io_error = on_io_error;
                 socket_io_instance->on_io_error_context = on_io_error_context;
 
-                socket_io_instance->io_state = IO_STATE_OPEN;
+                socket_io_instance->on_io_open_complete = on_io_open_complete;
+                socket_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+
+                /* the connection is never awaited here: socketio_dowork reports its outcome through on_io_open_complete */
+                socket_io_instance->last_connect_attempt_ms = socket_io_instance->connect_start_ms;
+                socket_io_instance->io_state = IO_STATE_OPENING;
+                is_open_pending = true;
+
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+                if (socket_io_instance->use_event_loop)
+                {
+                    /* socketio_dowork_all polls the lookup and the connection attempts from now on, as socketio_dowork does */
+                    event_loop_add_opening(socket_io_instance);
+                }
+#endif
             }
             else
             {
-                if (socket_io_instance->socket >= SOCKET_SUCCESS)
-                {
-                    close(socket_io_instance->socket);
-                }
-                socket_io_instance->socket = INVALID_SOCKET;
+                stop_connecting(socket_io_instance, socket_io_instance->connect_attempt_count);
             }
         }
     }
 
-    if (on_io_open_complete != NULL)
+    if (!is_open_pending && on_io_open_complete != NULL)
     {
         on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
     }
@@ -793,120 +1641,345 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
     return result;
 }
 
-int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result = 0;
+
+    if (socket_io == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
+        {
+            /* no connection attempt has won yet, there is no socket */
+            ON_IO_OPEN_COMPLETE on_io_open_complete = socket_io_instance->on_io_open_complete;
+
+            stop_connecting(socket_io_instance, socket_io_instance->connect_attempt_count);
+            socket_io_instance->on_io_open_complete = NULL;
+            socket_io_instance->io_state = IO_STATE_CLOSED;
+
+            if (on_io_open_complete != NULL)
+            {
+                on_io_open_complete(socket_io_instance->on_io_open_complete_context, IO_OPEN_CANCELLED);
+            }
+        }
+        else if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
+        {
+            // Only close if the socket isn't already in the closed or closing state
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+            event_loop_unregister(socket_io_instance);
+#endif
+            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            close(socket_io_instance->socket);
+            socket_io_instance->socket = INVALID_SOCKET;
+            socket_io_instance->io_state = IO_STATE_CLOSED;
+        }
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int send_or_queue(SOCKET_IO_INSTANCE* socket_io_instance, struct iovec* iov, size_t iov_count, bool copy_bytes, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    if (first_pending_io != NULL)
+    {
+        if (add_pending_io(socket_io_instance, iov, iov_count, copy_bytes, on_send_complete, callback_context) != 0)
+        {
+            LogError("Failure: add_pending_io failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        ssize_t send_result = send_iov(socket_io_instance->socket, iov, iov_count);
+        if ((send_result < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
+            result = __FAILURE__;
+        }
+        else if (consume_iov(&iov, &iov_count, (send_result < 0) ? 0 : (size_t)send_result))
+        {
+            if (on_send_complete != NULL)
+            {
+                on_send_complete(callback_context, IO_SEND_OK);
+            }
+
+            result = 0;
+        }
+        /* send says "come back later" with EAGAIN or only took part of the data - likely the socket buffer cannot accept more data, queue the rest */
+        else if (add_pending_io(socket_io_instance, iov, iov_count, copy_bytes, on_send_complete, callback_context) != 0)
+        {
+            LogError("Failure: add_pending_io failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+    if (result == 0)
+    {
+        event_loop_update_write_interest(socket_io_instance);
+    }
+#endif
+
+    return result;
+}
+
+int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct iovec iov;
+            iov.iov_base = (void*)buffer;
+            iov.iov_len = size;
+
+            /* the caller may reuse buffer as soon as this returns, so anything left unsent is copied */
+            result = send_or_queue(socket_io_instance, &iov, 1, true, on_send_complete, callback_context);
+        }
+    }
+
+    return result;
+}
+
+int socketio_send_vectored(CONCRETE_IO_HANDLE socket_io, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct iovec stack_iov[SEND_VECTORED_STACK_SEGMENTS];
+            struct iovec* iov;
+
+            if (buffer_count <= SEND_VECTORED_STACK_SEGMENTS)
+            {
+                iov = stack_iov;
+            }
+            else
+            {
+                iov = (struct iovec*)malloc(buffer_count * sizeof(struct iovec));
+            }
+
+            if (iov == NULL)
+            {
+                LogError("Failure: unable to allocate the send segments.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t total_size = 0;
+                size_t i;
+
+                for (i = 0; i < buffer_count; i++)
+                {
+                    iov[i].iov_base = (void*)buffers[i].buffer;
+                    iov[i].iov_len = buffers[i].size;
+                    total_size += buffers[i].size;
+                }
+
+                if (total_size == 0)
+                {
+                    LogError("Invalid argument: all buffers are empty");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* anything left unsent keeps referencing the caller's buffers until on_send_complete */
+                    result = send_or_queue(socket_io_instance, iov, buffer_count, false, on_send_complete, callback_context);
+                }
+
+                if (iov != stack_iov)
+                {
+                    free(iov);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void send_pending_ios(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    while (first_pending_io != NULL)
+    {
+        PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+        if (pending_socket_io == NULL)
+        {
+            indicate_error(socket_io_instance);
+            LogError("Failure: retrieving socket from list");
+            break;
+        }
+
+        ssize_t send_result = send_iov(socket_io_instance->socket, pending_socket_io->iov, pending_socket_io->iov_count);
+        if (send_result < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
+            {
+                /*do nothing until next dowork */
+                break;
+            }
+            else
+            {
+                LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
+
+                /* a vectored send references the caller's buffers, so the caller has to learn they are released */
+                if (pending_socket_io->on_send_complete != NULL)
+                {
+                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_ERROR);
+                }
+
+                free(pending_socket_io);
+                (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+
+                indicate_error(socket_io_instance);
+            }
+        }
+        else if (!consume_iov(&pending_socket_io->iov, &pending_socket_io->iov_count, (size_t)send_result))
+        {
+            /* simply wait until next dowork */
+            break;
+        }
+        else
+        {
+            if (pending_socket_io->on_send_complete != NULL)
+            {
+                pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
+            }
+
+            free(pending_socket_io);
+            if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
+            {
+                indicate_error(socket_io_instance);
+                LogError("Failure: unable to remove socket from list");
+            }
+        }
+
+        first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    }
+}
+
+/* Doubles the receive buffer, up to max_recv_bytes_size, once reads have filled it RECEIVE_BUFFER_GROWTH_THRESHOLD times in a row */
+static void adapt_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance, size_t received)
 {
-    int result = 0;
-
-    if (socket_io == NULL)
+    if (received < socket_io_instance->recv_bytes_size)
     {
-        result = __FAILURE__;
+        socket_io_instance->full_receive_count = 0;
     }
-    else
+    else if (++socket_io_instance->full_receive_count >= RECEIVE_BUFFER_GROWTH_THRESHOLD &&
+        socket_io_instance->recv_bytes_size < socket_io_instance->max_recv_bytes_size)
     {
-        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
-        {
-            // Only close if the socket isn't already in the closed or closing state
-            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
-            close(socket_io_instance->socket);
-            socket_io_instance->socket = INVALID_SOCKET;
-            socket_io_instance->io_state = IO_STATE_CLOSED;
-        }
+        size_t new_size = (socket_io_instance->recv_bytes_size > socket_io_instance->max_recv_bytes_size / 2) ?
+            socket_io_instance->max_recv_bytes_size : socket_io_instance->recv_bytes_size * 2;
+        unsigned char* new_recv_bytes = (unsigned char*)realloc(socket_io_instance->recv_bytes, new_size);
 
-        if (on_io_close_complete != NULL)
+        /* the current buffer keeps working if it cannot grow */
+        if (new_recv_bytes != NULL)
         {
-            on_io_close_complete(callback_context);
+            socket_io_instance->recv_bytes = new_recv_bytes;
+            socket_io_instance->recv_bytes_size = new_size;
         }
 
-        result = 0;
+        socket_io_instance->full_receive_count = 0;
     }
-
-    return result;
 }
 
-int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static void receive_bytes(SOCKET_IO_INSTANCE* socket_io_instance)
 {
-    int result;
-
-    if ((socket_io == NULL) ||
-        (buffer == NULL) ||
-        (size == 0))
-    {
-        /* Invalid arguments */
-        LogError("Invalid argument: send given invalid parameter");
-        result = __FAILURE__;
-    }
-    else
+    if (socket_io_instance->io_state == IO_STATE_OPEN)
     {
-        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if (socket_io_instance->io_state != IO_STATE_OPEN)
-        {
-            LogError("Failure: socket state is not opened.");
-            result = __FAILURE__;
-        }
-        else
+        ssize_t received = 0;
+        bool has_received = false;
+        do
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
+            received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, socket_io_instance->recv_bytes_size, 0);
+            if (received > 0)
             {
-                if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Failure: add_pending_io failed.");
-                    result = __FAILURE__;
-                }
-                else
+                has_received = true;
+                if (socket_io_instance->on_bytes_received != NULL)
                 {
-                    result = 0;
+                    /* Explicitly ignoring here the result of the callback */
+                    (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
                 }
+
+                adapt_receive_buffer(socket_io_instance, (size_t)received);
             }
-            else
+            else if (received == 0)
+            {
+                // Do not log error here due to this is probably the socket being closed on the other end
+                indicate_error(socket_io_instance);
+            }
+            else if (received < 0 && errno != EAGAIN)
             {
-                signal(SIGPIPE, SIG_IGN);
+                LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
+                indicate_error(socket_io_instance);
+            }
 
-                ssize_t send_result = send(socket_io_instance->socket, buffer, size, 0);
-                if ((send_result < 0) || ((size_t)send_result != size))
-                {
-                    if (send_result == INVALID_SOCKET)
-                    {
-                        if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
-                        {
-                            /*do nothing*/
-                            result = 0;
-                        }
-                        else
-                        {
-                            LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
-                            result = __FAILURE__;
-                        }
-                    }
-                    else
-                    {
-                        /* queue data */
-                        if (add_pending_io(socket_io_instance, buffer + send_result, size - send_result, on_send_complete, callback_context) != 0)
-                        {
-                            LogError("Failure: add_pending_io failed.");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            result = 0;
-                        }
-                    }
-                }
-                else
-                {
-                    if (on_send_complete != NULL)
-                    {
-                        on_send_complete(callback_context, IO_SEND_OK);
-                    }
+        } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
 
-                    result = 0;
-                }
-            }
+#ifdef TCP_QUICKACK
+        if (has_received && socket_io_instance->io_state == IO_STATE_OPEN && socket_io_instance->socket_options[SOCKET_OPTION_TCP_QUICKACK] > 0)
+        {
+            (void)set_socket_option(socket_io_instance->socket, SOCKET_OPTION_TCP_QUICKACK, socket_io_instance->socket_options[SOCKET_OPTION_TCP_QUICKACK]);
         }
+#else
+        (void)has_received;
+#endif
     }
-
-    return result;
 }
 
 void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
@@ -914,101 +1987,123 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
+
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
         {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io == NULL)
-            {
-                indicate_error(socket_io_instance);
-                LogError("Failure: retrieving socket from list");
-                break;
-            }
+            /* an instance joins the event loop once open, until then its lookup and connection attempts are polled here */
+            continue_opening(socket_io_instance);
+        }
+        /* instances in the event loop are only serviced by socketio_dowork_all, when their socket is ready */
+        else if (!socket_io_instance->in_event_loop)
+        {
+            send_pending_ios(socket_io_instance);
+            receive_bytes(socket_io_instance);
+        }
+    }
+}
 
-            signal(SIGPIPE, SIG_IGN);
+int socketio_dowork_all(unsigned int timeout_ms)
+{
+    int result;
 
-            ssize_t send_result = send(socket_io_instance->socket, pending_socket_io->bytes, pending_socket_io->size, 0);
-            if ((send_result < 0) || ((size_t)send_result != pending_socket_io->size))
-            {
-                if (send_result == INVALID_SOCKET)
-                {
-                    if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
-                    {
-                        /*do nothing until next dowork */
-                        break;
-                    }
-                    else
-                    {
-                        free(pending_socket_io->bytes);
-                        free(pending_socket_io);
-                        (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+    if (event_loop_dispatch_events != NULL)
+    {
+        LogError("Failure: socketio_dowork_all cannot be called from a socketio callback.");
+        result = __FAILURE__;
+    }
+    else if (event_loop_fd == INVALID_SOCKET && event_loop_opening_instances == NULL)
+    {
+        /* no instance is registered, nothing to do */
+        result = 0;
+    }
+    else
+    {
+        struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+        int ready_count;
+        /* an opening instance has nothing to wait for in the event loop yet, it is polled */
+        int wait_ms = (event_loop_opening_instances != NULL && timeout_ms > EVENT_LOOP_OPENING_POLL_MS) ? EVENT_LOOP_OPENING_POLL_MS : (int)timeout_ms;
 
-                        LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
-                        indicate_error(socket_io_instance);
-                    }
-                }
-                else
-                {
-                    /* simply wait until next dowork */
-                    (void)memmove(pending_socket_io->bytes, pending_socket_io->bytes + send_result, pending_socket_io->size - send_result);
-                    pending_socket_io->size -= send_result;
-                    break;
-                }
+        do
+        {
+            if (event_loop_fd == INVALID_SOCKET)
+            {
+                ready_count = poll(NULL, 0, wait_ms);
             }
             else
             {
-                if (pending_socket_io->on_send_complete != NULL)
-                {
-                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
-                }
-
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-                {
-                    indicate_error(socket_io_instance);
-                    LogError("Failure: unable to remove socket from list");
-                }
+                ready_count = epoll_wait(event_loop_fd, events, EVENT_LOOP_MAX_EVENTS, wait_ms);
             }
+        } while (ready_count < 0 && errno == EINTR);
 
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+        if (ready_count < 0)
+        {
+            LogError("Failure: epoll_wait failed. errno=%d (%s).", errno, strerror(errno));
+            result = __FAILURE__;
         }
-
-        if (socket_io_instance->io_state == IO_STATE_OPEN)
+        else
         {
-            ssize_t received = 0;
-            do
+            event_loop_dispatch_events = events;
+            event_loop_dispatch_count = ready_count;
+
+            for (event_loop_dispatch_index = 0; event_loop_dispatch_index < ready_count; event_loop_dispatch_index++)
             {
-                received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, RECEIVE_BYTES_VALUE, 0);
-                if (received > 0)
+                SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)events[event_loop_dispatch_index].data.ptr;
+                uint32_t ready_events = events[event_loop_dispatch_index].events;
+
+                if (socket_io_instance != NULL)
                 {
-                    if (socket_io_instance->on_bytes_received != NULL)
+                    if ((ready_events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0)
                     {
-                        /* Explicitly ignoring here the result of the callback */
-                        (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
+                        send_pending_ios(socket_io_instance);
+                    }
+
+                    /* a callback may have closed or destroyed the instance, in which case its event has been cleared */
+                    if (events[event_loop_dispatch_index].data.ptr != NULL &&
+                        (ready_events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) != 0)
+                    {
+                        receive_bytes(socket_io_instance);
+                    }
+
+                    if (events[event_loop_dispatch_index].data.ptr != NULL)
+                    {
+                        if (socket_io_instance->io_state != IO_STATE_OPEN)
+                        {
+                            /* stop polling a failed socket, it would be reported ready on every call until closed */
+                            event_loop_unregister(socket_io_instance);
+                        }
+                        else
+                        {
+                            event_loop_update_write_interest(socket_io_instance);
+                        }
                     }
                 }
-                else if (received == 0)
-                {
-                    // Do not log error here due to this is probably the socket being closed on the other end
-                    indicate_error(socket_io_instance);
-                }
-                else if (received < 0 && errno != EAGAIN)
-                {
-                    LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
-                    indicate_error(socket_io_instance);
-                }
+            }
 
-            } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
+            /* an instance leaves the list when its open completes, the callback may open, close or destroy others */
+            event_loop_opening_cursor = event_loop_opening_instances;
+            while (event_loop_opening_cursor != NULL)
+            {
+                SOCKET_IO_INSTANCE* socket_io_instance = event_loop_opening_cursor;
+                event_loop_opening_cursor = socket_io_instance->next_opening_instance;
+                continue_opening(socket_io_instance);
+            }
+
+            event_loop_dispatch_events = NULL;
+            event_loop_dispatch_index = 0;
+            event_loop_dispatch_count = 0;
+            result = 0;
         }
     }
-}
-
-// Edison is missing this from netinet/tcp.h, but this code still works if we manually define it.
-#ifndef SOL_TCP
-#define SOL_TCP 6
+#else
+    AZURE_UNREFERENCED_PARAMETER(timeout_ms);
+    LogError("Failure: the socketio event loop is not supported on this platform.");
+    result = __FAILURE__;
 #endif
 
+    return result;
+}
+
 #ifndef __APPLE__
 static void strtoup(char* str)
 {
@@ -1054,40 +2149,96 @@ static int socketio_setaddresstype_option(SOCKET_IO_INSTANCE* socket_io_instance
     return result;
 }
 
-int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
+static int socketio_setreceivebuffersize_option(SOCKET_IO_INSTANCE* socket_io_instance, size_t max_recv_bytes_size)
 {
     int result;
 
-    if (socket_io == NULL ||
-        optionName == NULL ||
-        value == NULL)
+    if (max_recv_bytes_size == 0)
     {
+        LogError("The receive buffer size must be greater than 0");
         result = __FAILURE__;
     }
     else
     {
-        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->recv_bytes_size > max_recv_bytes_size)
+        {
+            /* shrinking cannot fail to leave a usable buffer, the larger block is kept if realloc fails */
+            unsigned char* new_recv_bytes = (unsigned char*)realloc(socket_io_instance->recv_bytes, max_recv_bytes_size);
+            if (new_recv_bytes != NULL)
+            {
+                socket_io_instance->recv_bytes = new_recv_bytes;
+            }
+            socket_io_instance->recv_bytes_size = max_recv_bytes_size;
+        }
+
+        socket_io_instance->max_recv_bytes_size = max_recv_bytes_size;
+        socket_io_instance->full_receive_count = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Remembers a socket option for the sockets created by socketio_open and gives it to the sockets that already exist */
+static int socketio_setsocket_option(SOCKET_IO_INSTANCE* socket_io_instance, SOCKET_OPTION socket_option, int value)
+{
+    int result;
 
-        if (strcmp(optionName, "tcp_keepalive") == 0)
+#ifndef TCP_QUICKACK
+    if (socket_option == SOCKET_OPTION_TCP_QUICKACK)
+    {
+        LogError("option %s not supported.", get_socket_option_name(socket_option));
+        result = __FAILURE__;
+    }
+    else
+#endif
+    if (value < 0)
+    {
+        LogError("The value of option %s cannot be negative", get_socket_option_name(socket_option));
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+        if (socket_io_instance->socket != INVALID_SOCKET)
         {
-            result = setsockopt(socket_io_instance->socket, SOL_SOCKET, SO_KEEPALIVE, value, sizeof(int));
-            if (result == -1) result = errno;
+            result = set_socket_option(socket_io_instance->socket, socket_option, value);
         }
-        else if (strcmp(optionName, "tcp_keepalive_time") == 0)
+
+        for (i = 0; i < socket_io_instance->next_connect_attempt && result == 0; i++)
         {
-#ifdef __APPLE__
-            result = setsockopt(socket_io_instance->socket, IPPROTO_TCP, TCP_KEEPALIVE, value, sizeof(int));
-#else
-            result = setsockopt(socket_io_instance->socket, SOL_TCP, TCP_KEEPIDLE, value, sizeof(int));
-#endif
-            if (result == -1) result = errno;
+            if (socket_io_instance->connect_attempts[i].socket != INVALID_SOCKET)
+            {
+                result = set_socket_option(socket_io_instance->connect_attempts[i].socket, socket_option, value);
+            }
         }
-        else if (strcmp(optionName, "tcp_keepalive_interval") == 0)
+
+        if (result == 0)
         {
-            result = setsockopt(socket_io_instance->socket, SOL_TCP, TCP_KEEPINTVL, value, sizeof(int));
-            if (result == -1) result = errno;
+            socket_io_instance->socket_options[socket_option] = value;
         }
-        else if (strcmp(optionName, OPTION_NET_INT_MAC_ADDRESS) == 0)
+    }
+
+    return result;
+}
+
+int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
+{
+    int result;
+
+    if (socket_io == NULL ||
+        optionName == NULL ||
+        value == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+
+        if (strcmp(optionName, OPTION_NET_INT_MAC_ADDRESS) == 0)
         {
 #ifdef __APPLE__
             LogError("option not supported.");
@@ -1121,6 +2272,32 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
         {
             result = socketio_setaddresstype_option(socket_io_instance, (const char*)value);
         }
+        else if (strcmp(optionName, OPTION_SOCKETIO_USE_EVENT_LOOP) == 0)
+        {
+#ifdef SOCKETIO_EVENT_LOOP_SUPPORTED
+            if (socket_io_instance->io_state != IO_STATE_CLOSED)
+            {
+                LogError("The event loop option can only be changed when in state 'IO_STATE_CLOSED'.  Current state=%d", socket_io_instance->io_state);
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->use_event_loop = *(const bool*)value;
+                result = 0;
+            }
+#else
+            LogError("option not supported.");
+            result = __FAILURE__;
+#endif
+        }
+        else if (strcmp(optionName, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            result = socketio_setreceivebuffersize_option(socket_io_instance, *(const size_t*)value);
+        }
+        else if (get_socket_option(optionName) != SOCKET_OPTION_COUNT)
+        {
+            result = socketio_setsocket_option(socket_io_instance, get_socket_option(optionName), *(const int*)value);
+        }
         else
         {
             result = __FAILURE__;
@@ -1130,8 +2307,40 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
     return result;
 }
 
+int socketio_berkeley_get_socket(CONCRETE_IO_HANDLE socket_io)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: socket_io is NULL");
+        result = INVALID_SOCKET;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        result = (socket_io_instance->io_state == IO_STATE_OPEN) ? socket_io_instance->socket : INVALID_SOCKET;
+    }
+
+    return result;
+}
+
 const IO_INTERFACE_DESCRIPTION* socketio_get_interface_description(void)
 {
-    return &socket_io_interface_description;
+    const IO_INTERFACE_DESCRIPTION* result;
+
+#ifdef USE_IO_URING
+    /* io_uring moves the data when the kernel supports it, this implementation does otherwise */
+    if (socketio_uring_is_supported())
+    {
+        result = socketio_uring_get_interface_description();
+    }
+    else
+#endif
+    {
+        result = &socket_io_interface_description;
+    }
+
+    return result;
 }
 
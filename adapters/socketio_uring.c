@@ -0,0 +1,1181 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// syscall, MAP_POPULATE and MSG_NOSIGNAL are outside C99 and POSIX, this file only builds on Linux
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/socketio_uring.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "socketio_berkeley.h"
+
+#define INVALID_SOCKET                 -1
+
+#ifndef IOV_MAX
+#define IOV_MAX                 16
+#endif
+
+// submission queue entries of an instance ring: a sendmsg, a recv and a cancel are the most ever queued
+#define RING_SUBMISSION_ENTRIES        4
+// completion queue entries, a multishot recv may post many completions between two calls to socketio_uring_dowork
+#define RING_COMPLETION_ENTRIES        64
+
+// receive buffers registered with the kernel for each instance, the count must be a power of 2
+#ifndef RECEIVE_BUFFER_COUNT
+#define RECEIVE_BUFFER_COUNT           8
+#endif
+#ifndef RECEIVE_BUFFER_SIZE
+#define RECEIVE_BUFFER_SIZE            (16 * 1024)
+#endif
+
+#define RECEIVE_BUFFER_GROUP           0
+
+// number of segments socketio_uring_send_vectored handles without allocating
+#define SEND_VECTORED_STACK_SEGMENTS    8
+
+/* user_data of the requests submitted to an instance ring */
+#define REQUEST_SEND                   1
+#define REQUEST_RECEIVE                2
+#define REQUEST_CANCEL                 3
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_CLOSED,
+    IO_STATE_OPENING,
+    IO_STATE_OPEN,
+    IO_STATE_CLOSING,
+    IO_STATE_ERROR
+} IO_STATE;
+
+typedef enum URING_SUPPORT_TAG
+{
+    URING_SUPPORT_UNKNOWN,
+    URING_SUPPORT_AVAILABLE,
+    URING_SUPPORT_UNAVAILABLE
+} URING_SUPPORT;
+
+typedef struct PENDING_SOCKET_IO_TAG
+{
+    /* the segments left to send, they point into bytes when the data was copied */
+    struct iovec* iov;
+    size_t iov_count;
+    unsigned char* bytes;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} PENDING_SOCKET_IO;
+
+/* the rings shared with the kernel, see io_uring_setup(2) */
+typedef struct URING_TAG
+{
+    int fd;
+    void* rings;
+    size_t rings_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_mask;
+    unsigned int* sq_array;
+    unsigned int sq_local_tail;
+    unsigned int sq_to_submit;
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int* cq_mask;
+    struct io_uring_cqe* cqes;
+    /* receive buffers and the ring through which they are given to the kernel */
+    void* buffer_memory;
+    size_t buffer_memory_size;
+    struct io_uring_buf_ring* buffer_ring;
+    unsigned char* buffers;
+    uint16_t buffer_ring_tail;
+} URING;
+
+typedef struct SOCKET_IO_URING_INSTANCE_TAG
+{
+    /* socketio_berkeley instance that connects, keeps the options and closes the socket */
+    CONCRETE_IO_HANDLE socket_io;
+    int socket;
+    IO_STATE io_state;
+    /* false when the ring could not be set up, socketio_berkeley then moves the data too */
+    bool use_ring;
+    /* one ring per instance, each instance is driven by its own socketio_uring_dowork, on whichever thread its owner calls it from,
+       so a shared ring would need a lock around both queues and would run the callbacks of an instance from the dowork of another */
+    URING ring;
+    bool is_send_in_flight;
+    bool is_receive_in_flight;
+    bool is_cancel_in_flight;
+    /* cleared when the kernel rejects IORING_RECV_MULTISHOT, a single shot recv is then submitted again after each completion */
+    bool use_multishot_receive;
+    /* the message of the sendmsg in flight, the kernel reads it until the send completes */
+    struct msghdr send_message;
+    struct iovec send_iov[IOV_MAX];
+    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_ERROR on_io_error;
+    void* on_bytes_received_context;
+    void* on_io_error_context;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+} SOCKET_IO_URING_INSTANCE;
+
+static URING_SUPPORT uring_support = URING_SUPPORT_UNKNOWN;
+
+static OPTIONHANDLER_HANDLE socketio_uring_retrieveoptions(CONCRETE_IO_HANDLE handle);
+
+static const IO_INTERFACE_DESCRIPTION socket_io_uring_interface_description =
+{
+    socketio_uring_retrieveoptions,
+    socketio_uring_create,
+    socketio_uring_destroy,
+    socketio_uring_open,
+    socketio_uring_close,
+    socketio_uring_send,
+    socketio_uring_dowork,
+    socketio_uring_setoption,
+    socketio_uring_send_vectored
+};
+
+static int io_uring_setup(unsigned int entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int io_uring_register(int fd, unsigned int opcode, void* arg, unsigned int nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static bool is_operation_supported(const struct io_uring_probe* probe, unsigned int operation)
+{
+    return (operation <= probe->last_op) && ((probe->ops[operation].flags & IO_URING_OP_SUPPORTED) != 0);
+}
+
+static void destroy_ring(URING* ring)
+{
+    if (ring->buffer_memory != NULL)
+    {
+        (void)munmap(ring->buffer_memory, ring->buffer_memory_size);
+    }
+    if (ring->sqes != NULL)
+    {
+        (void)munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->rings != NULL)
+    {
+        (void)munmap(ring->rings, ring->rings_size);
+    }
+    if (ring->fd >= 0)
+    {
+        (void)close(ring->fd);
+    }
+
+    (void)memset(ring, 0, sizeof(URING));
+    ring->fd = -1;
+}
+
+/* Gives a receive buffer back to the kernel */
+static void provide_receive_buffer(URING* ring, uint16_t buffer_id)
+{
+    struct io_uring_buf* buffer = &ring->buffer_ring->bufs[ring->buffer_ring_tail & (RECEIVE_BUFFER_COUNT - 1)];
+
+    buffer->addr = (uint64_t)(uintptr_t)(ring->buffers + ((size_t)buffer_id * RECEIVE_BUFFER_SIZE));
+    buffer->len = RECEIVE_BUFFER_SIZE;
+    buffer->bid = buffer_id;
+    ring->buffer_ring_tail++;
+    __atomic_store_n(&ring->buffer_ring->tail, ring->buffer_ring_tail, __ATOMIC_RELEASE);
+}
+
+/* Creates a ring with a single mapping for both queues, see io_uring_setup(2), and registers the receive buffers */
+static int create_ring(URING* ring)
+{
+    int result;
+    struct io_uring_params params;
+
+    (void)memset(ring, 0, sizeof(URING));
+    (void)memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = RING_COMPLETION_ENTRIES;
+
+    if ((ring->fd = io_uring_setup(RING_SUBMISSION_ENTRIES, &params)) < 0)
+    {
+        LogError("Failure: io_uring_setup failed. errno=%d (%s).", errno, strerror(errno));
+        ring->fd = -1;
+        result = __FAILURE__;
+    }
+    else if ((params.features & (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP)) != (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP))
+    {
+        LogError("Failure: the kernel io_uring lacks the single mapping or the completion backlog.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t sq_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+        size_t cq_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+
+        ring->rings_size = (sq_size > cq_size) ? sq_size : cq_size;
+        ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        ring->buffer_memory_size = (RECEIVE_BUFFER_COUNT * sizeof(struct io_uring_buf)) + (RECEIVE_BUFFER_COUNT * RECEIVE_BUFFER_SIZE);
+
+        if ((ring->rings = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING)) == MAP_FAILED)
+        {
+            LogError("Failure: unable to map the io_uring queues. errno=%d (%s).", errno, strerror(errno));
+            ring->rings = NULL;
+            result = __FAILURE__;
+        }
+        else if ((ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES)) == MAP_FAILED)
+        {
+            LogError("Failure: unable to map the io_uring submission entries. errno=%d (%s).", errno, strerror(errno));
+            ring->sqes = NULL;
+            result = __FAILURE__;
+        }
+        /* the buffer ring has to be page aligned, so it and the buffers are mapped rather than allocated */
+        else if ((ring->buffer_memory = mmap(NULL, ring->buffer_memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+        {
+            LogError("Failure: unable to map the receive buffers. errno=%d (%s).", errno, strerror(errno));
+            ring->buffer_memory = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct io_uring_buf_reg buffer_registration;
+            unsigned char* rings = (unsigned char*)ring->rings;
+
+            ring->sq_head = (unsigned int*)(rings + params.sq_off.head);
+            ring->sq_tail = (unsigned int*)(rings + params.sq_off.tail);
+            ring->sq_mask = (unsigned int*)(rings + params.sq_off.ring_mask);
+            ring->sq_array = (unsigned int*)(rings + params.sq_off.array);
+            ring->sq_local_tail = *ring->sq_tail;
+            ring->cq_head = (unsigned int*)(rings + params.cq_off.head);
+            ring->cq_tail = (unsigned int*)(rings + params.cq_off.tail);
+            ring->cq_mask = (unsigned int*)(rings + params.cq_off.ring_mask);
+            ring->cqes = (struct io_uring_cqe*)(rings + params.cq_off.cqes);
+
+            ring->buffer_ring = (struct io_uring_buf_ring*)ring->buffer_memory;
+            ring->buffers = (unsigned char*)ring->buffer_memory + (RECEIVE_BUFFER_COUNT * sizeof(struct io_uring_buf));
+
+            (void)memset(&buffer_registration, 0, sizeof(buffer_registration));
+            buffer_registration.ring_addr = (uint64_t)(uintptr_t)ring->buffer_ring;
+            buffer_registration.ring_entries = RECEIVE_BUFFER_COUNT;
+            buffer_registration.bgid = RECEIVE_BUFFER_GROUP;
+
+            if (io_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &buffer_registration, 1) != 0)
+            {
+                LogError("Failure: unable to register the receive buffers. errno=%d (%s).", errno, strerror(errno));
+                result = __FAILURE__;
+            }
+            else
+            {
+                uint16_t i;
+                for (i = 0; i < RECEIVE_BUFFER_COUNT; i++)
+                {
+                    provide_receive_buffer(ring, i);
+                }
+
+                result = 0;
+            }
+        }
+    }
+
+    if (result != 0)
+    {
+        destroy_ring(ring);
+    }
+
+    return result;
+}
+
+/* Returns a cleared submission entry, or NULL when the submission queue is full */
+static struct io_uring_sqe* get_submission_entry(URING* ring, uint64_t user_data)
+{
+    struct io_uring_sqe* result;
+    unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (ring->sq_local_tail - head >= RING_SUBMISSION_ENTRIES)
+    {
+        LogError("Failure: the io_uring submission queue is full.");
+        result = NULL;
+    }
+    else
+    {
+        unsigned int index = ring->sq_local_tail & *ring->sq_mask;
+
+        result = &ring->sqes[index];
+        (void)memset(result, 0, sizeof(struct io_uring_sqe));
+        result->user_data = user_data;
+        ring->sq_array[index] = index;
+        ring->sq_local_tail++;
+        ring->sq_to_submit++;
+        __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    }
+
+    return result;
+}
+
+/* Hands the queued submission entries to the kernel with a single io_uring_enter */
+static int submit_requests(URING* ring, unsigned int min_complete)
+{
+    int result;
+    int enter_result;
+
+    do
+    {
+        enter_result = io_uring_enter(ring->fd, ring->sq_to_submit, min_complete, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0);
+    } while (enter_result < 0 && errno == EINTR);
+
+    if (enter_result < 0)
+    {
+        LogError("Failure: io_uring_enter failed. errno=%d (%s).", errno, strerror(errno));
+        result = __FAILURE__;
+    }
+    else
+    {
+        ring->sq_to_submit -= (unsigned int)enter_result;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void indicate_error(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    socket_io_instance->io_state = IO_STATE_ERROR;
+    if (socket_io_instance->on_io_error != NULL)
+    {
+        socket_io_instance->on_io_error(socket_io_instance->on_io_error_context);
+    }
+}
+
+/* the pending IO, its segments and, when copy_bytes is true, a copy of the data live in a single allocation */
+static int add_pending_io(SOCKET_IO_URING_INSTANCE* socket_io_instance, const struct iovec* iov, size_t iov_count, bool copy_bytes, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    size_t bytes_size = 0;
+    size_t i;
+    PENDING_SOCKET_IO* pending_socket_io;
+
+    if (copy_bytes)
+    {
+        for (i = 0; i < iov_count; i++)
+        {
+            bytes_size += iov[i].iov_len;
+        }
+
+        pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO) + sizeof(struct iovec) + bytes_size);
+    }
+    else
+    {
+        pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO) + (iov_count * sizeof(struct iovec)));
+    }
+
+    if (pending_socket_io == NULL)
+    {
+        LogError("Allocation Failure: Unable to allocate pending list.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        pending_socket_io->iov = (struct iovec*)(pending_socket_io + 1);
+        pending_socket_io->on_send_complete = on_send_complete;
+        pending_socket_io->callback_context = callback_context;
+
+        if (copy_bytes)
+        {
+            size_t offset = 0;
+
+            pending_socket_io->bytes = (unsigned char*)(pending_socket_io->iov + 1);
+            for (i = 0; i < iov_count; i++)
+            {
+                (void)memcpy(pending_socket_io->bytes + offset, iov[i].iov_base, iov[i].iov_len);
+                offset += iov[i].iov_len;
+            }
+
+            pending_socket_io->iov[0].iov_base = pending_socket_io->bytes;
+            pending_socket_io->iov[0].iov_len = bytes_size;
+            pending_socket_io->iov_count = 1;
+        }
+        else
+        {
+            pending_socket_io->bytes = NULL;
+            (void)memcpy(pending_socket_io->iov, iov, iov_count * sizeof(struct iovec));
+            pending_socket_io->iov_count = iov_count;
+        }
+
+        if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
+        {
+            LogError("Failure: Unable to add socket to pending list.");
+            free(pending_socket_io);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* Drops every pending IO, the data of a vectored send belongs to the caller who has to learn it is no longer referenced */
+static void clear_pending_ios(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    while (first_pending_io != NULL)
+    {
+        PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+
+        (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+        if (pending_socket_io != NULL)
+        {
+            if ((pending_socket_io->bytes == NULL) && (pending_socket_io->on_send_complete != NULL))
+            {
+                pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_CANCELLED);
+            }
+
+            free(pending_socket_io);
+        }
+
+        first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    }
+}
+
+/* Gathers the segments of the pending IOs, in order and up to IOV_MAX, in a single sendmsg */
+static int submit_send(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    int result;
+    LIST_ITEM_HANDLE pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    size_t iov_count = 0;
+
+    while (pending_io != NULL && iov_count < IOV_MAX)
+    {
+        PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(pending_io);
+        size_t i;
+
+        for (i = 0; i < pending_socket_io->iov_count && iov_count < IOV_MAX; i++)
+        {
+            socket_io_instance->send_iov[iov_count++] = pending_socket_io->iov[i];
+        }
+
+        pending_io = singlylinkedlist_get_next_item(pending_io);
+    }
+
+    if (iov_count == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        struct io_uring_sqe* sqe = get_submission_entry(&socket_io_instance->ring, REQUEST_SEND);
+        if (sqe == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memset(&socket_io_instance->send_message, 0, sizeof(socket_io_instance->send_message));
+            socket_io_instance->send_message.msg_iov = socket_io_instance->send_iov;
+            socket_io_instance->send_message.msg_iovlen = iov_count;
+
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = socket_io_instance->socket;
+            sqe->addr = (uint64_t)(uintptr_t)&socket_io_instance->send_message;
+            sqe->len = 1;
+            /* the connection may be reset by the peer, which must not raise SIGPIPE */
+            sqe->msg_flags = MSG_NOSIGNAL;
+
+            socket_io_instance->is_send_in_flight = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int submit_receive(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    int result;
+    struct io_uring_sqe* sqe = get_submission_entry(&socket_io_instance->ring, REQUEST_RECEIVE);
+
+    if (sqe == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the kernel picks a registered buffer for each completion, so no buffer is tied up while nothing is received */
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = socket_io_instance->socket;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECEIVE_BUFFER_GROUP;
+        if (socket_io_instance->use_multishot_receive)
+        {
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+        }
+
+        socket_io_instance->is_receive_in_flight = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Completes the pending IOs covered by the bytes a sendmsg sent and trims the one it sent in part */
+static void on_send_completed(SOCKET_IO_URING_INSTANCE* socket_io_instance, int send_result)
+{
+    socket_io_instance->is_send_in_flight = false;
+
+    if (send_result < 0)
+    {
+        if (socket_io_instance->io_state == IO_STATE_OPEN)
+        {
+            LogError("Failure: sending Socket information. errno=%d (%s).", -send_result, strerror(-send_result));
+            indicate_error(socket_io_instance);
+        }
+    }
+    else
+    {
+        size_t sent = (size_t)send_result;
+        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+
+        while (first_pending_io != NULL && socket_io_instance->io_state == IO_STATE_OPEN)
+        {
+            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+            size_t remaining = 0;
+            size_t i;
+
+            for (i = 0; i < pending_socket_io->iov_count; i++)
+            {
+                remaining += pending_socket_io->iov[i].iov_len;
+            }
+
+            if (sent < remaining)
+            {
+                while (sent > 0)
+                {
+                    if (sent >= pending_socket_io->iov->iov_len)
+                    {
+                        sent -= pending_socket_io->iov->iov_len;
+                        pending_socket_io->iov++;
+                        pending_socket_io->iov_count--;
+                    }
+                    else
+                    {
+                        pending_socket_io->iov->iov_base = (unsigned char*)pending_socket_io->iov->iov_base + sent;
+                        pending_socket_io->iov->iov_len -= sent;
+                        sent = 0;
+                    }
+                }
+                break;
+            }
+            else
+            {
+                ON_SEND_COMPLETE on_send_complete = pending_socket_io->on_send_complete;
+                void* callback_context = pending_socket_io->callback_context;
+
+                sent -= remaining;
+                (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+                free(pending_socket_io);
+
+                /* the callback may close the instance, which is checked before the next pending IO */
+                if (on_send_complete != NULL)
+                {
+                    on_send_complete(callback_context, IO_SEND_OK);
+                }
+
+                first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+            }
+        }
+    }
+}
+
+static void on_receive_completed(SOCKET_IO_URING_INSTANCE* socket_io_instance, int receive_result, uint32_t flags)
+{
+    if ((flags & IORING_CQE_F_MORE) == 0)
+    {
+        socket_io_instance->is_receive_in_flight = false;
+    }
+
+    if (receive_result > 0)
+    {
+        uint16_t buffer_id = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+
+        if (socket_io_instance->io_state == IO_STATE_OPEN && socket_io_instance->on_bytes_received != NULL)
+        {
+            socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->ring.buffers + ((size_t)buffer_id * RECEIVE_BUFFER_SIZE), (size_t)receive_result);
+        }
+
+        /* a callback closing the instance has already released the buffers */
+        if (socket_io_instance->ring.fd >= 0)
+        {
+            provide_receive_buffer(&socket_io_instance->ring, buffer_id);
+        }
+    }
+    else if (socket_io_instance->io_state != IO_STATE_OPEN)
+    {
+        /* cancelled while closing */
+    }
+    else if (receive_result == 0)
+    {
+        // Do not log error here due to this is probably the socket being closed on the other end
+        indicate_error(socket_io_instance);
+    }
+    else if (receive_result == -EINVAL && socket_io_instance->use_multishot_receive)
+    {
+        LogInfo("The kernel does not support multishot recv, a recv is submitted after each completion.");
+        socket_io_instance->use_multishot_receive = false;
+    }
+    else if (receive_result != -ENOBUFS)
+    {
+        /* ENOBUFS only means every buffer was in use, the recv is submitted again by socketio_uring_dowork */
+        LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", -receive_result);
+        indicate_error(socket_io_instance);
+    }
+}
+
+/* Processes every completion the kernel has posted, without a system call */
+static void process_completions(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    URING* ring = &socket_io_instance->ring;
+    unsigned int head = *ring->cq_head;
+
+    while (ring->fd >= 0 && head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        struct io_uring_cqe cqe = ring->cqes[head & *ring->cq_mask];
+
+        /* the entry is copied and given back before any callback runs, a callback may close the instance */
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+        switch (cqe.user_data)
+        {
+        case REQUEST_SEND:
+            on_send_completed(socket_io_instance, cqe.res);
+            break;
+        case REQUEST_RECEIVE:
+            on_receive_completed(socket_io_instance, cqe.res, cqe.flags);
+            break;
+        default:
+            socket_io_instance->is_cancel_in_flight = false;
+            if (cqe.res == -EINVAL)
+            {
+                /* a kernel without IORING_ASYNC_CANCEL_ANY, shutting the socket down completes the requests instead */
+                (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            }
+            break;
+        }
+    }
+}
+
+/* Cancels the requests in flight and waits for the kernel to be done with the buffers they reference before releasing the ring */
+static void stop_ring(SOCKET_IO_URING_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->ring.fd >= 0)
+    {
+        if (socket_io_instance->is_send_in_flight || socket_io_instance->is_receive_in_flight)
+        {
+            struct io_uring_sqe* sqe = get_submission_entry(&socket_io_instance->ring, REQUEST_CANCEL);
+            if (sqe == NULL)
+            {
+                (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            }
+            else
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+                socket_io_instance->is_cancel_in_flight = true;
+            }
+
+            while (socket_io_instance->is_send_in_flight || socket_io_instance->is_receive_in_flight || socket_io_instance->is_cancel_in_flight)
+            {
+                if (submit_requests(&socket_io_instance->ring, 1) != 0)
+                {
+                    LogError("Failure: unable to wait for the cancelled requests.");
+                    break;
+                }
+
+                process_completions(socket_io_instance);
+            }
+        }
+
+        destroy_ring(&socket_io_instance->ring);
+    }
+
+    socket_io_instance->is_send_in_flight = false;
+    socket_io_instance->is_receive_in_flight = false;
+    socket_io_instance->is_cancel_in_flight = false;
+}
+
+static void on_underlying_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)context;
+    ON_IO_OPEN_COMPLETE on_io_open_complete = socket_io_instance->on_io_open_complete;
+
+    socket_io_instance->on_io_open_complete = NULL;
+    if (open_result != IO_OPEN_OK)
+    {
+        socket_io_instance->io_state = (open_result == IO_OPEN_CANCELLED) ? IO_STATE_CLOSED : IO_STATE_ERROR;
+    }
+    else
+    {
+        socket_io_instance->socket = socketio_berkeley_get_socket(socket_io_instance->socket_io);
+        socket_io_instance->use_multishot_receive = true;
+
+        /* a process out of locked memory or file descriptors keeps working, only without the ring */
+        if (create_ring(&socket_io_instance->ring) != 0)
+        {
+            LogInfo("Failure: unable to set up io_uring, socketio_berkeley moves the data of this connection.");
+            socket_io_instance->use_ring = false;
+        }
+        else
+        {
+            socket_io_instance->use_ring = true;
+        }
+
+        socket_io_instance->io_state = IO_STATE_OPEN;
+    }
+
+    if (on_io_open_complete != NULL)
+    {
+        on_io_open_complete(socket_io_instance->on_io_open_complete_context, open_result);
+    }
+}
+
+/* only called when socketio_berkeley moves the data */
+static void on_underlying_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)context;
+
+    if (socket_io_instance->on_bytes_received != NULL)
+    {
+        socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, buffer, size);
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    indicate_error((SOCKET_IO_URING_INSTANCE*)context);
+}
+
+bool socketio_uring_is_supported(void)
+{
+    /* probed once, concurrent first calls probe the same kernel and reach the same answer */
+    if (uring_support == URING_SUPPORT_UNKNOWN)
+    {
+        URING ring;
+        URING_SUPPORT support = URING_SUPPORT_UNAVAILABLE;
+
+        if (create_ring(&ring) == 0)
+        {
+            size_t probe_size = sizeof(struct io_uring_probe) + (256 * sizeof(struct io_uring_probe_op));
+            struct io_uring_probe* probe = (struct io_uring_probe*)malloc(probe_size);
+
+            if (probe == NULL)
+            {
+                LogError("Failure: unable to allocate the io_uring probe.");
+            }
+            else
+            {
+                (void)memset(probe, 0, probe_size);
+                if (io_uring_register(ring.fd, IORING_REGISTER_PROBE, probe, 256) != 0)
+                {
+                    LogInfo("io_uring cannot be probed, errno=%d.", errno);
+                }
+                else if (!is_operation_supported(probe, IORING_OP_SENDMSG) ||
+                    !is_operation_supported(probe, IORING_OP_RECV) ||
+                    !is_operation_supported(probe, IORING_OP_ASYNC_CANCEL))
+                {
+                    LogInfo("io_uring lacks the socket operations.");
+                }
+                else
+                {
+                    support = URING_SUPPORT_AVAILABLE;
+                }
+
+                free(probe);
+            }
+
+            destroy_ring(&ring);
+        }
+
+        if (support == URING_SUPPORT_UNAVAILABLE)
+        {
+            LogInfo("io_uring is not available, sockets are served by socketio_berkeley.");
+        }
+
+        uring_support = support;
+    }
+
+    return (uring_support == URING_SUPPORT_AVAILABLE);
+}
+
+CONCRETE_IO_HANDLE socketio_uring_create(void* io_create_parameters)
+{
+    SOCKET_IO_URING_INSTANCE* result;
+
+    if (io_create_parameters == NULL)
+    {
+        LogError("Invalid argument: io_create_parameters is NULL");
+        result = NULL;
+    }
+    else if ((result = (SOCKET_IO_URING_INSTANCE*)malloc(sizeof(SOCKET_IO_URING_INSTANCE))) == NULL)
+    {
+        LogError("Allocation Failure: SOCKET_IO_URING_INSTANCE");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SOCKET_IO_URING_INSTANCE));
+        result->ring.fd = -1;
+        result->socket = INVALID_SOCKET;
+        result->io_state = IO_STATE_CLOSED;
+
+        if ((result->pending_io_list = singlylinkedlist_create()) == NULL)
+        {
+            LogError("Failure: singlylinkedlist_create unable to create pending list.");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->socket_io = socketio_create(io_create_parameters)) == NULL)
+        {
+            LogError("Failure: socketio_create failed.");
+            singlylinkedlist_destroy(result->pending_io_list);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void socketio_uring_destroy(CONCRETE_IO_HANDLE socket_io)
+{
+    if (socket_io != NULL)
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+
+        socket_io_instance->io_state = IO_STATE_CLOSING;
+        stop_ring(socket_io_instance);
+        clear_pending_ios(socket_io_instance);
+
+        socketio_destroy(socket_io_instance->socket_io);
+        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
+        free(socket_io_instance);
+    }
+}
+
+int socketio_uring_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: SOCKET_IO_URING_INSTANCE is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+
+        if (socket_io_instance->io_state != IO_STATE_CLOSED)
+        {
+            LogError("Failure: socket state is not closed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_io_instance->on_bytes_received = on_bytes_received;
+            socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+            socket_io_instance->on_io_error = on_io_error;
+            socket_io_instance->on_io_error_context = on_io_error_context;
+            socket_io_instance->on_io_open_complete = on_io_open_complete;
+            socket_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+            socket_io_instance->io_state = IO_STATE_OPENING;
+
+            /* socketio_berkeley reports the outcome from socketio_uring_dowork, never from here */
+            if (socketio_open(socket_io_instance->socket_io, on_underlying_open_complete, socket_io_instance, on_underlying_bytes_received, socket_io_instance, on_underlying_io_error, socket_io_instance) != 0)
+            {
+                LogError("Failure: socketio_open failed.");
+                socket_io_instance->on_io_open_complete = NULL;
+                socket_io_instance->io_state = IO_STATE_CLOSED;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int socketio_uring_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+
+        if (socket_io_instance->io_state != IO_STATE_OPENING)
+        {
+            socket_io_instance->io_state = IO_STATE_CLOSING;
+        }
+
+        stop_ring(socket_io_instance);
+        clear_pending_ios(socket_io_instance);
+        socket_io_instance->socket = INVALID_SOCKET;
+
+        /* socketio_berkeley closes the socket, or cancels the open through on_underlying_open_complete */
+        (void)socketio_close(socket_io_instance->socket_io, NULL, NULL);
+        socket_io_instance->io_state = IO_STATE_CLOSED;
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int queue_send(SOCKET_IO_URING_INSTANCE* socket_io_instance, const struct iovec* iov, size_t iov_count, bool copy_bytes, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* the data waits for the next socketio_uring_dowork, which hands everything queued until then to a single sendmsg */
+    if (add_pending_io(socket_io_instance, iov, iov_count, copy_bytes, on_send_complete, callback_context) != 0)
+    {
+        LogError("Failure: add_pending_io failed.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int socketio_uring_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else if (!socket_io_instance->use_ring)
+        {
+            result = socketio_send(socket_io_instance->socket_io, buffer, size, on_send_complete, callback_context);
+        }
+        else
+        {
+            struct iovec iov;
+            iov.iov_base = (void*)buffer;
+            iov.iov_len = size;
+
+            /* the caller may reuse buffer as soon as this returns, so it is copied */
+            result = queue_send(socket_io_instance, &iov, 1, true, on_send_complete, callback_context);
+        }
+    }
+
+    return result;
+}
+
+int socketio_uring_send_vectored(CONCRETE_IO_HANDLE socket_io, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else if (!socket_io_instance->use_ring)
+        {
+            result = socketio_send_vectored(socket_io_instance->socket_io, buffers, buffer_count, on_send_complete, callback_context);
+        }
+        else
+        {
+            struct iovec stack_iov[SEND_VECTORED_STACK_SEGMENTS];
+            struct iovec* iov;
+
+            if (buffer_count <= SEND_VECTORED_STACK_SEGMENTS)
+            {
+                iov = stack_iov;
+            }
+            else
+            {
+                iov = (struct iovec*)malloc(buffer_count * sizeof(struct iovec));
+            }
+
+            if (iov == NULL)
+            {
+                LogError("Failure: unable to allocate the send segments.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t total_size = 0;
+                size_t i;
+
+                for (i = 0; i < buffer_count; i++)
+                {
+                    iov[i].iov_base = (void*)buffers[i].buffer;
+                    iov[i].iov_len = buffers[i].size;
+                    total_size += buffers[i].size;
+                }
+
+                if (total_size == 0)
+                {
+                    LogError("Invalid argument: all buffers are empty");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* the segments keep referencing the caller's buffers until on_send_complete */
+                    result = queue_send(socket_io_instance, iov, buffer_count, false, on_send_complete, callback_context);
+                }
+
+                if (iov != stack_iov)
+                {
+                    free(iov);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void socketio_uring_dowork(CONCRETE_IO_HANDLE socket_io)
+{
+    if (socket_io != NULL)
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+
+        if (socket_io_instance->io_state == IO_STATE_OPENING || (socket_io_instance->io_state == IO_STATE_OPEN && !socket_io_instance->use_ring))
+        {
+            socketio_dowork(socket_io_instance->socket_io);
+        }
+        else if (socket_io_instance->io_state == IO_STATE_OPEN)
+        {
+            /* the completions of every request since the last call are processed in one pass over the completion queue */
+            process_completions(socket_io_instance);
+
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
+            {
+                if ((!socket_io_instance->is_send_in_flight && submit_send(socket_io_instance) != 0) ||
+                    (!socket_io_instance->is_receive_in_flight && submit_receive(socket_io_instance) != 0) ||
+                    (socket_io_instance->ring.sq_to_submit > 0 && submit_requests(&socket_io_instance->ring, 0) != 0))
+                {
+                    LogError("Failure: unable to submit the socket requests.");
+                    indicate_error(socket_io_instance);
+                }
+            }
+        }
+    }
+}
+
+int socketio_uring_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
+{
+    int result;
+
+    if (socket_io == NULL ||
+        optionName == NULL ||
+        value == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else if (strcmp(optionName, OPTION_SOCKETIO_USE_EVENT_LOOP) == 0)
+    {
+        /* the event loop would receive the data the ring is waiting for */
+        LogError("option %s not supported.", optionName);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)socket_io;
+        result = socketio_setoption(socket_io_instance->socket_io, optionName, value);
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE socketio_uring_retrieveoptions(CONCRETE_IO_HANDLE handle)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (handle == NULL)
+    {
+        LogError("failed retrieving options (handle is NULL)");
+        result = NULL;
+    }
+    else
+    {
+        SOCKET_IO_URING_INSTANCE* socket_io_instance = (SOCKET_IO_URING_INSTANCE*)handle;
+        result = socketio_berkeley_retrieve_options(socket_io_instance->socket_io, socketio_uring_setoption);
+    }
+
+    return result;
+}
+
+const IO_INTERFACE_DESCRIPTION* socketio_uring_get_interface_description(void)
+{
+    return &socket_io_uring_interface_description;
+}
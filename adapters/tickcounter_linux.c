@@ -12,7 +12,7 @@
 
 typedef struct TICK_COUNTER_INSTANCE_TAG
 {
-    time_t init_time_value;
+    int64_t init_time_value;
     tickcounter_ms_t current_ms;
 } TICK_COUNTER_INSTANCE;
 
@@ -23,8 +23,8 @@ TICK_COUNTER_HANDLE tickcounter_create(void)
     {
         set_time_basis();
 
-        result->init_time_value = get_time_s();
-        if (result->init_time_value == INVALID_TIME_VALUE)
+        result->init_time_value = get_time_ms();
+        if (result->init_time_value == INVALID_TIME_VALUE_MS)
         {
             LogError("tickcounter failed: time return INVALID_TIME.");
             free(result);
@@ -57,15 +57,15 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
     }
     else
     {
-        time_t time_value = get_time_s();
-        if (time_value == INVALID_TIME_VALUE)
+        int64_t time_value = get_time_ms();
+        if (time_value == INVALID_TIME_VALUE_MS)
         {
             result = __FAILURE__;
         }
         else
         {
             TICK_COUNTER_INSTANCE* tick_counter_instance = (TICK_COUNTER_INSTANCE*)tick_counter;
-            tick_counter_instance->current_ms = (tickcounter_ms_t)(difftime(time_value, tick_counter_instance->init_time_value) * 1000);
+            tick_counter_instance->current_ms = (tickcounter_ms_t)(time_value - tick_counter_instance->init_time_value);
             *current_ms = tick_counter_instance->current_ms;
             result = 0;
         }
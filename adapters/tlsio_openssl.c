@@ -2,9 +2,11 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include "openssl/ssl.h"
 #include "openssl/err.h"
 #include "openssl/crypto.h"
+#include "openssl/sha.h"
 #include "openssl/opensslv.h"
 #include <stdio.h>
 #include <stdbool.h>
@@ -20,6 +22,7 @@
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/const_defines.h"
+#include "azure_c_shared_utility/refcount.h"
 
 typedef enum TLSIO_STATE_TAG
 {
@@ -51,6 +54,56 @@ static bool is_an_opening_state(TLSIO_STATE state)
 
 typedef int(*TLS_CERTIFICATE_VALIDATION_CALLBACK)(X509_STORE_CTX*, void*);
 
+/*application writes smaller than a full record are gathered up to this size before SSL_write*/
+#define TLSIO_OPENSSL_MAX_RECORD_PLAINTEXT SSL3_RT_MAX_PLAIN_LENGTH
+#define TLSIO_OPENSSL_INITIAL_PENDING_SEND_CAPACITY 4
+
+typedef struct TLSIO_OPENSSL_PENDING_SEND_TAG
+{
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} TLSIO_OPENSSL_PENDING_SEND;
+
+/*the sends carried by one record, the array is stored right after the structure*/
+typedef struct TLSIO_OPENSSL_FLUSHED_SENDS_TAG
+{
+    size_t pending_send_count;
+    TLSIO_OPENSSL_PENDING_SEND* pending_sends;
+} TLSIO_OPENSSL_FLUSHED_SENDS;
+
+/*contexts and sessions that are not in use are kept up to these limits*/
+#define TLSIO_OPENSSL_MAX_IDLE_CONTEXTS 16
+#define TLSIO_OPENSSL_MAX_SESSIONS_PER_CONTEXT 64
+
+typedef struct TLSIO_OPENSSL_SESSION_TAG
+{
+    char* hostname;
+    int port;
+    SSL_SESSION* ssl_session;
+    struct TLSIO_OPENSSL_SESSION_TAG* next;
+} TLSIO_OPENSSL_SESSION;
+
+/*an SSL_CTX shared by all the instances that have the same TLS configuration*/
+typedef struct TLSIO_OPENSSL_CONTEXT_TAG
+{
+    SSL_CTX* ssl_context;
+    /*atomic, orphaned contexts are released without any lock*/
+    COUNT_TYPE ref_count;
+    bool orphaned;
+    TLSIO_VERSION tls_version;
+    char* cipher_list;
+    char* certificate;
+    char* x509_certificate;
+    /*the cache only keeps a digest of the private key, the key itself lives in the SSL_CTX*/
+    bool has_x509_private_key;
+    unsigned char x509_private_key_digest[SHA256_DIGEST_LENGTH];
+    TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
+    void* tls_validation_callback_data;
+    TLSIO_OPENSSL_SESSION* sessions;
+    size_t session_count;
+    struct TLSIO_OPENSSL_CONTEXT_TAG* next;
+} TLSIO_OPENSSL_CONTEXT;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE underlying_io;
@@ -64,6 +117,9 @@ typedef struct TLS_IO_INSTANCE_TAG
     void* on_io_error_context;
     SSL* ssl;
     SSL_CTX* ssl_context;
+    TLSIO_OPENSSL_CONTEXT* shared_context;
+    char* hostname;
+    int port;
     BIO* in_bio;
     BIO* out_bio;
     TLSIO_STATE tlsio_state;
@@ -74,6 +130,15 @@ typedef struct TLS_IO_INSTANCE_TAG
     TLSIO_VERSION tls_version;
     TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
     void* tls_validation_callback_data;
+    /*out_bio is drained into this buffer, it is kept for the life of the instance*/
+    unsigned char* scratch_buffer;
+    size_t scratch_buffer_size;
+    /*application writes gathered into one TLS record, flushed when full or by tlsio_openssl_dowork*/
+    unsigned char* pending_plaintext;
+    size_t pending_plaintext_size;
+    TLSIO_OPENSSL_PENDING_SEND* pending_sends;
+    size_t pending_send_count;
+    size_t pending_send_capacity;
 } TLS_IO_INSTANCE;
 
 struct CRYPTO_dynlock_value
@@ -391,6 +456,11 @@ static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
 
 static LOCK_HANDLE * openssl_locks = NULL;
 
+/*the context cache only exists between tlsio_openssl_init and tlsio_openssl_deinit, without it every open builds its own SSL_CTX*/
+static LOCK_HANDLE context_cache_lock = NULL;
+static TLSIO_OPENSSL_CONTEXT* context_cache = NULL;
+static TLSIO_OPENSSL_CACHE_STATISTICS cache_statistics;
+
 
 static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const char* file, int line)
 {
@@ -621,39 +691,427 @@ static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLE
     }
     else
     {
-        unsigned char* bytes_to_send = malloc(pending);
-        if (bytes_to_send == NULL)
+        if (pending > tls_io_instance->scratch_buffer_size)
+        {
+            unsigned char* new_scratch_buffer = realloc(tls_io_instance->scratch_buffer, pending);
+            if (new_scratch_buffer == NULL)
+            {
+                LogError("Cannot allocate the scratch buffer.");
+            }
+            else
+            {
+                tls_io_instance->scratch_buffer = new_scratch_buffer;
+                tls_io_instance->scratch_buffer_size = pending;
+            }
+        }
+
+        if (pending > tls_io_instance->scratch_buffer_size)
+        {
+            result = __FAILURE__;
+        }
+        else if (BIO_read(tls_io_instance->out_bio, tls_io_instance->scratch_buffer, (int)pending) != (int)pending)
+        {
+            log_ERR_get_error("BIO_read not in pending state.");
+            result = __FAILURE__;
+        }
+        /*the underlying IO sends or copies the bytes before xio_send returns, so the scratch buffer can be reused right away*/
+        else if (xio_send(tls_io_instance->underlying_io, tls_io_instance->scratch_buffer, pending, on_send_complete, callback_context) != 0)
+        {
+            LogError("Error in xio_send.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void indicate_pending_sends_complete(TLSIO_OPENSSL_PENDING_SEND* pending_sends, size_t pending_send_count, IO_SEND_RESULT send_result)
+{
+    size_t i;
+
+    for (i = 0; i < pending_send_count; i++)
+    {
+        if (pending_sends[i].on_send_complete != NULL)
+        {
+            pending_sends[i].on_send_complete(pending_sends[i].callback_context, send_result);
+        }
+    }
+}
+
+static void complete_pending_sends(TLS_IO_INSTANCE* tls_io_instance, IO_SEND_RESULT send_result)
+{
+    TLSIO_OPENSSL_PENDING_SEND* pending_sends = tls_io_instance->pending_sends;
+    size_t pending_send_count = tls_io_instance->pending_send_count;
+    size_t pending_send_capacity = tls_io_instance->pending_send_capacity;
+
+    /*a callback that sends again gets a new pending send array*/
+    tls_io_instance->pending_sends = NULL;
+    tls_io_instance->pending_send_count = 0;
+    tls_io_instance->pending_send_capacity = 0;
+    tls_io_instance->pending_plaintext_size = 0;
+
+    indicate_pending_sends_complete(pending_sends, pending_send_count, send_result);
+
+    if (tls_io_instance->pending_sends == NULL)
+    {
+        tls_io_instance->pending_sends = pending_sends;
+        tls_io_instance->pending_send_capacity = pending_send_capacity;
+    }
+    else
+    {
+        free(pending_sends);
+    }
+}
+
+static void on_flushed_sends_complete(void* context, IO_SEND_RESULT send_result)
+{
+    TLSIO_OPENSSL_FLUSHED_SENDS* flushed_sends = (TLSIO_OPENSSL_FLUSHED_SENDS*)context;
+
+    indicate_pending_sends_complete(flushed_sends->pending_sends, flushed_sends->pending_send_count, send_result);
+    free(flushed_sends);
+}
+
+static int flush_pending_plaintext(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (tls_io_instance->pending_plaintext_size == 0)
+    {
+        result = 0;
+    }
+    else if (SSL_write(tls_io_instance->ssl, tls_io_instance->pending_plaintext, (int)tls_io_instance->pending_plaintext_size) != (int)tls_io_instance->pending_plaintext_size)
+    {
+        log_ERR_get_error("SSL_write error.");
+        complete_pending_sends(tls_io_instance, IO_SEND_ERROR);
+        result = __FAILURE__;
+    }
+    else if (tls_io_instance->pending_send_count == 1)
+    {
+        /*a single send needs no fan out of its completion*/
+        TLSIO_OPENSSL_PENDING_SEND pending_send = tls_io_instance->pending_sends[0];
+
+        tls_io_instance->pending_send_count = 0;
+        tls_io_instance->pending_plaintext_size = 0;
+
+        if (write_outgoing_bytes(tls_io_instance, pending_send.on_send_complete, pending_send.callback_context) != 0)
+        {
+            LogError("Error in write_outgoing_bytes.");
+            indicate_pending_sends_complete(&pending_send, 1, IO_SEND_ERROR);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        size_t pending_send_count = tls_io_instance->pending_send_count;
+        TLSIO_OPENSSL_FLUSHED_SENDS* flushed_sends = malloc(sizeof(TLSIO_OPENSSL_FLUSHED_SENDS) + (pending_send_count * sizeof(TLSIO_OPENSSL_PENDING_SEND)));
+        if (flushed_sends == NULL)
         {
-            LogError("NULL bytes_to_send.");
+            LogError("Cannot allocate memory for the flushed sends.");
+            /*the record is already in out_bio, it goes out with the next write_outgoing_bytes*/
+            complete_pending_sends(tls_io_instance, IO_SEND_ERROR);
             result = __FAILURE__;
         }
         else
         {
-            if (BIO_read(tls_io_instance->out_bio, bytes_to_send, (int)pending) != (int)pending)
+            flushed_sends->pending_send_count = pending_send_count;
+            flushed_sends->pending_sends = (TLSIO_OPENSSL_PENDING_SEND*)(flushed_sends + 1);
+            (void)memcpy(flushed_sends->pending_sends, tls_io_instance->pending_sends, pending_send_count * sizeof(TLSIO_OPENSSL_PENDING_SEND));
+
+            tls_io_instance->pending_send_count = 0;
+            tls_io_instance->pending_plaintext_size = 0;
+
+            if (write_outgoing_bytes(tls_io_instance, on_flushed_sends_complete, flushed_sends) != 0)
             {
-                log_ERR_get_error("BIO_read not in pending state.");
+                LogError("Error in write_outgoing_bytes.");
+                indicate_pending_sends_complete(flushed_sends->pending_sends, pending_send_count, IO_SEND_ERROR);
+                free(flushed_sends);
                 result = __FAILURE__;
             }
             else
             {
-                if (xio_send(tls_io_instance->underlying_io, bytes_to_send, pending, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Error in xio_send.");
-                    result = __FAILURE__;
-                }
-                else
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int add_pending_send(TLS_IO_INSTANCE* tls_io_instance, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((tls_io_instance->pending_plaintext == NULL) &&
+        ((tls_io_instance->pending_plaintext = malloc(TLSIO_OPENSSL_MAX_RECORD_PLAINTEXT)) == NULL))
+    {
+        LogError("Cannot allocate the pending plaintext buffer.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (tls_io_instance->pending_send_count == tls_io_instance->pending_send_capacity)
+        {
+            size_t new_capacity = (tls_io_instance->pending_send_capacity == 0) ? TLSIO_OPENSSL_INITIAL_PENDING_SEND_CAPACITY : (tls_io_instance->pending_send_capacity * 2);
+            TLSIO_OPENSSL_PENDING_SEND* new_pending_sends = realloc(tls_io_instance->pending_sends, new_capacity * sizeof(TLSIO_OPENSSL_PENDING_SEND));
+            if (new_pending_sends == NULL)
+            {
+                LogError("Cannot allocate memory for the pending sends.");
+            }
+            else
+            {
+                tls_io_instance->pending_sends = new_pending_sends;
+                tls_io_instance->pending_send_capacity = new_capacity;
+            }
+        }
+
+        if (tls_io_instance->pending_send_count == tls_io_instance->pending_send_capacity)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memcpy(tls_io_instance->pending_plaintext + tls_io_instance->pending_plaintext_size, buffer, size);
+            tls_io_instance->pending_plaintext_size += size;
+            tls_io_instance->pending_sends[tls_io_instance->pending_send_count].on_send_complete = on_send_complete;
+            tls_io_instance->pending_sends[tls_io_instance->pending_send_count].callback_context = callback_context;
+            tls_io_instance->pending_send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void destroy_session(TLSIO_OPENSSL_SESSION* session)
+{
+    SSL_SESSION_free(session->ssl_session);
+    free(session->hostname);
+    free(session);
+}
+
+static void destroy_shared_context(TLSIO_OPENSSL_CONTEXT* shared_context)
+{
+    while (shared_context->sessions != NULL)
+    {
+        TLSIO_OPENSSL_SESSION* next = shared_context->sessions->next;
+        destroy_session(shared_context->sessions);
+        shared_context->sessions = next;
+    }
+    SSL_CTX_free(shared_context->ssl_context);
+    free(shared_context->cipher_list);
+    free(shared_context->certificate);
+    free(shared_context->x509_certificate);
+    free(shared_context);
+}
+
+/*must be called with context_cache_lock held, drops the least recently used contexts that nobody holds*/
+static void trim_idle_contexts(void)
+{
+    TLSIO_OPENSSL_CONTEXT** current = &context_cache;
+    size_t idle_count = 0;
+
+    while (*current != NULL)
+    {
+        if (((*current)->ref_count == 0) &&
+            (++idle_count > TLSIO_OPENSSL_MAX_IDLE_CONTEXTS))
+        {
+            TLSIO_OPENSSL_CONTEXT* to_destroy = *current;
+            *current = to_destroy->next;
+            destroy_shared_context(to_destroy);
+        }
+        else
+        {
+            current = &(*current)->next;
+        }
+    }
+}
+
+static void release_shared_context(TLSIO_OPENSSL_CONTEXT* shared_context)
+{
+    if (context_cache_lock == NULL)
+    {
+        /*tlsio_openssl_deinit has already run and left this context to its users, which may release it from several threads*/
+        if (DEC_REF_VAR(shared_context->ref_count) == DEC_RETURN_ZERO)
+        {
+            destroy_shared_context(shared_context);
+        }
+    }
+    else if (Lock(context_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the SSL context cache, the context is leaked.");
+    }
+    else
+    {
+        if (DEC_REF_VAR(shared_context->ref_count) == DEC_RETURN_ZERO)
+        {
+            if (shared_context->orphaned)
+            {
+                destroy_shared_context(shared_context);
+            }
+            else
+            {
+                trim_idle_contexts();
+            }
+        }
+        (void)Unlock(context_cache_lock);
+    }
+}
+
+/*must be called with context_cache_lock held, unlinks the session stored for hostname:port*/
+static TLSIO_OPENSSL_SESSION* remove_session(TLSIO_OPENSSL_CONTEXT* shared_context, const char* hostname, int port)
+{
+    TLSIO_OPENSSL_SESSION* result = NULL;
+    TLSIO_OPENSSL_SESSION** current = &shared_context->sessions;
+
+    while (*current != NULL)
+    {
+        if (((*current)->port == port) &&
+            (strcmp((*current)->hostname, hostname) == 0))
+        {
+            result = *current;
+            *current = result->next;
+            shared_context->session_count--;
+            break;
+        }
+        current = &(*current)->next;
+    }
+
+    return result;
+}
+
+static void forget_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if ((tls_io_instance->shared_context != NULL) &&
+        (tls_io_instance->hostname != NULL) &&
+        (context_cache_lock != NULL) &&
+        (Lock(context_cache_lock) == LOCK_OK))
+    {
+        TLSIO_OPENSSL_SESSION* session = remove_session(tls_io_instance->shared_context, tls_io_instance->hostname, tls_io_instance->port);
+        (void)Unlock(context_cache_lock);
+
+        if (session != NULL)
+        {
+            destroy_session(session);
+        }
+    }
+}
+
+/*called by OpenSSL whenever the server hands out a session (TLS 1.3 sends its tickets after the handshake),
+returning 1 keeps the reference to ssl_session*/
+static int on_new_session(SSL* ssl, SSL_SESSION* ssl_session)
+{
+    int result;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)SSL_get_app_data(ssl);
+
+    if ((tls_io_instance == NULL) ||
+        (tls_io_instance->shared_context == NULL) ||
+        (tls_io_instance->hostname == NULL) ||
+        (context_cache_lock == NULL))
+    {
+        result = 0;
+    }
+    else
+    {
+        TLSIO_OPENSSL_SESSION* session = malloc(sizeof(TLSIO_OPENSSL_SESSION));
+        if (session == NULL)
+        {
+            LogError("Failed allocating TLS session cache entry.");
+            result = 0;
+        }
+        else if (mallocAndStrcpy_s(&session->hostname, tls_io_instance->hostname) != 0)
+        {
+            LogError("Failed copying hostname for TLS session cache entry.");
+            free(session);
+            result = 0;
+        }
+        else if (Lock(context_cache_lock) != LOCK_OK)
+        {
+            LogError("Failed locking the SSL context cache.");
+            free(session->hostname);
+            free(session);
+            result = 0;
+        }
+        else
+        {
+            TLSIO_OPENSSL_CONTEXT* shared_context = tls_io_instance->shared_context;
+            TLSIO_OPENSSL_SESSION* replaced = remove_session(shared_context, tls_io_instance->hostname, tls_io_instance->port);
+            TLSIO_OPENSSL_SESSION* evicted = NULL;
+
+            session->port = tls_io_instance->port;
+            session->ssl_session = ssl_session;
+            session->next = shared_context->sessions;
+            shared_context->sessions = session;
+            shared_context->session_count++;
+
+            if (shared_context->session_count > TLSIO_OPENSSL_MAX_SESSIONS_PER_CONTEXT)
+            {
+                /*newest sessions are at the head, drop the tail*/
+                TLSIO_OPENSSL_SESSION* last = shared_context->sessions;
+                while (last->next->next != NULL)
                 {
-                    result = 0;
+                    last = last->next;
                 }
+                evicted = last->next;
+                last->next = NULL;
+                shared_context->session_count--;
             }
+            (void)Unlock(context_cache_lock);
 
-            free(bytes_to_send);
+            if (replaced != NULL)
+            {
+                destroy_session(replaced);
+            }
+            if (evicted != NULL)
+            {
+                destroy_session(evicted);
+            }
+            result = 1;
         }
     }
 
     return result;
 }
 
+static void update_session_statistics(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if ((tls_io_instance->shared_context != NULL) &&
+        (context_cache_lock != NULL) &&
+        (Lock(context_cache_lock) == LOCK_OK))
+    {
+        if (SSL_session_reused(tls_io_instance->ssl))
+        {
+            cache_statistics.session_hits++;
+        }
+        else
+        {
+            cache_statistics.session_misses++;
+        }
+        (void)Unlock(context_cache_lock);
+    }
+}
+
+static void release_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->shared_context != NULL)
+    {
+        release_shared_context(tls_io_instance->shared_context);
+        tls_io_instance->shared_context = NULL;
+    }
+    else if (tls_io_instance->ssl_context != NULL)
+    {
+        SSL_CTX_free(tls_io_instance->ssl_context);
+    }
+    tls_io_instance->ssl_context = NULL;
+}
+
 // Non-NULL tls_io_instance is guaranteed by callers.
 // We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
 static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
@@ -676,6 +1134,8 @@ static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
             {
                 LogError("SSL handshake failed: %d", ssl_err);
             }
+            /*a session the server no longer accepts must not be offered again*/
+            forget_session(tls_io_instance);
             tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
         }
         else
@@ -689,6 +1149,7 @@ static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
     }
     else
     {
+        update_session_statistics(tls_io_instance);
         tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
         indicate_open_complete(tls_io_instance, IO_OPEN_OK);
     }
@@ -701,11 +1162,7 @@ static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
         SSL_free(tls_io_instance->ssl);
         tls_io_instance->ssl = NULL;
     }
-    if (tls_io_instance->ssl_context != NULL)
-    {
-        SSL_CTX_free(tls_io_instance->ssl_context);
-        tls_io_instance->ssl_context = NULL;
-    }
+    release_ssl_context(tls_io_instance);
 }
 
 static void on_underlying_io_close_complete(void* context)
@@ -850,13 +1307,13 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
     }
 }
 
-static int add_certificate_to_store(TLS_IO_INSTANCE* tls_io_instance, const char* certValue)
+static int add_certificate_to_store(SSL_CTX* ssl_context, const char* certValue)
 {
     int result = 0;
 
     if (certValue != NULL)
     {
-        X509_STORE* cert_store = SSL_CTX_get_cert_store(tls_io_instance->ssl_context);
+        X509_STORE* cert_store = SSL_CTX_get_cert_store(ssl_context);
         if (cert_store == NULL)
         {
             log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
@@ -931,10 +1388,114 @@ static int add_certificate_to_store(TLS_IO_INSTANCE* tls_io_instance, const char
     return result;
 }
 
-static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
+static bool option_equals(const char* left, const char* right)
+{
+    return ((left == NULL) && (right == NULL)) ||
+        ((left != NULL) && (right != NULL) && (strcmp(left, right) == 0));
+}
+
+static bool shared_context_matches(const TLSIO_OPENSSL_CONTEXT* shared_context, const TLS_IO_INSTANCE* tls_io_instance, const unsigned char* x509_private_key_digest)
+{
+    return !shared_context->orphaned &&
+        (shared_context->tls_version == tls_io_instance->tls_version) &&
+        (shared_context->tls_validation_callback == tls_io_instance->tls_validation_callback) &&
+        (shared_context->tls_validation_callback_data == tls_io_instance->tls_validation_callback_data) &&
+        option_equals(shared_context->cipher_list, tls_io_instance->cipher_list) &&
+        option_equals(shared_context->certificate, tls_io_instance->certificate) &&
+        option_equals(shared_context->x509_certificate, tls_io_instance->x509_certificate) &&
+        (shared_context->has_x509_private_key == (tls_io_instance->x509_private_key != NULL)) &&
+        ((tls_io_instance->x509_private_key == NULL) ||
+            (memcmp(shared_context->x509_private_key_digest, x509_private_key_digest, SHA256_DIGEST_LENGTH) == 0));
+}
+
+/*must be called with context_cache_lock held, a hit is moved to the front of the cache*/
+static TLSIO_OPENSSL_CONTEXT* find_shared_context(const TLS_IO_INSTANCE* tls_io_instance, const unsigned char* x509_private_key_digest)
+{
+    TLSIO_OPENSSL_CONTEXT* result = NULL;
+    TLSIO_OPENSSL_CONTEXT** current = &context_cache;
+
+    while (*current != NULL)
+    {
+        if (shared_context_matches(*current, tls_io_instance, x509_private_key_digest))
+        {
+            result = *current;
+            *current = result->next;
+            result->next = context_cache;
+            context_cache = result;
+            (void)INC_REF_VAR(result->ref_count);
+            break;
+        }
+        current = &(*current)->next;
+    }
+
+    return result;
+}
+
+static int copy_option(char** destination, const char* source)
 {
     int result;
 
+    if (source == NULL)
+    {
+        *destination = NULL;
+        result = 0;
+    }
+    else if (mallocAndStrcpy_s(destination, source) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static TLSIO_OPENSSL_CONTEXT* create_shared_context(const TLS_IO_INSTANCE* tls_io_instance, SSL_CTX* ssl_context, const unsigned char* x509_private_key_digest)
+{
+    TLSIO_OPENSSL_CONTEXT* result = malloc(sizeof(TLSIO_OPENSSL_CONTEXT));
+    if (result == NULL)
+    {
+        LogError("Failed allocating SSL context cache entry.");
+    }
+    else
+    {
+        result->ssl_context = ssl_context;
+        INIT_REF_VAR(result->ref_count);
+        result->orphaned = false;
+        result->tls_version = tls_io_instance->tls_version;
+        result->tls_validation_callback = tls_io_instance->tls_validation_callback;
+        result->tls_validation_callback_data = tls_io_instance->tls_validation_callback_data;
+        result->sessions = NULL;
+        result->session_count = 0;
+        result->next = NULL;
+        result->cipher_list = NULL;
+        result->certificate = NULL;
+        result->x509_certificate = NULL;
+        result->has_x509_private_key = (tls_io_instance->x509_private_key != NULL);
+        (void)memcpy(result->x509_private_key_digest, x509_private_key_digest, SHA256_DIGEST_LENGTH);
+
+        if ((copy_option(&result->cipher_list, tls_io_instance->cipher_list) != 0) ||
+            (copy_option(&result->certificate, tls_io_instance->certificate) != 0) ||
+            (copy_option(&result->x509_certificate, tls_io_instance->x509_certificate) != 0))
+        {
+            LogError("Failed copying the SSL context cache key.");
+            free(result->cipher_list);
+            free(result->certificate);
+            free(result->x509_certificate);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static SSL_CTX* create_ssl_context(const TLS_IO_INSTANCE* tlsInstance)
+{
+    SSL_CTX* result;
+
     const SSL_METHOD* method = NULL;
 
 #if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
@@ -956,48 +1517,183 @@ static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
     }
 #endif
 
-    tlsInstance->ssl_context = SSL_CTX_new(method);
-    if (tlsInstance->ssl_context == NULL)
+    result = SSL_CTX_new(method);
+    if (result == NULL)
     {
         log_ERR_get_error("Failed allocating OpenSSL context.");
-        result = __FAILURE__;
     }
     else if ((tlsInstance->cipher_list != NULL) &&
-             (SSL_CTX_set_cipher_list(tlsInstance->ssl_context, tlsInstance->cipher_list)) != 1)
+             (SSL_CTX_set_cipher_list(result, tlsInstance->cipher_list)) != 1)
     {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
+        SSL_CTX_free(result);
+        result = NULL;
         log_ERR_get_error("unable to set cipher list.");
-        result = __FAILURE__;
     }
-    else if (add_certificate_to_store(tlsInstance, tlsInstance->certificate) != 0)
+    else if (add_certificate_to_store(result, tlsInstance->certificate) != 0)
     {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
+        SSL_CTX_free(result);
+        result = NULL;
         log_ERR_get_error("unable to add_certificate_to_store.");
-        result = __FAILURE__;
     }
     /*x509 authentication can only be build before underlying connection is realized*/
     else if (
         (tlsInstance->x509_certificate != NULL) &&
         (tlsInstance->x509_private_key != NULL) &&
-        (x509_openssl_add_credentials(tlsInstance->ssl_context, tlsInstance->x509_certificate, tlsInstance->x509_private_key) != 0)
+        (x509_openssl_add_credentials(result, tlsInstance->x509_certificate, tlsInstance->x509_private_key) != 0)
         )
     {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
+        SSL_CTX_free(result);
+        result = NULL;
         log_ERR_get_error("unable to use x509 authentication");
+    }
+    else
+    {
+        SSL_CTX_set_cert_verify_callback(result, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
+        SSL_CTX_set_verify(result, SSL_VERIFY_PEER, NULL);
+
+        // Specifies that the default locations for which CA certificates are loaded should be used.
+        if (SSL_CTX_set_default_verify_paths(result) != 1)
+        {
+            // This is only a warning to the user. They can still specify the certificate via SetOption.
+            LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+        }
+
+        /*client sessions are kept per hostname:port in the context cache, not in OpenSSL's own store*/
+        (void)SSL_CTX_set_session_cache_mode(result, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(result, on_new_session);
+    }
+
+    return result;
+}
+
+/*gets an SSL_CTX for the instance's configuration, shared with other instances when the cache exists*/
+static int acquire_ssl_context(TLS_IO_INSTANCE* tlsInstance)
+{
+    int result;
+
+    if (context_cache_lock == NULL)
+    {
+        tlsInstance->shared_context = NULL;
+        tlsInstance->ssl_context = create_ssl_context(tlsInstance);
+        result = (tlsInstance->ssl_context == NULL) ? __FAILURE__ : 0;
+    }
+    else if (Lock(context_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the SSL context cache.");
         result = __FAILURE__;
     }
     else
     {
-        SSL_CTX_set_cert_verify_callback(tlsInstance->ssl_context, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
+        TLSIO_OPENSSL_CONTEXT* shared_context;
+        unsigned char x509_private_key_digest[SHA256_DIGEST_LENGTH];
+
+        if (tlsInstance->x509_private_key == NULL)
+        {
+            (void)memset(x509_private_key_digest, 0, sizeof(x509_private_key_digest));
+        }
+        else
+        {
+            (void)SHA256((const unsigned char*)tlsInstance->x509_private_key, strlen(tlsInstance->x509_private_key), x509_private_key_digest);
+        }
+
+        shared_context = find_shared_context(tlsInstance, x509_private_key_digest);
+        if (shared_context != NULL)
+        {
+            cache_statistics.context_hits++;
+            (void)Unlock(context_cache_lock);
+        }
+        else
+        {
+            SSL_CTX* ssl_context;
+
+            cache_statistics.context_misses++;
+            (void)Unlock(context_cache_lock);
 
+            /*loading certificates is slow, the context is built without holding the lock*/
+            ssl_context = create_ssl_context(tlsInstance);
+            if (ssl_context != NULL)
+            {
+                shared_context = create_shared_context(tlsInstance, ssl_context, x509_private_key_digest);
+                if (shared_context == NULL)
+                {
+                    SSL_CTX_free(ssl_context);
+                }
+                else if (Lock(context_cache_lock) != LOCK_OK)
+                {
+                    LogError("Failed locking the SSL context cache.");
+                    destroy_shared_context(shared_context);
+                    shared_context = NULL;
+                }
+                else
+                {
+                    shared_context->next = context_cache;
+                    context_cache = shared_context;
+                    trim_idle_contexts();
+                    (void)Unlock(context_cache_lock);
+                }
+            }
+        }
+
+        if (shared_context == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            tlsInstance->shared_context = shared_context;
+            tlsInstance->ssl_context = shared_context->ssl_context;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/*offers the last session negotiated with the same hostname:port so the handshake can be abbreviated*/
+static void apply_cached_session(TLS_IO_INSTANCE* tlsInstance)
+{
+    if ((tlsInstance->shared_context != NULL) &&
+        (tlsInstance->hostname != NULL) &&
+        (Lock(context_cache_lock) == LOCK_OK))
+    {
+        TLSIO_OPENSSL_SESSION* session = tlsInstance->shared_context->sessions;
+        while ((session != NULL) &&
+            ((session->port != tlsInstance->port) || (strcmp(session->hostname, tlsInstance->hostname) != 0)))
+        {
+            session = session->next;
+        }
+
+        if (session != NULL)
+        {
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L) && !defined(LIBRESSL_VERSION_NUMBER)
+            if (SSL_SESSION_is_resumable(session->ssl_session))
+#endif
+            {
+                if (SSL_set_session(tlsInstance->ssl, session->ssl_session) != 1)
+                {
+                    LogInfo("WARNING: unable to reuse the cached TLS session.");
+                }
+            }
+        }
+        (void)Unlock(context_cache_lock);
+    }
+}
+
+static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
+{
+    int result;
+
+    if (acquire_ssl_context(tlsInstance) != 0)
+    {
+        LogError("Failed getting an OpenSSL context.");
+        result = __FAILURE__;
+    }
+    else
+    {
         tlsInstance->in_bio = BIO_new(BIO_s_mem());
         if (tlsInstance->in_bio == NULL)
         {
-            SSL_CTX_free(tlsInstance->ssl_context);
-            tlsInstance->ssl_context = NULL;
+            release_ssl_context(tlsInstance);
             log_ERR_get_error("Failed BIO_new for in BIO.");
             result = __FAILURE__;
         }
@@ -1007,8 +1703,7 @@ static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
             if (tlsInstance->out_bio == NULL)
             {
                 (void)BIO_free(tlsInstance->in_bio);
-                SSL_CTX_free(tlsInstance->ssl_context);
-                tlsInstance->ssl_context = NULL;
+                release_ssl_context(tlsInstance);
                 log_ERR_get_error("Failed BIO_new for out BIO.");
                 result = __FAILURE__;
             }
@@ -1019,36 +1714,27 @@ static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
                 {
                     (void)BIO_free(tlsInstance->in_bio);
                     (void)BIO_free(tlsInstance->out_bio);
-                    SSL_CTX_free(tlsInstance->ssl_context);
-                    tlsInstance->ssl_context = NULL;
+                    release_ssl_context(tlsInstance);
                     LogError("Failed BIO_set_mem_eof_return.");
                     result = __FAILURE__;
                 }
                 else
                 {
-                    SSL_CTX_set_verify(tlsInstance->ssl_context, SSL_VERIFY_PEER, NULL);
-
-                    // Specifies that the default locations for which CA certificates are loaded should be used.
-                    if (SSL_CTX_set_default_verify_paths(tlsInstance->ssl_context) != 1)
-                    {
-                        // This is only a warning to the user. They can still specify the certificate via SetOption.
-                        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
-                    }
-
                     tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
                     if (tlsInstance->ssl == NULL)
                     {
                         (void)BIO_free(tlsInstance->in_bio);
                         (void)BIO_free(tlsInstance->out_bio);
-                        SSL_CTX_free(tlsInstance->ssl_context);
-                        tlsInstance->ssl_context = NULL;
+                        release_ssl_context(tlsInstance);
                         log_ERR_get_error("Failed creating OpenSSL instance.");
                         result = __FAILURE__;
                     }
                     else
                     {
+                        SSL_set_app_data(tlsInstance->ssl, tlsInstance);
                         SSL_set_bio(tlsInstance->ssl, tlsInstance->in_bio, tlsInstance->out_bio);
                         SSL_set_connect_state(tlsInstance->ssl);
+                        apply_cached_session(tlsInstance);
                         result = 0;
                     }
                 }
@@ -1073,11 +1759,48 @@ int tlsio_openssl_init(void)
     }
 
     openssl_dynamic_locks_install();
+
+    if (context_cache_lock == NULL)
+    {
+        /*without the lock every open builds its own SSL_CTX, as it always did*/
+        context_cache_lock = Lock_Init();
+        if (context_cache_lock == NULL)
+        {
+            LogInfo("WARNING: unable to create the SSL context cache lock, SSL contexts will not be shared.");
+        }
+    }
     return 0;
 }
 
 void tlsio_openssl_deinit(void)
 {
+    if ((context_cache_lock != NULL) &&
+        (Lock(context_cache_lock) == LOCK_OK))
+    {
+        LOCK_HANDLE lock = context_cache_lock;
+
+        /*contexts that are still in use are freed by their last user*/
+        while (context_cache != NULL)
+        {
+            TLSIO_OPENSSL_CONTEXT* next = context_cache->next;
+            if (context_cache->ref_count == 0)
+            {
+                destroy_shared_context(context_cache);
+            }
+            else
+            {
+                context_cache->orphaned = true;
+                context_cache->next = NULL;
+            }
+            context_cache = next;
+        }
+        (void)memset(&cache_statistics, 0, sizeof(cache_statistics));
+
+        context_cache_lock = NULL;
+        (void)Unlock(lock);
+        (void)Lock_Deinit(lock);
+    }
+
     openssl_dynamic_locks_uninstall();
     openssl_static_locks_uninstall();
 #if  (OPENSSL_VERSION_NUMBER >= 0x00907000L) &&  (OPENSSL_VERSION_NUMBER < 0x20000000L) && (FIPS_mode_set)
@@ -1159,16 +1882,35 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
                 result->on_io_error_context = NULL;
                 result->ssl = NULL;
                 result->ssl_context = NULL;
+                result->shared_context = NULL;
+                result->hostname = NULL;
+                result->port = tls_io_config->port;
                 result->tls_validation_callback = NULL;
                 result->tls_validation_callback_data = NULL;
                 result->x509_certificate = NULL;
                 result->x509_private_key = NULL;
+                result->scratch_buffer = NULL;
+                result->scratch_buffer_size = 0;
+                result->pending_plaintext = NULL;
+                result->pending_plaintext_size = 0;
+                result->pending_sends = NULL;
+                result->pending_send_count = 0;
+                result->pending_send_capacity = 0;
 
                 result->tls_version = VERSION_1_2;
 
+                /*TLS sessions are cached per hostname:port, without a hostname they are not reused*/
+                if ((tls_io_config->hostname != NULL) &&
+                    (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+                {
+                    LogInfo("WARNING: unable to copy the hostname, TLS sessions will not be resumed.");
+                    result->hostname = NULL;
+                }
+
                 result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters);
                 if (result->underlying_io == NULL)
                 {
+                    free(result->hostname);
                     free(result);
                     result = NULL;
                     LogError("Failed xio_create.");
@@ -1205,12 +1947,18 @@ void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
         }
         free((void*)tls_io_instance->x509_certificate);
         free((void*)tls_io_instance->x509_private_key);
+        free(tls_io_instance->hostname);
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        complete_pending_sends(tls_io_instance, IO_SEND_CANCELLED);
         close_openssl_instance(tls_io_instance);
         if (tls_io_instance->underlying_io != NULL)
         {
             xio_destroy(tls_io_instance->underlying_io);
             tls_io_instance->underlying_io = NULL;
         }
+        free(tls_io_instance->pending_sends);
+        free(tls_io_instance->pending_plaintext);
+        free(tls_io_instance->scratch_buffer);
         free(tls_io);
     }
 }
@@ -1307,6 +2055,17 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
             tls_io_instance->tlsio_state = TLSIO_STATE_CLOSING;
             tls_io_instance->on_io_close_complete = on_io_close_complete;
             tls_io_instance->on_io_close_complete_context = callback_context;
+            if (flush_pending_plaintext(tls_io_instance) != 0)
+            {
+                LogInfo("WARNING: unable to send the pending writes before closing.");
+            }
+            // Send close_notify, OpenSSL does not resume sessions of connections that were not shut down
+            ERR_clear_error();
+            if ((SSL_shutdown(tls_io_instance->ssl) < 0) ||
+                (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0))
+            {
+                LogInfo("WARNING: unable to send the TLS close_notify.");
+            }
             // xio_close is guaranteed to succeed from the open state, and the callback completes the
             // transition into TLSIO_STATE_NOT_OPEN
             if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
@@ -1317,6 +2076,8 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
         }
         else
         {
+            /* Codes_SRS_TLSIO_30_009: [ The phrase "enter TLSIO_STATE_EXT_CLOSING" means the adapter shall iterate through any unsent messages in the queue and shall delete each message after calling its on_send_complete with the associated callback_context and IO_SEND_CANCELLED. ]*/
+            complete_pending_sends(tls_io_instance, IO_SEND_CANCELLED);
             // Just force the shutdown
             /* Codes_SRS_TLSIO_30_056: [ On success the adapter shall enter TLSIO_STATE_EX_CLOSING. ]*/
             /* Codes_SRS_TLSIO_30_051: [ On success, if the underlying TLS does not support asynchronous closing or if the adapter is not in TLSIO_STATE_EXT_OPEN, then the adapter shall enter TLSIO_STATE_EXT_CLOSED immediately after entering TLSIO_STATE_EXT_CLOSING. ]*/
@@ -1361,23 +2122,50 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
                 return result;
             }
 
-            res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
-            if (res != (int)size)
+            if ((tls_io_instance->pending_plaintext_size + size > TLSIO_OPENSSL_MAX_RECORD_PLAINTEXT) &&
+                (flush_pending_plaintext(tls_io_instance) != 0))
             {
-                log_ERR_get_error("SSL_write error.");
+                LogError("Cannot flush the pending writes.");
                 result = __FAILURE__;
             }
-            else
+            else if (size >= TLSIO_OPENSSL_MAX_RECORD_PLAINTEXT)
             {
-                if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+                // A write of at least one full record is not gathered
+                res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
+                if (res != (int)size)
                 {
-                    LogError("Error in write_outgoing_bytes.");
+                    log_ERR_get_error("SSL_write error.");
                     result = __FAILURE__;
                 }
                 else
                 {
-                    result = 0;
+                    if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+                    {
+                        LogError("Error in write_outgoing_bytes.");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+            }
+            // Smaller writes are gathered so that they share one TLS record, tlsio_openssl_dowork sends them
+            else if (add_pending_send(tls_io_instance, buffer, size, on_send_complete, callback_context) != 0)
+            {
+                LogError("Cannot queue the write.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if ((tls_io_instance->pending_plaintext_size == TLSIO_OPENSSL_MAX_RECORD_PLAINTEXT) &&
+                    (flush_pending_plaintext(tls_io_instance) != 0))
+                {
+                    // the write was accepted, its failure was indicated through on_send_complete
+                    LogError("Cannot flush the full record.");
                 }
+
+                result = 0;
             }
         }
     }
@@ -1397,9 +2185,14 @@ void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
 
         switch (tls_io_instance->tlsio_state)
         {
+        case TLSIO_STATE_OPEN:
+            if (flush_pending_plaintext(tls_io_instance) != 0)
+            {
+                LogError("Cannot flush the pending writes.");
+            }
+            /* fall through */
         case TLSIO_STATE_OPENING_UNDERLYING_IO:
         case TLSIO_STATE_IN_HANDSHAKE:
-        case TLSIO_STATE_OPEN:
             /* this is needed in order to pump out bytes produces by OpenSSL for things like renegotiation */
             write_outgoing_bytes(tls_io_instance, NULL, NULL);
             break;
@@ -1416,6 +2209,13 @@ void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
             /* Same behavior as schannel */
             xio_dowork(tls_io_instance->underlying_io);
 
+            /* writes queued by on_bytes_received callbacks during xio_dowork do not wait for the next call */
+            if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+                (flush_pending_plaintext(tls_io_instance) != 0))
+            {
+                LogError("Cannot flush the pending writes.");
+            }
+
             if (tls_io_instance->tlsio_state == TLSIO_STATE_HANDSHAKE_FAILED)
             {
                 // The handshake failed so we need to close. The tlsio becomes aware of the
@@ -1471,10 +2271,11 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 result = 0;
             }
 
-            // If we're previously connected then add the cert to the context
-            if (tls_io_instance->ssl_context != NULL)
+            // If we're previously connected then add the cert to the context.
+            // A shared context is left alone, the certificate is part of its key and is used from the next open.
+            if ((tls_io_instance->ssl_context != NULL) && (tls_io_instance->shared_context == NULL))
             {
-                result = add_certificate_to_store(tls_io_instance, cert);
+                result = add_certificate_to_store(tls_io_instance->ssl_context, cert);
             }
         }
         else if (strcmp(OPTION_OPENSSL_CIPHER_SUITE, optionName) == 0)
@@ -1550,7 +2351,7 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
 #pragma warning(pop)
 #endif // WIN32
 
-            if (tls_io_instance->ssl_context != NULL)
+            if ((tls_io_instance->ssl_context != NULL) && (tls_io_instance->shared_context == NULL))
             {
                 SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
             }
@@ -1561,7 +2362,7 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
         {
             tls_io_instance->tls_validation_callback_data = (void*)value;
 
-            if (tls_io_instance->ssl_context != NULL)
+            if ((tls_io_instance->ssl_context != NULL) && (tls_io_instance->shared_context == NULL))
             {
                 SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
             }
@@ -1634,3 +2435,32 @@ const IO_INTERFACE_DESCRIPTION* tlsio_openssl_get_interface_description(void)
 {
     return &tlsio_openssl_interface_description;
 }
+
+int tlsio_openssl_get_cache_statistics(TLSIO_OPENSSL_CACHE_STATISTICS* statistics)
+{
+    int result;
+
+    if (statistics == NULL)
+    {
+        LogError("NULL statistics.");
+        result = __FAILURE__;
+    }
+    else if (context_cache_lock == NULL)
+    {
+        (void)memset(statistics, 0, sizeof(TLSIO_OPENSSL_CACHE_STATISTICS));
+        result = 0;
+    }
+    else if (Lock(context_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the SSL context cache.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *statistics = cache_statistics;
+        (void)Unlock(context_cache_lock);
+        result = 0;
+    }
+
+    return result;
+}
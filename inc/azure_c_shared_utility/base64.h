@@ -76,6 +76,39 @@ MOCKABLE_FUNCTION(, STRING_HANDLE, Base64_Encode_Bytes, const unsigned char*, so
  */
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, Base64_Decoder, const char*, source);
 
+/**
+ * @brief    Base64 encodes @p size bytes from @p source into a caller supplied buffer.
+ *
+ * @param    source              The bytes that need to be base64 encoded. May be @c NULL when @p size is zero.
+ * @param    size                The number of bytes in @p source.
+ * @param    destination         Receives the encoding followed by a null terminator.
+ * @param    destination_size    The size of @p destination, at least 4 * ((@p size + 2) / 3) + 1 bytes.
+ * @param    encoded_length      Receives the number of characters written, without the terminator.
+ *
+ *             No memory is allocated. On x86 targets the encoding uses SSSE3 or AVX2 when the
+ *             processor supports them.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid or @p destination is too small.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encode_Into, const unsigned char*, source, size_t, size, char*, destination, size_t, destination_size, size_t*, encoded_length);
+
+/**
+ * @brief    Base64 decodes @p source_length characters from @p source into a caller supplied buffer.
+ *
+ * @param    source              A base64 encoded string, it does not need to be null terminated.
+ * @param    source_length       The number of characters in @p source, a multiple of 4.
+ * @param    destination         Receives the decoded bytes.
+ * @param    destination_size    The size of @p destination, 3 * @p source_length / 4 bytes are always enough.
+ * @param    decoded_length      Receives the number of decoded bytes.
+ *
+ *             Unlike @c Base64_Decoder the whole input is validated: every character has to be part
+ *             of the base64 alphabet, except for up to two = at the end. No memory is allocated.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid, @p source is not valid
+ *             base64 or @p destination is too small.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Decode_Into, const char*, source, size_t, source_length, unsigned char*, destination, size_t, destination_size, size_t*, decoded_length);
+
 #ifdef __cplusplus
 }
 #endif
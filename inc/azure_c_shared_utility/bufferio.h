@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef BUFFERIO_H
+#define BUFFERIO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+/* bufferio is an IO that can be stacked on top of any other IO. It gathers the bytes of consecutive sends in one
+buffer and hands them to the underlying IO in a single send, either when the buffer reaches max_buffered_bytes or
+from bufferio_dowork once max_delay_ms have passed since the oldest buffered byte. The on_send_complete callback of
+every bufferio send is still called, with the result of the underlying send that carried its bytes. */
+
+#define BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES 16384
+
+typedef struct BUFFERIO_CONFIG_TAG
+{
+    const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+    void* underlying_io_parameters;
+    /* 0 selects BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES, sends of this size or bigger are not buffered */
+    size_t max_buffered_bytes;
+    /* 0 flushes on every bufferio_dowork */
+    unsigned int max_delay_ms;
+} BUFFERIO_CONFIG;
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, bufferio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BUFFERIO_H */
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef GBALLOC_POOL_H
+#define GBALLOC_POOL_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+/* gballoc_pool is a built-in implementation of the gballoc_malloc family for GB_USE_CUSTOM_HEAP builds
+(CMake option use_gballoc_pool). Small blocks are served from per size class pools with a thread local cache,
+larger blocks go to the C runtime. */
+
+typedef struct GBALLOC_POOL_CLASS_STATISTICS_TAG
+{
+    /* largest size served by the class */
+    size_t block_size;
+    /* blocks carved out of slabs for this class */
+    size_t blocks_reserved;
+    /* blocks handed out and not yet freed */
+    size_t blocks_in_use;
+    /* allocations served by the class */
+    size_t allocations;
+    /* allocations served from a thread local cache without taking the class lock */
+    size_t cache_hits;
+} GBALLOC_POOL_CLASS_STATISTICS;
+
+MOCKABLE_FUNCTION(, size_t, gballoc_pool_get_class_count);
+MOCKABLE_FUNCTION(, int, gballoc_pool_get_class_statistics, size_t, class_index, GBALLOC_POOL_CLASS_STATISTICS*, statistics);
+MOCKABLE_FUNCTION(, size_t, gballoc_pool_get_large_allocation_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GBALLOC_POOL_H */
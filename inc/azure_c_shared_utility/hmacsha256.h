@@ -6,6 +6,7 @@
 
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/sha.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
@@ -19,8 +20,22 @@ extern "C" {
 
 DEFINE_ENUM(HMACSHA256_RESULT, HMACSHA256_RESULT_VALUES)
 
+#define HMACSHA256_HASH_SIZE SHA256HashSize
+
+/* Holds the SHA-256 states after absorbing the inner and outer padded key, so that
+   signing many payloads with the same key only hashes the payloads */
+typedef struct HMACSHA256_CONTEXT_TAG
+{
+    SHA256Context inner;
+    SHA256Context outer;
+} HMACSHA256_CONTEXT;
+
 MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHash, const unsigned char*, key, size_t, keyLen, const unsigned char*, payload, size_t, payloadLen, BUFFER_HANDLE, hash);
 
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_InitContext, HMACSHA256_CONTEXT*, context, const unsigned char*, key, size_t, keyLen);
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHashWithContext, const HMACSHA256_CONTEXT*, context, const unsigned char*, payload, size_t, payloadLen, unsigned char*, hash);
+MOCKABLE_FUNCTION(, void, HMACSHA256_DeinitContext, HMACSHA256_CONTEXT*, context);
+
 #ifdef __cplusplus
 }
 #endif
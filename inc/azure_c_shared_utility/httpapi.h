@@ -165,6 +165,80 @@ MOCKABLE_FUNCTION(, HTTPAPI_RESULT, HTTPAPI_ExecuteRequest, HTTP_HANDLE, handle,
                                              size_t, contentLength, unsigned int*, statusCode,
                                              HTTP_HEADERS_HANDLE, responseHeadersHandle, BUFFER_HANDLE, responseContent);
 
+/**
+ * @brief    Callback invoked from ::HTTPAPI_DoWork when a request started with
+ *             ::HTTPAPI_ExecuteRequestAsync completes.
+ *
+ * @param    context        The @p callback_context given to ::HTTPAPI_ExecuteRequestAsync.
+ * @param    result         @c HTTPAPI_OK if a complete response was received or an
+ *                         error code in case it failed.
+ * @param    statusCode     The status code of the response, 0 if none was received.
+ */
+typedef void(*ON_HTTPAPI_REQUEST_COMPLETE)(void* context, HTTPAPI_RESULT result, unsigned int statusCode);
+
+/**
+ * @brief    Starts an HTTP request without waiting for the response.
+ *
+ *             The parameters have the same meaning as for ::HTTPAPI_ExecuteRequest.
+ *             The request headers and content are copied before this function
+ *             returns; @p responseHeadersHandle and @p responseContent must stay
+ *             valid until @p on_request_complete is called. Only one request can
+ *             be in progress on a connection; the progress is made by
+ *             ::HTTPAPI_DoWork, so one thread can drive many connections.
+ *             Not every HTTPAPI adapter implements the asynchronous calls.
+ *
+ * @return    @c HTTPAPI_OK if the request was started or an error code in
+ *             case it fails, in which case @p on_request_complete is not called.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, HTTPAPI_ExecuteRequestAsync, HTTP_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath,
+                                             HTTP_HEADERS_HANDLE, httpHeadersHandle, const unsigned char*, content, size_t, contentLength,
+                                             HTTP_HEADERS_HANDLE, responseHeadersHandle, BUFFER_HANDLE, responseContent,
+                                             ON_HTTPAPI_REQUEST_COMPLETE, on_request_complete, void*, callback_context);
+
+/**
+ * @brief    Makes progress on the request started with ::HTTPAPI_ExecuteRequestAsync
+ *             and calls its completion callback when it is done. It never sleeps.
+ *
+ * @param    handle    The handle to the HTTP connection created via ::HTTPAPI_CreateConnection.
+ */
+MOCKABLE_FUNCTION(, void, HTTPAPI_DoWork, HTTP_HANDLE, handle);
+
+/** @brief One request of ::HTTPAPI_ExecuteRequestBatch, the parameters have the
+ *          same meaning as for ::HTTPAPI_ExecuteRequest.
+ */
+typedef struct HTTPAPI_BATCH_REQUEST_TAG
+{
+    HTTPAPI_REQUEST_TYPE requestType;
+    const char* relativePath;
+    HTTP_HEADERS_HANDLE httpHeadersHandle;
+    const unsigned char* content;
+    size_t contentLength;
+    HTTP_HEADERS_HANDLE responseHeadersHandle;
+    BUFFER_HANDLE responseContent;
+    unsigned int statusCode;    /*out*/
+    HTTPAPI_RESULT result;      /*out*/
+} HTTPAPI_BATCH_REQUEST;
+
+/**
+ * @brief    Executes several HTTP requests on the same connection.
+ *
+ * @param    handle          The handle to the HTTP connection created via ::HTTPAPI_CreateConnection.
+ * @param    requests        The requests, their @c statusCode and @c result are
+ *                           written by the call.
+ * @param    requestCount    The number of requests.
+ *
+ *             Adapters that support HTTP/1.1 pipelining write all the requests
+ *             back to back and then read the responses in order, the others
+ *             execute the requests one after the other. The @c result of a request
+ *             that got no response, for example because the server closed the
+ *             connection after an earlier response, is @c HTTPAPI_ERROR, such a
+ *             request can be sent again.
+ *
+ * @return    @c HTTPAPI_OK if all the requests got a response or an error
+ *             code in case any of them failed.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, HTTPAPI_ExecuteRequestBatch, HTTP_HANDLE, handle, HTTPAPI_BATCH_REQUEST*, requests, size_t, requestCount);
+
 /**
  * @brief    Sets the option named @p optionName bearing the value
  *             @p value for the HTTP_HANDLE @p handle.
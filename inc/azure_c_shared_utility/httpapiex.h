@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 typedef struct HTTPAPIEX_HANDLE_DATA_TAG* HTTPAPIEX_HANDLE;
+typedef struct HTTPAPIEX_POOL_DATA_TAG* HTTPAPIEX_POOL_HANDLE;
 
 #define HTTPAPIEX_RESULT_VALUES \
     HTTPAPIEX_OK, \
@@ -56,6 +57,49 @@ DEFINE_ENUM(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
  */
 MOCKABLE_FUNCTION(, HTTPAPIEX_HANDLE, HTTPAPIEX_Create, const char*, hostName);
 
+/**
+ * @brief    Creates a pool of kept-alive HTTP connections that can be shared by
+ *           several @c HTTPAPIEX_HANDLE objects, also from several threads.
+ *
+ * @param    maxConnectionsPerHost    Maximum number of connections, idle or in use,
+ *                                    that the pool keeps open to the same host.
+ * @param    idleTimeoutInSeconds     Idle connections older than this are closed
+ *                                    instead of being reused.
+ *
+ *           The pool calls @c HTTPAPI_Init once and @c HTTPAPI_Deinit when it is
+ *           destroyed. Connections are kept per host name, they carry the options of
+ *           the handle that opened them, so all the handles that share a pool and a
+ *           host are expected to use the same options.
+ *
+ * @return   A valid @c HTTPAPIEX_POOL_HANDLE or @c NULL if @p maxConnectionsPerHost
+ *           is 0 or if creating the pool fails.
+ */
+MOCKABLE_FUNCTION(, HTTPAPIEX_POOL_HANDLE, HTTPAPIEX_Pool_Create, size_t, maxConnectionsPerHost, unsigned int, idleTimeoutInSeconds);
+
+/**
+ * @brief    Closes all the idle connections of the pool and frees it. All the
+ *           @c HTTPAPIEX_HANDLE objects using the pool shall be destroyed before.
+ *
+ * @param    pool    The @c HTTPAPIEX_POOL_HANDLE to be freed.
+ */
+MOCKABLE_FUNCTION(, void, HTTPAPIEX_Pool_Destroy, HTTPAPIEX_POOL_HANDLE, pool);
+
+/**
+ * @brief    Creates an @c HTTPAPIEX_HANDLE that executes its requests on connections
+ *           taken from @p pool instead of owning one connection.
+ *
+ * @param    hostName    Pointer to a null-terminated string that contains the host name
+ *                       of an HTTP server.
+ * @param    pool        A valid @c HTTPAPIEX_POOL_HANDLE that outlives the handle.
+ *
+ *           Each call to @c HTTPAPIEX_ExecuteRequest checks a connection out of the
+ *           pool and returns it once the response is received. If a reused connection
+ *           fails, the request is retried once on a new connection.
+ *
+ * @return   An @c HTTAPIEX_HANDLE suitable for further calls to the module or @c NULL.
+ */
+MOCKABLE_FUNCTION(, HTTPAPIEX_HANDLE, HTTPAPIEX_CreateWithPool, const char*, hostName, HTTPAPIEX_POOL_HANDLE, pool);
+
 /**
  * @brief    Tries to execute an HTTP request.
  *
@@ -81,6 +125,38 @@ MOCKABLE_FUNCTION(, HTTPAPIEX_HANDLE, HTTPAPIEX_Create, const char*, hostName);
  */
 MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, HTTPAPIEX_ExecuteRequest, HTTPAPIEX_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath, HTTP_HEADERS_HANDLE, requestHttpHeadersHandle, BUFFER_HANDLE, requestContent, unsigned int*, statusCode, HTTP_HEADERS_HANDLE, responseHttpHeadersHandle, BUFFER_HANDLE, responseContent);
 
+/** @brief    One request of a batch passed to ::HTTPAPIEX_ExecuteBatch. The in fields have the same meaning as the parameters of ::HTTPAPIEX_ExecuteRequest. */
+typedef struct HTTPAPIEX_BATCH_REQUEST_TAG
+{
+    HTTPAPI_REQUEST_TYPE requestType;
+    const char* relativePath;
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle;
+    BUFFER_HANDLE requestContent;
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle;
+    BUFFER_HANDLE responseContent;
+    unsigned int statusCode; /*out*/
+    HTTPAPIEX_RESULT result; /*out*/
+} HTTPAPIEX_BATCH_REQUEST;
+
+/**
+ * @brief    Executes several HTTP requests to the same host, pipelining them when the
+ *           underlying HTTPAPI adapter supports it.
+ *
+ * @param    handle          A valid @c HTTPAPIEX_HANDLE value.
+ * @param    requests        The requests to execute. @c statusCode and @c result of
+ *                           every element are written by the call.
+ * @param    requestCount    The number of elements in @p requests.
+ *
+ *           The requests are handed to ::HTTPAPI_ExecuteRequestBatch on one connection.
+ *           Every request that did not complete there (for example because the server
+ *           closed the connection in the middle of the batch) is executed again with
+ *           ::HTTPAPIEX_ExecuteRequest, so it gets the usual retry behaviour.
+ *
+ * @return   @c HTTPAPIEX_OK if all requests succeeded, otherwise the result of the
+ *           first request that failed.
+ */
+MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, HTTPAPIEX_ExecuteBatch, HTTPAPIEX_HANDLE, handle, HTTPAPIEX_BATCH_REQUEST*, requests, size_t, requestCount);
+
 /**
  * @brief    Frees all resources used by the @c HTTPAPIEX_HANDLE object.
  *
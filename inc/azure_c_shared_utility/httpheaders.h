@@ -15,6 +15,12 @@
 *                  of all the headers
 *                - ::HTTPHeaders_GetHeader - when the application needs to retrieve the
 *                  <code>name + ": " + value</code> string based on an index.
+*                - ::HTTPHeaders_GetHeaderNameValue - when the application needs the name and
+*                  the value of a header based on an index, without a copy.
+*                - ::HTTPHeaders_SerializeTo - when the application needs all the headers
+*                  written in a buffer it provides, as they appear in a HTTP message.
+*
+*             Header names are compared without regard to case.
 */
 
 #ifndef HTTPHEADERS_H
@@ -138,6 +144,42 @@ MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_GetHeaderCount, HTTP_HEADER
  */
 MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_GetHeader, HTTP_HEADERS_HANDLE, handle, size_t, index, char**, destination);
 
+/**
+ * @brief    This API retrieves the name and the value of the header element at
+ *             the given @p index without copying them.
+ *
+ * @param    handle            A valid @c HTTP_HEADERS_HANDLE value.
+ * @param    index            Zero-based index of the item in the
+ *                             headers collection.
+ * @param    name            Receives the name of the header.
+ * @param    value            Receives the value of the header.
+ *
+ *            Both strings are owned by @p handle and stay valid until the
+ *            headers are changed or freed.
+ *
+ * @return    Returns @c HTTP_HEADERS_OK when execution is successful or
+ *             @c HTTP_HEADERS_INVALID_ARG when an argument is not valid.
+ */
+MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_GetHeaderNameValue, HTTP_HEADERS_HANDLE, handle, size_t, index, const char**, name, const char**, value);
+
+/**
+ * @brief    This API writes every header as name+": "+value+"\r\n", in the order the
+ *             headers were added, in a buffer provided by the caller.
+ *
+ * @param    httpHeadersHandle    A valid @c HTTP_HEADERS_HANDLE value.
+ * @param    buffer                The destination of the headers, which are not
+ *                                 terminated by a '\0'. Can be @c NULL when
+ *                                 @p bufferSize is @c 0.
+ * @param    bufferSize            The size of @p buffer.
+ * @param    serializedSize        Receives the number of bytes the headers take,
+ *                                 also when @p buffer is too small.
+ *
+ * @return    Returns @c HTTP_HEADERS_OK when the headers were written,
+ *             @c HTTP_HEADERS_INSUFFICIENT_BUFFER when @p bufferSize is smaller than
+ *             @p *serializedSize or @c HTTP_HEADERS_INVALID_ARG.
+ */
+MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_SerializeTo, HTTP_HEADERS_HANDLE, httpHeadersHandle, char*, buffer, size_t, bufferSize, size_t*, serializedSize);
+
 /**
  * @brief    This API produces a clone of the @p handle parameter.
  *
@@ -48,6 +48,22 @@ extern "C"
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_DOMAIN_SOCKET = "DOMAIN_SOCKET";
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_IP_SOCKET = "IP_SOCKET";
 
+    // Value is a pointer to a bool. When true, the socket is serviced by the process-wide event loop driven by socketio_dowork_all.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_USE_EVENT_LOOP = "use_event_loop";
+
+    // Value is a pointer to a size_t, the largest buffer socketio grows its receive buffer to while data keeps arriving faster than it is read.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE = "receive_buffer_size";
+
+    // Values are pointers to an int, given to setsockopt for the socket and for every socket created when the IO is opened again.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_SO_RCVBUF = "so_rcvbuf";
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_SO_SNDBUF = "so_sndbuf";
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_TCP_NODELAY = "tcp_nodelay";
+    // Only supported on Linux. The kernel leaves quick ack mode on its own, so socketio sets it again after each read.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_TCP_QUICKACK = "tcp_quickack";
+
+    // Value is a pointer to a UWS_PERMESSAGE_DEFLATE_CONFIG, NULL stops offering the extension. Needs the use_permessage_deflate build option.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_PERMESSAGE_DEFLATE = "permessage_deflate";
+
 #ifdef __cplusplus
 }
 #endif
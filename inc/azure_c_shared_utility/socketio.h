@@ -35,11 +35,18 @@ MOCKABLE_FUNCTION(, void, socketio_destroy, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_open, CONCRETE_IO_HANDLE, socket_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, socketio_close, CONCRETE_IO_HANDLE, socket_io, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, socketio_send, CONCRETE_IO_HANDLE, socket_io, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, socketio_send_vectored, CONCRETE_IO_HANDLE, socket_io, const CONSTBUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, socketio_dowork, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_setoption, CONCRETE_IO_HANDLE, socket_io, const char*, optionName, const void*, value);
 
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, socketio_get_interface_description);
 
+/* Services every socketio instance opened with OPTION_SOCKETIO_USE_EVENT_LOOP that is ready for reading or writing,
+   waiting at most timeout_ms for one to become ready, and advances those still opening. The wait is shortened while
+   one is opening, as its lookup and connection attempts are polled. Returns 0 on success and a non-zero value on failure.
+   Only available in socketio implementations that support an event loop (socketio_berkeley on Linux). */
+MOCKABLE_FUNCTION(, int, socketio_dowork_all, unsigned int, timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SOCKETIO_URING_H
+#define SOCKETIO_URING_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#endif /* __cplusplus */
+
+/* socketio_uring connects, closes and keeps its options through socketio_berkeley and moves the data of the open
+   connection through io_uring: queued sends are gathered in one sendmsg and received data comes from a multishot recv
+   into buffers registered with the kernel. It is only built when the use_io_uring CMake option is ON, in which case
+   socketio_get_interface_description returns it whenever socketio_uring_is_supported is true.
+   socketio_uring_create takes the same SOCKETIO_CONFIG as socketio_create. */
+
+MOCKABLE_FUNCTION(, bool, socketio_uring_is_supported);
+
+MOCKABLE_FUNCTION(, CONCRETE_IO_HANDLE, socketio_uring_create, void*, io_create_parameters);
+MOCKABLE_FUNCTION(, void, socketio_uring_destroy, CONCRETE_IO_HANDLE, socket_io);
+MOCKABLE_FUNCTION(, int, socketio_uring_open, CONCRETE_IO_HANDLE, socket_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
+MOCKABLE_FUNCTION(, int, socketio_uring_close, CONCRETE_IO_HANDLE, socket_io, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, socketio_uring_send, CONCRETE_IO_HANDLE, socket_io, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, socketio_uring_send_vectored, CONCRETE_IO_HANDLE, socket_io, const CONSTBUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, void, socketio_uring_dowork, CONCRETE_IO_HANDLE, socket_io);
+MOCKABLE_FUNCTION(, int, socketio_uring_setoption, CONCRETE_IO_HANDLE, socket_io, const char*, optionName, const void*, value);
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, socketio_uring_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SOCKETIO_URING_H */
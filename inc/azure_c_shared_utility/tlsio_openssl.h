@@ -14,6 +14,15 @@ extern "C" {
 #include <stddef.h>
 #endif /* __cplusplus */
 
+/* counters of the process wide SSL_CTX cache and of the TLS sessions resumed through it */
+typedef struct TLSIO_OPENSSL_CACHE_STATISTICS_TAG
+{
+    size_t context_hits;
+    size_t context_misses;
+    size_t session_hits;
+    size_t session_misses;
+} TLSIO_OPENSSL_CACHE_STATISTICS;
+
 MOCKABLE_FUNCTION(, int, tlsio_openssl_init);
 MOCKABLE_FUNCTION(, void, tlsio_openssl_deinit);
 
@@ -26,6 +35,7 @@ MOCKABLE_FUNCTION(, void, tlsio_openssl_dowork, CONCRETE_IO_HANDLE, tls_io);
 MOCKABLE_FUNCTION(, int, tlsio_openssl_setoption, CONCRETE_IO_HANDLE, tls_io, const char*, optionName, const void*, value);
 
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, tlsio_openssl_get_interface_description);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_get_cache_statistics, TLSIO_OPENSSL_CACHE_STATISTICS*, statistics);
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,7 @@
 #include "xio.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/uws_permessage_deflate.h"
 
 #ifdef __cplusplus
 #include <cstddef>
@@ -88,6 +89,8 @@ DEFINE_ENUM(WS_ERROR, WS_ERROR_VALUES);
 #define CLOSE_RESERVED_1015                 1015
 
 typedef void(*ON_WS_FRAME_RECEIVED)(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size);
+/* A slice of a data message: message_offset is the position of buffer[0] in the (decompressed) message and is_final is set on the last slice of the message */
+typedef void(*ON_WS_FRAGMENT_RECEIVED)(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size, uint64_t message_offset, bool is_final);
 typedef void(*ON_WS_SEND_FRAME_COMPLETE)(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result);
 typedef void(*ON_WS_OPEN_COMPLETE)(void* context, WS_OPEN_RESULT ws_open_result);
 typedef void(*ON_WS_CLOSE_COMPLETE)(void* context);
@@ -110,6 +113,8 @@ MOCKABLE_FUNCTION(, void, uws_client_dowork, UWS_CLIENT_HANDLE, uws_client);
 MOCKABLE_FUNCTION(, int, uws_client_set_request_header, UWS_CLIENT_HANDLE, uws_client, const char*, name, const char*, value);
 MOCKABLE_FUNCTION(, int, uws_client_set_option, UWS_CLIENT_HANDLE, uws_client, const char*, option_name, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, uws_client_retrieve_options, UWS_CLIENT_HANDLE, uws_client);
+MOCKABLE_FUNCTION(, int, uws_client_set_fragment_received_callback, UWS_CLIENT_HANDLE, uws_client, ON_WS_FRAGMENT_RECEIVED, on_ws_fragment_received, void*, on_ws_fragment_received_context);
+MOCKABLE_FUNCTION(, int, uws_client_get_permessage_deflate_statistics, UWS_CLIENT_HANDLE, uws_client, UWS_PERMESSAGE_DEFLATE_STATISTICS*, statistics);
 
 #ifdef __cplusplus
 }
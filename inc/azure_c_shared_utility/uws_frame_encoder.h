@@ -20,6 +20,9 @@ extern "C" {
 #define RESERVED_2  0x02
 #define RESERVED_3  0x01
 
+/* 2 bytes of opcode and length, 8 bytes of extended payload length and 4 bytes of masking key */
+#define UWS_FRAME_ENCODER_MAX_HEADER_SIZE 14
+
 #define WS_FRAME_TYPE_VALUES \
     WS_CONTINUATION_FRAME, \
     WS_TEXT_FRAME, \
@@ -41,6 +44,8 @@ extern "C" {
 DEFINE_ENUM(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
 
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, uws_frame_encoder_encode, WS_FRAME_TYPE, opcode, const unsigned char*, payload, size_t, length, bool, is_masked, bool, is_final, unsigned char, reserved);
+MOCKABLE_FUNCTION(, size_t, uws_frame_encoder_encode_header, unsigned char*, header, WS_FRAME_TYPE, opcode, size_t, length, bool, is_masked, bool, is_final, unsigned char, reserved);
+MOCKABLE_FUNCTION(, void, uws_frame_encoder_mask_payload, unsigned char*, destination, const unsigned char*, payload, size_t, length, const unsigned char*, masking_key);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UWS_PERMESSAGE_DEFLATE_H
+#define UWS_PERMESSAGE_DEFLATE_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/* uws_permessage_deflate implements the permessage-deflate WebSocket extension (RFC 7692) with one streaming zlib
+context per direction. It is only built when the use_permessage_deflate CMake option is ON. */
+
+typedef struct UWS_PERMESSAGE_DEFLATE_INSTANCE_TAG* UWS_PERMESSAGE_DEFLATE_HANDLE;
+
+typedef struct UWS_PERMESSAGE_DEFLATE_CONFIG_TAG
+{
+    /* reset the compression context after each sent message, trading ratio for the memory of the context */
+    bool client_no_context_takeover;
+    /* ask the server to reset its compression context after each message */
+    bool server_no_context_takeover;
+    /* 0 does not limit the server window, otherwise 8 to 15 */
+    int server_max_window_bits;
+    /* 0 selects the zlib default level, otherwise 1 to 9 */
+    int compression_level;
+    /* messages shorter than this are sent uncompressed */
+    size_t min_compressed_message_size;
+} UWS_PERMESSAGE_DEFLATE_CONFIG;
+
+typedef struct UWS_PERMESSAGE_DEFLATE_STATISTICS_TAG
+{
+    uint64_t sent_uncompressed_bytes;
+    uint64_t sent_compressed_bytes;
+    uint64_t received_compressed_bytes;
+    uint64_t received_uncompressed_bytes;
+    /* processor time spent in deflate and inflate */
+    uint64_t compress_time_us;
+    uint64_t decompress_time_us;
+} UWS_PERMESSAGE_DEFLATE_STATISTICS;
+
+MOCKABLE_FUNCTION(, UWS_PERMESSAGE_DEFLATE_HANDLE, uws_permessage_deflate_create, const UWS_PERMESSAGE_DEFLATE_CONFIG*, config);
+MOCKABLE_FUNCTION(, void, uws_permessage_deflate_destroy, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate);
+MOCKABLE_FUNCTION(, const char*, uws_permessage_deflate_get_offer, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate);
+MOCKABLE_FUNCTION(, int, uws_permessage_deflate_accept_response, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate, const char*, extensions);
+MOCKABLE_FUNCTION(, void, uws_permessage_deflate_reset, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate);
+MOCKABLE_FUNCTION(, bool, uws_permessage_deflate_is_negotiated, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate);
+MOCKABLE_FUNCTION(, bool, uws_permessage_deflate_should_compress, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate, size_t, size, bool, is_final);
+MOCKABLE_FUNCTION(, int, uws_permessage_deflate_compress, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate, const unsigned char*, payload, size_t, size, bool, is_final, const unsigned char**, compressed_payload, size_t*, compressed_size);
+MOCKABLE_FUNCTION(, int, uws_permessage_deflate_decompress, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate, const unsigned char*, payload, size_t, size, bool, is_final, const unsigned char**, decompressed_payload, size_t*, decompressed_size);
+MOCKABLE_FUNCTION(, int, uws_permessage_deflate_get_statistics, UWS_PERMESSAGE_DEFLATE_HANDLE, permessage_deflate, UWS_PERMESSAGE_DEFLATE_STATISTICS*, statistics);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UWS_PERMESSAGE_DEFLATE_H */
@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 // This file is OS-specific, and is identified by setting include directories
 // in the project
@@ -14,64 +15,588 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
 
-// EXTRACT_IPV4 pulls the uint32_t IPv4 address out of an addrinfo struct
-// This will not be needed for the asynchronous design
-#ifdef WIN32_NOT_USED
-//#define EXTRACT_IPV4(ptr) ((struct sockaddr_in *) ptr->ai_addr)->sin_addr.S_un.S_addr
+#if defined(_MSC_VER)
+#include <windows.h>
+#define DNS_ASYNC_YIELD() (void)SwitchToThread()
+#define DNS_ASYNC_SPIN_TRY_ACQUIRE(lock) (InterlockedExchange(&(lock), 1) == 0)
+#define DNS_ASYNC_SPIN_RELEASE(lock) (void)InterlockedExchange(&(lock), 0)
+typedef LONG DNS_ASYNC_SPIN_LOCK;
+#elif defined(__GNUC__)
+#include <sched.h>
+#define DNS_ASYNC_YIELD() (void)sched_yield()
+#define DNS_ASYNC_SPIN_TRY_ACQUIRE(lock) (__sync_lock_test_and_set(&(lock), 1) == 0)
+#define DNS_ASYNC_SPIN_RELEASE(lock) __sync_lock_release(&(lock))
+typedef int DNS_ASYNC_SPIN_LOCK;
 #else
-// The default definition handles lwIP. Please add comments for other systems tested.
-#define EXTRACT_IPV4(ptr) ((struct sockaddr_in *) ptr->ai_addr)->sin_addr.s_addr
+#error dns_async needs atomic operations, which are only wired for gcc compatible compilers and MSVC
 #endif
 
-typedef struct
+typedef enum DNS_ASYNC_LOOKUP_STATE_TAG
+{
+    DNS_ASYNC_LOOKUP_STATE_PENDING,
+    DNS_ASYNC_LOOKUP_STATE_SUCCEEDED,
+    DNS_ASYNC_LOOKUP_STATE_FAILED
+} DNS_ASYNC_LOOKUP_STATE;
+
+/* One lookup of a hostname, shared by every DNS_ASYNC_INSTANCE created for that hostname while it is
+   in progress or cached. All fields but hostname are guarded by dns_async_cache_lock; the results are
+   not modified anymore once the state has left DNS_ASYNC_LOOKUP_STATE_PENDING. A pending lookup that is
+   not claimed waits in the cache for a worker thread. */
+typedef struct DNS_ASYNC_CACHE_ENTRY_TAG
 {
     char* hostname;
-    uint32_t ip_v4;
+    DNS_ASYNC_LOOKUP_STATE state;
+    DNS_ASYNC_ADDRESS* addresses;
+    size_t address_count;
+    uint32_t cache_ttl_seconds;
+    uint32_t negative_cache_ttl_seconds;
+    tickcounter_ms_t completion_ms;
+    bool is_claimed;
+    bool is_cached;
+    size_t ref_count;
+    struct DNS_ASYNC_CACHE_ENTRY_TAG* next;
+} DNS_ASYNC_CACHE_ENTRY;
+
+typedef struct DNS_ASYNC_INSTANCE_TAG
+{
+    DNS_ASYNC_CACHE_ENTRY* entry;
     bool is_complete;
-    bool is_failed;
 } DNS_ASYNC_INSTANCE;
 
+/* A worker thread performs lookups until none is left waiting and then exits, rather than wait for more
+   on a condition, since the condition module is optional. dns_async_create starts it again when needed. */
+typedef struct DNS_ASYNC_WORKER_TAG
+{
+    THREAD_HANDLE thread;
+    bool is_running;
+    DNS_ASYNC_CACHE_ENTRY* first_entry;
+} DNS_ASYNC_WORKER;
+
+/* serializes dns_async_init and dns_async_deinit, which cannot use dns_async_cache_lock since they create it */
+static DNS_ASYNC_SPIN_LOCK dns_async_init_lock = 0;
+static LOCK_HANDLE dns_async_cache_lock = NULL;
+static TICK_COUNTER_HANDLE dns_async_tick_counter = NULL;
+static DNS_ASYNC_CACHE_ENTRY* dns_async_cache = NULL;
+static DNS_ASYNC_WORKER dns_async_workers[DNS_ASYNC_MAX_WORKER_THREADS];
+
+static void destroy_cache_entry(DNS_ASYNC_CACHE_ENTRY* entry)
+{
+    if (entry->addresses != NULL)
+    {
+        free(entry->addresses);
+    }
+    free(entry->hostname);
+    free(entry);
+}
+
+static void join_worker(DNS_ASYNC_WORKER* worker)
+{
+    if (worker->thread != NULL)
+    {
+        int thread_result;
+        if (ThreadAPI_Join(worker->thread, &thread_result) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Join failed for a lookup worker thread");
+        }
+        worker->thread = NULL;
+    }
+    worker->is_running = false;
+}
+
+static int resolve_addresses(const char* hostname, DNS_ASYNC_ADDRESS** addresses, size_t* address_count)
+{
+    int result;
+    struct addrinfo *addrInfo = NULL;
+    struct addrinfo *ptr = NULL;
+    struct addrinfo hints;
+    int getAddrResult;
+
+    *addresses = NULL;
+    *address_count = 0;
+
+    //--------------------------------
+    // Setup the hints address info structure
+    // which is passed to the getaddrinfo() function
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    getAddrResult = getaddrinfo(hostname, NULL, &hints, &addrInfo);
+    if (getAddrResult != 0)
+    {
+        LogInfo("Failed DNS lookup for %s: %d", hostname, getAddrResult);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t count = 0;
+        for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
+        {
+            if (ptr->ai_family == AF_INET || ptr->ai_family == AF_INET6)
+            {
+                count++;
+            }
+        }
+
+        if (count == 0)
+        {
+            LogInfo("DNS lookup for %s returned no IP address", hostname);
+            result = __FAILURE__;
+        }
+        else if ((*addresses = (DNS_ASYNC_ADDRESS*)malloc(count * sizeof(DNS_ASYNC_ADDRESS))) == NULL)
+        {
+            LogError("malloc addresses failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_DNS_ASYNC_30_018: [ Otherwise dns_async_create shall start a new lookup of both the IPv4 and IPv6 addresses of hostname on a worker thread created with ThreadAPI_Create. ]*/
+            for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
+            {
+                DNS_ASYNC_ADDRESS* address = &(*addresses)[*address_count];
+                if (ptr->ai_family == AF_INET)
+                {
+                    memset(address, 0, sizeof(DNS_ASYNC_ADDRESS));
+                    address->type = DNS_ASYNC_ADDRESS_TYPE_IPV4;
+                    (void)memcpy(address->address, &((struct sockaddr_in*)ptr->ai_addr)->sin_addr, 4);
+                    (*address_count)++;
+                }
+                else if (ptr->ai_family == AF_INET6)
+                {
+                    memset(address, 0, sizeof(DNS_ASYNC_ADDRESS));
+                    address->type = DNS_ASYNC_ADDRESS_TYPE_IPV6;
+                    (void)memcpy(address->address, &((struct sockaddr_in6*)ptr->ai_addr)->sin6_addr, 16);
+                    address->scope_id = ((struct sockaddr_in6*)ptr->ai_addr)->sin6_scope_id;
+                    (*address_count)++;
+                }
+            }
+            result = 0;
+        }
+
+        freeaddrinfo(addrInfo);
+    }
+
+    return result;
+}
+
+/* must be called with dns_async_cache_lock held */
+static void complete_lookup(DNS_ASYNC_CACHE_ENTRY* entry, int resolve_result, DNS_ASYNC_ADDRESS* addresses, size_t address_count)
+{
+    /* Codes_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    if (tickcounter_get_current_ms(dns_async_tick_counter, &entry->completion_ms) != 0)
+    {
+        LogError("tickcounter_get_current_ms failed, the lookup of %s is not reused", entry->hostname);
+        entry->cache_ttl_seconds = 0;
+        entry->negative_cache_ttl_seconds = 0;
+    }
+
+    if (resolve_result == 0)
+    {
+        entry->addresses = addresses;
+        entry->address_count = address_count;
+        entry->state = DNS_ASYNC_LOOKUP_STATE_SUCCEEDED;
+    }
+    else
+    {
+        entry->state = DNS_ASYNC_LOOKUP_STATE_FAILED;
+    }
+}
+
+static bool is_entry_expired(const DNS_ASYNC_CACHE_ENTRY* entry, tickcounter_ms_t now_ms)
+{
+    uint32_t ttl_seconds = (entry->state == DNS_ASYNC_LOOKUP_STATE_SUCCEEDED) ? entry->cache_ttl_seconds : entry->negative_cache_ttl_seconds;
+
+    // the unsigned difference stays right when the tick counter wraps around
+    return ((tickcounter_ms_t)(now_ms - entry->completion_ms) / 1000) >= ttl_seconds;
+}
+
+/* must be called with dns_async_cache_lock held, returns the oldest pending lookup no thread performs yet */
+static DNS_ASYNC_CACHE_ENTRY* claim_waiting_entry(void)
+{
+    DNS_ASYNC_CACHE_ENTRY* result = NULL;
+    DNS_ASYNC_CACHE_ENTRY* entry;
+
+    // new lookups are inserted at the head of the cache, so the last one found is the oldest
+    for (entry = dns_async_cache; entry != NULL; entry = entry->next)
+    {
+        if (entry->state == DNS_ASYNC_LOOKUP_STATE_PENDING && !entry->is_claimed)
+        {
+            result = entry;
+        }
+    }
+
+    if (result != NULL)
+    {
+        result->is_claimed = true;
+    }
+
+    return result;
+}
+
+static int lookup_worker_thread(void* context)
+{
+    DNS_ASYNC_WORKER* worker = (DNS_ASYNC_WORKER*)context;
+    DNS_ASYNC_CACHE_ENTRY* entry = worker->first_entry;
+
+    /* Codes_SRS_DNS_ASYNC_30_027: [ A worker thread shall perform the lookups waiting in the cache, oldest first, and exit when none is left. ]*/
+    while (entry != NULL)
+    {
+        DNS_ASYNC_ADDRESS* addresses;
+        size_t address_count;
+        int resolve_result = resolve_addresses(entry->hostname, &addresses, &address_count);
+
+        if (Lock(dns_async_cache_lock) != LOCK_OK)
+        {
+            LogError("Lock failed, the lookup of %s is abandoned", entry->hostname);
+            if (addresses != NULL)
+            {
+                free(addresses);
+            }
+            entry = NULL;
+        }
+        else
+        {
+            complete_lookup(entry, resolve_result, addresses, address_count);
+            entry = claim_waiting_entry();
+            if (entry == NULL)
+            {
+                worker->is_running = false;
+            }
+            (void)Unlock(dns_async_cache_lock);
+        }
+    }
+
+    return 0;
+}
+
+/* must be called with dns_async_cache_lock held, returns a non-zero value when the caller has to perform the lookup */
+static int start_lookup(DNS_ASYNC_CACHE_ENTRY* entry)
+{
+    int result;
+    DNS_ASYNC_WORKER* worker = NULL;
+    bool is_any_worker_running = false;
+    size_t i;
+
+    for (i = 0; i < DNS_ASYNC_MAX_WORKER_THREADS; i++)
+    {
+        if (dns_async_workers[i].is_running)
+        {
+            is_any_worker_running = true;
+        }
+        else if (worker == NULL)
+        {
+            worker = &dns_async_workers[i];
+        }
+    }
+
+    if (worker == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_028: [ If DNS_ASYNC_MAX_WORKER_THREADS worker threads are running, dns_async_create shall leave the lookup waiting in the cache for the first of them that is done. ]*/
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_30_025: [ A worker thread that has exited shall be joined before another one is started in its place. ]*/
+        join_worker(worker);
+
+        /* Codes_SRS_DNS_ASYNC_30_018: [ Otherwise dns_async_create shall start a new lookup of both the IPv4 and IPv6 addresses of hostname on a worker thread created with ThreadAPI_Create. ]*/
+        entry->is_claimed = true;
+        worker->first_entry = entry;
+        worker->is_running = true;
+        if (ThreadAPI_Create(&worker->thread, lookup_worker_thread, worker) == THREADAPI_OK)
+        {
+            result = 0;
+        }
+        else
+        {
+            worker->thread = NULL;
+            worker->is_running = false;
+            worker->first_entry = NULL;
+            if (is_any_worker_running)
+            {
+                /* Codes_SRS_DNS_ASYNC_30_029: [ If ThreadAPI_Create fails while another worker thread is running, dns_async_create shall leave the lookup waiting in the cache for it. ]*/
+                LogInfo("ThreadAPI_Create failed, the lookup of %s waits for a running worker thread", entry->hostname);
+                entry->is_claimed = false;
+                result = 0;
+            }
+            else
+            {
+                /* Codes_SRS_DNS_ASYNC_30_019: [ If ThreadAPI_Create fails and no worker thread is running, dns_async_create shall perform the lookup before returning. ]*/
+                LogInfo("ThreadAPI_Create failed, looking up %s synchronously", entry->hostname);
+                result = __FAILURE__;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* must be called with dns_async_cache_lock held */
+static void evict_expired_entries(void)
+{
+    DNS_ASYNC_CACHE_ENTRY** link = &dns_async_cache;
+    tickcounter_ms_t now_ms;
+    bool is_time_known = (tickcounter_get_current_ms(dns_async_tick_counter, &now_ms) == 0);
+
+    if (!is_time_known)
+    {
+        LogError("tickcounter_get_current_ms failed, all completed lookups are removed from the cache");
+    }
+
+    while (*link != NULL)
+    {
+        DNS_ASYNC_CACHE_ENTRY* entry = *link;
+        if (entry->state == DNS_ASYNC_LOOKUP_STATE_PENDING)
+        {
+            link = &entry->next;
+        }
+        else
+        {
+            if (is_time_known && !is_entry_expired(entry, now_ms))
+            {
+                link = &entry->next;
+            }
+            else
+            {
+                /* Codes_SRS_DNS_ASYNC_30_016: [ dns_async_create shall remove from the cache the completed lookups whose time to live has elapsed. ]*/
+                *link = entry->next;
+                entry->is_cached = false;
+                if (entry->ref_count == 0)
+                {
+                    destroy_cache_entry(entry);
+                }
+            }
+        }
+    }
+}
+
+static DNS_ASYNC_CACHE_ENTRY* create_cache_entry(const char* hostname, const DNS_ASYNC_OPTIONS* options)
+{
+    DNS_ASYNC_CACHE_ENTRY* result = (DNS_ASYNC_CACHE_ENTRY*)malloc(sizeof(DNS_ASYNC_CACHE_ENTRY));
+    if (result == NULL)
+    {
+        LogError("malloc cache entry failed");
+    }
+    else
+    {
+        memset(result, 0, sizeof(DNS_ASYNC_CACHE_ENTRY));
+        /* Codes_SRS_DNS_ASYNC_30_010: [ dns_async_create shall make a copy of the hostname parameter to allow immediate deletion by the caller. ]*/
+        if (mallocAndStrcpy_s(&result->hostname, hostname) != 0)
+        {
+            LogError("mallocAndStrcpy_s hostname failed");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->state = DNS_ASYNC_LOOKUP_STATE_PENDING;
+            if (options == NULL)
+            {
+                /* Codes_SRS_DNS_ASYNC_30_012: [ If the options parameter is NULL, dns_async_create shall use DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS and DNS_ASYNC_DEFAULT_NEGATIVE_CACHE_TTL_SECONDS. ]*/
+                result->cache_ttl_seconds = DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS;
+                result->negative_cache_ttl_seconds = DNS_ASYNC_DEFAULT_NEGATIVE_CACHE_TTL_SECONDS;
+            }
+            else
+            {
+                result->cache_ttl_seconds = options->cache_ttl_seconds;
+                result->negative_cache_ttl_seconds = options->negative_cache_ttl_seconds;
+            }
+        }
+    }
+
+    return result;
+}
+
+int dns_async_init(void)
+{
+    int result;
+
+    /* Codes_SRS_DNS_ASYNC_30_065: [ dns_async_init shall create the cache only once when it is called from several threads at once. ]*/
+    while (!DNS_ASYNC_SPIN_TRY_ACQUIRE(dns_async_init_lock))
+    {
+        DNS_ASYNC_YIELD();
+    }
+
+    if (dns_async_cache_lock != NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_061: [ If the cache already exists, dns_async_init shall do nothing and return 0. ]*/
+        result = 0;
+    }
+    /* Codes_SRS_DNS_ASYNC_30_060: [ dns_async_init shall create the lock guarding the cache shared by all lookups. ]*/
+    else if ((dns_async_cache_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_062: [ If Lock_Init fails, dns_async_init shall log an error and return a non-zero value. ]*/
+        LogError("Lock_Init failed");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_DNS_ASYNC_30_063: [ dns_async_init shall create the tick counter measuring the time to live of the cached lookups. ]*/
+    else if ((dns_async_tick_counter = tickcounter_create()) == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_064: [ If tickcounter_create fails, dns_async_init shall destroy the lock, log an error and return a non-zero value. ]*/
+        LogError("tickcounter_create failed");
+        (void)Lock_Deinit(dns_async_cache_lock);
+        dns_async_cache_lock = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        dns_async_cache = NULL;
+        memset(dns_async_workers, 0, sizeof(dns_async_workers));
+        result = 0;
+    }
+
+    DNS_ASYNC_SPIN_RELEASE(dns_async_init_lock);
+
+    return result;
+}
+
+void dns_async_deinit(void)
+{
+    while (!DNS_ASYNC_SPIN_TRY_ACQUIRE(dns_async_init_lock))
+    {
+        DNS_ASYNC_YIELD();
+    }
+
+    if (dns_async_cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_070: [ If the cache does not exist, dns_async_deinit shall do nothing. ]*/
+        LogInfo("dns_async_deinit called without cache");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_DNS_ASYNC_30_071: [ dns_async_deinit shall wait for the lookups in progress and release all cached lookups. ]*/
+        for (i = 0; i < DNS_ASYNC_MAX_WORKER_THREADS; i++)
+        {
+            join_worker(&dns_async_workers[i]);
+        }
+
+        while (dns_async_cache != NULL)
+        {
+            DNS_ASYNC_CACHE_ENTRY* entry = dns_async_cache;
+            dns_async_cache = entry->next;
+
+            entry->is_cached = false;
+            if (entry->ref_count == 0)
+            {
+                destroy_cache_entry(entry);
+            }
+            else
+            {
+                LogError("dns_async_deinit called while a lookup of %s is not destroyed", entry->hostname);
+            }
+        }
+
+        /* Codes_SRS_DNS_ASYNC_30_072: [ dns_async_deinit shall destroy the tick counter and the lock guarding the cache. ]*/
+        tickcounter_destroy(dns_async_tick_counter);
+        dns_async_tick_counter = NULL;
+        (void)Lock_Deinit(dns_async_cache_lock);
+        dns_async_cache_lock = NULL;
+    }
+
+    DNS_ASYNC_SPIN_RELEASE(dns_async_init_lock);
+}
+
 DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* options)
 {
-    /* Codes_SRS_DNS_ASYNC_30_012: [ The optional options parameter shall be ignored. ]*/
     DNS_ASYNC_INSTANCE* result;
-    (void)options;
     if (hostname == NULL)
     {
         /* Codes_SRS_DNS_ASYNC_30_011: [ If the hostname parameter is NULL, dns_async_create shall log an error and return NULL. ]*/
         LogError("NULL hostname");
         result = NULL;
     }
+    /* Codes_SRS_DNS_ASYNC_30_015: [ dns_async_create shall call dns_async_init, which creates the cache if it does not exist. ]*/
+    else if (dns_async_init() != 0)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
+        LogError("dns_async_init failed");
+        result = NULL;
+    }
+    else if ((result = (DNS_ASYNC_INSTANCE*)malloc(sizeof(DNS_ASYNC_INSTANCE))) == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
+        LogError("malloc instance failed");
+    }
+    else if (Lock(dns_async_cache_lock) != LOCK_OK)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
+        LogError("Lock failed");
+        free(result);
+        result = NULL;
+    }
     else
     {
-        result = malloc(sizeof(DNS_ASYNC_INSTANCE));
-        if (result == NULL)
+        DNS_ASYNC_CACHE_ENTRY* entry;
+        bool is_synchronous = false;
+
+        evict_expired_entries();
+
+        /* Codes_SRS_DNS_ASYNC_30_017: [ If the cache holds a lookup of hostname that is in progress or whose time to live has not elapsed, dns_async_create shall share it instead of starting a new lookup. ]*/
+        for (entry = dns_async_cache; entry != NULL; entry = entry->next)
+        {
+            if (strcmp(entry->hostname, hostname) == 0)
+            {
+                break;
+            }
+        }
+
+        if (entry == NULL && (entry = create_cache_entry(hostname, options)) != NULL)
+        {
+            is_synchronous = (start_lookup(entry) != 0);
+            entry->is_cached = true;
+            entry->next = dns_async_cache;
+            dns_async_cache = entry;
+        }
+
+        if (entry == NULL)
         {
             /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
-            LogError("malloc instance failed");
+            free(result);
             result = NULL;
         }
         else
         {
-            int ms_result;
+            entry->ref_count++;
+            result->entry = entry;
             result->is_complete = false;
-            result->is_failed = false;
-            result->ip_v4 = 0;
-            /* Codes_SRS_DNS_ASYNC_30_010: [ dns_async_create shall make a copy of the hostname parameter to allow immediate deletion by the caller. ]*/
-            ms_result = mallocAndStrcpy_s(&result->hostname, hostname);
-            if (ms_result != 0)
+        }
+
+        (void)Unlock(dns_async_cache_lock);
+
+        if (is_synchronous)
+        {
+            DNS_ASYNC_ADDRESS* addresses;
+            size_t address_count;
+            int resolve_result = resolve_addresses(entry->hostname, &addresses, &address_count);
+
+            if (Lock(dns_async_cache_lock) != LOCK_OK)
+            {
+                LogError("Lock failed");
+                if (addresses != NULL)
+                {
+                    free(addresses);
+                }
+            }
+            else
             {
-                /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
-                free(result);
-                result = NULL;
+                complete_lookup(entry, resolve_result, addresses, address_count);
+                (void)Unlock(dns_async_cache_lock);
             }
         }
     }
+
+    /* Codes_SRS_DNS_ASYNC_30_013: [ On success, dns_async_create shall return the created DNS_ASYNC_HANDLE. ]*/
     return result;
 }
 
-/* Codes_SRS_DNS_ASYNC_30_021: [ dns_async_is_create_complete shall perform the asynchronous work of DNS lookup and log any errors. ]*/
+/* Codes_SRS_DNS_ASYNC_30_021: [ dns_async_is_create_complete shall check the state of the lookup shared through the cache and log any errors. ]*/
 bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
 {
     DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
@@ -83,67 +608,30 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
         LogError("NULL dns");
         result = false;
     }
+    else if (dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_024: [ If dns_async_is_create_complete has previously returned true, dns_async_is_create_complete shall do nothing and return true. ]*/
+        result = true;
+    }
+    else if (Lock(dns_async_cache_lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = false;
+    }
     else
     {
-        if (dns->is_complete)
+        if (dns->entry->state == DNS_ASYNC_LOOKUP_STATE_PENDING)
         {
-            /* Codes_SRS_DNS_ASYNC_30_024: [ If dns_async_is_create_complete has previously returned true, dns_async_is_create_complete shall do nothing and return true. ]*/
-            result = true;
+            /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
+            result = false;
         }
         else
         {
-            struct addrinfo *addrInfo = NULL;
-            struct addrinfo *ptr = NULL;
-            struct addrinfo hints;
-            int getAddrResult;
-
-            /* Codes_SRS_DNS_ASYNC_30_021: [ dns_async_is_create_complete shall perform the asynchronous work of DNS lookup and log any errors. ]*/
-            // Only make one attempt at lookup for this
-            // synchronous implementation
-            dns->is_complete = true;
-
-            //--------------------------------
-            // Setup the hints address info structure
-            // which is passed to the getaddrinfo() function
-            memset(&hints, 0, sizeof(hints));
-            hints.ai_family = AF_INET;
-            hints.ai_socktype = SOCK_STREAM;
-            hints.ai_protocol = IPPROTO_TCP;
-
-            //--------------------------------
-            // Call getaddrinfo(). If the call succeeds,
-            // the result variable will hold a linked list
-            // of addrinfo structures containing response
-            // information
-            getAddrResult = getaddrinfo(dns->hostname, NULL, &hints, &addrInfo);
-            if (getAddrResult == 0)
-            {
-                // If we find the AF_INET address, use it as the return value
-                for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
-                {
-                    switch (ptr->ai_family)
-                    {
-                    case AF_INET:
-                        /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
-                        dns->ip_v4 = EXTRACT_IPV4(ptr);
-                        break;
-                    }
-                }
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                dns->is_failed = (dns->ip_v4 == 0);
-                freeaddrinfo(addrInfo);
-            }
-            else
-            {
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                LogInfo("Failed DNS lookup for %s: %d", dns->hostname, getAddrResult);
-                dns->is_failed = true;
-            }
-            // This synchronous implementation is incapable of being incomplete, so SRS_DNS_ASYNC_30_023 does not ever happen
-            /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
             /* Codes_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
+            dns->is_complete = true;
             result = true;
         }
+        (void)Unlock(dns_async_cache_lock);
     }
 
     return result;
@@ -159,8 +647,22 @@ void dns_async_destroy(DNS_ASYNC_HANDLE dns_in)
     }
     else
     {
+        if (Lock(dns_async_cache_lock) != LOCK_OK)
+        {
+            LogError("Lock failed, the lookup of %s is leaked", dns->entry->hostname);
+        }
+        else
+        {
+            /* Codes_SRS_DNS_ASYNC_30_052: [ dns_async_destroy shall release the shared lookup when neither the cache nor another DNS_ASYNC_HANDLE use it. ]*/
+            dns->entry->ref_count--;
+            if (dns->entry->ref_count == 0 && !dns->entry->is_cached)
+            {
+                destroy_cache_entry(dns->entry);
+            }
+            (void)Unlock(dns_async_cache_lock);
+        }
+
         /* Codes_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
-        free(dns->hostname);
         free(dns);
     }
 }
@@ -175,27 +677,82 @@ uint32_t dns_async_get_ipv4(DNS_ASYNC_HANDLE dns_in)
         LogError("NULL dns");
         result = 0;
     }
+    else if (!dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_031: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_ipv4 shall log an error and return 0. ]*/
+        LogError("dns_async_get_ipv4 when not complete");
+        result = 0;
+    }
     else
     {
-        if (dns->is_complete)
+        size_t i;
+
+        /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed or found no IPv4 address, dns_async_get_ipv4 shall return 0. ]*/
+        result = 0;
+        for (i = 0; i < dns->entry->address_count; i++)
         {
-            if (dns->is_failed)
+            if (dns->entry->addresses[i].type == DNS_ASYNC_ADDRESS_TYPE_IPV4)
             {
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                result = 0;
+                /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the first discovered IPv4 address. ]*/
+                (void)memcpy(&result, dns->entry->addresses[i].address, sizeof(result));
+                break;
             }
-            else
-            {
-                /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
-                result = dns->ip_v4;
-            }
-        }
-        else
-        {
-            /* Codes_SRS_DNS_ASYNC_30_031: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_ipv4 shall log an error and return 0. ]*/
-            LogError("dns_async_get_ipv4 when not complete");
-            result = 0;
         }
     }
     return result;
 }
+
+size_t dns_async_get_address_count(DNS_ASYNC_HANDLE dns_in)
+{
+    DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
+    size_t result;
+    if (dns == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_040: [ If the dns parameter is NULL, dns_async_get_address_count shall log an error and return 0. ]*/
+        LogError("NULL dns");
+        result = 0;
+    }
+    else if (!dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_041: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_address_count shall log an error and return 0. ]*/
+        LogError("dns_async_get_address_count when not complete");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_30_042: [ dns_async_get_address_count shall return the number of IPv4 and IPv6 addresses discovered, which is 0 if the lookup process has failed. ]*/
+        result = dns->entry->address_count;
+    }
+    return result;
+}
+
+int dns_async_get_address(DNS_ASYNC_HANDLE dns_in, size_t index, DNS_ASYNC_ADDRESS* address)
+{
+    DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
+    int result;
+    if (dns == NULL || address == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_045: [ If the dns or address parameter is NULL, dns_async_get_address shall log an error and return a non-zero value. ]*/
+        LogError("Invalid arguments: dns = %p, address = %p", dns, address);
+        result = __FAILURE__;
+    }
+    else if (!dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_046: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_address shall log an error and return a non-zero value. ]*/
+        LogError("dns_async_get_address when not complete");
+        result = __FAILURE__;
+    }
+    else if (index >= dns->entry->address_count)
+    {
+        /* Codes_SRS_DNS_ASYNC_30_047: [ If index is not lower than the number of addresses discovered, dns_async_get_address shall log an error and return a non-zero value. ]*/
+        LogError("Invalid index %lu, %lu addresses found", (unsigned long)index, (unsigned long)dns->entry->address_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_30_048: [ dns_async_get_address shall copy the address at index, in the order given by the resolver, and return 0. ]*/
+        *address = dns->entry->addresses[index];
+        result = 0;
+    }
+    return result;
+}
@@ -1,15 +1,21 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
-/** @file ssl_socket.h
- *    @brief     Implements socket creation for TLSIO adapters.
+/** @file dns_async.h
+ *    @brief     Implements asynchronous DNS lookup with a process-wide cache.
  */
 
 #ifndef AZURE_IOT_DNS_H
 #define AZURE_IOT_DNS_H
 
 #ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
 extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #endif
 
 #include "azure_c_shared_utility/macro_utils.h"
@@ -17,20 +23,64 @@ extern "C" {
 
     typedef void* DNS_ASYNC_HANDLE;
 
-    // If options are added in future, DNS_ASYNC_OPTIONS will become a struct containing the options
-    typedef void DNS_ASYNC_OPTIONS;
+    // Lifetimes used by dns_async_create when no options are given
+#define DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS             60
+#define DNS_ASYNC_DEFAULT_NEGATIVE_CACHE_TTL_SECONDS    10
+
+    // Lookups in progress at once, the others wait for one of the worker threads to be done
+#ifndef DNS_ASYNC_MAX_WORKER_THREADS
+#define DNS_ASYNC_MAX_WORKER_THREADS                    4
+#endif
+
+    typedef struct DNS_ASYNC_OPTIONS_TAG
+    {
+        // seconds a successful lookup is reused by later lookups of the same host, 0 disables reuse
+        uint32_t cache_ttl_seconds;
+        // seconds a failed lookup is reported to later lookups of the same host without asking the resolver again
+        uint32_t negative_cache_ttl_seconds;
+    } DNS_ASYNC_OPTIONS;
+
+#define DNS_ASYNC_ADDRESS_TYPE_VALUES \
+    DNS_ASYNC_ADDRESS_TYPE_IPV4, \
+    DNS_ASYNC_ADDRESS_TYPE_IPV6
+
+    DEFINE_ENUM(DNS_ASYNC_ADDRESS_TYPE, DNS_ASYNC_ADDRESS_TYPE_VALUES);
+
+    typedef struct DNS_ASYNC_ADDRESS_TAG
+    {
+        DNS_ASYNC_ADDRESS_TYPE type;
+        // network byte order, an IPv4 address only uses the first 4 bytes
+        unsigned char address[16];
+        // IPv6 scope of link-local addresses, 0 otherwise
+        uint32_t scope_id;
+    } DNS_ASYNC_ADDRESS;
+
+    /**
+    * @brief    Create the cache shared by all lookups. Called by dns_async_create, so it only has to be called
+    *           explicitly to report a failure early. Several threads may call it at once.
+    *
+    * @return    @c 0 on success.
+    */
+    MOCKABLE_FUNCTION(, int, dns_async_init);
+
+    /**
+    * @brief    Wait for the lookups still running and release the cache. All DNS_ASYNC_HANDLEs must be destroyed first.
+    */
+    MOCKABLE_FUNCTION(, void, dns_async_deinit);
 
     /**
     * @brief    Begin the process of an asynchronous DNS lookup.
     *
     * @param   hostname    The url of the host to look up.
     *
+    * @param   options     The cache lifetimes to use, or NULL for the defaults.
+    *
     * @return    @c The newly created DNS_ASYNC_HANDLE.
     */
     MOCKABLE_FUNCTION(, DNS_ASYNC_HANDLE, dns_async_create, const char*, hostname, DNS_ASYNC_OPTIONS*, options);
 
     /**
-    * @brief    Continue the lookup process and report its completion state. Must be polled repeatedly for completion.
+    * @brief    Report the completion state of the lookup. Must be polled repeatedly for completion.
     *
     * @param   dns    The DNS_ASYNC_HANDLE.
     *
@@ -39,7 +89,7 @@ extern "C" {
     MOCKABLE_FUNCTION(, bool, dns_async_is_lookup_complete, DNS_ASYNC_HANDLE, dns);
 
     /**
-    * @brief    Return the IPv4 of a completed lookup process. Call only after dns_async_is_lookup_complete indicates completion.
+    * @brief    Return the first IPv4 of a completed lookup process. Call only after dns_async_is_lookup_complete indicates completion.
     *
     * @param   dns    The DNS_ASYNC_HANDLE.
     *
@@ -47,6 +97,28 @@ extern "C" {
     */
     MOCKABLE_FUNCTION(, uint32_t, dns_async_get_ipv4, DNS_ASYNC_HANDLE, dns);
 
+    /**
+    * @brief    Return the number of IPv4 and IPv6 addresses found by a completed lookup process.
+    *
+    * @param   dns    The DNS_ASYNC_HANDLE.
+    *
+    * @return    @c The number of addresses. 0 indicates failure or not finished.
+    */
+    MOCKABLE_FUNCTION(, size_t, dns_async_get_address_count, DNS_ASYNC_HANDLE, dns);
+
+    /**
+    * @brief    Retrieve one of the addresses found by a completed lookup process, in the order given by the resolver.
+    *
+    * @param   dns        The DNS_ASYNC_HANDLE.
+    *
+    * @param   index      The index of the address, lower than dns_async_get_address_count.
+    *
+    * @param   address    Receives the address.
+    *
+    * @return    @c 0 on success.
+    */
+    MOCKABLE_FUNCTION(, int, dns_async_get_address, DNS_ASYNC_HANDLE, dns, size_t, index, DNS_ASYNC_ADDRESS*, address);
+
     /**
     * @brief    Destroy the module.
     *
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file socketio_berkeley.h
+ *    @brief     Gives the IO implementations layered on socketio_berkeley access to its socket and options.
+ */
+
+#ifndef SOCKETIO_BERKELEY_H
+#define SOCKETIO_BERKELEY_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+    * @brief    Return the connected socket of an open socketio_berkeley instance.
+    *
+    * @param   socket_io    The socketio_berkeley instance.
+    *
+    * @return    @c The socket, -1 when the instance is not open.
+    */
+    MOCKABLE_FUNCTION(, int, socketio_berkeley_get_socket, CONCRETE_IO_HANDLE, socket_io);
+
+    /**
+    * @brief    Retrieve the options of a socketio_berkeley instance for an IO that forwards them to socketio_setoption.
+    *
+    * @param   socket_io     The socketio_berkeley instance.
+    *
+    * @param   set_option    The setoption of the IO the options are given back to by OptionHandler_FeedOptions.
+    *
+    * @return    @c The options, NULL on failure.
+    */
+    MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, socketio_berkeley_retrieve_options, CONCRETE_IO_HANDLE, socket_io, pfSetOption, set_option);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOCKETIO_BERKELEY_H */
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "azure_c_shared_utility/base64.h"
+
+/*measures base64 throughput for a SAS token sized input, a typical message and a large blob*/
+
+#define BYTES_PER_SIZE (256 * 1024 * 1024)
+
+static const size_t input_sizes[] = { 64, 4096, 1024 * 1024 };
+
+static double megabytes_per_second(clock_t start, clock_t end, size_t bytes)
+{
+    double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+    return (seconds > 0) ? ((double)bytes / (1024.0 * 1024.0) / seconds) : 0.0;
+}
+
+static int run_allocating(const unsigned char* input, size_t size, const char* encoded, size_t rounds)
+{
+    int result = 0;
+    size_t i;
+    clock_t start = clock();
+    clock_t end;
+    for (i = 0; i < rounds; i++)
+    {
+        STRING_HANDLE value = Base64_Encode_Bytes(input, size);
+        if (value == NULL)
+        {
+            (void)printf("Base64_Encode_Bytes failed\r\n");
+            result = __LINE__;
+            break;
+        }
+        STRING_delete(value);
+    }
+    end = clock();
+
+    if (result == 0)
+    {
+        (void)printf("%8lu bytes: Base64_Encode_Bytes %9.1f MB/s\r\n", (unsigned long)size, megabytes_per_second(start, end, rounds * size));
+
+        start = clock();
+        for (i = 0; i < rounds; i++)
+        {
+            BUFFER_HANDLE value = Base64_Decoder(encoded);
+            if (value == NULL)
+            {
+                (void)printf("Base64_Decoder failed\r\n");
+                result = __LINE__;
+                break;
+            }
+            BUFFER_delete(value);
+        }
+        end = clock();
+
+        if (result == 0)
+        {
+            (void)printf("%8lu bytes: Base64_Decoder      %9.1f MB/s\r\n", (unsigned long)size, megabytes_per_second(start, end, rounds * size));
+        }
+    }
+    return result;
+}
+
+static int run_into(const unsigned char* input, size_t size, char* encoded, size_t encoded_size, size_t rounds)
+{
+    int result = 0;
+    size_t encoded_length = 0;
+    size_t i;
+    clock_t start = clock();
+    clock_t end;
+    for (i = 0; i < rounds; i++)
+    {
+        if (Base64_Encode_Into(input, size, encoded, encoded_size, &encoded_length) != 0)
+        {
+            (void)printf("Base64_Encode_Into failed\r\n");
+            result = __LINE__;
+            break;
+        }
+    }
+    end = clock();
+
+    if (result == 0)
+    {
+        unsigned char* decoded;
+        (void)printf("%8lu bytes: Base64_Encode_Into  %9.1f MB/s\r\n", (unsigned long)size, megabytes_per_second(start, end, rounds * size));
+
+        if ((decoded = (unsigned char*)malloc(size)) == NULL)
+        {
+            (void)printf("malloc failed\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t decoded_length = 0;
+            start = clock();
+            for (i = 0; i < rounds; i++)
+            {
+                if (Base64_Decode_Into(encoded, encoded_length, decoded, size, &decoded_length) != 0)
+                {
+                    (void)printf("Base64_Decode_Into failed\r\n");
+                    result = __LINE__;
+                    break;
+                }
+            }
+            end = clock();
+
+            if (result == 0)
+            {
+                if ((decoded_length != size) || (memcmp(decoded, input, size) != 0))
+                {
+                    (void)printf("round trip mismatch\r\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    (void)printf("%8lu bytes: Base64_Decode_Into  %9.1f MB/s\r\n", (unsigned long)size, megabytes_per_second(start, end, rounds * size));
+                }
+            }
+            free(decoded);
+        }
+    }
+    return result;
+}
+
+static int run_size(size_t size)
+{
+    int result;
+    size_t encoded_size = (size + 2) / 3 * 4 + 1;
+    unsigned char* input = (unsigned char*)malloc(size);
+    char* encoded = (char*)malloc(encoded_size);
+    if ((input == NULL) || (encoded == NULL))
+    {
+        (void)printf("malloc failed\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t encoded_length;
+        size_t rounds = BYTES_PER_SIZE / size;
+        size_t i;
+        for (i = 0; i < size; i++)
+        {
+            input[i] = (unsigned char)(i * 131 + 7);
+        }
+
+        if (Base64_Encode_Into(input, size, encoded, encoded_size, &encoded_length) != 0)
+        {
+            (void)printf("Base64_Encode_Into failed\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            result = run_allocating(input, size, encoded, rounds);
+            if (result == 0)
+            {
+                result = run_into(input, size, encoded, encoded_size, rounds);
+            }
+        }
+    }
+    free(input);
+    free(encoded);
+    return result;
+}
+
+int main(void)
+{
+    int result = 0;
+    size_t i;
+    for (i = 0; i < sizeof(input_sizes) / sizeof(input_sizes[0]); i++)
+    {
+        result = run_size(input_sizes[i]);
+        if (result != 0)
+        {
+            break;
+        }
+    }
+    return result;
+}
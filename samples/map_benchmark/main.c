@@ -0,0 +1,145 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "azure_c_shared_utility/map.h"
+
+/*measures Map_Add and Map_GetValueFromKey for a few map sizes*/
+
+/*every map size is filled this many times in total, spread over as many maps as needed, so that small maps are timed over enough calls*/
+#define ADD_OPERATIONS 1000000
+#define LOOKUP_ROUNDS 1000000
+#define KEY_SIZE 32
+
+static const size_t map_sizes[] = { 10, 100, 10000 };
+
+/*monotonic time in nanoseconds, clock() only has the resolution of the process CPU time*/
+static double now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+    {
+        (void)QueryPerformanceFrequency(&frequency);
+    }
+    (void)QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+#endif
+}
+
+static char* create_keys(size_t key_count)
+{
+    char* result = (char*)malloc(key_count * KEY_SIZE);
+    if (result != NULL)
+    {
+        size_t i;
+        for (i = 0; i < key_count; i++)
+        {
+            (void)sprintf(result + (i * KEY_SIZE), "key%lu", (unsigned long)i);
+        }
+    }
+    return result;
+}
+
+static int run_benchmark(size_t key_count)
+{
+    int result;
+    size_t map_count = (key_count < ADD_OPERATIONS) ? (ADD_OPERATIONS / key_count) : 1;
+    MAP_HANDLE* maps = (MAP_HANDLE*)calloc(map_count, sizeof(MAP_HANDLE));
+    char* keys = create_keys(key_count);
+    if ((maps == NULL) || (keys == NULL))
+    {
+        (void)printf("malloc failed\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+        size_t j;
+        double start;
+        double add_ns = 0;
+        size_t found = 0;
+
+        result = 0;
+        for (j = 0; j < map_count; j++)
+        {
+            if ((maps[j] = Map_Create(NULL)) == NULL)
+            {
+                (void)printf("Map_Create failed\r\n");
+                result = __LINE__;
+                break;
+            }
+        }
+
+        if (result == 0)
+        {
+            start = now_ns();
+            for (j = 0; (j < map_count) && (result == 0); j++)
+            {
+                for (i = 0; i < key_count; i++)
+                {
+                    if (Map_Add(maps[j], keys + (i * KEY_SIZE), "value") != MAP_OK)
+                    {
+                        (void)printf("Map_Add failed\r\n");
+                        result = __LINE__;
+                        break;
+                    }
+                }
+            }
+            add_ns = (now_ns() - start) / (double)(map_count * key_count);
+        }
+
+        if (result == 0)
+        {
+            start = now_ns();
+            for (i = 0; i < LOOKUP_ROUNDS; i++)
+            {
+                if (Map_GetValueFromKey(maps[0], keys + ((i % key_count) * KEY_SIZE)) != NULL)
+                {
+                    found++;
+                }
+            }
+
+            (void)printf("%6lu keys: Map_Add %10.1f ns/op (%lu maps), Map_GetValueFromKey %10.1f ns/op (%lu found)\r\n",
+                (unsigned long)key_count, add_ns, (unsigned long)map_count, (now_ns() - start) / LOOKUP_ROUNDS, (unsigned long)found);
+        }
+
+        for (j = 0; j < map_count; j++)
+        {
+            if (maps[j] != NULL)
+            {
+                Map_Destroy(maps[j]);
+            }
+        }
+    }
+
+    free(keys);
+    free(maps);
+    return result;
+}
+
+int main(void)
+{
+    int result = 0;
+    size_t i;
+    for (i = 0; i < sizeof(map_sizes) / sizeof(map_sizes[0]); i++)
+    {
+        result = run_benchmark(map_sizes[i]);
+        if (result != 0)
+        {
+            break;
+        }
+    }
+    return result;
+}
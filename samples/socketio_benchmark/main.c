@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+/*measures how fast socketio_berkeley receives a bulk download over a loopback TCP connection: a thread sends
+TOTAL_BYTES as fast as the socket accepts them while socketio_dowork delivers them. The download is made once with
+the receive buffer held at RECEIVE_BYTES_VALUE, which is how socketio_berkeley received before the buffer could grow,
+once with the default adaptive buffer and once with a larger buffer limit and SO_RCVBUF. Built with use_io_uring, the
+IO is socketio_uring, whose receive buffers are fixed and ignore the buffer limit*/
+
+#define TOTAL_BYTES (64 * 1024 * 1024)
+#define SEND_CHUNK_SIZE (64 * 1024)
+
+typedef struct RUN_STATE_TAG
+{
+    int listen_socket;
+    int open_result;
+    int error;
+    size_t received_bytes;
+    size_t receive_callbacks;
+} RUN_STATE;
+
+static int send_download(void* context)
+{
+    RUN_STATE* state = (RUN_STATE*)context;
+    int connection = accept(state->listen_socket, NULL, NULL);
+
+    if (connection >= 0)
+    {
+        unsigned char* chunk = (unsigned char*)malloc(SEND_CHUNK_SIZE);
+        if (chunk != NULL)
+        {
+            size_t sent = 0;
+
+            (void)memset(chunk, 'x', SEND_CHUNK_SIZE);
+            while (sent < TOTAL_BYTES)
+            {
+                size_t size = (TOTAL_BYTES - sent < SEND_CHUNK_SIZE) ? (TOTAL_BYTES - sent) : SEND_CHUNK_SIZE;
+                ssize_t send_result = send(connection, chunk, size, 0);
+                if (send_result <= 0)
+                {
+                    break;
+                }
+                sent += (size_t)send_result;
+            }
+
+            free(chunk);
+        }
+
+        (void)close(connection);
+    }
+
+    return 0;
+}
+
+static void on_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    ((RUN_STATE*)context)->open_result = (int)open_result;
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    RUN_STATE* state = (RUN_STATE*)context;
+    (void)buffer;
+    state->received_bytes += size;
+    state->receive_callbacks++;
+}
+
+static void on_io_error(void* context)
+{
+    /*the sender closing the connection at the end of the download is reported as an error*/
+    ((RUN_STATE*)context)->error = 1;
+}
+
+static int run(const char* label, size_t receive_buffer_size, int so_rcvbuf)
+{
+    int result;
+    RUN_STATE state;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&state, 0, sizeof(state));
+    state.open_result = -1;
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (((state.listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0) ||
+        (bind(state.listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(state.listen_socket, 1) != 0) ||
+        (getsockname(state.listen_socket, (struct sockaddr*)&address, &address_length) != 0))
+    {
+        (void)printf("Cannot create the loopback listener\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        THREAD_HANDLE sender;
+        SOCKETIO_CONFIG socketio_config;
+        XIO_HANDLE socketio;
+        TICK_COUNTER_HANDLE tick_counter = tickcounter_create();
+
+        socketio_config.hostname = "127.0.0.1";
+        socketio_config.port = ntohs(address.sin_port);
+        socketio_config.accepted_socket = NULL;
+
+        if (tick_counter == NULL)
+        {
+            (void)printf("tickcounter_create failed\r\n");
+            result = __LINE__;
+        }
+        else if ((socketio = xio_create(socketio_get_interface_description(), &socketio_config)) == NULL)
+        {
+            (void)printf("xio_create failed\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((receive_buffer_size != 0 && xio_setoption(socketio, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE, &receive_buffer_size) != 0) ||
+                (so_rcvbuf != 0 && xio_setoption(socketio, OPTION_SOCKETIO_SO_RCVBUF, &so_rcvbuf) != 0))
+            {
+                (void)printf("xio_setoption failed\r\n");
+                result = __LINE__;
+            }
+            else if (xio_open(socketio, on_open_complete, &state, on_bytes_received, &state, on_io_error, &state) != 0)
+            {
+                (void)printf("xio_open failed\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                /*the connection is established once the listener queues it, before the sender accepts it*/
+                while (state.open_result == -1)
+                {
+                    xio_dowork(socketio);
+                }
+
+                if (state.open_result != (int)IO_OPEN_OK)
+                {
+                    (void)printf("Cannot connect to the loopback listener\r\n");
+                    result = __LINE__;
+                }
+                else if (ThreadAPI_Create(&sender, send_download, &state) != THREADAPI_OK)
+                {
+                    (void)printf("ThreadAPI_Create failed\r\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    int thread_result;
+                    tickcounter_ms_t start;
+                    tickcounter_ms_t end;
+
+                    (void)tickcounter_get_current_ms(tick_counter, &start);
+                    while (!state.error && state.received_bytes < TOTAL_BYTES)
+                    {
+                        xio_dowork(socketio);
+                    }
+                    (void)tickcounter_get_current_ms(tick_counter, &end);
+
+                    if (state.received_bytes != TOTAL_BYTES)
+                    {
+                        (void)printf("%-32s failed after %lu bytes\r\n", label, (unsigned long)state.received_bytes);
+                        result = __LINE__;
+                    }
+                    else
+                    {
+                        double seconds = (double)(end - start) / 1000.0;
+                        (void)printf("%-32s %8.3f s %9.1f MB/s %9lu callbacks %8.0f bytes per callback\r\n",
+                            label, seconds, (seconds > 0) ? ((double)TOTAL_BYTES / (1024.0 * 1024.0) / seconds) : 0.0,
+                            (unsigned long)state.receive_callbacks, (double)state.received_bytes / (double)state.receive_callbacks);
+                        result = 0;
+                    }
+
+                    (void)ThreadAPI_Join(sender, &thread_result);
+                }
+
+                (void)xio_close(socketio, NULL, NULL);
+            }
+
+            xio_destroy(socketio);
+        }
+
+        if (tick_counter != NULL)
+        {
+            tickcounter_destroy(tick_counter);
+        }
+    }
+
+    if (state.listen_socket >= 0)
+    {
+        (void)close(state.listen_socket);
+    }
+
+    return result;
+}
+
+int main(void)
+{
+    int result;
+
+    (void)printf("%d bytes over loopback\r\n", TOTAL_BYTES);
+    result = run("fixed RECEIVE_BYTES_VALUE buffer", RECEIVE_BYTES_VALUE, 0);
+    if (result == 0)
+    {
+        result = run("adaptive buffer, default limit", 0, 0);
+    }
+    if (result == 0)
+    {
+        result = run("adaptive buffer to 256KB", 256 * 1024, 1024 * 1024);
+    }
+
+    return result;
+}
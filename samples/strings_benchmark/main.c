@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <time.h>
+#include "azure_c_shared_utility/strings.h"
+
+/*measures building strings out of many small pieces, the way JSON and HTTP payloads are assembled*/
+
+#define SHORT_STRING_ROUNDS 1000000
+
+static const size_t chain_lengths[] = { 10, 100, 1000, 10000 };
+
+static double elapsed_ns(clock_t start, clock_t end, size_t operations)
+{
+    return ((double)(end - start) * 1e9 / CLOCKS_PER_SEC) / (double)operations;
+}
+
+static int run_concat_chain(size_t chain_length)
+{
+    int result = 0;
+    size_t rounds = 1000000 / chain_length;
+    size_t total_length = 0;
+    size_t i;
+    clock_t start = clock();
+    clock_t end;
+
+    for (i = 0; (i < rounds) && (result == 0); i++)
+    {
+        STRING_HANDLE value = STRING_new();
+        if (value == NULL)
+        {
+            (void)printf("STRING_new failed\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t j;
+            for (j = 0; j < chain_length; j++)
+            {
+                if (STRING_concat(value, "\"key\":1,") != 0)
+                {
+                    (void)printf("STRING_concat failed\r\n");
+                    result = __LINE__;
+                    break;
+                }
+            }
+            total_length += STRING_length(value);
+            STRING_delete(value);
+        }
+    }
+    end = clock();
+
+    if (result == 0)
+    {
+        (void)printf("%6lu pieces: STRING_concat %8.1f ns/op (%lu bytes built)\r\n",
+            (unsigned long)chain_length, elapsed_ns(start, end, rounds * chain_length), (unsigned long)total_length);
+    }
+    return result;
+}
+
+static int run_short_strings(void)
+{
+    int result = 0;
+    size_t total_length = 0;
+    size_t i;
+    clock_t start = clock();
+    clock_t end;
+
+    for (i = 0; i < SHORT_STRING_ROUNDS; i++)
+    {
+        STRING_HANDLE value = STRING_construct("Content-Type");
+        if (value == NULL)
+        {
+            (void)printf("STRING_construct failed\r\n");
+            result = __LINE__;
+            break;
+        }
+        else
+        {
+            total_length += STRING_length(value);
+            STRING_delete(value);
+        }
+    }
+    end = clock();
+
+    if (result == 0)
+    {
+        (void)printf("short strings: STRING_construct+STRING_length+STRING_delete %8.1f ns/op (%lu)\r\n",
+            elapsed_ns(start, end, SHORT_STRING_ROUNDS), (unsigned long)total_length);
+    }
+    return result;
+}
+
+int main(void)
+{
+    int result = 0;
+    size_t i;
+    for (i = 0; i < sizeof(chain_lengths) / sizeof(chain_lengths[0]); i++)
+    {
+        result = run_concat_chain(chain_lengths[i]);
+        if (result != 0)
+        {
+            break;
+        }
+    }
+
+    if (result == 0)
+    {
+        result = run_short_strings();
+    }
+    return result;
+}
@@ -0,0 +1,418 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/x509.h"
+#include "openssl/pem.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+/*measures many small sends through tlsio_openssl over an in-process loopback TLS pair: the client is tlsio_openssl,
+its underlying IO hands the bytes to an OpenSSL server on memory BIOs. The same sends are made once with a
+tlsio_openssl_dowork after every send, which puts every send in its own record, and once with a dowork every
+SENDS_PER_DOWORK sends, which lets tlsio_openssl gather them into full records*/
+
+#define SEND_SIZE 100
+#define SEND_COUNT 200000
+#define SENDS_PER_DOWORK 1000
+
+typedef struct LOOPBACK_SERVER_TAG
+{
+    SSL_CTX* ssl_context;
+    SSL* ssl;
+    BIO* in_bio;
+    BIO* out_bio;
+    int handshake_done;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    size_t underlying_sends;
+    size_t wire_bytes;
+    size_t records;
+    size_t record_bytes_left;
+    size_t record_header_bytes_seen;
+    unsigned char record_header[5];
+    size_t plaintext_bytes;
+} LOOPBACK_SERVER;
+
+static LOOPBACK_SERVER server;
+static size_t sends_completed;
+static int open_result = -1;
+
+static void count_records(const unsigned char* buffer, size_t size)
+{
+    while (size > 0)
+    {
+        if (server.record_bytes_left > 0)
+        {
+            size_t chunk = (size < server.record_bytes_left) ? size : server.record_bytes_left;
+            server.record_bytes_left -= chunk;
+            buffer += chunk;
+            size -= chunk;
+        }
+        else
+        {
+            server.record_header[server.record_header_bytes_seen++] = *buffer++;
+            size--;
+            if (server.record_header_bytes_seen == sizeof(server.record_header))
+            {
+                server.records++;
+                server.record_bytes_left = ((size_t)server.record_header[3] << 8) | server.record_header[4];
+                server.record_header_bytes_seen = 0;
+            }
+        }
+    }
+}
+
+static CONCRETE_IO_HANDLE loopback_create(void* io_create_parameters)
+{
+    (void)io_create_parameters;
+    return &server;
+}
+
+static void loopback_destroy(CONCRETE_IO_HANDLE loopback_io)
+{
+    (void)loopback_io;
+}
+
+static int loopback_open(CONCRETE_IO_HANDLE loopback_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)loopback_io;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    server.on_bytes_received = on_bytes_received;
+    server.on_bytes_received_context = on_bytes_received_context;
+    on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+    return 0;
+}
+
+static int loopback_close(CONCRETE_IO_HANDLE loopback_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)loopback_io;
+    if (on_io_close_complete != NULL)
+    {
+        on_io_close_complete(callback_context);
+    }
+    return 0;
+}
+
+static int loopback_send(CONCRETE_IO_HANDLE loopback_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    (void)loopback_io;
+
+    server.underlying_sends++;
+    server.wire_bytes += size;
+    if (server.handshake_done)
+    {
+        count_records((const unsigned char*)buffer, size);
+    }
+
+    if (BIO_write(server.in_bio, buffer, (int)size) != (int)size)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (!server.handshake_done)
+        {
+            if (SSL_accept(server.ssl) == 1)
+            {
+                server.handshake_done = 1;
+            }
+        }
+        else
+        {
+            unsigned char plaintext[16384];
+            int read_size;
+            while ((read_size = SSL_read(server.ssl, plaintext, sizeof(plaintext))) > 0)
+            {
+                server.plaintext_bytes += (size_t)read_size;
+            }
+        }
+
+        if (on_send_complete != NULL)
+        {
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static void loopback_dowork(CONCRETE_IO_HANDLE loopback_io)
+{
+    unsigned char buffer[4096];
+    int read_size;
+    (void)loopback_io;
+
+    while ((read_size = BIO_read(server.out_bio, buffer, sizeof(buffer))) > 0)
+    {
+        server.on_bytes_received(server.on_bytes_received_context, buffer, (size_t)read_size);
+    }
+}
+
+static int loopback_setoption(CONCRETE_IO_HANDLE loopback_io, const char* optionName, const void* value)
+{
+    (void)loopback_io;
+    (void)optionName;
+    (void)value;
+    return 0;
+}
+
+static OPTIONHANDLER_HANDLE loopback_retrieveoptions(CONCRETE_IO_HANDLE loopback_io)
+{
+    (void)loopback_io;
+    return NULL;
+}
+
+static const IO_INTERFACE_DESCRIPTION loopback_interface_description =
+{
+    loopback_retrieveoptions,
+    loopback_create,
+    loopback_destroy,
+    loopback_open,
+    loopback_close,
+    loopback_send,
+    loopback_dowork,
+    loopback_setoption,
+    NULL
+};
+
+/*creates the server SSL objects with a self signed certificate and returns the certificate as PEM*/
+static char* create_server(void)
+{
+    char* result = NULL;
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    X509* certificate = X509_new();
+
+    if ((key_context != NULL) && (certificate != NULL) &&
+        (EVP_PKEY_keygen_init(key_context) == 1) &&
+        (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) == 1) &&
+        (EVP_PKEY_keygen(key_context, &key) == 1))
+    {
+        BIO* pem_bio = BIO_new(BIO_s_mem());
+        X509_NAME* name = X509_get_subject_name(certificate);
+
+        (void)ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        (void)X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+        (void)X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+        (void)X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+        (void)X509_set_issuer_name(certificate, name);
+        (void)X509_set_pubkey(certificate, key);
+
+        server.ssl_context = SSL_CTX_new(SSLv23_server_method());
+        if ((pem_bio != NULL) && (server.ssl_context != NULL) &&
+            (X509_sign(certificate, key, EVP_sha256()) != 0) &&
+            (SSL_CTX_use_certificate(server.ssl_context, certificate) == 1) &&
+            (SSL_CTX_use_PrivateKey(server.ssl_context, key) == 1) &&
+            (PEM_write_bio_X509(pem_bio, certificate) == 1))
+        {
+            char* pem;
+            long pem_size = BIO_get_mem_data(pem_bio, &pem);
+
+            server.ssl = SSL_new(server.ssl_context);
+            server.in_bio = BIO_new(BIO_s_mem());
+            server.out_bio = BIO_new(BIO_s_mem());
+            result = (char*)malloc((size_t)pem_size + 1);
+            if ((server.ssl != NULL) && (server.in_bio != NULL) && (server.out_bio != NULL) && (result != NULL))
+            {
+                SSL_set_bio(server.ssl, server.in_bio, server.out_bio);
+                (void)memcpy(result, pem, (size_t)pem_size);
+                result[pem_size] = '\0';
+            }
+            else
+            {
+                free(result);
+                result = NULL;
+            }
+        }
+
+        BIO_free(pem_bio);
+    }
+
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(key_context);
+    X509_free(certificate);
+    return result;
+}
+
+static void destroy_server(void)
+{
+    /*the BIOs are owned by the SSL object once SSL_set_bio was called*/
+    if (server.ssl != NULL)
+    {
+        SSL_free(server.ssl);
+    }
+    else
+    {
+        BIO_free(server.in_bio);
+        BIO_free(server.out_bio);
+    }
+    SSL_CTX_free(server.ssl_context);
+    (void)memset(&server, 0, sizeof(server));
+}
+
+static void on_open_complete(void* context, IO_OPEN_RESULT result)
+{
+    (void)context;
+    open_result = (int)result;
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    (void)size;
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    (void)printf("tlsio error\r\n");
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    if (send_result == IO_SEND_OK)
+    {
+        sends_completed++;
+    }
+}
+
+static int run(const char* label, size_t sends_per_dowork)
+{
+    int result;
+    char* certificate = create_server();
+
+    if (certificate == NULL)
+    {
+        (void)printf("Cannot create the loopback server\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        TLSIO_CONFIG tlsio_config;
+        XIO_HANDLE tlsio;
+
+        tlsio_config.hostname = "localhost";
+        tlsio_config.port = 443;
+        tlsio_config.underlying_io_interface = &loopback_interface_description;
+        tlsio_config.underlying_io_parameters = NULL;
+
+        open_result = -1;
+        sends_completed = 0;
+        tlsio = xio_create(tlsio_openssl_get_interface_description(), &tlsio_config);
+        if (tlsio == NULL)
+        {
+            (void)printf("xio_create failed\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+
+            (void)xio_setoption(tlsio, OPTION_TRUSTED_CERT, certificate);
+            if (xio_open(tlsio, on_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL) != 0)
+            {
+                (void)printf("xio_open failed\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                for (i = 0; (i < 100) && (open_result == -1); i++)
+                {
+                    xio_dowork(tlsio);
+                }
+
+                if (open_result != (int)IO_OPEN_OK)
+                {
+                    (void)printf("TLS handshake failed\r\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    unsigned char payload[SEND_SIZE];
+                    clock_t start;
+                    clock_t end;
+                    double seconds;
+
+                    (void)memset(payload, 'x', sizeof(payload));
+                    server.underlying_sends = 0;
+                    server.wire_bytes = 0;
+                    server.records = 0;
+
+                    result = 0;
+                    start = clock();
+                    for (i = 0; i < SEND_COUNT; i++)
+                    {
+                        if (xio_send(tlsio, payload, sizeof(payload), on_send_complete, NULL) != 0)
+                        {
+                            (void)printf("xio_send failed\r\n");
+                            result = __LINE__;
+                            break;
+                        }
+                        if (((i + 1) % sends_per_dowork) == 0)
+                        {
+                            xio_dowork(tlsio);
+                        }
+                    }
+                    xio_dowork(tlsio);
+                    end = clock();
+                    seconds = (double)(end - start) / CLOCKS_PER_SEC;
+
+                    if (result == 0)
+                    {
+                        (void)printf("%-22s %8.3f s %9.0f sends/s %8lu records %8lu underlying sends %10lu wire bytes (%lu of %lu sends completed, %lu plaintext bytes received)\r\n",
+                            label, seconds, (seconds > 0) ? (SEND_COUNT / seconds) : 0.0,
+                            (unsigned long)server.records, (unsigned long)server.underlying_sends, (unsigned long)server.wire_bytes,
+                            (unsigned long)sends_completed, (unsigned long)SEND_COUNT, (unsigned long)server.plaintext_bytes);
+                    }
+                }
+
+                (void)xio_close(tlsio, NULL, NULL);
+            }
+
+            xio_destroy(tlsio);
+        }
+
+        free(certificate);
+        destroy_server();
+    }
+
+    return result;
+}
+
+int main(void)
+{
+    int result;
+
+    if (tlsio_openssl_init() != 0)
+    {
+        (void)printf("tlsio_openssl_init failed\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        (void)printf("%d sends of %d bytes\r\n", SEND_COUNT, SEND_SIZE);
+        result = run("dowork after each send", 1);
+        if (result == 0)
+        {
+            result = run("dowork every 1000", SENDS_PER_DOWORK);
+        }
+
+        tlsio_openssl_deinit();
+    }
+
+    return result;
+}
@@ -5,98 +5,413 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/xlogging.h"
 
 
-#define splitInt(intVal, bytePos)   (char)((intVal >> (bytePos << 3)) & 0xFF)
-#define joinChars(a, b, c, d) (uint32_t)((uint32_t)a + ((uint32_t)b << 8) + ((uint32_t)c << 16) + ((uint32_t)d << 24))
+/*x86 builds get SSSE3 and AVX2 kernels that are picked at run time, everybody else uses the table driven scalar code*/
+#if !defined(NO_BASE64_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#if defined(_MSC_VER) && (_MSC_VER >= 1800)
+#define BASE64_USE_X86_SIMD
+#define BASE64_TARGET(x)
+#include <intrin.h>
+#include <immintrin.h>
+#elif (defined(__GNUC__) && (__GNUC__ >= 5)) || defined(__clang__)
+#define BASE64_USE_X86_SIMD
+#define BASE64_TARGET(x) __attribute__((target(x)))
+#include <immintrin.h>
+#endif
+#endif
 
-static char base64char(unsigned char val)
+#define BASE64_INVALID 0xFF
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*maps every character to its 6 bit value, BASE64_INVALID for characters that are not part of the alphabet*/
+static const unsigned char base64_values[256] =
 {
-    char result;
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
 
-    if (val < 26)
+static size_t base64_encode_scalar(char* destination, const unsigned char* source, size_t size)
+{
+    /*b0            b1(+1)          b2(+2)
+    7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0
+    |----c1---| |----c2---| |----c3---| |----c4---|
+    */
+    size_t currentPosition = 0;
+    while (size - currentPosition >= 3)
     {
-        result = 'A' + (char)val;
+        uint32_t group = ((uint32_t)source[currentPosition] << 16) | ((uint32_t)source[currentPosition + 1] << 8) | source[currentPosition + 2];
+        destination[0] = base64_alphabet[group >> 18];
+        destination[1] = base64_alphabet[(group >> 12) & 0x3F];
+        destination[2] = base64_alphabet[(group >> 6) & 0x3F];
+        destination[3] = base64_alphabet[group & 0x3F];
+        destination += 4;
+        currentPosition += 3;
     }
-    else if (val < 52)
+    return currentPosition;
+}
+
+/*decodes the longest prefix of source (at most numberOfChars characters) that is in the alphabet and returns its length.
+A trailing group of 2 or 3 characters produces 1 or 2 bytes, a single character produces nothing*/
+static size_t base64_decode_scalar(unsigned char* destination, const char* source, size_t numberOfChars)
+{
+    const unsigned char* encoded = (const unsigned char*)source;
+    size_t result = 0;
+    size_t remaining;
+    while (numberOfChars - result >= 4)
     {
-        result = 'a' + ((char)val - 26);
+        uint32_t c1 = base64_values[encoded[result]];
+        uint32_t c2 = base64_values[encoded[result + 1]];
+        uint32_t c3 = base64_values[encoded[result + 2]];
+        uint32_t c4 = base64_values[encoded[result + 3]];
+        uint32_t group;
+        if (((c1 | c2 | c3 | c4) & 0x80) != 0)
+        {
+            break;
+        }
+        group = (c1 << 18) | (c2 << 12) | (c3 << 6) | c4;
+        destination[0] = (unsigned char)(group >> 16);
+        destination[1] = (unsigned char)(group >> 8);
+        destination[2] = (unsigned char)group;
+        destination += 3;
+        result += 4;
     }
-    else if (val < 62)
+
+    remaining = 0;
+    while ((result + remaining < numberOfChars) && (remaining < 3) && (base64_values[encoded[result + remaining]] != BASE64_INVALID))
     {
-        result = '0' + ((char)val - 52);
+        remaining++;
     }
-    else if (val == 62)
+    if (remaining >= 2)
     {
-        result = '+';
+        uint32_t group = ((uint32_t)base64_values[encoded[result]] << 18) | ((uint32_t)base64_values[encoded[result + 1]] << 12);
+        if (remaining == 3)
+        {
+            group |= (uint32_t)base64_values[encoded[result + 2]] << 6;
+            destination[1] = (unsigned char)(group >> 8);
+        }
+        destination[0] = (unsigned char)(group >> 16);
     }
-    else
+    return result + remaining;
+}
+
+#ifdef BASE64_USE_X86_SIMD
+
+#define BASE64_CPU_UNKNOWN  0
+#define BASE64_CPU_SCALAR   1
+#define BASE64_CPU_SSSE3    2
+#define BASE64_CPU_AVX2     3
+
+/*several threads may race to fill this in, they all compute the same value*/
+static volatile int base64_cpu_level = BASE64_CPU_UNKNOWN;
+
+static int base64_get_cpu_level(void)
+{
+    int result = base64_cpu_level;
+    if (result == BASE64_CPU_UNKNOWN)
     {
-        result = '/';
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 1)
+        {
+            result = BASE64_CPU_SCALAR;
+        }
+        else
+        {
+            int hasAvx;
+            __cpuid(info, 1);
+            /*AVX needs the OS to save the ymm registers (OSXSAVE and XCR0 bits 1 and 2)*/
+            hasAvx = ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6);
+            result = ((info[2] & (1 << 9)) != 0) ? BASE64_CPU_SSSE3 : BASE64_CPU_SCALAR;
+            if (hasAvx)
+            {
+                __cpuid(info, 0);
+                if (info[0] >= 7)
+                {
+                    __cpuidex(info, 7, 0);
+                    if ((info[1] & (1 << 5)) != 0)
+                    {
+                        result = BASE64_CPU_AVX2;
+                    }
+                }
+            }
+        }
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            result = BASE64_CPU_AVX2;
+        }
+        else if (__builtin_cpu_supports("ssse3"))
+        {
+            result = BASE64_CPU_SSSE3;
+        }
+        else
+        {
+            result = BASE64_CPU_SCALAR;
+        }
+#endif
+        base64_cpu_level = result;
     }
-
     return result;
 }
 
-static char base64b16(unsigned char val)
+/*the vector kernels follow W. Mula and D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions"*/
+
+BASE64_TARGET("ssse3")
+static __m128i base64_encode_indices_ssse3(__m128i input)
 {
-    const uint32_t base64b16values[4] = {
-        joinChars('A', 'E', 'I', 'M'),
-        joinChars('Q', 'U', 'Y', 'c'),
-        joinChars('g', 'k', 'o', 's'),
-        joinChars('w', '0', '4', '8')
-    };
-    return splitInt(base64b16values[val >> 2], (val & 0x03));
+    /*spread every 3 bytes over 4 bytes, then move the 6 bit groups to the bottom of each byte*/
+    __m128i shuffled = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_and_si128(shuffled, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(shuffled, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
 }
 
-static char base64b8(unsigned char val)
+BASE64_TARGET("ssse3")
+static __m128i base64_encode_translate_ssse3(__m128i indices)
 {
-    const uint32_t base64b8values = joinChars('A', 'Q', 'g', 'w');
-    return splitInt(base64b8values, val);
+    /*picks the offset to add for each of the 5 ranges of the alphabet*/
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
 }
 
-static int base64toValue(char base64character, unsigned char* value)
+BASE64_TARGET("ssse3")
+static size_t base64_encode_ssse3(char* destination, const unsigned char* source, size_t size)
 {
-    int result = 0;
-    if (('A' <= base64character) && (base64character <= 'Z'))
+    size_t currentPosition = 0;
+    /*every step loads 16 bytes and consumes 12 of them*/
+    while (size - currentPosition >= 16)
     {
-        *value = base64character - 'A';
+        __m128i input = _mm_loadu_si128((const __m128i*)(source + currentPosition));
+        _mm_storeu_si128((__m128i*)destination, base64_encode_translate_ssse3(base64_encode_indices_ssse3(input)));
+        destination += 16;
+        currentPosition += 12;
     }
-    else if (('a' <= base64character) && (base64character <= 'z'))
+    return currentPosition + base64_encode_scalar(destination, source + currentPosition, size - currentPosition);
+}
+
+/*translates 16 characters to their 6 bit values. Returns 0 if any of them is not in the alphabet*/
+BASE64_TARGET("ssse3")
+static int base64_decode_values_ssse3(__m128i* values)
+{
+    int result;
+    const __m128i lowNibbleClasses = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i highNibbleClasses = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i slash = _mm_set1_epi8(0x2F);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i input = *values;
+    __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(input, 4), nibble);
+    __m128i lowNibbles = _mm_and_si128(input, nibble);
+    __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lowNibbleClasses, lowNibbles), _mm_shuffle_epi8(highNibbleClasses, highNibbles));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF)
     {
-        *value = ('Z' - 'A') + 1 + (base64character - 'a');
+        result = 0;
     }
-    else if (('0' <= base64character) && (base64character <= '9'))
+    else
     {
-        *value = ('Z' - 'A') + 1 + ('z' - 'a') + 1 + (base64character - '0');
+        /*'/' shares its high nibble with '+', it is moved to a slot of its own*/
+        __m128i offsetIndex = _mm_add_epi8(_mm_cmpeq_epi8(input, slash), highNibbles);
+        *values = _mm_add_epi8(input, _mm_shuffle_epi8(offsets, offsetIndex));
+        result = 1;
     }
-    else if ('+' == base64character)
+    return result;
+}
+
+BASE64_TARGET("ssse3")
+static __m128i base64_decode_pack_ssse3(__m128i values)
+{
+    /*merges 4 values of 6 bits into 3 bytes, in the low 12 bytes of the result*/
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+BASE64_TARGET("ssse3")
+static size_t base64_decode_ssse3(unsigned char* destination, const char* source, size_t numberOfChars)
+{
+    size_t result = 0;
+    /*every step reads 16 characters and stores 16 bytes of which 12 are used. Keeping 24 characters
+    in hand guarantees that at least 16 bytes of destination are left, even when the last 2 characters are padding*/
+    while (numberOfChars - result >= 24)
     {
-        *value = 62;
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + result));
+        if (!base64_decode_values_ssse3(&values))
+        {
+            /*the scalar code finds where the alphabet ends*/
+            break;
+        }
+        _mm_storeu_si128((__m128i*)destination, base64_decode_pack_ssse3(values));
+        destination += 12;
+        result += 16;
     }
-    else if ('/' == base64character)
+    return result + base64_decode_scalar(destination, source + result, numberOfChars - result);
+}
+
+BASE64_TARGET("avx2")
+static size_t base64_encode_avx2(char* destination, const unsigned char* source, size_t size)
+{
+    size_t currentPosition = 0;
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    /*every step consumes 24 bytes, 12 in each lane. The second lane loads 16 bytes starting at 12*/
+    while (size - currentPosition >= 28)
     {
-        *value = 63;
+        __m128i low = _mm_loadu_si128((const __m128i*)(source + currentPosition));
+        __m128i high = _mm_loadu_si128((const __m128i*)(source + currentPosition + 12));
+        __m256i input = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        __m256i shuffled = _mm256_shuffle_epi8(input, spread);
+        __m256i t0 = _mm256_and_si256(shuffled, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(shuffled, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(isUpper, _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i*)destination, _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range)));
+        destination += 32;
+        currentPosition += 24;
     }
-    else
+    _mm256_zeroupper();
+    return currentPosition + base64_encode_ssse3(destination, source + currentPosition, size - currentPosition);
+}
+
+BASE64_TARGET("avx2")
+static size_t base64_decode_avx2(unsigned char* destination, const char* source, size_t numberOfChars)
+{
+    size_t result = 0;
+    const __m256i lowNibbleClasses = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i highNibbleClasses = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i offsets = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i slash = _mm256_set1_epi8(0x2F);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    /*every step reads 32 characters and stores 32 bytes of which 24 are used. Keeping 45 characters
+    in hand guarantees that at least 32 bytes of destination are left, even when the last 2 characters are padding*/
+    while (numberOfChars - result >= 45)
     {
-        *value = 0;
-        result = -1;
+        __m256i input = _mm256_loadu_si256((const __m256i*)(source + result));
+        __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi32(input, 4), nibble);
+        __m256i lowNibbles = _mm256_and_si256(input, nibble);
+        __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lowNibbleClasses, lowNibbles), _mm256_shuffle_epi8(highNibbleClasses, highNibbles));
+        __m256i values;
+        __m256i groups;
+        if (!_mm256_testz_si256(invalid, invalid))
+        {
+            break;
+        }
+        values = _mm256_add_epi8(input, _mm256_shuffle_epi8(offsets, _mm256_add_epi8(_mm256_cmpeq_epi8(input, slash), highNibbles)));
+        groups = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+        groups = _mm256_shuffle_epi8(groups, pack);
+        /*the 12 bytes of each lane are made contiguous*/
+        _mm256_storeu_si256((__m256i*)destination, _mm256_permutevar8x32_epi32(groups, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7)));
+        destination += 24;
+        result += 32;
+    }
+    /*avoids the penalty of running SSE code with the upper halves of the ymm registers in use*/
+    _mm256_zeroupper();
+    return result + base64_decode_ssse3(destination, source + result, numberOfChars - result);
+}
+
+static size_t base64_encode_groups(char* destination, const unsigned char* source, size_t size)
+{
+    size_t result;
+    switch (base64_get_cpu_level())
+    {
+    case BASE64_CPU_AVX2:
+        result = base64_encode_avx2(destination, source, size);
+        break;
+    case BASE64_CPU_SSSE3:
+        result = base64_encode_ssse3(destination, source, size);
+        break;
+    default:
+        result = base64_encode_scalar(destination, source, size);
+        break;
+    }
+    return result;
+}
+
+static size_t base64_decode_chars(unsigned char* destination, const char* source, size_t numberOfChars)
+{
+    size_t result;
+    switch (base64_get_cpu_level())
+    {
+    case BASE64_CPU_AVX2:
+        result = base64_decode_avx2(destination, source, numberOfChars);
+        break;
+    case BASE64_CPU_SSSE3:
+        result = base64_decode_ssse3(destination, source, numberOfChars);
+        break;
+    default:
+        result = base64_decode_scalar(destination, source, numberOfChars);
+        break;
     }
     return result;
 }
 
-static size_t numberOfBase64Characters(const char* encodedString)
+#else
+
+#define base64_encode_groups base64_encode_scalar
+#define base64_decode_chars base64_decode_scalar
+
+#endif
+
+/*encodes size bytes into destination, which must have room for the padded encoding (no terminator is written). Returns the number of characters written*/
+static size_t base64_encode(char* destination, const unsigned char* source, size_t size)
 {
-    size_t length = 0;
-    unsigned char junkChar;
-    while (base64toValue(encodedString[length],&junkChar) != -1)
+    size_t currentPosition = base64_encode_groups(destination, source, size);
+    size_t destinationPosition = currentPosition / 3 * 4;
+    if (size - currentPosition == 2)
+    {
+        uint32_t group = ((uint32_t)source[currentPosition] << 16) | ((uint32_t)source[currentPosition + 1] << 8);
+        destination[destinationPosition++] = base64_alphabet[group >> 18];
+        destination[destinationPosition++] = base64_alphabet[(group >> 12) & 0x3F];
+        destination[destinationPosition++] = base64_alphabet[(group >> 6) & 0x3F];
+        destination[destinationPosition++] = '=';
+    }
+    else if (size - currentPosition == 1)
     {
-        length++;
+        uint32_t group = (uint32_t)source[currentPosition] << 16;
+        destination[destinationPosition++] = base64_alphabet[group >> 18];
+        destination[destinationPosition++] = base64_alphabet[(group >> 12) & 0x3F];
+        destination[destinationPosition++] = '=';
+        destination[destinationPosition++] = '=';
     }
-    return length;
+    return destinationPosition;
 }
 
 /*returns the count of original bytes before being base64 encoded*/
@@ -127,61 +442,8 @@ static size_t Base64decode_len(const char *encodedString)
 
 static void Base64decode(unsigned char *decodedString, const char *base64String)
 {
-
-    size_t numberOfEncodedChars;
-    size_t indexOfFirstEncodedChar;
-    size_t decodedIndex;
-
-    //
-    // We can only operate on individual bytes.  If we attempt to work
-    // on anything larger we could get an alignment fault on some
-    // architectures
-    //
-
-    numberOfEncodedChars = numberOfBase64Characters(base64String);
-    indexOfFirstEncodedChar = 0;
-    decodedIndex = 0;
-    while (numberOfEncodedChars >= 4)
-    {
-        unsigned char c1;
-        unsigned char c2;
-        unsigned char c3;
-        unsigned char c4;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 2], &c3);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 3], &c4);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c2 & 0x0f) << 4) | (c3 >> 2);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c3 & 0x03) << 6) | c4;
-        decodedIndex++;
-        numberOfEncodedChars -= 4;
-        indexOfFirstEncodedChar += 4;
-
-    }
-
-    if (numberOfEncodedChars == 2)
-    {
-        unsigned char c1;
-        unsigned char c2;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
-    }
-    else if (numberOfEncodedChars == 3)
-    {
-        unsigned char c1;
-        unsigned char c2;
-        unsigned char c3;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 2], &c3);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c2 & 0x0f) << 4) | (c3 >> 2);
-    }
+    /*decoding stops at the first character that is not part of the alphabet*/
+    (void)base64_decode_chars(decodedString, base64String, strlen(base64String));
 }
 
 BUFFER_HANDLE Base64_Decoder(const char* source)
@@ -238,7 +500,6 @@ static STRING_HANDLE Base64_Encode_Internal(const unsigned char* source, size_t
     STRING_HANDLE result;
     size_t neededSize = 0;
     char* encoded;
-    size_t currentPosition = 0;
     neededSize += (size == 0) ? (0) : ((((size - 1) / 3) + 1) * 4);
     neededSize += 1; /*+1 because \0 at the end of the string*/
     /*Codes_SRS_BASE64_06_006: [If when allocating memory to produce the encoding a failure occurs then Base64_Encoder shall return NULL.]*/
@@ -250,55 +511,7 @@ static STRING_HANDLE Base64_Encode_Internal(const unsigned char* source, size_t
     }
     else
     {
-        /*b0            b1(+1)          b2(+2)
-        7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0
-        |----c1---| |----c2---| |----c3---| |----c4---|
-        */
-
-        size_t destinationPosition = 0;
-        while (size - currentPosition >= 3)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64char(
-                ((source[currentPosition] & 3) << 4) |
-                    (source[currentPosition + 1] >> 4)
-            );
-            char c3 = base64char(
-                ((source[currentPosition + 1] & 0x0F) << 2) |
-                    ((source[currentPosition + 2] >> 6) & 3)
-            );
-            char c4 = base64char(
-                source[currentPosition + 2] & 0x3F
-            );
-            currentPosition += 3;
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = c3;
-            encoded[destinationPosition++] = c4;
-
-        }
-        if (size - currentPosition == 2)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64char(
-                ((source[currentPosition] & 0x03) << 4) |
-                    (source[currentPosition + 1] >> 4)
-            );
-            char c3 = base64b16(source[currentPosition + 1] & 0x0F);
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = c3;
-            encoded[destinationPosition++] = '=';
-        }
-        else if (size - currentPosition == 1)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64b8(source[currentPosition] & 0x03);
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = '=';
-            encoded[destinationPosition++] = '=';
-        }
+        size_t destinationPosition = base64_encode(encoded, source, size);
 
         /*null terminating the string*/
         encoded[destinationPosition] = '\0';
@@ -366,3 +579,90 @@ STRING_HANDLE Base64_Encoder(BUFFER_HANDLE input)
     }
     return result;
 }
+
+int Base64_Encode_Into(const unsigned char* source, size_t size, char* destination, size_t destination_size, size_t* encoded_length)
+{
+    int result;
+    /*Codes_SRS_BASE64_01_001: [ If source is NULL and size is not zero, or destination is NULL, or encoded_length is NULL, Base64_Encode_Into shall fail and return a non-zero value. ]*/
+    if (((source == NULL) && (size != 0)) ||
+        (destination == NULL) ||
+        (encoded_length == NULL))
+    {
+        LogError("Invalid arguments: const unsigned char* source=%p, size_t size=%lu, char* destination=%p, size_t* encoded_length=%p",
+            source, (unsigned long)size, destination, encoded_length);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_BASE64_01_002: [ If destination_size is less than 4 * ((size + 2) / 3) + 1 then Base64_Encode_Into shall fail and return a non-zero value. ]*/
+    else if ((size / 3 >= ((size_t)-1) / 4 - 1) ||
+        (destination_size < ((size + 2) / 3) * 4 + 1))
+    {
+        LogError("destination too small: size_t size=%lu, size_t destination_size=%lu", (unsigned long)size, (unsigned long)destination_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_003: [ Otherwise Base64_Encode_Into shall write the padded base64 encoding of source followed by a null terminator to destination, set *encoded_length to the number of characters written (without the terminator) and return 0. ]*/
+        size_t destinationPosition = (size == 0) ? 0 : base64_encode(destination, source, size);
+        destination[destinationPosition] = '\0';
+        *encoded_length = destinationPosition;
+        result = 0;
+    }
+    return result;
+}
+
+int Base64_Decode_Into(const char* source, size_t source_length, unsigned char* destination, size_t destination_size, size_t* decoded_length)
+{
+    int result;
+    /*Codes_SRS_BASE64_01_004: [ If source is NULL and source_length is not zero, or destination is NULL, or decoded_length is NULL, Base64_Decode_Into shall fail and return a non-zero value. ]*/
+    if (((source == NULL) && (source_length != 0)) ||
+        (destination == NULL) ||
+        (decoded_length == NULL))
+    {
+        LogError("Invalid arguments: const char* source=%p, size_t source_length=%lu, unsigned char* destination=%p, size_t* decoded_length=%p",
+            source, (unsigned long)source_length, destination, decoded_length);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_BASE64_01_005: [ If source_length is not a multiple of 4 then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+    else if ((source_length % 4) != 0)
+    {
+        LogError("Invalid length Base64 string: %lu", (unsigned long)source_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t numberOfEncodedChars = source_length;
+        size_t outputSize;
+
+        /*Codes_SRS_BASE64_01_006: [ Up to two = characters are accepted as padding at the end of source. ]*/
+        if ((numberOfEncodedChars > 0) && (source[numberOfEncodedChars - 1] == '='))
+        {
+            numberOfEncodedChars--;
+            if (source[numberOfEncodedChars - 1] == '=')
+            {
+                numberOfEncodedChars--;
+            }
+        }
+        outputSize = numberOfEncodedChars / 4 * 3 + ((numberOfEncodedChars % 4 == 0) ? 0 : (numberOfEncodedChars % 4 - 1));
+
+        /*Codes_SRS_BASE64_01_008: [ If destination_size is less than the number of decoded bytes then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+        if (destination_size < outputSize)
+        {
+            LogError("destination too small: needed %lu, size_t destination_size=%lu", (unsigned long)outputSize, (unsigned long)destination_size);
+            result = __FAILURE__;
+        }
+        /*Codes_SRS_BASE64_01_007: [ If any of the other characters in source is not part of the base64 alphabet then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+        else if ((numberOfEncodedChars % 4 == 1) ||
+            (base64_decode_chars(destination, source, numberOfEncodedChars) != numberOfEncodedChars))
+        {
+            LogError("Invalid Base64 string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /*Codes_SRS_BASE64_01_009: [ Otherwise Base64_Decode_Into shall write the decoded bytes to destination, set *decoded_length to their number and return 0. ]*/
+            *decoded_length = outputSize;
+            result = 0;
+        }
+    }
+    return result;
+}
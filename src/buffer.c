@@ -5,17 +5,84 @@
 #include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 
+/*the content is [buffer, buffer + size). It lives inside the allocation [storage, storage + capacity),
+the bytes between storage and buffer are headroom that BUFFER_prepend can fill without moving the content*/
 typedef struct BUFFER_TAG
 {
     unsigned char* buffer;
     size_t size;
+    unsigned char* storage;
+    size_t capacity;
 } BUFFER;
 
+static void BUFFER_free_storage(BUFFER* handleptr)
+{
+    free(handleptr->storage);
+    handleptr->storage = NULL;
+    handleptr->capacity = 0;
+    handleptr->buffer = NULL;
+    handleptr->size = 0;
+}
+
+static size_t BUFFER_headroom(const BUFFER* handleptr)
+{
+    return (handleptr->storage == NULL) ? 0 : (size_t)(handleptr->buffer - handleptr->storage);
+}
+
+/*reallocates the memory held by the buffer to newCapacity bytes, keeping the headroom and the content in place*/
+static int BUFFER_set_capacity(BUFFER* handleptr, size_t newCapacity)
+{
+    int result;
+    size_t headroom = BUFFER_headroom(handleptr);
+    unsigned char* temp = (unsigned char*)realloc(handleptr->storage, newCapacity);
+    if (temp == NULL)
+    {
+        LogError("Failure reallocating buffer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        handleptr->storage = temp;
+        handleptr->buffer = temp + headroom;
+        handleptr->capacity = newCapacity;
+        result = 0;
+    }
+    return result;
+}
+
+/*makes room for additionalSize more bytes after the content. The memory grows to at least twice its
+previous size so that appending chunk by chunk costs amortized linear time*/
+static int BUFFER_ensure_tailroom(BUFFER* handleptr, size_t additionalSize)
+{
+    int result;
+    size_t used = BUFFER_headroom(handleptr) + handleptr->size;
+    if (additionalSize <= handleptr->capacity - used)
+    {
+        result = 0;
+    }
+    else if (additionalSize > SIZE_MAX - used)
+    {
+        LogError("Failure: size overflow.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t newCapacity = (handleptr->capacity > SIZE_MAX / 2) ? SIZE_MAX : (2 * handleptr->capacity);
+        if (newCapacity < used + additionalSize)
+        {
+            newCapacity = used + additionalSize;
+        }
+        result = BUFFER_set_capacity(handleptr, newCapacity);
+    }
+    return result;
+}
+
 /* Codes_SRS_BUFFER_07_001: [BUFFER_new shall allocate a BUFFER_HANDLE that will contain a NULL unsigned char*.] */
 BUFFER_HANDLE BUFFER_new(void)
 {
@@ -25,6 +92,8 @@ BUFFER_HANDLE BUFFER_new(void)
     {
         temp->buffer = NULL;
         temp->size = 0;
+        temp->storage = NULL;
+        temp->capacity = 0;
     }
     return (BUFFER_HANDLE)temp;
 }
@@ -48,6 +117,8 @@ static int BUFFER_safemalloc(BUFFER* handleptr, size_t size)
     {
         // we still consider the real buffer size is 0
         handleptr->size = size;
+        handleptr->storage = handleptr->buffer;
+        handleptr->capacity = sizetomalloc;
         result = 0;
     }
     return result;
@@ -103,6 +174,8 @@ BUFFER_HANDLE BUFFER_create_with_size(size_t buff_size)
             // Codes_SRS_BUFFER_07_030: [ If buff_size is 0 BUFFER_create_with_size shall create a valid non-NULL handle of zero size. ]
             result->size = 0;
             result->buffer = NULL;
+            result->storage = NULL;
+            result->capacity = 0;
         }
         else
         {
@@ -115,6 +188,11 @@ BUFFER_HANDLE BUFFER_create_with_size(size_t buff_size)
                 free(result);
                 result = NULL;
             }
+            else
+            {
+                result->storage = result->buffer;
+                result->capacity = buff_size;
+            }
         }
     }
     else
@@ -133,10 +211,10 @@ void BUFFER_delete(BUFFER_HANDLE handle)
     if (handle != NULL)
     {
         BUFFER* b = (BUFFER*)handle;
-        if (b->buffer != NULL)
+        if (b->storage != NULL)
         {
             /* Codes_SRS_BUFFER_07_003: [BUFFER_delete shall delete the data associated with the BUFFER_HANDLE along with the Buffer.] */
-            free(b->buffer);
+            free(b->storage);
         }
         free(b);
     }
@@ -158,9 +236,7 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
     {
         /* Codes_SRS_BUFFER_01_003: [If size is zero, source can be NULL.] */
         BUFFER* b = (BUFFER*)handle;
-        free(b->buffer);
-        b->buffer = NULL;
-        b->size = 0;
+        BUFFER_free_storage(b);
 
         result = 0;
     }
@@ -175,7 +251,8 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
         {
             BUFFER* b = (BUFFER*)handle;
             /* Codes_SRS_BUFFER_07_011: [BUFFER_build shall overwrite previous contents if the buffer has been previously allocated.] */
-            unsigned char* newBuffer = (unsigned char*)realloc(b->buffer, size);
+            /* Codes_SRS_BUFFER_01_010: [ If the memory already held by the buffer is large enough, BUFFER_build shall reuse it. ]*/
+            unsigned char* newBuffer = (size <= b->capacity) ? b->storage : (unsigned char*)realloc(b->storage, size);
             if (newBuffer == NULL)
             {
                 /* Codes_SRS_BUFFER_07_010: [BUFFER_build shall return nonzero if any error is encountered.] */
@@ -184,6 +261,11 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
             }
             else
             {
+                if (newBuffer != b->storage)
+                {
+                    b->capacity = size;
+                }
+                b->storage = newBuffer;
                 b->buffer = newBuffer;
                 b->size = size;
                 /* Codes_SRS_BUFFER_01_002: [The size argument can be zero, in which case nothing shall be copied from source.] */
@@ -228,8 +310,7 @@ int BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_
         else
         {
             /* Codes_SRS_BUFFER_07_032: [ if handle->buffer is not NULL BUFFER_append_build shall realloc the buffer to be the handle->size + size ] */
-            unsigned char* temp = (unsigned char*)realloc(handle->buffer, handle->size + size);
-            if (temp == NULL)
+            if (BUFFER_ensure_tailroom(handle, size) != 0)
             {
                 /* Codes_SRS_BUFFER_07_035: [ If any error is encountered BUFFER_append_build shall return a non-null value. ] */
                 LogError("Failure reallocating temporary buffer");
@@ -238,7 +319,6 @@ int BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_
             else
             {
                 /* Codes_SRS_BUFFER_07_033: [ ... and copy the contents of source to the end of the buffer. ] */
-                handle->buffer = temp;
                 // Append the BUFFER
                 (void)memcpy(&handle->buffer[handle->size], source, size);
                 handle->size += size;
@@ -286,6 +366,8 @@ int BUFFER_pre_build(BUFFER_HANDLE handle, size_t size)
             else
             {
                 b->size = size;
+                b->storage = b->buffer;
+                b->capacity = size;
                 result = 0;
             }
         }
@@ -326,10 +408,7 @@ extern int BUFFER_unbuild(BUFFER_HANDLE handle)
         BUFFER* b = (BUFFER*)handle;
         if (b->buffer != NULL)
         {
-            LogError("Failure buffer data is NULL");
-            free(b->buffer);
-            b->buffer = NULL;
-            b->size = 0;
+            BUFFER_free_storage(b);
             result = 0;
         }
         else
@@ -360,8 +439,8 @@ int BUFFER_enlarge(BUFFER_HANDLE handle, size_t enlargeSize)
     else
     {
         BUFFER* b = (BUFFER*)handle;
-        unsigned char* temp = (unsigned char*)realloc(b->buffer, b->size + enlargeSize);
-        if (temp == NULL)
+        /* Codes_SRS_BUFFER_01_011: [ BUFFER_enlarge shall grow the memory held by the buffer to at least twice its previous size when it needs to grow. ]*/
+        if (BUFFER_ensure_tailroom(b, enlargeSize) != 0)
         {
             /* Codes_SRS_BUFFER_07_018: [BUFFER_enlarge shall return a nonzero result if any error is encountered.] */
             LogError("Failure: allocating temp buffer.");
@@ -369,7 +448,6 @@ int BUFFER_enlarge(BUFFER_HANDLE handle, size_t enlargeSize)
         }
         else
         {
-            b->buffer = temp;
             b->size += enlargeSize;
             result = 0;
         }
@@ -405,9 +483,7 @@ int BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd)
         if (alloc_size == 0)
         {
             /* Codes_SRS_BUFFER_07_043: [ If the decreaseSize is equal the buffer size , BUFFER_shrink shall deallocate the buffer and set the size to zero. ] */
-            free(handle->buffer);
-            handle->buffer = NULL;
-            handle->size = 0;
+            BUFFER_free_storage(handle);
             result = 0;
         }
         else
@@ -425,20 +501,18 @@ int BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd)
                 {
                     /* Codes_SRS_BUFFER_07_040: [ if the fromEnd variable is true, BUFFER_shrink shall remove the end of the buffer of size decreaseSize. ] */
                     memcpy(tmp, handle->buffer, alloc_size);
-                    free(handle->buffer);
-                    handle->buffer = tmp;
-                    handle->size = alloc_size;
-                    result = 0;
                 }
                 else
                 {
                     /* Codes_SRS_BUFFER_07_041: [ if the fromEnd variable is false, BUFFER_shrink shall remove the beginning of the buffer of size decreaseSize. ] */
                     memcpy(tmp, handle->buffer + decreaseSize, alloc_size);
-                    free(handle->buffer);
-                    handle->buffer = tmp;
-                    handle->size = alloc_size;
-                    result = 0;
                 }
+                free(handle->storage);
+                handle->storage = tmp;
+                handle->capacity = alloc_size;
+                handle->buffer = tmp;
+                handle->size = alloc_size;
+                result = 0;
             }
         }
     }
@@ -496,8 +570,7 @@ int BUFFER_append(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
             else
             {
                 // b2->size != 0, whatever b1->size is
-                unsigned char* temp = (unsigned char*)realloc(b1->buffer, b1->size + b2->size);
-                if (temp == NULL)
+                if (BUFFER_ensure_tailroom(b1, b2->size) != 0)
                 {
                     /* Codes_SRS_BUFFER_07_023: [BUFFER_append shall return a nonzero upon any error that is encountered.] */
                     LogError("Failure: allocating temp buffer.");
@@ -506,7 +579,6 @@ int BUFFER_append(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                 else
                 {
                     /* Codes_SRS_BUFFER_07_024: [BUFFER_append concatenates b2 onto b1 without modifying b2 and shall return zero on success.]*/
-                    b1->buffer = temp;
                     // Append the BUFFER
                     (void)memcpy(&b1->buffer[b1->size], b2->buffer, b2->size);
                     b1->size += b2->size;
@@ -548,10 +620,27 @@ int BUFFER_prepend(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                 // do nothing
                 result = 0;
             }
+            else if ((size_t)(b1->buffer - b1->storage) >= b2->size)
+            {
+                /* Codes_SRS_BUFFER_01_012: [ If there is enough headroom in front of the content of handle1, BUFFER_prepend shall copy the content of handle2 there without moving the content of handle1. ]*/
+                b1->buffer -= b2->size;
+                (void)memcpy(b1->buffer, b2->buffer, b2->size);
+                b1->size += b2->size;
+                result = 0;
+            }
+            else if (b2->size > SIZE_MAX / 2 - b1->size)
+            {
+                /* Codes_SRS_BUFFER_01_005: [ BUFFER_prepend shall return a non-zero upon value any error that is encountered. ]*/
+                LogError("Failure: size overflow.");
+                result = __FAILURE__;
+            }
             else
             {
                 // b2->size != 0
-                unsigned char* temp = (unsigned char*)malloc(b1->size + b2->size);
+                /* Codes_SRS_BUFFER_01_013: [ Otherwise BUFFER_prepend shall allocate the combined size plus half of it as headroom in front of the result, leaving room for further prepends. ]*/
+                size_t newSize = b1->size + b2->size;
+                size_t headroom = newSize / 2;
+                unsigned char* temp = (unsigned char*)malloc(headroom + newSize);
                 if (temp == NULL)
                 {
                     /* Codes_SRS_BUFFER_01_005: [ BUFFER_prepend shall return a non-zero upon value any error that is encountered. ]*/
@@ -562,12 +651,14 @@ int BUFFER_prepend(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                 {
                     /* Codes_SRS_BUFFER_01_004: [ BUFFER_prepend concatenates handle1 onto handle2 without modifying handle1 and shall return zero on success. ]*/
                     // Append the BUFFER
-                    (void)memcpy(temp, b2->buffer, b2->size);
+                    (void)memcpy(&temp[headroom], b2->buffer, b2->size);
                     // start from b1->size to append b1
-                    (void)memcpy(&temp[b2->size], b1->buffer, b1->size);
-                    free(b1->buffer);
-                    b1->buffer = temp;
-                    b1->size += b2->size;
+                    (void)memcpy(&temp[headroom + b2->size], b1->buffer, b1->size);
+                    free(b1->storage);
+                    b1->storage = temp;
+                    b1->capacity = headroom + newSize;
+                    b1->buffer = temp + headroom;
+                    b1->size = newSize;
                     result = 0;
                 }
             }
@@ -576,6 +667,58 @@ int BUFFER_prepend(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
     return result;
 }
 
+int BUFFER_reserve(BUFFER_HANDLE handle, size_t capacity)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_BUFFER_01_006: [ If handle is NULL, BUFFER_reserve shall fail and return a non-zero value. ]*/
+        LogError("Invalid parameter specified, handle == NULL.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFER* b = (BUFFER*)handle;
+        if (b->buffer == NULL)
+        {
+            /* Codes_SRS_BUFFER_01_007: [ If the buffer holds no memory, BUFFER_reserve shall allocate capacity bytes and leave the buffer allocated with a size of 0. ]*/
+            if (BUFFER_safemalloc(b, capacity) != 0)
+            {
+                /* Codes_SRS_BUFFER_01_009: [ If any error occurs, BUFFER_reserve shall fail and return a non-zero value. ]*/
+                LogError("Failure with BUFFER_safemalloc");
+                result = __FAILURE__;
+            }
+            else
+            {
+                b->size = 0;
+                result = 0;
+            }
+        }
+        else if (capacity <= b->capacity - BUFFER_headroom(b))
+        {
+            result = 0;
+        }
+        else if (capacity > SIZE_MAX - BUFFER_headroom(b))
+        {
+            /* Codes_SRS_BUFFER_01_009: [ If any error occurs, BUFFER_reserve shall fail and return a non-zero value. ]*/
+            LogError("Failure: size overflow.");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_BUFFER_01_008: [ Otherwise BUFFER_reserve shall make sure that the content of the buffer can grow to capacity bytes without allocating memory. ]*/
+        else if (BUFFER_set_capacity(b, BUFFER_headroom(b) + capacity) != 0)
+        {
+            /* Codes_SRS_BUFFER_01_009: [ If any error occurs, BUFFER_reserve shall fail and return a non-zero value. ]*/
+            LogError("Failure reserving buffer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
 int BUFFER_fill(BUFFER_HANDLE handle, unsigned char fill_char)
 {
     int result;
@@ -0,0 +1,764 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/bufferio.h"
+
+#define INITIAL_PENDING_SEND_CAPACITY 4
+
+typedef enum BUFFERIO_STATE_TAG
+{
+    BUFFERIO_STATE_CLOSED,
+    BUFFERIO_STATE_OPENING,
+    BUFFERIO_STATE_OPEN,
+    BUFFERIO_STATE_CLOSING,
+    BUFFERIO_STATE_ERROR
+} BUFFERIO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+} PENDING_SEND;
+
+/* The sends whose bytes went out in one underlying send. The pending sends are stored right after the structure,
+so a flush needs a single allocation. */
+typedef struct FLUSHED_SENDS_TAG
+{
+    size_t pending_send_count;
+    PENDING_SEND* pending_sends;
+} FLUSHED_SENDS;
+
+typedef struct BUFFERIO_INSTANCE_TAG
+{
+    BUFFERIO_STATE bufferio_state;
+    XIO_HANDLE underlying_io;
+    TICK_COUNTER_HANDLE tick_counter;
+    size_t max_buffered_bytes;
+    unsigned int max_delay_ms;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    void* on_io_close_complete_context;
+    unsigned char* send_buffer;
+    size_t send_buffer_size;
+    tickcounter_ms_t first_buffered_ms;
+    PENDING_SEND* pending_sends;
+    size_t pending_send_count;
+    size_t pending_send_capacity;
+} BUFFERIO_INSTANCE;
+
+static void indicate_pending_sends_complete(PENDING_SEND* pending_sends, size_t pending_send_count, IO_SEND_RESULT send_result)
+{
+    size_t i;
+
+    for (i = 0; i < pending_send_count; i++)
+    {
+        if (pending_sends[i].on_send_complete != NULL)
+        {
+            pending_sends[i].on_send_complete(pending_sends[i].on_send_complete_context, send_result);
+        }
+    }
+}
+
+static void complete_buffered_sends(BUFFERIO_INSTANCE* bufferio_instance, IO_SEND_RESULT send_result)
+{
+    PENDING_SEND* pending_sends = bufferio_instance->pending_sends;
+    size_t pending_send_count = bufferio_instance->pending_send_count;
+    size_t pending_send_capacity = bufferio_instance->pending_send_capacity;
+
+    /* the buffer is emptied before the callbacks run, a callback that sends again gets a new pending send array */
+    bufferio_instance->pending_sends = NULL;
+    bufferio_instance->pending_send_count = 0;
+    bufferio_instance->pending_send_capacity = 0;
+    bufferio_instance->send_buffer_size = 0;
+
+    indicate_pending_sends_complete(pending_sends, pending_send_count, send_result);
+
+    if (bufferio_instance->pending_sends == NULL)
+    {
+        bufferio_instance->pending_sends = pending_sends;
+        bufferio_instance->pending_send_capacity = pending_send_capacity;
+    }
+    else
+    {
+        free(pending_sends);
+    }
+}
+
+static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    if (context == NULL)
+    {
+        LogError("NULL context in on_underlying_io_send_complete");
+    }
+    else
+    {
+        FLUSHED_SENDS* flushed_sends = (FLUSHED_SENDS*)context;
+
+        /* Codes_SRS_BUFFERIO_01_032: [ When the underlying send completes, the `on_send_complete` callback of every send carried by it shall be called in the order of the sends, with the `send_result` of the underlying send. ]*/
+        indicate_pending_sends_complete(flushed_sends->pending_sends, flushed_sends->pending_send_count, send_result);
+        free(flushed_sends);
+    }
+}
+
+static int flush_buffered_sends(BUFFERIO_INSTANCE* bufferio_instance)
+{
+    int result;
+
+    if (bufferio_instance->send_buffer_size == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t pending_send_count = bufferio_instance->pending_send_count;
+        size_t send_buffer_size = bufferio_instance->send_buffer_size;
+
+        /* Codes_SRS_BUFFERIO_01_030: [ Flushing shall move the callbacks of the buffered sends to a newly allocated structure that is passed as context to the underlying send. ]*/
+        FLUSHED_SENDS* flushed_sends = (FLUSHED_SENDS*)malloc(sizeof(FLUSHED_SENDS) + (pending_send_count * sizeof(PENDING_SEND)));
+        if (flushed_sends == NULL)
+        {
+            /* Codes_SRS_BUFFERIO_01_033: [ If flushing fails, the `on_send_complete` callback of every buffered send shall be called with `IO_SEND_ERROR`. ]*/
+            LogError("Cannot allocate memory for the flushed sends");
+            complete_buffered_sends(bufferio_instance, IO_SEND_ERROR);
+            result = __FAILURE__;
+        }
+        else
+        {
+            flushed_sends->pending_send_count = pending_send_count;
+            flushed_sends->pending_sends = (PENDING_SEND*)(flushed_sends + 1);
+            (void)memcpy(flushed_sends->pending_sends, bufferio_instance->pending_sends, pending_send_count * sizeof(PENDING_SEND));
+
+            /* the send buffer is free again once xio_send returns, the underlying IO has consumed or copied the bytes */
+            bufferio_instance->pending_send_count = 0;
+            bufferio_instance->send_buffer_size = 0;
+
+            /* Codes_SRS_BUFFERIO_01_031: [ Flushing shall send all the buffered bytes with a single call to `xio_send` on the underlying IO. ]*/
+            if (xio_send(bufferio_instance->underlying_io, bufferio_instance->send_buffer, send_buffer_size, on_underlying_io_send_complete, flushed_sends) != 0)
+            {
+                /* Codes_SRS_BUFFERIO_01_033: [ If flushing fails, the `on_send_complete` callback of every buffered send shall be called with `IO_SEND_ERROR`. ]*/
+                LogError("Underlying xio_send failed.");
+                indicate_pending_sends_complete(flushed_sends->pending_sends, pending_send_count, IO_SEND_ERROR);
+                free(flushed_sends);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static CONCRETE_IO_HANDLE bufferio_create(void* io_create_parameters)
+{
+    BUFFERIO_INSTANCE* result;
+
+    if (io_create_parameters == NULL)
+    {
+        /* Codes_SRS_BUFFERIO_01_002: [ If `io_create_parameters` is NULL, `bufferio_create` shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFERIO_01_003: [ `io_create_parameters` shall be used as a `BUFFERIO_CONFIG*`. ]*/
+        BUFFERIO_CONFIG* bufferio_config = (BUFFERIO_CONFIG*)io_create_parameters;
+        if (bufferio_config->underlying_io_interface == NULL)
+        {
+            /* Codes_SRS_BUFFERIO_01_004: [ If the `underlying_io_interface` member is NULL, `bufferio_create` shall fail and return NULL. ]*/
+            LogError("NULL underlying_io_interface.");
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_BUFFERIO_01_001: [ `bufferio_create` shall create a new instance of the buffer IO. ]*/
+            result = (BUFFERIO_INSTANCE*)malloc(sizeof(BUFFERIO_INSTANCE));
+            if (result == NULL)
+            {
+                /* Codes_SRS_BUFFERIO_01_005: [ If any allocation or call fails, `bufferio_create` shall free all allocated resources and return NULL. ]*/
+                LogError("Failed allocating buffer IO instance.");
+            }
+            else
+            {
+                /* Codes_SRS_BUFFERIO_01_006: [ If `max_buffered_bytes` is 0, `BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES` shall be used. ]*/
+                result->max_buffered_bytes = (bufferio_config->max_buffered_bytes == 0) ? BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES : bufferio_config->max_buffered_bytes;
+                result->max_delay_ms = bufferio_config->max_delay_ms;
+
+                /* Codes_SRS_BUFFERIO_01_007: [ `bufferio_create` shall allocate a send buffer of `max_buffered_bytes` bytes. ]*/
+                result->send_buffer = (unsigned char*)malloc(result->max_buffered_bytes);
+                if (result->send_buffer == NULL)
+                {
+                    /* Codes_SRS_BUFFERIO_01_005: [ If any allocation or call fails, `bufferio_create` shall free all allocated resources and return NULL. ]*/
+                    LogError("Failed allocating the send buffer.");
+                    free(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_BUFFERIO_01_008: [ `bufferio_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+                else if ((result->tick_counter = tickcounter_create()) == NULL)
+                {
+                    /* Codes_SRS_BUFFERIO_01_005: [ If any allocation or call fails, `bufferio_create` shall free all allocated resources and return NULL. ]*/
+                    LogError("Failed creating the tick counter.");
+                    free(result->send_buffer);
+                    free(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_BUFFERIO_01_009: [ `bufferio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+                else if ((result->underlying_io = xio_create(bufferio_config->underlying_io_interface, bufferio_config->underlying_io_parameters)) == NULL)
+                {
+                    /* Codes_SRS_BUFFERIO_01_005: [ If any allocation or call fails, `bufferio_create` shall free all allocated resources and return NULL. ]*/
+                    LogError("Unable to create the underlying IO.");
+                    tickcounter_destroy(result->tick_counter);
+                    free(result->send_buffer);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->bufferio_state = BUFFERIO_STATE_CLOSED;
+                    result->on_io_open_complete = NULL;
+                    result->on_io_open_complete_context = NULL;
+                    result->on_io_error = NULL;
+                    result->on_io_error_context = NULL;
+                    result->on_io_close_complete = NULL;
+                    result->on_io_close_complete_context = NULL;
+                    result->send_buffer_size = 0;
+                    result->first_buffered_ms = 0;
+                    result->pending_sends = NULL;
+                    result->pending_send_count = 0;
+                    result->pending_send_capacity = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void bufferio_destroy(CONCRETE_IO_HANDLE bufferio)
+{
+    if (bufferio == NULL)
+    {
+        /* Codes_SRS_BUFFERIO_01_011: [ If `bufferio` is NULL, `bufferio_destroy` shall do nothing. ]*/
+        LogError("NULL bufferio.");
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        /* sends from the callbacks below are refused */
+        bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+
+        /* Codes_SRS_BUFFERIO_01_012: [ The `on_send_complete` callback of every buffered send shall be called with `IO_SEND_CANCELLED`. ]*/
+        complete_buffered_sends(bufferio_instance, IO_SEND_CANCELLED);
+
+        /* Codes_SRS_BUFFERIO_01_010: [ `bufferio_destroy` shall destroy the underlying IO by calling `xio_destroy` and free all the resources of the instance. ]*/
+        xio_destroy(bufferio_instance->underlying_io);
+        tickcounter_destroy(bufferio_instance->tick_counter);
+        free(bufferio_instance->pending_sends);
+        free(bufferio_instance->send_buffer);
+        free(bufferio_instance);
+    }
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    if (context == NULL)
+    {
+        LogError("NULL context in on_underlying_io_open_complete");
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)context;
+
+        if (bufferio_instance->bufferio_state != BUFFERIO_STATE_OPENING)
+        {
+            LogError("on_underlying_io_open_complete called in an unexpected state.");
+        }
+        else if (open_result == IO_OPEN_OK)
+        {
+            /* Codes_SRS_BUFFERIO_01_017: [ When the underlying IO open completes with `IO_OPEN_OK`, the buffer IO shall be OPEN and `on_io_open_complete` shall be called with `IO_OPEN_OK`. ]*/
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_OPEN;
+            bufferio_instance->on_io_open_complete(bufferio_instance->on_io_open_complete_context, IO_OPEN_OK);
+        }
+        else
+        {
+            /* Codes_SRS_BUFFERIO_01_018: [ When the underlying IO open completes with any other result, the buffer IO shall be CLOSED and `on_io_open_complete` shall be called with the same result. ]*/
+            LogError("Underlying IO open failed");
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+            bufferio_instance->on_io_open_complete(bufferio_instance->on_io_open_complete_context, open_result);
+        }
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    if (context == NULL)
+    {
+        LogError("NULL context in on_underlying_io_error");
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)context;
+
+        switch (bufferio_instance->bufferio_state)
+        {
+        default:
+            LogError("on_underlying_io_error in invalid state");
+            break;
+
+        case BUFFERIO_STATE_OPENING:
+            /* Codes_SRS_BUFFERIO_01_019: [ If the underlying IO indicates an error while OPENING, the buffer IO shall be CLOSED and `on_io_open_complete` shall be called with `IO_OPEN_ERROR`. ]*/
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+            bufferio_instance->on_io_open_complete(bufferio_instance->on_io_open_complete_context, IO_OPEN_ERROR);
+            break;
+
+        case BUFFERIO_STATE_OPEN:
+            /* Codes_SRS_BUFFERIO_01_020: [ If the underlying IO indicates an error while OPEN, the buffer IO shall enter the error state and `on_io_error` shall be called. ]*/
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_ERROR;
+            bufferio_instance->on_io_error(bufferio_instance->on_io_error_context);
+            break;
+        }
+    }
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    if (context == NULL)
+    {
+        LogError("NULL context in on_underlying_io_close_complete");
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)context;
+
+        if (bufferio_instance->bufferio_state != BUFFERIO_STATE_CLOSING)
+        {
+            LogError("on_underlying_io_close_complete called in an invalid state");
+        }
+        else
+        {
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+
+            /* Codes_SRS_BUFFERIO_01_026: [ When the underlying IO close completes, the buffer IO shall be CLOSED and `on_io_close_complete`, if not NULL, shall be called. ]*/
+            if (bufferio_instance->on_io_close_complete != NULL)
+            {
+                bufferio_instance->on_io_close_complete(bufferio_instance->on_io_close_complete_context);
+            }
+        }
+    }
+}
+
+static int bufferio_open(CONCRETE_IO_HANDLE bufferio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if ((bufferio == NULL) ||
+        (on_io_open_complete == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        /* Codes_SRS_BUFFERIO_01_014: [ If `bufferio`, `on_io_open_complete`, `on_bytes_received` or `on_io_error` is NULL, `bufferio_open` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bufferio = %p, on_io_open_complete = %p, on_bytes_received = %p, on_io_error = %p",
+            bufferio, on_io_open_complete, on_bytes_received, on_io_error);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        if (bufferio_instance->bufferio_state != BUFFERIO_STATE_CLOSED)
+        {
+            /* Codes_SRS_BUFFERIO_01_015: [ If the buffer IO is not CLOSED, `bufferio_open` shall fail and return a non-zero value. ]*/
+            LogError("Invalid bufferio_state. Expected state is BUFFERIO_STATE_CLOSED.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            bufferio_instance->on_io_open_complete = on_io_open_complete;
+            bufferio_instance->on_io_open_complete_context = on_io_open_complete_context;
+            bufferio_instance->on_io_error = on_io_error;
+            bufferio_instance->on_io_error_context = on_io_error_context;
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_OPENING;
+
+            /* Codes_SRS_BUFFERIO_01_013: [ `bufferio_open` shall open the underlying IO by calling `xio_open`, passing `on_bytes_received` and `on_bytes_received_context` through unchanged, and on success it shall return 0. ]*/
+            if (xio_open(bufferio_instance->underlying_io, on_underlying_io_open_complete, bufferio_instance, on_bytes_received, on_bytes_received_context, on_underlying_io_error, bufferio_instance) != 0)
+            {
+                /* Codes_SRS_BUFFERIO_01_016: [ If `xio_open` fails, `bufferio_open` shall fail and return a non-zero value. ]*/
+                LogError("Cannot open the underlying IO.");
+                bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int bufferio_close(CONCRETE_IO_HANDLE bufferio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+
+    if (bufferio == NULL)
+    {
+        /* Codes_SRS_BUFFERIO_01_022: [ If `bufferio` is NULL, `bufferio_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL bufferio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        if ((bufferio_instance->bufferio_state == BUFFERIO_STATE_CLOSED) ||
+            (bufferio_instance->bufferio_state == BUFFERIO_STATE_CLOSING))
+        {
+            /* Codes_SRS_BUFFERIO_01_023: [ If the buffer IO is CLOSED or CLOSING, `bufferio_close` shall fail and return a non-zero value. ]*/
+            LogError("Invalid bufferio_state. Expected state is BUFFERIO_STATE_OPEN.");
+            result = __FAILURE__;
+        }
+        else if (bufferio_instance->bufferio_state == BUFFERIO_STATE_OPENING)
+        {
+            /* Codes_SRS_BUFFERIO_01_024: [ `bufferio_close` while OPENING shall close the underlying IO and call `on_io_open_complete` with `IO_OPEN_CANCELLED`. ]*/
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSED;
+            (void)xio_close(bufferio_instance->underlying_io, NULL, NULL);
+            bufferio_instance->on_io_open_complete(bufferio_instance->on_io_open_complete_context, IO_OPEN_CANCELLED);
+            result = 0;
+        }
+        else
+        {
+            BUFFERIO_STATE previous_state = bufferio_instance->bufferio_state;
+
+            if (previous_state == BUFFERIO_STATE_OPEN)
+            {
+                /* Codes_SRS_BUFFERIO_01_025: [ Before closing an OPEN buffer IO, `bufferio_close` shall flush the buffered sends, in the error state it shall call their `on_send_complete` with `IO_SEND_CANCELLED`. ]*/
+                if (flush_buffered_sends(bufferio_instance) != 0)
+                {
+                    LogError("Cannot flush the buffered sends before closing.");
+                }
+            }
+            else
+            {
+                /* Codes_SRS_BUFFERIO_01_025: [ Before closing an OPEN buffer IO, `bufferio_close` shall flush the buffered sends, in the error state it shall call their `on_send_complete` with `IO_SEND_CANCELLED`. ]*/
+                complete_buffered_sends(bufferio_instance, IO_SEND_CANCELLED);
+            }
+
+            bufferio_instance->bufferio_state = BUFFERIO_STATE_CLOSING;
+            bufferio_instance->on_io_close_complete = on_io_close_complete;
+            bufferio_instance->on_io_close_complete_context = on_io_close_complete_context;
+
+            /* Codes_SRS_BUFFERIO_01_021: [ `bufferio_close` shall close the underlying IO by calling `xio_close` and on success it shall return 0. ]*/
+            if (xio_close(bufferio_instance->underlying_io, on_underlying_io_close_complete, bufferio_instance) != 0)
+            {
+                /* Codes_SRS_BUFFERIO_01_027: [ If `xio_close` fails, `bufferio_close` shall fail and return a non-zero value. ]*/
+                LogError("Cannot close underlying IO.");
+                bufferio_instance->bufferio_state = previous_state;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int add_pending_send(BUFFERIO_INSTANCE* bufferio_instance, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if (bufferio_instance->pending_send_count == bufferio_instance->pending_send_capacity)
+    {
+        size_t new_capacity = (bufferio_instance->pending_send_capacity == 0) ? INITIAL_PENDING_SEND_CAPACITY : (bufferio_instance->pending_send_capacity * 2);
+        PENDING_SEND* new_pending_sends = (PENDING_SEND*)realloc(bufferio_instance->pending_sends, new_capacity * sizeof(PENDING_SEND));
+        if (new_pending_sends == NULL)
+        {
+            LogError("Cannot allocate memory for the pending sends");
+            result = __FAILURE__;
+        }
+        else
+        {
+            bufferio_instance->pending_sends = new_pending_sends;
+            bufferio_instance->pending_send_capacity = new_capacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        size_t i;
+
+        if ((bufferio_instance->send_buffer_size == 0) &&
+            (tickcounter_get_current_ms(bufferio_instance->tick_counter, &bufferio_instance->first_buffered_ms) != 0))
+        {
+            /* without a time the bytes are flushed by the next bufferio_dowork */
+            LogError("Cannot get the current time");
+            bufferio_instance->first_buffered_ms = 0;
+        }
+
+        for (i = 0; i < buffer_count; i++)
+        {
+            if (buffers[i].size > 0)
+            {
+                (void)memcpy(bufferio_instance->send_buffer + bufferio_instance->send_buffer_size, buffers[i].buffer, buffers[i].size);
+                bufferio_instance->send_buffer_size += buffers[i].size;
+            }
+        }
+
+        bufferio_instance->pending_sends[bufferio_instance->pending_send_count].on_send_complete = on_send_complete;
+        bufferio_instance->pending_sends[bufferio_instance->pending_send_count].on_send_complete_context = on_send_complete_context;
+        bufferio_instance->pending_send_count++;
+    }
+
+    return result;
+}
+
+static int buffer_or_send(BUFFERIO_INSTANCE* bufferio_instance, const CONSTBUFFER* buffers, size_t buffer_count, size_t size, int is_vectored, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if (bufferio_instance->bufferio_state != BUFFERIO_STATE_OPEN)
+    {
+        /* Codes_SRS_BUFFERIO_01_037: [ If the buffer IO is not OPEN, `bufferio_send` shall fail and return a non-zero value. ]*/
+        LogError("Invalid bufferio_state. Expected state is BUFFERIO_STATE_OPEN.");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_BUFFERIO_01_038: [ If the buffered bytes and `size` together exceed `max_buffered_bytes`, the buffered sends shall be flushed first. ]*/
+    else if ((bufferio_instance->send_buffer_size + size > bufferio_instance->max_buffered_bytes) &&
+        (flush_buffered_sends(bufferio_instance) != 0))
+    {
+        /* Codes_SRS_BUFFERIO_01_039: [ If flushing before the send fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+        LogError("Cannot flush the buffered sends.");
+        result = __FAILURE__;
+    }
+    else if (size >= bufferio_instance->max_buffered_bytes)
+    {
+        /* Codes_SRS_BUFFERIO_01_040: [ A send of `max_buffered_bytes` or more shall not be buffered, it shall be passed to `xio_send` on the underlying IO with its own `on_send_complete` and `on_send_complete_context`. ]*/
+        /* Codes_SRS_BUFFERIO_01_055: [ A vectored send of `max_buffered_bytes` or more shall not be buffered, it shall be passed to `xio_send_vectored` on the underlying IO with its own `on_send_complete` and `on_send_complete_context`. ]*/
+        if (((is_vectored == 0) && (xio_send(bufferio_instance->underlying_io, buffers[0].buffer, size, on_send_complete, on_send_complete_context) != 0)) ||
+            ((is_vectored != 0) && (xio_send_vectored(bufferio_instance->underlying_io, buffers, buffer_count, on_send_complete, on_send_complete_context) != 0)))
+        {
+            /* Codes_SRS_BUFFERIO_01_041: [ If `xio_send` fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+            LogError("Underlying send failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    /* Codes_SRS_BUFFERIO_01_034: [ `bufferio_send` shall copy the `size` bytes pointed to by `buffer` at the end of the send buffer, remember `on_send_complete` and `on_send_complete_context`, and on success it shall return 0. ]*/
+    else if (add_pending_send(bufferio_instance, buffers, buffer_count, on_send_complete, on_send_complete_context) != 0)
+    {
+        /* Codes_SRS_BUFFERIO_01_042: [ If allocating memory for the send fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFERIO_01_043: [ When the send buffer is full, the buffered sends shall be flushed before `bufferio_send` returns. ]*/
+        if ((bufferio_instance->send_buffer_size == bufferio_instance->max_buffered_bytes) &&
+            (flush_buffered_sends(bufferio_instance) != 0))
+        {
+            /* the send was accepted, its failure was indicated through on_send_complete */
+            LogError("Cannot flush the full send buffer.");
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int bufferio_send(CONCRETE_IO_HANDLE bufferio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    /* Codes_SRS_BUFFERIO_01_036: [ `on_send_complete` shall be allowed to be NULL. ]*/
+    if ((bufferio == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Codes_SRS_BUFFERIO_01_035: [ If `bufferio` or `buffer` is NULL or `size` is 0, `bufferio_send` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bufferio = %p, buffer = %p, size = %lu.", bufferio, buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CONSTBUFFER send_buffer;
+        send_buffer.buffer = (const unsigned char*)buffer;
+        send_buffer.size = size;
+
+        result = buffer_or_send((BUFFERIO_INSTANCE*)bufferio, &send_buffer, 1, size, 0, on_send_complete, on_send_complete_context);
+    }
+
+    return result;
+}
+
+static int bufferio_send_vectored(CONCRETE_IO_HANDLE bufferio, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((bufferio == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        /* Codes_SRS_BUFFERIO_01_056: [ If `bufferio` or `buffers` is NULL or `buffer_count` is 0, `bufferio_send_vectored` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: bufferio = %p, buffers = %p, buffer_count = %lu.", bufferio, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t size = 0;
+        size_t i;
+
+        for (i = 0; i < buffer_count; i++)
+        {
+            size += buffers[i].size;
+        }
+
+        if (size == 0)
+        {
+            /* Codes_SRS_BUFFERIO_01_056: [ If `bufferio` or `buffers` is NULL or `buffer_count` is 0, `bufferio_send_vectored` shall fail and return a non-zero value. ]*/
+            LogError("Nothing to send.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_BUFFERIO_01_054: [ `bufferio_send_vectored` shall buffer the segments in order exactly like `bufferio_send` buffers one buffer, so a vectored send completes through a single `on_send_complete` call. ]*/
+            result = buffer_or_send((BUFFERIO_INSTANCE*)bufferio, buffers, buffer_count, size, 1, on_send_complete, on_send_complete_context);
+        }
+    }
+
+    return result;
+}
+
+static void bufferio_dowork(CONCRETE_IO_HANDLE bufferio)
+{
+    if (bufferio == NULL)
+    {
+        /* Codes_SRS_BUFFERIO_01_045: [ If `bufferio` is NULL, `bufferio_dowork` shall do nothing. ]*/
+        LogError("NULL bufferio.");
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        if ((bufferio_instance->bufferio_state == BUFFERIO_STATE_OPEN) &&
+            (bufferio_instance->send_buffer_size > 0))
+        {
+            tickcounter_ms_t current_ms;
+
+            /* Codes_SRS_BUFFERIO_01_046: [ If `max_delay_ms` is 0, `bufferio_dowork` shall flush the buffered sends. ]*/
+            /* Codes_SRS_BUFFERIO_01_047: [ Otherwise the buffered sends shall be flushed once `max_delay_ms` have passed since the first of them was buffered, or when the current time cannot be obtained. ]*/
+            if ((bufferio_instance->max_delay_ms == 0) ||
+                (tickcounter_get_current_ms(bufferio_instance->tick_counter, &current_ms) != 0) ||
+                (current_ms - bufferio_instance->first_buffered_ms >= bufferio_instance->max_delay_ms))
+            {
+                if (flush_buffered_sends(bufferio_instance) != 0)
+                {
+                    LogError("Cannot flush the buffered sends.");
+                }
+            }
+        }
+
+        if (bufferio_instance->bufferio_state != BUFFERIO_STATE_CLOSED)
+        {
+            /* Codes_SRS_BUFFERIO_01_044: [ `bufferio_dowork` shall call `xio_dowork` on the underlying IO after the flush, so the flushed bytes go out in the same call. ]*/
+            xio_dowork(bufferio_instance->underlying_io);
+        }
+    }
+}
+
+static int bufferio_set_option(CONCRETE_IO_HANDLE bufferio, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((bufferio == NULL) || (option_name == NULL))
+    {
+        /* Codes_SRS_BUFFERIO_01_049: [ If `bufferio` or `option_name` is NULL, `bufferio_set_option` shall return a non-zero value. ]*/
+        LogError("Bad arguments: bufferio = %p, option_name = %p", bufferio, option_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        /* Codes_SRS_BUFFERIO_01_048: [ `bufferio_set_option` shall pass all options to the underlying IO by calling `xio_setoption`. ]*/
+        if (xio_setoption(bufferio_instance->underlying_io, option_name, value) != 0)
+        {
+            /* Codes_SRS_BUFFERIO_01_050: [ If `xio_setoption` fails, `bufferio_set_option` shall return a non-zero value. ]*/
+            LogError("Unrecognized option");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE bufferio_retrieve_options(CONCRETE_IO_HANDLE bufferio)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (bufferio == NULL)
+    {
+        /* Codes_SRS_BUFFERIO_01_052: [ If `bufferio` is NULL, `bufferio_retrieve_options` shall fail and return NULL. ]*/
+        LogError("invalid parameter detected: CONCRETE_IO_HANDLE handle=%p", bufferio);
+        result = NULL;
+    }
+    else
+    {
+        BUFFERIO_INSTANCE* bufferio_instance = (BUFFERIO_INSTANCE*)bufferio;
+
+        /* Codes_SRS_BUFFERIO_01_051: [ `bufferio_retrieve_options` shall return the result of `xio_retrieveoptions` on the underlying IO. ]*/
+        result = xio_retrieveoptions(bufferio_instance->underlying_io);
+        if (result == NULL)
+        {
+            LogError("unable to create option handler");
+        }
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION bufferio_interface_description =
+{
+    bufferio_retrieve_options,
+    bufferio_create,
+    bufferio_destroy,
+    bufferio_open,
+    bufferio_close,
+    bufferio_send,
+    bufferio_dowork,
+    bufferio_set_option,
+    bufferio_send_vectored
+};
+
+const IO_INTERFACE_DESCRIPTION* bufferio_get_interface_description(void)
+{
+    /* Codes_SRS_BUFFERIO_01_053: [ `bufferio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `bufferio_retrieve_options`, `bufferio_create`, `bufferio_destroy`, `bufferio_open`, `bufferio_close`, `bufferio_send`, `bufferio_dowork`, `bufferio_set_option` and `bufferio_send_vectored`. ]*/
+    return &bufferio_interface_description;
+}
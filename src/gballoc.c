@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+#include <assert.h>
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -15,6 +17,404 @@
 #define SIZE_MAX ((size_t)~(size_t)0)
 #endif
 
+#if defined(GB_USE_HEADER_TRACKING)
+
+/* In this mode the size of every block lives in a header placed in front of the block handed out to the caller,
+so free and realloc do not have to search for it. Counters are split in shards updated with atomic operations
+and summed up when queried, so the lock is not taken on the allocation paths.
+Each shard also keeps the highest total it reached, so an allocation only touches the cache line of its own shard;
+the maximum reported is the sum of those, which is never below the real maximum. Every pointer passed to gballoc_free and gballoc_realloc has to come from gballoc: its header is read in front of it,
+so any other pointer is a caller bug. Such a pointer is reported through GBALLOC_UNTRACKED_POINTER, which stops debug
+builds, and is left alone otherwise. */
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define GBALLOC_ATOMIC_ADD(var, value) ((size_t)InterlockedExchangeAddSizeT(&(var), (value)) + (size_t)(value))
+#define GBALLOC_ATOMIC_COMPARE_AND_SWAP(var, expected, desired) (InterlockedCompareExchangePointer((PVOID volatile*)&(var), (PVOID)(desired), (PVOID)(expected)) == (PVOID)(expected))
+#elif defined(__GNUC__)
+#define GBALLOC_ATOMIC_ADD(var, value) __sync_add_and_fetch(&(var), (value))
+#define GBALLOC_ATOMIC_COMPARE_AND_SWAP(var, expected, desired) __sync_bool_compare_and_swap(&(var), (expected), (desired))
+#else
+#error GB_USE_HEADER_TRACKING needs atomic operations, which are only wired for gcc compatible compilers and MSVC
+#endif
+
+#define GBALLOC_SHARD_COUNT 16
+#define GBALLOC_CACHE_LINE_SIZE 64
+#define GBALLOC_HEADER_SIGNATURE ((size_t)0x6762616C)
+
+#ifndef GBALLOC_UNTRACKED_POINTER
+#define GBALLOC_UNTRACKED_POINTER(ptr) assert(!"pointer was not allocated by gballoc")
+#endif
+
+typedef union GBALLOC_HEADER_TAG
+{
+    struct
+    {
+        size_t size;
+        size_t signature;
+    } info;
+    /* the members below only give the header the alignment of the blocks returned by malloc */
+    double alignDouble;
+    long long alignLongLong;
+    void* alignPointer;
+} GBALLOC_HEADER;
+
+typedef struct GBALLOC_SHARD_TAG
+{
+    volatile size_t totalSize;
+    volatile size_t maxSize;
+    volatile size_t allocations;
+    /* keeps every shard on its own cache line */
+    unsigned char padding[GBALLOC_CACHE_LINE_SIZE - (3 * sizeof(size_t))];
+} GBALLOC_SHARD;
+
+typedef enum GBALLOC_STATE_TAG
+{
+    GBALLOC_STATE_INIT,
+    GBALLOC_STATE_NOT_INIT
+} GBALLOC_STATE;
+
+static GBALLOC_SHARD shards[GBALLOC_SHARD_COUNT];
+static GBALLOC_STATE gballocState = GBALLOC_STATE_NOT_INIT;
+
+static LOCK_HANDLE gballocThreadSafeLock = NULL;
+
+static GBALLOC_SHARD* get_shard(const void* block)
+{
+    /* blocks are at least 8 bytes aligned, the low bits carry no information */
+    uintptr_t hash = ((uintptr_t)block >> 4) * (uintptr_t)2654435761u;
+    return &shards[(hash >> 8) % GBALLOC_SHARD_COUNT];
+}
+
+static size_t get_total_size(void)
+{
+    size_t result = 0;
+    size_t i;
+    for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+    {
+        result += shards[i].totalSize;
+    }
+    return result;
+}
+
+static void update_maximum(GBALLOC_SHARD* shard, size_t shardTotal)
+{
+    size_t currentMax = shard->maxSize;
+
+    /* Codes_SRS_GBALLOC_01_056: [ When GB_USE_HEADER_TRACKING is defined, every shard shall keep the maximum of its own total memory used. ]*/
+    /* a shard total below zero wraps around, the signed comparison keeps it from becoming a huge maximum */
+    while (((ptrdiff_t)currentMax < (ptrdiff_t)shardTotal) &&
+        (!GBALLOC_ATOMIC_COMPARE_AND_SWAP(shard->maxSize, currentMax, shardTotal)))
+    {
+        currentMax = shard->maxSize;
+    }
+}
+
+/* the signature depends on where the header is and on the size it holds, so a stale or foreign block is unlikely to match */
+static size_t get_signature(const GBALLOC_HEADER* header)
+{
+    return GBALLOC_HEADER_SIGNATURE ^ (size_t)(uintptr_t)header ^ header->info.size;
+}
+
+static void count_allocation(GBALLOC_HEADER* header, size_t size)
+{
+    GBALLOC_SHARD* shard = get_shard(header);
+
+    header->info.size = size;
+    header->info.signature = get_signature(header);
+
+    if (gballocState == GBALLOC_STATE_INIT)
+    {
+        size_t shardTotal = GBALLOC_ATOMIC_ADD(shard->totalSize, size);
+        (void)GBALLOC_ATOMIC_ADD(shard->allocations, 1);
+        if (size > 0)
+        {
+            update_maximum(shard, shardTotal);
+        }
+    }
+}
+
+static void uncount_allocation(GBALLOC_HEADER* header)
+{
+    if (gballocState == GBALLOC_STATE_INIT)
+    {
+        GBALLOC_SHARD* shard = get_shard(header);
+        /* shards may go below zero individually, only their sum is meaningful */
+        (void)GBALLOC_ATOMIC_ADD(shard->totalSize, (size_t)0 - header->info.size);
+    }
+}
+
+static GBALLOC_HEADER* get_header(void* ptr)
+{
+    GBALLOC_HEADER* result = (GBALLOC_HEADER*)ptr - 1;
+    if (result->info.signature != get_signature(result))
+    {
+        GBALLOC_UNTRACKED_POINTER(ptr);
+        result = NULL;
+    }
+    return result;
+}
+
+int gballoc_init(void)
+{
+    int result;
+
+    if (gballocState != GBALLOC_STATE_NOT_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_025: [Init after Init shall fail and return a non-zero value.] */
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_GBALLOC_01_026: [gballoc_Init shall create a lock handle that will be used to make the other gballoc APIs thread-safe.] */
+    else if ((gballocThreadSafeLock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_027: [If the Lock creation fails, gballoc_init shall return a non-zero value.]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_ SRS_GBALLOC_01_002: [Upon initialization the total memory used and maximum total memory used tracked by the module shall be set to 0.] */
+        (void)memset((void*)shards, 0, sizeof(shards));
+
+        gballocState = GBALLOC_STATE_INIT;
+
+        /* Codes_SRS_GBALLOC_01_024: [gballoc_init shall initialize the gballoc module and return 0 upon success.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+void gballoc_deinit(void)
+{
+    if (gballocState == GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_028: [gballoc_deinit shall free all resources allocated by gballoc_init.] */
+        (void)Lock_Deinit(gballocThreadSafeLock);
+    }
+
+    gballocState = GBALLOC_STATE_NOT_INIT;
+}
+
+void* gballoc_malloc(size_t size)
+{
+    void* result;
+
+    if (size > SIZE_MAX - sizeof(GBALLOC_HEADER))
+    {
+        LogError("Invalid size %lu", (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_052: [ When GB_USE_HEADER_TRACKING is defined, gballoc_malloc shall allocate size bytes plus a header holding size and return the memory following the header. ]*/
+        GBALLOC_HEADER* header = (GBALLOC_HEADER*)malloc(sizeof(GBALLOC_HEADER) + size);
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
+            count_allocation(header, size);
+            result = header + 1;
+        }
+    }
+
+    return result;
+}
+
+void* gballoc_calloc(size_t nmemb, size_t size)
+{
+    void* result;
+
+    if ((size != 0) && (nmemb > (SIZE_MAX - sizeof(GBALLOC_HEADER)) / size))
+    {
+        LogError("Invalid size %lu * %lu", (unsigned long)nmemb, (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_053: [ When GB_USE_HEADER_TRACKING is defined, gballoc_calloc shall call calloc for nmemb * size bytes plus the header. ]*/
+        GBALLOC_HEADER* header = (GBALLOC_HEADER*)calloc(1, sizeof(GBALLOC_HEADER) + (nmemb * size));
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_022: [When the underlying calloc call fails, gballoc_calloc shall return NULL and size should not be counted towards total memory used.] */
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
+            count_allocation(header, nmemb * size);
+            result = header + 1;
+        }
+    }
+
+    return result;
+}
+
+void* gballoc_realloc(void* ptr, size_t size)
+{
+    void* result;
+    GBALLOC_HEADER* header = NULL;
+
+    /* Codes_SRS_GBALLOC_01_017: [When ptr is NULL, gballoc_realloc shall call the underlying realloc with ptr being NULL and the realloc result shall be tracked by gballoc.] */
+    /* Codes_SRS_GBALLOC_01_054: [ When GB_USE_HEADER_TRACKING is defined, gballoc_realloc and gballoc_free shall find the size of ptr in its header without searching and without acquiring the lock. ]*/
+    if ((ptr != NULL) && ((header = get_header(ptr)) == NULL))
+    {
+        /* Codes_SRS_GBALLOC_01_016: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_realloc shall return NULL and the underlying realloc shall not be called.] */
+        LogError("Could not realloc allocation for address %p (not found)", ptr);
+        result = NULL;
+    }
+    else if (size > SIZE_MAX - sizeof(GBALLOC_HEADER))
+    {
+        LogError("Invalid size %lu", (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        GBALLOC_HEADER* oldHeader = header;
+        size_t oldSize = (oldHeader == NULL) ? 0 : oldHeader->info.size;
+        /* the size is taken off the shard the old block was counted in, picked before realloc frees it */
+        GBALLOC_SHARD* oldShard = (oldHeader == NULL) ? NULL : get_shard(oldHeader);
+        GBALLOC_HEADER* newHeader = (GBALLOC_HEADER*)realloc(oldHeader, sizeof(GBALLOC_HEADER) + size);
+        if (newHeader == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+            result = NULL;
+        }
+        else
+        {
+            if ((oldShard != NULL) && (gballocState == GBALLOC_STATE_INIT))
+            {
+                /* Codes_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
+                (void)GBALLOC_ATOMIC_ADD(oldShard->totalSize, (size_t)0 - oldSize);
+            }
+
+            /* Codes_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
+            count_allocation(newHeader, size);
+            result = newHeader + 1;
+        }
+    }
+
+    return result;
+}
+
+void gballoc_free(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        GBALLOC_HEADER* header = get_header(ptr);
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_019: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_free shall not free any memory.] */
+            LogError("Could not free allocation for address %p (not found)", ptr);
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_009: [gballoc_free shall also look up the size associated with the ptr pointer and decrease the total memory used with the associated size amount.] */
+            uncount_allocation(header);
+            header->info.signature = 0;
+
+            /* Codes_SRS_GBALLOC_01_008: [gballoc_free shall call the C99 free function.] */
+            free(header);
+        }
+    }
+}
+
+size_t gballoc_getMaximumMemoryUsed(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_01_038: [If gballoc was not initialized gballoc_getMaximumMemoryUsed shall return MAX_INT_SIZE.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_GBALLOC_01_010: [gballoc_getMaximumMemoryUsed shall return the maximum amount of total memory used recorded since the module initialization.] */
+        /* Codes_SRS_GBALLOC_01_057: [ When GB_USE_HEADER_TRACKING is defined, gballoc_getMaximumMemoryUsed shall return the sum of the per shard maximums. ]*/
+        result = 0;
+        for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+        {
+            result += shards[i].maxSize;
+        }
+    }
+
+    return result;
+}
+
+size_t gballoc_getCurrentMemoryUsed(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_01_044: [If gballoc was not initialized gballoc_getCurrentMemoryUsed shall return SIZE_MAX.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_055: [ When GB_USE_HEADER_TRACKING is defined, gballoc_getCurrentMemoryUsed and gballoc_getAllocationCount shall return the sum of the per shard counters. ]*/
+        result = get_total_size();
+    }
+
+    return result;
+}
+
+size_t gballoc_getAllocationCount(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_07_001: [ If gballoc was not initialized gballoc_getAllocationCount shall return 0. ] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = 0;
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_GBALLOC_07_004: [ gballoc_getAllocationCount shall return the currently number of allocations. ] */
+        result = 0;
+        for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+        {
+            result += shards[i].allocations;
+        }
+    }
+
+    return result;
+}
+
+void gballoc_resetMetrics()
+{
+    /* Codes_SRS_GBALLOC_07_005: [ If gballoc was not initialized gballoc_reset Metrics shall do nothing.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+    }
+    /* Codes_SRS_GBALLOC_07_006: [ gballoc_resetMetrics shall ensure thread safety by using the lock created by gballoc_Init ]*/
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_07_007: [ If the lock cannot be acquired, gballoc_reset Metrics shall do nothing.] */
+        LogError("Failed to get the Lock.");
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
+        (void)memset((void*)shards, 0, sizeof(shards));
+        (void)Unlock(gballocThreadSafeLock);
+    }
+}
+
+#else /* GB_USE_HEADER_TRACKING */
+
 typedef struct ALLOCATION_TAG
 {
     size_t size;
@@ -287,7 +687,7 @@ void* gballoc_realloc(void* ptr, size_t size)
 
 void gballoc_free(void* ptr)
 {
-    ALLOCATION* curr = head;
+    ALLOCATION* curr;
     ALLOCATION* prev = NULL;
 
     if (gballocState != GBALLOC_STATE_INIT)
@@ -304,6 +704,8 @@ void gballoc_free(void* ptr)
     else
     {
         /* Codes_SRS_GBALLOC_01_009: [gballoc_free shall also look up the size associated with the ptr pointer and decrease the total memory used with the associated size amount.] */
+        /* head is only read once the lock is held */
+        curr = head;
         while (curr != NULL)
         {
             if (curr->ptr == ptr)
@@ -443,4 +845,6 @@ void gballoc_resetMetrics()
     }
 }
 
+#endif /* GB_USE_HEADER_TRACKING */
+
 #endif // GB_USE_CUSTOM_HEAP
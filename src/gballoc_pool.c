@@ -0,0 +1,629 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* the pool gets its own memory from the C runtime, these wrappers are defined before gballoc.h redirects malloc to the pool */
+static void* system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void system_free(void* ptr)
+{
+    free(ptr);
+}
+
+#ifndef GB_USE_CUSTOM_HEAP
+#error gballoc_pool.c implements the custom heap and is only built with GB_USE_CUSTOM_HEAP defined
+#endif
+
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/gballoc_pool.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)~(size_t)0)
+#endif
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define GBALLOC_POOL_THREAD_LOCAL __declspec(thread)
+#define GBALLOC_POOL_THREAD_EXIT_CALLBACK(name, value) static VOID WINAPI name(PVOID value)
+#define GBALLOC_POOL_SPIN_PAUSE() YieldProcessor()
+#define GBALLOC_POOL_YIELD() (void)SwitchToThread()
+#define GBALLOC_POOL_SPIN_TRY_ACQUIRE(lock) (InterlockedExchange(&(lock), 1) == 0)
+#define GBALLOC_POOL_SPIN_IS_LOCKED(lock) ((lock) != 0)
+#define GBALLOC_POOL_SPIN_RELEASE(lock) (void)InterlockedExchange(&(lock), 0)
+#define GBALLOC_POOL_ATOMIC_INCREMENT(var) (void)InterlockedIncrementSizeT(&(var))
+typedef LONG GBALLOC_POOL_SPIN_LOCK;
+#elif defined(__GNUC__)
+#include <sched.h>
+#include <pthread.h>
+#define GBALLOC_POOL_THREAD_LOCAL __thread
+#define GBALLOC_POOL_THREAD_EXIT_CALLBACK(name, value) static void name(void* value)
+#if defined(__i386__) || defined(__x86_64__)
+#define GBALLOC_POOL_SPIN_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define GBALLOC_POOL_SPIN_PAUSE() __asm__ __volatile__("yield")
+#else
+#define GBALLOC_POOL_SPIN_PAUSE() ((void)0)
+#endif
+#define GBALLOC_POOL_YIELD() (void)sched_yield()
+#define GBALLOC_POOL_SPIN_TRY_ACQUIRE(lock) (__sync_lock_test_and_set(&(lock), 1) == 0)
+#define GBALLOC_POOL_SPIN_IS_LOCKED(lock) (__atomic_load_n(&(lock), __ATOMIC_RELAXED) != 0)
+#define GBALLOC_POOL_SPIN_RELEASE(lock) __sync_lock_release(&(lock))
+#define GBALLOC_POOL_ATOMIC_INCREMENT(var) (void)__sync_add_and_fetch(&(var), 1)
+typedef int GBALLOC_POOL_SPIN_LOCK;
+#else
+#error gballoc_pool needs atomic operations, which are only wired for gcc compatible compilers and MSVC
+#endif
+
+/* blocks of up to 256 bytes are pooled in classes 16 bytes apart up to 64, then further apart */
+static const size_t class_sizes[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+#define GBALLOC_POOL_CLASS_COUNT (sizeof(class_sizes) / sizeof(class_sizes[0]))
+#define GBALLOC_POOL_MAX_CLASS_SIZE 256
+#define GBALLOC_POOL_LARGE_CLASS ((size_t)~(size_t)0)
+/* class index held by the header of a block that is in a free list, so that freeing it again is caught */
+#define GBALLOC_POOL_FREE_CLASS ((size_t)~(size_t)1)
+
+/* number of blocks carved out of one slab */
+#define GBALLOC_POOL_SLAB_BLOCK_COUNT 64
+/* a thread moves this many blocks at a time between its cache and the class */
+#define GBALLOC_POOL_CACHE_BATCH 16
+/* a thread never keeps more than this many free blocks of one class */
+#define GBALLOC_POOL_CACHE_MAX (2 * GBALLOC_POOL_CACHE_BATCH)
+/* a thread waiting for a class lock spins this many times before giving its timeslice to the holder */
+#define GBALLOC_POOL_SPIN_COUNT 64
+/* statistics kept by a thread are merged into the class at least every this many allocations and frees */
+#define GBALLOC_POOL_STATISTICS_BATCH 64
+
+typedef union POOL_HEADER_TAG
+{
+    struct
+    {
+        size_t class_index;
+        size_t size;
+    } info;
+    /* the members below only give the header the alignment of the blocks returned by malloc */
+    double alignDouble;
+    long long alignLongLong;
+    void* alignPointer;
+} POOL_HEADER;
+
+/* free blocks are chained through their payload */
+typedef struct POOL_FREE_BLOCK_TAG
+{
+    struct POOL_FREE_BLOCK_TAG* next;
+} POOL_FREE_BLOCK;
+
+typedef struct POOL_CLASS_TAG
+{
+    volatile GBALLOC_POOL_SPIN_LOCK lock;
+    POOL_FREE_BLOCK* free_list;
+    size_t blocks_reserved;
+    size_t allocations;
+    size_t frees;
+    size_t cache_hits;
+} POOL_CLASS;
+
+typedef struct THREAD_CACHE_TAG
+{
+    POOL_FREE_BLOCK* free_list[GBALLOC_POOL_CLASS_COUNT];
+    size_t count[GBALLOC_POOL_CLASS_COUNT];
+    /* statistics not yet added to the class, they are merged whenever the class lock is taken */
+    size_t allocations[GBALLOC_POOL_CLASS_COUNT];
+    size_t frees[GBALLOC_POOL_CLASS_COUNT];
+    size_t cache_hits[GBALLOC_POOL_CLASS_COUNT];
+    /* set once the thread has asked to have its cache given back when it exits */
+    int exit_registered;
+} THREAD_CACHE;
+
+static POOL_CLASS pool_classes[GBALLOC_POOL_CLASS_COUNT];
+static volatile size_t large_allocations = 0;
+static GBALLOC_POOL_THREAD_LOCAL THREAD_CACHE thread_cache;
+
+static size_t get_class_index(size_t size)
+{
+    size_t result;
+    if (size > GBALLOC_POOL_MAX_CLASS_SIZE)
+    {
+        result = GBALLOC_POOL_LARGE_CLASS;
+    }
+    else
+    {
+        result = 0;
+        while (class_sizes[result] < size)
+        {
+            result++;
+        }
+    }
+    return result;
+}
+
+/* returns NULL when the header in front of ptr does not describe a block in use, which happens for a block that was
+already freed and usually for a pointer that did not come from the pool, rather than letting it corrupt a free list */
+static POOL_HEADER* get_header(void* ptr)
+{
+    POOL_HEADER* result = (POOL_HEADER*)ptr - 1;
+    size_t class_index = result->info.class_index;
+
+    if ((class_index != GBALLOC_POOL_LARGE_CLASS) &&
+        ((class_index >= GBALLOC_POOL_CLASS_COUNT) || (result->info.size > class_sizes[class_index])))
+    {
+        result = NULL;
+    }
+
+    return result;
+}
+
+static void* get_payload(POOL_HEADER* header)
+{
+    return header + 1;
+}
+
+static void lock_class(POOL_CLASS* pool_class)
+{
+    unsigned int spins = 0;
+
+    while (!GBALLOC_POOL_SPIN_TRY_ACQUIRE(pool_class->lock))
+    {
+        /* the lock is only held for a handful of pointer updates, a holder that keeps it longer has likely been preempted */
+        do
+        {
+            if (++spins < GBALLOC_POOL_SPIN_COUNT)
+            {
+                GBALLOC_POOL_SPIN_PAUSE();
+            }
+            else
+            {
+                GBALLOC_POOL_YIELD();
+                spins = 0;
+            }
+        } while (GBALLOC_POOL_SPIN_IS_LOCKED(pool_class->lock));
+    }
+}
+
+static void unlock_class(POOL_CLASS* pool_class)
+{
+    GBALLOC_POOL_SPIN_RELEASE(pool_class->lock);
+}
+
+/* must be called with the class lock held */
+static void merge_thread_statistics(size_t class_index)
+{
+    POOL_CLASS* pool_class = &pool_classes[class_index];
+
+    pool_class->allocations += thread_cache.allocations[class_index];
+    pool_class->frees += thread_cache.frees[class_index];
+    pool_class->cache_hits += thread_cache.cache_hits[class_index];
+    thread_cache.allocations[class_index] = 0;
+    thread_cache.frees[class_index] = 0;
+    thread_cache.cache_hits[class_index] = 0;
+}
+
+static void flush_thread_statistics(size_t class_index)
+{
+    if ((thread_cache.allocations[class_index] + thread_cache.frees[class_index]) >= GBALLOC_POOL_STATISTICS_BATCH)
+    {
+        POOL_CLASS* pool_class = &pool_classes[class_index];
+        lock_class(pool_class);
+        merge_thread_statistics(class_index);
+        unlock_class(pool_class);
+    }
+}
+
+/* must be called with the class lock held */
+static int reserve_slab(size_t class_index)
+{
+    int result;
+    size_t stride = sizeof(POOL_HEADER) + class_sizes[class_index];
+    unsigned char* slab = (unsigned char*)system_malloc(stride * GBALLOC_POOL_SLAB_BLOCK_COUNT);
+    if (slab == NULL)
+    {
+        /* no logging here, logging may allocate from this very class */
+        result = __FAILURE__;
+    }
+    else
+    {
+        POOL_CLASS* pool_class = &pool_classes[class_index];
+        size_t i;
+
+        /* slabs are kept for the lifetime of the process, their blocks are recycled through the free lists */
+        for (i = 0; i < GBALLOC_POOL_SLAB_BLOCK_COUNT; i++)
+        {
+            POOL_HEADER* header = (POOL_HEADER*)(slab + (i * stride));
+            POOL_FREE_BLOCK* block = (POOL_FREE_BLOCK*)get_payload(header);
+            header->info.class_index = GBALLOC_POOL_FREE_CLASS;
+            block->next = pool_class->free_list;
+            pool_class->free_list = block;
+        }
+
+        pool_class->blocks_reserved += GBALLOC_POOL_SLAB_BLOCK_COUNT;
+        result = 0;
+    }
+    return result;
+}
+
+/* moves up to a batch of blocks from the class to the thread cache */
+static void refill_thread_cache(size_t class_index)
+{
+    POOL_CLASS* pool_class = &pool_classes[class_index];
+    size_t moved = 0;
+
+    lock_class(pool_class);
+
+    merge_thread_statistics(class_index);
+
+    /* Codes_SRS_GBALLOC_POOL_01_004: [ If the class has no free blocks, gballoc_malloc shall allocate a slab of 64 blocks by calling malloc. ]*/
+    if ((pool_class->free_list != NULL) ||
+        (reserve_slab(class_index) == 0))
+    {
+        while ((moved < GBALLOC_POOL_CACHE_BATCH) &&
+            (pool_class->free_list != NULL))
+        {
+            POOL_FREE_BLOCK* block = pool_class->free_list;
+            pool_class->free_list = block->next;
+            block->next = thread_cache.free_list[class_index];
+            thread_cache.free_list[class_index] = block;
+            moved++;
+        }
+    }
+
+    unlock_class(pool_class);
+
+    if (moved == 0)
+    {
+        LogError("Cannot allocate a slab for %lu byte blocks", (unsigned long)class_sizes[class_index]);
+    }
+
+    thread_cache.count[class_index] += moved;
+}
+
+/* gives block_count blocks from the thread cache back to the class */
+static void drain_thread_cache(size_t class_index, size_t block_count)
+{
+    POOL_CLASS* pool_class = &pool_classes[class_index];
+    size_t moved = 0;
+
+    lock_class(pool_class);
+
+    merge_thread_statistics(class_index);
+
+    while (moved < block_count)
+    {
+        POOL_FREE_BLOCK* block = thread_cache.free_list[class_index];
+        thread_cache.free_list[class_index] = block->next;
+        block->next = pool_class->free_list;
+        pool_class->free_list = block;
+        moved++;
+    }
+
+    unlock_class(pool_class);
+
+    thread_cache.count[class_index] -= moved;
+}
+
+/* gives every cached block and the statistics of the calling thread back to the classes */
+static void release_thread_cache(void)
+{
+    size_t class_index;
+    for (class_index = 0; class_index < GBALLOC_POOL_CLASS_COUNT; class_index++)
+    {
+        drain_thread_cache(class_index, thread_cache.count[class_index]);
+    }
+}
+
+GBALLOC_POOL_THREAD_EXIT_CALLBACK(on_thread_exit, value)
+{
+    if (value != NULL)
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_024: [ When a thread that allocated or freed blocks exits, the blocks cached by the thread and its statistics shall be given back to their classes. ]*/
+        release_thread_cache();
+        /* a destructor running after this one may allocate again, in which case the thread registers again */
+        thread_cache.exit_registered = 0;
+    }
+}
+
+#if defined(_MSC_VER)
+static INIT_ONCE thread_exit_once = INIT_ONCE_STATIC_INIT;
+static DWORD thread_exit_index = FLS_OUT_OF_INDEXES;
+
+static BOOL CALLBACK create_thread_exit_index(PINIT_ONCE init_once, PVOID parameter, PVOID* context)
+{
+    (void)init_once;
+    (void)parameter;
+    (void)context;
+    thread_exit_index = FlsAlloc(on_thread_exit);
+    return TRUE;
+}
+
+static void register_thread_exit(void)
+{
+    if ((InitOnceExecuteOnce(&thread_exit_once, create_thread_exit_index, NULL, NULL)) &&
+        (thread_exit_index != FLS_OUT_OF_INDEXES) &&
+        (FlsSetValue(thread_exit_index, &thread_cache)))
+    {
+        thread_cache.exit_registered = 1;
+    }
+}
+#else
+static pthread_once_t thread_exit_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_exit_key;
+static int thread_exit_key_created = 0;
+
+static void create_thread_exit_key(void)
+{
+    thread_exit_key_created = (pthread_key_create(&thread_exit_key, on_thread_exit) == 0);
+}
+
+static void register_thread_exit(void)
+{
+    if ((pthread_once(&thread_exit_once, create_thread_exit_key) == 0) &&
+        thread_exit_key_created &&
+        (pthread_setspecific(thread_exit_key, &thread_cache) == 0))
+    {
+        thread_cache.exit_registered = 1;
+    }
+}
+#endif
+
+static void* allocate_from_class(size_t class_index, size_t size)
+{
+    void* result;
+    POOL_FREE_BLOCK* block;
+
+    if (!thread_cache.exit_registered)
+    {
+        register_thread_exit();
+    }
+
+    /* Codes_SRS_GBALLOC_POOL_01_002: [ The block shall be taken from the free blocks cached by the calling thread for that class. ]*/
+    block = thread_cache.free_list[class_index];
+
+    if (block != NULL)
+    {
+        thread_cache.cache_hits[class_index]++;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_003: [ If the thread has no cached block for the class, gballoc_malloc shall move up to 16 free blocks of the class to the thread cache. ]*/
+        refill_thread_cache(class_index);
+        block = thread_cache.free_list[class_index];
+    }
+
+    if (block == NULL)
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_005: [ If allocating the slab fails, gballoc_malloc shall return NULL. ]*/
+        result = NULL;
+    }
+    else
+    {
+        POOL_HEADER* header = (POOL_HEADER*)block - 1;
+        thread_cache.free_list[class_index] = block->next;
+        thread_cache.count[class_index]--;
+        thread_cache.allocations[class_index]++;
+
+        header->info.class_index = class_index;
+        header->info.size = size;
+        result = block;
+
+        flush_thread_statistics(class_index);
+    }
+
+    return result;
+}
+
+static void free_to_class(POOL_HEADER* header)
+{
+    size_t class_index = header->info.class_index;
+    POOL_FREE_BLOCK* block = (POOL_FREE_BLOCK*)get_payload(header);
+
+    header->info.class_index = GBALLOC_POOL_FREE_CLASS;
+
+    if (!thread_cache.exit_registered)
+    {
+        register_thread_exit();
+    }
+
+    /* Codes_SRS_GBALLOC_POOL_01_015: [ If ptr belongs to a size class, gballoc_free shall add it to the free blocks cached by the calling thread. ]*/
+    block->next = thread_cache.free_list[class_index];
+    thread_cache.free_list[class_index] = block;
+    thread_cache.count[class_index]++;
+    thread_cache.frees[class_index]++;
+
+    if (thread_cache.count[class_index] > GBALLOC_POOL_CACHE_MAX)
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_016: [ If the thread cache then holds more than 32 blocks of the class, gballoc_free shall move 16 of them back to the class. ]*/
+        drain_thread_cache(class_index, GBALLOC_POOL_CACHE_BATCH);
+    }
+    else
+    {
+        flush_thread_statistics(class_index);
+    }
+}
+
+void* gballoc_malloc(size_t size)
+{
+    void* result;
+    size_t class_index = get_class_index(size);
+
+    if (class_index != GBALLOC_POOL_LARGE_CLASS)
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_001: [ If size is at most 256, gballoc_malloc shall return a block of the smallest size class that can hold size bytes. ]*/
+        result = allocate_from_class(class_index, size);
+    }
+    else if (size > SIZE_MAX - sizeof(POOL_HEADER))
+    {
+        LogError("Invalid size %lu", (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_006: [ If size is larger than 256, gballoc_malloc shall call malloc for size bytes plus the header and return the memory following the header. ]*/
+        POOL_HEADER* header = (POOL_HEADER*)system_malloc(sizeof(POOL_HEADER) + size);
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_007: [ If malloc fails, gballoc_malloc shall return NULL. ]*/
+            result = NULL;
+        }
+        else
+        {
+            header->info.class_index = GBALLOC_POOL_LARGE_CLASS;
+            header->info.size = size;
+            GBALLOC_POOL_ATOMIC_INCREMENT(large_allocations);
+            result = get_payload(header);
+        }
+    }
+
+    return result;
+}
+
+void* gballoc_calloc(size_t nmemb, size_t size)
+{
+    void* result;
+
+    if ((size != 0) && (nmemb > SIZE_MAX / size))
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_008: [ If nmemb * size overflows, gballoc_calloc shall fail and return NULL. ]*/
+        LogError("Invalid size %lu * %lu", (unsigned long)nmemb, (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_009: [ Otherwise gballoc_calloc shall allocate nmemb * size bytes as gballoc_malloc does and set them to 0. ]*/
+        result = gballoc_malloc(nmemb * size);
+        if (result != NULL)
+        {
+            (void)memset(result, 0, nmemb * size);
+        }
+    }
+
+    return result;
+}
+
+void* gballoc_realloc(void* ptr, size_t size)
+{
+    void* result;
+
+    if (ptr == NULL)
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_010: [ If ptr is NULL, gballoc_realloc shall behave as gballoc_malloc. ]*/
+        result = gballoc_malloc(size);
+    }
+    else
+    {
+        POOL_HEADER* header = get_header(ptr);
+
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_023: [ If the header of ptr does not hold the class of a block in use, gballoc_realloc shall fail and return NULL. ]*/
+            LogError("Cannot reallocate %p, it is not a block in use", ptr);
+            result = NULL;
+        }
+        else if ((header->info.class_index != GBALLOC_POOL_LARGE_CLASS) &&
+            (size <= class_sizes[header->info.class_index]))
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_011: [ If the size class of ptr can hold size bytes, gballoc_realloc shall return ptr. ]*/
+            header->info.size = size;
+            result = ptr;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_012: [ Otherwise gballoc_realloc shall allocate a new block as gballoc_malloc does, copy the content of ptr into it and free ptr. ]*/
+            result = gballoc_malloc(size);
+            if (result == NULL)
+            {
+                /* Codes_SRS_GBALLOC_POOL_01_013: [ If allocating the new block fails, gballoc_realloc shall return NULL and leave ptr untouched. ]*/
+                LogError("Cannot reallocate %lu bytes", (unsigned long)size);
+            }
+            else
+            {
+                (void)memcpy(result, ptr, (header->info.size < size) ? header->info.size : size);
+                gballoc_free(ptr);
+            }
+        }
+    }
+
+    return result;
+}
+
+void gballoc_free(void* ptr)
+{
+    /* Codes_SRS_GBALLOC_POOL_01_014: [ If ptr is NULL, gballoc_free shall do nothing. ]*/
+    if (ptr != NULL)
+    {
+        POOL_HEADER* header = get_header(ptr);
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_022: [ If the header of ptr does not hold the class of a block in use, gballoc_free shall not free anything. ]*/
+            LogError("Cannot free %p, it is not a block in use", ptr);
+        }
+        else if (header->info.class_index == GBALLOC_POOL_LARGE_CLASS)
+        {
+            /* Codes_SRS_GBALLOC_POOL_01_017: [ If ptr is a large block, gballoc_free shall call free on its header. ]*/
+            system_free(header);
+        }
+        else
+        {
+            free_to_class(header);
+        }
+    }
+}
+
+size_t gballoc_pool_get_class_count(void)
+{
+    /* Codes_SRS_GBALLOC_POOL_01_018: [ gballoc_pool_get_class_count shall return the number of size classes. ]*/
+    return GBALLOC_POOL_CLASS_COUNT;
+}
+
+int gballoc_pool_get_class_statistics(size_t class_index, GBALLOC_POOL_CLASS_STATISTICS* statistics)
+{
+    int result;
+
+    if ((class_index >= GBALLOC_POOL_CLASS_COUNT) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_GBALLOC_POOL_01_019: [ If class_index is not smaller than the number of classes or statistics is NULL, gballoc_pool_get_class_statistics shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: size_t class_index=%lu, GBALLOC_POOL_CLASS_STATISTICS* statistics=%p",
+            (unsigned long)class_index, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        POOL_CLASS* pool_class = &pool_classes[class_index];
+
+        lock_class(pool_class);
+
+        /* Codes_SRS_GBALLOC_POOL_01_020: [ gballoc_pool_get_class_statistics shall merge the statistics of the calling thread into the class and fill statistics with the block size, reserved blocks, blocks in use, allocations and thread cache hits of the class, then return 0. ]*/
+        /* counters of other threads are merged the next time they take the class lock */
+        merge_thread_statistics(class_index);
+
+        statistics->block_size = class_sizes[class_index];
+        statistics->blocks_reserved = pool_class->blocks_reserved;
+        /* frees merged from another thread may be ahead of the matching allocations for a while */
+        statistics->blocks_in_use = (pool_class->allocations > pool_class->frees) ? (pool_class->allocations - pool_class->frees) : 0;
+        statistics->allocations = pool_class->allocations;
+        statistics->cache_hits = pool_class->cache_hits;
+
+        unlock_class(pool_class);
+
+        result = 0;
+    }
+
+    return result;
+}
+
+size_t gballoc_pool_get_large_allocation_count(void)
+{
+    /* Codes_SRS_GBALLOC_POOL_01_021: [ gballoc_pool_get_large_allocation_count shall return the number of blocks larger than 256 bytes allocated so far. ]*/
+    return large_allocations;
+}
@@ -2,10 +2,142 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stddef.h>
+#include <string.h>
+#include <limits.h>
 #include "azure_c_shared_utility/hmacsha256.h"
-#include "azure_c_shared_utility/hmac.h"
 #include "azure_c_shared_utility/buffer_.h"
 
+#define HMACSHA256_IPAD 0x36
+#define HMACSHA256_OPAD 0x5C
+
+/* SHA256Input takes an unsigned int length, longer inputs are fed in pieces */
+static int sha256_input(SHA256Context* context, const unsigned char* bytes, size_t length)
+{
+    int result = shaSuccess;
+    while ((length > 0) && (result == shaSuccess))
+    {
+        unsigned int chunk = (length > UINT_MAX) ? UINT_MAX : (unsigned int)length;
+        result = SHA256Input(context, bytes, chunk);
+        bytes += chunk;
+        length -= chunk;
+    }
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_InitContext(HMACSHA256_CONTEXT* context, const unsigned char* key, size_t keyLen)
+{
+    HMACSHA256_RESULT result;
+
+    if (context == NULL ||
+        key == NULL ||
+        keyLen == 0)
+    {
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        unsigned char keyHash[SHA256HashSize];
+        unsigned char innerPad[SHA256_Message_Block_Size];
+        unsigned char outerPad[SHA256_Message_Block_Size];
+        size_t i;
+
+        result = HMACSHA256_OK;
+
+        /* keys longer than a block are replaced by their hash (RFC 2104) */
+        if (keyLen > SHA256_Message_Block_Size)
+        {
+            SHA256Context keyContext;
+            if ((SHA256Reset(&keyContext) != shaSuccess) ||
+                (sha256_input(&keyContext, key, keyLen) != shaSuccess) ||
+                (SHA256Result(&keyContext, keyHash) != shaSuccess))
+            {
+                result = HMACSHA256_ERROR;
+            }
+            key = keyHash;
+            keyLen = SHA256HashSize;
+        }
+
+        if (result == HMACSHA256_OK)
+        {
+            for (i = 0; i < keyLen; i++)
+            {
+                innerPad[i] = key[i] ^ HMACSHA256_IPAD;
+                outerPad[i] = key[i] ^ HMACSHA256_OPAD;
+            }
+            for (; i < SHA256_Message_Block_Size; i++)
+            {
+                innerPad[i] = HMACSHA256_IPAD;
+                outerPad[i] = HMACSHA256_OPAD;
+            }
+
+            /* each state has absorbed exactly one block, only the payload is left to hash */
+            if ((SHA256Reset(&context->inner) != shaSuccess) ||
+                (SHA256Input(&context->inner, innerPad, SHA256_Message_Block_Size) != shaSuccess) ||
+                (SHA256Reset(&context->outer) != shaSuccess) ||
+                (SHA256Input(&context->outer, outerPad, SHA256_Message_Block_Size) != shaSuccess))
+            {
+                result = HMACSHA256_ERROR;
+            }
+
+            (void)memset(innerPad, 0, sizeof(innerPad));
+            (void)memset(outerPad, 0, sizeof(outerPad));
+        }
+
+        (void)memset(keyHash, 0, sizeof(keyHash));
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_ComputeHashWithContext(const HMACSHA256_CONTEXT* context, const unsigned char* payload, size_t payloadLen, unsigned char* hash)
+{
+    HMACSHA256_RESULT result;
+
+    if (context == NULL ||
+        payload == NULL ||
+        payloadLen == 0 ||
+        hash == NULL)
+    {
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        /* the key states are copied so that the context can be reused, also from several threads */
+        SHA256Context work = context->inner;
+        unsigned char innerHash[SHA256HashSize];
+
+        if ((sha256_input(&work, payload, payloadLen) != shaSuccess) ||
+            (SHA256Result(&work, innerHash) != shaSuccess))
+        {
+            result = HMACSHA256_ERROR;
+        }
+        else
+        {
+            work = context->outer;
+            if ((SHA256Input(&work, innerHash, SHA256HashSize) != shaSuccess) ||
+                (SHA256Result(&work, hash) != shaSuccess))
+            {
+                result = HMACSHA256_ERROR;
+            }
+            else
+            {
+                result = HMACSHA256_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+void HMACSHA256_DeinitContext(HMACSHA256_CONTEXT* context)
+{
+    if (context != NULL)
+    {
+        /* the states are derived from the key */
+        (void)memset(context, 0, sizeof(HMACSHA256_CONTEXT));
+    }
+}
+
 HMACSHA256_RESULT HMACSHA256_ComputeHash(const unsigned char* key, size_t keyLen, const unsigned char* payload, size_t payloadLen, BUFFER_HANDLE hash)
 {
     HMACSHA256_RESULT result;
@@ -20,14 +152,17 @@ HMACSHA256_RESULT HMACSHA256_ComputeHash(const unsigned char* key, size_t keyLen
     }
     else
     {
-        if ((BUFFER_enlarge(hash, 32) != 0) ||
-            (hmac(SHA256, payload, (int)payloadLen, key, (int)keyLen, BUFFER_u_char(hash) ) != 0))
+        HMACSHA256_CONTEXT context;
+
+        if ((BUFFER_enlarge(hash, HMACSHA256_HASH_SIZE) != 0) ||
+            (HMACSHA256_InitContext(&context, key, keyLen) != HMACSHA256_OK))
         {
             result = HMACSHA256_ERROR;
         }
         else
         {
-            result = HMACSHA256_OK;
+            result = HMACSHA256_ComputeHashWithContext(&context, payload, payloadLen, BUFFER_u_char(hash));
+            HMACSHA256_DeinitContext(&context);
         }
     }
 
@@ -9,6 +9,8 @@
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
 
 typedef struct HTTPAPIEX_SAVED_OPTION_TAG
 {
@@ -16,14 +18,55 @@ typedef struct HTTPAPIEX_SAVED_OPTION_TAG
     const void* value;
 }HTTPAPIEX_SAVED_OPTION;
 
+typedef struct HTTPAPIEX_POOLED_CONNECTION_TAG
+{
+    HTTP_HANDLE httpHandle;
+    tickcounter_ms_t lastUsed;
+    size_t optionsGeneration; /*optionsGeneration of the host when the connection was opened*/
+    struct HTTPAPIEX_POOLED_CONNECTION_TAG* next;
+}HTTPAPIEX_POOLED_CONNECTION;
+
+typedef struct HTTPAPIEX_POOL_HOST_TAG
+{
+    char* hostName;
+    bool isShared; /*shared by the handles without options, otherwise owned by a single handle*/
+    size_t optionsGeneration; /*bumped when the owner changes its options, older connections are not reused*/
+    size_t connectionCount; /*idle and checked out*/
+    HTTPAPIEX_POOLED_CONNECTION* idleConnections; /*most recently used first*/
+    struct HTTPAPIEX_POOL_HOST_TAG* next;
+}HTTPAPIEX_POOL_HOST;
+
+typedef struct HTTPAPIEX_POOL_DATA_TAG
+{
+    LOCK_HANDLE lock;
+    TICK_COUNTER_HANDLE tickCounter;
+    size_t maxConnectionsPerHost;
+    tickcounter_ms_t idleTimeout;
+    HTTPAPIEX_POOL_HOST* hosts;
+}HTTPAPIEX_POOL_DATA;
+
 typedef struct HTTPAPIEX_HANDLE_DATA_TAG
 {
     STRING_HANDLE hostName;
     int k;
     HTTP_HANDLE httpHandle;
     VECTOR_HANDLE savedOptions;
+    HTTPAPIEX_POOL_DATA* pool;
+    HTTPAPIEX_POOL_HOST* poolHost;
 }HTTPAPIEX_HANDLE_DATA;
 
+typedef struct HTTPAPIEX_BATCH_ENTRY_TAG
+{
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle;
+    bool isOriginalRequestHttpHeadersHandle;
+    BUFFER_HANDLE requestContent;
+    bool isOriginalRequestContent;
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle;
+    bool isOriginalResponseHttpHeadersHandle;
+    BUFFER_HANDLE responseContent;
+    bool isOriginalResponseContent;
+}HTTPAPIEX_BATCH_ENTRY;
+
 DEFINE_ENUM_STRINGS(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 
 #define LOG_HTTAPIEX_ERROR() LogError("error code = %s", ENUM_TO_STRING(HTTPAPIEX_RESULT, result))
@@ -70,6 +113,8 @@ HTTPAPIEX_HANDLE HTTPAPIEX_Create(const char* hostName)
                 {
                     handleData->k = -1;
                     handleData->httpHandle = NULL;
+                    handleData->pool = NULL;
+                    handleData->poolHost = NULL;
                     result = handleData;
                 }
             }
@@ -78,6 +123,190 @@ HTTPAPIEX_HANDLE HTTPAPIEX_Create(const char* hostName)
     return result;
 }
 
+static void closePooledConnections(HTTPAPIEX_POOLED_CONNECTION* connection)
+{
+    while (connection != NULL)
+    {
+        HTTPAPIEX_POOLED_CONNECTION* next = connection->next;
+        HTTPAPI_CloseConnection(connection->httpHandle);
+        free(connection);
+        connection = next;
+    }
+}
+
+HTTPAPIEX_POOL_HANDLE HTTPAPIEX_Pool_Create(size_t maxConnectionsPerHost, unsigned int idleTimeoutInSeconds)
+{
+    HTTPAPIEX_POOL_DATA* result;
+    /*Codes_SRS_HTTPAPIEX_01_001: [If maxConnectionsPerHost is 0 then HTTPAPIEX_Pool_Create shall return NULL.]*/
+    if (maxConnectionsPerHost == 0)
+    {
+        LogError("invalid (0) maxConnectionsPerHost");
+        result = NULL;
+    }
+    /*Codes_SRS_HTTPAPIEX_01_003: [If any of the operations in HTTPAPIEX_Pool_Create fails, then HTTPAPIEX_Pool_Create shall return NULL.]*/
+    else if ((result = (HTTPAPIEX_POOL_DATA*)malloc(sizeof(HTTPAPIEX_POOL_DATA))) == NULL)
+    {
+        LogError("malloc failed.");
+    }
+    else if ((result->lock = Lock_Init()) == NULL)
+    {
+        LogError("unable to Lock_Init");
+        free(result);
+        result = NULL;
+    }
+    else if ((result->tickCounter = tickcounter_create()) == NULL)
+    {
+        LogError("unable to tickcounter_create");
+        (void)Lock_Deinit(result->lock);
+        free(result);
+        result = NULL;
+    }
+    /*Codes_SRS_HTTPAPIEX_01_002: [HTTPAPIEX_Pool_Create shall call HTTPAPI_Init once for all the connections of the pool.]*/
+    else if (HTTPAPI_Init() != HTTPAPI_OK)
+    {
+        LogError("unable to HTTPAPI_Init");
+        tickcounter_destroy(result->tickCounter);
+        (void)Lock_Deinit(result->lock);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->maxConnectionsPerHost = maxConnectionsPerHost;
+        result->idleTimeout = (tickcounter_ms_t)idleTimeoutInSeconds * 1000;
+        result->hosts = NULL;
+    }
+    return result;
+}
+
+void HTTPAPIEX_Pool_Destroy(HTTPAPIEX_POOL_HANDLE pool)
+{
+    /*Codes_SRS_HTTPAPIEX_01_005: [If parameter pool is NULL then HTTPAPIEX_Pool_Destroy shall take no action.]*/
+    if (pool != NULL)
+    {
+        /*Codes_SRS_HTTPAPIEX_01_004: [HTTPAPIEX_Pool_Destroy shall close all the idle connections, call HTTPAPI_Deinit and free all the resources used by the pool.]*/
+        HTTPAPIEX_POOL_HOST* host = pool->hosts;
+        while (host != NULL)
+        {
+            HTTPAPIEX_POOL_HOST* next = host->next;
+            HTTPAPIEX_POOLED_CONNECTION* connection;
+            size_t idleCount = 0;
+            for (connection = host->idleConnections; connection != NULL; connection = connection->next)
+            {
+                idleCount++;
+            }
+            if (idleCount != host->connectionCount)
+            {
+                LogError("%lu connections to %s are still in use", (unsigned long)(host->connectionCount - idleCount), host->hostName);
+            }
+            closePooledConnections(host->idleConnections);
+            free(host->hostName);
+            free(host);
+            host = next;
+        }
+        HTTPAPI_Deinit();
+        tickcounter_destroy(pool->tickCounter);
+        (void)Lock_Deinit(pool->lock);
+        free(pool);
+    }
+}
+
+/*the host is not linked to the pool yet*/
+static HTTPAPIEX_POOL_HOST* createPoolHost(const char* hostName, bool isShared)
+{
+    HTTPAPIEX_POOL_HOST* result;
+    if ((result = (HTTPAPIEX_POOL_HOST*)malloc(sizeof(HTTPAPIEX_POOL_HOST))) == NULL)
+    {
+        LogError("malloc failed.");
+    }
+    else if (mallocAndStrcpy_s(&result->hostName, hostName) != 0)
+    {
+        LogError("unable to copy the host name");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->isShared = isShared;
+        result->optionsGeneration = 0;
+        result->connectionCount = 0;
+        result->idleConnections = NULL;
+        result->next = NULL;
+    }
+    return result;
+}
+
+/*called with the pool locked*/
+static HTTPAPIEX_POOL_HOST* findOrAddPoolHost(HTTPAPIEX_POOL_DATA* pool, const char* hostName)
+{
+    HTTPAPIEX_POOL_HOST* result = pool->hosts;
+    while ((result != NULL) && (!result->isShared || (strcmp(result->hostName, hostName) != 0)))
+    {
+        result = result->next;
+    }
+
+    if ((result == NULL) &&
+        ((result = createPoolHost(hostName, true)) != NULL))
+    {
+        result->next = pool->hosts;
+        pool->hosts = result;
+    }
+    return result;
+}
+
+/*called with the pool locked*/
+static void unlinkPoolHost(HTTPAPIEX_POOL_DATA* pool, HTTPAPIEX_POOL_HOST* host)
+{
+    HTTPAPIEX_POOL_HOST** current = &pool->hosts;
+    while ((*current != NULL) && (*current != host))
+    {
+        current = &(*current)->next;
+    }
+    if (*current != NULL)
+    {
+        *current = host->next;
+    }
+}
+
+HTTPAPIEX_HANDLE HTTPAPIEX_CreateWithPool(const char* hostName, HTTPAPIEX_POOL_HANDLE pool)
+{
+    HTTPAPIEX_HANDLE_DATA* result;
+    /*Codes_SRS_HTTPAPIEX_01_006: [If parameter hostName or pool is NULL then HTTPAPIEX_CreateWithPool shall return NULL.]*/
+    if ((hostName == NULL) || (pool == NULL))
+    {
+        LogError("invalid parameter hostName=%p, pool=%p", hostName, pool);
+        result = NULL;
+    }
+    /*Codes_SRS_HTTPAPIEX_01_007: [HTTPAPIEX_CreateWithPool shall create the handle as HTTPAPIEX_Create does and attach it to the connections of pool for hostName.]*/
+    else if ((result = (HTTPAPIEX_HANDLE_DATA*)HTTPAPIEX_Create(hostName)) == NULL)
+    {
+        LogError("unable to HTTPAPIEX_Create");
+    }
+    else if (Lock(pool->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_HTTPAPIEX_01_008: [If any of the operations in HTTPAPIEX_CreateWithPool fails, then HTTPAPIEX_CreateWithPool shall return NULL.]*/
+        LogError("unable to Lock");
+        HTTPAPIEX_Destroy(result);
+        result = NULL;
+    }
+    else
+    {
+        result->poolHost = findOrAddPoolHost(pool, hostName);
+        (void)Unlock(pool->lock);
+
+        if (result->poolHost == NULL)
+        {
+            HTTPAPIEX_Destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            result->pool = pool;
+        }
+    }
+    return result;
+}
+
 /*this function builds the default request http headers if none are specified*/
 /*returns 0 if no error*/
 /*any other code is error*/
@@ -294,6 +523,244 @@ static int buildAllRequests(HTTPAPIEX_HANDLE_DATA* handle, HTTPAPI_REQUEST_TYPE
     return result;
 }
 
+static void setSavedOptions(HTTPAPIEX_HANDLE_DATA* handleData, HTTP_HANDLE httpHandle)
+{
+    size_t i;
+    size_t vectorSize = VECTOR_size(handleData->savedOptions);
+    for (i = 0; i < vectorSize; i++)
+    {
+        /*Codes_SRS_HTTPAPIEX_02_035: [HTTPAPIEX_ExecuteRequest shall pass all the saved options (see HTTPAPIEX_SetOption) to the newly create HTTPAPI_HANDLE in step 2 by calling HTTPAPI_SetOption.]*/
+        /*Codes_SRS_HTTPAPIEX_02_036: [If setting the option fails, then the failure shall be ignored.] */
+        HTTPAPIEX_SAVED_OPTION* option = (HTTPAPIEX_SAVED_OPTION*)VECTOR_element(handleData->savedOptions, i);
+        if (HTTPAPI_SetOption(httpHandle, option->optionName, option->value) != HTTPAPI_OK)
+        {
+            LogError("HTTPAPI_SetOption failed when called for option %s", option->optionName);
+        }
+    }
+}
+
+/*called with the pool locked, returns the connections that are to be closed*/
+static HTTPAPIEX_POOLED_CONNECTION* removeExpiredConnections(HTTPAPIEX_POOL_DATA* pool, HTTPAPIEX_POOL_HOST* host, tickcounter_ms_t now)
+{
+    HTTPAPIEX_POOLED_CONNECTION* result;
+    HTTPAPIEX_POOLED_CONNECTION* connection;
+    HTTPAPIEX_POOLED_CONNECTION** last = &host->idleConnections;
+
+    /*the list is ordered by last use, everything after the first expired connection is expired too*/
+    while ((*last != NULL) && ((now - (*last)->lastUsed) <= pool->idleTimeout))
+    {
+        last = &(*last)->next;
+    }
+    result = *last;
+    *last = NULL;
+
+    for (connection = result; connection != NULL; connection = connection->next)
+    {
+        host->connectionCount--;
+    }
+    return result;
+}
+
+/*called with the pool locked and a non empty idle list*/
+static HTTPAPIEX_POOLED_CONNECTION* removeOldestConnection(HTTPAPIEX_POOL_HOST* host)
+{
+    HTTPAPIEX_POOLED_CONNECTION* result;
+    HTTPAPIEX_POOLED_CONNECTION** last = &host->idleConnections;
+
+    while ((*last)->next != NULL)
+    {
+        last = &(*last)->next;
+    }
+    result = *last;
+    *last = NULL;
+    host->connectionCount--;
+    return result;
+}
+
+/*returns 0 and either an idle connection or NULL when a slot for a new connection has been reserved*/
+static int checkoutPooledConnection(HTTPAPIEX_HANDLE_DATA* handleData, bool allowReuse, HTTPAPIEX_POOLED_CONNECTION** connection)
+{
+    int result;
+    HTTPAPIEX_POOL_DATA* pool = handleData->pool;
+    HTTPAPIEX_POOL_HOST* host = handleData->poolHost;
+    tickcounter_ms_t now;
+
+    if (tickcounter_get_current_ms(pool->tickCounter, &now) != 0)
+    {
+        LogError("unable to tickcounter_get_current_ms");
+        result = __FAILURE__;
+    }
+    else if (Lock(pool->lock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPIEX_01_011: [Idle connections that have not been used for longer than the idle timeout of the pool shall be closed instead of being reused.]*/
+        HTTPAPIEX_POOLED_CONNECTION* toBeClosed = removeExpiredConnections(pool, host, now);
+
+        if (allowReuse && (host->idleConnections != NULL))
+        {
+            /*Codes_SRS_HTTPAPIEX_01_010: [HTTPAPIEX_ExecuteRequest shall reuse the most recently used idle connection of the pool to the host of the handle.]*/
+            *connection = host->idleConnections;
+            host->idleConnections = (*connection)->next;
+            (*connection)->next = NULL;
+            result = 0;
+        }
+        else
+        {
+            if ((host->connectionCount >= pool->maxConnectionsPerHost) && (host->idleConnections != NULL))
+            {
+                /*a new connection is needed, the least recently used idle one makes room for it*/
+                HTTPAPIEX_POOLED_CONNECTION* oldest = removeOldestConnection(host);
+                oldest->next = toBeClosed;
+                toBeClosed = oldest;
+            }
+
+            /*Codes_SRS_HTTPAPIEX_01_012: [If there is no idle connection, HTTPAPIEX_ExecuteRequest shall open a new connection only if the pool has less than maxConnectionsPerHost connections to the host.]*/
+            if (host->connectionCount < pool->maxConnectionsPerHost)
+            {
+                host->connectionCount++;
+                *connection = NULL;
+                result = 0;
+            }
+            else
+            {
+                /*Codes_SRS_HTTPAPIEX_01_013: [Otherwise HTTPAPIEX_ExecuteRequest shall fail with HTTPAPIEX_ERROR without waiting for a connection to be returned to the pool.]*/
+                LogError("all the %lu connections to %s are in use", (unsigned long)host->connectionCount, host->hostName);
+                result = __FAILURE__;
+            }
+        }
+        (void)Unlock(pool->lock);
+
+        /*closing can take a while, it is not done with the pool locked*/
+        closePooledConnections(toBeClosed);
+    }
+    return result;
+}
+
+/*returns NULL and gives back the reserved slot if the connection cannot be created*/
+static HTTPAPIEX_POOLED_CONNECTION* createPooledConnection(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    HTTPAPIEX_POOLED_CONNECTION* result;
+
+    if ((result = (HTTPAPIEX_POOLED_CONNECTION*)malloc(sizeof(HTTPAPIEX_POOLED_CONNECTION))) == NULL)
+    {
+        LogError("malloc failed.");
+    }
+    else if ((result->httpHandle = HTTPAPI_CreateConnection(STRING_c_str(handleData->hostName))) == NULL)
+    {
+        LogError("unable to HTTPAPI_CreateConnection");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        /*options set from now on bump the generation and make this connection stale*/
+        result->optionsGeneration = handleData->poolHost->optionsGeneration;
+        setSavedOptions(handleData, result->httpHandle);
+        result->next = NULL;
+    }
+
+    if ((result == NULL) && (Lock(handleData->pool->lock) == LOCK_OK))
+    {
+        handleData->poolHost->connectionCount--;
+        (void)Unlock(handleData->pool->lock);
+    }
+    return result;
+}
+
+static void checkinPooledConnection(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPIEX_POOLED_CONNECTION* connection, bool isReusable)
+{
+    HTTPAPIEX_POOL_DATA* pool = handleData->pool;
+
+    if (Lock(pool->lock) != LOCK_OK)
+    {
+        /*the slot is lost, but the connection is not leaked*/
+        LogError("unable to Lock");
+        closePooledConnections(connection);
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPIEX_01_025: [When HTTPAPIEX_SetOption is called on a handle that already has connections of its own, its idle connections shall be closed and the connections in use shall be closed when they are returned, so that every further request uses all the saved options.]*/
+        if (isReusable &&
+            (connection->optionsGeneration == handleData->poolHost->optionsGeneration) &&
+            (tickcounter_get_current_ms(pool->tickCounter, &connection->lastUsed) == 0))
+        {
+            connection->next = handleData->poolHost->idleConnections;
+            handleData->poolHost->idleConnections = connection;
+            connection = NULL;
+        }
+        else
+        {
+            handleData->poolHost->connectionCount--;
+        }
+        (void)Unlock(pool->lock);
+
+        closePooledConnections(connection);
+    }
+}
+
+static HTTPAPIEX_RESULT executePooledRequest(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPIEX_RESULT result = HTTPAPIEX_RECOVERYFAILED;
+    bool allowReuse = true;
+    bool isDone = false;
+
+    while (!isDone)
+    {
+        HTTPAPIEX_POOLED_CONNECTION* connection;
+
+        if (checkoutPooledConnection(handleData, allowReuse, &connection) != 0)
+        {
+            result = HTTPAPIEX_ERROR;
+            LOG_HTTAPIEX_ERROR();
+            isDone = true;
+        }
+        else
+        {
+            bool isReused = (connection != NULL);
+
+            if (!isReused &&
+                ((connection = createPooledConnection(handleData)) == NULL))
+            {
+                /*Codes_SRS_HTTPAPIEX_01_015: [If a new connection cannot be created or the request fails on it, HTTPAPIEX_ExecuteRequest shall return HTTPAPIEX_RECOVERYFAILED.]*/
+                result = HTTPAPIEX_RECOVERYFAILED;
+                LOG_HTTAPIEX_ERROR();
+                isDone = true;
+            }
+            else if (HTTPAPI_ExecuteRequest(connection->httpHandle, requestType, relativePath, requestHttpHeadersHandle, BUFFER_u_char(requestContent), BUFFER_length(requestContent), statusCode, responseHttpHeadersHandle, responseContent) == HTTPAPI_OK)
+            {
+                /*Codes_SRS_HTTPAPIEX_01_016: [After a successful request the connection shall be returned to the idle connections of the pool.]*/
+                checkinPooledConnection(handleData, connection, true);
+                result = HTTPAPIEX_OK;
+                isDone = true;
+            }
+            else
+            {
+                checkinPooledConnection(handleData, connection, false);
+                if (isReused)
+                {
+                    /*Codes_SRS_HTTPAPIEX_01_014: [If the request fails on a reused connection, the connection shall be closed and the request shall be retried once on a new connection.]*/
+                    LogInfo("request failed on a reused connection to %s, retrying on a new one", STRING_c_str(handleData->hostName));
+                    allowReuse = false;
+                }
+                else
+                {
+                    /*Codes_SRS_HTTPAPIEX_01_015: [If a new connection cannot be created or the request fails on it, HTTPAPIEX_ExecuteRequest shall return HTTPAPIEX_RECOVERYFAILED.]*/
+                    result = HTTPAPIEX_RECOVERYFAILED;
+                    LOG_HTTAPIEX_ERROR();
+                    isDone = true;
+                }
+            }
+        }
+    }
+    return result;
+}
+
 HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
     HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode,
     HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
@@ -336,6 +803,28 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                 result = HTTPAPIEX_ERROR;
                 LOG_HTTAPIEX_ERROR();
             }
+            else if (handleData->pool != NULL)
+            {
+                /*Codes_SRS_HTTPAPIEX_01_009: [If the handle was created by HTTPAPIEX_CreateWithPool, HTTPAPIEX_ExecuteRequest shall execute the request on a connection checked out of the pool instead of the retry sequence of SRS_HTTPAPIEX_02_023.]*/
+                result = executePooledRequest(handleData, requestType, toBeUsedRelativePath, toBeUsedRequestHttpHeadersHandle, toBeUsedRequestContent, toBeUsedStatusCode, toBeUsedResponseHttpHeadersHandle, toBeUsedResponseContent);
+
+                if (isOriginalRequestContent == false)
+                {
+                    BUFFER_delete(toBeUsedRequestContent);
+                }
+                if (isOriginalRequestHttpHeadersHandle == false)
+                {
+                    HTTPHeaders_Free(toBeUsedRequestHttpHeadersHandle);
+                }
+                if (isOriginalResponseContent == false)
+                {
+                    BUFFER_delete(toBeUsedResponseContent);
+                }
+                if (isOriginalResponseHttpHeadersHandle == false)
+                {
+                    HTTPHeaders_Free(toBeUsedResponseHttpHeadersHandle);
+                }
+            }
             else
             {
 
@@ -388,18 +877,7 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                             }
                             else
                             {
-                                size_t i;
-                                size_t vectorSize = VECTOR_size(handleData->savedOptions);
-                                for (i = 0; i < vectorSize; i++)
-                                {
-                                    /*Codes_SRS_HTTPAPIEX_02_035: [HTTPAPIEX_ExecuteRequest shall pass all the saved options (see HTTPAPIEX_SetOption) to the newly create HTTPAPI_HANDLE in step 2 by calling HTTPAPI_SetOption.]*/
-                                    /*Codes_SRS_HTTPAPIEX_02_036: [If setting the option fails, then the failure shall be ignored.] */
-                                    HTTPAPIEX_SAVED_OPTION* option = (HTTPAPIEX_SAVED_OPTION*)VECTOR_element(handleData->savedOptions, i);
-                                    if (HTTPAPI_SetOption(handleData->httpHandle, option->optionName, option->value) != HTTPAPI_OK)
-                                    {
-                                        LogError("HTTPAPI_SetOption failed when called for option %s", option->optionName);
-                                    }
-                                }
+                                setSavedOptions(handleData, handleData->httpHandle);
                                 goOn = true;
                             }
                             break;
@@ -498,6 +976,201 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
 }
 
 
+static void destroyBatchEntries(HTTPAPIEX_BATCH_ENTRY* entries, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if (entries[i].isOriginalRequestContent == false)
+        {
+            BUFFER_delete(entries[i].requestContent);
+        }
+        if (entries[i].isOriginalRequestHttpHeadersHandle == false)
+        {
+            HTTPHeaders_Free(entries[i].requestHttpHeadersHandle);
+        }
+        if (entries[i].isOriginalResponseContent == false)
+        {
+            BUFFER_delete(entries[i].responseContent);
+        }
+        if (entries[i].isOriginalResponseHttpHeadersHandle == false)
+        {
+            HTTPHeaders_Free(entries[i].responseHttpHeadersHandle);
+        }
+    }
+}
+
+/*marks with HTTPAPIEX_OK the requests that completed, returns the result of HTTPAPI_ExecuteRequestBatch*/
+static HTTPAPI_RESULT executeBatchOnConnection(HTTPAPIEX_HANDLE_DATA* handleData, HTTP_HANDLE httpHandle, HTTPAPIEX_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+    HTTPAPIEX_BATCH_ENTRY* entries;
+    HTTPAPI_BATCH_REQUEST* batch;
+
+    if ((entries = (HTTPAPIEX_BATCH_ENTRY*)malloc(requestCount * sizeof(HTTPAPIEX_BATCH_ENTRY))) == NULL)
+    {
+        LogError("malloc failed.");
+        result = HTTPAPI_ALLOC_FAILED;
+    }
+    else if ((batch = (HTTPAPI_BATCH_REQUEST*)malloc(requestCount * sizeof(HTTPAPI_BATCH_REQUEST))) == NULL)
+    {
+        LogError("malloc failed.");
+        free(entries);
+        result = HTTPAPI_ALLOC_FAILED;
+    }
+    else
+    {
+        size_t built;
+
+        /*Codes_SRS_HTTPAPIEX_01_019: [Every request of the batch shall get the same default headers and temporary objects as a request executed by HTTPAPIEX_ExecuteRequest.]*/
+        for (built = 0; built < requestCount; built++)
+        {
+            const char* toBeUsedRelativePath;
+            unsigned int* toBeUsedStatusCode;
+
+            if (buildAllRequests(handleData, requests[built].requestType, requests[built].relativePath, requests[built].requestHttpHeadersHandle, requests[built].requestContent, &requests[built].statusCode, requests[built].responseHttpHeadersHandle, requests[built].responseContent,
+                &toBeUsedRelativePath,
+                &entries[built].requestHttpHeadersHandle, &entries[built].isOriginalRequestHttpHeadersHandle,
+                &entries[built].requestContent, &entries[built].isOriginalRequestContent,
+                &toBeUsedStatusCode,
+                &entries[built].responseHttpHeadersHandle, &entries[built].isOriginalResponseHttpHeadersHandle,
+                &entries[built].responseContent, &entries[built].isOriginalResponseContent) != 0)
+            {
+                LogError("unable to build request %lu of the batch", (unsigned long)built);
+                break;
+            }
+
+            batch[built].requestType = requests[built].requestType;
+            batch[built].relativePath = toBeUsedRelativePath;
+            batch[built].httpHeadersHandle = entries[built].requestHttpHeadersHandle;
+            batch[built].content = BUFFER_u_char(entries[built].requestContent);
+            batch[built].contentLength = BUFFER_length(entries[built].requestContent);
+            batch[built].responseHeadersHandle = entries[built].responseHttpHeadersHandle;
+            batch[built].responseContent = entries[built].responseContent;
+            batch[built].statusCode = 0;
+            batch[built].result = HTTPAPI_ERROR;
+        }
+
+        if (built < requestCount)
+        {
+            result = HTTPAPI_ERROR;
+        }
+        else
+        {
+            size_t i;
+
+            /*Codes_SRS_HTTPAPIEX_01_020: [HTTPAPIEX_ExecuteBatch shall hand the requests to HTTPAPI_ExecuteRequestBatch on a single connection.]*/
+            result = HTTPAPI_ExecuteRequestBatch(httpHandle, batch, requestCount);
+
+            for (i = 0; i < requestCount; i++)
+            {
+                if (batch[i].result == HTTPAPI_OK)
+                {
+                    requests[i].statusCode = batch[i].statusCode;
+                    requests[i].result = HTTPAPIEX_OK;
+                }
+            }
+        }
+
+        destroyBatchEntries(entries, built);
+        free(batch);
+        free(entries);
+    }
+    return result;
+}
+
+HTTPAPIEX_RESULT HTTPAPIEX_ExecuteBatch(HTTPAPIEX_HANDLE handle, HTTPAPIEX_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPIEX_RESULT result;
+    size_t i;
+
+    /*Codes_SRS_HTTPAPIEX_01_017: [If handle or requests is NULL, requestCount is 0 or any of the requests has an invalid requestType, HTTPAPIEX_ExecuteBatch shall return HTTPAPIEX_INVALID_ARG.]*/
+    if ((handle == NULL) || (requests == NULL) || (requestCount == 0))
+    {
+        result = HTTPAPIEX_INVALID_ARG;
+        LOG_HTTAPIEX_ERROR();
+    }
+    else
+    {
+        for (i = 0; i < requestCount; i++)
+        {
+            if (requests[i].requestType >= COUNT_ARG(HTTPAPI_REQUEST_TYPE_VALUES))
+            {
+                break;
+            }
+        }
+
+        if (i < requestCount)
+        {
+            result = HTTPAPIEX_INVALID_ARG;
+            LOG_HTTAPIEX_ERROR();
+        }
+        else
+        {
+            HTTPAPIEX_HANDLE_DATA* handleData = (HTTPAPIEX_HANDLE_DATA*)handle;
+            size_t first = 0; /*requests before first have already been executed on their own*/
+
+            for (i = 0; i < requestCount; i++)
+            {
+                requests[i].statusCode = 0;
+                requests[i].result = HTTPAPIEX_ERROR;
+            }
+
+            if (handleData->pool != NULL)
+            {
+                HTTPAPIEX_POOLED_CONNECTION* connection;
+
+                if (checkoutPooledConnection(handleData, true, &connection) != 0)
+                {
+                    LogError("unable to get a connection from the pool");
+                }
+                else if ((connection == NULL) &&
+                    ((connection = createPooledConnection(handleData)) == NULL))
+                {
+                    LogError("unable to create a pooled connection");
+                }
+                else
+                {
+                    /*Codes_SRS_HTTPAPIEX_01_022: [A pooled connection shall be returned to the pool only if the whole batch succeeded on it.]*/
+                    checkinPooledConnection(handleData, connection, executeBatchOnConnection(handleData, connection->httpHandle, requests, requestCount) == HTTPAPI_OK);
+                }
+            }
+            else
+            {
+                if (handleData->k != 2)
+                {
+                    /*Codes_SRS_HTTPAPIEX_01_018: [If the handle has no connection yet, the first request shall be executed by HTTPAPIEX_ExecuteRequest, which creates the connection, and the rest of the batch shall then use that connection.]*/
+                    requests[0].result = HTTPAPIEX_ExecuteRequest(handle, requests[0].requestType, requests[0].relativePath, requests[0].requestHttpHeadersHandle, requests[0].requestContent, &requests[0].statusCode, requests[0].responseHttpHeadersHandle, requests[0].responseContent);
+                    first = 1;
+                }
+
+                if ((first < requestCount) && (handleData->k == 2))
+                {
+                    (void)executeBatchOnConnection(handleData, handleData->httpHandle, requests + first, requestCount - first);
+                }
+            }
+
+            result = HTTPAPIEX_OK;
+            for (i = 0; i < requestCount; i++)
+            {
+                if ((i >= first) && (requests[i].result != HTTPAPIEX_OK))
+                {
+                    /*Codes_SRS_HTTPAPIEX_01_021: [Every request that did not complete in the batch shall be executed again by HTTPAPIEX_ExecuteRequest.]*/
+                    requests[i].result = HTTPAPIEX_ExecuteRequest(handle, requests[i].requestType, requests[i].relativePath, requests[i].requestHttpHeadersHandle, requests[i].requestContent, &requests[i].statusCode, requests[i].responseHttpHeadersHandle, requests[i].responseContent);
+                }
+
+                /*Codes_SRS_HTTPAPIEX_01_023: [HTTPAPIEX_ExecuteBatch shall return HTTPAPIEX_OK if all the requests succeeded, otherwise the result of the first request that failed.]*/
+                if ((requests[i].result != HTTPAPIEX_OK) && (result == HTTPAPIEX_OK))
+                {
+                    result = requests[i].result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+
 void HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
 {
     if (handle != NULL)
@@ -512,6 +1185,25 @@ void HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
             HTTPAPI_CloseConnection(handleData->httpHandle);
             HTTPAPI_Deinit();
         }
+
+        /*Codes_SRS_HTTPAPIEX_01_026: [HTTPAPIEX_Destroy shall close the connections that the handle does not share with other handles.]*/
+        if ((handleData->poolHost != NULL) && !handleData->poolHost->isShared)
+        {
+            if (Lock(handleData->pool->lock) != LOCK_OK)
+            {
+                /*the host stays linked to the pool, HTTPAPIEX_Pool_Destroy frees it*/
+                LogError("unable to Lock");
+            }
+            else
+            {
+                unlinkPoolHost(handleData->pool, handleData->poolHost);
+                (void)Unlock(handleData->pool->lock);
+
+                closePooledConnections(handleData->poolHost->idleConnections);
+                free(handleData->poolHost->hostName);
+                free(handleData->poolHost);
+            }
+        }
         STRING_delete(handleData->hostName);
 
         vectorSize = VECTOR_size(handleData->savedOptions);
@@ -579,6 +1271,54 @@ static int createOrUpdateOption(HTTPAPIEX_HANDLE_DATA* handleData, const char* o
     return result;
 }
 
+/*moves the handle to connections of its own (ownHost != NULL) or retires the connections it already owns*/
+static void useOwnPooledConnections(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPIEX_POOL_HOST* ownHost)
+{
+    HTTPAPIEX_POOL_DATA* pool = handleData->pool;
+    HTTPAPIEX_POOLED_CONNECTION* toBeClosed = NULL;
+    bool isLocked = (Lock(pool->lock) == LOCK_OK);
+
+    if (!isLocked)
+    {
+        /*an own host that is not linked to the pool is still freed by HTTPAPIEX_Destroy*/
+        LogError("unable to Lock");
+    }
+
+    if (ownHost != NULL)
+    {
+        /*Codes_SRS_HTTPAPIEX_01_024: [When HTTPAPIEX_SetOption is called on a handle created by HTTPAPIEX_CreateWithPool, the handle shall stop sharing connections with other handles and use connections of its own, opened with all its saved options.]*/
+        if (isLocked)
+        {
+            ownHost->next = pool->hosts;
+            pool->hosts = ownHost;
+        }
+        handleData->poolHost = ownHost;
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPIEX_01_025: [When HTTPAPIEX_SetOption is called on a handle that already has connections of its own, its idle connections shall be closed and the connections in use shall be closed when they are returned, so that every further request uses all the saved options.]*/
+        HTTPAPIEX_POOLED_CONNECTION* connection;
+        HTTPAPIEX_POOL_HOST* host = handleData->poolHost;
+
+        host->optionsGeneration++;
+        if (isLocked)
+        {
+            toBeClosed = host->idleConnections;
+            host->idleConnections = NULL;
+            for (connection = toBeClosed; connection != NULL; connection = connection->next)
+            {
+                host->connectionCount--;
+            }
+        }
+    }
+
+    if (isLocked)
+    {
+        (void)Unlock(pool->lock);
+    }
+    closePooledConnections(toBeClosed);
+}
+
 HTTPAPIEX_RESULT HTTPAPIEX_SetOption(HTTPAPIEX_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPIEX_RESULT result;
@@ -617,16 +1357,36 @@ HTTPAPIEX_RESULT HTTPAPIEX_SetOption(HTTPAPIEX_HANDLE handle, const char* option
         else
         {
             HTTPAPIEX_HANDLE_DATA* handleData = (HTTPAPIEX_HANDLE_DATA*)handle;
+            HTTPAPIEX_POOL_HOST* ownHost = NULL;
+
+            /*the connections of other handles do not carry this option, the own ones are made before the option is saved so a failure leaves the handle as it was*/
+            if ((handleData->pool != NULL) && handleData->poolHost->isShared &&
+                ((ownHost = createPoolHost(STRING_c_str(handleData->hostName), false)) == NULL))
+            {
+                free((void*)savedOption);
+                result = HTTPAPIEX_ERROR;
+                LOG_HTTAPIEX_ERROR();
+            }
             /*Codes_SRS_HTTPAPIEX_02_039: [If HTTPAPI_CloneOption returns HTTPAPI_OK then HTTPAPIEX_SetOption shall create or update the pair optionName/value.]*/
-            if (createOrUpdateOption(handleData, optionName, savedOption) != 0)
+            else if (createOrUpdateOption(handleData, optionName, savedOption) != 0)
             {
                 /*Codes_SRS_HTTPAPIEX_02_041: [If creating or updating the pair optionName/value fails then shall return HTTPAPIEX_ERROR.] */
+                if (ownHost != NULL)
+                {
+                    free(ownHost->hostName);
+                    free(ownHost);
+                }
                 result = HTTPAPIEX_ERROR;
                 LOG_HTTAPIEX_ERROR();
 
             }
             else
             {
+                if (handleData->pool != NULL)
+                {
+                    useOwnPooledConnections(handleData, ownHost);
+                }
+
                 /*Codes_SRS_HTTPAPIEX_02_031: [If HTTPAPI_HANDLE exists then HTTPAPIEX_SetOption shall call HTTPAPI_SetOption passing the same optionName and value and shall return a value conforming to the below table:] */
                 if (handleData->httpHandle != NULL)
                 {
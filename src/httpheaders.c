@@ -2,8 +2,8 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/map.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include <string.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
@@ -11,11 +11,214 @@
 
 DEFINE_ENUM_STRINGS(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 
+/*the header table holds this many headers before it first grows, which covers a typical request*/
+#define HTTP_HEADERS_INITIAL_CAPACITY 8
+
+typedef struct HTTP_HEADER_TAG
+{
+    /*name\0value\0 in a single allocation, or only value\0 when the name is interned*/
+    char* storage;
+    const char* name;
+    char* value;
+    size_t nameLength;
+    size_t valueLength;
+    size_t hash;
+} HTTP_HEADER;
+
 typedef struct HTTP_HEADERS_HANDLE_DATA_TAG
 {
-    MAP_HANDLE headers;
+    /*headers in the order they were added, followed in the same allocation by the index*/
+    HTTP_HEADER* headers;
+    size_t count;
+    size_t capacity;
+    /*open addressing table of (position in headers + 1), 0 marks an empty slot. It has 2 * capacity slots so it is never more than half full*/
+    size_t* index;
+    size_t indexSize;
+    /*the number of bytes HTTPHeaders_SerializeTo writes, kept up to date by every change*/
+    size_t serializedSize;
 } HTTP_HEADERS_HANDLE_DATA;
 
+typedef struct INTERNED_HEADER_NAME_TAG
+{
+    const char* name;
+    size_t length;
+} INTERNED_HEADER_NAME;
+
+#define INTERNED_HEADER_NAME_ENTRY(name) { name, sizeof(name) - 1 }
+
+/*names used by most requests and responses are not copied for every set of headers. Only a name spelled exactly as below is interned, so that a header is always serialized the way it was added*/
+static const INTERNED_HEADER_NAME internedHeaderNames[] =
+{
+    INTERNED_HEADER_NAME_ENTRY("Accept"),
+    INTERNED_HEADER_NAME_ENTRY("Authorization"),
+    INTERNED_HEADER_NAME_ENTRY("Connection"),
+    INTERNED_HEADER_NAME_ENTRY("Content-Encoding"),
+    INTERNED_HEADER_NAME_ENTRY("Content-Length"),
+    INTERNED_HEADER_NAME_ENTRY("Content-Type"),
+    INTERNED_HEADER_NAME_ENTRY("Date"),
+    INTERNED_HEADER_NAME_ENTRY("ETag"),
+    INTERNED_HEADER_NAME_ENTRY("Host"),
+    INTERNED_HEADER_NAME_ENTRY("If-Match"),
+    INTERNED_HEADER_NAME_ENTRY("Keep-Alive"),
+    INTERNED_HEADER_NAME_ENTRY("Request-Id"),
+    INTERNED_HEADER_NAME_ENTRY("Retry-After"),
+    INTERNED_HEADER_NAME_ENTRY("Server"),
+    INTERNED_HEADER_NAME_ENTRY("Transfer-Encoding"),
+    INTERNED_HEADER_NAME_ENTRY("User-Agent"),
+    INTERNED_HEADER_NAME_ENTRY("content-length"),
+    INTERNED_HEADER_NAME_ENTRY("content-type"),
+    INTERNED_HEADER_NAME_ENTRY("transfer-encoding")
+};
+
+static const char* headers_FindInternedName(const char* name, size_t nameLength)
+{
+    const char* result = NULL;
+    size_t i;
+    for (i = 0; i < sizeof(internedHeaderNames) / sizeof(internedHeaderNames[0]); i++)
+    {
+        if ((internedHeaderNames[i].length == nameLength) &&
+            (memcmp(internedHeaderNames[i].name, name, nameLength) == 0))
+        {
+            result = internedHeaderNames[i].name;
+            break;
+        }
+    }
+    return result;
+}
+
+static char headers_ToLower(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+}
+
+/*FNV-1a over the lower case name, header names are case-insensitive (RFC 7230 section 3.2)*/
+static size_t headers_HashName(const char* name, size_t nameLength)
+{
+    size_t result = (size_t)2166136261u;
+    size_t i;
+    for (i = 0; i < nameLength; i++)
+    {
+        result ^= (unsigned char)headers_ToLower(name[i]);
+        result *= (size_t)16777619u;
+    }
+    return result;
+}
+
+static bool headers_NameEquals(const HTTP_HEADER* header, const char* name, size_t nameLength, size_t hash)
+{
+    bool result;
+    if ((header->hash != hash) || (header->nameLength != nameLength))
+    {
+        result = false;
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < nameLength; i++)
+        {
+            if (headers_ToLower(header->name[i]) != headers_ToLower(name[i]))
+            {
+                break;
+            }
+        }
+        result = (i == nameLength);
+    }
+    return result;
+}
+
+/*returns the header with the given name or NULL*/
+static HTTP_HEADER* headers_Find(const HTTP_HEADERS_HANDLE_DATA* handleData, const char* name, size_t nameLength, size_t hash)
+{
+    HTTP_HEADER* result = NULL;
+    if (handleData->indexSize > 0)
+    {
+        size_t mask = handleData->indexSize - 1;
+        size_t slot = hash & mask;
+        while (handleData->index[slot] != 0)
+        {
+            HTTP_HEADER* header = &handleData->headers[handleData->index[slot] - 1];
+            if (headers_NameEquals(header, name, nameLength, hash))
+            {
+                result = header;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    return result;
+}
+
+static void headers_IndexInsert(HTTP_HEADERS_HANDLE_DATA* handleData, size_t position)
+{
+    size_t mask = handleData->indexSize - 1;
+    size_t slot = handleData->headers[position].hash & mask;
+    while (handleData->index[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    handleData->index[slot] = position + 1;
+}
+
+/*the headers and their index share one allocation, it doubles when full so that n headers cost O(n) copies overall*/
+static int headers_Grow(HTTP_HEADERS_HANDLE_DATA* handleData, size_t newCapacity)
+{
+    int result;
+    size_t newIndexSize = 2 * newCapacity;
+    HTTP_HEADER* newHeaders = (HTTP_HEADER*)malloc((newCapacity * sizeof(HTTP_HEADER)) + (newIndexSize * sizeof(size_t)));
+    if (newHeaders == NULL)
+    {
+        LogError("unable to grow the header table");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+        /*the table only grows when it is full, so it has not been allocated yet when there are no headers*/
+        if (handleData->count > 0)
+        {
+            (void)memcpy(newHeaders, handleData->headers, handleData->count * sizeof(HTTP_HEADER));
+            free(handleData->headers);
+        }
+
+        handleData->headers = newHeaders;
+        handleData->capacity = newCapacity;
+        handleData->index = (size_t*)(newHeaders + newCapacity);
+        handleData->indexSize = newIndexSize;
+        (void)memset(handleData->index, 0, newIndexSize * sizeof(size_t));
+        for (i = 0; i < handleData->count; i++)
+        {
+            headers_IndexInsert(handleData, i);
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*resizes the storage of header to hold a value of valueLength characters, name and value are moved with it*/
+static int headers_ResizeValue(HTTP_HEADER* header, size_t valueLength)
+{
+    int result;
+    bool isNameStored = (header->name == header->storage);
+    size_t valueOffset = isNameStored ? (header->nameLength + 1) : 0;
+    char* newStorage = (char*)realloc(header->storage, valueOffset + valueLength + 1);
+    if (newStorage == NULL)
+    {
+        LogError("unable to realloc");
+        result = __FAILURE__;
+    }
+    else
+    {
+        header->storage = newStorage;
+        if (isNameStored)
+        {
+            header->name = newStorage;
+        }
+        header->value = newStorage + valueOffset;
+        result = 0;
+    }
+    return result;
+}
+
 HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
 {
     /*Codes_SRS_HTTP_HEADERS_99_002:[ This API shall produce a HTTP_HANDLE that can later be used in subsequent calls to the module.]*/
@@ -29,17 +232,13 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
     else
     {
         /*Codes_SRS_HTTP_HEADERS_99_004:[ After a successful init, HTTPHeaders_GetHeaderCount shall report 0 existing headers.]*/
-        result->headers = Map_Create(NULL);
-        if (result->headers == NULL)
-        {
-            LogError("Map_Create failed");
-            free(result);
-            result = NULL;
-        }
-        else
-        {
-            /*all is fine*/
-        }
+        /*the header table is allocated with the first header*/
+        result->headers = NULL;
+        result->count = 0;
+        result->capacity = 0;
+        result->index = NULL;
+        result->indexSize = 0;
+        result->serializedSize = 0;
     }
 
     /*Codes_SRS_HTTP_HEADERS_99_003:[ The function shall return NULL when the function cannot execute properly]*/
@@ -58,8 +257,13 @@ void HTTPHeaders_Free(HTTP_HEADERS_HANDLE handle)
     {
         /*Codes_SRS_HTTP_HEADERS_99_005:[ Calling this API shall de-allocate the data structures allocated by previous API calls to the same handle.]*/
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
+        size_t i;
 
-        Map_Destroy(handleData->headers);
+        for (i = 0; i < handleData->count; i++)
+        {
+            free(handleData->headers[i].storage);
+        }
+        free(handleData->headers);
         free(handleData);
     }
 }
@@ -100,20 +304,33 @@ static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDL
         else
         {
             HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-            const char* existingValue = Map_GetValueFromKey(handleData->headers, name);
+            size_t hash = headers_HashName(name, nameLen);
+            /*Codes_SRS_HTTP_HEADERS_01_001: [ Header names shall be compared without regard to case. ]*/
+            HTTP_HEADER* existingHeader = headers_Find(handleData, name, nameLen, hash);
+            size_t valueLen;
             /*eat up the whitespaces from value, as per RFC 2616, chapter 4.2 "The field value MAY be preceded by any amount of LWS, though a single SP is preferred."*/
             /*Codes_SRS_HTTP_HEADERS_02_002: [The LWS from the beginning of the value shall not be stored.] */
             while ((value[0] == ' ') || (value[0] == '\t') || (value[0] == '\r') || (value[0] == '\n'))
             {
                 value++;
             }
+            valueLen = strlen(value);
 
-            if (!replace && (existingValue != NULL))
+            if (existingHeader == NULL)
             {
-                size_t existingValueLen = strlen(existingValue);
-                size_t valueLen = strlen(value);
-                char* newValue = (char*)malloc(sizeof(char) * (existingValueLen + /*COMMA_AND_SPACE_LENGTH*/ 2 + valueLen + /*EOL*/ 1));
-                if (newValue == NULL)
+                /*Codes_SRS_HTTP_HEADERS_01_002: [ A name spelled exactly as one of the commonly used header names shall not be copied. ]*/
+                const char* internedName = headers_FindInternedName(name, nameLen);
+                size_t storageSize = ((internedName == NULL) ? (nameLen + 1) : 0) + valueLen + 1;
+                char* storage;
+
+                if ((handleData->count == handleData->capacity) &&
+                    (headers_Grow(handleData, (handleData->capacity == 0) ? HTTP_HEADERS_INITIAL_CAPACITY : (2 * handleData->capacity)) != 0))
+                {
+                    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+                    result = HTTP_HEADERS_ALLOC_FAILED;
+                    LogError("failed to grow the headers, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+                }
+                else if ((storage = (char*)malloc(storageSize)) == NULL)
                 {
                     /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
                     result = HTTP_HEADERS_ALLOC_FAILED;
@@ -121,40 +338,81 @@ static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDL
                 }
                 else
                 {
-                    char* runNewValue;
-                    /*Codes_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
-                    (void)memcpy(newValue, existingValue, existingValueLen);
-                    runNewValue = newValue + existingValueLen;
-                    (*runNewValue++) = ',';
-                    (*runNewValue++) = ' ';
-                    (void)memcpy(runNewValue, value, valueLen + /*EOL*/ 1);
-
                     /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                    if (Map_AddOrUpdate(handleData->headers, name, newValue) != MAP_OK)
+                    HTTP_HEADER* header = &handleData->headers[handleData->count];
+                    header->storage = storage;
+                    if (internedName == NULL)
                     {
-                        /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-                        result = HTTP_HEADERS_ERROR;
-                        LogError("failed to Map_AddOrUpdate, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+                        (void)memcpy(storage, name, nameLen + 1);
+                        header->name = storage;
+                        header->value = storage + nameLen + 1;
                     }
                     else
                     {
-                        /*Codes_SRS_HTTP_HEADERS_99_013:[ The function shall return HTTP_HEADERS_OK when execution is successful.]*/
-                        result = HTTP_HEADERS_OK;
+                        header->name = internedName;
+                        header->value = storage;
+                    }
+                    (void)memcpy(header->value, value, valueLen + 1);
+                    header->nameLength = nameLen;
+                    header->valueLength = valueLen;
+                    header->hash = hash;
+
+                    headers_IndexInsert(handleData, handleData->count);
+                    handleData->count++;
+                    handleData->serializedSize += nameLen + /*COLON_AND_SPACE_LENGTH*/ 2 + valueLen + /*CRLF*/ 2;
+
+                    /*Codes_SRS_HTTP_HEADERS_99_013:[ The function shall return HTTP_HEADERS_OK when execution is successful.]*/
+                    result = HTTP_HEADERS_OK;
+                }
+            }
+            else if (!replace)
+            {
+                /*Codes_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
+                size_t existingValueLen = existingHeader->valueLength;
+                /*value may point into the stored value, which the realloc below moves, so it is kept as an offset*/
+                bool isValueStored = (value >= existingHeader->value) && (value <= existingHeader->value + existingValueLen);
+                size_t valueOffset = isValueStored ? (size_t)(value - existingHeader->value) : 0;
+                if (headers_ResizeValue(existingHeader, existingValueLen + /*COMMA_AND_SPACE_LENGTH*/ 2 + valueLen) != 0)
+                {
+                    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+                    result = HTTP_HEADERS_ALLOC_FAILED;
+                    LogError("failed to realloc , result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+                }
+                else
+                {
+                    char* runNewValue = existingHeader->value + existingValueLen;
+                    if (isValueStored)
+                    {
+                        value = existingHeader->value + valueOffset;
                     }
-                    free(newValue);
+                    (*runNewValue++) = ',';
+                    (*runNewValue++) = ' ';
+                    /*the comma overwrote the terminator of a stored value, so only its characters are copied*/
+                    (void)memcpy(runNewValue, value, valueLen);
+                    runNewValue[valueLen] = '\0';
+                    existingHeader->valueLength = existingValueLen + 2 + valueLen;
+                    handleData->serializedSize += 2 + valueLen;
+
+                    result = HTTP_HEADERS_OK;
                 }
             }
             else
             {
-                /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                if (Map_AddOrUpdate(handleData->headers, name, value) != MAP_OK)
+                /*Codes_SRS_HTTP_HEADERS_06_001: [This API will perform exactly as HTTPHeaders_AddHeaderNameValuePair except that if the header name already exists the already existing value will be replaced as opposed to concatenated to.] */
+                if ((valueLen > existingHeader->valueLength) &&
+                    (headers_ResizeValue(existingHeader, valueLen) != 0))
                 {
                     /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
                     result = HTTP_HEADERS_ALLOC_FAILED;
-                    LogError("failed to Map_AddOrUpdate, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+                    LogError("failed to realloc , result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
                 }
                 else
                 {
+                    /*value may point into the stored value, which memmove tolerates*/
+                    (void)memmove(existingHeader->value, value, valueLen + /*EOL*/ 1);
+                    handleData->serializedSize = handleData->serializedSize - existingHeader->valueLength + valueLen;
+                    existingHeader->valueLength = valueLen;
+
                     result = HTTP_HEADERS_OK;
                 }
             }
@@ -192,8 +450,11 @@ const char* HTTPHeaders_FindHeaderValue(HTTP_HEADERS_HANDLE httpHeadersHandle, c
         /*Codes_SRS_HTTP_HEADERS_99_018:[ Calling this API shall retrieve the value for a previously stored name.]*/
         /*Codes_SRS_HTTP_HEADERS_99_020:[ The return value shall be different than NULL when the name matches the name of a previously stored name:value pair.] */
         /*Codes_SRS_HTTP_HEADERS_99_021:[ In this case the return value shall point to a string that shall strcmp equal to the original stored string.]*/
+        /*Codes_SRS_HTTP_HEADERS_01_001: [ Header names shall be compared without regard to case. ]*/
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle;
-        result = Map_GetValueFromKey(handleData->headers, name);
+        size_t nameLen = strlen(name);
+        HTTP_HEADER* header = headers_Find(handleData, name, nameLen, headers_HashName(name, nameLen));
+        result = (header == NULL) ? NULL : header->value;
     }
     return result;
 
@@ -213,20 +474,10 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeaderCount(HTTP_HEADERS_HANDLE handle, size_
     else
     {
         HTTP_HEADERS_HANDLE_DATA *handleData = (HTTP_HEADERS_HANDLE_DATA *)handle;
-        const char*const* keys;
-        const char*const* values;
         /*Codes_SRS_HTTP_HEADERS_99_023:[ Calling this API shall provide the number of stored headers.]*/
-        if (Map_GetInternals(handleData->headers, &keys, &values, headerCount) != MAP_OK)
-        {
-            /*Codes_SRS_HTTP_HEADERS_99_037:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs.]*/
-            result = HTTP_HEADERS_ERROR;
-            LogError("Map_GetInternals failed, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-        }
-        else
-        {
-            /*Codes_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
-            result = HTTP_HEADERS_OK;
-        }
+        /*Codes_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
+        *headerCount = handleData->count;
+        result = HTTP_HEADERS_OK;
     }
 
     return result;
@@ -248,51 +499,110 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t ind
         LogError("invalid arg (NULL), result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
     }
     /*Codes_SRS_HTTP_HEADERS_99_029:[ The function shall return HTTP_HEADERS_INVALID_ARG if index is not valid (for example, out of range) for the currently stored headers.]*/
+    else if (index >= ((HTTP_HEADERS_HANDLE_DATA*)handle)->count)
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("index out of bounds, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
     else
     {
-        HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-        const char*const* keys;
-        const char*const* values;
-        size_t headerCount;
-        if (Map_GetInternals(handleData->headers, &keys, &values, &headerCount) != MAP_OK)
+        const HTTP_HEADER* header = &((HTTP_HEADERS_HANDLE_DATA*)handle)->headers[index];
+        *destination = (char*)malloc(sizeof(char) * (header->nameLength + /*COLON_AND_SPACE_LENGTH*/ 2 + header->valueLength + /*EOL*/ 1));
+        if (*destination == NULL)
         {
             /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
             result = HTTP_HEADERS_ERROR;
-            LogError("Map_GetInternals failed, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+            LogError("unable to malloc, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
         }
         else
         {
-            /*Codes_SRS_HTTP_HEADERS_99_029:[ The function shall return HTTP_HEADERS_INVALID_ARG if index is not valid (for example, out of range) for the currently stored headers.]*/
-            if (index >= headerCount)
-            {
-                result = HTTP_HEADERS_INVALID_ARG;
-                LogError("index out of bounds, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-            }
-            else
+            /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
+            /*Codes_SRS_HTTP_HEADERS_99_027:[ Calling this API shall produce the string value+": "+pair) for the index header in the *destination parameter.]*/
+            char* runDestination = (*destination);
+            (void)memcpy(runDestination, header->name, header->nameLength);
+            runDestination += header->nameLength;
+            (*runDestination++) = ':';
+            (*runDestination++) = ' ';
+            (void)memcpy(runDestination, header->value, header->valueLength + /*EOL*/ 1);
+            /*Codes_SRS_HTTP_HEADERS_99_035:[ The function shall return HTTP_HEADERS_OK when the function executed without error.]*/
+            result = HTTP_HEADERS_OK;
+        }
+    }
+
+    return result;
+}
+
+HTTP_HEADERS_RESULT HTTPHeaders_GetHeaderNameValue(HTTP_HEADERS_HANDLE handle, size_t index, const char** name, const char** value)
+{
+    HTTP_HEADERS_RESULT result;
+
+    /*Codes_SRS_HTTP_HEADERS_01_007: [ If handle, name or value is NULL, or index is not smaller than the number of stored headers, HTTPHeaders_GetHeaderNameValue shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    if ((handle == NULL) ||
+        (name == NULL) ||
+        (value == NULL))
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("invalid arg (NULL), result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else if (index >= ((HTTP_HEADERS_HANDLE_DATA*)handle)->count)
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("index out of bounds, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else
+    {
+        /*Codes_SRS_HTTP_HEADERS_01_008: [ Otherwise HTTPHeaders_GetHeaderNameValue shall write in *name and *value the stored name and value of the header at index, without copying them, and return HTTP_HEADERS_OK. ]*/
+        const HTTP_HEADER* header = &((HTTP_HEADERS_HANDLE_DATA*)handle)->headers[index];
+        *name = header->name;
+        *value = header->value;
+        result = HTTP_HEADERS_OK;
+    }
+
+    return result;
+}
+
+HTTP_HEADERS_RESULT HTTPHeaders_SerializeTo(HTTP_HEADERS_HANDLE httpHeadersHandle, char* buffer, size_t bufferSize, size_t* serializedSize)
+{
+    HTTP_HEADERS_RESULT result;
+
+    /*Codes_SRS_HTTP_HEADERS_01_003: [ If httpHeadersHandle or serializedSize is NULL, or buffer is NULL while bufferSize is not 0, HTTPHeaders_SerializeTo shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    if ((httpHeadersHandle == NULL) ||
+        (serializedSize == NULL) ||
+        ((buffer == NULL) && (bufferSize > 0)))
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("invalid arg, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else
+    {
+        HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle;
+
+        /*Codes_SRS_HTTP_HEADERS_01_004: [ HTTPHeaders_SerializeTo shall write in *serializedSize the number of bytes the serialized headers take. ]*/
+        *serializedSize = handleData->serializedSize;
+        if (bufferSize < handleData->serializedSize)
+        {
+            /*Codes_SRS_HTTP_HEADERS_01_005: [ If bufferSize is smaller than that, HTTPHeaders_SerializeTo shall not write to buffer and shall return HTTP_HEADERS_INSUFFICIENT_BUFFER. ]*/
+            /*not logged, this is how a caller learns the size to allocate*/
+            result = HTTP_HEADERS_INSUFFICIENT_BUFFER;
+        }
+        else
+        {
+            /*Codes_SRS_HTTP_HEADERS_01_006: [ Otherwise HTTPHeaders_SerializeTo shall write every header as name+": "+value+"\r\n", in the order the headers were added and without a terminating '\0', and return HTTP_HEADERS_OK. ]*/
+            size_t i;
+            char* runBuffer = buffer;
+            for (i = 0; i < handleData->count; i++)
             {
-                size_t keyLen = strlen(keys[index]);
-                size_t valueLen = strlen(values[index]);
-                *destination = (char*)malloc(sizeof(char) * (keyLen + /*COLON_AND_SPACE_LENGTH*/ 2 + valueLen + /*EOL*/ 1));
-                if (*destination == NULL)
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
-                    result = HTTP_HEADERS_ERROR;
-                    LogError("unable to malloc, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-                }
-                else
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                    /*Codes_SRS_HTTP_HEADERS_99_027:[ Calling this API shall produce the string value+": "+pair) for the index header in the *destination parameter.]*/
-                    char* runDestination = (*destination);
-                    (void)memcpy(runDestination, keys[index], keyLen);
-                    runDestination += keyLen;
-                    (*runDestination++) = ':';
-                    (*runDestination++) = ' ';
-                    (void)memcpy(runDestination, values[index], valueLen + /*EOL*/ 1);
-                    /*Codes_SRS_HTTP_HEADERS_99_035:[ The function shall return HTTP_HEADERS_OK when the function executed without error.]*/
-                    result = HTTP_HEADERS_OK;
-                }
+                const HTTP_HEADER* header = &handleData->headers[i];
+                (void)memcpy(runBuffer, header->name, header->nameLength);
+                runBuffer += header->nameLength;
+                (*runBuffer++) = ':';
+                (*runBuffer++) = ' ';
+                (void)memcpy(runBuffer, header->value, header->valueLength);
+                runBuffer += header->valueLength;
+                (*runBuffer++) = '\r';
+                (*runBuffer++) = '\n';
             }
+            result = HTTP_HEADERS_OK;
         }
     }
 
@@ -310,7 +620,7 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle)
     else
     {
         /*Codes_SRS_HTTP_HEADERS_02_004: [Otherwise HTTPHeaders_Clone shall clone the content of handle to a new handle.] */
-        result = (HTTP_HEADERS_HANDLE_DATA*)malloc(sizeof(HTTP_HEADERS_HANDLE_DATA));
+        result = (HTTP_HEADERS_HANDLE_DATA*)HTTPHeaders_Alloc();
         if (result == NULL)
         {
             /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
@@ -318,16 +628,52 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle)
         else
         {
             HTTP_HEADERS_HANDLE_DATA* handleData = handle;
-            result->headers = Map_Clone(handleData->headers);
-            if (result->headers == NULL)
+            if ((handleData->count > 0) &&
+                (headers_Grow(result, handleData->capacity) != 0))
             {
                 /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
-                free(result);
+                HTTPHeaders_Free(result);
                 result = NULL;
             }
             else
             {
-                /*all is fine*/
+                size_t i;
+                for (i = 0; i < handleData->count; i++)
+                {
+                    const HTTP_HEADER* header = &handleData->headers[i];
+                    bool isNameStored = (header->name == header->storage);
+                    size_t storageSize = (isNameStored ? (header->nameLength + 1) : 0) + header->valueLength + 1;
+                    HTTP_HEADER* clonedHeader = &result->headers[i];
+
+                    if ((clonedHeader->storage = (char*)malloc(storageSize)) == NULL)
+                    {
+                        break;
+                    }
+                    (void)memcpy(clonedHeader->storage, header->storage, storageSize);
+                    clonedHeader->name = isNameStored ? clonedHeader->storage : header->name;
+                    clonedHeader->value = clonedHeader->storage + (header->value - header->storage);
+                    clonedHeader->nameLength = header->nameLength;
+                    clonedHeader->valueLength = header->valueLength;
+                    clonedHeader->hash = header->hash;
+                    result->count++;
+                }
+
+                if (i < handleData->count)
+                {
+                    /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
+                    LogError("unable to clone the headers");
+                    HTTPHeaders_Free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    /*positions are the same as in handle, so is the index, which headers without any entry do not have*/
+                    if (handleData->count > 0)
+                    {
+                        (void)memcpy(result->index, handleData->index, handleData->indexSize * sizeof(size_t));
+                    }
+                    result->serializedSize = handleData->serializedSize;
+                }
             }
         }
     }
@@ -10,11 +10,18 @@
 
 DEFINE_ENUM_STRINGS(MAP_RESULT, MAP_RESULT_VALUES);
 
+/*maps with at most this many keys are searched linearly, a hash index is built above it*/
+#define MAP_HASH_INDEX_THRESHOLD 8
+
 typedef struct MAP_HANDLE_DATA_TAG
 {
     char** keys;
     char** values;
     size_t count;
+    size_t capacity;
+    /*open addressing table of (position in keys + 1), 0 marks an empty slot. NULL when the map is small or the index could not be allocated*/
+    size_t* index;
+    size_t indexSize;
     MAP_FILTER_CALLBACK mapFilterCallback;
 }MAP_HANDLE_DATA;
 
@@ -31,11 +38,93 @@ MAP_HANDLE Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
         result->keys = NULL;
         result->values = NULL;
         result->count = 0;
+        result->capacity = 0;
+        result->index = NULL;
+        result->indexSize = 0;
         result->mapFilterCallback = mapFilterFunc;
     }
     return (MAP_HANDLE)result;
 }
 
+/*FNV-1a*/
+static size_t Map_HashKey(const char* key)
+{
+    size_t result = (size_t)2166136261u;
+    while (*key != '\0')
+    {
+        result ^= (unsigned char)*key;
+        result *= (size_t)16777619u;
+        key++;
+    }
+    return result;
+}
+
+static void Map_IndexInsert(MAP_HANDLE_DATA* handleData, size_t position)
+{
+    size_t mask = handleData->indexSize - 1;
+    size_t slot = Map_HashKey(handleData->keys[position]) & mask;
+    while (handleData->index[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    handleData->index[slot] = position + 1;
+}
+
+static void Map_FreeIndex(MAP_HANDLE_DATA* handleData)
+{
+    if (handleData->index != NULL)
+    {
+        free(handleData->index);
+        handleData->index = NULL;
+        handleData->indexSize = 0;
+    }
+}
+
+/*(re)builds the hash index so that it is at most half full. If memory cannot be obtained, the map falls back to linear search*/
+static void Map_RebuildIndex(MAP_HANDLE_DATA* handleData)
+{
+    if (handleData->count <= MAP_HASH_INDEX_THRESHOLD)
+    {
+        Map_FreeIndex(handleData);
+    }
+    else
+    {
+        size_t newIndexSize = (handleData->indexSize == 0) ? (2 * MAP_HASH_INDEX_THRESHOLD) : handleData->indexSize;
+        size_t* newIndex;
+        while (newIndexSize < 2 * handleData->count)
+        {
+            newIndexSize *= 2;
+        }
+
+        if (newIndexSize == handleData->indexSize)
+        {
+            /*the current table is large enough, it is only refilled*/
+            newIndex = handleData->index;
+        }
+        else
+        {
+            newIndex = (size_t*)malloc(newIndexSize * sizeof(size_t));
+            if (newIndex == NULL)
+            {
+                LogError("unable to allocate the map index, falling back to linear search");
+            }
+            Map_FreeIndex(handleData);
+        }
+
+        if (newIndex != NULL)
+        {
+            size_t i;
+            (void)memset(newIndex, 0, newIndexSize * sizeof(size_t));
+            handleData->index = newIndex;
+            handleData->indexSize = newIndexSize;
+            for (i = 0; i < handleData->count; i++)
+            {
+                Map_IndexInsert(handleData, i);
+            }
+        }
+    }
+}
+
 void Map_Destroy(MAP_HANDLE handle)
 {
     /*Codes_SRS_MAP_02_005: [If parameter handle is NULL then Map_Destroy shall take no action.] */
@@ -52,6 +141,7 @@ void Map_Destroy(MAP_HANDLE handle)
         }
         free(handleData->keys);
         free(handleData->values);
+        Map_FreeIndex(handleData);
         free(handleData);
     }
 }
@@ -117,9 +207,12 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
         }
         else
         {
+            result->index = NULL;
+            result->indexSize = 0;
             if (handleData->count == 0)
             {
                 result->count = 0;
+                result->capacity = 0;
                 result->keys = NULL;
                 result->values = NULL;
                 result->mapFilterCallback = NULL;
@@ -128,6 +221,7 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
             {
                 result->mapFilterCallback = handleData->mapFilterCallback;
                 result->count = handleData->count;
+                result->capacity = handleData->count;
                 if( (result->keys = Map_CloneVector((const char* const*)handleData->keys, handleData->count))==NULL)
                 {
                     /*Codes_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
@@ -151,6 +245,7 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
                 else
                 {
                     /*all fine, return it*/
+                    Map_RebuildIndex(result);
                 }
             }
         }
@@ -161,46 +256,52 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
 static int Map_IncreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
 {
     int result;
-    char** newKeys = (char**)realloc(handleData->keys, (handleData->count + 1) * sizeof(char*));
-    if (newKeys == NULL)
+    if (handleData->count < handleData->capacity)
     {
-        LogError("realloc error");
-        result = __FAILURE__;
+        /*there is room left from a previous growth*/
+        handleData->keys[handleData->count] = NULL;
+        handleData->values[handleData->count] = NULL;
+        handleData->count++;
+        result = 0;
     }
     else
     {
-        char** newValues;
-        handleData->keys = newKeys;
-        handleData->keys[handleData->count] = NULL;
-        newValues = (char**)realloc(handleData->values, (handleData->count + 1) * sizeof(char*));
-        if (newValues == NULL)
+        /*capacity doubles so that n inserts cost O(n) copies overall*/
+        size_t newCapacity = (handleData->capacity == 0) ? 1 : (2 * handleData->capacity);
+        char** newKeys = (char**)realloc(handleData->keys, newCapacity * sizeof(char*));
+        if (newKeys == NULL)
         {
             LogError("realloc error");
-            if (handleData->count == 0) /*avoiding an implementation defined behavior */
-            {
-                free(handleData->keys);
-                handleData->keys = NULL;
-            }
-            else
+            result = __FAILURE__;
+        }
+        else
+        {
+            char** newValues;
+            handleData->keys = newKeys;
+            handleData->keys[handleData->count] = NULL;
+            newValues = (char**)realloc(handleData->values, newCapacity * sizeof(char*));
+            if (newValues == NULL)
             {
-                char** undoneKeys = (char**)realloc(handleData->keys, (handleData->count) * sizeof(char*));
-                if (undoneKeys == NULL)
+                LogError("realloc error");
+                if (handleData->count == 0) /*avoiding an implementation defined behavior */
                 {
-                    LogError("CATASTROPHIC error, unable to undo through realloc to a smaller size");
+                    free(handleData->keys);
+                    handleData->keys = NULL;
                 }
                 else
                 {
-                    handleData->keys = undoneKeys;
+                    /*keys is now larger than capacity, which is harmless*/
                 }
+                result = __FAILURE__;
+            }
+            else
+            {
+                handleData->values = newValues;
+                handleData->values[handleData->count] = NULL;
+                handleData->capacity = newCapacity;
+                handleData->count++;
+                result = 0;
             }
-            result = __FAILURE__;
-        }
-        else
-        {
-            handleData->values = newValues;
-            handleData->values[handleData->count] = NULL;
-            handleData->count++;
-            result = 0;
         }
     }
     return result;
@@ -215,32 +316,12 @@ static void Map_DecreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
         free(handleData->values);
         handleData->values = NULL;
         handleData->count = 0;
+        handleData->capacity = 0;
         handleData->mapFilterCallback = NULL;
     }
     else
     {
-        /*certainly > 1...*/
-        char** undoneValues;
-        char** undoneKeys = (char**)realloc(handleData->keys, sizeof(char*)* (handleData->count - 1));
-        if (undoneKeys == NULL)
-        {
-            LogError("CATASTROPHIC error, unable to undo through realloc to a smaller size");
-        }
-        else
-        {
-            handleData->keys = undoneKeys;
-        }
-
-        undoneValues = (char**)realloc(handleData->values, sizeof(char*)* (handleData->count - 1));
-        if (undoneValues == NULL)
-        {
-            LogError("CATASTROPHIC error, unable to undo through realloc to a smaller size");
-        }
-        else
-        {
-            handleData->values = undoneValues;
-        }
-
+        /*certainly > 1... capacity is kept for the next insert*/
         handleData->count--;
     }
 }
@@ -252,6 +333,22 @@ static char** findKey(MAP_HANDLE_DATA* handleData, const char* key)
     {
         result = NULL;
     }
+    else if (handleData->index != NULL)
+    {
+        size_t mask = handleData->indexSize - 1;
+        size_t slot = Map_HashKey(key) & mask;
+        result = NULL;
+        while (handleData->index[slot] != 0)
+        {
+            size_t position = handleData->index[slot] - 1;
+            if (strcmp(handleData->keys[position], key) == 0)
+            {
+                result = handleData->keys + position;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
     else
     {
         size_t i;
@@ -317,6 +414,15 @@ static int insertNewKeyValue(MAP_HANDLE_DATA* handleData, const char* key, const
             }
             else
             {
+                if ((handleData->index != NULL) &&
+                    (2 * handleData->count <= handleData->indexSize))
+                {
+                    Map_IndexInsert(handleData, handleData->count - 1);
+                }
+                else if (handleData->count > MAP_HASH_INDEX_THRESHOLD)
+                {
+                    Map_RebuildIndex(handleData);
+                }
                 result = 0;
             }
         }
@@ -470,6 +576,11 @@ MAP_RESULT Map_Delete(MAP_HANDLE handle, const char* key)
             memmove(handleData->keys + index, handleData->keys + index + 1, (handleData->count - index - 1)*sizeof(char*)); /*if order doesn't matter... then this can be optimized*/
             memmove(handleData->values + index, handleData->values + index + 1, (handleData->count - index - 1)*sizeof(char*));
             Map_DecreaseStorageKeysValues(handleData);
+            if (handleData->index != NULL)
+            {
+                /*positions after the deleted key have shifted*/
+                Map_RebuildIndex(handleData);
+            }
             result = MAP_OK;
         }
 
@@ -41,9 +41,34 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "azure_c_shared_utility/sha.h"
 #include "azure_c_shared_utility/sha-private.h"
+
+/*
+* x86 builds get a SHA-NI block function that is picked at run time,
+* ARMv8 builds that target the cryptography extensions can use them
+* by defining USE_SHA256_ARMV8 (CMake option use_sha256_armv8); that
+* path has not been run against the sha_ut vectors on ARM yet.
+* Everybody else (and NO_SHA256_HW builds) use the portable code.
+*/
+#if !defined(NO_SHA256_HW) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#if defined(_MSC_VER) && (_MSC_VER >= 1900)
+#define SHA256_USE_SHANI
+#define SHA256_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#elif (defined(__GNUC__) && (__GNUC__ >= 5)) || defined(__clang__)
+#define SHA256_USE_SHANI
+#define SHA256_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+#elif !defined(NO_SHA256_HW) && defined(USE_SHA256_ARMV8) && defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define SHA256_USE_ARMV8
+#include <arm_neon.h>
+#endif
 /* Define the SHA shift, rotate left and rotate right macro */
 #define SHA256_SHR(bits,word)      ((word) >> (bits))
 #define SHA256_ROTL(bits,word)                         \
@@ -69,13 +94,34 @@
     (((context)->Length_Low += (length)) < addTemp) &&     \
     (++(context)->Length_High == 0) ? 1 : 0)
 
+/* Largest number of blocks whose length in bits fits in 32 bits */
+#define SHA256_MAX_DIRECT_BLOCKS (0xFFFFFFFFu / (SHA256_Message_Block_Size * 8))
+
 /* Local Function Prototypes */
 static void SHA224_256Finalize(SHA256Context *context, uint8_t Pad_Byte);
 static void SHA224_256PadMessage(SHA256Context *context, uint8_t Pad_Byte);
 static void SHA224_256ProcessMessageBlock(SHA256Context *context);
+static void SHA224_256ProcessBlocks(uint32_t *Intermediate_Hash, const uint8_t *message_array, size_t blocks);
 static int SHA224_256Reset(SHA256Context *context, uint32_t *H0);
 static int SHA224_256ResultN(SHA256Context *context, uint8_t Message_Digest[], int HashSize);
 
+/* Constants defined in FIPS-180-2, section 4.2.2 */
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+    0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+    0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+    0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
 /* Initial Hash Values: FIPS-180-2 Change Notice 1 */
 static uint32_t SHA224_H0[SHA256HashSize / 4] = {
     0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939,
@@ -239,15 +285,44 @@ int SHA256Input(SHA256Context *context, const uint8_t *message_array, unsigned i
     }
     else
     {
-        while (length-- && !context->Corrupted)
+        while (length && !context->Corrupted)
         {
-            context->Message_Block[context->Message_Block_Index++] = (*message_array & 0xFF);
-
-            if (!SHA224_256AddLength(context, 8) && (context->Message_Block_Index == SHA256_Message_Block_Size))
+            if ((context->Message_Block_Index == 0) && (length >= SHA256_Message_Block_Size))
             {
-                SHA224_256ProcessMessageBlock(context);
+                /*
+                * Whole blocks are hashed straight from message_array. At most
+                * SHA256_MAX_DIRECT_BLOCKS at a time so that their bit count
+                * fits in 32 bits.
+                */
+                unsigned int blocks = length / SHA256_Message_Block_Size;
+                if (blocks > SHA256_MAX_DIRECT_BLOCKS)
+                {
+                    blocks = SHA256_MAX_DIRECT_BLOCKS;
+                }
+                if (!SHA224_256AddLength(context, blocks * SHA256_Message_Block_Size * 8))
+                {
+                    SHA224_256ProcessBlocks(context->Intermediate_Hash, message_array, blocks);
+                }
+                message_array += blocks * SHA256_Message_Block_Size;
+                length -= blocks * SHA256_Message_Block_Size;
+            }
+            else
+            {
+                unsigned int copied = (unsigned int)(SHA256_Message_Block_Size - context->Message_Block_Index);
+                if (copied > length)
+                {
+                    copied = length;
+                }
+                (void)memcpy(&context->Message_Block[context->Message_Block_Index], message_array, copied);
+                context->Message_Block_Index += (int_least16_t)copied;
+
+                if (!SHA224_256AddLength(context, copied * 8) && (context->Message_Block_Index == SHA256_Message_Block_Size))
+                {
+                    SHA224_256ProcessMessageBlock(context);
+                }
+                message_array += copied;
+                length -= copied;
             }
-            message_array++;
         }
         result = shaSuccess;
     }
@@ -450,83 +525,323 @@ static void SHA224_256PadMessage(SHA256Context *context, uint8_t Pad_Byte)
 *
 * Returns:
 *   Nothing.
+*/
+static void SHA224_256ProcessMessageBlock(SHA256Context *context)
+{
+    SHA224_256ProcessBlocks(context->Intermediate_Hash, context->Message_Block, 1);
+    context->Message_Block_Index = 0;
+}
+
+/*
+* SHA224_256ProcessBlocksPortable
+*
+* Description:
+*   This function will process consecutive 512 bit blocks of the
+*   message in plain C.
+*
+* Parameters:
+*   Intermediate_Hash: [in/out]
+*     The 8 words of the hash to update
+*   message_array: [in]
+*     The blocks to process
+*   blocks: [in]
+*     The number of blocks in message_array
+*
+* Returns:
+*   Nothing.
 *
 * Comments:
 *   Many of the variable names in this code, especially the
 *   single character names, were used because those were the
 *   names used in the publication.
 */
-static void SHA224_256ProcessMessageBlock(SHA256Context *context)
+static void SHA224_256ProcessBlocksPortable(uint32_t *Intermediate_Hash, const uint8_t *message_array, size_t blocks)
 {
-    /* Constants defined in FIPS-180-2, section 4.2.2 */
-    static const uint32_t K[64] = {
-        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
-        0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
-        0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
-        0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-        0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
-        0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
-        0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
-        0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
-        0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-    };
     int        t, t4;                   /* Loop counter */
     uint32_t   temp1, temp2;            /* Temporary word value */
     uint32_t   W[64];                   /* Word sequence */
     uint32_t   A, B, C, D, E, F, G, H;  /* Word buffers */
 
-    /*
-    * Initialize the first 16 words in the array W
-    */
-    for (t = t4 = 0; t < 16; t++, t4 += 4)
+    while (blocks-- > 0)
     {
-        W[t] = (((uint32_t)context->Message_Block[t4]) << 24) |
-            (((uint32_t)context->Message_Block[t4 + 1]) << 16) |
-            (((uint32_t)context->Message_Block[t4 + 2]) << 8) |
-            (((uint32_t)context->Message_Block[t4 + 3]));
+        /*
+        * Initialize the first 16 words in the array W
+        */
+        for (t = t4 = 0; t < 16; t++, t4 += 4)
+        {
+            W[t] = (((uint32_t)message_array[t4]) << 24) |
+                (((uint32_t)message_array[t4 + 1]) << 16) |
+                (((uint32_t)message_array[t4 + 2]) << 8) |
+                (((uint32_t)message_array[t4 + 3]));
+        }
+        for (t = 16; t < 64; t++)
+        {
+            W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
+                SHA256_sigma0(W[t - 15]) + W[t - 16];
+        }
+        A = Intermediate_Hash[0];
+        B = Intermediate_Hash[1];
+        C = Intermediate_Hash[2];
+        D = Intermediate_Hash[3];
+        E = Intermediate_Hash[4];
+        F = Intermediate_Hash[5];
+        G = Intermediate_Hash[6];
+        H = Intermediate_Hash[7];
+
+        for (t = 0; t < 64; t++)
+        {
+            temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + SHA256_K[t] + W[t];
+            temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
+            H = G;
+            G = F;
+            F = E;
+            E = D + temp1;
+            D = C;
+            C = B;
+            B = A;
+            A = temp1 + temp2;
+        }
+
+        Intermediate_Hash[0] += A;
+        Intermediate_Hash[1] += B;
+        Intermediate_Hash[2] += C;
+        Intermediate_Hash[3] += D;
+        Intermediate_Hash[4] += E;
+        Intermediate_Hash[5] += F;
+        Intermediate_Hash[6] += G;
+        Intermediate_Hash[7] += H;
+
+        message_array += SHA256_Message_Block_Size;
     }
-    for (t = 16; t < 64; t++)
+}
+
+#ifdef SHA256_USE_SHANI
+
+/*
+* SHA224_256ProcessBlocksShaNi
+*
+* Description:
+*   Same as SHA224_256ProcessBlocksPortable, using the x86 SHA
+*   extensions. The instructions keep the hash as ABEF and CDGH
+*   and do 2 rounds per sha256rnds2.
+*/
+/* 4 rounds with the message words in w, t is the index of the group of 4 rounds */
+#define SHA256_SHANI_ROUNDS(w, t)                                                         \
+    message = _mm_add_epi32((w), _mm_loadu_si128((const __m128i*)&SHA256_K[4 * (t)]));   \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, message);                              \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0E))
+
+/* W[t] = sigma1(W[t-2]) + W[t-7] + sigma0(W[t-15]) + W[t-16], 4 words at a time, w0 holds the oldest words */
+#define SHA256_SHANI_SCHEDULE(w0, w1, w2, w3) \
+    w0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32((w0), (w1)), _mm_alignr_epi8((w3), (w2), 4)), (w3))
+
+SHA256_TARGET
+static void SHA224_256ProcessBlocksShaNi(uint32_t *Intermediate_Hash, const uint8_t *message_array, size_t blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0;
+    __m128i state1;
+    __m128i temp;
+
+    temp = _mm_loadu_si128((const __m128i*)&Intermediate_Hash[0]);
+    state1 = _mm_loadu_si128((const __m128i*)&Intermediate_Hash[4]);
+    temp = _mm_shuffle_epi32(temp, 0xB1);             /* CDAB */
+    state1 = _mm_shuffle_epi32(state1, 0x1B);         /* EFGH */
+    state0 = _mm_alignr_epi8(temp, state1, 8);        /* ABEF */
+    state1 = _mm_blend_epi16(state1, temp, 0xF0);     /* CDGH */
+
+    while (blocks-- > 0)
     {
-        W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
-            SHA256_sigma0(W[t - 15]) + W[t - 16];
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i message;
+        __m128i W0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(message_array + 0)), byteSwap);
+        __m128i W1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(message_array + 16)), byteSwap);
+        __m128i W2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(message_array + 32)), byteSwap);
+        __m128i W3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(message_array + 48)), byteSwap);
+        int t;
+
+        SHA256_SHANI_ROUNDS(W0, 0);
+        SHA256_SHANI_ROUNDS(W1, 1);
+        SHA256_SHANI_ROUNDS(W2, 2);
+        SHA256_SHANI_ROUNDS(W3, 3);
+        for (t = 4; t < 16; t += 4)
+        {
+            SHA256_SHANI_SCHEDULE(W0, W1, W2, W3);
+            SHA256_SHANI_ROUNDS(W0, t);
+            SHA256_SHANI_SCHEDULE(W1, W2, W3, W0);
+            SHA256_SHANI_ROUNDS(W1, t + 1);
+            SHA256_SHANI_SCHEDULE(W2, W3, W0, W1);
+            SHA256_SHANI_ROUNDS(W2, t + 2);
+            SHA256_SHANI_SCHEDULE(W3, W0, W1, W2);
+            SHA256_SHANI_ROUNDS(W3, t + 3);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        message_array += SHA256_Message_Block_Size;
     }
-    A = context->Intermediate_Hash[0];
-    B = context->Intermediate_Hash[1];
-    C = context->Intermediate_Hash[2];
-    D = context->Intermediate_Hash[3];
-    E = context->Intermediate_Hash[4];
-    F = context->Intermediate_Hash[5];
-    G = context->Intermediate_Hash[6];
-    H = context->Intermediate_Hash[7];
-
-    for (t = 0; t < 64; t++)
+
+    temp = _mm_shuffle_epi32(state0, 0x1B);           /* FEBA */
+    state1 = _mm_shuffle_epi32(state1, 0xB1);         /* DCHG */
+    state0 = _mm_blend_epi16(temp, state1, 0xF0);     /* DCBA */
+    state1 = _mm_alignr_epi8(state1, temp, 8);        /* HGFE */
+    _mm_storeu_si128((__m128i*)&Intermediate_Hash[0], state0);
+    _mm_storeu_si128((__m128i*)&Intermediate_Hash[4], state1);
+}
+
+/*
+* SHA224_256HasShaNi
+*
+* Description:
+*   Checks CPUID for the SHA extensions and the SSSE3/SSE4.1
+*   instructions used next to them.
+*/
+static int SHA224_256HasShaNi(void)
+{
+    int result;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        int hasSse41;
+        __cpuid(info, 1);
+        hasSse41 = ((info[2] & (1 << 9)) != 0) && ((info[2] & (1 << 19)) != 0);
+        __cpuidex(info, 7, 0);
+        result = hasSse41 && ((info[1] & (1 << 29)) != 0);
+    }
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        result = 0;
+    }
+    else
     {
-        temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
-        temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
-        H = G;
-        G = F;
-        F = E;
-        E = D + temp1;
-        D = C;
-        C = B;
-        B = A;
-        A = temp1 + temp2;
+        int hasSse41;
+        __cpuid(1, eax, ebx, ecx, edx);
+        hasSse41 = ((ecx & (1 << 9)) != 0) && ((ecx & (1 << 19)) != 0);
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        result = hasSse41 && ((ebx & (1 << 29)) != 0);
     }
+#endif
+    return result;
+}
 
-    context->Intermediate_Hash[0] += A;
-    context->Intermediate_Hash[1] += B;
-    context->Intermediate_Hash[2] += C;
-    context->Intermediate_Hash[3] += D;
-    context->Intermediate_Hash[4] += E;
-    context->Intermediate_Hash[5] += F;
-    context->Intermediate_Hash[6] += G;
-    context->Intermediate_Hash[7] += H;
+#endif /* SHA256_USE_SHANI */
 
-    context->Message_Block_Index = 0;
+#ifdef SHA256_USE_ARMV8
+
+/*
+* SHA224_256ProcessBlocksArmv8
+*
+* Description:
+*   Same as SHA224_256ProcessBlocksPortable, using the ARMv8
+*   cryptography extensions. sha256h/sha256h2 do 4 rounds each.
+*/
+/* 4 rounds with the message words in w, t is the index of the group of 4 rounds */
+#define SHA256_ARMV8_ROUNDS(w, t)                                 \
+    message = vaddq_u32((w), vld1q_u32(&SHA256_K[4 * (t)]));      \
+    abcd = state0;                                                \
+    state0 = vsha256hq_u32(state0, state1, message);              \
+    state1 = vsha256h2q_u32(state1, abcd, message)
+
+/* replaces the oldest words w0 with the words 16 positions later */
+#define SHA256_ARMV8_SCHEDULE(w0, w1, w2, w3) \
+    w0 = vsha256su1q_u32(vsha256su0q_u32((w0), (w1)), (w2), (w3))
+
+static void SHA224_256ProcessBlocksArmv8(uint32_t *Intermediate_Hash, const uint8_t *message_array, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&Intermediate_Hash[0]);
+    uint32x4_t state1 = vld1q_u32(&Intermediate_Hash[4]);
+
+    while (blocks-- > 0)
+    {
+        uint32x4_t abcdSave = state0;
+        uint32x4_t efghSave = state1;
+        uint32x4_t message;
+        uint32x4_t abcd;
+        uint32x4_t W0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(message_array + 0)));
+        uint32x4_t W1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(message_array + 16)));
+        uint32x4_t W2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(message_array + 32)));
+        uint32x4_t W3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(message_array + 48)));
+        int t;
+
+        for (t = 0; t < 12; t += 4)
+        {
+            SHA256_ARMV8_ROUNDS(W0, t);
+            SHA256_ARMV8_SCHEDULE(W0, W1, W2, W3);
+            SHA256_ARMV8_ROUNDS(W1, t + 1);
+            SHA256_ARMV8_SCHEDULE(W1, W2, W3, W0);
+            SHA256_ARMV8_ROUNDS(W2, t + 2);
+            SHA256_ARMV8_SCHEDULE(W2, W3, W0, W1);
+            SHA256_ARMV8_ROUNDS(W3, t + 3);
+            SHA256_ARMV8_SCHEDULE(W3, W0, W1, W2);
+        }
+        SHA256_ARMV8_ROUNDS(W0, 12);
+        SHA256_ARMV8_ROUNDS(W1, 13);
+        SHA256_ARMV8_ROUNDS(W2, 14);
+        SHA256_ARMV8_ROUNDS(W3, 15);
+
+        state0 = vaddq_u32(state0, abcdSave);
+        state1 = vaddq_u32(state1, efghSave);
+        message_array += SHA256_Message_Block_Size;
+    }
+
+    vst1q_u32(&Intermediate_Hash[0], state0);
+    vst1q_u32(&Intermediate_Hash[4], state1);
+}
+
+#endif /* SHA256_USE_ARMV8 */
+
+/*
+* SHA224_256ProcessBlocks
+*
+* Description:
+*   Processes consecutive 512 bit blocks with the fastest block
+*   function the processor supports.
+*
+* Parameters:
+*   Intermediate_Hash: [in/out]
+*     The 8 words of the hash to update
+*   message_array: [in]
+*     The blocks to process
+*   blocks: [in]
+*     The number of blocks in message_array
+*
+* Returns:
+*   Nothing.
+*/
+static void SHA224_256ProcessBlocks(uint32_t *Intermediate_Hash, const uint8_t *message_array, size_t blocks)
+{
+#if defined(SHA256_USE_SHANI)
+    /* several threads may race to fill this in, they all compute the same value */
+    static volatile int hasShaNi = -1;
+    int useShaNi = hasShaNi;
+    if (useShaNi < 0)
+    {
+        useShaNi = SHA224_256HasShaNi();
+        hasShaNi = useShaNi;
+    }
+
+    if (useShaNi)
+    {
+        SHA224_256ProcessBlocksShaNi(Intermediate_Hash, message_array, blocks);
+    }
+    else
+    {
+        SHA224_256ProcessBlocksPortable(Intermediate_Hash, message_array, blocks);
+    }
+#elif defined(SHA256_USE_ARMV8)
+    SHA224_256ProcessBlocksArmv8(Intermediate_Hash, message_array, blocks);
+#else
+    SHA224_256ProcessBlocksPortable(Intermediate_Hash, message_array, blocks);
+#endif
 }
 
 /*
@@ -21,30 +21,141 @@
 
 static const char hexToASCII[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
 
+/*strings of up to this many bytes (terminator included) are kept in the same allocation as the handle*/
+#define STRING_INLINE_CAPACITY 32
+
 typedef struct STRING_TAG
 {
     char* s;
+    /*length of s, terminator not included*/
+    size_t length;
+    /*bytes available at s, terminator included*/
+    size_t capacity;
+    char inline_buffer[];
 } STRING;
 
-/*this function will allocate a new string with just '\0' in it*/
-/*return NULL if it fails*/
-/* Codes_SRS_STRING_07_001: [STRING_new shall allocate a new STRING_HANDLE pointing to an empty string.] */
-STRING_HANDLE STRING_new(void)
+/*allocates a handle with room for size bytes (terminator included) holding an empty string*/
+static STRING* allocate_string(size_t size)
 {
     STRING* result;
-    if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+    if (size <= STRING_INLINE_CAPACITY)
     {
-        if ((result->s = (char*)malloc(1)) != NULL)
+        result = (STRING*)malloc(sizeof(STRING) + STRING_INLINE_CAPACITY);
+        if (result != NULL)
+        {
+            result->s = result->inline_buffer;
+            result->capacity = STRING_INLINE_CAPACITY;
+        }
+    }
+    else
+    {
+        result = (STRING*)malloc(sizeof(STRING));
+        if (result != NULL)
         {
-            result->s[0] = '\0';
+            if ((result->s = (char*)malloc(size)) == NULL)
+            {
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->capacity = size;
+            }
+        }
+    }
+
+    if (result != NULL)
+    {
+        result->s[0] = '\0';
+        result->length = 0;
+    }
+    return result;
+}
+
+/*makes sure that str can hold size bytes (terminator included). Capacity grows geometrically so that a chain of concatenations is amortized linear*/
+static int ensure_capacity(STRING* str, size_t size)
+{
+    int result;
+    if (size <= str->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (str->capacity > ((size_t)~(size_t)0) / 2) ? size : (2 * str->capacity);
+        char* temp;
+        if (newCapacity < size)
+        {
+            newCapacity = size;
+        }
+
+        if (str->s == str->inline_buffer)
+        {
+            /*the inline buffer cannot grow, the string moves to its own allocation*/
+            temp = (char*)malloc(newCapacity);
+            if (temp != NULL)
+            {
+                (void)memcpy(temp, str->s, str->length + 1);
+            }
         }
         else
         {
-            /* Codes_SRS_STRING_07_002: [STRING_new shall return an NULL STRING_HANDLE on any error that is encountered.] */
-            LogError("Failure allocating in STRING_new.");
-            free(result);
-            result = NULL;
+            temp = (char*)realloc(str->s, newCapacity);
+        }
+
+        if (temp == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            str->s = temp;
+            str->capacity = newCapacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int append(STRING* str, const char* source, size_t sourceLength)
+{
+    int result;
+    if (sourceLength >= ((size_t)~(size_t)0) - str->length)
+    {
+        LogError("String would be too long.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*source may point into the string itself, which can move when growing*/
+        int isSelf = (source >= str->s) && (source < str->s + str->capacity);
+        size_t sourceOffset = isSelf ? (size_t)(source - str->s) : 0;
+        if (ensure_capacity(str, str->length + sourceLength + 1) != 0)
+        {
+            LogError("Failure reallocating value.");
+            result = __FAILURE__;
         }
+        else
+        {
+            (void)memmove(str->s + str->length, isSelf ? (str->s + sourceOffset) : source, sourceLength);
+            str->length += sourceLength;
+            str->s[str->length] = '\0';
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*this function will allocate a new string with just '\0' in it*/
+/*return NULL if it fails*/
+/* Codes_SRS_STRING_07_001: [STRING_new shall allocate a new STRING_HANDLE pointing to an empty string.] */
+STRING_HANDLE STRING_new(void)
+{
+    STRING* result;
+    if ((result = allocate_string(1)) == NULL)
+    {
+        /* Codes_SRS_STRING_07_002: [STRING_new shall return an NULL STRING_HANDLE on any error that is encountered.] */
+        LogError("Failure allocating in STRING_new.");
     }
     return (STRING_HANDLE)result;
 }
@@ -60,26 +171,16 @@ STRING_HANDLE STRING_clone(STRING_HANDLE handle)
     }
     else
     {
+        STRING* source = (STRING*)handle;
         /*Codes_SRS_STRING_02_003: [If STRING_clone fails for any reason, it shall return NULL.] */
-        if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+        if ((result = allocate_string(source->length + 1)) == NULL)
         {
-            STRING* source = (STRING*)handle;
-            /*Codes_SRS_STRING_02_003: [If STRING_clone fails for any reason, it shall return NULL.] */
-            size_t sourceLen = strlen(source->s);
-            if ((result->s = (char*)malloc(sourceLen + 1)) == NULL)
-            {
-                LogError("Failure allocating clone value.");
-                free(result);
-                result = NULL;
-            }
-            else
-            {
-                (void)memcpy(result->s, source->s, sourceLen + 1);
-            }
+            LogError("Failure allocating clone value.");
         }
         else
         {
-            /*not much to do, result is NULL from malloc*/
+            (void)memcpy(result->s, source->s, source->length + 1);
+            result->length = source->length;
         }
     }
     return (STRING_HANDLE)result;
@@ -96,22 +197,13 @@ STRING_HANDLE STRING_construct(const char* psz)
     }
     else
     {
+        size_t nLen = strlen(psz);
         STRING* str;
-        if ((str = (STRING*)malloc(sizeof(STRING))) != NULL)
+        if ((str = allocate_string(nLen + 1)) != NULL)
         {
-            size_t nLen = strlen(psz) + 1;
-            if ((str->s = (char*)malloc(nLen)) != NULL)
-            {
-                (void)memcpy(str->s, psz, nLen);
-                result = (STRING_HANDLE)str;
-            }
-            /* Codes_SRS_STRING_07_032: [STRING_construct encounters any error it shall return a NULL value.] */
-            else
-            {
-                LogError("Failure allocating constructed value.");
-                free(str);
-                result = NULL;
-            }
+            (void)memcpy(str->s, psz, nLen + 1);
+            str->length = nLen;
+            result = (STRING_HANDLE)str;
         }
         else
         {
@@ -149,33 +241,26 @@ STRING_HANDLE STRING_construct_sprintf(const char* format, ...)
         va_end(arg_list);
         if (length > 0)
         {
-            result = (STRING*)malloc(sizeof(STRING));
+            result = allocate_string((size_t)length + 1);
             if (result != NULL)
             {
-                result->s = (char*)malloc(length+1);
-                if (result->s != NULL)
+                va_start(arg_list, format);
+                if (vsnprintf(result->s, length+1, format, arg_list) < 0)
                 {
-                    va_start(arg_list, format);
-                    if (vsnprintf(result->s, length+1, format, arg_list) < 0)
-                    {
-                        /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
-                        free(result->s);
-                        free(result);
-                        result = NULL;
-                        LogError("Failure: vsnprintf formatting failed.");
-                    }
-                    va_end(arg_list);
+                    /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
+                    STRING_delete((STRING_HANDLE)result);
+                    result = NULL;
+                    LogError("Failure: vsnprintf formatting failed.");
                 }
                 else
                 {
-                    /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
-                    free(result);
-                    result = NULL;
-                    LogError("Failure: allocation sprintf value failed.");
+                    result->length = (size_t)length;
                 }
+                va_end(arg_list);
             }
             else
             {
+                /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
                 LogError("Failure: allocation failed.");
             }
         }
@@ -216,6 +301,8 @@ STRING_HANDLE STRING_new_with_memory(const char* memory)
         if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
         {
             result->s = (char*)memory;
+            result->length = strlen(memory);
+            result->capacity = result->length + 1;
         }
         else
         {
@@ -234,22 +321,21 @@ STRING_HANDLE STRING_new_quoted(const char* source)
         /* Codes_SRS_STRING_07_009: [STRING_new_quoted shall return a NULL STRING_HANDLE if the supplied const char* is NULL.] */
         result = NULL;
     }
-    else if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+    else
     {
         size_t sourceLength = strlen(source);
-        if ((result->s = (char*)malloc(sourceLength + 3)) != NULL)
+        if ((result = allocate_string(sourceLength + 3)) != NULL)
         {
             result->s[0] = '"';
             (void)memcpy(result->s + 1, source, sourceLength);
             result->s[sourceLength + 1] = '"';
             result->s[sourceLength + 2] = '\0';
+            result->length = sourceLength + 2;
         }
         else
         {
             /* Codes_SRS_STRING_07_031: [STRING_new_quoted shall return a NULL STRING_HANDLE if any error is encountered.] */
             LogError("Failure allocating quoted string value.");
-            free(result);
-            result = NULL;
         }
     }
     return (STRING_HANDLE)result;
@@ -305,18 +391,11 @@ STRING_HANDLE STRING_new_JSON(const char* source)
         }
         else
         {
-            if ((result = (STRING*)malloc(sizeof(STRING))) == NULL)
+            if ((result = allocate_string(vlen + 5 * nControlCharacters + nEscapeCharacters + 3)) == NULL)
             {
                 /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
                 LogError("malloc json failure");
             }
-            else if ((result->s = (char*)malloc(vlen + 5 * nControlCharacters + nEscapeCharacters + 3)) == NULL)
-            {
-                /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
-                free(result);
-                result = NULL;
-                LogError("malloc failed");
-            }
             else
             {
                 size_t pos = 0;
@@ -362,6 +441,7 @@ STRING_HANDLE STRING_new_JSON(const char* source)
                 result->s[pos++] = '"';
                 /*zero terminating it*/
                 result->s[pos] = '\0';
+                result->length = pos;
             }
         }
 
@@ -381,24 +461,14 @@ int STRING_concat(STRING_HANDLE handle, const char* s2)
         /* Codes_SRS_STRING_07_013: [STRING_concat shall return a nonzero number if an error is encountered.] */
         result = __FAILURE__;
     }
+    else if (append((STRING*)handle, s2, strlen(s2)) != 0)
+    {
+        /* Codes_SRS_STRING_07_013: [STRING_concat shall return a nonzero number if an error is encountered.] */
+        result = __FAILURE__;
+    }
     else
     {
-        STRING* s1 = (STRING*)handle;
-        size_t s1Length = strlen(s1->s);
-        size_t s2Length = strlen(s2);
-        char* temp = (char*)realloc(s1->s, s1Length + s2Length + 1);
-        if (temp == NULL)
-        {
-            /* Codes_SRS_STRING_07_013: [STRING_concat shall return a nonzero number if an error is encountered.] */
-            LogError("Failure reallocating value.");
-            result = __FAILURE__;
-        }
-        else
-        {
-            s1->s = temp;
-            (void)memcpy(s1->s + s1Length, s2, s2Length + 1);
-            result = 0;
-        }
+        result = 0;
     }
     return result;
 }
@@ -421,20 +491,14 @@ int STRING_concat_with_STRING(STRING_HANDLE s1, STRING_HANDLE s2)
         STRING* dest = (STRING*)s1;
         STRING* src = (STRING*)s2;
 
-        size_t s1Length = strlen(dest->s);
-        size_t s2Length = strlen(src->s);
-        char* temp = (char*)realloc(dest->s, s1Length + s2Length + 1);
-        if (temp == NULL)
+        /* Codes_SRS_STRING_07_034: [String_Concat_with_STRING shall concatenate a given STRING_HANDLE variable with a source STRING_HANDLE.] */
+        if (append(dest, src->s, src->length) != 0)
         {
             /* Codes_SRS_STRING_07_035: [String_Concat_with_STRING shall return a nonzero number if an error is encountered.] */
-            LogError("Failure reallocating value");
             result = __FAILURE__;
         }
         else
         {
-            dest->s = temp;
-            /* Codes_SRS_STRING_07_034: [String_Concat_with_STRING shall concatenate a given STRING_HANDLE variable with a source STRING_HANDLE.] */
-            (void)memcpy(dest->s + s1Length, src->s, s2Length + 1);
             result = 0;
         }
     }
@@ -460,8 +524,7 @@ int STRING_copy(STRING_HANDLE handle, const char* s2)
         if (s1->s != s2)
         {
             size_t s2Length = strlen(s2);
-            char* temp = (char*)realloc(s1->s, s2Length + 1);
-            if (temp == NULL)
+            if (ensure_capacity(s1, s2Length + 1) != 0)
             {
                 LogError("Failure reallocating value.");
                 /* Codes_SRS_STRING_07_027: [STRING_copy shall return a nonzero value if any error is encountered.] */
@@ -469,8 +532,8 @@ int STRING_copy(STRING_HANDLE handle, const char* s2)
             }
             else
             {
-                s1->s = temp;
                 memmove(s1->s, s2, s2Length + 1);
+                s1->length = s2Length;
                 result = 0;
             }
         }
@@ -499,14 +562,12 @@ int STRING_copy_n(STRING_HANDLE handle, const char* s2, size_t n)
     {
         STRING* s1 = (STRING*)handle;
         size_t s2Length = strlen(s2);
-        char* temp;
         if (s2Length > n)
         {
             s2Length = n;
         }
 
-        temp = (char*)realloc(s1->s, s2Length + 1);
-        if (temp == NULL)
+        if (ensure_capacity(s1, s2Length + 1) != 0)
         {
             LogError("Failure reallocating value.");
             /* Codes_SRS_STRING_07_028: [STRING_copy_n shall return a nonzero value if any error is encountered.] */
@@ -514,9 +575,9 @@ int STRING_copy_n(STRING_HANDLE handle, const char* s2, size_t n)
         }
         else
         {
-            s1->s = temp;
-            (void)memcpy(s1->s, s2, s2Length);
+            (void)memmove(s1->s, s2, s2Length);
             s1->s[s2Length] = 0;
+            s1->length = s2Length;
             result = 0;
         }
 
@@ -567,14 +628,11 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
         else
         {
             STRING* s1 = (STRING*)handle;
-            char* temp;
-            size_t s1Length = strlen(s1->s);
-            temp = (char*)realloc(s1->s, s1Length + s2Length + 1);
-            if (temp != NULL)
+            size_t s1Length = s1->length;
+            if (ensure_capacity(s1, s1Length + s2Length + 1) == 0)
             {
-                s1->s = temp;
                 va_start(arg_list, format);
-                if (vsnprintf(s1->s + s1Length, s1Length + s2Length + 1, format, arg_list) < 0)
+                if (vsnprintf(s1->s + s1Length, s2Length + 1, format, arg_list) < 0)
                 {
                     /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
                     LogError("Failure vsnprintf formatting error");
@@ -584,6 +642,7 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
                 else
                 {
                     /* Codes_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.]*/
+                    s1->length = s1Length + s2Length;
                     result = 0;
                 }
                 va_end(arg_list);
@@ -614,9 +673,8 @@ int STRING_quote(STRING_HANDLE handle)
     else
     {
         STRING* s1 = (STRING*)handle;
-        size_t s1Length = strlen(s1->s);
-        char* temp = (char*)realloc(s1->s, s1Length + 2 + 1);/*2 because 2 quotes, 1 because '\0'*/
-        if (temp == NULL)
+        size_t s1Length = s1->length;
+        if (ensure_capacity(s1, s1Length + 2 + 1) != 0) /*2 because 2 quotes, 1 because '\0'*/
         {
             LogError("Failure reallocating value.");
             /* Codes_SRS_STRING_07_029: [STRING_quote shall return a nonzero value if any error is encountered.] */
@@ -624,11 +682,11 @@ int STRING_quote(STRING_HANDLE handle)
         }
         else
         {
-            s1->s = temp;
             memmove(s1->s + 1, s1->s, s1Length);
             s1->s[0] = '"';
             s1->s[s1Length + 1] = '"';
             s1->s[s1Length + 2] = '\0';
+            s1->length = s1Length + 2;
             result = 0;
         }
     }
@@ -647,20 +705,11 @@ int STRING_empty(STRING_HANDLE handle)
     }
     else
     {
+        /*the capacity is kept, the string is likely to be filled again*/
         STRING* s1 = (STRING*)handle;
-        char* temp = (char*)realloc(s1->s, 1);
-        if (temp == NULL)
-        {
-            LogError("Failure reallocating value.");
-            /* Codes_SRS_STRING_07_030: [STRING_empty shall return a nonzero value if the STRING_HANDLE is NULL.] */
-            result = __FAILURE__;
-        }
-        else
-        {
-            s1->s = temp;
-            s1->s[0] = '\0';
-            result = 0;
-        }
+        s1->s[0] = '\0';
+        s1->length = 0;
+        result = 0;
     }
     return result;
 }
@@ -673,7 +722,10 @@ void STRING_delete(STRING_HANDLE handle)
     if (handle != NULL)
     {
         STRING* value = (STRING*)handle;
-        free(value->s);
+        if (value->s != value->inline_buffer)
+        {
+            free(value->s);
+        }
         value->s = NULL;
         free(value);
     }
@@ -703,7 +755,7 @@ size_t STRING_length(STRING_HANDLE handle)
     if (handle != NULL)
     {
         STRING* value = (STRING*)handle;
-        result = strlen(value->s);
+        result = value->length;
     }
     return result;
 }
@@ -730,25 +782,17 @@ STRING_HANDLE STRING_construct_n(const char* psz, size_t n)
         else
         {
             STRING* str;
-            if ((str = (STRING*)malloc(sizeof(STRING))) != NULL)
+            if ((str = allocate_string(n + 1)) != NULL)
             {
-                if ((str->s = (char*)malloc(len + 1)) != NULL)
-                {
-                    (void)memcpy(str->s, psz, n);
-                    str->s[n] = '\0';
-                    result = (STRING_HANDLE)str;
-                }
-                /* Codes_SRS_STRING_02_010: [In all other error cases, STRING_construct_n shall return NULL.]  */
-                else
-                {
-                    LogError("Failure allocating value.");
-                    free(str);
-                    result = NULL;
-                }
+                (void)memcpy(str->s, psz, n);
+                str->s[n] = '\0';
+                str->length = n;
+                result = (STRING_HANDLE)str;
             }
             else
             {
                 /* Codes_SRS_STRING_02_010: [In all other error cases, STRING_construct_n shall return NULL.]  */
+                LogError("Failure allocating value.");
                 result = NULL;
             }
         }
@@ -797,7 +841,7 @@ STRING_HANDLE STRING_from_byte_array(const unsigned char* source, size_t size)
     else
     {
         /*Codes_SRS_STRING_02_023: [ Otherwise, STRING_from_BUFFER shall build a string that has the same content (byte-by-byte) as source and return a non-NULL handle. ]*/
-        result = (STRING*)malloc(sizeof(STRING));
+        result = allocate_string(size + 1);
         if (result == NULL)
         {
             /*Codes_SRS_STRING_02_024: [ If building the string fails, then STRING_from_BUFFER shall fail and return NULL. ]*/
@@ -806,20 +850,13 @@ STRING_HANDLE STRING_from_byte_array(const unsigned char* source, size_t size)
         }
         else
         {
-            /*Codes_SRS_STRING_02_023: [ Otherwise, STRING_from_BUFFER shall build a string that has the same content (byte-by-byte) as source and return a non-NULL handle. ]*/
-            result->s = (char*)malloc(size + 1);
-            if (result->s == NULL)
-            {
-                /*Codes_SRS_STRING_02_024: [ If building the string fails, then STRING_from_BUFFER shall fail and return NULL. ]*/
-                LogError("oom - unable to malloc");
-                free(result);
-                result = NULL;
-            }
-            else
+            if (size > 0)
             {
                 (void)memcpy(result->s, source, size);
-                result->s[size] = '\0'; /*all is fine*/
             }
+            result->s[size] = '\0'; /*all is fine*/
+            /*the content may have embedded zeroes, the string ends at the first one*/
+            result->length = strlen(result->s);
         }
     }
     return (STRING_HANDLE)result;
@@ -844,12 +881,18 @@ int STRING_replace(STRING_HANDLE handle, char target, char replace)
         size_t index;
         /* Codes_SRS_STRING_07_047: [ STRING_replace shall replace all instances of target with replace. ] */
         STRING* str_value = (STRING*)handle;
-        length = strlen(str_value->s);
+        length = str_value->length;
         for (index = 0; index < length; index++)
         {
             if (str_value->s[index] == target)
             {
                 str_value->s[index] = replace;
+                if (replace == '\0')
+                {
+                    /* Codes_SRS_STRING_07_050: [ If replace is '\0', the string shall end at the first replaced character. ] */
+                    str_value->length = index;
+                    break;
+                }
             }
         }
         /* Codes_SRS_STRING_07_049: [ On success STRING_replace shall return zero. ] */
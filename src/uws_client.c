@@ -24,6 +24,8 @@
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/uws_permessage_deflate.h"
 
 static const char* UWS_CLIENT_OPTIONS = "uWSClientOptions";
 
@@ -31,6 +33,9 @@ static const char* HTTP_HEADER_KEY_VALUE_SEPARATOR = ": ";
 static const size_t HTTP_HEADER_KEY_VALUE_SEPARATOR_LENGTH = 2;
 static const char* HTTP_HEADER_TERMINATOR = "\r\n";
 static const size_t HTTP_HEADER_TERMINATOR_LENGTH = 2;
+#ifdef USE_PERMESSAGE_DEFLATE
+static const char* SEC_WEBSOCKET_EXTENSIONS_HEADER = "Sec-WebSocket-Extensions";
+#endif
 
 /* Requirements not needed as they are optional:
 Codes_SRS_UWS_CLIENT_01_254: [ If an endpoint receives a Ping frame and has not yet sent Pong frame(s) in response to previous Ping frame(s), the endpoint MAY elect to send a Pong frame for only the most recently processed Ping frame. ]
@@ -71,6 +76,8 @@ typedef struct WS_PENDING_SEND_TAG
     ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete;
     void* context;
     UWS_CLIENT_HANDLE uws_client;
+    /* header and masked payload (which follows this structure) are referenced by the underlying IO until it completes the send */
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
 } WS_PENDING_SEND;
 
 typedef struct UWS_CLIENT_INSTANCE_TAG
@@ -88,6 +95,8 @@ typedef struct UWS_CLIENT_INSTANCE_TAG
     void* on_ws_open_complete_context;
     ON_WS_FRAME_RECEIVED on_ws_frame_received;
     void* on_ws_frame_received_context;
+    ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received;
+    void* on_ws_fragment_received_context;
     ON_WS_PEER_CLOSED on_ws_peer_closed;
     void* on_ws_peer_closed_context;
     ON_WS_ERROR on_ws_error;
@@ -95,10 +104,25 @@ typedef struct UWS_CLIENT_INSTANCE_TAG
     ON_WS_CLOSE_COMPLETE on_ws_close_complete;
     void* on_ws_close_complete_context;
     unsigned char* stream_buffer;
+    size_t stream_buffer_offset;
     size_t stream_buffer_count;
+    size_t stream_buffer_size;
+    const unsigned char* received_bytes;
+    size_t received_bytes_count;
     unsigned char* fragment_buffer;
     size_t fragment_buffer_count;
     unsigned char fragmented_frame_type;
+    bool is_streaming_frame_payload;
+    unsigned char streamed_frame_opcode;
+    unsigned char streamed_frame_type;
+    bool streamed_frame_is_compressed;
+    bool streamed_frame_is_final;
+    size_t streamed_frame_remaining;
+    uint64_t streamed_message_offset;
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate;
+    UWS_PERMESSAGE_DEFLATE_CONFIG permessage_deflate_config;
+    bool is_sending_compressed_message;
+    bool is_receiving_compressed_message;
 } UWS_CLIENT_INSTANCE;
 
 /* Codes_SRS_UWS_CLIENT_01_360: [ Connection confidentiality and integrity is provided by running the WebSocket Protocol over TLS (wss URIs). ]*/
@@ -523,6 +547,34 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
     return result;
 }
 
+static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, LIST_ITEM_HANDLE pending_send_frame_item, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    int result;
+    UWS_CLIENT_INSTANCE* uws_client = ws_pending_send->uws_client;
+
+    /* Codes_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling `singlylinkedlist_remove`. ]*/
+    if (singlylinkedlist_remove(uws_client->pending_sends, pending_send_frame_item) != 0)
+    {
+        LogError("Failed removing item from list");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (ws_pending_send->on_ws_send_frame_complete != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the `on_ws_send_frame_complete` callback shall be the context given to `uws_client_send_frame_async`. ]*/
+            ws_pending_send->on_ws_send_frame_complete(ws_pending_send->context, ws_send_frame_result);
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
+        free(ws_pending_send);
+
+        result = 0;
+    }
+
+    return result;
+}
+
 void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
 {
     /* Codes_SRS_UWS_CLIENT_01_020: [ If `uws_client` is NULL, `uws_client_destroy` shall do nothing. ]*/
@@ -568,8 +620,29 @@ void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
             uws_client->underlying_io = NULL;
         }
 
+        /* Codes_SRS_UWS_CLIENT_01_579: [ After destroying the underlying IO, `uws_client_destroy` shall free the pending send frames that the underlying IO did not complete. ]*/
+        {
+            LIST_ITEM_HANDLE first_pending_send;
+
+            while ((first_pending_send = singlylinkedlist_get_head_item(uws_client->pending_sends)) != NULL)
+            {
+                WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
+
+                complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
+            }
+        }
+
         /* Codes_SRS_UWS_CLIENT_01_024: [ `uws_client_destroy` shall free the list used to track the pending sends by calling `singlylinkedlist_destroy`. ]*/
         singlylinkedlist_destroy(uws_client->pending_sends);
+
+#ifdef USE_PERMESSAGE_DEFLATE
+        /* Codes_SRS_UWS_CLIENT_01_564: [ `uws_client_destroy` shall destroy the permessage-deflate instance, if any, by calling `uws_permessage_deflate_destroy`. ]*/
+        if (uws_client->permessage_deflate != NULL)
+        {
+            uws_permessage_deflate_destroy(uws_client->permessage_deflate);
+        }
+#endif
+
         free(uws_client->resource_name);
         free(uws_client->hostname);
         Map_Destroy(uws_client->request_headers);
@@ -865,14 +938,78 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
     }
 }
 
-static void consume_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t consumed_bytes)
+static int append_to_stream_buffer(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t size)
 {
-    if (consumed_bytes < uws_client->stream_buffer_count)
+    int result;
+
+    /* One extra byte is always kept so that the upgrade response can be zero terminated */
+    if (uws_client->stream_buffer_offset + uws_client->stream_buffer_count + size + 1 > uws_client->stream_buffer_size)
     {
-        (void)memmove(uws_client->stream_buffer, uws_client->stream_buffer + consumed_bytes, uws_client->stream_buffer_count - consumed_bytes);
+        /* Reclaim the already consumed bytes at the front before growing */
+        if ((uws_client->stream_buffer_offset > 0) &&
+            (uws_client->stream_buffer_count > 0))
+        {
+            (void)memmove(uws_client->stream_buffer, uws_client->stream_buffer + uws_client->stream_buffer_offset, uws_client->stream_buffer_count);
+        }
+
+        uws_client->stream_buffer_offset = 0;
     }
 
-    uws_client->stream_buffer_count -= consumed_bytes;
+    if (uws_client->stream_buffer_count + size + 1 > uws_client->stream_buffer_size)
+    {
+        /* Grow geometrically so that a large frame arriving in small chunks is not copied over and over */
+        size_t new_size = uws_client->stream_buffer_size * 2;
+        unsigned char* new_stream_buffer;
+
+        if (new_size < uws_client->stream_buffer_count + size + 1)
+        {
+            new_size = uws_client->stream_buffer_count + size + 1;
+        }
+
+        new_stream_buffer = (unsigned char*)realloc(uws_client->stream_buffer, new_size);
+        if (new_stream_buffer == NULL)
+        {
+            LogError("Cannot allocate memory for received data");
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->stream_buffer = new_stream_buffer;
+            uws_client->stream_buffer_size = new_size;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_offset + uws_client->stream_buffer_count, bytes, size);
+        uws_client->stream_buffer_count += size;
+    }
+
+    return result;
+}
+
+static void consume_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t consumed_bytes)
+{
+    if (uws_client->received_bytes != NULL)
+    {
+        /* Decoding straight out of the buffer handed over by the underlying IO */
+        uws_client->received_bytes += consumed_bytes;
+        uws_client->received_bytes_count -= consumed_bytes;
+    }
+    else
+    {
+        uws_client->stream_buffer_offset += consumed_bytes;
+        uws_client->stream_buffer_count -= consumed_bytes;
+        if (uws_client->stream_buffer_count == 0)
+        {
+            uws_client->stream_buffer_offset = 0;
+        }
+    }
 }
 
 static void on_underlying_io_close_complete(void* context)
@@ -1022,11 +1159,17 @@ static int ParseHttpResponse(const char* src, int* dst)
     return result;
 }
 
-static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, size_t length, size_t needed_bytes)
+static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, const unsigned char* payload, size_t length)
 {
     int result;
-    unsigned char *new_fragment_bytes = (unsigned char *)realloc(uws_client->fragment_buffer, uws_client->fragment_buffer_count + length);
-    if (new_fragment_bytes == NULL)
+    unsigned char *new_fragment_bytes;
+
+    if (uws_client->fragment_buffer_count + length == 0)
+    {
+        /* realloc to 0 bytes may free the buffer, an empty first fragment has nothing to accumulate */
+        result = 0;
+    }
+    else if ((new_fragment_bytes = (unsigned char *)realloc(uws_client->fragment_buffer, uws_client->fragment_buffer_count + length)) == NULL)
     {
         /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
         LogError("Cannot allocate memory for received data");
@@ -1036,7 +1179,7 @@ static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, size_t length
     else
     {
         uws_client->fragment_buffer = new_fragment_bytes;
-        (void)memcpy(uws_client->fragment_buffer + uws_client->fragment_buffer_count, uws_client->stream_buffer + needed_bytes - length, length);
+        (void)memcpy(uws_client->fragment_buffer + uws_client->fragment_buffer_count, payload, length);
         uws_client->fragment_buffer_count += length;
         result = 0;
     }
@@ -1044,6 +1187,310 @@ static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, size_t length
     return result;
 }
 
+#ifdef USE_PERMESSAGE_DEFLATE
+static const char* find_response_header_value(const char* response, const char* response_end, const char* header_name, size_t* value_length)
+{
+    const char* result = NULL;
+    size_t header_name_length = strlen(header_name);
+    const char* line = strstr(response, HTTP_HEADER_TERMINATOR);
+
+    /* the status line is skipped, header names are case insensitive */
+    while ((result == NULL) &&
+        (line != NULL) &&
+        (line < response_end))
+    {
+        const char* line_end;
+
+        line += HTTP_HEADER_TERMINATOR_LENGTH;
+        line_end = strstr(line, HTTP_HEADER_TERMINATOR);
+        if (line_end == NULL)
+        {
+            break;
+        }
+
+        if (((size_t)(line_end - line) > header_name_length) &&
+            (line[header_name_length] == ':'))
+        {
+            size_t i;
+
+            for (i = 0; i < header_name_length; i++)
+            {
+                if (tolower((unsigned char)line[i]) != tolower((unsigned char)header_name[i]))
+                {
+                    break;
+                }
+            }
+
+            if (i == header_name_length)
+            {
+                result = line + header_name_length + 1;
+                while ((*result == ' ') || (*result == '\t'))
+                {
+                    result++;
+                }
+
+                *value_length = (size_t)(line_end - result);
+            }
+        }
+
+        line = line_end;
+    }
+
+    return result;
+}
+#endif
+
+static int accept_upgrade_response_extensions(UWS_CLIENT_INSTANCE* uws_client, const char* response, const char* response_end)
+{
+    int result;
+
+#ifdef USE_PERMESSAGE_DEFLATE
+    if (uws_client->permessage_deflate == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t extensions_length = 0;
+        const char* extensions = find_response_header_value(response, response_end, SEC_WEBSOCKET_EXTENSIONS_HEADER, &extensions_length);
+
+        if (extensions == NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_547: [ If the upgrade response has no `Sec-WebSocket-Extensions` header, uws shall call `uws_permessage_deflate_reset` and exchange uncompressed messages. ]*/
+            uws_permessage_deflate_reset(uws_client->permessage_deflate);
+            result = 0;
+        }
+        else
+        {
+            char* extensions_value = (char*)malloc(extensions_length + 1);
+            if (extensions_value == NULL)
+            {
+                LogError("Cannot allocate memory for the Sec-WebSocket-Extensions header value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memcpy(extensions_value, extensions, extensions_length);
+                extensions_value[extensions_length] = '\0';
+
+                /* Codes_SRS_UWS_CLIENT_01_546: [ If permessage-deflate is configured, the value of the `Sec-WebSocket-Extensions` header of the upgrade response shall be passed to `uws_permessage_deflate_accept_response`. ]*/
+                if (uws_permessage_deflate_accept_response(uws_client->permessage_deflate, extensions_value) != 0)
+                {
+                    LogError("Server responded with unsupported extensions: %s", extensions_value);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+
+                free(extensions_value);
+            }
+        }
+    }
+#else
+    (void)uws_client;
+    (void)response;
+    (void)response_end;
+    result = 0;
+#endif
+
+    return result;
+}
+
+static int get_received_message_payload(UWS_CLIENT_INSTANCE* uws_client, unsigned char opcode, bool is_compressed, bool is_final, const unsigned char** payload, size_t* payload_length)
+{
+    int result;
+
+#ifdef USE_PERMESSAGE_DEFLATE
+    if (is_compressed &&
+        ((opcode == (unsigned char)WS_CONTINUATION_FRAME) || (uws_client->permessage_deflate == NULL) || !uws_permessage_deflate_is_negotiated(uws_client->permessage_deflate)))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_150: [ If a nonzero value is received and none of the negotiated extensions defines the meaning of such a nonzero value, the receiving endpoint MUST _Fail the WebSocket Connection_. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_549: [ If RSV1 is set on a continuation frame or while permessage-deflate is not negotiated, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+        LogError("Unexpected RSV1 bit on a frame with opcode %u", (unsigned int)opcode);
+        indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_550: [ RSV1 on the first frame of a message shall mark all the frames of the message as compressed. ]*/
+        if (opcode != (unsigned char)WS_CONTINUATION_FRAME)
+        {
+            uws_client->is_receiving_compressed_message = is_compressed;
+        }
+
+        if (!uws_client->is_receiving_compressed_message)
+        {
+            result = 0;
+        }
+        else
+        {
+            const unsigned char* decompressed_payload;
+            size_t decompressed_length;
+
+            /* Codes_SRS_UWS_CLIENT_01_551: [ The payload of each frame of a compressed message shall be decompressed by calling `uws_permessage_deflate_decompress` before being delivered or accumulated. ]*/
+            if (uws_permessage_deflate_decompress(uws_client->permessage_deflate, *payload, *payload_length, is_final, &decompressed_payload, &decompressed_length) != 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_552: [ If `uws_permessage_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+                LogError("Cannot decompress the received frame");
+                indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (is_final)
+                {
+                    uws_client->is_receiving_compressed_message = false;
+                }
+
+                *payload = decompressed_payload;
+                *payload_length = decompressed_length;
+                result = 0;
+            }
+        }
+    }
+#else
+    /* without permessage-deflate support the reserved bits are not interpreted */
+    (void)uws_client;
+    (void)opcode;
+    (void)is_compressed;
+    (void)is_final;
+    (void)payload;
+    (void)payload_length;
+    result = 0;
+#endif
+
+    return result;
+}
+
+static bool is_data_frame_opcode(unsigned char opcode)
+{
+    return (opcode == (unsigned char)WS_CONTINUATION_FRAME) ||
+        (opcode == (unsigned char)WS_TEXT_FRAME) ||
+        (opcode == (unsigned char)WS_BINARY_FRAME);
+}
+
+/* Number of bytes the stream buffer still needs before the frame it holds can be decoded when fragments are streamed:
+the header for data frames, the whole frame for control frames */
+static size_t get_missing_buffered_frame_bytes(UWS_CLIENT_INSTANCE* uws_client)
+{
+    const unsigned char* frame_bytes = uws_client->stream_buffer + uws_client->stream_buffer_offset;
+    size_t needed_bytes = 2;
+
+    if (uws_client->stream_buffer_count >= needed_bytes)
+    {
+        size_t length = frame_bytes[1];
+
+        if (length == 126)
+        {
+            needed_bytes += 2;
+        }
+        else if (length == 127)
+        {
+            needed_bytes += 8;
+        }
+        else if (!is_data_frame_opcode(frame_bytes[0] & 0xF))
+        {
+            needed_bytes += length;
+        }
+    }
+
+    return (uws_client->stream_buffer_count >= needed_bytes) ? 0 : needed_bytes - uws_client->stream_buffer_count;
+}
+
+static void begin_streamed_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char opcode, bool is_compressed, bool is_final, size_t length)
+{
+    unsigned char frame_type;
+
+    if (opcode == (unsigned char)WS_CONTINUATION_FRAME)
+    {
+        if (uws_client->fragmented_frame_type == WS_FRAME_TYPE_UNKNOWN)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_571: [ If a continuation frame is received while no fragmented message is in progress, or a text or binary frame is received while one is, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and the payload of the frame shall be discarded. ]*/
+            LogError("Continuation fragment received without initial fragment specifying frame data type");
+            indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+            frame_type = WS_FRAME_TYPE_UNKNOWN;
+        }
+        else
+        {
+            frame_type = uws_client->fragmented_frame_type;
+        }
+    }
+    else if (uws_client->fragmented_frame_type != WS_FRAME_TYPE_UNKNOWN)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_571: [ If a continuation frame is received while no fragmented message is in progress, or a text or binary frame is received while one is, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and the payload of the frame shall be discarded. ]*/
+        LogError("Fragmented frame received interleaved between the fragments of another message");
+        indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+        frame_type = WS_FRAME_TYPE_UNKNOWN;
+    }
+    else
+    {
+        frame_type = (opcode == (unsigned char)WS_TEXT_FRAME) ? WS_FRAME_TYPE_TEXT : WS_FRAME_TYPE_BINARY;
+        if (!is_final)
+        {
+            uws_client->fragmented_frame_type = frame_type;
+        }
+    }
+
+    uws_client->streamed_frame_opcode = opcode;
+    uws_client->streamed_frame_type = frame_type;
+    uws_client->streamed_frame_is_compressed = is_compressed;
+    uws_client->streamed_frame_is_final = is_final;
+    uws_client->streamed_frame_remaining = length;
+    uws_client->is_streaming_frame_payload = true;
+}
+
+static size_t deliver_streamed_frame_payload(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t count)
+{
+    size_t slice_length = (count < uws_client->streamed_frame_remaining) ? count : uws_client->streamed_frame_remaining;
+    bool is_message_end = (slice_length == uws_client->streamed_frame_remaining) && uws_client->streamed_frame_is_final;
+    const unsigned char* payload = bytes;
+    size_t payload_length = slice_length;
+
+    uws_client->streamed_frame_remaining -= slice_length;
+    if (uws_client->streamed_frame_remaining == 0)
+    {
+        uws_client->is_streaming_frame_payload = false;
+    }
+
+    if (uws_client->streamed_frame_type != WS_FRAME_TYPE_UNKNOWN)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_572: [ Slices of a compressed message shall be decompressed by calling `uws_permessage_deflate_decompress` as they arrive. ]*/
+        if (get_received_message_payload(uws_client, uws_client->streamed_frame_opcode, uws_client->streamed_frame_is_compressed, is_message_end, &payload, &payload_length) != 0)
+        {
+            /* the rest of the frame is dropped, the error has already been indicated */
+            uws_client->streamed_frame_type = WS_FRAME_TYPE_UNKNOWN;
+        }
+        else
+        {
+            unsigned char frame_type = uws_client->streamed_frame_type;
+            uint64_t message_offset = uws_client->streamed_message_offset;
+
+            /* RSV1 and the opcode only apply to the first slice of the frame */
+            uws_client->streamed_frame_opcode = (unsigned char)WS_CONTINUATION_FRAME;
+            uws_client->streamed_frame_is_compressed = false;
+            uws_client->streamed_message_offset += payload_length;
+
+            if (is_message_end)
+            {
+                uws_client->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+                uws_client->streamed_message_offset = 0;
+            }
+
+            /* Codes_SRS_UWS_CLIENT_01_569: [ Slices without payload bytes shall not be indicated, except for the last slice of a message. ]*/
+            if ((payload_length > 0) || is_message_end)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_567: [ When a fragment received callback is set, the payload bytes of data frames shall be indicated by calling `on_ws_fragment_received` as soon as they are received, without waiting for the whole frame or message. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_568: [ `message_offset` shall be the position of the first indicated byte in the message and `is_final` shall be true only for the last slice of the final frame of the message. ]*/
+                uws_client->on_ws_fragment_received(uws_client->on_ws_fragment_received_context, frame_type, payload, payload_length, message_offset, is_message_end);
+            }
+        }
+    }
+
+    return slice_length;
+}
+
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     /* Codes_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
@@ -1060,6 +1507,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
         else
         {
             unsigned char decode_stream = 1;
+            const unsigned char* unbuffered_bytes = NULL;
+            size_t unbuffered_bytes_count = 0;
 
             switch (uws_client->uws_state)
             {
@@ -1077,8 +1526,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->stream_buffer, uws_client->stream_buffer_count + size + 1);
-                if (new_received_bytes == NULL)
+                if (append_to_stream_buffer(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
                     indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
@@ -1086,10 +1534,6 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 else
                 {
-                    uws_client->stream_buffer = new_received_bytes;
-                    (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_count, buffer, size);
-                    uws_client->stream_buffer_count += size;
-
                     decode_stream = 1;
                 }
 
@@ -1100,21 +1544,53 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->stream_buffer, uws_client->stream_buffer_count + size + 1);
-                if (new_received_bytes == NULL)
+                if (uws_client->stream_buffer_count == 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_532: [ If no bytes are accumulated from a previous call, frames shall be decoded directly from `buffer` without copying the bytes. ]*/
+                    uws_client->received_bytes = buffer;
+                    uws_client->received_bytes_count = size;
+
+                    decode_stream = 1;
+                }
+                else if (uws_client->on_ws_fragment_received != NULL)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_570: [ When a fragment received callback is set, only the bytes needed to complete a partially received frame header or control frame shall be accumulated, the remaining bytes in `buffer` shall be decoded without copying them. ]*/
+                    size_t missing_bytes = get_missing_buffered_frame_bytes(uws_client);
+
+                    decode_stream = 1;
+
+                    while ((missing_bytes > 0) && (size > 0))
+                    {
+                        size_t copied_bytes = (missing_bytes < size) ? missing_bytes : size;
+
+                        if (append_to_stream_buffer(uws_client, buffer, copied_bytes) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                            indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+                            decode_stream = 0;
+                            break;
+                        }
+
+                        buffer += copied_bytes;
+                        size -= copied_bytes;
+                        missing_bytes = get_missing_buffered_frame_bytes(uws_client);
+                    }
+
+                    if (decode_stream)
+                    {
+                        unbuffered_bytes = buffer;
+                        unbuffered_bytes_count = size;
+                    }
+                }
+                else if (append_to_stream_buffer(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-                    LogError("Cannot allocate memory for received data");
                     indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
 
                     decode_stream = 0;
                 }
                 else
                 {
-                    uws_client->stream_buffer = new_received_bytes;
-                    (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_count, buffer, size);
-                    uws_client->stream_buffer_count += size;
-
                     decode_stream = 1;
                 }
 
@@ -1142,12 +1618,12 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                     const char* request_end_ptr;
 
                     /* Make sure it is zero terminated */
-                    uws_client->stream_buffer[uws_client->stream_buffer_count] = '\0';
+                    uws_client->stream_buffer[uws_client->stream_buffer_offset + uws_client->stream_buffer_count] = '\0';
 
                     /* Codes_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
                     if ((uws_client->stream_buffer_count >= 4) &&
-                        ((request_end_ptr = strstr((const char*)uws_client->stream_buffer, "\r\n\r\n")) != NULL))
+                        ((request_end_ptr = strstr((const char*)uws_client->stream_buffer + uws_client->stream_buffer_offset, "\r\n\r\n")) != NULL))
                     {
                         int status_code;
 
@@ -1156,7 +1632,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
 
                         /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
                         /* Codes_SRS_UWS_CLIENT_01_478: [ A Status-Line with a 101 response code as per RFC 2616 [RFC2616]. ]*/
-                        if (ParseHttpResponse((const char*)uws_client->stream_buffer, &status_code) != 0)
+                        if (ParseHttpResponse((const char*)uws_client->stream_buffer + uws_client->stream_buffer_offset, &status_code) != 0)
                         {
                             /* Codes_SRS_UWS_CLIENT_01_383: [ If the WebSocket upgrade request cannot be decoded an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
                             LogError("Cannot decode HTTP response");
@@ -1168,10 +1644,16 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             LogError("Bad status (%d) received in WebSocket Upgrade response", status_code);
                             indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_RESPONSE_STATUS);
                         }
+                        else if (accept_upgrade_response_extensions(uws_client, (const char*)uws_client->stream_buffer + uws_client->stream_buffer_offset, request_end_ptr) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_548: [ If `uws_permessage_deflate_accept_response` fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+                            /* Codes_SRS_UWS_CLIENT_01_111: [ If the response includes a |Sec-WebSocket-Extensions| header field and this header field indicates the use of an extension that was not present in the client's handshake (the server has indicated an extension not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE);
+                        }
                         else
                         {
                             /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-                            consume_stream_buffer_bytes(uws_client, request_end_ptr - (char*)uws_client->stream_buffer + 4);
+                            consume_stream_buffer_bytes(uws_client, request_end_ptr - ((char*)uws_client->stream_buffer + uws_client->stream_buffer_offset) + 4);
 
                             /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
                             uws_client->uws_state = UWS_STATE_OPEN;
@@ -1191,16 +1673,49 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
                 {
                     size_t needed_bytes = 2;
+                    size_t header_length = 0;
                     size_t length;
+                    const unsigned char* frame_bytes;
+                    size_t frame_bytes_count;
+
+                    if ((uws_client->received_bytes == NULL) &&
+                        (uws_client->stream_buffer_count == 0) &&
+                        (unbuffered_bytes_count > 0))
+                    {
+                        /* The buffered frame has been decoded, carry on with the rest of the received bytes in place */
+                        uws_client->received_bytes = unbuffered_bytes;
+                        uws_client->received_bytes_count = unbuffered_bytes_count;
+                        unbuffered_bytes_count = 0;
+                    }
+
+                    if (uws_client->received_bytes != NULL)
+                    {
+                        frame_bytes = uws_client->received_bytes;
+                        frame_bytes_count = uws_client->received_bytes_count;
+                    }
+                    else
+                    {
+                        frame_bytes = uws_client->stream_buffer + uws_client->stream_buffer_offset;
+                        frame_bytes_count = uws_client->stream_buffer_count;
+                    }
 
                     /* Codes_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
-                    if (uws_client->stream_buffer_count >= needed_bytes)
+                    if (uws_client->is_streaming_frame_payload)
+                    {
+                        if ((frame_bytes_count > 0) ||
+                            (uws_client->streamed_frame_remaining == 0))
+                        {
+                            consume_stream_buffer_bytes(uws_client, deliver_streamed_frame_payload(uws_client, frame_bytes, frame_bytes_count));
+                            decode_stream = 1;
+                        }
+                    }
+                    else if (frame_bytes_count >= needed_bytes)
                     {
                         unsigned char has_error = 0;
 
                         /* Codes_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-                        if ((uws_client->stream_buffer[1] & 0x80) != 0)
+                        if ((frame_bytes[1] & 0x80) != 0)
                         {
                             /* Codes_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
                             /* Codes_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
@@ -1210,16 +1725,16 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
 
                         /* Codes_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
                         /* Codes_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-                        length = uws_client->stream_buffer[1];
+                        length = frame_bytes[1];
 
                         if (length == 126)
                         {
                             /* Codes_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
                             needed_bytes += 2;
-                            if (uws_client->stream_buffer_count >= needed_bytes)
+                            if (frame_bytes_count >= needed_bytes)
                             {
                                 /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                length = ((size_t)(uws_client->stream_buffer[2]) << 8) + (size_t)uws_client->stream_buffer[3];
+                                length = ((size_t)(frame_bytes[2]) << 8) + (size_t)frame_bytes[3];
 
                                 if (length < 126)
                                 {
@@ -1232,6 +1747,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 }
                                 else
                                 {
+                                    header_length = needed_bytes;
                                     needed_bytes += (size_t)length;
                                 }
                             }
@@ -1240,9 +1756,9 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         {
                             /* Codes_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
                             needed_bytes += 8;
-                            if (uws_client->stream_buffer_count >= needed_bytes)
+                            if (frame_bytes_count >= needed_bytes)
                             {
-                                if ((uws_client->stream_buffer[2] & 0x80) != 0)
+                                if ((frame_bytes[2] & 0x80) != 0)
                                 {
                                     LogError("Bad frame: received a 64 bit length frame with the highest bit set");
 
@@ -1253,14 +1769,14 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 else
                                 {
                                     /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                    length = (size_t)(((uint64_t)(uws_client->stream_buffer[2]) << 56) +
-                                        (((uint64_t)uws_client->stream_buffer[3]) << 48) +
-                                        (((uint64_t)uws_client->stream_buffer[4]) << 40) +
-                                        (((uint64_t)uws_client->stream_buffer[5]) << 32) +
-                                        (((uint64_t)uws_client->stream_buffer[6]) << 24) +
-                                        (((uint64_t)uws_client->stream_buffer[7]) << 16) +
-                                        (((uint64_t)uws_client->stream_buffer[8]) << 8) +
-                                        (uint64_t)(uws_client->stream_buffer[9]));
+                                    length = (size_t)(((uint64_t)(frame_bytes[2]) << 56) +
+                                        (((uint64_t)frame_bytes[3]) << 48) +
+                                        (((uint64_t)frame_bytes[4]) << 40) +
+                                        (((uint64_t)frame_bytes[5]) << 32) +
+                                        (((uint64_t)frame_bytes[6]) << 24) +
+                                        (((uint64_t)frame_bytes[7]) << 16) +
+                                        (((uint64_t)frame_bytes[8]) << 8) +
+                                        (uint64_t)(frame_bytes[9]));
 
                                     if (length < 65536)
                                     {
@@ -1273,6 +1789,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     }
                                     else
                                     {
+                                        header_length = needed_bytes;
                                         needed_bytes += length;
                                     }
                                 }
@@ -1280,16 +1797,41 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         }
                         else
                         {
+                            header_length = needed_bytes;
                             needed_bytes += length;
                         }
 
                         if ((has_error == 0) &&
-                            (uws_client->stream_buffer_count >= needed_bytes))
+                            (header_length > 0) &&
+                            (uws_client->on_ws_fragment_received != NULL) &&
+                            is_data_frame_opcode(frame_bytes[0] & 0xF))
                         {
-                            unsigned char opcode = uws_client->stream_buffer[0] & 0xF;
+                            /* Codes_SRS_UWS_CLIENT_01_567: [ When a fragment received callback is set, the payload bytes of data frames shall be indicated by calling `on_ws_fragment_received` as soon as they are received, without waiting for the whole frame or message. ]*/
+                            begin_streamed_frame(uws_client, frame_bytes[0] & 0xF, (frame_bytes[0] & 0x40) != 0, (frame_bytes[0] & 0x80) != 0, length);
+                            consume_stream_buffer_bytes(uws_client, header_length);
+                            decode_stream = 1;
+                        }
+                        else if ((has_error == 0) &&
+                            (header_length > 0) &&
+                            (uws_client->on_ws_fragment_received != NULL) &&
+                            (length > 125))
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_573: [ When a fragment received callback is set, a control frame with a payload longer than 125 bytes shall be indicated as an error by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+                            LogError("Bad frame: control frame with a %u bytes payload", (unsigned int)length);
+                            indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                        }
+                        else if ((has_error == 0) &&
+                            (frame_bytes_count >= needed_bytes))
+                        {
+                            unsigned char opcode = frame_bytes[0] & 0xF;
 
                             /* Codes_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
-                            bool is_final = (uws_client->stream_buffer[0] & 0x80) != 0;
+                            bool is_final = (frame_bytes[0] & 0x80) != 0;
+
+                            /* Codes_SRS_UWS_CLIENT_01_149: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+                            bool is_compressed = (frame_bytes[0] & 0x40) != 0;
+                            const unsigned char* payload = frame_bytes + needed_bytes - length;
+                            size_t payload_length = length;
 
                             switch (opcode)
                             {
@@ -1301,7 +1843,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                if ((get_received_message_payload(uws_client, opcode, is_compressed, is_final, &payload, &payload_length) != 0) ||
+                                    (process_frame_fragment(uws_client, payload, payload_length) != 0))
                                 {
                                     break;
                                 }
@@ -1333,9 +1876,14 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+                                if (get_received_message_payload(uws_client, opcode, is_compressed, is_final, &payload, &payload_length) != 0)
+                                {
+                                    break;
+                                }
+
                                 if (is_final)
                                 {
-                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, uws_client->stream_buffer + needed_bytes - length, length);
+                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, payload, payload_length);
                                 }
                                 else
                                 {
@@ -1350,7 +1898,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                    if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                    if (process_frame_fragment(uws_client, payload, payload_length) != 0)
                                     {
                                         break;
                                     }
@@ -1373,9 +1921,14 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+                                if (get_received_message_payload(uws_client, opcode, is_compressed, is_final, &payload, &payload_length) != 0)
+                                {
+                                    break;
+                                }
+
                                 if (is_final)
                                 {
-                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, uws_client->stream_buffer + needed_bytes - length, length);
+                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, payload, payload_length);
                                 }
                                 else
                                 {
@@ -1390,7 +1943,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                    if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                    if (process_frame_fragment(uws_client, payload, payload_length) != 0)
                                     {
                                         break;
                                     }
@@ -1410,7 +1963,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             {
                                 uint16_t close_code;
                                 uint16_t* close_code_ptr;
-                                const unsigned char* data_ptr = uws_client->stream_buffer + needed_bytes - length;
+                                const unsigned char* data_ptr = frame_bytes + needed_bytes - length;
                                 const unsigned char* extra_data_ptr;
                                 size_t extra_data_length;
                                 unsigned char* close_frame_bytes;
@@ -1559,7 +2112,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 }
 
                                 /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-                                pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, uws_client->stream_buffer + needed_bytes - length, length, true, true, 0);
+                                pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, frame_bytes + needed_bytes - length, length, true, true, 0);
                                 if (pong_frame_buffer == NULL)
                                 {
                                     LogError("Encoding of PONG failed.");
@@ -1577,10 +2130,14 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     BUFFER_delete(pong_frame_buffer);
                                 }
 
+                                /* Codes_SRS_UWS_CLIENT_01_574: [ Decoding shall continue with the bytes following a PING or PONG frame. ]*/
+                                decode_stream = 1;
                                 break;
                             }
                             /* Codes_SRS_UWS_CLIENT_01_252: [ The Pong frame contains an opcode of 0xA. ]*/
                             case (unsigned char)WS_PONG_FRAME:
+                                /* Codes_SRS_UWS_CLIENT_01_574: [ Decoding shall continue with the bytes following a PING or PONG frame. ]*/
+                                decode_stream = 1;
                                 break;
                             }
 
@@ -1592,6 +2149,27 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 }
             }
+
+            if (uws_client->received_bytes != NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_533: [ Any bytes left over from `buffer` that do not form a complete frame shall be accumulated for decoding when more bytes are received. ]*/
+                if ((uws_client->received_bytes_count > 0) &&
+                    (append_to_stream_buffer(uws_client, uws_client->received_bytes, uws_client->received_bytes_count) != 0))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                    indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+                }
+
+                uws_client->received_bytes = NULL;
+                uws_client->received_bytes_count = 0;
+            }
+
+            if ((unbuffered_bytes_count > 0) &&
+                (append_to_stream_buffer(uws_client, unbuffered_bytes, unbuffered_bytes_count) != 0))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+            }
         }
     }
 }
@@ -1661,9 +2239,14 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
         {
             uws_client->uws_state = UWS_STATE_OPENING_UNDERLYING_IO;
 
+            uws_client->stream_buffer_offset = 0;
             uws_client->stream_buffer_count = 0;
             uws_client->fragment_buffer_count = 0;
             uws_client->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+            uws_client->is_streaming_frame_payload = false;
+            uws_client->streamed_message_offset = 0;
+            uws_client->is_sending_compressed_message = false;
+            uws_client->is_receiving_compressed_message = false;
 
             uws_client->on_ws_open_complete = on_ws_open_complete;
             uws_client->on_ws_open_complete_context = on_ws_open_complete_context;
@@ -1696,34 +2279,6 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
     return result;
 }
 
-static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, LIST_ITEM_HANDLE pending_send_frame_item, WS_SEND_FRAME_RESULT ws_send_frame_result)
-{
-    int result;
-    UWS_CLIENT_INSTANCE* uws_client = ws_pending_send->uws_client;
-
-    /* Codes_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling `singlylinkedlist_remove`. ]*/
-    if (singlylinkedlist_remove(uws_client->pending_sends, pending_send_frame_item) != 0)
-    {
-        LogError("Failed removing item from list");
-        result = __FAILURE__;
-    }
-    else
-    {
-        if (ws_pending_send->on_ws_send_frame_complete != NULL)
-        {
-            /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the `on_ws_send_frame_complete` callback shall be the context given to `uws_client_send_frame_async`. ]*/
-            ws_pending_send->on_ws_send_frame_complete(ws_pending_send->context, ws_send_frame_result);
-        }
-
-        /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
-        free(ws_pending_send);
-
-        result = 0;
-    }
-
-    return result;
-}
-
 /* Codes_SRS_UWS_CLIENT_01_029: [ `uws_client_close_async` shall close the uws instance connection if an open action is either pending or has completed successfully (if the IO is open). ]*/
 /* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
 int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
@@ -1788,6 +2343,13 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
     return result;
 }
 
+static bool is_pending_send_not_cancelled(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const WS_PENDING_SEND* ws_pending_send = (const WS_PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+    (void)match_context;
+    return (ws_pending_send != NULL) && (ws_pending_send->on_ws_send_frame_complete != NULL);
+}
+
 /* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
 int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t close_code, const char* close_reason, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
 {
@@ -1832,13 +2394,17 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
             }
             else
             {
-                LIST_ITEM_HANDLE first_pending_send;
+                LIST_ITEM_HANDLE pending_send_to_cancel;
 
-                while ((first_pending_send = singlylinkedlist_get_head_item(uws_client->pending_sends)) != NULL)
+                /* Codes_SRS_UWS_CLIENT_01_578: [ Each pending send frame that still has a send complete callback shall be indicated with `WS_SEND_FRAME_CANCELLED` and stay queued without a callback until the underlying IO completes it, since the underlying IO may still reference its header and payload. ]*/
+                /* The search restarts after each callback, as the callback may change the list */
+                while ((pending_send_to_cancel = singlylinkedlist_find(uws_client->pending_sends, is_pending_send_not_cancelled, NULL)) != NULL)
                 {
-                    WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
+                    WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(pending_send_to_cancel);
+                    ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete = ws_pending_send->on_ws_send_frame_complete;
 
-                    complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
+                    ws_pending_send->on_ws_send_frame_complete = NULL;
+                    on_ws_send_frame_complete(ws_pending_send->context, WS_SEND_FRAME_CANCELLED);
                 }
 
                 /* Codes_SRS_UWS_CLIENT_01_466: [ On success `uws_client_close_handshake_async` shall return 0. ]*/
@@ -1904,9 +2470,71 @@ static bool find_list_node(LIST_ITEM_HANDLE list_item, const void* match_context
     return list_item == (LIST_ITEM_HANDLE)match_context;
 }
 
+static int get_frame_payload_to_send(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, bool is_final, const unsigned char** payload, size_t* payload_size, unsigned char* reserved)
+{
+    int result;
+
+#ifdef USE_PERMESSAGE_DEFLATE
+    /* Codes_SRS_UWS_CLIENT_01_553: [ When sending the first frame of a message, uws shall call `uws_permessage_deflate_should_compress` to decide whether all the frames of the message are compressed. ]*/
+    if (frame_type != WS_FRAME_TYPE_UNKNOWN)
+    {
+        uws_client->is_sending_compressed_message = (uws_client->permessage_deflate != NULL) &&
+            uws_permessage_deflate_should_compress(uws_client->permessage_deflate, *payload_size, is_final);
+
+        /* Codes_SRS_UWS_CLIENT_01_554: [ The RSV1 bit shall be set on the first frame of a compressed message. ]*/
+        *reserved = uws_client->is_sending_compressed_message ? RESERVED_1 : 0;
+    }
+    else
+    {
+        *reserved = 0;
+    }
+
+    if (!uws_client->is_sending_compressed_message)
+    {
+        result = 0;
+    }
+    else
+    {
+        const unsigned char* compressed_payload;
+        size_t compressed_size;
+
+        /* Codes_SRS_UWS_CLIENT_01_555: [ The payload of each frame of a compressed message shall be compressed by calling `uws_permessage_deflate_compress` and the compressed bytes shall be masked and sent instead of `buffer`. ]*/
+        if (uws_permessage_deflate_compress(uws_client->permessage_deflate, *payload, *payload_size, is_final, &compressed_payload, &compressed_size) != 0)
+        {
+            LogError("Cannot compress the frame payload");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (is_final)
+            {
+                uws_client->is_sending_compressed_message = false;
+            }
+
+            *payload = compressed_payload;
+            *payload_size = compressed_size;
+            result = 0;
+        }
+    }
+#else
+    (void)uws_client;
+    (void)frame_type;
+    (void)is_final;
+    (void)payload;
+    (void)payload_size;
+    *reserved = 0;
+    result = 0;
+#endif
+
+    return result;
+}
+
 int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
 {
     int result;
+    const unsigned char* payload = buffer;
+    size_t payload_size = size;
+    unsigned char reserved = 0;
 
     if (uws_client == NULL)
     {
@@ -1929,9 +2557,22 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
         LogError("uws not in OPEN state.");
         result = __FAILURE__;
     }
+    else if (get_frame_payload_to_send(uws_client, frame_type, is_final, &payload, &payload_size, &reserved) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_556: [ If `uws_permessage_deflate_compress` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Cannot compress the frame to be sent");
+        result = __FAILURE__;
+    }
+    else if (payload_size > SIZE_MAX - sizeof(WS_PENDING_SEND))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_577: [ If the size of the queued structure together with the masked payload does not fit in a `size_t`, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Frame payload of %u bytes is too large", (unsigned int)payload_size);
+        result = __FAILURE__;
+    }
     else
     {
-        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)malloc(sizeof(WS_PENDING_SEND));
+        /* Codes_SRS_UWS_CLIENT_01_536: [ The queued structure shall be allocated together with the storage for the masked payload, so that the encoded header and the masked payload stay valid until the underlying IO completes the send. ]*/
+        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)malloc(sizeof(WS_PENDING_SEND) + payload_size);
         if (ws_pending_send == NULL)
         {
             /* Codes_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
@@ -1940,30 +2581,40 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
         }
         else
         {
-            BUFFER_HANDLE non_control_frame_buffer;
+            unsigned char* header = ws_pending_send->header;
+            unsigned char* masked_payload = (unsigned char*)(ws_pending_send + 1);
+            size_t header_length;
 
-            /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_534: [ The frame header shall be encoded into the `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes header storage of the queued structure by calling `uws_frame_encoder_encode_header` and passing to it `size` as payload length, the `is_final` flag and setting `is_masked` to true. ]*/
             /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
             /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
             /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
-            non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, buffer, size, true, is_final, 0);
-            if (non_control_frame_buffer == NULL)
+            header_length = uws_frame_encoder_encode_header(header, (WS_FRAME_TYPE)frame_type, payload_size, true, is_final, reserved);
+            if (header_length == 0)
             {
-                /* Codes_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-                LogError("Failed encoding WebSocket frame");
+                /* Codes_SRS_UWS_CLIENT_01_535: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                LogError("Failed encoding WebSocket frame header");
                 free(ws_pending_send);
                 result = __FAILURE__;
             }
             else
             {
-                const unsigned char* encoded_frame;
-                size_t encoded_frame_length;
+                CONSTBUFFER frame_buffers[2];
+                size_t frame_buffer_count = 1;
                 LIST_ITEM_HANDLE new_pending_send_list_item;
 
-                /* Codes_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
-                encoded_frame = BUFFER_u_char(non_control_frame_buffer);
-                /* Codes_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
-                encoded_frame_length = BUFFER_length(non_control_frame_buffer);
+                frame_buffers[0].buffer = header;
+                frame_buffers[0].size = header_length;
+
+                if (payload_size > 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_538: [ The payload shall be masked with the masking key at the end of the encoded header by calling `uws_frame_encoder_mask_payload`, writing into the payload storage of the queued structure. ]*/
+                    uws_frame_encoder_mask_payload(masked_payload, payload, payload_size, header + header_length - 4);
+
+                    frame_buffers[1].buffer = masked_payload;
+                    frame_buffers[1].size = payload_size;
+                    frame_buffer_count = 2;
+                }
 
                 /* Codes_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
                 /* Codes_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
@@ -1984,22 +2635,22 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                 }
                 else
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_431: [ Once encoded the frame shall be sent by using `xio_send` with the following arguments: ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_431: [ Once encoded the frame shall be sent by using `xio_send_vectored` with the following arguments: ]*/
                     /* Codes_SRS_UWS_CLIENT_01_053: [ - the io handle shall be the underlyiong IO handle created in `uws_client_create`. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_054: [ - the `buffer` argument shall point to the complete websocket frame to be sent. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_055: [ - the `size` argument shall indicate the websocket frame length. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_054: [ - the `buffers` argument shall point to the encoded header followed by the masked payload. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_055: [ - the `buffer_count` argument shall be 2, or 1 when `size` is 0 and there is no payload to send. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_057: [ - the `send_complete_context` argument shall identify the pending send. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
-                    if (xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, new_pending_send_list_item) != 0)
+                    if (xio_send_vectored(uws_client->underlying_io, frame_buffers, frame_buffer_count, on_underlying_io_send_complete, new_pending_send_list_item) != 0)
                     {
-                        /* Codes_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                        /* Codes_SRS_UWS_CLIENT_01_058: [ If `xio_send_vectored` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
                         LogError("Could not send bytes through the underlying IO");
 
-                        /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+                        /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send_vectored` fails and the message is still queued, it shall be de-queued and destroyed. ] */
                         if (singlylinkedlist_find(uws_client->pending_sends, find_list_node, new_pending_send_list_item) != NULL)
                         {
-                            // Guards against double free in case the underlying I/O invoked 'on_underlying_io_send_complete' within xio_send.
+                            // Guards against double free in case the underlying I/O invoked 'on_underlying_io_send_complete' within xio_send_vectored.
                             (void)singlylinkedlist_remove(uws_client->pending_sends, new_pending_send_list_item);
                             free(ws_pending_send);
                         }
@@ -2012,8 +2663,6 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                         result = 0;
                     }
                 }
-
-                BUFFER_delete(non_control_frame_buffer);
             }
         }
     }
@@ -2039,6 +2688,70 @@ void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
     }
 }
 
+static int set_permessage_deflate_option(UWS_CLIENT_INSTANCE* uws_client, const UWS_PERMESSAGE_DEFLATE_CONFIG* config)
+{
+    int result;
+
+#ifdef USE_PERMESSAGE_DEFLATE
+    if (uws_client->uws_state != UWS_STATE_CLOSED)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_541: [ If the uws instance is not CLOSED, setting the `permessage_deflate` option shall fail and return a non-zero value. ]*/
+        LogError("permessage-deflate can only be configured while the uws instance is closed");
+        result = __FAILURE__;
+    }
+    else if (config == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_542: [ If `value` is NULL, the permessage-deflate instance shall be destroyed and the `Sec-WebSocket-Extensions` request header removed. ]*/
+        if (uws_client->permessage_deflate != NULL)
+        {
+            (void)Map_Delete(uws_client->request_headers, SEC_WEBSOCKET_EXTENSIONS_HEADER);
+            uws_permessage_deflate_destroy(uws_client->permessage_deflate);
+            uws_client->permessage_deflate = NULL;
+        }
+
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_540: [ If the option name is `permessage_deflate`, `uws_client_set_option` shall create a permessage-deflate instance by calling `uws_permessage_deflate_create` with `value` as config. ]*/
+        UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(config);
+        if (permessage_deflate == NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_543: [ If creating the permessage-deflate instance or adding the request header fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+            LogError("uws_permessage_deflate_create failed");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_UWS_CLIENT_01_100: [ The request MAY include a header field with the name |Sec-WebSocket-Extensions|. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_544: [ The extension offer obtained with `uws_permessage_deflate_get_offer` shall be added as the `Sec-WebSocket-Extensions` request header, so that it is sent in the upgrade request. ]*/
+        else if (Map_AddOrUpdate(uws_client->request_headers, SEC_WEBSOCKET_EXTENSIONS_HEADER, uws_permessage_deflate_get_offer(permessage_deflate)) != MAP_OK)
+        {
+            LogError("Cannot add the Sec-WebSocket-Extensions request header");
+            uws_permessage_deflate_destroy(permessage_deflate);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (uws_client->permessage_deflate != NULL)
+            {
+                uws_permessage_deflate_destroy(uws_client->permessage_deflate);
+            }
+
+            uws_client->permessage_deflate = permessage_deflate;
+            uws_client->permessage_deflate_config = *config;
+            result = 0;
+        }
+    }
+#else
+    /* Codes_SRS_UWS_CLIENT_01_545: [ If uws was built without permessage-deflate support, setting the `permessage_deflate` option shall fail and return a non-zero value. ]*/
+    (void)uws_client;
+    (void)config;
+    LogError("uws_client was built without permessage-deflate support");
+    result = __FAILURE__;
+#endif
+
+    return result;
+}
+
 int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name, const void* value)
 {
     int result;
@@ -2069,6 +2782,10 @@ int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name,
                 result = 0;
             }
         }
+        else if (strcmp(OPTION_WS_PERMESSAGE_DEFLATE, option_name) == 0)
+        {
+            result = set_permessage_deflate_option(uws_client, (const UWS_PERMESSAGE_DEFLATE_CONFIG*)value);
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling `xio_setoption`. ]*/
@@ -2109,6 +2826,22 @@ static void* uws_client_clone_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_507: [ `uws_client_clone_option` called with `name` being `uWSClientOptions` shall return the same value. ]*/
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_557: [ `uws_client_clone_option` called with `name` being `permessage_deflate` shall return a newly allocated copy of the `UWS_PERMESSAGE_DEFLATE_CONFIG` pointed to by `value`. ]*/
+            UWS_PERMESSAGE_DEFLATE_CONFIG* config = (UWS_PERMESSAGE_DEFLATE_CONFIG*)malloc(sizeof(UWS_PERMESSAGE_DEFLATE_CONFIG));
+            if (config == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_558: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("Cannot allocate memory for the permessage-deflate option");
+            }
+            else
+            {
+                *config = *(const UWS_PERMESSAGE_DEFLATE_CONFIG*)value;
+            }
+
+            result = config;
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_512: [ `uws_client_clone_option` called with any other option name than `uWSClientOptions` shall return NULL. ]*/
@@ -2137,6 +2870,11 @@ static void uws_client_destroy_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_508: [ `uws_client_destroy_option` called with the option `name` being `uWSClientOptions` shall destroy the value by calling `OptionHandler_Destroy`. ]*/
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_559: [ `uws_client_destroy_option` called with the option `name` being `permessage_deflate` shall free the value. ]*/
+            free((void*)value);
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_513: [ If `uws_client_destroy_option` is called with any other `name` it shall do nothing. ]*/
@@ -2187,6 +2925,14 @@ OPTIONHANDLER_HANDLE uws_client_retrieve_options(UWS_CLIENT_HANDLE uws_client)
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                /* Codes_SRS_UWS_CLIENT_01_560: [ If permessage-deflate is configured, `uws_client_retrieve_options` shall also add the `permessage_deflate` option with the config that was set. ]*/
+                else if ((uws_client->permessage_deflate != NULL) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PERMESSAGE_DEFLATE, &uws_client->permessage_deflate_config) != OPTIONHANDLER_OK))
+                {
+                    LogError("OptionHandler_AddOption failed for the permessage-deflate option");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
             }
         }
 
@@ -2220,3 +2966,69 @@ int uws_client_set_request_header(UWS_CLIENT_HANDLE uws_client, const char* name
 
     return result;
 }
+
+int uws_client_get_permessage_deflate_statistics(UWS_CLIENT_HANDLE uws_client, UWS_PERMESSAGE_DEFLATE_STATISTICS* statistics)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_562: [ If `uws_client` or `statistics` is NULL, `uws_client_get_permessage_deflate_statistics` shall fail and return a non-zero value. ]*/
+        LogError("invalid parameter (uws_client=%p, statistics=%p)", uws_client, statistics);
+        result = __FAILURE__;
+    }
+    else if (uws_client->permessage_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_563: [ If permessage-deflate is not configured, `uws_client_get_permessage_deflate_statistics` shall fail and return a non-zero value. ]*/
+        LogError("permessage-deflate is not configured");
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef USE_PERMESSAGE_DEFLATE
+        /* Codes_SRS_UWS_CLIENT_01_561: [ `uws_client_get_permessage_deflate_statistics` shall fill `statistics` by calling `uws_permessage_deflate_get_statistics`. ]*/
+        if (uws_permessage_deflate_get_statistics(uws_client->permessage_deflate, statistics) != 0)
+        {
+            LogError("uws_permessage_deflate_get_statistics failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+#else
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+int uws_client_set_fragment_received_callback(UWS_CLIENT_HANDLE uws_client, ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received, void* on_ws_fragment_received_context)
+{
+    int result;
+
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_565: [ If `uws_client` is NULL, `uws_client_set_fragment_received_callback` shall fail and return a non-zero value. ]*/
+        LogError("NULL uws_client");
+        result = __FAILURE__;
+    }
+    else if (uws_client->uws_state != UWS_STATE_CLOSED)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_566: [ If the uws instance is not CLOSED, `uws_client_set_fragment_received_callback` shall fail and return a non-zero value. ]*/
+        LogError("Cannot change the fragment received callback in state %d", (int)uws_client->uws_state);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_575: [ `uws_client_set_fragment_received_callback` shall store `on_ws_fragment_received` and `on_ws_fragment_received_context` and return 0. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_576: [ A NULL `on_ws_fragment_received` shall restore delivering whole messages through `on_ws_frame_received`. ]*/
+        uws_client->on_ws_fragment_received = on_ws_fragment_received;
+        uws_client->on_ws_fragment_received_context = on_ws_fragment_received_context;
+        result = 0;
+    }
+
+    return result;
+}
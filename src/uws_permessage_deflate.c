@@ -0,0 +1,723 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "zlib.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/uws_permessage_deflate.h"
+
+#define PERMESSAGE_DEFLATE_EXTENSION_NAME "permessage-deflate"
+#define MIN_WINDOW_BITS 8
+#define MAX_WINDOW_BITS 15
+/* zlib cannot produce raw deflate streams with a 256 byte window */
+#define MIN_DEFLATE_WINDOW_BITS 9
+#define DEFLATE_MEM_LEVEL 8
+#define MIN_OUTPUT_BUFFER_SIZE 256
+#define MAX_OFFER_LENGTH 128
+
+/* every message sent with Z_SYNC_FLUSH ends with an empty stored block, which is not put on the wire */
+static const unsigned char deflate_trailer[] = { 0x00, 0x00, 0xFF, 0xFF };
+
+typedef struct OUTPUT_BUFFER_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    size_t count;
+} OUTPUT_BUFFER;
+
+typedef struct UWS_PERMESSAGE_DEFLATE_INSTANCE_TAG
+{
+    UWS_PERMESSAGE_DEFLATE_CONFIG config;
+    char offer[MAX_OFFER_LENGTH];
+    bool is_negotiated;
+    bool client_no_context_takeover;
+    bool server_no_context_takeover;
+    z_stream deflate_stream;
+    z_stream inflate_stream;
+    OUTPUT_BUFFER compressed;
+    OUTPUT_BUFFER decompressed;
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+} UWS_PERMESSAGE_DEFLATE_INSTANCE;
+
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    (void)opaque;
+    return malloc((size_t)items * size);
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    free(address);
+}
+
+static uint64_t get_elapsed_us(clock_t start)
+{
+    clock_t end = clock();
+    uint64_t result;
+
+    if ((start == (clock_t)-1) ||
+        (end == (clock_t)-1) ||
+        (end < start))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (uint64_t)(end - start) * 1000000 / CLOCKS_PER_SEC;
+    }
+
+    return result;
+}
+
+static int ensure_output_space(OUTPUT_BUFFER* output_buffer, size_t minimum_size)
+{
+    int result;
+
+    if (output_buffer->count < output_buffer->size)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_size = (output_buffer->size == 0) ? minimum_size : output_buffer->size * 2;
+        unsigned char* new_bytes;
+
+        if (new_size < MIN_OUTPUT_BUFFER_SIZE)
+        {
+            new_size = MIN_OUTPUT_BUFFER_SIZE;
+        }
+
+        if ((new_size <= output_buffer->size) ||
+            ((new_bytes = (unsigned char*)realloc(output_buffer->bytes, new_size)) == NULL))
+        {
+            LogError("Cannot grow the permessage-deflate output buffer to %u bytes", (unsigned int)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            output_buffer->bytes = new_bytes;
+            output_buffer->size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void end_streams(UWS_PERMESSAGE_DEFLATE_INSTANCE* permessage_deflate)
+{
+    if (permessage_deflate->is_negotiated)
+    {
+        (void)deflateEnd(&permessage_deflate->deflate_stream);
+        (void)inflateEnd(&permessage_deflate->inflate_stream);
+        permessage_deflate->is_negotiated = false;
+    }
+}
+
+static int run_deflate(UWS_PERMESSAGE_DEFLATE_INSTANCE* permessage_deflate, const unsigned char* bytes, size_t size)
+{
+    int result = 0;
+    z_stream* stream = &permessage_deflate->deflate_stream;
+    OUTPUT_BUFFER* output_buffer = &permessage_deflate->compressed;
+
+    do
+    {
+        int zlib_result;
+
+        if ((stream->avail_in == 0) && (size > 0))
+        {
+            uInt chunk_size = (size > UINT_MAX) ? UINT_MAX : (uInt)size;
+            stream->next_in = (Bytef*)bytes;
+            stream->avail_in = chunk_size;
+            bytes += chunk_size;
+            size -= chunk_size;
+        }
+
+        if (ensure_output_space(output_buffer, size + stream->avail_in + sizeof(deflate_trailer)) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        stream->next_out = output_buffer->bytes + output_buffer->count;
+        stream->avail_out = (output_buffer->size - output_buffer->count > UINT_MAX) ? UINT_MAX : (uInt)(output_buffer->size - output_buffer->count);
+
+        zlib_result = deflate(stream, Z_SYNC_FLUSH);
+        output_buffer->count = (size_t)(stream->next_out - output_buffer->bytes);
+
+        if ((zlib_result != Z_OK) &&
+            (zlib_result != Z_BUF_ERROR))
+        {
+            LogError("deflate failed with %d", zlib_result);
+            result = __FAILURE__;
+            break;
+        }
+    /* with Z_SYNC_FLUSH all output has been produced once deflate leaves room in the output buffer */
+    } while ((stream->avail_out == 0) || (stream->avail_in > 0) || (size > 0));
+
+    return result;
+}
+
+static int run_inflate(UWS_PERMESSAGE_DEFLATE_INSTANCE* permessage_deflate, const unsigned char* bytes, size_t size)
+{
+    int result = 0;
+    z_stream* stream = &permessage_deflate->inflate_stream;
+    OUTPUT_BUFFER* output_buffer = &permessage_deflate->decompressed;
+
+    do
+    {
+        int zlib_result;
+
+        if ((stream->avail_in == 0) && (size > 0))
+        {
+            uInt chunk_size = (size > UINT_MAX) ? UINT_MAX : (uInt)size;
+            stream->next_in = (Bytef*)bytes;
+            stream->avail_in = chunk_size;
+            bytes += chunk_size;
+            size -= chunk_size;
+        }
+
+        if (ensure_output_space(output_buffer, (size + stream->avail_in) * 4) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        stream->next_out = output_buffer->bytes + output_buffer->count;
+        stream->avail_out = (output_buffer->size - output_buffer->count > UINT_MAX) ? UINT_MAX : (uInt)(output_buffer->size - output_buffer->count);
+
+        zlib_result = inflate(stream, Z_SYNC_FLUSH);
+        output_buffer->count = (size_t)(stream->next_out - output_buffer->bytes);
+
+        if (zlib_result == Z_STREAM_END)
+        {
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_041: [ If the peer ended the DEFLATE stream with a final block, the inflate context shall be reset with `inflateReset` and the remaining bytes shall be decompressed as a new stream. ]*/
+            (void)inflateReset(stream);
+        }
+        else if (zlib_result == Z_BUF_ERROR)
+        {
+            if (stream->avail_out > 0)
+            {
+                /* no progress is possible, the rest of the message is in the next frames */
+                break;
+            }
+        }
+        else if (zlib_result != Z_OK)
+        {
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_042: [ If `inflate` fails, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+            LogError("inflate failed with %d", zlib_result);
+            result = __FAILURE__;
+            break;
+        }
+    } while ((stream->avail_out == 0) || (stream->avail_in > 0) || (size > 0));
+
+    return result;
+}
+
+static const char* skip_whitespace(const char* value)
+{
+    while ((*value == ' ') || (*value == '\t'))
+    {
+        value++;
+    }
+
+    return value;
+}
+
+static size_t get_token_length(const char* value)
+{
+    size_t result = 0;
+
+    while ((value[result] != '\0') &&
+        (value[result] != ' ') &&
+        (value[result] != '\t') &&
+        (value[result] != ';') &&
+        (value[result] != ',') &&
+        (value[result] != '='))
+    {
+        result++;
+    }
+
+    return result;
+}
+
+static bool is_token(const char* value, size_t length, const char* token)
+{
+    return (strlen(token) == length) && (memcmp(value, token, length) == 0);
+}
+
+static int parse_window_bits(const char** value, int* window_bits)
+{
+    int result;
+    const char* current = skip_whitespace(*value);
+    bool is_quoted = false;
+
+    if (*current != '=')
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        int parsed_value = 0;
+        size_t digit_count = 0;
+
+        current = skip_whitespace(current + 1);
+        if (*current == '"')
+        {
+            is_quoted = true;
+            current++;
+        }
+
+        while ((*current >= '0') && (*current <= '9') && (digit_count < 3))
+        {
+            parsed_value = (parsed_value * 10) + (*current - '0');
+            digit_count++;
+            current++;
+        }
+
+        if (is_quoted)
+        {
+            if (*current == '"')
+            {
+                current++;
+            }
+            else
+            {
+                digit_count = 0;
+            }
+        }
+
+        if ((digit_count == 0) ||
+            (parsed_value < MIN_WINDOW_BITS) ||
+            (parsed_value > MAX_WINDOW_BITS))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            *window_bits = parsed_value;
+            *value = current;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+UWS_PERMESSAGE_DEFLATE_HANDLE uws_permessage_deflate_create(const UWS_PERMESSAGE_DEFLATE_CONFIG* config)
+{
+    UWS_PERMESSAGE_DEFLATE_INSTANCE* result;
+
+    if (config == NULL)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_002: [ If `config` is NULL, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+        LogError("NULL config");
+        result = NULL;
+    }
+    else if (((config->server_max_window_bits != 0) && ((config->server_max_window_bits < MIN_WINDOW_BITS) || (config->server_max_window_bits > MAX_WINDOW_BITS))) ||
+        (config->compression_level < 0) ||
+        (config->compression_level > 9))
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_003: [ If `server_max_window_bits` is not 0 and not between 8 and 15, or `compression_level` is not between 0 and 9, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+        LogError("Invalid permessage-deflate config: server_max_window_bits=%d, compression_level=%d", config->server_max_window_bits, config->compression_level);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_001: [ `uws_permessage_deflate_create` shall allocate a new permessage-deflate instance and on success return a non-NULL handle to it. ]*/
+        result = (UWS_PERMESSAGE_DEFLATE_INSTANCE*)malloc(sizeof(UWS_PERMESSAGE_DEFLATE_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_004: [ If allocating memory fails, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the permessage-deflate instance");
+        }
+        else
+        {
+            int offer_length;
+
+            (void)memset(result, 0, sizeof(UWS_PERMESSAGE_DEFLATE_INSTANCE));
+            result->config = *config;
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_005: [ `uws_permessage_deflate_create` shall build the extension offer `permessage-deflate; client_max_window_bits`, followed by `; client_no_context_takeover` and `; server_no_context_takeover` when the matching config flags are set and by `; server_max_window_bits=N` when `server_max_window_bits` is not 0. ]*/
+            offer_length = snprintf(result->offer, sizeof(result->offer), "%s; client_max_window_bits%s%s",
+                PERMESSAGE_DEFLATE_EXTENSION_NAME,
+                config->client_no_context_takeover ? "; client_no_context_takeover" : "",
+                config->server_no_context_takeover ? "; server_no_context_takeover" : "");
+            if ((offer_length > 0) &&
+                ((size_t)offer_length < sizeof(result->offer)) &&
+                (config->server_max_window_bits != 0))
+            {
+                (void)snprintf(result->offer + offer_length, sizeof(result->offer) - (size_t)offer_length, "; server_max_window_bits=%d", config->server_max_window_bits);
+            }
+        }
+    }
+
+    return result;
+}
+
+void uws_permessage_deflate_destroy(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate)
+{
+    if (permessage_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_007: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_destroy` shall do nothing. ]*/
+        LogError("NULL permessage_deflate");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_006: [ `uws_permessage_deflate_destroy` shall end the zlib contexts, if any, and free all resources of the instance. ]*/
+        end_streams(permessage_deflate);
+        free(permessage_deflate->compressed.bytes);
+        free(permessage_deflate->decompressed.bytes);
+        free(permessage_deflate);
+    }
+}
+
+const char* uws_permessage_deflate_get_offer(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate)
+{
+    const char* result;
+
+    if (permessage_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_009: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_get_offer` shall return NULL. ]*/
+        LogError("NULL permessage_deflate");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_008: [ `uws_permessage_deflate_get_offer` shall return the extension offer to be sent in the `Sec-WebSocket-Extensions` header of the upgrade request. ]*/
+        result = permessage_deflate->offer;
+    }
+
+    return result;
+}
+
+int uws_permessage_deflate_accept_response(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, const char* extensions)
+{
+    int result;
+
+    if ((permessage_deflate == NULL) ||
+        (extensions == NULL))
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_011: [ If `permessage_deflate` or `extensions` is NULL, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: permessage_deflate=%p, extensions=%p", permessage_deflate, extensions);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const char* current = skip_whitespace(extensions);
+        bool is_accepted = false;
+        bool client_no_context_takeover = permessage_deflate->config.client_no_context_takeover;
+        bool server_no_context_takeover = false;
+        int client_max_window_bits = MAX_WINDOW_BITS;
+        int server_max_window_bits = MAX_WINDOW_BITS;
+
+        end_streams(permessage_deflate);
+        result = 0;
+
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_010: [ `uws_permessage_deflate_accept_response` shall parse `extensions`, the value of the `Sec-WebSocket-Extensions` header of the upgrade response, as a comma separated list of extensions with semicolon separated parameters. ]*/
+        while ((result == 0) && (*current != '\0'))
+        {
+            size_t token_length = get_token_length(current);
+
+            if ((token_length == 0) && (*current == ','))
+            {
+                current = skip_whitespace(current + 1);
+            }
+            else if (!is_token(current, token_length, PERMESSAGE_DEFLATE_EXTENSION_NAME) || is_accepted)
+            {
+                /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_012: [ If the response contains any extension other than a single `permessage-deflate`, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+                LogError("Server accepted an extension that was not offered: %.*s", (int)token_length, current);
+                result = __FAILURE__;
+            }
+            else
+            {
+                is_accepted = true;
+                current = skip_whitespace(current + token_length);
+
+                while ((result == 0) && (*current == ';'))
+                {
+                    current = skip_whitespace(current + 1);
+                    token_length = get_token_length(current);
+
+                    if (is_token(current, token_length, "server_no_context_takeover"))
+                    {
+                        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_013: [ `server_no_context_takeover` shall make the inflate context be reset after each received message. ]*/
+                        server_no_context_takeover = true;
+                        current += token_length;
+                    }
+                    else if (is_token(current, token_length, "client_no_context_takeover"))
+                    {
+                        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_014: [ `client_no_context_takeover` shall make the deflate context be reset after each sent message. ]*/
+                        client_no_context_takeover = true;
+                        current += token_length;
+                    }
+                    else if (is_token(current, token_length, "server_max_window_bits"))
+                    {
+                        current += token_length;
+
+                        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_015: [ `server_max_window_bits` shall have a value between 8 and 15, not bigger than the one offered, if any, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+                        if ((parse_window_bits(&current, &server_max_window_bits) != 0) ||
+                            ((permessage_deflate->config.server_max_window_bits != 0) && (server_max_window_bits > permessage_deflate->config.server_max_window_bits)))
+                        {
+                            LogError("Invalid server_max_window_bits in the permessage-deflate response");
+                            result = __FAILURE__;
+                        }
+                    }
+                    else if (is_token(current, token_length, "client_max_window_bits"))
+                    {
+                        current += token_length;
+
+                        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_016: [ `client_max_window_bits` shall have a value between 9 and 15, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+                        if ((parse_window_bits(&current, &client_max_window_bits) != 0) ||
+                            (client_max_window_bits < MIN_DEFLATE_WINDOW_BITS))
+                        {
+                            LogError("Invalid or unsupported client_max_window_bits in the permessage-deflate response");
+                            result = __FAILURE__;
+                        }
+                    }
+                    else
+                    {
+                        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_017: [ If the response contains an unknown parameter, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+                        LogError("Unknown permessage-deflate parameter: %.*s", (int)token_length, current);
+                        result = __FAILURE__;
+                    }
+
+                    current = skip_whitespace(current);
+                }
+
+                if ((result == 0) &&
+                    (*current != '\0') &&
+                    (*current != ','))
+                {
+                    LogError("Cannot parse the permessage-deflate response: %s", current);
+                    result = __FAILURE__;
+                }
+            }
+        }
+
+        if ((result == 0) && is_accepted)
+        {
+            z_stream* deflate_stream = &permessage_deflate->deflate_stream;
+            z_stream* inflate_stream = &permessage_deflate->inflate_stream;
+            int compression_level = (permessage_deflate->config.compression_level == 0) ? Z_DEFAULT_COMPRESSION : permessage_deflate->config.compression_level;
+
+            (void)memset(deflate_stream, 0, sizeof(z_stream));
+            deflate_stream->zalloc = zlib_alloc;
+            deflate_stream->zfree = zlib_free;
+            (void)memset(inflate_stream, 0, sizeof(z_stream));
+            inflate_stream->zalloc = zlib_alloc;
+            inflate_stream->zfree = zlib_free;
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_018: [ When `permessage-deflate` was accepted, `uws_permessage_deflate_accept_response` shall create a raw deflate context with `deflateInit2` and a window of `client_max_window_bits` and a raw inflate context with `inflateInit2`. ]*/
+            /* a bigger inflate window decodes any stream made with a smaller one, and zlib makes 9 bit streams when asked for 8 */
+            if (deflateInit2(deflate_stream, compression_level, Z_DEFLATED, -client_max_window_bits, DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_019: [ If creating any of the zlib contexts fails, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+                LogError("deflateInit2 failed");
+                result = __FAILURE__;
+            }
+            else if (inflateInit2(inflate_stream, -((server_max_window_bits < MIN_DEFLATE_WINDOW_BITS) ? MIN_DEFLATE_WINDOW_BITS : server_max_window_bits)) != Z_OK)
+            {
+                LogError("inflateInit2 failed");
+                (void)deflateEnd(deflate_stream);
+                result = __FAILURE__;
+            }
+            else
+            {
+                permessage_deflate->client_no_context_takeover = client_no_context_takeover;
+                permessage_deflate->server_no_context_takeover = server_no_context_takeover;
+                permessage_deflate->is_negotiated = true;
+            }
+        }
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_020: [ If `extensions` does not contain any extension, `uws_permessage_deflate_accept_response` shall succeed and leave the extension not negotiated. ]*/
+    }
+
+    return result;
+}
+
+void uws_permessage_deflate_reset(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate)
+{
+    if (permessage_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_022: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_reset` shall do nothing. ]*/
+        LogError("NULL permessage_deflate");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_021: [ `uws_permessage_deflate_reset` shall end the zlib contexts, if any, and mark the extension as not negotiated. ]*/
+        end_streams(permessage_deflate);
+    }
+}
+
+bool uws_permessage_deflate_is_negotiated(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate)
+{
+    /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_023: [ `uws_permessage_deflate_is_negotiated` shall return true if `permessage_deflate` is not NULL and the server accepted the extension. ]*/
+    return (permessage_deflate != NULL) && permessage_deflate->is_negotiated;
+}
+
+bool uws_permessage_deflate_should_compress(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, size_t size, bool is_final)
+{
+    /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_024: [ `uws_permessage_deflate_should_compress` shall return true if the extension is negotiated and the first frame of a message is not final or carries at least `min_compressed_message_size` bytes. ]*/
+    return uws_permessage_deflate_is_negotiated(permessage_deflate) &&
+        (!is_final || (size >= permessage_deflate->config.min_compressed_message_size));
+}
+
+int uws_permessage_deflate_compress(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** compressed_payload, size_t* compressed_size)
+{
+    int result;
+
+    if ((permessage_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (compressed_payload == NULL) ||
+        (compressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_026: [ If `permessage_deflate`, `compressed_payload` or `compressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: permessage_deflate=%p, payload=%p, size=%u, compressed_payload=%p, compressed_size=%p",
+            permessage_deflate, payload, (unsigned int)size, compressed_payload, compressed_size);
+        result = __FAILURE__;
+    }
+    else if (!permessage_deflate->is_negotiated)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_027: [ If the extension is not negotiated, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+        LogError("permessage-deflate was not negotiated");
+        result = __FAILURE__;
+    }
+    else
+    {
+        clock_t start = clock();
+
+        permessage_deflate->compressed.count = 0;
+
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_025: [ `uws_permessage_deflate_compress` shall compress `payload` with `deflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which stays valid until the next call. ]*/
+        if (run_deflate(permessage_deflate, payload, size) != 0)
+        {
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_028: [ If `deflate` fails or the output buffer cannot be grown, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (is_final)
+            {
+                /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_029: [ For the final frame of a message the trailing `0x00 0x00 0xFF 0xFF` bytes shall be removed from the compressed payload. ]*/
+                if ((permessage_deflate->compressed.count >= sizeof(deflate_trailer)) &&
+                    (memcmp(permessage_deflate->compressed.bytes + permessage_deflate->compressed.count - sizeof(deflate_trailer), deflate_trailer, sizeof(deflate_trailer)) == 0))
+                {
+                    permessage_deflate->compressed.count -= sizeof(deflate_trailer);
+                }
+
+                /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_045: [ If the final frame would carry no compressed bytes, a single `0x00` byte shall be sent so that the receiver can append the trailing bytes to it. ]*/
+                /* deflate produces no output for a flush right after another flush */
+                if (permessage_deflate->compressed.count == 0)
+                {
+                    permessage_deflate->compressed.bytes[0] = 0x00;
+                    permessage_deflate->compressed.count = 1;
+                }
+
+                /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_030: [ If `client_no_context_takeover` is in effect, the deflate context shall be reset with `deflateReset` after the final frame of a message. ]*/
+                if (permessage_deflate->client_no_context_takeover)
+                {
+                    (void)deflateReset(&permessage_deflate->deflate_stream);
+                }
+            }
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_031: [ `uws_permessage_deflate_compress` shall add `size` and the compressed size to the sent byte counters and the processor time spent to `compress_time_us`. ]*/
+            permessage_deflate->statistics.sent_uncompressed_bytes += size;
+            permessage_deflate->statistics.sent_compressed_bytes += permessage_deflate->compressed.count;
+            permessage_deflate->statistics.compress_time_us += get_elapsed_us(start);
+
+            *compressed_payload = permessage_deflate->compressed.bytes;
+            *compressed_size = permessage_deflate->compressed.count;
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_032: [ On success, `uws_permessage_deflate_compress` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int uws_permessage_deflate_decompress(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** decompressed_payload, size_t* decompressed_size)
+{
+    int result;
+
+    if ((permessage_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (decompressed_payload == NULL) ||
+        (decompressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_034: [ If `permessage_deflate`, `decompressed_payload` or `decompressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: permessage_deflate=%p, payload=%p, size=%u, decompressed_payload=%p, decompressed_size=%p",
+            permessage_deflate, payload, (unsigned int)size, decompressed_payload, decompressed_size);
+        result = __FAILURE__;
+    }
+    else if (!permessage_deflate->is_negotiated)
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_035: [ If the extension is not negotiated, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+        LogError("permessage-deflate was not negotiated");
+        result = __FAILURE__;
+    }
+    else
+    {
+        clock_t start = clock();
+
+        permessage_deflate->decompressed.count = 0;
+
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_033: [ `uws_permessage_deflate_decompress` shall decompress `payload` with `inflate` into a buffer owned by the instance, which stays valid until the next call. ]*/
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_036: [ For the final frame of a message the bytes `0x00 0x00 0xFF 0xFF` shall be decompressed after `payload`. ]*/
+        if ((run_inflate(permessage_deflate, payload, size) != 0) ||
+            (is_final && (run_inflate(permessage_deflate, deflate_trailer, sizeof(deflate_trailer)) != 0)))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_037: [ If `server_no_context_takeover` is in effect, the inflate context shall be reset with `inflateReset` after the final frame of a message. ]*/
+            if (is_final && permessage_deflate->server_no_context_takeover)
+            {
+                (void)inflateReset(&permessage_deflate->inflate_stream);
+            }
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_038: [ `uws_permessage_deflate_decompress` shall add `size` and the decompressed size to the received byte counters and the processor time spent to `decompress_time_us`. ]*/
+            permessage_deflate->statistics.received_compressed_bytes += size;
+            permessage_deflate->statistics.received_uncompressed_bytes += permessage_deflate->decompressed.count;
+            permessage_deflate->statistics.decompress_time_us += get_elapsed_us(start);
+
+            *decompressed_payload = permessage_deflate->decompressed.bytes;
+            *decompressed_size = permessage_deflate->decompressed.count;
+
+            /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_039: [ On success, `uws_permessage_deflate_decompress` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int uws_permessage_deflate_get_statistics(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, UWS_PERMESSAGE_DEFLATE_STATISTICS* statistics)
+{
+    int result;
+
+    if ((permessage_deflate == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_044: [ If `permessage_deflate` or `statistics` is NULL, `uws_permessage_deflate_get_statistics` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: permessage_deflate=%p, statistics=%p", permessage_deflate, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_PERMESSAGE_DEFLATE_01_043: [ `uws_permessage_deflate_get_statistics` shall copy the counters accumulated since the instance was created to `statistics` and return 0. ]*/
+        *statistics = permessage_deflate->statistics;
+        result = 0;
+    }
+
+    return result;
+}
@@ -403,6 +403,16 @@ static void on_underlying_ws_frame_received(void* context, unsigned char frame_t
     }
 }
 
+static void on_underlying_ws_fragment_received(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size, uint64_t message_offset, bool is_final)
+{
+    /* Codes_SRS_WSIO_01_189: [ The `message_offset` and `is_final` arguments shall be ignored, the IO being a byte stream. ]*/
+    (void)message_offset;
+    (void)is_final;
+
+    /* Codes_SRS_WSIO_01_188: [ Each slice indicated by `on_underlying_ws_fragment_received` shall be handled exactly as a frame indicated by `on_underlying_ws_frame_received`. ]*/
+    on_underlying_ws_frame_received(context, frame_type, buffer, size);
+}
+
 static void on_underlying_ws_peer_closed(void* context, uint16_t* close_code, const unsigned char* extra_data, size_t extra_data_length)
 {
     /* Codes_SRS_WSIO_01_168: [ The `close_code`, `extra_data` and `extra_data_length` arguments shall be ignored. ]*/
@@ -509,8 +519,16 @@ int wsio_open(CONCRETE_IO_HANDLE ws_io, ON_IO_OPEN_COMPLETE on_io_open_complete,
 
             wsio_instance->io_state = IO_STATE_OPENING;
 
+            /* Codes_SRS_WSIO_01_187: [ Before opening the uws instance, `wsio_open` shall call `uws_client_set_fragment_received_callback` so that received bytes are indicated as they arrive instead of once per WebSocket message. ]*/
+            if (uws_client_set_fragment_received_callback(wsio_instance->uws, on_underlying_ws_fragment_received, wsio_instance) != 0)
+            {
+                /* Codes_SRS_WSIO_01_190: [ If `uws_client_set_fragment_received_callback` fails, `wsio_open` shall fail and return a non-zero value. ]*/
+                LogError("Setting the fragment received callback failed.");
+                wsio_instance->io_state = IO_STATE_NOT_OPEN;
+                result = __FAILURE__;
+            }
             /* Codes_SRS_WSIO_01_082: [ `wsio_open` shall open the underlying uws instance by calling `uws_client_open_async` and providing the uws handle created in `wsio_create` as argument. ] */
-            if (uws_client_open_async(wsio_instance->uws, on_underlying_ws_open_complete, wsio_instance, on_underlying_ws_frame_received, wsio_instance, on_underlying_ws_peer_closed, wsio_instance, on_underlying_ws_error, wsio_instance) != 0)
+            else if (uws_client_open_async(wsio_instance->uws, on_underlying_ws_open_complete, wsio_instance, on_underlying_ws_frame_received, wsio_instance, on_underlying_ws_peer_closed, wsio_instance, on_underlying_ws_error, wsio_instance) != 0)
             {
                 /* Codes_SRS_WSIO_01_084: [ If opening the underlying uws instance fails then `wsio_open` shall fail and return a non-zero value. ]*/
                 LogError("Opening the uws instance failed.");
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xio.h"
@@ -30,6 +31,7 @@ XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description,
         (io_interface_description->concrete_io_send == NULL) ||
         (io_interface_description->concrete_io_dowork == NULL) ||
         (io_interface_description->concrete_io_setoption == NULL))
+        /* concrete_io_send_vectored is optional */
     {
         xio_instance = NULL;
     }
@@ -154,6 +156,82 @@ int xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE o
     return result;
 }
 
+int xio_send_vectored(XIO_HANDLE xio, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_028: [ If xio is NULL, xio_send_vectored shall return a non-zero value. ]*/
+    /* Codes_SRS_XIO_01_029: [ If buffers is NULL or buffer_count is 0, xio_send_vectored shall return a non-zero value. ]*/
+    if ((xio == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        LogError("Invalid arguments: xio = %p, buffers = %p, buffer_count = %lu", xio, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        if (xio_instance->io_interface_description->concrete_io_send_vectored != NULL)
+        {
+            /* Codes_SRS_XIO_01_037: [ On success, xio_send_vectored shall return 0. ]*/
+            /* Codes_SRS_XIO_01_030: [ If the concrete IO implements concrete_io_send_vectored, xio_send_vectored shall pass buffers, buffer_count, on_send_complete and callback_context to it. ]*/
+            /* Codes_SRS_XIO_01_031: [ If concrete_io_send_vectored fails, xio_send_vectored shall return a non-zero value. ]*/
+            result = xio_instance->io_interface_description->concrete_io_send_vectored(xio_instance->concrete_xio_handle, buffers, buffer_count, on_send_complete, callback_context);
+        }
+        else
+        {
+            size_t total_size = 0;
+            size_t i;
+
+            for (i = 0; i < buffer_count; i++)
+            {
+                total_size += buffers[i].size;
+            }
+
+            if (total_size == 0)
+            {
+                /* Codes_SRS_XIO_01_033: [ If the concrete IO does not implement concrete_io_send_vectored and all buffers are empty, xio_send_vectored shall return a non-zero value. ]*/
+                LogError("Invalid arguments: all buffers are empty");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_XIO_01_032: [ Otherwise xio_send_vectored shall concatenate the buffers into one allocated buffer and pass it to concrete_io_send. ]*/
+                unsigned char* bytes = (unsigned char*)malloc(total_size);
+                if (bytes == NULL)
+                {
+                    /* Codes_SRS_XIO_01_034: [ If allocating the concatenated buffer fails, xio_send_vectored shall return a non-zero value. ]*/
+                    LogError("Failed allocating %lu bytes for the concatenated send", (unsigned long)total_size);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    size_t offset = 0;
+
+                    for (i = 0; i < buffer_count; i++)
+                    {
+                        if (buffers[i].size > 0)
+                        {
+                            (void)memcpy(bytes + offset, buffers[i].buffer, buffers[i].size);
+                            offset += buffers[i].size;
+                        }
+                    }
+
+                    /* Codes_SRS_XIO_01_035: [ If concrete_io_send fails, xio_send_vectored shall return a non-zero value. ]*/
+                    result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, bytes, total_size, on_send_complete, callback_context);
+
+                    /* Codes_SRS_XIO_01_036: [ The concatenated buffer shall be freed once concrete_io_send returns. ]*/
+                    free(bytes);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
 void xio_dowork(XIO_HANDLE xio)
 {
     /* Codes_SRS_XIO_01_018: [When the handle argument is NULL, xio_dowork shall do nothing.] */
@@ -1471,6 +1471,30 @@ static const struct
 
     static TEST_MUTEX_HANDLE g_testByTest;
 
+/*plain bit by bit encoder used to check the vectorized paths on inputs longer than the test vectors*/
+static void reference_encode(const unsigned char* source, size_t size, char* destination)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+    for (i = 0; i < size; i += 3)
+    {
+        unsigned long group = (unsigned long)source[i] << 16;
+        if (i + 1 < size)
+        {
+            group |= (unsigned long)source[i + 1] << 8;
+        }
+        if (i + 2 < size)
+        {
+            group |= source[i + 2];
+        }
+        *destination++ = alphabet[(group >> 18) & 0x3F];
+        *destination++ = alphabet[(group >> 12) & 0x3F];
+        *destination++ = (i + 1 < size) ? alphabet[(group >> 6) & 0x3F] : '=';
+        *destination++ = (i + 2 < size) ? alphabet[group & 0x3F] : '=';
+    }
+    *destination = '\0';
+}
+
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
@@ -1803,4 +1827,299 @@ TEST_FUNCTION(Base64_Decoder_invalid_length_fails_6)
 }
 
 
+/*Tests_SRS_BASE64_01_001: [ If source is NULL and size is not zero, or destination is NULL, or encoded_length is NULL, Base64_Encode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_Into_with_NULL_source_fails)
+{
+    ///arrange
+    char destination[16];
+    size_t encoded_length;
+    int result;
+
+    ///act
+    result = Base64_Encode_Into(NULL, 1, destination, sizeof(destination), &encoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_001: [ If source is NULL and size is not zero, or destination is NULL, or encoded_length is NULL, Base64_Encode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_Into_with_NULL_destination_fails)
+{
+    ///arrange
+    size_t encoded_length;
+    int result;
+
+    ///act
+    result = Base64_Encode_Into((const unsigned char*)"a", 1, NULL, 16, &encoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_001: [ If source is NULL and size is not zero, or destination is NULL, or encoded_length is NULL, Base64_Encode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_Into_with_NULL_encoded_length_fails)
+{
+    ///arrange
+    char destination[16];
+    int result;
+
+    ///act
+    result = Base64_Encode_Into((const unsigned char*)"a", 1, destination, sizeof(destination), NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_002: [ If destination_size is less than 4 * ((size + 2) / 3) + 1 then Base64_Encode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_Into_with_destination_too_small_fails)
+{
+    ///arrange
+    char destination[16];
+    size_t encoded_length;
+    int result;
+
+    ///act
+    result = Base64_Encode_Into((const unsigned char*)"abcd", 4, destination, 8, &encoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_003: [ Otherwise Base64_Encode_Into shall write the padded base64 encoding of source followed by a null terminator to destination, set *encoded_length to the number of characters written (without the terminator) and return 0. ]*/
+TEST_FUNCTION(Base64_Encode_Into_with_zero_size_produces_empty_string)
+{
+    ///arrange
+    char destination[1] = { 'x' };
+    size_t encoded_length = 42;
+    int result;
+
+    ///act
+    result = Base64_Encode_Into(NULL, 0, destination, sizeof(destination), &encoded_length);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, encoded_length);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/*Tests_SRS_BASE64_01_003: [ Otherwise Base64_Encode_Into shall write the padded base64 encoding of source followed by a null terminator to destination, set *encoded_length to the number of characters written (without the terminator) and return 0. ]*/
+TEST_FUNCTION(Base64_Encode_Into_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        char destination[32];
+        size_t expectedLength = strlen(testVector_BINARY_with_equal_signs[i].expectedOutput);
+        size_t encoded_length;
+        int result;
+
+        ///act
+        result = Base64_Encode_Into(testVector_BINARY_with_equal_signs[i].inputData, testVector_BINARY_with_equal_signs[i].inputLength, destination, expectedLength + 1, &encoded_length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, expectedLength, encoded_length);
+        ASSERT_ARE_EQUAL(char_ptr, testVector_BINARY_with_equal_signs[i].expectedOutput, destination);
+    }
+}
+
+/*Tests_SRS_BASE64_01_003: [ Otherwise Base64_Encode_Into shall write the padded base64 encoding of source followed by a null terminator to destination, set *encoded_length to the number of characters written (without the terminator) and return 0. ]*/
+/*Tests_SRS_BASE64_01_009: [ Otherwise Base64_Decode_Into shall write the decoded bytes to destination, set *decoded_length to their number and return 0. ]*/
+TEST_FUNCTION(Base64_Encode_Into_and_Decode_Into_long_inputs_round_trip)
+{
+    unsigned char source[300];
+    char expected[401];
+    char encoded[401];
+    unsigned char decoded[300];
+    size_t size;
+    size_t i;
+
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 167 + 13);
+    }
+
+    /*every length up to 300 goes through the vectorized loops and all of their tails*/
+    for (size = 0; size <= sizeof(source); size++)
+    {
+        ///arrange
+        size_t encoded_length;
+        size_t decoded_length;
+        int result;
+        reference_encode(source, size, expected);
+
+        ///act
+        result = Base64_Encode_Into(source, size, encoded, sizeof(encoded), &encoded_length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, expected, encoded);
+
+        ///act
+        result = Base64_Decode_Into(encoded, encoded_length, decoded, sizeof(decoded), &decoded_length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, size, decoded_length);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(decoded, source, size));
+    }
+}
+
+/*Tests_SRS_BASE64_01_004: [ If source is NULL and source_length is not zero, or destination is NULL, or decoded_length is NULL, Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_NULL_source_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into(NULL, 4, destination, sizeof(destination), &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_004: [ If source is NULL and source_length is not zero, or destination is NULL, or decoded_length is NULL, Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_NULL_destination_fails)
+{
+    ///arrange
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QUJD", 4, NULL, 16, &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_004: [ If source is NULL and source_length is not zero, or destination is NULL, or decoded_length is NULL, Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_NULL_decoded_length_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QUJD", 4, destination, sizeof(destination), NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_005: [ If source_length is not a multiple of 4 then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_invalid_length_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QUJDR", 5, destination, sizeof(destination), &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_006: [ Up to two = characters are accepted as padding at the end of source. ]*/
+/*Tests_SRS_BASE64_01_009: [ Otherwise Base64_Decode_Into shall write the decoded bytes to destination, set *decoded_length to their number and return 0. ]*/
+TEST_FUNCTION(Base64_Decode_Into_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        unsigned char destination[32];
+        size_t decoded_length;
+        int result;
+
+        ///act
+        result = Base64_Decode_Into(testVector_BINARY_with_equal_signs[i].expectedOutput, strlen(testVector_BINARY_with_equal_signs[i].expectedOutput),
+            destination, testVector_BINARY_with_equal_signs[i].inputLength, &decoded_length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, testVector_BINARY_with_equal_signs[i].inputLength, decoded_length);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, testVector_BINARY_with_equal_signs[i].inputData, decoded_length));
+    }
+}
+
+/*Tests_SRS_BASE64_01_006: [ Up to two = characters are accepted as padding at the end of source. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_three_padding_characters_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QUJDQ===", 8, destination, sizeof(destination), &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_007: [ If any of the other characters in source is not part of the base64 alphabet then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_padding_in_the_middle_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QU==QUJD", 8, destination, sizeof(destination), &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_007: [ If any of the other characters in source is not part of the base64 alphabet then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_invalid_character_in_long_input_fails)
+{
+    char encoded[401];
+    unsigned char decoded[300];
+    size_t position;
+
+    (void)memset(encoded, 'A', 400);
+    encoded[400] = '\0';
+
+    /*the bad character is found by the vectorized loops as well as by the tail*/
+    for (position = 0; position < 400; position += 7)
+    {
+        ///arrange
+        size_t decoded_length;
+        int result;
+        encoded[position] = '*';
+
+        ///act
+        result = Base64_Decode_Into(encoded, 400, decoded, sizeof(decoded), &decoded_length);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+        ///cleanup
+        encoded[position] = 'A';
+    }
+}
+
+/*Tests_SRS_BASE64_01_008: [ If destination_size is less than the number of decoded bytes then Base64_Decode_Into shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_Into_with_destination_too_small_fails)
+{
+    ///arrange
+    unsigned char destination[16];
+    size_t decoded_length;
+    int result;
+
+    ///act
+    result = Base64_Decode_Into("QUJDRA==", 8, destination, 3, &decoded_length);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+
 END_TEST_SUITE(base64_unittests);
@@ -574,6 +574,7 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
     }
 
     /* Tests_SRS_BUFFER_07_011: [BUFFER_build shall overwrite previous contents if the buffer has been previously allocated.] */
+    /* Tests_SRS_BUFFER_01_010: [ If the memory already held by the buffer is large enough, BUFFER_build shall reuse it. ]*/
     TEST_FUNCTION(BUFFER_build_when_the_buffer_is_already_allocated_and_the_same_amount_of_bytes_is_needed_succeeds)
     {
         ///arrange
@@ -583,9 +584,6 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         nResult = BUFFER_build(g_hBuffer, BUFFER_TEST_VALUE, ALLOCATION_SIZE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, ALLOCATION_SIZE))
-            .IgnoreArgument(1);
-
         ///act
         nResult = BUFFER_build(g_hBuffer, BUFFER_TEST_VALUE, ALLOCATION_SIZE);
 
@@ -622,6 +620,7 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
     }
 
     /* Tests_SRS_BUFFER_07_011: [BUFFER_build shall overwrite previous contents if the buffer has been previously allocated.] */
+    /* Tests_SRS_BUFFER_01_010: [ If the memory already held by the buffer is large enough, BUFFER_build shall reuse it. ]*/
     TEST_FUNCTION(BUFFER_build_when_the_buffer_is_already_allocated_and_less_bytes_are_needed_succeeds)
     {
         ///arrange
@@ -631,14 +630,12 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         nResult = BUFFER_build(g_hBuffer, BUFFER_TEST_VALUE, ALLOCATION_SIZE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, ALLOCATION_SIZE - 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = BUFFER_build(g_hBuffer, BUFFER_TEST_VALUE, ALLOCATION_SIZE - 1);
 
         ///assert
         ASSERT_ARE_EQUAL(int, nResult, 0);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE - 1, BUFFER_length(g_hBuffer));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -731,6 +728,34 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         BUFFER_delete(g_hBuffer);
     }
 
+    /* Tests_SRS_BUFFER_01_011: [ BUFFER_enlarge shall grow the memory held by the buffer to at least twice its previous size when it needs to grow. ]*/
+    TEST_FUNCTION(BUFFER_enlarge_doubles_the_allocation)
+    {
+        ///arrange
+        int nResult1;
+        int nResult2;
+        BUFFER_HANDLE g_hBuffer;
+        g_hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * ALLOCATION_SIZE))
+            .IgnoreArgument(1);
+
+        ///act
+        nResult1 = BUFFER_enlarge(g_hBuffer, 1);
+        nResult2 = BUFFER_enlarge(g_hBuffer, ALLOCATION_SIZE - 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, nResult1);
+        ASSERT_ARE_EQUAL(int, 0, nResult2);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(g_hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(g_hBuffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(g_hBuffer);
+    }
+
     /* Tests_SRS_BUFFER_07_017: [BUFFER_enlarge shall return a nonzero result if any parameters are NULL or zero.] */
     /* Tests_SRS_BUFFER_07_018: [BUFFER_enlarge shall return a nonzero result if any error is encountered.] */
     TEST_FUNCTION(BUFFER_enlarge_NULL_HANDLE_Fail)
@@ -1281,6 +1306,7 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
     }
 
     /* Tests_SRS_BUFFER_07_024: [BUFFER_append concatenates b2 onto b1 without modifying b2 and shall return zero on success.] */
+    /* Tests_SRS_BUFFER_01_013: [ Otherwise BUFFER_prepend shall allocate the combined size plus half of it as headroom in front of the result, leaving room for further prepends. ]*/
     TEST_FUNCTION(BUFFER_prepend_Succeed)
     {
         ///arrange
@@ -1293,7 +1319,7 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         nResult = BUFFER_build(hAppend, BUFFER_TEST_VALUE, ALLOCATION_SIZE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(ALLOCATION_SIZE + ALLOCATION_SIZE));
+        STRICT_EXPECTED_CALL(gballoc_malloc((ALLOCATION_SIZE + ALLOCATION_SIZE) / 2 + ALLOCATION_SIZE + ALLOCATION_SIZE));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -1312,6 +1338,37 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         BUFFER_delete(g_hBuffer);
     }
 
+    /* Tests_SRS_BUFFER_01_012: [ If there is enough headroom in front of the content of handle1, BUFFER_prepend shall copy the content of handle2 there without moving the content of handle1. ]*/
+    TEST_FUNCTION(BUFFER_prepend_uses_the_headroom_left_by_a_previous_prepend)
+    {
+        ///arrange
+        int nResult;
+        BUFFER_HANDLE g_hBuffer;
+        BUFFER_HANDLE hPrefix1;
+        BUFFER_HANDLE hPrefix2;
+        g_hBuffer = BUFFER_create(ADDITIONAL_BUFFER + BUFFER_TEST1_SIZE + BUFFER_TEST2_SIZE, ALLOCATION_SIZE - BUFFER_TEST1_SIZE - BUFFER_TEST2_SIZE);
+        hPrefix1 = BUFFER_create(BUFFER_Test2, BUFFER_TEST2_SIZE);
+        hPrefix2 = BUFFER_create(BUFFER_Test1, BUFFER_TEST1_SIZE);
+        (void)BUFFER_prepend(g_hBuffer, hPrefix1);
+        umock_c_reset_all_calls();
+
+        ///act
+        nResult = BUFFER_prepend(g_hBuffer, hPrefix2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, nResult);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(g_hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(g_hBuffer), BUFFER_Test1, BUFFER_TEST1_SIZE));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(g_hBuffer) + BUFFER_TEST1_SIZE, BUFFER_Test2, BUFFER_TEST2_SIZE));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(g_hBuffer) + BUFFER_TEST1_SIZE + BUFFER_TEST2_SIZE, ADDITIONAL_BUFFER + BUFFER_TEST1_SIZE + BUFFER_TEST2_SIZE, ALLOCATION_SIZE - BUFFER_TEST1_SIZE - BUFFER_TEST2_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hPrefix1);
+        BUFFER_delete(hPrefix2);
+        BUFFER_delete(g_hBuffer);
+    }
+
     /* BUFFER_u_char */
 
     /* Tests_SRS_BUFFER_07_025: [BUFFER_u_char shall return a pointer to the underlying unsigned char*.] */
@@ -1714,4 +1771,119 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         BUFFER_delete(buffer);
     }
 
+    /* Tests_SRS_BUFFER_01_006: [ If handle is NULL, BUFFER_reserve shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(BUFFER_reserve_with_NULL_handle_fails)
+    {
+        int result;
+
+        //arrange
+
+        //act
+        result = BUFFER_reserve(NULL, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_007: [ If the buffer holds no memory, BUFFER_reserve shall allocate capacity bytes and leave the buffer allocated with a size of 0. ]*/
+    TEST_FUNCTION(BUFFER_reserve_on_an_empty_buffer_allocates_the_memory)
+    {
+        int result;
+        const unsigned char* content = NULL;
+
+        //arrange
+        BUFFER_HANDLE buffer = BUFFER_new();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(TOTAL_ALLOCATION_SIZE));
+
+        //act
+        result = BUFFER_reserve(buffer, TOTAL_ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 0, BUFFER_length(buffer));
+        ASSERT_ARE_EQUAL(int, 0, BUFFER_content(buffer, &content));
+        ASSERT_IS_NOT_NULL(content);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(buffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_008: [ Otherwise BUFFER_reserve shall make sure that the content of the buffer can grow to capacity bytes without allocating memory. ]*/
+    TEST_FUNCTION(BUFFER_reserve_grows_the_memory_to_the_requested_capacity)
+    {
+        int result;
+
+        //arrange
+        BUFFER_HANDLE buffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, TOTAL_ALLOCATION_SIZE + 1))
+            .IgnoreArgument(1);
+
+        //act
+        result = BUFFER_reserve(buffer, TOTAL_ALLOCATION_SIZE + 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(buffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(buffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(buffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_008: [ Otherwise BUFFER_reserve shall make sure that the content of the buffer can grow to capacity bytes without allocating memory. ]*/
+    TEST_FUNCTION(BUFFER_append_build_after_BUFFER_reserve_does_not_allocate)
+    {
+        int result;
+
+        //arrange
+        BUFFER_HANDLE buffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        (void)BUFFER_reserve(buffer, TOTAL_ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_append_build(buffer, ADDITIONAL_BUFFER, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(buffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(buffer), TOTAL_BUFFER, TOTAL_ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(buffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_009: [ If any error occurs, BUFFER_reserve shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(BUFFER_reserve_fails_when_realloc_fails)
+    {
+        int result;
+
+        //arrange
+        BUFFER_HANDLE buffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, TOTAL_ALLOCATION_SIZE))
+            .IgnoreArgument(1)
+            .SetReturn(NULL);
+
+        //act
+        result = BUFFER_reserve(buffer, TOTAL_ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(buffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(buffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(buffer);
+    }
+
 END_TEST_SUITE(Buffer_UnitTests)
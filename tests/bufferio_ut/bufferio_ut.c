@@ -0,0 +1,1309 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#if defined _MSC_VER
+#pragma warning(disable: 4054) /* MSC incorrectly fires this */
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_OPTION_HANDLER                     (OPTIONHANDLER_HANDLE)0x4244
+#define TEST_UNDERLYING_IO_INTERFACE            (const IO_INTERFACE_DESCRIPTION*)0x4242
+#define TEST_UNDERLYING_IO_PARAMETERS           (void*)0x4245
+#define TEST_IO_HANDLE                          (XIO_HANDLE)0x4243
+#define TEST_TICK_COUNTER                       (TICK_COUNTER_HANDLE)0x4246
+#define TEST_MAX_BUFFERED_BYTES                 16
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_open_complete, void*, context, IO_OPEN_RESULT, open_result)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_received, void*, context, const unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_error, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_close_complete, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END();
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/bufferio.h"
+
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_ERROR g_on_io_error;
+static void* g_on_io_error_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+static ON_SEND_COMPLETE g_on_io_send_complete;
+static void* g_on_io_send_complete_context;
+static unsigned char g_sent_bytes[64];
+static size_t g_sent_size;
+static tickcounter_ms_t g_current_ms;
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    g_on_io_error = on_io_error;
+    g_on_io_error_context = on_io_error_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)xio;
+    if (size <= sizeof(g_sent_bytes))
+    {
+        (void)memcpy(g_sent_bytes, buffer, size);
+    }
+    g_sent_size = size;
+    g_on_io_send_complete = on_send_complete;
+    g_on_io_send_complete_context = callback_context;
+    return 0;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+static const BUFFERIO_CONFIG default_bufferio_config =
+{
+    TEST_UNDERLYING_IO_INTERFACE,
+    TEST_UNDERLYING_IO_PARAMETERS,
+    TEST_MAX_BUFFERED_BYTES,
+    0
+};
+
+static CONCRETE_IO_HANDLE create_and_open_bufferio(const BUFFERIO_CONFIG* bufferio_config)
+{
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+    return bufferio;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(bufferio_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_OPTION_HANDLER);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const CONSTBUFFER*, void*);
+    REGISTER_UMOCKC_PAIRED_CREATE_DESTROY_CALLS(xio_create, xio_destroy);
+    REGISTER_UMOCKC_PAIRED_CREATE_DESTROY_CALLS(tickcounter_create, tickcounter_destroy);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    g_on_io_send_complete = NULL;
+    g_on_io_send_complete_context = NULL;
+    g_sent_size = 0;
+    g_current_ms = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    umock_c_negative_tests_deinit();
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* bufferio_create */
+
+/* Tests_SRS_BUFFERIO_01_001: [ `bufferio_create` shall create a new instance of the buffer IO. ]*/
+/* Tests_SRS_BUFFERIO_01_003: [ `io_create_parameters` shall be used as a `BUFFERIO_CONFIG*`. ]*/
+/* Tests_SRS_BUFFERIO_01_007: [ `bufferio_create` shall allocate a send buffer of `max_buffered_bytes` bytes. ]*/
+/* Tests_SRS_BUFFERIO_01_008: [ `bufferio_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+/* Tests_SRS_BUFFERIO_01_009: [ `bufferio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+TEST_FUNCTION(bufferio_create_succeeds)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_MAX_BUFFERED_BYTES));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS));
+
+    // act
+    bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(bufferio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_006: [ If `max_buffered_bytes` is 0, `BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES` shall be used. ]*/
+TEST_FUNCTION(bufferio_create_with_0_max_buffered_bytes_uses_the_default)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio;
+    BUFFERIO_CONFIG bufferio_config = default_bufferio_config;
+    bufferio_config.max_buffered_bytes = 0;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(BUFFERIO_DEFAULT_MAX_BUFFERED_BYTES));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS));
+
+    // act
+    bufferio = bufferio_get_interface_description()->concrete_io_create(&bufferio_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(bufferio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_002: [ If `io_create_parameters` is NULL, `bufferio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(bufferio_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio;
+
+    // act
+    bufferio = bufferio_get_interface_description()->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(bufferio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFERIO_01_004: [ If the `underlying_io_interface` member is NULL, `bufferio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(bufferio_create_with_NULL_underlying_io_interface_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio;
+    BUFFERIO_CONFIG bufferio_config = default_bufferio_config;
+    bufferio_config.underlying_io_interface = NULL;
+
+    // act
+    bufferio = bufferio_get_interface_description()->concrete_io_create(&bufferio_config);
+
+    // assert
+    ASSERT_IS_NULL(bufferio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFERIO_01_005: [ If any allocation or call fails, `bufferio_create` shall free all allocated resources and return NULL. ]*/
+TEST_FUNCTION(when_a_call_fails_bufferio_create_fails)
+{
+    // arrange
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_MAX_BUFFERED_BYTES));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS));
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        CONCRETE_IO_HANDLE bufferio;
+        char temp_str[128];
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+
+        // assert
+        (void)sprintf(temp_str, "On failed call %lu", (unsigned long)i);
+        ASSERT_IS_NULL_WITH_MSG(bufferio, temp_str);
+    }
+}
+
+/* bufferio_destroy */
+
+/* Tests_SRS_BUFFERIO_01_010: [ `bufferio_destroy` shall destroy the underlying IO by calling `xio_destroy` and free all the resources of the instance. ]*/
+TEST_FUNCTION(bufferio_destroy_frees_the_resources)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFERIO_01_011: [ If `bufferio` is NULL, `bufferio_destroy` shall do nothing. ]*/
+TEST_FUNCTION(bufferio_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    bufferio_get_interface_description()->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFERIO_01_012: [ The `on_send_complete` callback of every buffered send shall be called with `IO_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(bufferio_destroy_cancels_the_buffered_sends)
+{
+    // arrange
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x1, IO_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x2, IO_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* bufferio_open */
+
+/* Tests_SRS_BUFFERIO_01_013: [ `bufferio_open` shall open the underlying IO by calling `xio_open`, passing `on_bytes_received` and `on_bytes_received_context` through unchanged, and on success it shall return 0. ]*/
+TEST_FUNCTION(bufferio_open_opens_the_underlying_io)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, test_on_bytes_received, (void*)0x4248, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_014: [ If `bufferio`, `on_io_open_complete`, `on_bytes_received` or `on_io_error` is NULL, `bufferio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_open_with_NULL_on_io_open_complete_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_open(bufferio, NULL, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_015: [ If the buffer IO is not CLOSED, `bufferio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_open_when_already_open_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_016: [ If `xio_open` fails, `bufferio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_open_fails_bufferio_open_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, test_on_bytes_received, (void*)0x4248, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context()
+        .SetReturn(1);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_017: [ When the underlying IO open completes with `IO_OPEN_OK`, the buffer IO shall be OPEN and `on_io_open_complete` shall be called with `IO_OPEN_OK`. ]*/
+TEST_FUNCTION(on_underlying_io_open_complete_with_OK_indicates_open)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4247, IO_OPEN_OK));
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_018: [ When the underlying IO open completes with any other result, the buffer IO shall be CLOSED and `on_io_open_complete` shall be called with the same result. ]*/
+TEST_FUNCTION(on_underlying_io_open_complete_with_ERROR_indicates_open_error)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4247, IO_OPEN_ERROR));
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_ERROR);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_019: [ If the underlying IO indicates an error while OPENING, the buffer IO shall be CLOSED and `on_io_open_complete` shall be called with `IO_OPEN_ERROR`. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_opening_indicates_open_error)
+{
+    // arrange
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4247, IO_OPEN_ERROR));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_020: [ If the underlying IO indicates an error while OPEN, the buffer IO shall enter the error state and `on_io_error` shall be called. ]*/
+/* Tests_SRS_BUFFERIO_01_037: [ If the buffer IO is not OPEN, `bufferio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_open_indicates_the_error_and_sends_fail)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    STRICT_EXPECTED_CALL(test_on_io_error((void*)0x4249));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* bufferio_close */
+
+/* Tests_SRS_BUFFERIO_01_021: [ `bufferio_close` shall close the underlying IO by calling `xio_close` and on success it shall return 0. ]*/
+/* Tests_SRS_BUFFERIO_01_026: [ When the underlying IO close completes, the buffer IO shall be CLOSED and `on_io_close_complete`, if not NULL, shall be called. ]*/
+TEST_FUNCTION(bufferio_close_closes_the_underlying_io)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_close_complete((void*)0x4250));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, test_on_io_close_complete, (void*)0x4250);
+    g_on_io_close_complete(g_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_025: [ Before closing an OPEN buffer IO, `bufferio_close` shall flush the buffered sends, in the error state it shall call their `on_send_complete` with `IO_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(bufferio_close_flushes_the_buffered_sends)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, test_on_io_close_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_CANCELLED);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_025: [ Before closing an OPEN buffer IO, `bufferio_close` shall flush the buffered sends, in the error state it shall call their `on_send_complete` with `IO_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(bufferio_close_in_error_state_cancels_the_buffered_sends)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    g_on_io_error(g_on_io_error_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x1, IO_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_022: [ If `bufferio` is NULL, `bufferio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_close_with_NULL_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(NULL, test_on_io_close_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BUFFERIO_01_023: [ If the buffer IO is CLOSED or CLOSING, `bufferio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_close_when_closed_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, test_on_io_close_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_024: [ `bufferio_close` while OPENING shall close the underlying IO and call `on_io_open_complete` with `IO_OPEN_CANCELLED`. ]*/
+TEST_FUNCTION(bufferio_close_while_opening_cancels_the_open)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_open(bufferio, test_on_io_open_complete, (void*)0x4247, test_on_bytes_received, (void*)0x4248, test_on_io_error, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4247, IO_OPEN_CANCELLED));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, test_on_io_close_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_027: [ If `xio_close` fails, `bufferio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_close_fails_bufferio_close_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_close(bufferio, test_on_io_close_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* bufferio_send */
+
+/* Tests_SRS_BUFFERIO_01_034: [ `bufferio_send` shall copy the `size` bytes pointed to by `buffer` at the end of the send buffer, remember `on_send_complete` and `on_send_complete_context`, and on success it shall return 0. ]*/
+TEST_FUNCTION(bufferio_send_buffers_the_bytes)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER, IGNORED_PTR_ARG))
+        .IgnoreArgument_current_ms();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_035: [ If `bufferio` or `buffer` is NULL or `size` is 0, `bufferio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_send_with_0_size_fails)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, 0, test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_035: [ If `bufferio` or `buffer` is NULL or `size` is 0, `bufferio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_send_with_NULL_buffer_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, NULL, 1, test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_042: [ If allocating memory for the send fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_pending_send_fails_bufferio_send_fails)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_038: [ If the buffered bytes and `size` together exceed `max_buffered_bytes`, the buffered sends shall be flushed first. ]*/
+TEST_FUNCTION(bufferio_send_exceeding_the_budget_flushes_the_buffered_sends_first)
+{
+    // arrange
+    int result;
+    unsigned char first[10] = { 0x01 };
+    unsigned char second[10] = { 0x02 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, first, sizeof(first), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(first), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER, IGNORED_PTR_ARG))
+        .IgnoreArgument_current_ms();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, second, sizeof(second), test_on_send_complete, (void*)0x2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0x01, (int)g_sent_bytes[0]);
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_039: [ If flushing before the send fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_BUFFERIO_01_033: [ If flushing fails, the `on_send_complete` callback of every buffered send shall be called with `IO_SEND_ERROR`. ]*/
+TEST_FUNCTION(when_flushing_before_the_send_fails_bufferio_send_fails)
+{
+    // arrange
+    int result;
+    unsigned char first[10] = { 0x01 };
+    unsigned char second[10] = { 0x02 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, first, sizeof(first), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(first), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x1, IO_SEND_ERROR));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, second, sizeof(second), test_on_send_complete, (void*)0x2);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_040: [ A send of `max_buffered_bytes` or more shall not be buffered, it shall be passed to `xio_send` on the underlying IO with its own `on_send_complete` and `on_send_complete_context`. ]*/
+TEST_FUNCTION(bufferio_send_of_max_buffered_bytes_is_passed_through)
+{
+    // arrange
+    int result;
+    unsigned char send_data[TEST_MAX_BUFFERED_BYTES] = { 0x42 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_041: [ If `xio_send` fails, `bufferio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_passed_through_xio_send_fails_bufferio_send_fails)
+{
+    // arrange
+    int result;
+    unsigned char send_data[TEST_MAX_BUFFERED_BYTES] = { 0x42 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1))
+        .SetReturn(1);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_043: [ When the send buffer is full, the buffered sends shall be flushed before `bufferio_send` returns. ]*/
+/* Tests_SRS_BUFFERIO_01_031: [ Flushing shall send all the buffered bytes with a single call to `xio_send` on the underlying IO. ]*/
+TEST_FUNCTION(bufferio_send_filling_the_buffer_flushes_it)
+{
+    // arrange
+    int result;
+    unsigned char first[10] = { 0x01 };
+    unsigned char second[6] = { 0x02 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, first, sizeof(first), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_MAX_BUFFERED_BYTES, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send(bufferio, second, sizeof(second), test_on_send_complete, (void*)0x2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0x01, (int)g_sent_bytes[0]);
+    ASSERT_ARE_EQUAL(int, 0x02, (int)g_sent_bytes[10]);
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_032: [ When the underlying send completes, the `on_send_complete` callback of every send carried by it shall be called in the order of the sends, with the `send_result` of the underlying send. ]*/
+TEST_FUNCTION(when_the_underlying_send_completes_every_send_is_completed_in_order)
+{
+    // arrange
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), NULL, NULL);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x3);
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x1, IO_SEND_OK));
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x3, IO_SEND_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* bufferio_send_vectored */
+
+/* Tests_SRS_BUFFERIO_01_054: [ `bufferio_send_vectored` shall buffer the segments in order exactly like `bufferio_send` buffers one buffer, so a vectored send completes through a single `on_send_complete` call. ]*/
+TEST_FUNCTION(bufferio_send_vectored_buffers_the_segments)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x82, 0x02 };
+    unsigned char payload[] = { 0x42, 0x43 };
+    CONSTBUFFER buffers[2];
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = sizeof(payload);
+    (void)bufferio_get_interface_description()->concrete_io_send_vectored(bufferio, buffers, 2, test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 4, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    result = memcmp(g_sent_bytes, "\x82\x02\x42\x43", 4);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_055: [ A vectored send of `max_buffered_bytes` or more shall not be buffered, it shall be passed to `xio_send_vectored` on the underlying IO with its own `on_send_complete` and `on_send_complete_context`. ]*/
+TEST_FUNCTION(bufferio_send_vectored_of_max_buffered_bytes_is_passed_through)
+{
+    // arrange
+    int result;
+    unsigned char header[2] = { 0x82 };
+    unsigned char payload[TEST_MAX_BUFFERED_BYTES] = { 0x42 };
+    CONSTBUFFER buffers[2];
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = sizeof(payload);
+
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, buffers, 2, test_on_send_complete, (void*)0x1));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send_vectored(bufferio, buffers, 2, test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_056: [ If `bufferio` or `buffers` is NULL or `buffer_count` is 0, `bufferio_send_vectored` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_send_vectored_with_0_buffer_count_fails)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 0x43 };
+    CONSTBUFFER buffers[1];
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_send_vectored(bufferio, buffers, 0, test_on_send_complete, (void*)0x1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* bufferio_dowork */
+
+/* Tests_SRS_BUFFERIO_01_046: [ If `max_delay_ms` is 0, `bufferio_dowork` shall flush the buffered sends. ]*/
+/* Tests_SRS_BUFFERIO_01_030: [ Flushing shall move the callbacks of the buffered sends to a newly allocated structure that is passed as context to the underlying send. ]*/
+/* Tests_SRS_BUFFERIO_01_044: [ `bufferio_dowork` shall call `xio_dowork` on the underlying IO after the flush, so the flushed bytes go out in the same call. ]*/
+TEST_FUNCTION(bufferio_dowork_flushes_the_buffered_sends_in_one_underlying_send)
+{
+    // arrange
+    unsigned char first[] = { 0x42, 0x43 };
+    unsigned char second[] = { 0x44 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, first, sizeof(first), test_on_send_complete, (void*)0x1);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, second, sizeof(second), test_on_send_complete, (void*)0x2);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 3, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0x42, (int)g_sent_bytes[0]);
+    ASSERT_ARE_EQUAL(int, 0x43, (int)g_sent_bytes[1]);
+    ASSERT_ARE_EQUAL(int, 0x44, (int)g_sent_bytes[2]);
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_047: [ Otherwise the buffered sends shall be flushed once `max_delay_ms` have passed since the first of them was buffered, or when the current time cannot be obtained. ]*/
+TEST_FUNCTION(bufferio_dowork_keeps_the_buffered_sends_until_max_delay_ms)
+{
+    // arrange
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio;
+    BUFFERIO_CONFIG bufferio_config = default_bufferio_config;
+    bufferio_config.max_delay_ms = 10;
+    bufferio = create_and_open_bufferio(&bufferio_config);
+    g_current_ms = 1000;
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER, IGNORED_PTR_ARG))
+        .IgnoreArgument_current_ms();
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER, IGNORED_PTR_ARG))
+        .IgnoreArgument_current_ms();
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    g_current_ms = 1009;
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+    g_current_ms = 1010;
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_033: [ If flushing fails, the `on_send_complete` callback of every buffered send shall be called with `IO_SEND_ERROR`. ]*/
+TEST_FUNCTION(when_allocating_the_flushed_sends_fails_the_buffered_sends_complete_with_error)
+{
+    // arrange
+    unsigned char send_data[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE bufferio = create_and_open_bufferio(&default_bufferio_config);
+    (void)bufferio_get_interface_description()->concrete_io_send(bufferio, send_data, sizeof(send_data), test_on_send_complete, (void*)0x1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x1, IO_SEND_ERROR));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    bufferio_get_interface_description()->concrete_io_dowork(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_045: [ If `bufferio` is NULL, `bufferio_dowork` shall do nothing. ]*/
+TEST_FUNCTION(bufferio_dowork_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    bufferio_get_interface_description()->concrete_io_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* bufferio_set_option */
+
+/* Tests_SRS_BUFFERIO_01_048: [ `bufferio_set_option` shall pass all options to the underlying IO by calling `xio_setoption`. ]*/
+TEST_FUNCTION(bufferio_set_option_passes_the_option_to_the_underlying_io)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "some_option", (void*)0x4251));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_setoption(bufferio, "some_option", (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_049: [ If `bufferio` or `option_name` is NULL, `bufferio_set_option` shall return a non-zero value. ]*/
+TEST_FUNCTION(bufferio_set_option_with_NULL_option_name_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_setoption(bufferio, NULL, (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_050: [ If `xio_setoption` fails, `bufferio_set_option` shall return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_setoption_fails_bufferio_set_option_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "some_option", (void*)0x4251))
+        .SetReturn(1);
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_setoption(bufferio, "some_option", (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* bufferio_retrieve_options */
+
+/* Tests_SRS_BUFFERIO_01_051: [ `bufferio_retrieve_options` shall return the result of `xio_retrieveoptions` on the underlying IO. ]*/
+TEST_FUNCTION(bufferio_retrieve_options_returns_the_options_of_the_underlying_io)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    CONCRETE_IO_HANDLE bufferio = bufferio_get_interface_description()->concrete_io_create((void*)&default_bufferio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_retrieveoptions(bufferio);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    bufferio_get_interface_description()->concrete_io_destroy(bufferio);
+}
+
+/* Tests_SRS_BUFFERIO_01_052: [ If `bufferio` is NULL, `bufferio_retrieve_options` shall fail and return NULL. ]*/
+TEST_FUNCTION(bufferio_retrieve_options_with_NULL_fails)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+
+    // act
+    result = bufferio_get_interface_description()->concrete_io_retrieveoptions(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* bufferio_get_interface_description */
+
+/* Tests_SRS_BUFFERIO_01_053: [ `bufferio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `bufferio_retrieve_options`, `bufferio_create`, `bufferio_destroy`, `bufferio_open`, `bufferio_close`, `bufferio_send`, `bufferio_dowork`, `bufferio_set_option` and `bufferio_send_vectored`. ]*/
+TEST_FUNCTION(bufferio_get_interface_description_returns_all_the_functions)
+{
+    // arrange
+
+    // act
+    const IO_INTERFACE_DESCRIPTION* result = bufferio_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result->concrete_io_retrieveoptions);
+    ASSERT_IS_NOT_NULL(result->concrete_io_create);
+    ASSERT_IS_NOT_NULL(result->concrete_io_destroy);
+    ASSERT_IS_NOT_NULL(result->concrete_io_open);
+    ASSERT_IS_NOT_NULL(result->concrete_io_close);
+    ASSERT_IS_NOT_NULL(result->concrete_io_send);
+    ASSERT_IS_NOT_NULL(result->concrete_io_dowork);
+    ASSERT_IS_NOT_NULL(result->concrete_io_setoption);
+    ASSERT_IS_NOT_NULL(result->concrete_io_send_vectored);
+}
+
+END_TEST_SUITE(bufferio_unittests)
@@ -18,6 +18,7 @@
 #include <ctime>
 #else
 #include <stddef.h>
+#include <string.h>
 #include <time.h>
 #endif
 
@@ -47,6 +48,9 @@ void my_gballoc_free(void* ptr)
 
 #include "socket_async_os.h"
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,23 +72,67 @@ void freeaddrinfo(struct addrinfo* ai)
 #define GETADDRINFO_SUCCESS 0
 #define GETADDRINFO_FAIL -1
 #define FAKE_GOOD_IP_ADDR 444
+#define FAKE_GOOD_IPV6_LAST_BYTE 0x42
+#define FAKE_NOW_MS 1000000
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4244;
+static const THREAD_HANDLE TEST_THREAD_HANDLE = (THREAD_HANDLE)0x4245;
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4246;
 
 struct sockaddr_in fake_good_addr;
+struct sockaddr_in6 fake_good_addr6;
 struct addrinfo fake_addrinfo;
+struct addrinfo fake_addrinfo6;
+static bool fake_ipv6_first;
+static tickcounter_ms_t fake_now_ms;
+static THREAD_START_FUNC captured_thread_func;
+static void* captured_thread_arg;
+static size_t thread_create_count;
 
 int my_getaddrinfo(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
 {
     (void)node;
     (void)service;
     (void)hints;
-    fake_addrinfo.ai_next = NULL;
+    memset(&fake_good_addr6, 0, sizeof(fake_good_addr6));
+    fake_good_addr6.sin6_family = AF_INET6;
+    fake_good_addr6.sin6_addr.s6_addr[15] = FAKE_GOOD_IPV6_LAST_BYTE;
+    fake_addrinfo6.ai_family = AF_INET6;
+    fake_addrinfo6.ai_addr = (struct sockaddr*)(&fake_good_addr6);
     fake_addrinfo.ai_family = AF_INET;
     fake_addrinfo.ai_addr = (struct sockaddr*)(&fake_good_addr);
     ((struct sockaddr_in *) fake_addrinfo.ai_addr)->sin_addr.s_addr = FAKE_GOOD_IP_ADDR;
-    *res = &fake_addrinfo;
+    if (fake_ipv6_first)
+    {
+        fake_addrinfo6.ai_next = &fake_addrinfo;
+        fake_addrinfo.ai_next = NULL;
+        *res = &fake_addrinfo6;
+    }
+    else
+    {
+        fake_addrinfo.ai_next = &fake_addrinfo6;
+        fake_addrinfo6.ai_next = NULL;
+        *res = &fake_addrinfo;
+    }
     return 0;
 }
 
+int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = fake_now_ms;
+    return 0;
+}
+
+THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    captured_thread_func = func;
+    captured_thread_arg = arg;
+    thread_create_count++;
+    *threadHandle = TEST_THREAD_HANDLE;
+    return THREADAPI_OK;
+}
+
 /**
  * Include the test tools.
  */
@@ -100,6 +148,9 @@ int my_getaddrinfo(const char *node, const char *service, const struct addrinfo
 
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
     char temp_str[256];
@@ -107,6 +158,39 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
     ASSERT_FAIL(temp_str);
 }
 
+// Runs the worker thread last started by dns_async_create
+static void run_lookup_thread(void)
+{
+    ASSERT_IS_NOT_NULL(captured_thread_func);
+    (void)captured_thread_func(captured_thread_arg);
+    captured_thread_func = NULL;
+}
+
+static DNS_ASYNC_HANDLE create_completed_lookup(const char* hostname, DNS_ASYNC_OPTIONS* options)
+{
+    DNS_ASYNC_HANDLE result = dns_async_create(hostname, options);
+    ASSERT_IS_NOT_NULL(result);
+    run_lookup_thread();
+    ASSERT_IS_TRUE(dns_async_is_lookup_complete(result), "Unexpected non-completion");
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static void setup_create_new_lookup_calls(bool is_first_lookup)
+{
+    if (is_first_lookup)
+    {
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(tickcounter_create());
+    }
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+}
 
 /**
  * This is necessary for the test suite, just keep as is.
@@ -135,13 +219,31 @@ BEGIN_TEST_SUITE(dns_async_ut)
         umocktypes_stdint_register_types();
         ASSERT_ARE_EQUAL(int, 0, result);
 
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+        REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+        REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
         REGISTER_GLOBAL_MOCK_RETURNS(getaddrinfo, GETADDRINFO_SUCCESS, GETADDRINFO_FAIL);
         REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo);
-}
+
+        REGISTER_GLOBAL_MOCK_RETURNS(tickcounter_create, TEST_TICK_COUNTER_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, __LINE__);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock_Init, TEST_LOCK_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock, LOCK_OK, LOCK_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(Unlock, LOCK_OK, LOCK_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+    }
 
     /**
      * The test suite will call this function to cleanup your machine.
@@ -165,6 +267,11 @@ BEGIN_TEST_SUITE(dns_async_ut)
             ASSERT_FAIL("Could not acquire test serialization mutex.");
         }
 
+        fake_ipv6_first = false;
+        fake_now_ms = FAKE_NOW_MS;
+        captured_thread_func = NULL;
+        captured_thread_arg = NULL;
+        thread_create_count = 0;
         umock_c_reset_all_calls();
     }
 
@@ -174,22 +281,20 @@ BEGIN_TEST_SUITE(dns_async_ut)
      */
     TEST_FUNCTION_CLEANUP(cleans)
     {
+        // the cache outlives the lookups, start every test without it
+        dns_async_deinit();
         TEST_MUTEX_RELEASE(g_testByTest);
     }
 
     /* Tests_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
-    /* Tests_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the first discovered IPv4 address. ]*/
     /* Tests_SRS_DNS_ASYNC_30_024: [ If dns_async_is_create_complete has previously returned true, dns_async_is_create_complete shall do nothing and return true. ]*/
     TEST_FUNCTION(dns_async__is_complete_repeated_call__succeeds)
     {
         ///arrange
-        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
-        // We're calling this twice
-        bool result = dns_async_is_lookup_complete(dns);
-        uint32_t ipv4 = dns_async_get_ipv4(dns);
-        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, ipv4, "Unexpected IP");
-        ASSERT_IS_TRUE(result, "Unexpected non-completion");
-        umock_c_reset_all_calls();
+        bool result;
+        uint32_t ipv4;
+        DNS_ASYNC_HANDLE dns = create_completed_lookup("fake.com", NULL);
 
         ///act
         result = dns_async_is_lookup_complete(dns);
@@ -208,7 +313,22 @@ BEGIN_TEST_SUITE(dns_async_ut)
     /* Tests_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
     TEST_FUNCTION(dns_async__is_complete_waiting__succeeds)
     {
-        // This condition cannot be tested with the blocking immplementation of dns_async because the module never waits.
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_FALSE(result, "Unexpected completion");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
     }
 
     /* Tests_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
@@ -217,30 +337,55 @@ BEGIN_TEST_SUITE(dns_async_ut)
         ///arrange
         bool result;
         DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        run_lookup_thread();
         umock_c_reset_all_calls();
-        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
 
         ///act
         result = dns_async_is_lookup_complete(dns);
 
         ///assert
         ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         dns_async_destroy(dns);
     }
 
-    /* Tests_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
-    TEST_FUNCTION(dns_async__dns_async_get_ipv4__succeeds)
+    /* Tests_SRS_DNS_ASYNC_30_018: [ Otherwise dns_async_create shall start a new lookup of both the IPv4 and IPv6 addresses of hostname on a worker thread created with ThreadAPI_Create. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_027: [ A worker thread shall perform the lookups waiting in the cache, oldest first, and exit when none is left. ]*/
+    TEST_FUNCTION(dns_async__lookup_thread__succeeds)
     {
         ///arrange
-        bool result;
-        uint32_t ipv4;
         DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
         umock_c_reset_all_calls();
-        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-        result = dns_async_is_lookup_complete(dns);
-        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        STRICT_EXPECTED_CALL(getaddrinfo("fake.com", NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(DNS_ASYNC_ADDRESS)));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        run_lookup_thread();
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns), "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(size_t, 2, dns_async_get_address_count(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the first discovered IPv4 address. ]*/
+    TEST_FUNCTION(dns_async__dns_async_get_ipv4__succeeds)
+    {
+        ///arrange
+        uint32_t ipv4;
+        DNS_ASYNC_HANDLE dns;
+        fake_ipv6_first = true;
+        dns = create_completed_lookup("fake.com", NULL);
 
         ///act
         ipv4 = dns_async_get_ipv4(dns);
@@ -260,6 +405,7 @@ BEGIN_TEST_SUITE(dns_async_ut)
         DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
+        run_lookup_thread();
 
         ///act
         result = dns_async_is_lookup_complete(dns);
@@ -271,17 +417,16 @@ BEGIN_TEST_SUITE(dns_async_ut)
         dns_async_destroy(dns);
     }
 
-    /* Tests_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed or found no IPv4 address, dns_async_get_ipv4 shall return 0. ]*/
     TEST_FUNCTION(dns_async__async_get_ipv4__fails)
     {
         ///arrange
-        bool result;
         uint32_t ipv4;
         DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
-        result = dns_async_is_lookup_complete(dns);
-        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        run_lookup_thread();
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns), "Unexpected non-completion");
 
         ///act
         ipv4 = dns_async_get_ipv4(dns);
@@ -311,6 +456,7 @@ BEGIN_TEST_SUITE(dns_async_ut)
     {
         ///arrange
         DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        run_lookup_thread();
 
         ///act
         uint32_t result = dns_async_get_ipv4(dns);
@@ -335,6 +481,157 @@ BEGIN_TEST_SUITE(dns_async_ut)
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
+    /* Tests_SRS_DNS_ASYNC_30_040: [ If the dns parameter is NULL, dns_async_get_address_count shall log an error and return 0. ]*/
+    TEST_FUNCTION(dns_async__get_address_count_parameter_validation__fails)
+    {
+        ///arrange
+
+        ///act
+        size_t result = dns_async_get_address_count(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_041: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_address_count shall log an error and return 0. ]*/
+    TEST_FUNCTION(dns_async__get_address_count_too_early__fails)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        run_lookup_thread();
+
+        ///act
+        size_t result = dns_async_get_address_count(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_042: [ dns_async_get_address_count shall return the number of IPv4 and IPv6 addresses discovered, which is 0 if the lookup process has failed. ]*/
+    TEST_FUNCTION(dns_async__get_address_count__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = create_completed_lookup("fake.com", NULL);
+
+        ///act
+        size_t result = dns_async_get_address_count(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 2, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_042: [ dns_async_get_address_count shall return the number of IPv4 and IPv6 addresses discovered, which is 0 if the lookup process has failed. ]*/
+    TEST_FUNCTION(dns_async__get_address_count_after_failure__returns_0)
+    {
+        ///arrange
+        size_t result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
+        run_lookup_thread();
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns), "Unexpected non-completion");
+
+        ///act
+        result = dns_async_get_address_count(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_045: [ If the dns or address parameter is NULL, dns_async_get_address shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_address_parameter_validation__fails)
+    {
+        ///arrange
+        DNS_ASYNC_ADDRESS address;
+        DNS_ASYNC_HANDLE dns = create_completed_lookup("fake.com", NULL);
+
+        ///act
+        int result1 = dns_async_get_address(NULL, 0, &address);
+        int result2 = dns_async_get_address(dns, 0, NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+        ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_046: [ If dns_async_is_create_complete has not yet returned true, dns_async_get_address shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_address_too_early__fails)
+    {
+        ///arrange
+        DNS_ASYNC_ADDRESS address;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        run_lookup_thread();
+
+        ///act
+        int result = dns_async_get_address(dns, 0, &address);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_047: [ If index is not lower than the number of addresses discovered, dns_async_get_address shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_address_index_out_of_range__fails)
+    {
+        ///arrange
+        DNS_ASYNC_ADDRESS address;
+        DNS_ASYNC_HANDLE dns = create_completed_lookup("fake.com", NULL);
+
+        ///act
+        int result = dns_async_get_address(dns, 2, &address);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_048: [ dns_async_get_address shall copy the address at index, in the order given by the resolver, and return 0. ]*/
+    TEST_FUNCTION(dns_async__get_address__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_ADDRESS address4;
+        DNS_ASYNC_ADDRESS address6;
+        uint32_t ipv4;
+        int result4;
+        int result6;
+        DNS_ASYNC_HANDLE dns = create_completed_lookup("fake.com", NULL);
+
+        ///act
+        result4 = dns_async_get_address(dns, 0, &address4);
+        result6 = dns_async_get_address(dns, 1, &address6);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result4);
+        ASSERT_ARE_EQUAL(int, 0, result6);
+        ASSERT_ARE_EQUAL(int, (int)DNS_ASYNC_ADDRESS_TYPE_IPV4, (int)address4.type);
+        (void)memcpy(&ipv4, address4.address, sizeof(ipv4));
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, ipv4);
+        ASSERT_ARE_EQUAL(int, (int)DNS_ASYNC_ADDRESS_TYPE_IPV6, (int)address6.type);
+        ASSERT_ARE_EQUAL(int, FAKE_GOOD_IPV6_LAST_BYTE, (int)address6.address[15]);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
     /* Tests_SRS_DNS_ASYNC_30_050: [ If the dns parameter is NULL, dns_async_destroy shall log an error and do nothing. ]*/
     TEST_FUNCTION(dns_async__destroy_parameter_validation__fails)
     {
@@ -348,35 +645,65 @@ BEGIN_TEST_SUITE(dns_async_ut)
     }
 
     /* Tests_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_052: [ dns_async_destroy shall release the shared lookup when neither the cache nor another DNS_ASYNC_HANDLE use it. ]*/
     TEST_FUNCTION(dns_async__destroy__success)
     {
         ///arrange
-        DNS_ASYNC_HANDLE result = dns_async_create("fake.com", NULL);
+        DNS_ASYNC_HANDLE result = create_completed_lookup("fake.com", NULL);
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // instance, the lookup stays cached
+
+        ///act
+        dns_async_destroy(result);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_052: [ dns_async_destroy shall release the shared lookup when neither the cache nor another DNS_ASYNC_HANDLE use it. ]*/
+    TEST_FUNCTION(dns_async__destroy_after_eviction__releases_lookup)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", NULL);
+        DNS_ASYNC_HANDLE dns2;
+        fake_now_ms += DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS * 1000;
+        dns2 = dns_async_create("fake.com", NULL);
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // addresses
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // instance
 
         ///act
-        dns_async_destroy(result);
+        dns_async_destroy(dns1);
 
         ///assert
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns2);
     }
 
-    /* Tests_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_013: [ On success, dns_async_create shall return the created DNS_ASYNC_HANDLE. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_015: [ dns_async_create shall call dns_async_init, which creates the cache if it does not exist. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_018: [ Otherwise dns_async_create shall start a new lookup of both the IPv4 and IPv6 addresses of hostname on a worker thread created with ThreadAPI_Create. ]*/
     TEST_FUNCTION(dns_async__create__success)
     {
         ///arrange
         DNS_ASYNC_HANDLE result;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        setup_create_new_lookup_calls(true);
 
         ///act
         result = dns_async_create("fake.com", NULL);
 
         ///assert
         ASSERT_IS_NOT_NULL(result);
+        ASSERT_IS_NOT_NULL(captured_thread_func);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -391,14 +718,19 @@ BEGIN_TEST_SUITE(dns_async_ut)
         int negativeTestsInitResult = umock_c_negative_tests_init();
         ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        setup_create_new_lookup_calls(true);
         umock_c_negative_tests_snapshot();
 
         for (i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             DNS_ASYNC_HANDLE result;
 
+            // tickcounter_get_current_ms only empties the cache, ThreadAPI_Create falls back to a synchronous lookup and Unlock is not checked
+            if (i == 4 || i == 7 || i == 8)
+            {
+                continue;
+            }
+
             umock_c_negative_tests_reset();
             umock_c_negative_tests_fail_call(i);
 
@@ -407,6 +739,9 @@ BEGIN_TEST_SUITE(dns_async_ut)
 
             ///assert
             ASSERT_IS_NULL(result);
+
+            // the cache created by a failed call would change the calls of the next one
+            dns_async_deinit();
         }
 
         ///cleanup
@@ -425,5 +760,488 @@ BEGIN_TEST_SUITE(dns_async_ut)
         ASSERT_IS_NULL(result, "Unexpected success with NULL hostname");
     }
 
+    /* Tests_SRS_DNS_ASYNC_30_017: [ If the cache holds a lookup of hostname that is in progress or whose time to live has not elapsed, dns_async_create shall share it instead of starting a new lookup. ]*/
+    TEST_FUNCTION(dns_async__create_while_same_lookup_in_progress__shares_it)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns1 = dns_async_create("fake.com", NULL);
+        DNS_ASYNC_HANDLE dns2;
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        run_lookup_thread();
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns1), "Unexpected non-completion");
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns2), "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns2));
+
+        ///cleanup
+        dns_async_destroy(dns1);
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_017: [ If the cache holds a lookup of hostname that is in progress or whose time to live has not elapsed, dns_async_create shall share it instead of starting a new lookup. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    TEST_FUNCTION(dns_async__create_with_cached_lookup__completes_immediately)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", NULL);
+        dns_async_destroy(dns1);
+        fake_now_ms += (DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS * 1000) - 1;
+        umock_c_reset_all_calls();
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_IS_NULL(captured_thread_func);
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns2), "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns2));
+
+        ///cleanup
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_016: [ dns_async_create shall remove from the cache the completed lookups whose time to live has elapsed. ]*/
+    TEST_FUNCTION(dns_async__create_with_expired_lookup__starts_new_lookup)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", NULL);
+        dns_async_destroy(dns1);
+        fake_now_ms += DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS * 1000;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // expired addresses
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // expired copy hostname
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // expired cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));  // exited worker
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_012: [ If the options parameter is NULL, dns_async_create shall use DNS_ASYNC_DEFAULT_CACHE_TTL_SECONDS and DNS_ASYNC_DEFAULT_NEGATIVE_CACHE_TTL_SECONDS. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    TEST_FUNCTION(dns_async__failed_lookup__is_cached_for_negative_ttl)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns3;
+        DNS_ASYNC_HANDLE dns1 = dns_async_create("fake.com", NULL);
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
+        run_lookup_thread();
+        dns_async_destroy(dns1);
+
+        ///act
+        fake_now_ms += (DNS_ASYNC_DEFAULT_NEGATIVE_CACHE_TTL_SECONDS * 1000) - 1;
+        dns2 = dns_async_create("fake.com", NULL);
+        fake_now_ms += 1;
+        dns3 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns2), "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(dns2));
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(dns3), "Unexpected completion of an expired failure");
+
+        ///cleanup
+        dns_async_destroy(dns2);
+        dns_async_destroy(dns3);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    TEST_FUNCTION(dns_async__create_with_zero_ttl_options__does_not_reuse_lookup)
+    {
+        ///arrange
+        DNS_ASYNC_OPTIONS options = { 0, 0 };
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", &options);
+
+        ///act
+        dns2 = dns_async_create("fake.com", &options);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_IS_NOT_NULL(captured_thread_func);
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(dns2), "Unexpected completion");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns1));
+
+        ///cleanup
+        dns_async_destroy(dns1);
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_019: [ If ThreadAPI_Create fails and no worker thread is running, dns_async_create shall perform the lookup before returning. ]*/
+    TEST_FUNCTION(dns_async__create_thread_fails__looks_up_synchronously)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns;
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(tickcounter_create());
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(THREADAPI_NO_MEMORY);
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(getaddrinfo("fake.com", NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns), "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    TEST_FUNCTION(dns_async__create_after_tick_counter_wraps__reuses_lookup)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns1;
+        DNS_ASYNC_HANDLE dns2;
+        fake_now_ms = (tickcounter_ms_t)0 - 1000;
+        dns1 = create_completed_lookup("fake.com", NULL);
+        dns_async_destroy(dns1);
+        fake_now_ms += 2000;
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_IS_NULL(captured_thread_func);
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns2), "Unexpected non-completion");
+
+        ///cleanup
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_026: [ A successful lookup shall be reused for cache_ttl_seconds after its completion and a failed lookup for negative_cache_ttl_seconds, as measured by the tick counter. ]*/
+    TEST_FUNCTION(dns_async__tick_counter_fails_at_completion__does_not_reuse_lookup)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns1 = dns_async_create("fake.com", NULL);
+        DNS_ASYNC_HANDLE dns2;
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG)).SetReturn(__LINE__);
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        run_lookup_thread();
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns1), "Unexpected non-completion");
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_IS_NOT_NULL(captured_thread_func);
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(dns2), "Unexpected reuse of a lookup without completion time");
+
+        ///cleanup
+        dns_async_destroy(dns1);
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_016: [ dns_async_create shall remove from the cache the completed lookups whose time to live has elapsed. ]*/
+    TEST_FUNCTION(dns_async__tick_counter_fails_at_create__removes_completed_lookups)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", NULL);
+        dns_async_destroy(dns1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG)).SetReturn(__LINE__);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));  // exited worker
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns2 = dns_async_create("fake.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_025: [ A worker thread that has exited shall be joined before another one is started in its place. ]*/
+    TEST_FUNCTION(dns_async__create_after_worker_exited__joins_it)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = create_completed_lookup("fake.com", NULL);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns2 = dns_async_create("other.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns1);
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_027: [ A worker thread shall perform the lookups waiting in the cache, oldest first, and exit when none is left. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_028: [ If DNS_ASYNC_MAX_WORKER_THREADS worker threads are running, dns_async_create shall leave the lookup waiting in the cache for the first of them that is done. ]*/
+    TEST_FUNCTION(dns_async__create_with_all_workers_busy__waits_for_a_worker)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE busy[DNS_ASYNC_MAX_WORKER_THREADS];
+        DNS_ASYNC_HANDLE waiting1;
+        DNS_ASYNC_HANDLE waiting2;
+        char hostname[32];
+        size_t i;
+        for (i = 0; i < DNS_ASYNC_MAX_WORKER_THREADS; i++)
+        {
+            (void)sprintf(hostname, "busy%lu.com", (unsigned long)i);
+            busy[i] = dns_async_create(hostname, NULL);
+            ASSERT_IS_NOT_NULL(busy[i]);
+        }
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        waiting1 = dns_async_create("waiting1.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(waiting1);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, DNS_ASYNC_MAX_WORKER_THREADS, thread_create_count);
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(waiting1), "Unexpected completion");
+
+        // the last worker started performs its own lookup, then the waiting ones, oldest first
+        waiting2 = dns_async_create("waiting2.com", NULL);
+        umock_c_reset_all_calls();
+        (void)sprintf(hostname, "busy%lu.com", (unsigned long)(DNS_ASYNC_MAX_WORKER_THREADS - 1));
+        STRICT_EXPECTED_CALL(getaddrinfo(hostname, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(getaddrinfo("waiting1.com", NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(getaddrinfo("waiting2.com", NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // addresses
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        run_lookup_thread();
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(waiting1), "Unexpected non-completion");
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(waiting2), "Unexpected non-completion");
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(busy[0]), "Unexpected completion");
+
+        ///cleanup
+        for (i = 0; i < DNS_ASYNC_MAX_WORKER_THREADS; i++)
+        {
+            dns_async_destroy(busy[i]);
+        }
+        dns_async_destroy(waiting1);
+        dns_async_destroy(waiting2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_029: [ If ThreadAPI_Create fails while another worker thread is running, dns_async_create shall leave the lookup waiting in the cache for it. ]*/
+    TEST_FUNCTION(dns_async__create_thread_fails_while_worker_runs__waits_for_it)
+    {
+        ///arrange
+        THREAD_START_FUNC running_thread_func;
+        void* running_thread_arg;
+        DNS_ASYNC_HANDLE dns2;
+        DNS_ASYNC_HANDLE dns1 = dns_async_create("fake.com", NULL);
+        running_thread_func = captured_thread_func;
+        running_thread_arg = captured_thread_arg;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // instance
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(THREADAPI_NO_MEMORY);
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        dns2 = dns_async_create("other.com", NULL);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(dns2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_FALSE(dns_async_is_lookup_complete(dns2), "Unexpected synchronous lookup");
+        captured_thread_func = running_thread_func;
+        captured_thread_arg = running_thread_arg;
+        run_lookup_thread();
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns1), "Unexpected non-completion");
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns2), "Unexpected non-completion");
+
+        ///cleanup
+        dns_async_destroy(dns1);
+        dns_async_destroy(dns2);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_060: [ dns_async_init shall create the lock guarding the cache shared by all lookups. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_063: [ dns_async_init shall create the tick counter measuring the time to live of the cached lookups. ]*/
+    TEST_FUNCTION(dns_async__init__succeeds)
+    {
+        ///arrange
+        int result;
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(tickcounter_create());
+
+        ///act
+        result = dns_async_init();
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_061: [ If the cache already exists, dns_async_init shall do nothing and return 0. ]*/
+    TEST_FUNCTION(dns_async__init_twice__does_nothing)
+    {
+        ///arrange
+        int result;
+        ASSERT_ARE_EQUAL(int, 0, dns_async_init());
+        umock_c_reset_all_calls();
+
+        ///act
+        result = dns_async_init();
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_062: [ If Lock_Init fails, dns_async_init shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__init_lock_fails__fails)
+    {
+        ///arrange
+        int result;
+        STRICT_EXPECTED_CALL(Lock_Init()).SetReturn(NULL);
+
+        ///act
+        result = dns_async_init();
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_064: [ If tickcounter_create fails, dns_async_init shall destroy the lock, log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__init_tickcounter_fails__fails)
+    {
+        ///arrange
+        int result;
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(tickcounter_create()).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        ///act
+        result = dns_async_init();
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_070: [ If the cache does not exist, dns_async_deinit shall do nothing. ]*/
+    TEST_FUNCTION(dns_async__deinit_without_init__does_nothing)
+    {
+        ///arrange
+
+        ///act
+        dns_async_deinit();
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_071: [ dns_async_deinit shall wait for the lookups in progress and release all cached lookups. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_072: [ dns_async_deinit shall destroy the tick counter and the lock guarding the cache. ]*/
+    TEST_FUNCTION(dns_async__deinit__joins_and_releases_lookups)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        dns_async_destroy(dns);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // copy hostname
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_NUM_ARG));  // cache entry
+        STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        ///act
+        dns_async_deinit();
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
 
 END_TEST_SUITE(dns_async_ut)
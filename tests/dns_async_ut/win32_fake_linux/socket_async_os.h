@@ -15,7 +15,9 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 
+#define    AF_UNSPEC      0
 #define    AF_INET        2
+#define    AF_INET6       23
 #define    SOCK_STREAM    1
 #define IPPROTO_TCP     6
 
@@ -33,6 +35,18 @@ extern "C" {
         struct in_addr  sin_addr;   /* internet address */
     };
 
+    struct in6_addr {
+        uint8_t         s6_addr[16];    /* IPv6 address */
+    };
+
+    struct sockaddr_in6 {
+        uint16_t        sin6_family;    /* address family: AF_INET6 */
+        uint16_t        sin6_port;      /* port in network byte order */
+        uint32_t        sin6_flowinfo;  /* IPv6 flow information */
+        struct in6_addr sin6_addr;      /* IPv6 address */
+        uint32_t        sin6_scope_id;  /* scope ID */
+    };
+
     struct sockaddr {
         uint8_t         sin_family; /* address family: AF_INET */
         uint16_t        sin_port;   /* port in network byte order */
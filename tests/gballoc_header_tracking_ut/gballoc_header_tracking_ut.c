@@ -0,0 +1,606 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#if defined(GB_MEASURE_MEMORY_FOR_THIS)
+#undef GB_MEASURE_MEMORY_FOR_THIS
+#endif
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/lock.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)~(size_t)0)
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4244;
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_calloc, size_t, nmemb, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_realloc, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+
+    MOCKABLE_FUNCTION(, LOCK_HANDLE, Lock_Init);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Unlock, LOCK_HANDLE, handle);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_mock_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_mock_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+static size_t untracked_pointer_count;
+
+#ifdef __cplusplus
+extern "C"
+#endif
+void test_on_untracked_pointer(void* ptr)
+{
+    (void)ptr;
+    untracked_pointer_count++;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(GBAlloc_HeaderTracking_UnitTests)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_calloc, my_mock_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_realloc, my_mock_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    untracked_pointer_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    gballoc_deinit();
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* gballoc_init */
+
+/* Tests_SRS_GBALLOC_01_002: [Upon initialization the total memory used and maximum total memory used tracked by the module shall be set to 0.] */
+TEST_FUNCTION(gballoc_init_resets_memory_used)
+{
+    // arrange
+    void* block;
+    ASSERT_ARE_EQUAL(int, 0, gballoc_init());
+    block = gballoc_malloc(1);
+    gballoc_free(block);
+    gballoc_deinit();
+    umock_c_reset_all_calls();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, gballoc_init());
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getAllocationCount());
+}
+
+/* Tests_SRS_GBALLOC_01_027: [If the Lock creation fails, gballoc_init shall return a non-zero value.] */
+TEST_FUNCTION(when_lock_init_fails_gballoc_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn((LOCK_HANDLE)NULL);
+
+    // act
+    result = gballoc_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_malloc */
+
+/* Tests_SRS_GBALLOC_01_052: [ When GB_USE_HEADER_TRACKING is defined, gballoc_malloc shall allocate size bytes plus a header holding size and return the memory following the header. ]*/
+/* Tests_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
+TEST_FUNCTION(gballoc_malloc_allocates_the_block_with_its_header_without_locking)
+{
+    // arrange
+    unsigned char* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = (unsigned char*)gballoc_malloc(42);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)memset(result, 0x42, 42);
+    ASSERT_ARE_EQUAL(size_t, 42, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 42, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 1, gballoc_getAllocationCount());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
+TEST_FUNCTION(when_malloc_fails_then_gballoc_malloc_fails_too)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_malloc(1);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getMaximumMemoryUsed());
+}
+
+TEST_FUNCTION(gballoc_malloc_with_a_size_that_overflows_with_the_header_fails)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_malloc(SIZE_MAX);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_calloc */
+
+/* Tests_SRS_GBALLOC_01_053: [ When GB_USE_HEADER_TRACKING is defined, gballoc_calloc shall call calloc for nmemb * size bytes plus the header. ]*/
+/* Tests_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
+TEST_FUNCTION(gballoc_calloc_with_2_items_of_3_bytes_counts_6_bytes)
+{
+    // arrange
+    unsigned char* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_calloc(1, IGNORED_NUM_ARG));
+
+    // act
+    result = (unsigned char*)gballoc_calloc(2, 3);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result[0] | result[1] | result[2] | result[3] | result[4] | result[5]);
+    ASSERT_ARE_EQUAL(size_t, 6, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_022: [When the underlying calloc call fails, gballoc_calloc shall return NULL and size should not be counted towards total memory used.] */
+TEST_FUNCTION(when_calloc_fails_then_gballoc_calloc_fails_too)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_calloc(1, IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_calloc(2, 3);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+TEST_FUNCTION(gballoc_calloc_with_a_size_that_overflows_fails)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_calloc(SIZE_MAX / 2, 3);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_realloc */
+
+/* Tests_SRS_GBALLOC_01_017: [When ptr is NULL, gballoc_realloc shall call the underlying realloc with ptr being NULL and the realloc result shall be tracked by gballoc.] */
+TEST_FUNCTION(gballoc_realloc_with_NULL_tracks_the_new_block)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_realloc(NULL, IGNORED_NUM_ARG));
+
+    // act
+    result = gballoc_realloc(NULL, 5);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 5, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_054: [ When GB_USE_HEADER_TRACKING is defined, gballoc_realloc and gballoc_free shall find the size of ptr in its header without searching and without acquiring the lock. ]*/
+/* Tests_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
+/* Tests_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
+/* Tests_SRS_GBALLOC_01_057: [ When GB_USE_HEADER_TRACKING is defined, gballoc_getMaximumMemoryUsed shall return the sum of the per shard maximums. ]*/
+TEST_FUNCTION(gballoc_realloc_replaces_the_counted_size_and_keeps_the_content)
+{
+    // arrange
+    unsigned char* block;
+    unsigned char* result;
+    (void)gballoc_init();
+    block = (unsigned char*)gballoc_malloc(2);
+    block[0] = 0x42;
+    block[1] = 0x43;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    // act
+    result = (unsigned char*)gballoc_realloc(block, 100);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0x42, result[0]);
+    ASSERT_ARE_EQUAL(int, 0x43, result[1]);
+    ASSERT_ARE_EQUAL(size_t, 100, gballoc_getCurrentMemoryUsed());
+    /* the 2 bytes stay in the maximum of the old shard when the block moved to another one */
+    ASSERT_IS_TRUE((gballoc_getMaximumMemoryUsed() == 100) || (gballoc_getMaximumMemoryUsed() == 102));
+    ASSERT_ARE_EQUAL(size_t, 2, gballoc_getAllocationCount());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+TEST_FUNCTION(when_realloc_fails_then_gballoc_realloc_fails_and_the_counters_are_unchanged)
+{
+    // arrange
+    void* block;
+    void* result;
+    (void)gballoc_init();
+    block = gballoc_malloc(2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_realloc(block, 100);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 2, gballoc_getMaximumMemoryUsed());
+
+    // cleanup
+    gballoc_free(block);
+}
+
+/* Tests_SRS_GBALLOC_01_016: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_realloc shall return NULL and the underlying realloc shall not be called.] */
+TEST_FUNCTION(when_the_pointer_is_not_tracked_gballoc_realloc_returns_NULL)
+{
+    // arrange
+    unsigned char untracked[128];
+    void* result;
+    (void)gballoc_init();
+    (void)memset(untracked, 0, sizeof(untracked));
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_realloc(untracked + 64, 1);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, 1, untracked_pointer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+/* gballoc_free */
+
+/* Tests_SRS_GBALLOC_01_008: [gballoc_free shall call the C99 free function.] */
+/* Tests_SRS_GBALLOC_01_009: [gballoc_free shall also look up the size associated with the ptr pointer and decrease the total memory used with the associated size amount.] */
+/* Tests_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
+TEST_FUNCTION(gballoc_free_frees_the_block_and_its_header_without_locking)
+{
+    // arrange
+    void* block;
+    (void)gballoc_init();
+    block = gballoc_malloc(10);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG));
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 10, gballoc_getMaximumMemoryUsed());
+}
+
+/* Tests_SRS_GBALLOC_01_019: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_free shall not free any memory.] */
+TEST_FUNCTION(gballoc_free_with_an_untracked_pointer_does_not_free)
+{
+    // arrange
+    unsigned char untracked[128];
+    void* block;
+    (void)gballoc_init();
+    (void)memset(untracked, 0, sizeof(untracked));
+    block = gballoc_malloc(1);
+    umock_c_reset_all_calls();
+
+    // act
+    gballoc_free(untracked + 64);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, untracked_pointer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(block);
+}
+
+TEST_FUNCTION(gballoc_free_with_NULL_does_nothing)
+{
+    // arrange
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    // act
+    gballoc_free(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_getCurrentMemoryUsed */
+
+/* Tests_SRS_GBALLOC_01_055: [ When GB_USE_HEADER_TRACKING is defined, gballoc_getCurrentMemoryUsed and gballoc_getAllocationCount shall return the sum of the per shard counters. ]*/
+TEST_FUNCTION(gballoc_getCurrentMemoryUsed_sums_many_blocks)
+{
+    // arrange
+    void* blocks[100];
+    size_t i;
+    size_t result;
+    (void)gballoc_init();
+    for (i = 0; i < 100; i++)
+    {
+        blocks[i] = gballoc_malloc(i + 1);
+    }
+    for (i = 0; i < 50; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_getCurrentMemoryUsed();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, (100 * 101 / 2) - (50 * 51 / 2), result);
+    ASSERT_ARE_EQUAL(size_t, 100 * 101 / 2, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 100, gballoc_getAllocationCount());
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    for (i = 50; i < 100; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+}
+
+/* gballoc_getMaximumMemoryUsed */
+
+/* Tests_SRS_GBALLOC_01_056: [ When GB_USE_HEADER_TRACKING is defined, every shard shall keep the maximum of its own total memory used. ]*/
+TEST_FUNCTION(gballoc_getMaximumMemoryUsed_keeps_the_peak_when_a_freed_block_is_allocated_again)
+{
+    // arrange
+    void* block;
+    size_t result;
+    (void)gballoc_init();
+    block = gballoc_malloc(30);
+    gballoc_free(block);
+    block = gballoc_malloc(20);
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_getMaximumMemoryUsed();
+
+    // assert
+    ASSERT_IS_TRUE((result == 30) || (result == 50));
+    ASSERT_ARE_EQUAL(size_t, 20, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(block);
+}
+
+/* Tests_SRS_GBALLOC_01_056: [ When GB_USE_HEADER_TRACKING is defined, every shard shall keep the maximum of its own total memory used. ]*/
+TEST_FUNCTION(gballoc_getMaximumMemoryUsed_is_not_raised_by_a_shard_below_zero)
+{
+    // arrange
+    void* block = gballoc_malloc(10);
+    void* other_block;
+    size_t result;
+    (void)gballoc_init();
+    gballoc_free(block);
+    other_block = gballoc_malloc(1);
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_getMaximumMemoryUsed();
+
+    // assert
+    ASSERT_IS_TRUE(result <= 1);
+
+    // cleanup
+    gballoc_free(other_block);
+}
+
+/* Tests_SRS_GBALLOC_01_044: [If gballoc was not initialized gballoc_getCurrentMemoryUsed shall return SIZE_MAX.] */
+TEST_FUNCTION(gballoc_getCurrentMemoryUsed_without_init_returns_SIZE_MAX)
+{
+    // arrange
+
+    // act
+    size_t result = gballoc_getCurrentMemoryUsed();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, SIZE_MAX, result);
+}
+
+TEST_FUNCTION(blocks_allocated_before_init_can_be_freed_after_init)
+{
+    // arrange
+    void* block = gballoc_malloc(10);
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG));
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_resetMetrics */
+
+/* Tests_SRS_GBALLOC_07_006: [ gballoc_resetMetrics shall ensure thread safety by using the lock created by gballoc_Init ]*/
+/* Tests_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
+TEST_FUNCTION(gballoc_resetMetrics_resets_all_counters)
+{
+    // arrange
+    void* block;
+    (void)gballoc_init();
+    block = gballoc_malloc(10);
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    gballoc_resetMetrics();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getAllocationCount());
+}
+
+END_TEST_SUITE(GBAlloc_HeaderTracking_UnitTests)
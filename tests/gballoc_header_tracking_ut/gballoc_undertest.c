@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#define malloc mock_malloc
+#define calloc mock_calloc
+#define realloc mock_realloc
+#define free mock_free
+
+extern void* mock_malloc(size_t size);
+extern void* mock_calloc(size_t nmemb, size_t size);
+extern void* mock_realloc(void* ptr, size_t size);
+extern void mock_free(void* ptr);
+
+/* the tests feed untracked pointers on purpose, so they count the reports instead of asserting */
+extern void test_on_untracked_pointer(void* ptr);
+#define GBALLOC_UNTRACKED_POINTER(ptr) test_on_untracked_pointer(ptr)
+
+#undef _CRTDBG_MAP_ALLOC
+#ifndef GB_USE_HEADER_TRACKING
+#define GB_USE_HEADER_TRACKING
+#endif
+#include "../src/gballoc.c"
@@ -0,0 +1,590 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#if defined(GB_MEASURE_MEMORY_FOR_THIS)
+#undef GB_MEASURE_MEMORY_FOR_THIS
+#endif
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)~(size_t)0)
+#endif
+
+/* the pool keeps its slabs and thread cache for the lifetime of the process, so every test uses its own size class */
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_calloc, size_t, nmemb, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_realloc, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    extern void* gballoc_malloc(size_t size);
+    extern void* gballoc_calloc(size_t nmemb, size_t size);
+    extern void* gballoc_realloc(void* ptr, size_t size);
+    extern void gballoc_free(void* ptr);
+#ifdef __cplusplus
+}
+#endif
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define THREAD_BLOCK_COUNT 40
+
+static int allocate_and_free_blocks(void* arg)
+{
+    void* blocks[THREAD_BLOCK_COUNT];
+    size_t i;
+    (void)arg;
+    for (i = 0; i < THREAD_BLOCK_COUNT; i++)
+    {
+        blocks[i] = gballoc_malloc(90);
+    }
+    for (i = 0; i < THREAD_BLOCK_COUNT; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(GBAlloc_Pool_UnitTests)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* gballoc_malloc */
+
+/* Tests_SRS_GBALLOC_POOL_01_001: [ If size is at most 256, gballoc_malloc shall return a block of the smallest size class that can hold size bytes. ]*/
+/* Tests_SRS_GBALLOC_POOL_01_003: [ If the thread has no cached block for the class, gballoc_malloc shall move up to 16 free blocks of the class to the thread cache. ]*/
+/* Tests_SRS_GBALLOC_POOL_01_004: [ If the class has no free blocks, gballoc_malloc shall allocate a slab of 64 blocks by calling malloc. ]*/
+TEST_FUNCTION(the_first_small_allocation_of_a_class_allocates_one_slab_for_64_blocks)
+{
+    // arrange
+    void* blocks[64];
+    size_t i;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG));
+
+    // act
+    for (i = 0; i < 64; i++)
+    {
+        blocks[i] = gballoc_malloc(20);
+        ASSERT_IS_NOT_NULL(blocks[i]);
+        (void)memset(blocks[i], (int)i, 20);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    for (i = 0; i < 64; i++)
+    {
+        ASSERT_ARE_EQUAL(int, (int)i, ((unsigned char*)blocks[i])[19]);
+    }
+
+    // cleanup
+    for (i = 0; i < 64; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_002: [ The block shall be taken from the free blocks cached by the calling thread for that class. ]*/
+/* Tests_SRS_GBALLOC_POOL_01_015: [ If ptr belongs to a size class, gballoc_free shall add it to the free blocks cached by the calling thread. ]*/
+TEST_FUNCTION(a_freed_small_block_is_reused_without_calling_malloc_or_free)
+{
+    // arrange
+    void* block = gballoc_malloc(40);
+    void* result;
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_malloc(33);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, block, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_005: [ If allocating the slab fails, gballoc_malloc shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_slab_fails_gballoc_malloc_fails)
+{
+    // arrange
+    void* result;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_malloc(64);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_006: [ If size is larger than 256, gballoc_malloc shall call malloc for size bytes plus the header and return the memory following the header. ]*/
+/* Tests_SRS_GBALLOC_POOL_01_017: [ If ptr is a large block, gballoc_free shall call free on its header. ]*/
+/* Tests_SRS_GBALLOC_POOL_01_021: [ gballoc_pool_get_large_allocation_count shall return the number of blocks larger than 256 bytes allocated so far. ]*/
+TEST_FUNCTION(large_blocks_are_allocated_and_freed_with_the_C_runtime)
+{
+    // arrange
+    size_t large_allocation_count = gballoc_pool_get_large_allocation_count();
+    void* result;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG));
+
+    // act
+    result = gballoc_malloc(1000);
+    ASSERT_IS_NOT_NULL(result);
+    (void)memset(result, 0x42, 1000);
+    gballoc_free(result);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, large_allocation_count + 1, gballoc_pool_get_large_allocation_count());
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_007: [ If malloc fails, gballoc_malloc shall return NULL. ]*/
+TEST_FUNCTION(when_malloc_fails_for_a_large_block_gballoc_malloc_fails)
+{
+    // arrange
+    void* result;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_malloc(1000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_calloc */
+
+/* Tests_SRS_GBALLOC_POOL_01_009: [ Otherwise gballoc_calloc shall allocate nmemb * size bytes as gballoc_malloc does and set them to 0. ]*/
+TEST_FUNCTION(gballoc_calloc_returns_a_zeroed_block_even_when_the_block_is_reused)
+{
+    // arrange
+    unsigned char* block = (unsigned char*)gballoc_malloc(80);
+    unsigned char* result;
+    size_t i;
+    (void)memset(block, 0xFF, 80);
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    // act
+    result = (unsigned char*)gballoc_calloc(8, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, block, result);
+    for (i = 0; i < 80; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, result[i]);
+    }
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_008: [ If nmemb * size overflows, gballoc_calloc shall fail and return NULL. ]*/
+TEST_FUNCTION(gballoc_calloc_with_an_overflowing_size_fails)
+{
+    // arrange
+    void* result;
+
+    // act
+    result = gballoc_calloc(SIZE_MAX / 2, 3);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_realloc */
+
+/* Tests_SRS_GBALLOC_POOL_01_010: [ If ptr is NULL, gballoc_realloc shall behave as gballoc_malloc. ]*/
+TEST_FUNCTION(gballoc_realloc_with_NULL_allocates_a_block)
+{
+    // arrange
+    void* result;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = gballoc_realloc(NULL, 500);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_011: [ If the size class of ptr can hold size bytes, gballoc_realloc shall return ptr. ]*/
+TEST_FUNCTION(gballoc_realloc_within_the_size_class_returns_the_same_block)
+{
+    // arrange
+    void* block = gballoc_malloc(100);
+    void* result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_realloc(block, 128);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, block, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_012: [ Otherwise gballoc_realloc shall allocate a new block as gballoc_malloc does, copy the content of ptr into it and free ptr. ]*/
+TEST_FUNCTION(gballoc_realloc_to_a_larger_class_copies_the_content)
+{
+    // arrange
+    unsigned char* block = (unsigned char*)gballoc_malloc(150);
+    unsigned char* result;
+    (void)memset(block, 0x42, 150);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = (unsigned char*)gballoc_realloc(block, 2000);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, block, result);
+    ASSERT_ARE_EQUAL(int, 0x42, result[0]);
+    ASSERT_ARE_EQUAL(int, 0x42, result[149]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_013: [ If allocating the new block fails, gballoc_realloc shall return NULL and leave ptr untouched. ]*/
+TEST_FUNCTION(when_allocating_the_new_block_fails_gballoc_realloc_fails)
+{
+    // arrange
+    unsigned char* block = (unsigned char*)gballoc_malloc(150);
+    void* result;
+    block[0] = 0x42;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn((void*)NULL);
+
+    // act
+    result = gballoc_realloc(block, 2000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0x42, block[0]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    gballoc_free(block);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_023: [ If the header of ptr does not hold the class of a block in use, gballoc_realloc shall fail and return NULL. ]*/
+TEST_FUNCTION(gballoc_realloc_of_a_freed_block_fails)
+{
+    // arrange
+    void* block = gballoc_malloc(180);
+    void* result;
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_realloc(block, 10);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_free */
+
+/* Tests_SRS_GBALLOC_POOL_01_014: [ If ptr is NULL, gballoc_free shall do nothing. ]*/
+TEST_FUNCTION(gballoc_free_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    gballoc_free(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_022: [ If the header of ptr does not hold the class of a block in use, gballoc_free shall not free anything. ]*/
+TEST_FUNCTION(gballoc_free_of_a_block_already_freed_does_not_free_it_again)
+{
+    // arrange
+    void* block = gballoc_malloc(180);
+    void* block1;
+    void* block2;
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    /* a block that went twice in the free list would be handed out twice */
+    block1 = gballoc_malloc(180);
+    block2 = gballoc_malloc(180);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, block1, block2);
+
+    // cleanup
+    gballoc_free(block1);
+    gballoc_free(block2);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_022: [ If the header of ptr does not hold the class of a block in use, gballoc_free shall not free anything. ]*/
+TEST_FUNCTION(gballoc_free_of_a_pointer_with_an_invalid_class_does_not_free_it)
+{
+    // arrange
+    size_t foreign[8];
+    (void)memset(foreign, 0x7F, sizeof(foreign));
+
+    // act
+    gballoc_free(&foreign[4]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_016: [ If the thread cache then holds more than 32 blocks of the class, gballoc_free shall move 16 of them back to the class. ]*/
+TEST_FUNCTION(blocks_given_back_by_the_thread_cache_are_reused_without_a_new_slab)
+{
+    // arrange
+    void* blocks[64];
+    size_t i;
+    for (i = 0; i < 64; i++)
+    {
+        blocks[i] = gballoc_malloc(250);
+    }
+    for (i = 0; i < 64; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+    umock_c_reset_all_calls();
+
+    // act
+    for (i = 0; i < 64; i++)
+    {
+        blocks[i] = gballoc_malloc(250);
+        ASSERT_IS_NOT_NULL(blocks[i]);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    for (i = 0; i < 64; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+}
+
+/* gballoc_pool_get_class_count */
+
+/* Tests_SRS_GBALLOC_POOL_01_018: [ gballoc_pool_get_class_count shall return the number of size classes. ]*/
+TEST_FUNCTION(gballoc_pool_get_class_count_returns_8)
+{
+    // arrange
+
+    // act
+    size_t result = gballoc_pool_get_class_count();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 8, result);
+}
+
+/* gballoc_pool_get_class_statistics */
+
+/* Tests_SRS_GBALLOC_POOL_01_019: [ If class_index is not smaller than the number of classes or statistics is NULL, gballoc_pool_get_class_statistics shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(gballoc_pool_get_class_statistics_with_an_invalid_class_fails)
+{
+    // arrange
+    GBALLOC_POOL_CLASS_STATISTICS statistics;
+
+    // act
+    int result = gballoc_pool_get_class_statistics(8, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_019: [ If class_index is not smaller than the number of classes or statistics is NULL, gballoc_pool_get_class_statistics shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(gballoc_pool_get_class_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+
+    // act
+    int result = gballoc_pool_get_class_statistics(0, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_POOL_01_020: [ gballoc_pool_get_class_statistics shall merge the statistics of the calling thread into the class and fill statistics with the block size, reserved blocks, blocks in use, allocations and thread cache hits of the class, then return 0. ]*/
+TEST_FUNCTION(gballoc_pool_get_class_statistics_reports_the_activity_of_the_class)
+{
+    // arrange
+    GBALLOC_POOL_CLASS_STATISTICS before;
+    GBALLOC_POOL_CLASS_STATISTICS after;
+    void* block1;
+    void* block2;
+    int result;
+    ASSERT_ARE_EQUAL(int, 0, gballoc_pool_get_class_statistics(0, &before));
+    block1 = gballoc_malloc(1);
+    block2 = gballoc_malloc(16);
+    gballoc_free(block1);
+
+    // act
+    result = gballoc_pool_get_class_statistics(0, &after);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 16, after.block_size);
+    ASSERT_ARE_EQUAL(size_t, 64, after.blocks_reserved);
+    ASSERT_ARE_EQUAL(size_t, before.blocks_in_use + 1, after.blocks_in_use);
+    ASSERT_ARE_EQUAL(size_t, before.allocations + 2, after.allocations);
+    ASSERT_ARE_EQUAL(size_t, before.cache_hits + 1, after.cache_hits);
+
+    // cleanup
+    gballoc_free(block2);
+}
+
+/* thread exit */
+
+/* Tests_SRS_GBALLOC_POOL_01_024: [ When a thread that allocated or freed blocks exits, the blocks cached by the thread and its statistics shall be given back to their classes. ]*/
+TEST_FUNCTION(the_blocks_and_statistics_of_an_exited_thread_are_given_back_to_the_class)
+{
+    // arrange
+    GBALLOC_POOL_CLASS_STATISTICS before;
+    GBALLOC_POOL_CLASS_STATISTICS after;
+    THREAD_HANDLE thread;
+    int thread_result;
+    void* blocks[64];
+    size_t i;
+    ASSERT_ARE_EQUAL(int, 0, gballoc_pool_get_class_statistics(4, &before));
+
+    // act
+    ASSERT_ARE_EQUAL(int, (int)THREADAPI_OK, (int)ThreadAPI_Create(&thread, allocate_and_free_blocks, NULL));
+    ASSERT_ARE_EQUAL(int, (int)THREADAPI_OK, (int)ThreadAPI_Join(thread, &thread_result));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_pool_get_class_statistics(4, &after));
+    ASSERT_ARE_EQUAL(size_t, 96, after.block_size);
+    ASSERT_ARE_EQUAL(size_t, before.blocks_in_use, after.blocks_in_use);
+    ASSERT_ARE_EQUAL(size_t, before.allocations + THREAD_BLOCK_COUNT, after.allocations);
+
+    /* the blocks the thread had cached can be used without reserving another slab */
+    ASSERT_ARE_EQUAL(size_t, 64, after.blocks_reserved);
+    umock_c_reset_all_calls();
+    for (i = 0; i < (after.blocks_reserved - after.blocks_in_use); i++)
+    {
+        blocks[i] = gballoc_malloc(90);
+    }
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    while (i > 0)
+    {
+        gballoc_free(blocks[--i]);
+    }
+}
+
+END_TEST_SUITE(GBAlloc_Pool_UnitTests)
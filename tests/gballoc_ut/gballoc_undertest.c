@@ -13,4 +13,5 @@ extern void* mock_realloc(void* ptr, size_t size);
 extern void mock_free(void* ptr);
 
 #undef _CRTDBG_MAP_ALLOC
+#undef GB_USE_HEADER_TRACKING
 #include "../src/gballoc.c"
@@ -165,4 +165,149 @@ TEST_FUNCTION(HMACSHA256_ComputeHash_Succeeds)
     ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedHash, 8));
 }
 
+/* HMACSHA256_InitContext */
+
+TEST_FUNCTION(HMACSHA256_InitContext_With_NULL_Context_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_InitContext(NULL, key, sizeof(key) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_InitContext_With_NULL_Key_Fails)
+{
+    // arrange
+    HMACSHA256_CONTEXT context;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_InitContext(&context, NULL, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_InitContext_With_Zero_Key_Buffer_Size_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    HMACSHA256_CONTEXT context;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_InitContext(&context, key, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+/* HMACSHA256_ComputeHashWithContext */
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithContext_With_NULL_Context_Fails)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+    unsigned char output[HMACSHA256_HASH_SIZE];
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithContext(NULL, buffer, sizeof(buffer) - 1, output);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithContext_With_NULL_Payload_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    HMACSHA256_CONTEXT context;
+    unsigned char output[HMACSHA256_HASH_SIZE];
+    HMACSHA256_RESULT result;
+    (void)HMACSHA256_InitContext(&context, key, sizeof(key) - 1);
+
+    // act
+    result = HMACSHA256_ComputeHashWithContext(&context, NULL, 11, output);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_DeinitContext(&context);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithContext_With_NULL_Hash_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_CONTEXT context;
+    HMACSHA256_RESULT result;
+    (void)HMACSHA256_InitContext(&context, key, sizeof(key) - 1);
+
+    // act
+    result = HMACSHA256_ComputeHashWithContext(&context, buffer, sizeof(buffer) - 1, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_DeinitContext(&context);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithContext_Succeeds_Several_Times)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    unsigned char expectedHash[32] = { 108, 7, 130, 47, 104, 233, 39, 188, 126, 122, 134, 187, 63, 19, 52, 120, 172, 7, 43, 25, 133, 60, 92, 217, 59, 59, 69, 116, 85, 104, 55, 224 };
+    HMACSHA256_CONTEXT context;
+    unsigned char output[HMACSHA256_HASH_SIZE];
+    int i;
+
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, HMACSHA256_InitContext(&context, key, sizeof(key) - 1));
+
+    for (i = 0; i < 3; i++)
+    {
+        // act
+        HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithContext(&context, buffer, sizeof(buffer) - 1, output);
+
+        // assert
+        ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(output, expectedHash, HMACSHA256_HASH_SIZE));
+    }
+
+    // cleanup
+    HMACSHA256_DeinitContext(&context);
+}
+
+/* RFC 4231 test case 6 */
+TEST_FUNCTION(HMACSHA256_ComputeHashWithContext_With_Key_Longer_Than_Block_Succeeds)
+{
+    // arrange
+    static const unsigned char buffer[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+    unsigned char expectedHash[32] = {
+        0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f,
+        0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54
+    };
+    unsigned char key[131];
+    HMACSHA256_CONTEXT context;
+    unsigned char output[HMACSHA256_HASH_SIZE];
+    HMACSHA256_RESULT result;
+    (void)memset(key, 0xaa, sizeof(key));
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, HMACSHA256_InitContext(&context, key, sizeof(key)));
+
+    // act
+    result = HMACSHA256_ComputeHashWithContext(&context, buffer, sizeof(buffer) - 1, output);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(output, expectedHash, HMACSHA256_HASH_SIZE));
+
+    // cleanup
+    HMACSHA256_DeinitContext(&context);
+}
+
 END_TEST_SUITE(HMACSHA256_UnitTests)
@@ -83,6 +83,7 @@ void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/buffer_.h"
 #undef ENABLE_MOCKS
@@ -152,7 +153,6 @@ static const int xio_send_e[4] = { 123, 123, 123, 123 };
 static const int xio_send_0_e[4] = { 0, 123, 0, 0 };
 static const int xio_send_00_e[4] = { 0, 0, 123, 0 };
 static const int xio_send_7x0[7] = { 0, 0, 0, 0, 0, 0, 0 };
-static const int xio_send_6x0_e[7] = { 0, 0, 0, 0, 0, 0, 123 };
 static const xio_dowork_job doworkjob_end[1] = { XIO_DOWORK_JOB_END };
 static const xio_dowork_job doworkjob_oe[2] = { XIO_DOWORK_JOB_OPEN, XIO_DOWORK_JOB_END };
 static const xio_dowork_job doworkjob_4none_oe[6] = { XIO_DOWORK_JOB_NONE, XIO_DOWORK_JOB_NONE, XIO_DOWORK_JOB_NONE, XIO_DOWORK_JOB_NONE, XIO_DOWORK_JOB_OPEN, XIO_DOWORK_JOB_END };
@@ -165,8 +165,8 @@ static const xio_dowork_job doworkjob_o_re[3] = { XIO_DOWORK_JOB_OPEN, XIO_DOWOR
 static const xio_dowork_job doworkjob_o_rce[8] = { XIO_DOWORK_JOB_OPEN, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_CLOSE, XIO_DOWORK_JOB_END };
 static const xio_dowork_job doworkjob_o_rc_error[9] = { XIO_DOWORK_JOB_OPEN, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_CLOSE, XIO_DOWORK_JOB_ERROR, XIO_DOWORK_JOB_END };
 static const xio_dowork_job doworkjob_o_rre[4] = { XIO_DOWORK_JOB_OPEN, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_END };
-static const xio_dowork_job doworkjob_o_sre[15] = { XIO_DOWORK_JOB_OPEN,
-    XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND,
+static const xio_dowork_job doworkjob_o_sre[10] = { XIO_DOWORK_JOB_OPEN,
+    XIO_DOWORK_JOB_SEND, XIO_DOWORK_JOB_SEND,
     XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_RECEIVED, XIO_DOWORK_JOB_CLOSE, XIO_DOWORK_JOB_END };
 
 static const IO_OPEN_RESULT openresult_ok[1] = { IO_OPEN_OK };
@@ -183,15 +183,6 @@ static const IO_SEND_RESULT sendresult_7ok[7] = {
         IO_SEND_OK,
         IO_SEND_OK
 };
-static const IO_SEND_RESULT sendresult_6ok_error[7] = {
-    IO_SEND_OK,
-    IO_SEND_OK,
-    IO_SEND_OK,
-    IO_SEND_OK,
-    IO_SEND_OK,
-    IO_SEND_OK,
-    IO_SEND_ERROR
-};
 
 
 static const xio_dowork_job* DoworkJobs = (const xio_dowork_job*)doworkjob_end;
@@ -422,20 +413,33 @@ HTTP_HEADERS_RESULT my_HTTPHeaders_GetHeaderCount(HTTP_HEADERS_HANDLE handle, si
     return result;
 }
 
-static HTTP_HEADERS_RESULT HTTPHeaders_GetHeader_shallReturn;
-HTTP_HEADERS_RESULT my_HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t index, char** destination)
+#define TEST_SERIALIZED_HEADER "0123456789\r\n"
+static HTTP_HEADERS_RESULT HTTPHeaders_SerializeTo_shallReturn;
+static size_t HTTPHeaders_SerializeTo_size;
+HTTP_HEADERS_RESULT my_HTTPHeaders_SerializeTo(HTTP_HEADERS_HANDLE handle, char* buffer, size_t bufferSize, size_t* serializedSize)
 {
     HTTP_HEADERS_RESULT result;
 
-    if ((handle == NULL) || (destination == NULL) || (index > TEST_GET_HEADER_HEAD_COUNT))
+    if ((handle == NULL) || (serializedSize == NULL) || ((buffer == NULL) && (bufferSize > 0)))
     {
         result = HTTP_HEADERS_INVALID_ARG;
     }
     else
     {
-        *destination = (char*)malloc(11 * sizeof(char));
-        strcpy(*destination, "0123456789");
-        result = HTTPHeaders_GetHeaderCount_shallReturn;
+        *serializedSize = HTTPHeaders_SerializeTo_size;
+        if (bufferSize < HTTPHeaders_SerializeTo_size)
+        {
+            result = HTTP_HEADERS_INSUFFICIENT_BUFFER;
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < HTTPHeaders_SerializeTo_size; i++)
+            {
+                buffer[i] = TEST_SERIALIZED_HEADER[i % (sizeof(TEST_SERIALIZED_HEADER) - 1)];
+            }
+            result = HTTPHeaders_SerializeTo_shallReturn;
+        }
     }
 
     return result;
@@ -448,6 +452,26 @@ const IO_INTERFACE_DESCRIPTION* my_platform_get_default_tlsio(void)
 }
 
 
+#define TEST_TICK_COUNTER_HANDLE (TICK_COUNTER_HANDLE)0x4242
+static tickcounter_ms_t test_current_ms;
+int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = test_current_ms;
+    return 0;
+}
+
+static int async_complete_count;
+static HTTPAPI_RESULT async_complete_result;
+static unsigned int async_complete_status_code;
+static void test_on_request_complete(void* context, HTTPAPI_RESULT result, unsigned int statusCode)
+{
+    (void)context;
+    async_complete_count++;
+    async_complete_result = result;
+    async_complete_status_code = statusCode;
+}
+
 static void createHttpObjects(HTTP_HEADERS_HANDLE* requestHttpHeaders, HTTP_HEADERS_HANDLE* responseHttpHeaders)
 {
     STRICT_EXPECTED_CALL(HTTPHeaders_Alloc());
@@ -599,26 +623,8 @@ static void setupAllCallBeforeReceiveHTTPsequenceWithSuccess()
 
 static void setupAllCallBeforeSendHTTPsequenceWithSuccess(HTTP_HEADERS_HANDLE requestHttpHeaders)
 {
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
 
@@ -678,7 +684,7 @@ static void PrepareReceiveHead(HTTP_HEADERS_HANDLE requestHttpHeaders, size_t bu
             .IgnoreArgument(1);
     }
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 }
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
@@ -721,6 +727,8 @@ TEST_SUITE_INITIALIZE(setsBufferTempSize)
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, unsigned long long);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
@@ -739,9 +747,12 @@ TEST_SUITE_INITIALIZE(setsBufferTempSize)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, my_BUFFER_new);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, my_BUFFER_delete);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_GetHeaderCount, my_HTTPHeaders_GetHeaderCount);
-    REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_GetHeader, my_HTTPHeaders_GetHeader);
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPHeaders_SerializeTo, my_HTTPHeaders_SerializeTo);
 
     REGISTER_GLOBAL_MOCK_HOOK(platform_get_default_tlsio, my_platform_get_default_tlsio);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -767,6 +778,9 @@ TEST_FUNCTION_INITIALIZE(f)
 
     xio_send_transmited_buffer[0] = '\0';
 
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_size = TEST_GET_HEADER_HEAD_COUNT * (sizeof(TEST_SERIALIZED_HEADER) - 1);
+
     call_on_send_complete_in_xio_send = true;
     SkipDoworkJobsOpenResult = 0;
     SkipDoworkJobsCloseResult = 0;
@@ -775,6 +789,11 @@ TEST_FUNCTION_INITIALIZE(f)
     xio_close_shallReturn = 0;
     DoworkJobsCloseSuccess = true;
     call_on_io_close_complete_in_xio_close = true;
+
+    test_current_ms = 0;
+    async_complete_count = 0;
+    async_complete_result = HTTPAPI_ERROR;
+    async_complete_status_code = 0;
 }
 
 TEST_FUNCTION_CLEANUP(cleans)
@@ -1102,7 +1121,7 @@ TEST_FUNCTION(HTTPAPI_CloseConnection__close_on_dowork_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     xio_close_shallReturn = 0;
     DoworkJobsCloseSuccess = true;
@@ -1170,7 +1189,7 @@ TEST_FUNCTION(HTTPAPI_CloseConnection__close_on_dowork_retry_n_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     xio_close_shallReturn = 0;
     DoworkJobsCloseSuccess = true;
@@ -1244,7 +1263,7 @@ TEST_FUNCTION(HTTPAPI_CloseConnection__close_on_dowork_retry_n_failed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     xio_close_shallReturn = 0;
     DoworkJobsCloseSuccess = false;
@@ -1318,7 +1337,7 @@ TEST_FUNCTION(HTTPAPI_CloseConnection__close_timeout_failed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     xio_close_shallReturn = 0;
     DoworkJobsCloseSuccess = true;
@@ -2317,6 +2336,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__io_send_header_return_error_failed)
     setHttpx509ClientCertificateAndKey(httpHandle);
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, true);
     xio_send_shallReturn = (const int*)xio_send_e;
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
 
@@ -2344,7 +2365,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__io_send_header_return_error_failed)
 }
 
 /*Tests_SRS_HTTPAPI_COMPACT_21_028: [ If the HTTPAPI_ExecuteRequest cannot send the request header, it shall return HTTPAPI_SEND_REQUEST_FAILED. ]*/
-TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_success_before_error_failed)
+TEST_FUNCTION(HTTPAPI_ExecuteRequest__io_send_large_header_return_error_failed)
 {
     /// arrange
     unsigned int statusCode;
@@ -2357,22 +2378,20 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_success_befor
 
     DoworkJobs = (const xio_dowork_job*)doworkjob_oe;
     DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_ok;
-    DoworkJobsSendResult = (const IO_SEND_RESULT*)sendresult_o_3error;
-    xio_send_shallReturn = (const int*)xio_send_0_e;
+    xio_send_shallReturn = (const int*)xio_send_e;
+    HTTPHeaders_SerializeTo_size = 2048;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, 2048, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
-
     /// act
     result = HTTPAPI_ExecuteRequest(
         httpHandle,
@@ -2396,8 +2415,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_success_befor
     HTTPAPI_Deinit();
 }
 
-/*Tests_SRS_HTTPAPI_COMPACT_21_028: [ If the HTTPAPI_ExecuteRequest cannot send the request header, it shall return HTTPAPI_SEND_REQUEST_FAILED. ]*/
-TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_2_success_before_error_failed)
+/*Tests_SRS_HTTPAPI_COMPACT_21_027: [ If the HTTPAPI_ExecuteRequest cannot create a buffer to send the request, it shall not send any request and return HTTPAPI_STRING_PROCESSING_ERROR. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequest__serialize_header_failed)
 {
     /// arrange
     unsigned int statusCode;
@@ -2410,23 +2429,11 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_2_success_bef
 
     DoworkJobs = (const xio_dowork_job*)doworkjob_oe;
     DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_ok;
-    DoworkJobsSendResult = (const IO_SEND_RESULT*)sendresult_o_3error;
-    xio_send_shallReturn = (const int*)xio_send_00_e;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_ERROR;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2441,7 +2448,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_with_2_success_bef
         TestBufferHandle);
 
     /// assert
-    ASSERT_ARE_EQUAL(int, HTTPAPI_SEND_REQUEST_FAILED, result);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_STRING_PROCESSING_ERROR, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(int, 5, currentmalloc_call);
 
@@ -2472,6 +2479,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_timeout_failed)
     call_on_send_complete_in_xio_send = false;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     SkipDoworkJobsSendResult = 200;
@@ -2484,7 +2493,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_timeout_failed)
     STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2530,6 +2539,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_retry_n_and_failed
     call_on_send_complete_in_xio_send = false;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     SkipDoworkJobsSendResult = 10;
@@ -2542,7 +2553,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_header_complete_retry_n_and_failed
     STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2581,38 +2592,20 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_send_buffer_complete_with_error_failed)
 
     DoworkJobs = (const xio_dowork_job*)doworkjob_oe;
     DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_ok;
-    DoworkJobsSendResult = (const IO_SEND_RESULT*)sendresult_6ok_error;
-    xio_send_shallReturn = (const int*)xio_send_6x0_e;
+    DoworkJobsSendResult = (const IO_SEND_RESULT*)sendresult_o_3error;
+    xio_send_shallReturn = (const int*)xio_send_0_e;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
 
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
 
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2660,7 +2653,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_read_header_failed_failed)
     STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2710,7 +2703,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_read_NULL_header_failed)
     STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -2763,7 +2756,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__on_read_not_HTTP_header_failed)
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3087,7 +3080,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3138,7 +3131,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_retry_open_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3187,6 +3180,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_retry_send_succeed)
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
 
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     SkipDoworkJobsSendResult = 199;
@@ -3196,41 +3191,6 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_retry_send_succeed)
             .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
     }
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_NUM_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(100));
 
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
@@ -3240,7 +3200,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_retry_send_succeed)
 
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3290,7 +3250,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_get_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3342,7 +3302,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_post_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3394,7 +3354,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_put_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3446,7 +3406,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_delete_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3498,7 +3458,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_patch_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3550,7 +3510,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_head_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPHeadsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3602,7 +3562,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_relative_path_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
     xio_send_transmited_buffer_target = 1;
 
     /// act
@@ -3656,8 +3616,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_with_content_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
-    xio_send_transmited_buffer_target = 7;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    xio_send_transmited_buffer_target = 2;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3704,32 +3664,14 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_NULL_content_succeed)
     DoworkJobsSendResult = DoworkJobsSendResult_ReceiveHead;
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
-    xio_send_transmited_buffer_target = 7;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    xio_send_transmited_buffer_target = 2;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3777,32 +3719,14 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_content_size_0_succeed)
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
 
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
-    xio_send_transmited_buffer_target = 7;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    xio_send_transmited_buffer_target = 2;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3851,7 +3775,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_no_statusCode_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3897,26 +3821,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_no_responseHeadersHandle_s
 
     setupAllCallBeforeOpenHTTPsequence(requestHttpHeaders, 1, false);
 
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(HTTPHeaders_GetHeader(requestHttpHeaders, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_SerializeTo(requestHttpHeaders, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -3937,7 +3843,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_no_responseHeadersHandle_s
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -3986,7 +3892,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_responseContent_NULL_succe
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -4064,7 +3970,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_with_truncated_content_fai
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -4135,7 +4041,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_with_truncated_parameter_f
     }
 
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -4200,7 +4106,7 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__Execute_request_with_truncated_header_fail
     }
 
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -4248,8 +4154,8 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_with_no_content_succeed)
     setupAllCallBeforeSendHTTPsequenceWithSuccess(requestHttpHeaders);
     setupAllCallBeforeReceiveHTTPHeadsequenceWithSuccess();
 
-    HTTPHeaders_GetHeader_shallReturn = HTTP_HEADERS_OK;
-    xio_send_transmited_buffer_target = 7;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    xio_send_transmited_buffer_target = 2;
 
     /// act
     result = HTTPAPI_ExecuteRequest(
@@ -4276,4 +4182,518 @@ TEST_FUNCTION(HTTPAPI_ExecuteRequest__request_with_no_content_succeed)
     HTTPAPI_Deinit();
 }
 
+/* HTTPAPI_ExecuteRequestAsync */
+
+static HTTPAPI_RESULT startAsyncRequest(HTTP_HANDLE httpHandle, HTTPAPI_REQUEST_TYPE requestType, HTTP_HEADERS_HANDLE requestHttpHeaders, HTTP_HEADERS_HANDLE responseHttpHeaders)
+{
+    DoworkJobs = (const xio_dowork_job*)doworkjob_oe;
+    DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_ok;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+    xio_send_transmited_buffer_target = 1;
+
+    return HTTPAPI_ExecuteRequestAsync(
+        httpHandle,
+        requestType,
+        TEST_EXECUTE_REQUEST_RELATIVE_PATH,
+        requestHttpHeaders,
+        TEST_EXECUTE_REQUEST_CONTENT,
+        TEST_EXECUTE_REQUEST_CONTENT_LENGTH,
+        responseHttpHeaders,
+        NULL,
+        test_on_request_complete,
+        NULL);
+}
+
+static void receiveAsyncBytes(HTTP_HANDLE httpHandle, const char* bytes)
+{
+    my_on_bytes_received(my_on_bytes_received_context, (const unsigned char*)bytes, strlen(bytes));
+    HTTPAPI_DoWork(httpHandle);
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_001: [ If handle, relativePath, httpHeadersHandle or on_request_complete is NULL, the requestType is unknown or the number of headers cannot be obtained, the HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_INVALID_ARG. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestAsync__NULL_on_request_complete_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestAsync(httpHandle, HTTPAPI_REQUEST_GET, TEST_EXECUTE_REQUEST_RELATIVE_PATH, requestHttpHeaders, NULL, 0, responseHttpHeaders, NULL, NULL, NULL);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_004: [ If the connection is not open, the HTTPAPI_ExecuteRequestAsync shall set the transport options and start opening it; if this fails, it shall return HTTPAPI_SET_OPTION_FAILED or HTTPAPI_OPEN_REQUEST_FAILED. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_005: [ The HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_OK without waiting for the request to complete. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestAsync__opens_and_returns_without_sending_succeed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    setHttpCertificate(httpHandle);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = startAsyncRequest(httpHandle, HTTPAPI_REQUEST_POST, requestHttpHeaders, responseHttpHeaders);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, "", xio_send_transmited_buffer);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_004: [ If the connection is not open, the HTTPAPI_ExecuteRequestAsync shall set the transport options and start opening it; if this fails, it shall return HTTPAPI_SET_OPTION_FAILED or HTTPAPI_OPEN_REQUEST_FAILED. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestAsync__xio_open_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    umock_c_reset_all_calls();
+    xio_open_shallReturn = __FAILURE__;
+
+    /// act
+    result = startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OPEN_REQUEST_FAILED, result);
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_002: [ If a request is already in progress on the connection, the HTTPAPI_ExecuteRequestAsync shall return HTTPAPI_ERROR. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_016: [ The HTTPAPI_ExecuteRequest shall return HTTPAPI_ERROR while an asynchronous request is in progress on the connection. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestAsync__request_in_progress_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result1;
+    HTTPAPI_RESULT result2;
+    unsigned int statusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    umock_c_reset_all_calls();
+
+    /// act
+    result1 = startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    result2 = HTTPAPI_ExecuteRequest(httpHandle, HTTPAPI_REQUEST_GET, TEST_EXECUTE_REQUEST_RELATIVE_PATH, requestHttpHeaders, NULL, 0, &statusCode, responseHttpHeaders, NULL);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, result1);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, result2);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_003: [ The HTTPAPI_ExecuteRequestAsync shall build the request line, the headers and the content in a single buffer; if it cannot, it shall return HTTPAPI_STRING_PROCESSING_ERROR or HTTPAPI_ALLOC_FAILED. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_006: [ The HTTPAPI_DoWork shall call xio_dowork once and return without sleeping. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_007: [ Once the connection is open, the request shall be sent with a single xio_send; if it fails, the request shall complete with HTTPAPI_SEND_REQUEST_FAILED. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__sends_the_whole_request_in_one_xio_send_succeed)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_POST, requestHttpHeaders, responseHttpHeaders);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    /// act
+    HTTPAPI_DoWork(httpHandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(strncmp(xio_send_transmited_buffer, "POST /devices/Huzzah_w_DHT22/messages/events?api-version=2016-11-14 HTTP/1.1\r\n" TEST_SERIALIZED_HEADER TEST_SERIALIZED_HEADER "\r\n", 104) == 0);
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_008: [ The response shall be parsed incrementally, as the bytes are delivered by the transport. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_009: [ The response headers shall be added to the responseHeadersHandle, if it is not NULL. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_011: [ When the response is complete, the HTTPAPI_DoWork shall call on_request_complete with the result and the status code of the response. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__response_in_pieces_completes_succeed)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    HTTPAPI_DoWork(httpHandle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(responseHttpHeaders, "Content-Length", " 10"));
+
+    /// act
+    receiveAsyncBytes(httpHandle, "HTTP/1.1 20");
+    receiveAsyncBytes(httpHandle, "0 OK\r\nContent-Len");
+    receiveAsyncBytes(httpHandle, "gth: 10\r\n\r\n01234");
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+    receiveAsyncBytes(httpHandle, "56789");
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, async_complete_result);
+    ASSERT_ARE_EQUAL(int, 200, async_complete_status_code);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_010: [ A body sent with Content-Length or chunked transfer encoding shall be copied into responseContent; if responseContent is NULL, it shall be ignored. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__chunked_response_completes_succeed)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    HTTPAPI_DoWork(httpHandle);
+
+    /// act
+    receiveAsyncBytes(httpHandle, "HTTP/1.1 201 Created\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n");
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+    receiveAsyncBytes(httpHandle, "0\r\n\r\n");
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, async_complete_result);
+    ASSERT_ARE_EQUAL(int, 201, async_complete_status_code);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_013: [ If the response cannot be parsed, the asynchronous request shall complete with HTTPAPI_RECEIVE_RESPONSE_FAILED; if a memory allocation fails, with HTTPAPI_ALLOC_FAILED; if the transport reports an error, with HTTPAPI_READ_DATA_FAILED. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_015: [ After a failed request, or a response with `Connection: close`, the connection shall be closed and the next request shall open it again. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__invalid_status_line_closes_the_connection)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    HTTPAPI_DoWork(httpHandle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    /// act
+    my_on_bytes_received(my_on_bytes_received_context, (const unsigned char*)"garbage\r\n", 9);
+    HTTPAPI_DoWork(httpHandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_RECEIVE_RESPONSE_FAILED, async_complete_result);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_012: [ If the connection cannot be opened, the request shall complete with HTTPAPI_OPEN_REQUEST_FAILED. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__open_error_completes_with_HTTPAPI_OPEN_REQUEST_FAILED)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    DoworkJobs = (const xio_dowork_job*)doworkjob_oe;
+    DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_error;
+    result = HTTPAPI_ExecuteRequestAsync(httpHandle, HTTPAPI_REQUEST_GET, TEST_EXECUTE_REQUEST_RELATIVE_PATH, requestHttpHeaders, NULL, 0, responseHttpHeaders, NULL, test_on_request_complete, NULL);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, result);
+
+    /// act
+    HTTPAPI_DoWork(httpHandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OPEN_REQUEST_FAILED, async_complete_result);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_014: [ If nothing is received for 30 seconds, the asynchronous request shall complete with HTTPAPI_READ_DATA_FAILED. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__no_response_times_out)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    HTTPAPI_DoWork(httpHandle);
+    test_current_ms = 30000;
+    HTTPAPI_DoWork(httpHandle);
+    ASSERT_ARE_EQUAL(int, 0, async_complete_count);
+
+    /// act
+    test_current_ms = 30001;
+    HTTPAPI_DoWork(httpHandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_READ_DATA_FAILED, async_complete_result);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_017: [ If an asynchronous request is in progress, the HTTPAPI_CloseConnection shall call its on_request_complete with HTTPAPI_ERROR before closing the connection. ]*/
+TEST_FUNCTION(HTTPAPI_CloseConnection__completes_the_request_in_progress)
+{
+    /// arrange
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+
+    /// act
+    HTTPAPI_CloseConnection(httpHandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, 1, async_complete_count);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, async_complete_result);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_018: [ If the handle is NULL or no asynchronous request is in progress, the HTTPAPI_DoWork shall not do anything. ]*/
+TEST_FUNCTION(HTTPAPI_DoWork__NULL_handle_does_nothing)
+{
+    /// act
+    HTTPAPI_DoWork(NULL);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* HTTPAPI_ExecuteRequestBatch */
+
+static void setBatchRequests(HTTPAPI_BATCH_REQUEST* requests, size_t requestCount, HTTP_HEADERS_HANDLE requestHttpHeaders)
+{
+    size_t i;
+    for (i = 0; i < requestCount; i++)
+    {
+        requests[i].requestType = HTTPAPI_REQUEST_GET;
+        requests[i].relativePath = TEST_EXECUTE_REQUEST_RELATIVE_PATH;
+        requests[i].httpHeadersHandle = requestHttpHeaders;
+        requests[i].content = NULL;
+        requests[i].contentLength = 0;
+        requests[i].responseHeadersHandle = NULL;
+        requests[i].responseContent = NULL;
+        requests[i].statusCode = 0;
+        requests[i].result = HTTPAPI_OK;
+    }
+
+    DoworkJobs = (const xio_dowork_job*)doworkjob_o_re;
+    DoworkJobsOpenResult = (const IO_OPEN_RESULT*)openresult_ok;
+    DoworkJobsReceivedBuffer_counter = 0;
+    HTTPHeaders_SerializeTo_shallReturn = HTTP_HEADERS_OK;
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_019: [ If handle or requests is NULL, requestCount is 0, or any of the requests has a NULL relativePath or httpHeadersHandle, an unknown requestType or headers whose number cannot be obtained, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_INVALID_ARG. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestBatch__NULL_requests_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestBatch(httpHandle, NULL, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// cleanup
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_019: [ If handle or requests is NULL, requestCount is 0, or any of the requests has a NULL relativePath or httpHeadersHandle, an unknown requestType or headers whose number cannot be obtained, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_INVALID_ARG. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestBatch__NULL_relativePath_in_second_request_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTPAPI_BATCH_REQUEST requests[2];
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    setBatchRequests(requests, 2, requestHttpHeaders);
+    requests[1].relativePath = NULL;
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestBatch(httpHandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(int, 0, xio_send_shallReturn_counter);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_020: [ If an asynchronous request is in progress on the connection, the HTTPAPI_ExecuteRequestBatch shall return HTTPAPI_ERROR. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestBatch__async_request_in_progress_failed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTPAPI_BATCH_REQUEST requests[2];
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)startAsyncRequest(httpHandle, HTTPAPI_REQUEST_GET, requestHttpHeaders, responseHttpHeaders);
+    setBatchRequests(requests, 2, requestHttpHeaders);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestBatch(httpHandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, result);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_021: [ The HTTPAPI_ExecuteRequestBatch shall build all the requests back to back in a single buffer and send it, without waiting for any response. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_022: [ The HTTPAPI_ExecuteRequestBatch shall wait for the responses and write the status code and the result of each request in the batch. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_023: [ The responses of a batch shall be parsed in the order of the requests, the bytes that follow a complete response belong to the next one. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestBatch__responses_in_one_read_succeed)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTPAPI_BATCH_REQUEST requests[3];
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    setBatchRequests(requests, 3, requestHttpHeaders);
+    DoworkJobsReceivedBuffer = (const unsigned char*)
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nab"
+        "HTTP/1.1 201 Created\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nc\r\n0\r\n\r\n"
+        "HTTP/1.1 204 No Content\r\n\r\n";
+    DoworkJobsReceivedBuffer_size[0] = strlen((const char*)DoworkJobsReceivedBuffer);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestBatch(httpHandle, requests, 3);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, result);
+    ASSERT_ARE_EQUAL(int, 1, xio_send_shallReturn_counter);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, requests[0].result);
+    ASSERT_ARE_EQUAL(int, 200, requests[0].statusCode);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, requests[1].result);
+    ASSERT_ARE_EQUAL(int, 201, requests[1].statusCode);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, requests[2].result);
+    ASSERT_ARE_EQUAL(int, 204, requests[2].statusCode);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
+/*Tests_SRS_HTTPAPI_COMPACT_01_024: [ After a failed response, or a response with `Connection: close`, the following requests of the batch shall not be waited for and shall be reported with HTTPAPI_ERROR. ]*/
+/*Tests_SRS_HTTPAPI_COMPACT_01_025: [ If any request of the batch failed, or a response had `Connection: close`, the HTTPAPI_ExecuteRequestBatch shall close the connection so the next request opens it again. ]*/
+TEST_FUNCTION(HTTPAPI_ExecuteRequestBatch__connection_close_stops_the_batch)
+{
+    /// arrange
+    HTTPAPI_RESULT result;
+    HTTPAPI_BATCH_REQUEST requests[2];
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HANDLE httpHandle = createHttpConnection();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    setBatchRequests(requests, 2, requestHttpHeaders);
+    DoworkJobsReceivedBuffer = (const unsigned char*)"HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    DoworkJobsReceivedBuffer_size[0] = strlen((const char*)DoworkJobsReceivedBuffer);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPI_ExecuteRequestBatch(httpHandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, result);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_OK, requests[0].result);
+    ASSERT_ARE_EQUAL(int, 200, requests[0].statusCode);
+    ASSERT_ARE_EQUAL(int, HTTPAPI_ERROR, requests[1].result);
+    ASSERT_IS_TRUE(my_on_io_close_complete != NULL);
+
+    /// cleanup
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPI_CloseConnection(httpHandle);
+    HTTPAPI_Deinit();
+}
+
 END_TEST_SUITE(httpapicompact_ut)
@@ -77,6 +77,9 @@ void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
 
 static size_t currentHTTPAPI_SaveOption_call;
 static size_t whenShallHTTPAPI_SaveOption_fail;
@@ -95,6 +98,10 @@ static size_t currentHTTPAPI_Init_call;
 static size_t whenShallHTTPAPI_Init_fail[N_MAX_FAILS];
 static size_t HTTPAPI_Init_calls;
 
+static size_t HTTPAPI_ExecuteRequestBatch_calls;
+static size_t HTTPAPI_ExecuteRequestBatch_requestCount;
+static size_t HTTPAPI_ExecuteRequestBatch_completed;
+
 STRING_HANDLE my_STRING_construct(const char* psz)
 {
     (void)psz;
@@ -188,11 +195,66 @@ HTTP_HANDLE my_HTTPAPI_CreateConnection(const char* hostName)
     return result2;
 }
 
+static size_t HTTPAPI_CloseConnection_calls;
 void my_HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 {
+    HTTPAPI_CloseConnection_calls++;
     free(handle);
 }
 
+/*the first HTTPAPI_ExecuteRequestBatch_completed requests get a response, the others are left unanswered*/
+HTTPAPI_RESULT my_HTTPAPI_ExecuteRequestBatch(HTTP_HANDLE handle, HTTPAPI_BATCH_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result2 = HTTPAPI_OK;
+    size_t i;
+    (void)handle;
+    HTTPAPI_ExecuteRequestBatch_calls++;
+    HTTPAPI_ExecuteRequestBatch_requestCount = requestCount;
+    for (i = 0; i < requestCount; i++)
+    {
+        if (i < HTTPAPI_ExecuteRequestBatch_completed)
+        {
+            requests[i].statusCode = 200;
+            requests[i].result = HTTPAPI_OK;
+        }
+        else
+        {
+            requests[i].result = HTTPAPI_ERROR;
+            result2 = HTTPAPI_ERROR;
+        }
+    }
+    return result2;
+}
+
+/*lets a test act on the pool while a request is in flight*/
+static void(*onHTTPAPI_ExecuteRequest)(void);
+HTTPAPI_RESULT my_HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    void(*action)(void) = onHTTPAPI_ExecuteRequest;
+    (void)handle;
+    (void)requestType;
+    (void)relativePath;
+    (void)httpHeadersHandle;
+    (void)content;
+    (void)contentLength;
+    (void)statusCode;
+    (void)responseHeadersHandle;
+    (void)responseContent;
+    onHTTPAPI_ExecuteRequest = NULL;
+    if (action != NULL)
+    {
+        action();
+    }
+    return HTTPAPI_OK;
+}
+
+int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = 0;
+    return 0;
+}
+
 HTTPAPI_RESULT my_HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
 {
     HTTPAPI_RESULT result2;
@@ -272,6 +334,7 @@ extern "C"
 #include "azure_c_shared_utility/httpapiex.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
@@ -286,6 +349,8 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE_VALUES);
 #define TEST_HTTP_HEADERS_HANDLE (HTTP_HEADERS_HANDLE) 0x47
 #define TEST_BUFFER_REQ_BODY    (BUFFER_HANDLE) 0x48
 #define TEST_BUFFER_RESP_BODY   (BUFFER_HANDLE) 0x49
+#define TEST_LOCK_HANDLE        (LOCK_HANDLE) 0x4A
+#define TEST_TICK_COUNTER_HANDLE (TICK_COUNTER_HANDLE) 0x4B
 unsigned char* TEST_BUFFER = (unsigned char*)"333333";
 #define TEST_BUFFER_SIZE 6
 
@@ -439,6 +504,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const unsigned char*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, unsigned long long);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTPAPI_BATCH_REQUEST*, void*);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -458,6 +528,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CreateConnection, my_HTTPAPI_CreateConnection);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CloseConnection, my_HTTPAPI_CloseConnection);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPAPI_ExecuteRequest, HTTPAPI_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_ExecuteRequestBatch, my_HTTPAPI_ExecuteRequestBatch);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPAPI_SetOption, HTTPAPI_OK);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CloneOption, my_HTTPAPI_CloneOption);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
@@ -473,6 +544,11 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_size, real_VECTOR_size);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
     REGISTER_GLOBAL_MOCK_HOOK(size_tToString, real_size_tToString);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -507,6 +583,11 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     whenShallBUFFER_size_fail = 0;
 
     HTTPAPI_Init_calls = 0;
+    HTTPAPI_CloseConnection_calls = 0;
+
+    HTTPAPI_ExecuteRequestBatch_calls = 0;
+    HTTPAPI_ExecuteRequestBatch_requestCount = 0;
+    HTTPAPI_ExecuteRequestBatch_completed = (size_t)-1;
 
     currentHTTPAPI_CreateConnection_call = 0;
     for(i=0;i<N_MAX_FAILS;i++) whenShallHTTPAPI_CreateConnection_fail[i] = 0;
@@ -514,6 +595,9 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     currentHTTPAPI_Init_call = 0;
     for (i = 0; i<N_MAX_FAILS; i++) whenShallHTTPAPI_Init_fail[i] = 0;
 
+    onHTTPAPI_ExecuteRequest = NULL;
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_ExecuteRequest, NULL);
+
     umock_c_reset_all_calls();
 }
 
@@ -3333,4 +3417,525 @@ TEST_FUNCTION(HTTPAPIEX_Destroy_with_NULL_argument_does_nothing)
     ///destroy
 }
 
+/*Tests_SRS_HTTPAPIEX_01_001: [If maxConnectionsPerHost is 0 then HTTPAPIEX_Pool_Create shall return NULL.]*/
+TEST_FUNCTION(HTTPAPIEX_Pool_Create_with_0_maxConnectionsPerHost_fails)
+{
+    /// arrange
+
+    /// act
+    HTTPAPIEX_POOL_HANDLE result = HTTPAPIEX_Pool_Create(0, 60);
+
+    /// assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_01_002: [HTTPAPIEX_Pool_Create shall call HTTPAPI_Init once for all the connections of the pool.]*/
+TEST_FUNCTION(HTTPAPIEX_Pool_Create_succeeds)
+{
+    /// arrange
+    HTTPAPIEX_POOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+
+    /// act
+    result = HTTPAPIEX_Pool_Create(2, 60);
+
+    /// assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Pool_Destroy(result);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_003: [If any of the operations in HTTPAPIEX_Pool_Create fails, then HTTPAPIEX_Pool_Create shall return NULL.]*/
+TEST_FUNCTION(HTTPAPIEX_Pool_Create_fails_when_HTTPAPI_Init_fails)
+{
+    /// arrange
+    HTTPAPIEX_POOL_HANDLE result;
+    whenShallHTTPAPI_Init_fail[0] = 1;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    /// act
+    result = HTTPAPIEX_Pool_Create(2, 60);
+
+    /// assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_01_005: [If parameter pool is NULL then HTTPAPIEX_Pool_Destroy shall take no action.]*/
+TEST_FUNCTION(HTTPAPIEX_Pool_Destroy_with_NULL_argument_does_nothing)
+{
+    /// arrange
+
+    /// act
+    HTTPAPIEX_Pool_Destroy(NULL);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_01_006: [If parameter hostName or pool is NULL then HTTPAPIEX_CreateWithPool shall return NULL.]*/
+TEST_FUNCTION(HTTPAPIEX_CreateWithPool_with_NULL_pool_fails)
+{
+    /// arrange
+
+    /// act
+    HTTPAPIEX_HANDLE result = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, NULL);
+
+    /// assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_01_007: [HTTPAPIEX_CreateWithPool shall create the handle as HTTPAPIEX_Create does and attach it to the connections of pool for hostName.]*/
+TEST_FUNCTION(HTTPAPIEX_CreateWithPool_succeeds)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    /// act
+    result = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+
+    /// assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(result);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_009: [If the handle was created by HTTPAPIEX_CreateWithPool, HTTPAPIEX_ExecuteRequest shall execute the request on a connection checked out of the pool instead of the retry sequence of SRS_HTTPAPIEX_02_023.]*/
+/*Tests_SRS_HTTPAPIEX_01_010: [HTTPAPIEX_ExecuteRequest shall reuse the most recently used idle connection of the pool to the host of the handle.]*/
+/*Tests_SRS_HTTPAPIEX_01_016: [After a successful request the connection shall be returned to the idle connections of the pool.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_pool_reuses_the_connection)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result1;
+    HTTPAPIEX_RESULT result2;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle1 = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    HTTPAPIEX_HANDLE httpapiexhandle2 = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    unsigned int statusCode;
+    umock_c_reset_all_calls();
+
+    /// act
+    result1 = HTTPAPIEX_ExecuteRequest(httpapiexhandle1, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, &statusCode, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    result2 = HTTPAPIEX_ExecuteRequest(httpapiexhandle2, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, &statusCode, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result1);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result2);
+    ASSERT_ARE_EQUAL(size_t, 1, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_Init_calls);
+    ASSERT_ARE_EQUAL(size_t, 0, HTTPAPI_CloseConnection_calls);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle1);
+    HTTPAPIEX_Destroy(httpapiexhandle2);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_004: [HTTPAPIEX_Pool_Destroy shall close all the idle connections, call HTTPAPI_Deinit and free all the resources used by the pool.]*/
+TEST_FUNCTION(HTTPAPIEX_Pool_Destroy_closes_the_idle_connections)
+{
+    /// arrange
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*the pooled connection*/
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*the host name*/
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); /*the host*/
+    STRICT_EXPECTED_CALL(HTTPAPI_Deinit());
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    /// act
+    HTTPAPIEX_Pool_Destroy(pool);
+
+    /// assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_01_014: [If the request fails on a reused connection, the connection shall be closed and the request shall be retried once on a new connection.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_pool_retries_on_a_new_connection_when_the_reused_one_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(1, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(HTTPAPI_ERROR);
+    EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(HTTPAPI_OK);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_CloseConnection_calls);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_015: [If a new connection cannot be created or the request fails on it, HTTPAPIEX_ExecuteRequest shall return HTTPAPIEX_RECOVERYFAILED.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_pool_fails_when_HTTPAPI_CreateConnection_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(1, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    whenShallHTTPAPI_CreateConnection_fail[0] = 1;
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_RECOVERYFAILED, result);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+static HTTPAPIEX_HANDLE nestedHandle;
+static HTTPAPIEX_RESULT nestedResult;
+static void executeNestedRequest(void)
+{
+    nestedResult = HTTPAPIEX_ExecuteRequest(nestedHandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+}
+
+static void setNestedOption(void)
+{
+    nestedResult = HTTPAPIEX_SetOption(nestedHandle, "someOption", "b");
+}
+
+/*Tests_SRS_HTTPAPIEX_01_013: [Otherwise HTTPAPIEX_ExecuteRequest shall fail with HTTPAPIEX_ERROR without waiting for a connection to be returned to the pool.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_pool_fails_at_once_when_all_the_connections_are_in_use)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(1, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    nestedHandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    nestedResult = HTTPAPIEX_OK;
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_ExecuteRequest, my_HTTPAPI_ExecuteRequest);
+    onHTTPAPI_ExecuteRequest = executeNestedRequest;
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, nestedResult);
+    ASSERT_ARE_EQUAL(size_t, 1, currentHTTPAPI_CreateConnection_call);
+
+    ///destroy
+    HTTPAPIEX_Destroy(nestedHandle);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_024: [When HTTPAPIEX_SetOption is called on a handle created by HTTPAPIEX_CreateWithPool, the handle shall stop sharing connections with other handles and use connections of its own, opened with all its saved options.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_on_a_pooled_handle_stops_sharing_the_connections_of_other_handles)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle1 = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    HTTPAPIEX_HANDLE httpapiexhandle2 = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle1, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle2, "someOption", "a");
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, HTTPAPIEX_ExecuteRequest(httpapiexhandle2, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY));
+    ASSERT_ARE_EQUAL(size_t, 2, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, HTTPAPIEX_ExecuteRequest(httpapiexhandle1, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY));
+    ASSERT_ARE_EQUAL(size_t, 2, currentHTTPAPI_CreateConnection_call);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle1);
+    HTTPAPIEX_Destroy(httpapiexhandle2);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_025: [When HTTPAPIEX_SetOption is called on a handle that already has connections of its own, its idle connections shall be closed and the connections in use shall be closed when they are returned, so that every further request uses all the saved options.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_closes_the_idle_connections_of_its_own)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, "someOption", "a");
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, "someOption", "b");
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_CloseConnection_calls);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY));
+    ASSERT_ARE_EQUAL(size_t, 2, currentHTTPAPI_CreateConnection_call);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_025: [When HTTPAPIEX_SetOption is called on a handle that already has connections of its own, its idle connections shall be closed and the connections in use shall be closed when they are returned, so that every further request uses all the saved options.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_during_a_request_closes_the_connection_when_it_is_returned)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, "someOption", "a");
+    nestedHandle = httpapiexhandle;
+    nestedResult = HTTPAPIEX_ERROR;
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_ExecuteRequest, my_HTTPAPI_ExecuteRequest);
+    onHTTPAPI_ExecuteRequest = setNestedOption;
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, nestedResult);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_CloseConnection_calls);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_026: [HTTPAPIEX_Destroy shall close the connections that the handle does not share with other handles.]*/
+TEST_FUNCTION(HTTPAPIEX_Destroy_closes_the_pooled_connections_of_its_own)
+{
+    /// arrange
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, "someOption", "a");
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    umock_c_reset_all_calls();
+
+    /// act
+    HTTPAPIEX_Destroy(httpapiexhandle);
+
+    /// assert
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_CloseConnection_calls);
+
+    ///destroy
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+static void setBatchRequests(HTTPAPIEX_BATCH_REQUEST* requests, size_t requestCount)
+{
+    size_t i;
+    for (i = 0; i < requestCount; i++)
+    {
+        requests[i].requestType = HTTPAPI_REQUEST_PATCH;
+        requests[i].relativePath = TEST_RELATIVE_PATH;
+        requests[i].requestHttpHeadersHandle = TEST_REQUEST_HTTP_HEADERS;
+        requests[i].requestContent = TEST_REQUEST_BODY;
+        requests[i].responseHttpHeadersHandle = TEST_RESPONSE_HTTP_HEADERS;
+        requests[i].responseContent = TEST_RESPONSE_BODY;
+    }
+}
+
+/*Tests_SRS_HTTPAPIEX_01_017: [If handle or requests is NULL, requestCount is 0 or any of the requests has an invalid requestType, HTTPAPIEX_ExecuteBatch shall return HTTPAPIEX_INVALID_ARG.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_with_NULL_requests_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, NULL, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_017: [If handle or requests is NULL, requestCount is 0 or any of the requests has an invalid requestType, HTTPAPIEX_ExecuteBatch shall return HTTPAPIEX_INVALID_ARG.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_with_invalid_requestType_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_BATCH_REQUEST requests[2];
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    setBatchRequests(requests, 2);
+    requests[1].requestType = (HTTPAPI_REQUEST_TYPE)COUNT_ARG(HTTPAPI_REQUEST_TYPE_VALUES);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_018: [If the handle has no connection yet, the first request shall be executed by HTTPAPIEX_ExecuteRequest, which creates the connection, and the rest of the batch shall then use that connection.]*/
+/*Tests_SRS_HTTPAPIEX_01_019: [Every request of the batch shall get the same default headers and temporary objects as a request executed by HTTPAPIEX_ExecuteRequest.]*/
+/*Tests_SRS_HTTPAPIEX_01_020: [HTTPAPIEX_ExecuteBatch shall hand the requests to HTTPAPI_ExecuteRequestBatch on a single connection.]*/
+/*Tests_SRS_HTTPAPIEX_01_023: [HTTPAPIEX_ExecuteBatch shall return HTTPAPIEX_OK if all the requests succeeded, otherwise the result of the first request that failed.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_without_connection_executes_the_first_request_alone)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_BATCH_REQUEST requests[3];
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    setBatchRequests(requests, 3);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, requests, 3);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_ExecuteRequestBatch_calls);
+    ASSERT_ARE_EQUAL(size_t, 2, HTTPAPI_ExecuteRequestBatch_requestCount);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[0].result);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[1].result);
+    ASSERT_ARE_EQUAL(int, 200, requests[1].statusCode);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[2].result);
+    ASSERT_ARE_EQUAL(int, 200, requests[2].statusCode);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_021: [Every request that did not complete in the batch shall be executed again by HTTPAPIEX_ExecuteRequest.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_executes_again_the_requests_that_did_not_complete)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_BATCH_REQUEST requests[3];
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, TEST_REQUEST_HTTP_HEADERS, TEST_REQUEST_BODY, NULL, TEST_RESPONSE_HTTP_HEADERS, TEST_RESPONSE_BODY);
+    setBatchRequests(requests, 3);
+    HTTPAPI_ExecuteRequestBatch_completed = 1;
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(HTTPAPI_OK);
+    EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(HTTPAPI_OK);
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, requests, 3);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 3, HTTPAPI_ExecuteRequestBatch_requestCount);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[1].result);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[2].result);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_022: [A pooled connection shall be returned to the pool only if the whole batch succeeded on it.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_with_pool_keeps_the_connection_when_the_batch_succeeds)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_BATCH_REQUEST requests[2];
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    setBatchRequests(requests, 2);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, HTTPAPI_ExecuteRequestBatch_requestCount);
+    ASSERT_ARE_EQUAL(size_t, 1, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(size_t, 0, HTTPAPI_CloseConnection_calls);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_021: [Every request that did not complete in the batch shall be executed again by HTTPAPIEX_ExecuteRequest.]*/
+/*Tests_SRS_HTTPAPIEX_01_022: [A pooled connection shall be returned to the pool only if the whole batch succeeded on it.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteBatch_with_pool_closes_the_connection_when_the_batch_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_BATCH_REQUEST requests[2];
+    HTTPAPIEX_POOL_HANDLE pool = HTTPAPIEX_Pool_Create(2, 60);
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_CreateWithPool(TEST_HOSTNAME, pool);
+    setBatchRequests(requests, 2);
+    HTTPAPI_ExecuteRequestBatch_completed = 1;
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteBatch(httpapiexhandle, requests, 2);
+
+    /// assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, currentHTTPAPI_CreateConnection_call);
+    ASSERT_ARE_EQUAL(size_t, 1, HTTPAPI_CloseConnection_calls);
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, requests[1].result);
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+    HTTPAPIEX_Pool_Destroy(pool);
+}
+
 END_TEST_SUITE(httpapiex_unittests)
@@ -4,9 +4,11 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <climits>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <limits.h>
+#include <string.h>
 #endif
 
 static size_t currentmalloc_call = 0;
@@ -71,25 +73,6 @@ void my_gballoc_free(void* ptr)
 
 #define ENABLE_MOCKS
 
-#include "azure_c_shared_utility/map.h"
-
-MAP_HANDLE my_Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
-{
-    (void)mapFilterFunc;
-    return (MAP_HANDLE)malloc(1);
-}
-
-MAP_HANDLE my_Map_Clone(MAP_HANDLE handle)
-{
-    (void)handle;
-    return (MAP_HANDLE)malloc(1);
-}
-
-void my_Map_Destroy(MAP_HANDLE handle)
-{
-    free(handle);
-}
-
 #include "azure_c_shared_utility/gballoc.h"
 
 #undef ENABLE_MOCKS
@@ -104,8 +87,6 @@ static TEST_MUTEX_HANDLE g_testByTest;
 TEST_DEFINE_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 
-IMPLEMENT_UMOCK_C_ENUM_TYPE(MAP_RESULT, MAP_RESULT_VALUES);
-
 /*test assets*/
 #define NAME1 "name1"
 #define VALUE1 "value1"
@@ -146,17 +127,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         result = umocktypes_charptr_register_types();
         ASSERT_ARE_EQUAL(int, 0, result);
 
-        REGISTER_TYPE(MAP_RESULT, MAP_RESULT);
-        REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
-        REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
-
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Create, my_Map_Create);
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Clone, my_Map_Clone);
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Destroy, my_Map_Destroy);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_AddOrUpdate, MAP_OK);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_GetValueFromKey, VALUE1);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_GetInternals, MAP_OK);
-
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -183,6 +153,8 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
         currentrealloc_call = 0;
         whenShallrealloc_fail = 0;
+
+        (void)memset(tempBuffer, 'x', sizeof(tempBuffer));
     }
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -199,8 +171,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
-
         ///act
         handle = HTTPHeaders_Alloc();
 
@@ -248,39 +218,20 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(handle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
-
-        ///act
-        HTTPHeaders_Free(handle);
-
-        ///assert
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    }
-
-
-    /*Tests_SRS_HTTP_HEADERS_99_003:[ The function shall return NULL when the function cannot execute properly]*/
-    TEST_FUNCTION(HTTPHeaders_Alloc_fails_when_Map_Create_fails)
-    {
-        ///arrange
-        HTTP_HEADERS_HANDLE httpHandle;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG))
-            .SetReturn(NULL);
-
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
-        httpHandle = HTTPHeaders_Alloc();
+        HTTPHeaders_Free(handle);
 
         ///assert
-        ASSERT_IS_NULL(httpHandle);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
@@ -291,13 +242,8 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         size_t nHeaders;
-        size_t zero = 0;
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments()
-            .CopyOutArgumentBuffer(4, &zero, sizeof(zero));
-
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
@@ -319,12 +265,9 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*the header table*/
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1))); /*name\0value\0*/
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
@@ -333,28 +276,22 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-        //checking content
-
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_Map_AddOrUpdate_fails)
+    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_the_header_table_malloc_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
-            .IgnoreArgument(1)
-            .SetReturn(MAP_ERROR);
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
@@ -362,42 +299,61 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        //checking content
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 0, nHeaders);
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_succeeds)
+    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_the_header_malloc_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1)));
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        //checking content
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 0, nHeaders);
+        ASSERT_IS_NULL(HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
+    /*Tests_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        char* headerValue;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, HEADER1, headerValue);
 
+        ///cleanup
+        free(headerValue);
+        HTTPHeaders_Free(httpHandle);
+    }
 
     /*Tests_SRS_HTTP_HEADERS_99_014:[ The function shall return when the handle is not valid or when name parameter is NULL or when value parameter is NULL.]*/
     TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_NULL_handle_fails)
@@ -455,160 +411,213 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1 ", " VALUE1))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(NAME1) + sizeof(VALUE1 ", " VALUE2)))
             .IgnoreArgument(1);
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_appends_fails_when_Map_AddOrUpdate_fails)
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_fails_when_gballoc_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
+        whenShallrealloc_fail = currentrealloc_call + 1;
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreAllArguments();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE2);
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1 ", " VALUE1))
-            .IgnoreArgument(1)
-            .SetReturn(MAP_ERROR);
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_012:[ Calling this API shall record a header from name and value parameters.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_add_two_headers_produces_two_headers)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME2) + sizeof(VALUE2)));
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 2, nHeaders);
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_fails_when_gballoc_fails)
+    /*Tests_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
+    TEST_FUNCTION(HTTPHeaders_When_Second_Added_Header_Is_A_Substring_Of_An_Existing_Header_2_Headers_Are_Added)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "ab", VALUE1);
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", VALUE2);
 
-        whenShallmalloc_fail = currentmalloc_call + 1;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 2, nHeaders);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, "ab"));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, "a"));
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_001: [ Header names shall be compared without regard to case. ]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_in_other_case_appends_to_existing_value_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
+        char* headerValue;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "Name1", VALUE1);
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "nAME1", VALUE2);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, "Name1: " VALUE1 ", " VALUE2, headerValue);
 
         ///cleanup
+        free(headerValue);
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_012:[ Calling this API shall record a header from name and value parameters.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_add_two_headers_produces_two_headers)
+    /*Tests_SRS_HTTP_HEADERS_01_002: [ A name spelled exactly as one of the commonly used header names shall not be copied. ]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_common_name_stores_only_the_value)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        char* headerValue;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME2, VALUE2))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(VALUE1)));
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "Content-Type", VALUE1);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, "Content-Type: " VALUE1, headerValue);
 
         ///cleanup
+        free(headerValue);
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
-    TEST_FUNCTION(HTTPHeaders_When_Second_Added_Header_Is_A_Substring_Of_An_Existing_Header_2_Headers_Are_Added)
+    /*Tests_SRS_HTTP_HEADERS_01_002: [ A name spelled exactly as one of the commonly used header names shall not be copied. ]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_common_name_in_other_case_keeps_its_spelling)
     {
         ///arrange
-        HTTP_HEADERS_RESULT result;
+        HTTP_HEADERS_RESULT res;
+        char* headerValue;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "ab"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "ab", VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, "a", VALUE1))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("CONTENT-TYPE") + sizeof(VALUE1)));
 
         ///act
-        result = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "CONTENT-TYPE", VALUE1);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, result);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, "CONTENT-TYPE: " VALUE1, headerValue);
+
+        ///cleanup
+        free(headerValue);
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_012:[ Calling this API shall record a header from name and value parameters.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_many_headers_keep_their_order_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        size_t nHeaders;
+        size_t i;
+
+        ///act
+        for (i = 0; i < MAX_NAME_VALUE_PAIR; i++)
+        {
+            char name[32];
+            char value[32];
+            (void)sprintf(name, "header%u", (unsigned int)i);
+            (void)sprintf(value, "value%u", (unsigned int)i);
+            ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(httpHandle, name, value));
+        }
+
+        ///assert
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, MAX_NAME_VALUE_PAIR, nHeaders);
+        for (i = 0; i < MAX_NAME_VALUE_PAIR; i++)
+        {
+            char name[32];
+            char header[64];
+            char* headerValue;
+            (void)sprintf(name, "HEADER%u", (unsigned int)i);
+            (void)sprintf(header, "header%u: value%u", (unsigned int)i, (unsigned int)i);
+            ASSERT_ARE_EQUAL(char_ptr, header + strlen(name) + 2, HTTPHeaders_FindHeaderValue(httpHandle, name));
+            ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, i, &headerValue));
+            ASSERT_ARE_EQUAL(char_ptr, header, headerValue);
+            free(headerValue);
+        }
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -651,22 +660,16 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_retrieves_previously_stored_value_succeeds)
     {
         ///arrange
-        const char* res1;
+        const char* res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1);
-
         ///act
-        res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
+        res = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
 
         ///assert
-        ASSERT_ARE_EQUAL(char_ptr, VALUE1, res1);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -681,23 +684,10 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         const char* res1;
         const char* res2;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE2);
-
         ///act
         res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
         res2 = HTTPHeaders_FindHeaderValue(httpHandle, NAME2);
@@ -715,27 +705,64 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     /*Tests_SRS_HTTP_HEADERS_99_021:[ In this case the return value shall point to a string that shall strcmp equal to the original stored string.]*/
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_retrieves_concatenation_of_previously_stored_values_for_header_name_succeeds)
     {
+        ///arrange
         const char* res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1); /*this key exists, was added above*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1 ", " VALUE2);
-
         ///act
         res = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
 
         ///assert
-        ASSERT_ARE_EQUAL(char_ptr,VALUE1 ", " VALUE2, res);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE2, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_the_stored_value_appends_a_copy_of_it)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        const char* storedValue;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        storedValue = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(NAME1) + sizeof(VALUE1 ", " VALUE1)))
+            .IgnoreArgument(1);
+
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, storedValue);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_001: [ Header names shall be compared without regard to case. ]*/
+    TEST_FUNCTION(HTTPHeaders_FindHeaderValue_with_name_in_other_case_succeeds)
+    {
+        ///arrange
+        const char* res;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "Content-Length", "10");
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_FindHeaderValue(httpHandle, "content-LENGTH");
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "10", res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -749,16 +776,9 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///arrange
         const char* res2;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-
         ///act
         res2 = HTTPHeaders_FindHeaderValue(httpHandle, NAME2);
 
@@ -779,22 +799,9 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         const char* res2;
         const char* res3;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK3))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-
         ///act
         res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1_TRICK1);
         res2 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1_TRICK2);
@@ -815,26 +822,44 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1); /*this key does not exist, the line below is adding it*/
+        ///act
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE2))
+    /* Tests_SRS_HTTP_HEADERS_06_001: [This API will perform exactly as HTTPHeaders_AddHeaderNameValuePair except that if the header name already exists the already existing value will be replaced as opposed to concatenated to.] */
+    TEST_FUNCTION(HTTPHeaders_ReplaceHeaderNameValuePair_with_longer_value_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(NAME1) + sizeof(VALUE1 VALUE2)))
             .IgnoreArgument(1);
 
         ///act
-        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, "NAME1", VALUE1 VALUE2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -848,19 +873,17 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE2))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1)));
 
         ///act
-        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE1);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -870,14 +893,13 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_NULL_handle_fails)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
         size_t nHeaders;
 
         ///act
-        res1 = HTTPHeaders_GetHeaderCount(NULL, &nHeaders);
+        HTTP_HEADERS_RESULT res = HTTPHeaders_GetHeaderCount(NULL, &nHeaders);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
@@ -885,15 +907,15 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_NULL_headersCount_fails)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
+        HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
         ///act
-        res1 = HTTPHeaders_GetHeaderCount(httpHandle, NULL);
+        res = HTTPHeaders_GetHeaderCount(httpHandle, NULL);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -906,60 +928,20 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_1_header_produces_1)
     {
         ///arrange
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        size_t nHeaders;
-        const char* keys[] = { "NAME1" };
-        const char* values[] = { "VALUE1" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-        const size_t one = 1;
         HTTP_HEADERS_RESULT res;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
-
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
-        ASSERT_ARE_EQUAL(size_t, (size_t)1, nHeaders);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        HTTPHeaders_Free(httpHandle);
-    }
-
-    /*Tests_SRS_HTTP_HEADERS_99_037:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs.]*/
-    TEST_FUNCTION(HTTPHeaders_GetHeaderCount_fails_when_Map_GetInternals_fails)
-    {
-        ///arrange
-        HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        size_t nHeaders;
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments()
-            .SetReturn(MAP_ERROR);
-
-        ///act
-        res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
-
-        ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
@@ -970,31 +952,12 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         size_t nHeaders;
-        const char* keys[2] = { "NAME1", "NAME2" };
-        const char* values[2] = { "VALUE1", "VALUE2" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-
-        const size_t two = 2;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &two, sizeof(two));
-
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
@@ -1027,9 +990,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///arrange
         HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
@@ -1052,16 +1012,8 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_RESULT res1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         char* headerValue;
-        const char* thisIsNULL = NULL;
-        const char* zero = 0;
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &thisIsNULL, sizeof(thisIsNULL))
-            .CopyOutArgumentBuffer(3, &thisIsNULL, sizeof(thisIsNULL))
-            .CopyOutArgumentBuffer(4, &zero, sizeof(zero));
-
         ///act
         res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
 
@@ -1074,30 +1026,16 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_029:[ The function shall return HTTP_HEADERS_INVALID_ARG if index is not valid (for example, out of range) for the currently stored headers.]*/
-    /*Tests that not adding something to the collection fails tso retrieve for index 0*/
+    /*Tests that adding one header to the collection fails to retrieve for index 1*/
     TEST_FUNCTION(HTTPHeaders_GetHeader_with_index_too_big_fails_2)
     {
         ///arrange
         HTTP_HEADERS_RESULT res1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        const char* keys[1] = { "NAME1" };
-        const char* values[1] = { "VALUE1" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-        const size_t one = 1;
         char* headerValue;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
         ///act
         res1 = HTTPHeaders_GetHeader(httpHandle, 1, &headerValue);
 
@@ -1117,25 +1055,10 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_RESULT res1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("a: b")));
 
         ///act
         res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
@@ -1150,66 +1073,16 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         free(headerValue);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
-    TEST_FUNCTION(HTTPHeaders_GetHeader_fails_when_Map_GetInternals_fails)
-    {
-        ///arrange
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one))
-            .SetReturn(MAP_ERROR);
-
-        ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
-
-        ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res1);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        HTTPHeaders_Free(httpHandle);
-    }
-
     /*Tests_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
     TEST_FUNCTION(HTTPHeaders_GetHeader_succeeds_fails_when_malloc_fails)
     {
         ///arrange
+        HTTP_HEADERS_RESULT res1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
         whenShallmalloc_fail = currentmalloc_call + 1;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
@@ -1223,7 +1096,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
-        free(headerValue);
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_031:[ If name contains the character ":" then the return value shall be HTTP_HEADERS_INVALID_ARG.]*/
@@ -1249,26 +1121,12 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_colon_in_value_succeeds_1)
     {
         ///arrange
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { ":" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         char* headerValue;
         HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", ":");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
@@ -1325,12 +1183,9 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1)));
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, " \r\t\n" VALUE1); /*notice how there are some LWS characters in the value*/
@@ -1338,8 +1193,248 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_003: [ If httpHeadersHandle or serializedSize is NULL, or buffer is NULL while bufferSize is not 0, HTTPHeaders_SerializeTo shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_with_NULL_handle_fails)
+    {
+        ///arrange
+        size_t serializedSize;
+
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_SerializeTo(NULL, tempBuffer, sizeof(tempBuffer), &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_003: [ If httpHeadersHandle or serializedSize is NULL, or buffer is NULL while bufferSize is not 0, HTTPHeaders_SerializeTo shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_with_NULL_serializedSize_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_SerializeTo(httpHandle, tempBuffer, sizeof(tempBuffer), NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_003: [ If httpHeadersHandle or serializedSize is NULL, or buffer is NULL while bufferSize is not 0, HTTPHeaders_SerializeTo shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_with_NULL_buffer_and_nonzero_size_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_SerializeTo(httpHandle, NULL, 1, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_004: [ HTTPHeaders_SerializeTo shall write in *serializedSize the number of bytes the serialized headers take. ]*/
+    /*Tests_SRS_HTTP_HEADERS_01_006: [ Otherwise HTTPHeaders_SerializeTo shall write every header as name+": "+value+"\r\n", in the order the headers were added and without a terminating '\0', and return HTTP_HEADERS_OK. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_with_no_headers_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize = 1;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_SerializeTo(httpHandle, NULL, 0, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(size_t, 0, serializedSize);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_004: [ HTTPHeaders_SerializeTo shall write in *serializedSize the number of bytes the serialized headers take. ]*/
+    /*Tests_SRS_HTTP_HEADERS_01_005: [ If bufferSize is smaller than that, HTTPHeaders_SerializeTo shall not write to buffer and shall return HTTP_HEADERS_INSUFFICIENT_BUFFER. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_with_too_small_buffer_returns_INSUFFICIENT_BUFFER)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_SerializeTo(httpHandle, tempBuffer, sizeof(HEADER1 "\r\n" HEADER2 "\r\n") - 2, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INSUFFICIENT_BUFFER, res);
+        ASSERT_ARE_EQUAL(size_t, sizeof(HEADER1 "\r\n" HEADER2 "\r\n") - 1, serializedSize);
+        ASSERT_ARE_EQUAL(char, 'x', tempBuffer[0]);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_004: [ HTTPHeaders_SerializeTo shall write in *serializedSize the number of bytes the serialized headers take. ]*/
+    /*Tests_SRS_HTTP_HEADERS_01_006: [ Otherwise HTTPHeaders_SerializeTo shall write every header as name+": "+value+"\r\n", in the order the headers were added and without a terminating '\0', and return HTTP_HEADERS_OK. ]*/
+    TEST_FUNCTION(HTTPHeaders_SerializeTo_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "Host", "a");
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "NAME1", "b");
+        (void)HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, "host", "example.com");
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_SerializeTo(httpHandle, tempBuffer, sizeof(tempBuffer), &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(size_t, sizeof(HEADER1 ", b\r\nHost: example.com\r\n" HEADER2 "\r\n") - 1, serializedSize);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(HEADER1 ", b\r\nHost: example.com\r\n" HEADER2 "\r\n", tempBuffer, serializedSize));
+        ASSERT_ARE_EQUAL(char, 'x', tempBuffer[serializedSize]);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_007: [ If handle, name or value is NULL, or index is not smaller than the number of stored headers, HTTPHeaders_GetHeaderNameValue shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderNameValue_with_NULL_handle_fails)
+    {
+        ///arrange
+        const char* name;
+        const char* value;
 
-        //checking content
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_GetHeaderNameValue(NULL, 0, &name, &value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_007: [ If handle, name or value is NULL, or index is not smaller than the number of stored headers, HTTPHeaders_GetHeaderNameValue shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderNameValue_with_NULL_name_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        const char* value;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_GetHeaderNameValue(httpHandle, 0, NULL, &value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_007: [ If handle, name or value is NULL, or index is not smaller than the number of stored headers, HTTPHeaders_GetHeaderNameValue shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderNameValue_with_NULL_value_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        const char* name;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_GetHeaderNameValue(httpHandle, 0, &name, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_007: [ If handle, name or value is NULL, or index is not smaller than the number of stored headers, HTTPHeaders_GetHeaderNameValue shall fail and return HTTP_HEADERS_INVALID_ARG. ]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderNameValue_with_index_out_of_range_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        const char* name;
+        const char* value;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_GetHeaderNameValue(httpHandle, 1, &name, &value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_01_008: [ Otherwise HTTPHeaders_GetHeaderNameValue shall write in *name and *value the stored name and value of the header at index, without copying them, and return HTTP_HEADERS_OK. ]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderNameValue_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res0;
+        HTTP_HEADERS_RESULT res1;
+        const char* name0;
+        const char* value0;
+        const char* name1;
+        const char* value1;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "Host", "a");
+        (void)HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, "host", "example.com");
+        umock_c_reset_all_calls();
+
+        ///act
+        res0 = HTTPHeaders_GetHeaderNameValue(httpHandle, 0, &name0, &value0);
+        res1 = HTTPHeaders_GetHeaderNameValue(httpHandle, 1, &name1, &value1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res0);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res1);
+        ASSERT_ARE_EQUAL(char_ptr, NAME1, name0);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, value0);
+        ASSERT_ARE_EQUAL(char_ptr, "Host", name1);
+        ASSERT_ARE_EQUAL(char_ptr, "example.com", value1);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -1363,13 +1458,19 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_HANDLE result;
+        size_t nHeaders;
+        char* headerValue;
         HTTP_HEADERS_HANDLE source = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(source, NAME1, VALUE1);
+        (void)HTTPHeaders_AddHeaderNameValuePair(source, "Content-Type", VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*the handle*/
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*the header table*/
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1)));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(VALUE2)));
 
         ///act
         result = HTTPHeaders_Clone(source);
@@ -1377,25 +1478,40 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///assert
         ASSERT_IS_NOT_NULL(result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        HTTPHeaders_Free(source);
+        (void)HTTPHeaders_GetHeaderCount(result, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 2, nHeaders);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(result, NAME1));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(result, "content-type"));
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(result, 1, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, "Content-Type: " VALUE2, headerValue);
 
         ///cleanup
-        HTTPHeaders_Free(source);
+        free(headerValue);
         HTTPHeaders_Free(result);
     }
 
     /*Tests_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
-    TEST_FUNCTION(HTTPHEADERS_Clone_fails_when_map_clone_fails)
+    TEST_FUNCTION(HTTPHEADERS_Clone_fails_when_a_header_malloc_fails)
     {
         ///arrange
         HTTP_HEADERS_HANDLE result;
         HTTP_HEADERS_HANDLE source = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AddHeaderNameValuePair(source, NAME1, VALUE1);
+        (void)HTTPHeaders_AddHeaderNameValuePair(source, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
+        whenShallmalloc_fail = currentmalloc_call + 4;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG))
-            .IgnoreArgument(1).SetReturn(NULL);
-
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME1) + sizeof(VALUE1)));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(NAME2) + sizeof(VALUE2)));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
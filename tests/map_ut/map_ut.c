@@ -3,8 +3,10 @@
 
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstdio>
 #else
 #include <stdlib.h>
+#include <stdio.h>
 #endif
 
 #include "azure_c_shared_utility/optimize_size.h"
@@ -546,10 +548,6 @@ BEGIN_TEST_SUITE(map_unittests)
         /*below are undo actions*/
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*undo copy of blue key*/
             .ValidateArgumentBuffer(1, TEST_BLUEKEY, strlen(TEST_BLUEKEY) + 1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing values*/
-            .IgnoreArgument(1);
 
 
         ///act
@@ -601,11 +599,7 @@ BEGIN_TEST_SUITE(map_unittests)
         whenShallmalloc_fail = currentmalloc_call + 3;
         STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*copy of blue key*/
 
-        /*below are undo actions*/
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing values*/
-            .IgnoreArgument(1);
+        /*below are undo actions*/ /*none*/
 
 
         ///act
@@ -655,9 +649,7 @@ BEGIN_TEST_SUITE(map_unittests)
         STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * sizeof(const char*))) /*growing values*/
             .IgnoreArgument(1);
 
-        /*below are undo actions*/
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
+        /*below are undo actions*/ /*none*/
 
         ///act
         result1 = Map_Add(handle, TEST_REDKEY, TEST_REDVALUE);
@@ -1106,10 +1098,6 @@ BEGIN_TEST_SUITE(map_unittests)
         /*below are undo actions*/
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*undo blue key value*/
             .ValidateArgumentBuffer(1, TEST_BLUEKEY, strlen(TEST_BLUEKEY) + 1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing values*/
-            .IgnoreArgument(1);
 
         ///act
         result1 = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
@@ -1154,11 +1142,7 @@ BEGIN_TEST_SUITE(map_unittests)
         whenShallmalloc_fail = currentmalloc_call + 3;
         STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*copy of red key*/
 
-        /*below are undo actions*/
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing values*/
-            .IgnoreArgument(1);
+        /*below are undo actions*/ /*none*/
 
         ///act
         result1 = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
@@ -1202,9 +1186,7 @@ BEGIN_TEST_SUITE(map_unittests)
         STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * sizeof(const char*))) /*growing values*/
             .IgnoreArgument(1);
 
-        /*below are undo actions*/
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*undo growing keys*/
-            .IgnoreArgument(1);
+        /*below are undo actions*/ /*none*/
 
         ///act
         result1 = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
@@ -1689,12 +1671,6 @@ BEGIN_TEST_SUITE(map_unittests)
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*freeing yellow value*/
             .ValidateArgumentBuffer(1, TEST_YELLOWVALUE, strlen(TEST_YELLOWVALUE) + 1);
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1* sizeof(const char*))) /*ungrowing values*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*ungrowing keys*/
-            .IgnoreArgument(1);
-
         ///act
         result1 = Map_Delete(handle, TEST_YELLOWKEY);
         result3 = Map_GetInternals(handle, &keys, &values, &count);
@@ -1732,12 +1708,6 @@ BEGIN_TEST_SUITE(map_unittests)
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*freeing yellow value*/
             .ValidateArgumentBuffer(1, TEST_REDVALUE, strlen(TEST_REDVALUE) + 1);
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*ungrowing values*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1 * sizeof(const char*))) /*ungrowing keys*/
-            .IgnoreArgument(1);
-
         ///act
         result1 = Map_Delete(handle, TEST_REDKEY);
         result3 = Map_GetInternals(handle, &keys, &values, &count);
@@ -1754,6 +1724,52 @@ BEGIN_TEST_SUITE(map_unittests)
         Map_Destroy(handle);
     }
 
+    TEST_FUNCTION(Map_with_many_keys_finds_all_keys_and_keeps_insertion_order_after_delete)
+    {
+        ///arrange
+        MAP_HANDLE handle = Map_Create(NULL);
+        const char*const* keys;
+        const char*const* values;
+        size_t count;
+        char key[16];
+        char value[16];
+        size_t i;
+        MAP_RESULT result1;
+        MAP_RESULT result2;
+        for (i = 0; i < 40; i++)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            (void)sprintf(value, "value%u", (unsigned int)i);
+            (void)Map_Add(handle, key, value);
+        }
+        umock_c_reset_all_calls();
+
+        ///act
+        result1 = Map_Delete(handle, "key5");
+        result2 = Map_GetInternals(handle, &keys, &values, &count);
+
+        ///assert
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result1);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result2);
+        ASSERT_ARE_EQUAL(size_t, 39, count);
+        ASSERT_ARE_EQUAL(char_ptr, "key4", keys[4]);
+        ASSERT_ARE_EQUAL(char_ptr, "key6", keys[5]);
+        ASSERT_ARE_EQUAL(char_ptr, "value39", values[38]);
+        ASSERT_IS_NULL(Map_GetValueFromKey(handle, "key5"));
+        for (i = 0; i < 40; i++)
+        {
+            if (i != 5)
+            {
+                (void)sprintf(key, "key%u", (unsigned int)i);
+                (void)sprintf(value, "value%u", (unsigned int)i);
+                ASSERT_ARE_EQUAL(char_ptr, value, Map_GetValueFromKey(handle, key));
+            }
+        }
+
+        ///cleanup
+        Map_Destroy(handle);
+    }
+
     /*Tests_SRS_MAP_02_024: [If parameter handle, key or keyExists are NULL then Map_ContainsKey shall return MAP_INVALIDARG.]*/
     TEST_FUNCTION(Map_ContainsKey_fails_with_invalid_arg_1)
     {
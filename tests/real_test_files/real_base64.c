@@ -4,6 +4,8 @@
 #define Base64_Encoder real_Base64_Encoder
 #define Base64_Encode_Bytes real_Base64_Encode_Bytes
 #define Base64_Decoder real_Base64_Decoder
+#define Base64_Encode_Into real_Base64_Encode_Into
+#define Base64_Decode_Into real_Base64_Decode_Into
 
 #define GBALLOC_H
 
@@ -19,6 +19,7 @@
 #define BUFFER_append_build real_BUFFER_append_build
 #define BUFFER_shrink real_BUFFER_shrink
 #define BUFFER_fill real_BUFFER_fill
+#define BUFFER_reserve real_BUFFER_reserve
 
 #define GBALLOC_H
 
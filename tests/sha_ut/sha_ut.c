@@ -12,9 +12,11 @@
  */
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstring>
 #include <ctime>
 #else
 #include <stddef.h>
+#include <string.h>
 #include <time.h>
 #endif
 
@@ -433,4 +435,66 @@ BEGIN_TEST_SUITE(sha_ut)
         //cleanup
     }
 
+    TEST_FUNCTION(SHA256Result_two_block_message_succeeds)
+    {
+        //arrange
+        static const char message[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+        static const uint8_t expected[SHA256HashSize] = {
+            0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+            0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1
+        };
+        int result;
+        SHA256Context sha_ctx;
+        uint8_t digest[SHA256HashSize];
+
+        //act
+        result = SHA256Reset(&sha_ctx);
+        result |= SHA256Input(&sha_ctx, (const uint8_t*)message, sizeof(message) - 1);
+        result |= SHA256Result(&sha_ctx, digest);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(expected, digest, SHA256HashSize));
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(SHA256Result_million_a_in_pieces_succeeds)
+    {
+        //arrange
+        static const uint8_t expected[SHA256HashSize] = {
+            0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+            0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+        };
+        int result;
+        SHA256Context sha_ctx;
+        uint8_t bytes[1000];
+        uint8_t digest[SHA256HashSize];
+        unsigned int total = 0;
+        unsigned int count = 1;
+
+        (void)memset(bytes, 'a', sizeof(bytes));
+
+        //act
+        /* pieces of varying size go through both the buffered and the whole block paths */
+        result = SHA256Reset(&sha_ctx);
+        while (total < 1000000)
+        {
+            if (count > 1000000 - total)
+            {
+                count = 1000000 - total;
+            }
+            result |= SHA256Input(&sha_ctx, bytes, count);
+            total += count;
+            count = (count * 7 + 3) % 1000 + 1;
+        }
+        result |= SHA256Result(&sha_ctx, digest);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(expected, digest, SHA256HashSize));
+
+        //cleanup
+    }
+
 END_TEST_SUITE(sha_ut)
@@ -2,51 +2,1339 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <cerrno>
 #else
+#include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #endif
 
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+/* the receive buffer cannot grow while this is set */
+static bool gballoc_realloc_fails;
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return gballoc_realloc_fails ? NULL : realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
 #include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "azure_c_shared_utility/macro_utils.h"
 
 #define ENABLE_MOCKS
-
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "dns_async.h"
+#ifdef USE_IO_URING
+#include "azure_c_shared_utility/socketio_uring.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, int, socket, int, domain, int, type, int, protocol);
+    MOCKABLE_FUNCTION(, int, connect, int, sockfd, const struct sockaddr*, addr, socklen_t, addrlen);
+    MOCKABLE_FUNCTION(, int, setsockopt, int, sockfd, int, level, int, optname, const void*, optval, socklen_t, optlen);
+    MOCKABLE_FUNCTION(, int, getsockopt, int, sockfd, int, level, int, optname, void*, optval, socklen_t*, optlen);
+    MOCKABLE_FUNCTION(, int, poll, struct pollfd*, fds, nfds_t, nfds, int, timeout);
+    MOCKABLE_FUNCTION(, ssize_t, sendmsg, int, sockfd, const struct msghdr*, msg, int, flags);
+    MOCKABLE_FUNCTION(, ssize_t, recv, int, sockfd, void*, buf, size_t, len, int, flags);
+    MOCKABLE_FUNCTION(, int, shutdown, int, sockfd, int, how);
+    MOCKABLE_FUNCTION(, int, close, int, fd);
+    MOCKABLE_FUNCTION(, int, epoll_create1, int, flags);
+    MOCKABLE_FUNCTION(, int, epoll_ctl, int, epfd, int, op, int, fd, struct epoll_event*, event);
+    MOCKABLE_FUNCTION(, int, epoll_wait, int, epfd, struct epoll_event*, events, int, maxevents, int, timeout);
+#ifdef __cplusplus
+}
+#endif
 
 #undef ENABLE_MOCKS
 
-#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "socketio_berkeley.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    extern SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    extern void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    extern int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle);
+    extern const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+// Non-tested functions from fcntl.h and sys/ioctl.h, the sockets are made non-blocking and no network interface is selected
+int fcntl(int fd, int cmd, ... /* arg */) { (void)fd; (void)cmd; return 0; }
+int ioctl(int fd, unsigned long request, ... /* arg */) { (void)fd; (void)request; errno = ENOTTY; return -1; }
+
+#define TEST_FIRST_SOCKET       100
+#define TEST_MAX_SOCKETS        8
+#define TEST_EVENT_LOOP_FD      500
+#define TEST_MAX_SOCKET_OPTIONS 32
+#define TEST_PORT               443
+#define TEST_HOSTNAME           "test.azure-devices.net"
+
+static DNS_ASYNC_HANDLE TEST_DNS_HANDLE = (DNS_ASYNC_HANDLE)0x4242;
+static TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4243;
+
+/* the state of the sockets handed out by the socket mock, the socket with descriptor TEST_FIRST_SOCKET + i is test_sockets[i] */
+typedef struct TEST_SOCKET_TAG
+{
+    int family;
+    bool is_closed;
+    /* poll reports a pending connection as complete once this is set, connect_error being its SO_ERROR */
+    bool is_connect_complete;
+    int connect_error;
+    bool is_in_event_loop;
+    uint32_t event_loop_events;
+    void* event_loop_data;
+    /* reported by epoll_wait for as long as they match the events the socket was registered for */
+    uint32_t ready_events;
+} TEST_SOCKET;
+
+typedef struct TEST_SOCKET_OPTION_TAG
+{
+    int socket;
+    int level;
+    int name;
+    int value;
+} TEST_SOCKET_OPTION;
+
+static TEST_SOCKET test_sockets[TEST_MAX_SOCKETS];
+static size_t test_socket_count;
+static int connect_errno;
+
+static size_t epoll_create_count;
+static bool is_event_loop_open;
+static size_t epoll_wait_count;
+static int last_epoll_wait_timeout;
+
+static TEST_SOCKET_OPTION set_socket_options[TEST_MAX_SOCKET_OPTIONS];
+static size_t set_socket_option_count;
+static int setsockopt_result;
+
+/* bytes accepted by the next sendmsg calls, EAGAIN is reported once they are used */
+static size_t send_capacity;
+static int send_errno;
+static unsigned char sent_bytes[256];
+static size_t sent_byte_count;
+static size_t sendmsg_count;
+
+static const unsigned char* recv_data;
+static size_t recv_data_size;
+/* number of recv calls filling the whole buffer before recv_data is used */
+static size_t recv_full_count;
+static size_t last_recv_size;
+static bool recv_reports_end_of_stream;
+
+static bool dns_async_create_fails;
+static bool dns_lookup_complete;
+static DNS_ASYNC_ADDRESS test_addresses[4];
+static size_t test_address_count;
+static size_t dns_async_destroy_count;
+static tickcounter_ms_t test_current_ms;
+
+static size_t open_complete_count;
+static IO_OPEN_RESULT last_open_result;
+static unsigned char received_bytes[256];
+static size_t received_byte_count;
+static size_t on_bytes_received_count;
+static size_t io_error_count;
+static size_t send_complete_count;
+static IO_SEND_RESULT last_send_result;
+static CONCRETE_IO_HANDLE socket_io_to_destroy;
+static int nested_dowork_all_result;
+
+static TEST_SOCKET* get_test_socket(int fd)
+{
+    ASSERT_IS_TRUE((fd >= TEST_FIRST_SOCKET) && (fd < TEST_FIRST_SOCKET + (int)test_socket_count));
+    return &test_sockets[fd - TEST_FIRST_SOCKET];
+}
+
+static int create_test_socket(int family)
+{
+    ASSERT_IS_TRUE(test_socket_count < TEST_MAX_SOCKETS);
+    memset(&test_sockets[test_socket_count], 0, sizeof(TEST_SOCKET));
+    test_sockets[test_socket_count].family = family;
+    return TEST_FIRST_SOCKET + (int)test_socket_count++;
+}
+
+static int my_socket(int domain, int type, int protocol)
+{
+    (void)type;
+    (void)protocol;
+    return create_test_socket(domain);
+}
+
+static int my_connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+    int result;
+    (void)addr;
+    (void)addrlen;
+
+    if (connect_errno == 0)
+    {
+        get_test_socket(sockfd)->is_connect_complete = true;
+        result = 0;
+    }
+    else
+    {
+        errno = connect_errno;
+        result = -1;
+    }
+
+    return result;
+}
+
+static int my_setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    int result;
+
+    ASSERT_ARE_EQUAL(size_t, sizeof(int), (size_t)optlen);
+    ASSERT_IS_TRUE(set_socket_option_count < TEST_MAX_SOCKET_OPTIONS);
+    set_socket_options[set_socket_option_count].socket = sockfd;
+    set_socket_options[set_socket_option_count].level = level;
+    set_socket_options[set_socket_option_count].name = optname;
+    set_socket_options[set_socket_option_count].value = *(const int*)optval;
+    set_socket_option_count++;
+
+    result = setsockopt_result;
+    if (result != 0)
+    {
+        errno = ENOPROTOOPT;
+    }
+
+    return result;
+}
+
+static int my_getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    ASSERT_ARE_EQUAL(int, SOL_SOCKET, level);
+    ASSERT_ARE_EQUAL(int, SO_ERROR, optname);
+    ASSERT_ARE_EQUAL(size_t, sizeof(int), (size_t)*optlen);
+    *(int*)optval = get_test_socket(sockfd)->connect_error;
+    return 0;
+}
+
+static int my_poll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    int result = 0;
+    nfds_t i;
+    (void)timeout;
+
+    for (i = 0; i < nfds; i++)
+    {
+        TEST_SOCKET* test_socket = get_test_socket(fds[i].fd);
+        fds[i].revents = 0;
+        if (test_socket->is_connect_complete)
+        {
+            fds[i].revents = (short)((test_socket->connect_error == 0) ? POLLOUT : (POLLOUT | POLLERR));
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static ssize_t my_sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    ssize_t result;
+    (void)flags;
+
+    ASSERT_IS_FALSE(get_test_socket(sockfd)->is_closed);
+    sendmsg_count++;
+
+    if (send_errno != 0)
+    {
+        errno = send_errno;
+        result = -1;
+    }
+    else if (send_capacity == 0)
+    {
+        errno = EAGAIN;
+        result = -1;
+    }
+    else
+    {
+        size_t sent = 0;
+        size_t i;
+
+        for (i = 0; i < (size_t)msg->msg_iovlen && send_capacity > 0; i++)
+        {
+            size_t size = (msg->msg_iov[i].iov_len < send_capacity) ? msg->msg_iov[i].iov_len : send_capacity;
+            ASSERT_IS_TRUE(sent_byte_count + size <= sizeof(sent_bytes));
+            (void)memcpy(sent_bytes + sent_byte_count, msg->msg_iov[i].iov_base, size);
+            sent_byte_count += size;
+            sent += size;
+            send_capacity -= size;
+        }
+
+        result = (ssize_t)sent;
+    }
+
+    return result;
+}
+
+static ssize_t my_recv(int sockfd, void* buf, size_t len, int flags)
+{
+    ssize_t result;
+    (void)flags;
+
+    ASSERT_IS_FALSE(get_test_socket(sockfd)->is_closed);
+    last_recv_size = len;
+
+    if (recv_full_count > 0)
+    {
+        recv_full_count--;
+        (void)memset(buf, 'x', len);
+        result = (ssize_t)len;
+    }
+    else if (recv_data_size > 0)
+    {
+        size_t size = (recv_data_size < len) ? recv_data_size : len;
+        (void)memcpy(buf, recv_data, size);
+        recv_data += size;
+        recv_data_size -= size;
+        result = (ssize_t)size;
+    }
+    else if (recv_reports_end_of_stream)
+    {
+        result = 0;
+    }
+    else
+    {
+        errno = EAGAIN;
+        result = -1;
+    }
+
+    return result;
+}
+
+static int my_shutdown(int sockfd, int how)
+{
+    (void)sockfd;
+    (void)how;
+    return 0;
+}
+
+static int my_close(int fd)
+{
+    if (fd == TEST_EVENT_LOOP_FD)
+    {
+        ASSERT_IS_TRUE(is_event_loop_open);
+        is_event_loop_open = false;
+    }
+    else
+    {
+        TEST_SOCKET* test_socket = get_test_socket(fd);
+        ASSERT_IS_FALSE(test_socket->is_closed);
+        test_socket->is_closed = true;
+    }
+
+    return 0;
+}
+
+static int my_epoll_create1(int flags)
+{
+    (void)flags;
+    ASSERT_IS_FALSE(is_event_loop_open);
+    epoll_create_count++;
+    is_event_loop_open = true;
+    return TEST_EVENT_LOOP_FD;
+}
+
+static int my_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    TEST_SOCKET* test_socket = get_test_socket(fd);
+
+    ASSERT_ARE_EQUAL(int, TEST_EVENT_LOOP_FD, epfd);
+    ASSERT_IS_TRUE(is_event_loop_open);
+
+    switch (op)
+    {
+    case EPOLL_CTL_ADD:
+        ASSERT_IS_FALSE(test_socket->is_in_event_loop);
+        test_socket->is_in_event_loop = true;
+        test_socket->event_loop_events = event->events;
+        test_socket->event_loop_data = event->data.ptr;
+        break;
+    case EPOLL_CTL_MOD:
+        ASSERT_IS_TRUE(test_socket->is_in_event_loop);
+        test_socket->event_loop_events = event->events;
+        test_socket->event_loop_data = event->data.ptr;
+        break;
+    default:
+        ASSERT_ARE_EQUAL(int, EPOLL_CTL_DEL, op);
+        ASSERT_IS_TRUE(test_socket->is_in_event_loop);
+        test_socket->is_in_event_loop = false;
+        break;
+    }
+
+    return 0;
+}
+
+static int my_epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout)
+{
+    int result = 0;
+    size_t i;
+
+    ASSERT_ARE_EQUAL(int, TEST_EVENT_LOOP_FD, epfd);
+    epoll_wait_count++;
+    last_epoll_wait_timeout = timeout;
+
+    for (i = 0; i < test_socket_count && result < maxevents; i++)
+    {
+        uint32_t ready_events = test_sockets[i].ready_events & (test_sockets[i].event_loop_events | EPOLLERR | EPOLLHUP);
+        if (test_sockets[i].is_in_event_loop && ready_events != 0)
+        {
+            events[result].events = ready_events;
+            events[result].data.ptr = test_sockets[i].event_loop_data;
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static DNS_ASYNC_HANDLE my_dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* options)
+{
+    (void)options;
+    ASSERT_ARE_EQUAL(char_ptr, TEST_HOSTNAME, hostname);
+    return dns_async_create_fails ? NULL : TEST_DNS_HANDLE;
+}
+
+static bool my_dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns)
+{
+    (void)dns;
+    return dns_lookup_complete;
+}
+
+static size_t my_dns_async_get_address_count(DNS_ASYNC_HANDLE dns)
+{
+    (void)dns;
+    return test_address_count;
+}
+
+static int my_dns_async_get_address(DNS_ASYNC_HANDLE dns, size_t index, DNS_ASYNC_ADDRESS* address)
+{
+    (void)dns;
+    ASSERT_IS_TRUE(index < test_address_count);
+    *address = test_addresses[index];
+    return 0;
+}
+
+static void my_dns_async_destroy(DNS_ASYNC_HANDLE dns)
+{
+    (void)dns;
+    dns_async_destroy_count++;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = test_current_ms;
+    return 0;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    open_complete_count++;
+    last_open_result = open_result;
+}
+
+/* destroys socket_io_to_destroy, which socketio_dowork_all would advance later in the same round */
+static void on_io_open_complete_destroy_other(void* context, IO_OPEN_RESULT open_result)
+{
+    on_io_open_complete(context, open_result);
+    if (socket_io_to_destroy != NULL)
+    {
+        socketio_destroy(socket_io_to_destroy);
+        socket_io_to_destroy = NULL;
+    }
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    on_bytes_received_count++;
+    if (received_byte_count + size <= sizeof(received_bytes))
+    {
+        (void)memcpy(received_bytes + received_byte_count, buffer, size);
+        received_byte_count += size;
+    }
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    io_error_count++;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    send_complete_count++;
+    last_send_result = send_result;
+}
+
+/* destroys socket_io_to_destroy, which is serviced later in the same event loop round */
+static void on_bytes_received_destroy_other(void* context, const unsigned char* buffer, size_t size)
+{
+    on_bytes_received(context, buffer, size);
+    if (socket_io_to_destroy != NULL)
+    {
+        socketio_destroy(socket_io_to_destroy);
+        socket_io_to_destroy = NULL;
+    }
+}
+
+static void on_io_open_complete_call_dowork_all(void* context, IO_OPEN_RESULT open_result)
+{
+    on_io_open_complete(context, open_result);
+    nested_dowork_all_result = socketio_dowork_all(0);
+}
+
+static void on_bytes_received_call_dowork_all(void* context, const unsigned char* buffer, size_t size)
+{
+    on_bytes_received(context, buffer, size);
+    nested_dowork_all_result = socketio_dowork_all(0);
+}
+
+static void set_constbuffer(CONSTBUFFER* constbuffer, const unsigned char* buffer, size_t size)
+{
+    constbuffer->buffer = buffer;
+    constbuffer->size = size;
+}
+
+/* the bytes given to sendmsg so far, as a string */
+static const char* get_sent_bytes(void)
+{
+    static char sent_string[sizeof(sent_bytes) + 1];
+    (void)memcpy(sent_string, sent_bytes, sent_byte_count);
+    sent_string[sent_byte_count] = '\0';
+    return sent_string;
+}
+
+static CONCRETE_IO_HANDLE create_accepted_socket_io(bool use_event_loop, ON_BYTES_RECEIVED bytes_received_callback)
+{
+    int accepted_socket = create_test_socket(AF_INET);
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE result;
+
+    config.hostname = NULL;
+    config.port = TEST_PORT;
+    config.accepted_socket = &accepted_socket;
+
+    result = socketio_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    if (use_event_loop)
+    {
+        ASSERT_ARE_EQUAL(int, 0, socketio_setoption(result, OPTION_SOCKETIO_USE_EVENT_LOOP, &use_event_loop));
+    }
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(result, on_io_open_complete, NULL, bytes_received_callback, NULL, on_io_error, NULL));
+
+    return result;
+}
+
+/* opens a connection to TEST_HOSTNAME, which completes once socketio_dowork or socketio_dowork_all connects to a resolved address */
+static CONCRETE_IO_HANDLE create_opening_socket_io(bool use_event_loop, ON_IO_OPEN_COMPLETE open_complete_callback)
+{
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE result;
+
+    config.hostname = TEST_HOSTNAME;
+    config.port = TEST_PORT;
+    config.accepted_socket = NULL;
+
+    result = socketio_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    if (use_event_loop)
+    {
+        ASSERT_ARE_EQUAL(int, 0, socketio_setoption(result, OPTION_SOCKETIO_USE_EVENT_LOOP, &use_event_loop));
+    }
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(result, open_complete_callback, NULL, on_bytes_received, NULL, on_io_error, NULL));
+
+    return result;
+}
+
+static void add_test_address(DNS_ASYNC_ADDRESS_TYPE type, unsigned char last_byte)
+{
+    ASSERT_IS_TRUE(test_address_count < sizeof(test_addresses) / sizeof(test_addresses[0]));
+    memset(&test_addresses[test_address_count], 0, sizeof(DNS_ASYNC_ADDRESS));
+    test_addresses[test_address_count].type = type;
+    test_addresses[test_address_count].address[(type == DNS_ASYNC_ADDRESS_TYPE_IPV4) ? 3 : 15] = last_byte;
+    test_address_count++;
+}
+
+/* the value given to the setsockopt call of socket with the option, -1 when the option was not set on it */
+static int get_set_socket_option(int socket, int level, int name)
+{
+    int result = -1;
+    size_t i;
+
+    for (i = 0; i < set_socket_option_count; i++)
+    {
+        if (set_socket_options[i].socket == socket && set_socket_options[i].level == level && set_socket_options[i].name == name)
+        {
+            result = set_socket_options[i].value;
+        }
+    }
+
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+BEGIN_TEST_SUITE(socketio_berkeley_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+    size_t type_size;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // Unnatural type_size variable exists to avoid "conditional expression is constant" warning
+    type_size = sizeof(ssize_t);
+    if (type_size == sizeof(int32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int64_t);
+    }
+
+    type_size = sizeof(socklen_t);
+    if (type_size == sizeof(uint32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(socklen_t, uint32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(socklen_t, uint64_t);
+    }
+
+    type_size = sizeof(nfds_t);
+    if (type_size == sizeof(uint32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(nfds_t, uint32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(nfds_t, uint64_t);
+    }
+
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(DNS_ASYNC_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, real_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_create, my_dns_async_create);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_is_lookup_complete, my_dns_async_is_lookup_complete);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_get_address_count, my_dns_async_get_address_count);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_get_address, my_dns_async_get_address);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_destroy, my_dns_async_destroy);
+
+    REGISTER_GLOBAL_MOCK_HOOK(socket, my_socket);
+    REGISTER_GLOBAL_MOCK_HOOK(connect, my_connect);
+    REGISTER_GLOBAL_MOCK_HOOK(setsockopt, my_setsockopt);
+    REGISTER_GLOBAL_MOCK_HOOK(getsockopt, my_getsockopt);
+    REGISTER_GLOBAL_MOCK_HOOK(poll, my_poll);
+    REGISTER_GLOBAL_MOCK_HOOK(sendmsg, my_sendmsg);
+    REGISTER_GLOBAL_MOCK_HOOK(recv, my_recv);
+    REGISTER_GLOBAL_MOCK_HOOK(shutdown, my_shutdown);
+    REGISTER_GLOBAL_MOCK_HOOK(close, my_close);
+    REGISTER_GLOBAL_MOCK_HOOK(epoll_create1, my_epoll_create1);
+    REGISTER_GLOBAL_MOCK_HOOK(epoll_ctl, my_epoll_ctl);
+    REGISTER_GLOBAL_MOCK_HOOK(epoll_wait, my_epoll_wait);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    gballoc_realloc_fails = false;
+    test_socket_count = 0;
+    connect_errno = EINPROGRESS;
+    epoll_create_count = 0;
+    epoll_wait_count = 0;
+    last_epoll_wait_timeout = 0;
+    set_socket_option_count = 0;
+    setsockopt_result = 0;
+    send_capacity = SIZE_MAX;
+    send_errno = 0;
+    sent_byte_count = 0;
+    sendmsg_count = 0;
+    recv_data = NULL;
+    recv_data_size = 0;
+    recv_full_count = 0;
+    last_recv_size = 0;
+    recv_reports_end_of_stream = false;
+    dns_async_create_fails = false;
+    dns_lookup_complete = false;
+    test_address_count = 0;
+    dns_async_destroy_count = 0;
+    test_current_ms = 0;
+    open_complete_count = 0;
+    last_open_result = IO_OPEN_ERROR;
+    received_byte_count = 0;
+    on_bytes_received_count = 0;
+    io_error_count = 0;
+    send_complete_count = 0;
+    last_send_result = IO_SEND_ERROR;
+    socket_io_to_destroy = NULL;
+    nested_dowork_all_result = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    /* every test leaves the event loop empty, which closes it */
+    ASSERT_IS_FALSE(is_event_loop_open);
+
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* socketio_dowork_all */
+
+TEST_FUNCTION(socketio_open_with_the_event_loop_option_adds_the_socket_to_the_event_loop)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    // act
+    socket_io = create_accepted_socket_io(true, on_bytes_received);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, epoll_create_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_in_event_loop);
+    ASSERT_ARE_EQUAL(uint32_t, EPOLLIN | EPOLLRDHUP, test_sockets[0].event_loop_events);
+    ASSERT_ARE_EQUAL(void_ptr, socket_io, test_sockets[0].event_loop_data);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_open_without_the_event_loop_option_leaves_the_socket_out_of_the_event_loop)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    // act
+    socket_io = create_accepted_socket_io(false, on_bytes_received);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, epoll_create_count);
+    ASSERT_IS_FALSE(test_sockets[0].is_in_event_loop);
+    ASSERT_ARE_EQUAL(int, 0, socketio_dowork_all(0));
+    ASSERT_ARE_EQUAL(size_t, 0, epoll_wait_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(the_sockets_in_the_event_loop_share_one_epoll_instance)
+{
+    // arrange
+    CONCRETE_IO_HANDLE first = create_accepted_socket_io(true, on_bytes_received);
+    CONCRETE_IO_HANDLE second;
+
+    // act
+    second = create_accepted_socket_io(true, on_bytes_received);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, epoll_create_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_in_event_loop);
+    ASSERT_IS_TRUE(test_sockets[1].is_in_event_loop);
+
+    // cleanup
+    socketio_destroy(first);
+    ASSERT_IS_TRUE(is_event_loop_open);
+    socketio_destroy(second);
+}
+
+TEST_FUNCTION(socketio_dowork_all_receives_from_a_readable_socket)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    test_sockets[0].ready_events = EPOLLIN;
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    int result = socketio_dowork_all(100);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, epoll_wait_count);
+    ASSERT_ARE_EQUAL(int, 100, last_epoll_wait_timeout);
+    ASSERT_ARE_EQUAL(size_t, sizeof(data), received_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(data, received_bytes, sizeof(data)));
+    ASSERT_ARE_EQUAL(size_t, 0, sendmsg_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_all_does_not_touch_a_socket_that_is_not_ready)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, on_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 0, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_does_not_service_a_socket_in_the_event_loop)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, on_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 0, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_send_that_cannot_complete_asks_the_event_loop_for_writability)
+{
+    // arrange
+    const unsigned char data[] = { '1', '2', '3', '4' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    send_capacity = 0;
+
+    // act
+    int result = socketio_send(socket_io, data, sizeof(data), on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
+    ASSERT_ARE_EQUAL(uint32_t, EPOLLIN | EPOLLRDHUP | EPOLLOUT, test_sockets[0].event_loop_events);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_all_sends_the_pending_data_of_a_writable_socket)
+{
+    // arrange
+    const unsigned char data[] = { '1', '2', '3', '4' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    send_capacity = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, data, sizeof(data), on_send_complete, NULL));
+    send_capacity = SIZE_MAX;
+    test_sockets[0].ready_events = EPOLLOUT;
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, last_send_result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(data), sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(data, sent_bytes, sizeof(data)));
+    /* nothing is left to send, writability is not asked for anymore */
+    ASSERT_ARE_EQUAL(uint32_t, EPOLLIN | EPOLLRDHUP, test_sockets[0].event_loop_events);
+    ASSERT_ARE_EQUAL(size_t, 0, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_all_services_every_ready_socket)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b' };
+    CONCRETE_IO_HANDLE first = create_accepted_socket_io(true, on_bytes_received);
+    CONCRETE_IO_HANDLE second = create_accepted_socket_io(true, on_bytes_received);
+    test_sockets[0].ready_events = EPOLLIN;
+    test_sockets[1].ready_events = EPOLLIN;
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, epoll_wait_count);
+    /* the first socket reads everything, the second one is still read and finds nothing */
+    ASSERT_ARE_EQUAL(size_t, sizeof(data), received_byte_count);
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    socketio_destroy(second);
+    socketio_destroy(first);
+}
+
+TEST_FUNCTION(a_socket_closed_by_its_peer_is_removed_from_the_event_loop)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+    test_sockets[0].ready_events = EPOLLIN | EPOLLRDHUP;
+    recv_reports_end_of_stream = true;
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
+    ASSERT_IS_FALSE(test_sockets[0].is_in_event_loop);
+    /* it was the only socket in the event loop */
+    ASSERT_IS_FALSE(is_event_loop_open);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_close_removes_the_socket_from_the_event_loop)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received);
+
+    // act
+    int result = socketio_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(test_sockets[0].is_in_event_loop);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_FALSE(is_event_loop_open);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_destroy_removes_the_socket_from_the_event_loop)
+{
+    // arrange
+    CONCRETE_IO_HANDLE first = create_accepted_socket_io(true, on_bytes_received);
+    CONCRETE_IO_HANDLE second = create_accepted_socket_io(true, on_bytes_received);
+
+    // act
+    socketio_destroy(first);
+
+    // assert
+    ASSERT_IS_FALSE(test_sockets[0].is_in_event_loop);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_TRUE(test_sockets[1].is_in_event_loop);
+    ASSERT_IS_TRUE(is_event_loop_open);
+
+    // cleanup
+    socketio_destroy(second);
+}
+
+TEST_FUNCTION(a_socket_destroyed_by_a_callback_is_not_serviced_later_in_the_same_round)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE first = create_accepted_socket_io(true, on_bytes_received_destroy_other);
+    socket_io_to_destroy = create_accepted_socket_io(true, on_bytes_received);
+    test_sockets[0].ready_events = EPOLLIN;
+    test_sockets[1].ready_events = EPOLLIN;
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(socket_io_to_destroy);
+    ASSERT_ARE_EQUAL(size_t, 1, on_bytes_received_count);
+    ASSERT_IS_TRUE(test_sockets[1].is_closed);
+
+    // cleanup
+    socketio_destroy(first);
+}
+
+TEST_FUNCTION(the_event_loop_option_cannot_be_changed_once_open)
+{
+    // arrange
+    bool use_event_loop = true;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+
+    // act
+    int result = socketio_setoption(socket_io, OPTION_SOCKETIO_USE_EVENT_LOOP, &use_event_loop);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, epoll_create_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_all_cannot_be_called_from_a_callback)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(true, on_bytes_received_call_dowork_all);
+    const unsigned char data[] = { 'a' };
+    test_sockets[0].ready_events = EPOLLIN;
+    recv_data = data;
+    recv_data_size = sizeof(data);
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, nested_dowork_all_result);
+    ASSERT_ARE_EQUAL(size_t, 1, epoll_wait_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+/* socketio_send_vectored */
+
+TEST_FUNCTION(socketio_send_vectored_sends_all_segments_in_one_call)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e' };
+    CONSTBUFFER buffers[2];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], first, sizeof(first));
+    set_constbuffer(&buffers[1], second, sizeof(second));
+
+    // act
+    int result = socketio_send_vectored(socket_io, buffers, 2, on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_count);
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, last_send_result);
+    ASSERT_ARE_EQUAL(char_ptr, "abcde", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_send_vectored_queues_the_segments_left_after_a_partial_send)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e', 'f', 'g' };
+    const unsigned char third[] = { 'h', 'i' };
+    CONSTBUFFER buffers[3];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], first, sizeof(first));
+    set_constbuffer(&buffers[1], second, sizeof(second));
+    set_constbuffer(&buffers[2], third, sizeof(third));
+    /* the first segment and part of the second one are sent */
+    send_capacity = 5;
+
+    // act
+    int result = socketio_send_vectored(socket_io, buffers, 3, on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, "abcde", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_resumes_a_partial_send_where_it_stopped)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e', 'f', 'g' };
+    const unsigned char third[] = { 'h', 'i' };
+    CONSTBUFFER buffers[3];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], first, sizeof(first));
+    set_constbuffer(&buffers[1], second, sizeof(second));
+    set_constbuffer(&buffers[2], third, sizeof(third));
+    send_capacity = 5;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, 3, on_send_complete, NULL));
+    send_capacity = SIZE_MAX;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, sendmsg_count);
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, last_send_result);
+    ASSERT_ARE_EQUAL(char_ptr, "abcdefghi", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_partial_send_completes_after_as_many_doworks_as_needed)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e', 'f', 'g' };
+    CONSTBUFFER buffers[2];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], first, sizeof(first));
+    set_constbuffer(&buffers[1], second, sizeof(second));
+    send_capacity = 2;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, 2, on_send_complete, NULL));
+
+    // act
+    send_capacity = 2;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, "abcd", get_sent_bytes());
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, "abcd", get_sent_bytes());
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
+    send_capacity = 3;
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, last_send_result);
+    ASSERT_ARE_EQUAL(char_ptr, "abcdefg", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_partial_send_of_more_segments_than_fit_on_the_stack_is_resumed)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l' };
+    CONSTBUFFER buffers[sizeof(data)];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    size_t i;
+    for (i = 0; i < sizeof(data); i++)
+    {
+        set_constbuffer(&buffers[i], &data[i], 1);
+    }
+    send_capacity = 7;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, sizeof(data), on_send_complete, NULL));
+    send_capacity = SIZE_MAX;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, "abcdefghijkl", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_send_copies_the_bytes_left_after_a_partial_send)
+{
+    // arrange
+    unsigned char data[] = { 'a', 'b', 'c', 'd' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    send_capacity = 1;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, data, sizeof(data), on_send_complete, NULL));
+    /* the caller may reuse its buffer as soon as socketio_send returns */
+    (void)memset(data, 'z', sizeof(data));
+    send_capacity = SIZE_MAX;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, "abcd", get_sent_bytes());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_send_after_a_partial_send_is_queued_behind_it)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e' };
+    CONSTBUFFER buffers[1];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], first, sizeof(first));
+    send_capacity = 1;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, 1, on_send_complete, NULL));
+    send_capacity = SIZE_MAX;
+
+    // act
+    int result = socketio_send(socket_io, second, sizeof(second), on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_count);
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
 
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netdb.h>
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, "abcde", get_sent_bytes());
 
-TEST_MUTEX_HANDLE test_serialize_mutex;
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-BEGIN_TEST_SUITE(socketio_berkeley_unittests)
+TEST_FUNCTION(a_send_failure_while_resuming_a_partial_send_is_reported)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c' };
+    CONSTBUFFER buffers[1];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], data, sizeof(data));
+    send_capacity = 1;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, 1, on_send_complete, NULL));
+    send_errno = ECONNRESET;
 
-#if 0
+    // act
+    socketio_dowork(socket_io);
 
-// SOCKETIO_SETOPTION TESTS WERE WORKING BEFORE SWITCH TO umock_c...need to finish the conversion
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_ERROR, last_send_result);
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
 
-// socketio_setoption tests
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-static CONCRETE_IO_HANDLE setup_socket()
+TEST_FUNCTION(socketio_destroy_cancels_a_partial_vectored_send)
 {
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-    int result = socketio_open(ioHandle, test_on_io_open_complete, &callbackContext,
-        test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
-    ASSERT_ARE_EQUAL(int, 0, result);
-    return ioHandle;
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c' };
+    CONSTBUFFER buffers[1];
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    set_constbuffer(&buffers[0], data, sizeof(data));
+    send_capacity = 1;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_vectored(socket_io, buffers, 1, on_send_complete, NULL));
+
+    // act
+    socketio_destroy(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_CANCELLED, last_send_result);
 }
 
-static void verify_mocks_and_destroy_socket(CONCRETE_IO_HANDLE ioHandle)
+/* socketio_setoption */
+
+static void assert_socket_option_is_given_to_setsockopt(const char* option_name, int level, int name)
 {
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    socketio_destroy(ioHandle);
+    int value = 7;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+
+    int result = socketio_setoption(socket_io, option_name, &value);
+
+    ASSERT_ARE_EQUAL(int, 0, result, option_name);
+    ASSERT_ARE_EQUAL(size_t, 1, set_socket_option_count, option_name);
+    ASSERT_ARE_EQUAL(int, 7, get_set_socket_option(TEST_FIRST_SOCKET, level, name), option_name);
+
+    socketio_destroy(socket_io);
 }
 
 TEST_FUNCTION(socketio_setoption_fails_when_handle_is_null)
@@ -59,608 +1347,981 @@ TEST_FUNCTION(socketio_setoption_fails_when_handle_is_null)
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
 TEST_FUNCTION(socketio_setoption_fails_when_option_name_is_null)
 {
     // arrange
     int irrelevant = 1;
-
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
 
     // act
-    int result = socketio_setoption(ioHandle, NULL, &irrelevant);
+    int result = socketio_setoption(socket_io, NULL, &irrelevant);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
 TEST_FUNCTION(socketio_setoption_fails_when_value_is_null)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive", NULL);
+    int result = socketio_setoption(socket_io, "tcp_keepalive", NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
 TEST_FUNCTION(socketio_setoption_fails_when_it_receives_an_unsupported_option)
 {
     // arrange
     int irrelevant = 1;
-
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
 
     // act
-    int result = socketio_setoption(ioHandle, "unsupported_option_name", &irrelevant);
+    int result = socketio_setoption(socket_io, "unsupported_option_name", &irrelevant);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_so_rcvbuf_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt(OPTION_SOCKETIO_SO_RCVBUF, SOL_SOCKET, SO_RCVBUF);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_so_sndbuf_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt(OPTION_SOCKETIO_SO_SNDBUF, SOL_SOCKET, SO_SNDBUF);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_tcp_nodelay_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt(OPTION_SOCKETIO_TCP_NODELAY, IPPROTO_TCP, TCP_NODELAY);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_tcp_quickack_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt(OPTION_SOCKETIO_TCP_QUICKACK, IPPROTO_TCP, TCP_QUICKACK);
 }
 
 TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt("tcp_keepalive", SOL_SOCKET, SO_KEEPALIVE);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_time_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt("tcp_keepalive_time", IPPROTO_TCP, TCP_KEEPIDLE);
+}
+
+TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_interval_to_setsockopt)
+{
+    assert_socket_option_is_given_to_setsockopt("tcp_keepalive_interval", IPPROTO_TCP, TCP_KEEPINTVL);
+}
+
+TEST_FUNCTION(socketio_setoption_rejects_a_negative_socket_option_value)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    const char* option_names[] = { OPTION_SOCKETIO_SO_RCVBUF, OPTION_SOCKETIO_SO_SNDBUF, OPTION_SOCKETIO_TCP_NODELAY, OPTION_SOCKETIO_TCP_QUICKACK,
+        "tcp_keepalive", "tcp_keepalive_time", "tcp_keepalive_interval" };
+    int value = -1;
+    size_t i;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
 
-    umock_c_reset_all_calls();
+    for (i = 0; i < sizeof(option_names) / sizeof(option_names[0]); i++)
+    {
+        // act
+        int result = socketio_setoption(socket_io, option_names[i], &value);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result, option_names[i]);
+    }
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
 
-    int onoff = -42;
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_SOCKET, SO_KEEPALIVE,
-        &onoff, sizeof(int)));
+TEST_FUNCTION(socketio_setoption_fails_when_setsockopt_fails)
+{
+    // arrange
+    int value = 1;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    setsockopt_result = -1;
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive", &onoff);
+    int result = socketio_setoption(socket_io, OPTION_SOCKETIO_TCP_NODELAY, &value);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, set_socket_option_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_time_to_setsockopt)
+TEST_FUNCTION(an_option_rejected_by_setsockopt_is_not_given_to_the_sockets_created_later)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    int value = 1;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 2);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    setsockopt_result = -1;
+    ASSERT_ARE_NOT_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_TCP_NODELAY, &value));
+    setsockopt_result = 0;
+    test_current_ms = 250;
 
-    umock_c_reset_all_calls();
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    ASSERT_ARE_EQUAL(int, -1, get_set_socket_option(TEST_FIRST_SOCKET + 1, IPPROTO_TCP, TCP_NODELAY));
 
-    int time = 3;
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_TCP, TCP_KEEPIDLE,
-        &time, sizeof(int)));
+TEST_FUNCTION(socket_options_set_before_opening_are_set_before_connecting)
+{
+    // arrange
+    int rcvbuf = 65536;
+    int nodelay = 1;
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE socket_io;
+    config.hostname = TEST_HOSTNAME;
+    config.port = TEST_PORT;
+    config.accepted_socket = NULL;
+    socket_io = socketio_create(&config);
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_SO_RCVBUF, &rcvbuf));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_TCP_NODELAY, &nodelay));
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive_time", &time);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(int, 65536, get_set_socket_option(TEST_FIRST_SOCKET, SOL_SOCKET, SO_RCVBUF));
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET, IPPROTO_TCP, TCP_NODELAY));
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_interval_to_setsockopt)
+TEST_FUNCTION(tcp_options_are_not_given_to_a_unix_domain_socket)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    int value = 1;
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE socket_io;
+    config.hostname = "/tmp/test.sock";
+    config.port = 0;
+    config.accepted_socket = NULL;
+    socket_io = socketio_create(&config);
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADDRESS_TYPE, OPTION_ADDRESS_TYPE_DOMAIN_SOCKET));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_SO_SNDBUF, &value));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_keepalive", &value));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_TCP_NODELAY, &value));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_keepalive_time", &value));
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    connect_errno = 0;
 
-    umock_c_reset_all_calls();
+    // act
+    socketio_dowork(socket_io);
 
-    int interval = 15;
+    // assert
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(int, AF_UNIX, test_sockets[0].family);
+    ASSERT_ARE_EQUAL(size_t, 2, set_socket_option_count);
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET, SOL_SOCKET, SO_SNDBUF));
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET, SOL_SOCKET, SO_KEEPALIVE));
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_TCP, TCP_KEEPINTVL,
-        &interval, sizeof(int)));
+TEST_FUNCTION(tcp_quickack_is_set_again_after_each_read)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    int quickack = 1;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_TCP_QUICKACK, &quickack));
+    recv_data = data;
+    recv_data_size = sizeof(data);
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive_interval", &interval);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
-}
+    ASSERT_ARE_EQUAL(size_t, 2, set_socket_option_count);
+    ASSERT_ARE_EQUAL(int, TCP_QUICKACK, set_socket_options[1].name);
 
-#endif
+    /* nothing was read, the kernel has no reason to leave quick ack mode */
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, set_socket_option_count);
 
-/* Seems like the below tests require a full blown rewrite */
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-#if 0
+/* adaptive receive buffer */
 
-TEST_SUITE_INITIALIZE(suite_init)
+TEST_FUNCTION(the_receive_buffer_starts_at_receive_bytes_value)
 {
-    test_serialize_mutex = MicroMockCreateMutex();
-    ASSERT_IS_NOT_NULL(test_serialize_mutex);
-}
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    recv_data = data;
+    recv_data_size = sizeof(data);
 
-TEST_SUITE_CLEANUP(suite_cleanup)
-{
-    MicroMockDestroyMutex(test_serialize_mutex);
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, last_recv_size);
+    ASSERT_ARE_EQUAL(size_t, 1, received_byte_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION_INITIALIZE(method_init)
+TEST_FUNCTION(the_receive_buffer_doubles_after_consecutive_full_reads)
 {
-    if (!MicroMockAcquireMutex(test_serialize_mutex))
-    {
-        ASSERT_FAIL("Could not acquire test serialization mutex.");
-    }
-    list_head_count = 0;
-    list_add_called = false;
-    g_addrinfo_call_fail = false;
-    //g_socket_send_size_value = -1;
-    g_socket_recv_size_value = -1;
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    recv_full_count = 3;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, last_recv_size);
+    recv_full_count = 1;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    /* the fourth full read in a row grows the buffer for the next one */
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION_CLEANUP(method_cleanup)
+TEST_FUNCTION(a_read_that_does_not_fill_the_receive_buffer_restarts_the_count)
 {
-    if (!MicroMockReleaseMutex(test_serialize_mutex))
-    {
-        ASSERT_FAIL("Could not release test serialization mutex.");
-    }
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    recv_full_count = 3;
+    recv_data = data;
+    recv_data_size = sizeof(data);
+    socketio_dowork(socket_io);
+    recv_full_count = 3;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void OnBytesReceived(void* context, const unsigned char* buffer, size_t size)
+TEST_FUNCTION(the_receive_buffer_grows_up_to_its_default_limit)
 {
-    (void)context;
-    (void)buffer;
-    (void)size;
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    /* 64 bytes doubled 8 times is 16 KB, 4 full reads each time, then more full reads */
+    recv_full_count = 40;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, recv_full_count);
+    ASSERT_ARE_EQUAL(size_t, 16 * 1024, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void PrintLogFunction(unsigned int options, char* format, ...)
+TEST_FUNCTION(the_receive_buffer_grows_up_to_the_receive_buffer_size_option)
 {
-    (void)options;
-    (void)format;
+    // arrange
+    size_t max_size = 200;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE, &max_size));
+    /* 64, 128, then the limit rather than 256 */
+    recv_full_count = 12;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 200, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void OnSendComplete(void* context, IO_SEND_RESULT send_result)
+TEST_FUNCTION(a_smaller_receive_buffer_size_option_shrinks_the_receive_buffer)
 {
-    (void)context;
-    (void)send_result;
+    // arrange
+    size_t max_size = 100;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    recv_full_count = 4;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, last_recv_size);
+
+    // act
+    int result = socketio_setoption(socket_io, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE, &max_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    recv_full_count = 8;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 100, last_recv_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-/* socketio_win32_create */
-TEST_FUNCTION(socketio_create_io_create_parameters_NULL_fails)
+TEST_FUNCTION(a_receive_buffer_size_option_of_zero_is_rejected)
 {
     // arrange
-    socketio_mocks mocks;
+    size_t max_size = 0;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
 
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(NULL, PrintLogFunction);
+    int result = socketio_setoption(socket_io, OPTION_SOCKETIO_RECEIVE_BUFFER_SIZE, &max_size);
 
     // assert
-    ASSERT_IS_NULL(ioHandle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_create_list_create_fails)
+TEST_FUNCTION(the_receive_buffer_keeps_its_size_when_it_cannot_grow)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_accepted_socket_io(false, on_bytes_received);
+    recv_full_count = 4;
+    gballoc_realloc_fails = true;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, last_recv_size);
+    ASSERT_ARE_EQUAL(size_t, 4 * RECEIVE_BYTES_VALUE, received_byte_count);
 
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_create()).SetReturn((SINGLYLINKEDLIST_HANDLE)NULL);
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+/* socketio_create, socketio_open, socketio_close */
 
+TEST_FUNCTION(socketio_create_with_a_null_config_fails)
+{
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = socketio_create(NULL);
 
     // assert
-    ASSERT_IS_NULL(ioHandle);
+    ASSERT_IS_NULL(socket_io);
 }
 
-TEST_FUNCTION(socketio_create_succeeds)
+TEST_FUNCTION(socketio_destroy_with_a_null_handle_does_nothing)
 {
-    // arrange
-    socketio_mocks mocks;
+    // act
+    socketio_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, test_socket_count);
+}
 
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_create());
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_open_with_a_null_handle_fails)
+{
+    // act
+    int result = socketio_open(NULL, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+}
+
+TEST_FUNCTION(socketio_close_with_a_null_handle_fails)
+{
+    // act
+    int result = socketio_close(NULL, NULL, NULL);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
 
+TEST_FUNCTION(socketio_open_starts_the_lookup_and_returns_before_connecting)
+{
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
 
     // assert
-    ASSERT_IS_NOT_NULL(ioHandle);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, test_socket_count);
+    ASSERT_ARE_EQUAL(int, -1, socketio_berkeley_get_socket(socket_io));
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-// socketio_win32_destroy
-TEST_FUNCTION(socketio_destroy_socket_io_NULL_succeeds)
+TEST_FUNCTION(socketio_open_reports_an_error_when_the_lookup_cannot_start)
 {
     // arrange
-    socketio_mocks mocks;
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE socket_io;
+    dns_async_create_fails = true;
+    config.hostname = TEST_HOSTNAME;
+    config.port = TEST_PORT;
+    config.accepted_socket = NULL;
+    socket_io = socketio_create(&config);
 
     // act
-    socketio_destroy(NULL);
+    int result = socketio_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_destroy_socket_succeeds)
+TEST_FUNCTION(socketio_dowork_waits_for_the_lookup)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    test_current_ms = 1000;
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // act
+    socketio_dowork(socket_io);
 
-    mocks.ResetAllCalls();
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, test_socket_count);
+    ASSERT_ARE_EQUAL(size_t, 0, dns_async_destroy_count);
 
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-    EXPECTED_CALL(mocks, singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_destroy(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    list_head_count = 1;
+TEST_FUNCTION(socketio_dowork_connects_to_the_resolved_address)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
 
     // act
-    socketio_destroy(ioHandle);
+    socketio_dowork(socket_io);
 
     // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, dns_async_destroy_count);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    ASSERT_ARE_EQUAL(int, AF_INET, test_sockets[0].family);
+    ASSERT_IS_FALSE(test_sockets[0].is_closed);
+    ASSERT_ARE_EQUAL(int, TEST_FIRST_SOCKET, socketio_berkeley_get_socket(socket_io));
+
+    // cleanup
+    socketio_destroy(socket_io);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
 }
 
-TEST_FUNCTION(socketio_open_socket_io_NULL_fails)
+TEST_FUNCTION(a_connection_in_progress_completes_once_the_socket_is_writable)
 {
     // arrange
-    socketio_mocks mocks;
-
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-
-    mocks.ResetAllCalls();
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 1);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    test_sockets[0].is_connect_complete = true;
 
     // act
-    int result = socketio_open(NULL, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(int, AF_INET6, test_sockets[0].family);
+    ASSERT_IS_FALSE(test_sockets[0].is_closed);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_socket_fails)
+TEST_FUNCTION(socketio_open_reports_an_error_when_the_lookup_finds_no_address)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    dns_lookup_complete = true;
+
+    // act
+    socketio_dowork(socket_io);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, dns_async_destroy_count);
+    ASSERT_ARE_EQUAL(size_t, 0, test_socket_count);
 
-    mocks.ResetAllCalls();
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
-        .SetReturn(-1);
+TEST_FUNCTION(the_lookup_times_out_after_the_connect_timeout)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    test_current_ms = 9999;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+    test_current_ms = 10000;
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, dns_async_destroy_count);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-
-TEST_FUNCTION(socketio_open_getaddrinfo_fails)
+TEST_FUNCTION(the_connection_times_out_after_the_connect_timeout)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    test_current_ms = 9999;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+    test_current_ms = 10000;
+
+    // act
+    socketio_dowork(socket_io);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
 
-    mocks.ResetAllCalls();
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    g_addrinfo_call_fail = true;
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_send_while_opening_fails)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    int result = socketio_send(socket_io, data, sizeof(data), on_send_complete, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 0, sendmsg_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+/* address racing */
+
+TEST_FUNCTION(the_next_address_is_raced_after_the_connection_attempt_delay)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 2);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 3);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    test_current_ms = 249;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    test_current_ms = 250;
+
+    // act
+    socketio_dowork(socket_io);
 
-    socketio_destroy(ioHandle);
+    // assert
+    /* the families alternate, the first attempt is left running */
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    ASSERT_ARE_EQUAL(int, AF_INET6, test_sockets[0].family);
+    ASSERT_ARE_EQUAL(int, AF_INET, test_sockets[1].family);
+    ASSERT_IS_FALSE(test_sockets[0].is_closed);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_TRUE(test_sockets[1].is_closed);
 }
 
-TEST_FUNCTION(socketio_open_connect_fails)
+TEST_FUNCTION(the_first_attempt_to_connect_wins_and_the_others_are_closed)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 2);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    test_current_ms = 250;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    test_sockets[1].is_connect_complete = true;
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // act
+    socketio_dowork(socket_io);
 
-    mocks.ResetAllCalls();
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_FALSE(test_sockets[1].is_closed);
+    ASSERT_ARE_EQUAL(int, TEST_FIRST_SOCKET + 1, socketio_berkeley_get_socket(socket_io));
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(-1);
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
+TEST_FUNCTION(a_refused_attempt_starts_the_next_address_without_waiting)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 2);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    test_sockets[0].is_connect_complete = true;
+    test_sockets[0].connect_error = ECONNREFUSED;
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_FALSE(test_sockets[1].is_closed);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_ioctlsocket_fails)
+TEST_FUNCTION(socketio_open_reports_an_error_when_every_address_refuses_the_connection)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 2);
+    dns_lookup_complete = true;
+    connect_errno = ECONNREFUSED;
+
+    // act
+    socketio_dowork(socket_io);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_TRUE(test_sockets[1].is_closed);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    mocks.ResetAllCalls();
+/* cancel on close */
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    //EXPECTED_CALL(mocks, fcntl(IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-    //    .SetReturn(-1);
-    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_close_while_looking_up_cancels_the_open)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    int result = socketio_close(socket_io, NULL, NULL);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_CANCELLED, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, dns_async_destroy_count);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-//TEST_FUNCTION(socketio_open_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
-//
-//    // act
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-TEST_FUNCTION(socketio_close_socket_io_NULL_fails)
+TEST_FUNCTION(socketio_close_while_connecting_cancels_the_open_and_closes_every_attempt)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV6, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 2);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    test_current_ms = 250;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
 
     // act
-    int result = socketio_close(NULL);
+    int result = socketio_close(socket_io, NULL, NULL);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_CANCELLED, last_open_result);
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_IS_TRUE(test_sockets[1].is_closed);
+
+    /* nothing is left to complete the cancelled open */
+    test_sockets[0].is_connect_complete = true;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_close_Succeeds)
+TEST_FUNCTION(socketio_destroy_while_connecting_closes_every_attempt)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+
+    // act
+    socketio_destroy(socket_io);
 
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    // assert
+    ASSERT_IS_TRUE(test_sockets[0].is_closed);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+}
 
-    mocks.ResetAllCalls();
+/* socketio_dowork_all opening */
 
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_dowork_all_completes_the_open_of_an_event_loop_instance)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(true, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
 
     // act
-    result = socketio_close(ioHandle);
+    int result = socketio_dowork_all(1000);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_IS_TRUE(test_sockets[0].is_in_event_loop);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_send_socket_io_fails)
+TEST_FUNCTION(socketio_dowork_all_shortens_its_wait_while_an_instance_is_opening)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE open_socket_io = create_accepted_socket_io(true, on_bytes_received);
+    CONCRETE_IO_HANDLE opening_socket_io = create_opening_socket_io(true, on_io_open_complete);
+    open_complete_count = 0;
 
     // act
-    int result = socketio_send(NULL, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    int result = socketio_dowork_all(1000);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 10, last_epoll_wait_timeout);
+    ASSERT_ARE_EQUAL(size_t, 0, open_complete_count);
+
+    /* the whole timeout is waited for again once the open completes */
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_dowork_all(1000));
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_dowork_all(1000));
+    ASSERT_ARE_EQUAL(int, 1000, last_epoll_wait_timeout);
+
+    // cleanup
+    socketio_destroy(opening_socket_io);
+    socketio_destroy(open_socket_io);
 }
 
-TEST_FUNCTION(socketio_send_buffer_NULL_fails)
+TEST_FUNCTION(socketio_dowork_all_stops_opening_an_instance_closed_while_opening)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(true, on_io_open_complete);
+    ASSERT_ARE_EQUAL(int, 0, socketio_close(socket_io, NULL, NULL));
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+
+    // act
+    int result = socketio_dowork_all(1000);
 
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_CANCELLED, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, test_socket_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    mocks.ResetAllCalls();
+TEST_FUNCTION(an_instance_destroyed_by_an_open_callback_is_not_opened_later_in_the_same_round)
+{
+    // arrange
+    CONCRETE_IO_HANDLE second;
+    socket_io_to_destroy = create_opening_socket_io(true, on_io_open_complete);
+    /* the last instance opened is advanced first */
+    second = create_opening_socket_io(true, on_io_open_complete_destroy_other);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
 
     // act
-    result = socketio_send(ioHandle, NULL, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    int result = socketio_dowork_all(0);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(socket_io_to_destroy);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+    ASSERT_IS_TRUE(test_sockets[0].is_in_event_loop);
+
+    // cleanup
+    socketio_destroy(second);
 }
 
-TEST_FUNCTION(socketio_send_size_zero_fails)
+TEST_FUNCTION(socketio_dowork_all_cannot_be_called_from_an_open_callback)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(true, on_io_open_complete_call_dowork_all);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    dns_lookup_complete = true;
+    connect_errno = 0;
+
+    // act
+    int result = socketio_dowork_all(0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_NOT_EQUAL(int, 0, nested_dowork_all_result);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+/* keepalive options while opening */
 
-    mocks.ResetAllCalls();
+TEST_FUNCTION(keepalive_options_set_while_looking_up_are_given_to_the_connection_attempts)
+{
+    // arrange
+    int keepalive = 1;
+    int keepalive_time = 30;
+    int keepalive_interval = 5;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
 
     // act
-    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, 0, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_keepalive", &keepalive));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_keepalive_time", &keepalive_time));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_keepalive_interval", &keepalive_interval));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    /* there is no socket yet */
+    ASSERT_ARE_EQUAL(size_t, 0, set_socket_option_count);
+
+    dns_lookup_complete = true;
+    connect_errno = 0;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET, SOL_SOCKET, SO_KEEPALIVE));
+    ASSERT_ARE_EQUAL(int, 30, get_set_socket_option(TEST_FIRST_SOCKET, IPPROTO_TCP, TCP_KEEPIDLE));
+    ASSERT_ARE_EQUAL(int, 5, get_set_socket_option(TEST_FIRST_SOCKET, IPPROTO_TCP, TCP_KEEPINTVL));
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_send_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_send_returns_1_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(1);
-//    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-//
-//    // act
-//    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-TEST_FUNCTION(socketio_dowork_socket_io_NULL_fails)
-{
-    // arrange
-    socketio_mocks mocks;
-
-    // act
-    socketio_dowork(NULL);
-
-    // assert
-}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_dowork_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    socketio_dowork(ioHandle);
-//
-//    // assert
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_dowork_recv_bytes_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
-//        .CopyOutArgumentBuffer(2, "t", 1)
-//        .SetReturn(1);
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    socketio_dowork(ioHandle);
-//
-//    // assert
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
+TEST_FUNCTION(keepalive_set_while_connecting_is_given_to_the_attempts_started_and_to_come)
+{
+    // arrange
+    int keepalive = 1;
+    CONCRETE_IO_HANDLE socket_io = create_opening_socket_io(false, on_io_open_complete);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 1);
+    add_test_address(DNS_ASYNC_ADDRESS_TYPE_IPV4, 2);
+    dns_lookup_complete = true;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, test_socket_count);
+
+    // act
+    int result = socketio_setoption(socket_io, "tcp_keepalive", &keepalive);
 
-#endif
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET, SOL_SOCKET, SO_KEEPALIVE));
+
+    test_current_ms = 250;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, test_socket_count);
+    ASSERT_ARE_EQUAL(int, 1, get_set_socket_option(TEST_FIRST_SOCKET + 1, SOL_SOCKET, SO_KEEPALIVE));
+    test_sockets[1].is_connect_complete = true;
+    socketio_dowork(socket_io);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
 END_TEST_SUITE(socketio_berkeley_unittests)
-
@@ -0,0 +1,1416 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// MAP_ANONYMOUS and the syscall numbers are outside C99 and POSIX, as in socketio_uring.c
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdarg>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "socketio_berkeley.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mmap, void*, addr, size_t, length, int, prot, int, flags, int, fd, off_t, offset);
+    MOCKABLE_FUNCTION(, int, munmap, void*, addr, size_t, length);
+    MOCKABLE_FUNCTION(, int, shutdown, int, sockfd, int, how);
+    MOCKABLE_FUNCTION(, int, close, int, fd);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/socketio_uring.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    extern SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    extern void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    extern int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    extern LIST_ITEM_HANDLE real_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle);
+    extern const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+#define TEST_SOCKET             100
+#define TEST_RING_FD            600
+#define TEST_SQ_ENTRIES         4
+#define TEST_CQ_ENTRIES         64
+#define TEST_MAX_REQUESTS       16
+
+static CONCRETE_IO_HANDLE TEST_SOCKET_IO = (CONCRETE_IO_HANDLE)0x4242;
+static OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4243;
+static int TEST_CREATE_PARAMETERS = 1;
+
+/* the queues the fake kernel shares through the IORING_OFF_SQ_RING mapping, the offsets given by io_uring_setup point in here */
+typedef struct TEST_RINGS_TAG
+{
+    unsigned int sq_head;
+    unsigned int sq_tail;
+    unsigned int sq_ring_mask;
+    unsigned int sq_ring_entries;
+    unsigned int sq_flags;
+    unsigned int sq_dropped;
+    unsigned int sq_array[TEST_SQ_ENTRIES];
+    unsigned int cq_head;
+    unsigned int cq_tail;
+    unsigned int cq_ring_mask;
+    unsigned int cq_ring_entries;
+    unsigned int cq_overflow;
+    struct io_uring_cqe cqes[TEST_CQ_ENTRIES];
+} TEST_RINGS;
+
+/* a submission entry as the fake kernel found it */
+typedef struct TEST_REQUEST_TAG
+{
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t ioprio;
+    int32_t fd;
+    uint64_t user_data;
+    uint16_t buf_group;
+    uint32_t msg_flags;
+    uint32_t cancel_flags;
+    size_t iov_count;
+} TEST_REQUEST;
+
+static TEST_RINGS test_rings;
+static struct io_uring_sqe test_sqes[TEST_SQ_ENTRIES];
+static bool is_ring_open;
+static size_t ring_setup_count;
+static size_t ring_close_count;
+static size_t munmap_count;
+static void* buffer_memory;
+static struct io_uring_buf_ring* buffer_ring;
+static unsigned int buffer_ring_entries;
+static uint16_t buffer_ring_head;
+
+static bool ring_setup_fails;
+static uint32_t ring_features;
+static bool buffer_registration_fails;
+static bool probe_lacks_recv;
+static bool multishot_receive_is_rejected;
+static int cancel_result;
+
+static TEST_REQUEST test_requests[TEST_MAX_REQUESTS];
+static size_t test_request_count;
+static size_t enter_count;
+static unsigned int last_min_complete;
+static bool is_receive_pending;
+static bool is_receive_multishot;
+/* bytes accepted by each sendmsg, the rest is left for the next one */
+static size_t send_capacity;
+static int send_error;
+static unsigned char sent_bytes[256];
+static size_t sent_byte_count;
+static size_t shutdown_count;
+
+static ON_IO_OPEN_COMPLETE underlying_on_open_complete;
+static void* underlying_on_open_complete_context;
+static ON_IO_ERROR underlying_on_io_error;
+static void* underlying_on_io_error_context;
+static size_t socketio_close_count;
+static size_t socketio_destroy_count;
+
+static size_t open_complete_count;
+static IO_OPEN_RESULT last_open_result;
+static unsigned char received_bytes[256];
+static size_t received_byte_count;
+static size_t on_bytes_received_count;
+static size_t io_error_count;
+static size_t send_complete_count;
+static IO_SEND_RESULT send_results[8];
+static CONCRETE_IO_HANDLE socket_io_to_close;
+
+static void post_completion(uint64_t user_data, int32_t res, uint32_t flags)
+{
+    struct io_uring_cqe* cqe = &test_rings.cqes[test_rings.cq_tail & (TEST_CQ_ENTRIES - 1)];
+
+    ASSERT_IS_TRUE(test_rings.cq_tail - test_rings.cq_head < TEST_CQ_ENTRIES);
+    cqe->user_data = user_data;
+    cqe->res = res;
+    cqe->flags = flags;
+    test_rings.cq_tail++;
+}
+
+static void complete_pending_receive(int32_t res)
+{
+    ASSERT_IS_TRUE(is_receive_pending);
+    is_receive_pending = false;
+    post_completion(2, res, 0);
+}
+
+/* the peer sent data, it goes into the next buffer of the registered buffer ring */
+static void receive_from_peer(const unsigned char* data, size_t size)
+{
+    ASSERT_IS_TRUE(is_receive_pending);
+    if (buffer_ring_head == buffer_ring->tail)
+    {
+        complete_pending_receive(-ENOBUFS);
+    }
+    else
+    {
+        struct io_uring_buf* buffer = &buffer_ring->bufs[buffer_ring_head & (buffer_ring_entries - 1)];
+
+        ASSERT_IS_TRUE(size <= buffer->len);
+        memcpy((void*)(uintptr_t)buffer->addr, data, size);
+        buffer_ring_head++;
+        if (is_receive_multishot)
+        {
+            post_completion(2, (int32_t)size, ((uint32_t)buffer->bid << IORING_CQE_BUFFER_SHIFT) | IORING_CQE_F_BUFFER | IORING_CQE_F_MORE);
+        }
+        else
+        {
+            is_receive_pending = false;
+            post_completion(2, (int32_t)size, ((uint32_t)buffer->bid << IORING_CQE_BUFFER_SHIFT) | IORING_CQE_F_BUFFER);
+        }
+    }
+}
+
+static void consume_submission(const struct io_uring_sqe* sqe)
+{
+    TEST_REQUEST* request;
+
+    ASSERT_IS_TRUE(test_request_count < TEST_MAX_REQUESTS);
+    request = &test_requests[test_request_count++];
+    memset(request, 0, sizeof(TEST_REQUEST));
+    request->opcode = sqe->opcode;
+    request->flags = sqe->flags;
+    request->ioprio = sqe->ioprio;
+    request->fd = sqe->fd;
+    request->user_data = sqe->user_data;
+    request->buf_group = sqe->buf_group;
+    request->msg_flags = sqe->msg_flags;
+    request->cancel_flags = sqe->cancel_flags;
+
+    switch (sqe->opcode)
+    {
+    case IORING_OP_SENDMSG:
+    {
+        const struct msghdr* message = (const struct msghdr*)(uintptr_t)sqe->addr;
+        size_t capacity = send_capacity;
+        size_t sent = 0;
+        size_t i;
+
+        request->iov_count = message->msg_iovlen;
+        for (i = 0; i < message->msg_iovlen && sent < capacity; i++)
+        {
+            size_t size = message->msg_iov[i].iov_len;
+            if (size > capacity - sent)
+            {
+                size = capacity - sent;
+            }
+
+            ASSERT_IS_TRUE(sent_byte_count + size <= sizeof(sent_bytes));
+            memcpy(sent_bytes + sent_byte_count, message->msg_iov[i].iov_base, size);
+            sent_byte_count += size;
+            sent += size;
+        }
+
+        post_completion(sqe->user_data, (send_error != 0) ? -send_error : (int32_t)sent, 0);
+        break;
+    }
+    case IORING_OP_RECV:
+        ASSERT_IS_FALSE(is_receive_pending);
+        if (multishot_receive_is_rejected && (sqe->ioprio & IORING_RECV_MULTISHOT) != 0)
+        {
+            post_completion(sqe->user_data, -EINVAL, 0);
+        }
+        else
+        {
+            is_receive_pending = true;
+            is_receive_multishot = ((sqe->ioprio & IORING_RECV_MULTISHOT) != 0);
+        }
+        break;
+    case IORING_OP_ASYNC_CANCEL:
+        if (cancel_result == 0 && is_receive_pending)
+        {
+            complete_pending_receive(-ECANCELED);
+        }
+        post_completion(sqe->user_data, cancel_result, 0);
+        break;
+    default:
+        ASSERT_FAIL("unexpected io_uring operation");
+        break;
+    }
+}
+
+static long fake_io_uring_setup(unsigned int entries, struct io_uring_params* params)
+{
+    long result;
+
+    if (ring_setup_fails)
+    {
+        errno = ENOMEM;
+        result = -1;
+    }
+    else
+    {
+        ASSERT_IS_FALSE(is_ring_open);
+        ASSERT_ARE_EQUAL(uint32_t, TEST_SQ_ENTRIES, entries);
+        ASSERT_ARE_EQUAL(uint32_t, IORING_SETUP_CQSIZE, params->flags);
+        ASSERT_ARE_EQUAL(uint32_t, TEST_CQ_ENTRIES, params->cq_entries);
+
+        memset(&test_rings, 0, sizeof(test_rings));
+        memset(test_sqes, 0, sizeof(test_sqes));
+        test_rings.sq_ring_mask = TEST_SQ_ENTRIES - 1;
+        test_rings.sq_ring_entries = TEST_SQ_ENTRIES;
+        test_rings.cq_ring_mask = TEST_CQ_ENTRIES - 1;
+        test_rings.cq_ring_entries = TEST_CQ_ENTRIES;
+
+        params->sq_entries = TEST_SQ_ENTRIES;
+        params->features = ring_features;
+        params->sq_off.head = offsetof(TEST_RINGS, sq_head);
+        params->sq_off.tail = offsetof(TEST_RINGS, sq_tail);
+        params->sq_off.ring_mask = offsetof(TEST_RINGS, sq_ring_mask);
+        params->sq_off.ring_entries = offsetof(TEST_RINGS, sq_ring_entries);
+        params->sq_off.flags = offsetof(TEST_RINGS, sq_flags);
+        params->sq_off.dropped = offsetof(TEST_RINGS, sq_dropped);
+        params->sq_off.array = offsetof(TEST_RINGS, sq_array);
+        params->cq_off.head = offsetof(TEST_RINGS, cq_head);
+        params->cq_off.tail = offsetof(TEST_RINGS, cq_tail);
+        params->cq_off.ring_mask = offsetof(TEST_RINGS, cq_ring_mask);
+        params->cq_off.ring_entries = offsetof(TEST_RINGS, cq_ring_entries);
+        params->cq_off.overflow = offsetof(TEST_RINGS, cq_overflow);
+        params->cq_off.cqes = offsetof(TEST_RINGS, cqes);
+
+        is_ring_open = true;
+        is_receive_pending = false;
+        buffer_ring = NULL;
+        buffer_ring_head = 0;
+        ring_setup_count++;
+        result = TEST_RING_FD;
+    }
+
+    return result;
+}
+
+static long fake_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    unsigned int submitted = 0;
+
+    ASSERT_ARE_EQUAL(int, TEST_RING_FD, fd);
+    ASSERT_ARE_EQUAL(uint32_t, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0, flags);
+    enter_count++;
+    last_min_complete = min_complete;
+
+    while (submitted < to_submit && test_rings.sq_head != test_rings.sq_tail)
+    {
+        consume_submission(&test_sqes[test_rings.sq_array[test_rings.sq_head & test_rings.sq_ring_mask]]);
+        test_rings.sq_head++;
+        submitted++;
+    }
+
+    /* a wait that nothing would ever complete hangs the real kernel */
+    ASSERT_IS_TRUE(test_rings.cq_tail - test_rings.cq_head >= min_complete);
+
+    return (long)submitted;
+}
+
+static long fake_io_uring_register(int fd, unsigned int opcode, void* arg, unsigned int nr_args)
+{
+    long result;
+
+    ASSERT_ARE_EQUAL(int, TEST_RING_FD, fd);
+
+    if (opcode == IORING_REGISTER_PBUF_RING)
+    {
+        struct io_uring_buf_reg* registration = (struct io_uring_buf_reg*)arg;
+
+        ASSERT_ARE_EQUAL(uint32_t, 1, nr_args);
+        if (buffer_registration_fails)
+        {
+            errno = EINVAL;
+            result = -1;
+        }
+        else
+        {
+            buffer_ring = (struct io_uring_buf_ring*)(uintptr_t)registration->ring_addr;
+            buffer_ring_entries = registration->ring_entries;
+            ASSERT_ARE_EQUAL(uint32_t, 0, registration->bgid);
+            result = 0;
+        }
+    }
+    else if (opcode == IORING_REGISTER_PROBE)
+    {
+        struct io_uring_probe* probe = (struct io_uring_probe*)arg;
+        unsigned int i;
+
+        probe->last_op = IORING_OP_RECV;
+        probe->ops_len = IORING_OP_RECV + 1;
+        for (i = 0; i <= IORING_OP_RECV && i < nr_args; i++)
+        {
+            probe->ops[i].op = (uint8_t)i;
+            probe->ops[i].flags = (probe_lacks_recv && i == IORING_OP_RECV) ? 0 : IO_URING_OP_SUPPORTED;
+        }
+        result = 0;
+    }
+    else
+    {
+        errno = EINVAL;
+        result = -1;
+    }
+
+    return result;
+}
+
+long syscall(long number, ...)
+{
+    long result;
+    va_list args;
+
+    va_start(args, number);
+    if (number == __NR_io_uring_setup)
+    {
+        unsigned int entries = va_arg(args, unsigned int);
+        struct io_uring_params* params = va_arg(args, struct io_uring_params*);
+        result = fake_io_uring_setup(entries, params);
+    }
+    else if (number == __NR_io_uring_enter)
+    {
+        int fd = va_arg(args, int);
+        unsigned int to_submit = va_arg(args, unsigned int);
+        unsigned int min_complete = va_arg(args, unsigned int);
+        unsigned int flags = va_arg(args, unsigned int);
+        result = fake_io_uring_enter(fd, to_submit, min_complete, flags);
+    }
+    else if (number == __NR_io_uring_register)
+    {
+        int fd = va_arg(args, int);
+        unsigned int opcode = va_arg(args, unsigned int);
+        void* arg = va_arg(args, void*);
+        unsigned int nr_args = va_arg(args, unsigned int);
+        result = fake_io_uring_register(fd, opcode, arg, nr_args);
+    }
+    else
+    {
+        errno = ENOSYS;
+        result = -1;
+    }
+    va_end(args);
+
+    return result;
+}
+
+static void* my_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    void* result;
+
+    (void)addr;
+    (void)prot;
+    if (fd == TEST_RING_FD && offset == IORING_OFF_SQ_RING)
+    {
+        ASSERT_IS_TRUE(length <= sizeof(test_rings));
+        result = &test_rings;
+    }
+    else if (fd == TEST_RING_FD && offset == IORING_OFF_SQES)
+    {
+        ASSERT_ARE_EQUAL(size_t, sizeof(test_sqes), length);
+        result = test_sqes;
+    }
+    else
+    {
+        ASSERT_ARE_EQUAL(int, MAP_PRIVATE | MAP_ANONYMOUS, flags);
+        ASSERT_IS_NULL(buffer_memory);
+        result = buffer_memory = my_gballoc_malloc(length);
+        ASSERT_IS_NOT_NULL(result);
+        memset(result, 0, length);
+    }
+
+    return result;
+}
+
+static int my_munmap(void* addr, size_t length)
+{
+    (void)length;
+    if (addr == buffer_memory)
+    {
+        my_gballoc_free(buffer_memory);
+        buffer_memory = NULL;
+    }
+    munmap_count++;
+    return 0;
+}
+
+static int my_close(int fd)
+{
+    ASSERT_ARE_EQUAL(int, TEST_RING_FD, fd);
+    ASSERT_IS_TRUE(is_ring_open);
+    is_ring_open = false;
+    ring_close_count++;
+    return 0;
+}
+
+/* shutting the socket down completes the recv the kernel could not cancel */
+static int my_shutdown(int sockfd, int how)
+{
+    ASSERT_ARE_EQUAL(int, TEST_SOCKET, sockfd);
+    ASSERT_ARE_EQUAL(int, SHUT_RDWR, how);
+    if (is_receive_pending)
+    {
+        complete_pending_receive(0);
+    }
+    shutdown_count++;
+    return 0;
+}
+
+static CONCRETE_IO_HANDLE my_socketio_create(void* io_create_parameters)
+{
+    ASSERT_ARE_EQUAL(void_ptr, &TEST_CREATE_PARAMETERS, io_create_parameters);
+    return TEST_SOCKET_IO;
+}
+
+static void my_socketio_destroy(CONCRETE_IO_HANDLE socket_io)
+{
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_IO, socket_io);
+    socketio_destroy_count++;
+}
+
+static int my_socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)on_bytes_received;
+    (void)on_bytes_received_context;
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_IO, socket_io);
+    underlying_on_open_complete = on_io_open_complete;
+    underlying_on_open_complete_context = on_io_open_complete_context;
+    underlying_on_io_error = on_io_error;
+    underlying_on_io_error_context = on_io_error_context;
+    return 0;
+}
+
+/* socketio_berkeley cancels an open still in progress */
+static int my_socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    ON_IO_OPEN_COMPLETE on_open_complete = underlying_on_open_complete;
+
+    (void)on_io_close_complete;
+    (void)callback_context;
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_IO, socket_io);
+    underlying_on_open_complete = NULL;
+    if (on_open_complete != NULL)
+    {
+        on_open_complete(underlying_on_open_complete_context, IO_OPEN_CANCELLED);
+    }
+    socketio_close_count++;
+    return 0;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    open_complete_count++;
+    last_open_result = open_result;
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    ASSERT_IS_TRUE(received_byte_count + size <= sizeof(received_bytes));
+    memcpy(received_bytes + received_byte_count, buffer, size);
+    received_byte_count += size;
+    on_bytes_received_count++;
+
+    if (socket_io_to_close != NULL)
+    {
+        (void)socketio_uring_close(socket_io_to_close, NULL, NULL);
+        socket_io_to_close = NULL;
+    }
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    io_error_count++;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    ASSERT_IS_TRUE(send_complete_count < sizeof(send_results) / sizeof(send_results[0]));
+    send_results[send_complete_count++] = send_result;
+}
+
+/* opens an instance and has socketio_berkeley report the connection, which sets up the ring */
+static CONCRETE_IO_HANDLE create_open_socket_io(void)
+{
+    CONCRETE_IO_HANDLE result = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_open(result, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    ASSERT_IS_NOT_NULL(underlying_on_open_complete);
+
+    underlying_on_open_complete(underlying_on_open_complete_context, IO_OPEN_OK);
+    underlying_on_open_complete = NULL;
+
+    return result;
+}
+
+/* the number of requests of an operation the fake kernel was given */
+static size_t get_request_count(uint8_t opcode)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < test_request_count; i++)
+    {
+        if (test_requests[i].opcode == opcode)
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static const TEST_REQUEST* get_last_request(uint8_t opcode)
+{
+    const TEST_REQUEST* result = NULL;
+    size_t i;
+
+    for (i = 0; i < test_request_count; i++)
+    {
+        if (test_requests[i].opcode == opcode)
+        {
+            result = &test_requests[i];
+        }
+    }
+
+    ASSERT_IS_NOT_NULL(result);
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+BEGIN_TEST_SUITE(socketio_uring_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+    size_t type_size;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // Unnatural type_size variable exists to avoid "conditional expression is constant" warning
+    type_size = sizeof(off_t);
+    if (type_size == sizeof(int32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(off_t, int32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(off_t, int64_t);
+    }
+
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, real_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+
+    REGISTER_GLOBAL_MOCK_HOOK(socketio_create, my_socketio_create);
+    REGISTER_GLOBAL_MOCK_HOOK(socketio_destroy, my_socketio_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(socketio_open, my_socketio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(socketio_close, my_socketio_close);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_send, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_send_vectored, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_setoption, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_berkeley_get_socket, TEST_SOCKET);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_berkeley_retrieve_options, TEST_OPTIONHANDLER_HANDLE);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mmap, my_mmap);
+    REGISTER_GLOBAL_MOCK_HOOK(munmap, my_munmap);
+    REGISTER_GLOBAL_MOCK_HOOK(shutdown, my_shutdown);
+    REGISTER_GLOBAL_MOCK_HOOK(close, my_close);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    ring_setup_count = 0;
+    ring_close_count = 0;
+    munmap_count = 0;
+    ring_setup_fails = false;
+    ring_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP;
+    buffer_registration_fails = false;
+    probe_lacks_recv = false;
+    multishot_receive_is_rejected = false;
+    cancel_result = 0;
+    test_request_count = 0;
+    enter_count = 0;
+    last_min_complete = 0;
+    send_capacity = SIZE_MAX;
+    send_error = 0;
+    sent_byte_count = 0;
+    shutdown_count = 0;
+    underlying_on_open_complete = NULL;
+    underlying_on_io_error = NULL;
+    socketio_close_count = 0;
+    socketio_destroy_count = 0;
+    open_complete_count = 0;
+    last_open_result = IO_OPEN_ERROR;
+    received_byte_count = 0;
+    on_bytes_received_count = 0;
+    io_error_count = 0;
+    send_complete_count = 0;
+    socket_io_to_close = NULL;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    /* every test releases the ring it set up */
+    ASSERT_IS_FALSE(is_ring_open);
+    ASSERT_IS_NULL(buffer_memory);
+
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* socketio_uring_is_supported */
+
+TEST_FUNCTION(socketio_uring_is_supported_probes_the_kernel_once)
+{
+    // arrange
+    bool first;
+    bool second;
+
+    // act
+    first = socketio_uring_is_supported();
+    probe_lacks_recv = true;
+    second = socketio_uring_is_supported();
+
+    // assert
+    ASSERT_IS_TRUE(first);
+    ASSERT_IS_TRUE(second);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_setup_count);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+    ASSERT_ARE_EQUAL(size_t, 3, munmap_count);
+}
+
+/* socketio_uring_create */
+
+TEST_FUNCTION(socketio_uring_create_with_NULL_parameters_fails)
+{
+    // act
+    CONCRETE_IO_HANDLE result = socketio_uring_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+TEST_FUNCTION(socketio_uring_create_creates_the_socketio_berkeley_instance_that_connects)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(socketio_create(&TEST_CREATE_PARAMETERS));
+
+    // act
+    socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+
+    // assert
+    ASSERT_IS_NOT_NULL(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, ring_setup_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, socketio_destroy_count);
+}
+
+TEST_FUNCTION(socketio_uring_create_fails_when_socketio_create_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(socketio_create(&TEST_CREATE_PARAMETERS)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+
+    // assert
+    ASSERT_IS_NULL(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* socketio_uring_open */
+
+TEST_FUNCTION(socketio_uring_open_sets_up_the_ring_once_socketio_berkeley_is_connected)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    ASSERT_ARE_EQUAL(size_t, 0, ring_setup_count);
+
+    // act
+    underlying_on_open_complete(underlying_on_open_complete_context, IO_OPEN_OK);
+    underlying_on_open_complete = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_setup_count);
+    ASSERT_IS_NOT_NULL(buffer_ring);
+    ASSERT_ARE_EQUAL(uint32_t, 8, buffer_ring_entries);
+    ASSERT_ARE_EQUAL(uint32_t, 8, buffer_ring->tail);
+    ASSERT_ARE_EQUAL(size_t, 0, enter_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_open_reports_a_failed_connection_without_setting_up_a_ring)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+
+    // act
+    underlying_on_open_complete(underlying_on_open_complete_context, IO_OPEN_ERROR);
+    underlying_on_open_complete = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_ERROR, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, ring_setup_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_close_while_opening_cancels_the_open)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+
+    // act
+    int result = socketio_uring_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, socketio_close_count);
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_CANCELLED, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, ring_setup_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_dowork_while_opening_lets_socketio_berkeley_connect)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_open(socket_io, on_io_open_complete, NULL, on_bytes_received, NULL, on_io_error, NULL));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(socketio_dowork(TEST_SOCKET_IO));
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, enter_count);
+
+    // cleanup
+    (void)socketio_uring_close(socket_io, NULL, NULL);
+    socketio_uring_destroy(socket_io);
+}
+
+/* falling back to socketio_berkeley */
+
+TEST_FUNCTION(when_the_ring_cannot_be_set_up_socketio_berkeley_moves_the_data)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c' };
+    CONCRETE_IO_HANDLE socket_io;
+    int result;
+
+    ring_setup_fails = true;
+    socket_io = create_open_socket_io();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(socketio_send(TEST_SOCKET_IO, data, sizeof(data), on_send_complete, NULL));
+    STRICT_EXPECTED_CALL(socketio_dowork(TEST_SOCKET_IO));
+
+    // act
+    result = socketio_uring_send(socket_io, data, sizeof(data), on_send_complete, NULL);
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, open_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, enter_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_receive_buffers_cannot_be_registered_the_ring_is_released_and_socketio_berkeley_moves_the_data)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    buffer_registration_fails = true;
+
+    // act
+    socket_io = create_open_socket_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, ring_setup_count);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+    ASSERT_ARE_EQUAL(size_t, 3, munmap_count);
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, last_open_result);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(socketio_dowork(TEST_SOCKET_IO));
+    socketio_uring_dowork(socket_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_kernel_without_the_single_mapping_is_not_used)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io;
+
+    ring_features = IORING_FEAT_NODROP;
+
+    // act
+    socket_io = create_open_socket_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, ring_setup_count);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+    ASSERT_ARE_EQUAL(size_t, 0, munmap_count);
+    ASSERT_IS_NULL(buffer_ring);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+/* socketio_uring_dowork */
+
+TEST_FUNCTION(socketio_uring_dowork_submits_a_multishot_receive_into_the_registered_buffers)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    const TEST_REQUEST* receive;
+
+    // act
+    socketio_uring_dowork(socket_io);
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, enter_count);
+    ASSERT_ARE_EQUAL(size_t, 1, test_request_count);
+    receive = get_last_request(IORING_OP_RECV);
+    ASSERT_ARE_EQUAL(int32_t, TEST_SOCKET, receive->fd);
+    ASSERT_ARE_EQUAL(uint8_t, IOSQE_BUFFER_SELECT, receive->flags);
+    ASSERT_ARE_EQUAL(uint16_t, 0, receive->buf_group);
+    ASSERT_ARE_EQUAL(uint16_t, IORING_RECV_MULTISHOT, receive->ioprio);
+    ASSERT_IS_TRUE(is_receive_pending);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_dowork_gives_the_received_data_to_on_bytes_received_and_the_buffers_back_to_the_kernel)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    socketio_uring_dowork(socket_io);
+    receive_from_peer(first, sizeof(first));
+    receive_from_peer(second, sizeof(second));
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, on_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 5, received_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(received_bytes, "abcde", 5));
+    ASSERT_ARE_EQUAL(uint32_t, 10, buffer_ring->tail);
+    ASSERT_ARE_EQUAL(size_t, 1, get_request_count(IORING_OP_RECV));
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_kernel_without_multishot_receive_gets_a_receive_after_each_completion)
+{
+    // arrange
+    const unsigned char data[] = { 'a', 'b', 'c' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+
+    multishot_receive_is_rejected = true;
+    socketio_uring_dowork(socket_io);
+
+    // act
+    socketio_uring_dowork(socket_io);
+    receive_from_peer(data, sizeof(data));
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 3, get_request_count(IORING_OP_RECV));
+    ASSERT_ARE_EQUAL(uint16_t, 0, get_last_request(IORING_OP_RECV)->ioprio);
+    ASSERT_ARE_EQUAL(size_t, 3, received_byte_count);
+    ASSERT_IS_TRUE(is_receive_pending);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(running_out_of_receive_buffers_submits_the_receive_again)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    size_t i;
+
+    socketio_uring_dowork(socket_io);
+    for (i = 0; i < 9; i++)
+    {
+        receive_from_peer(data, sizeof(data));
+    }
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 8, on_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 2, get_request_count(IORING_OP_RECV));
+    ASSERT_IS_TRUE(is_receive_pending);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(the_peer_closing_the_connection_is_reported_as_an_error)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    socketio_uring_dowork(socket_io);
+    complete_pending_receive(0);
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, get_request_count(IORING_OP_RECV));
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_failed_receive_is_reported_as_an_error)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    socketio_uring_dowork(socket_io);
+    complete_pending_receive(-ECONNRESET);
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(on_bytes_received_closing_the_instance_stops_the_completions)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    socketio_uring_dowork(socket_io);
+    receive_from_peer(data, sizeof(data));
+    receive_from_peer(data, sizeof(data));
+    socket_io_to_close = socket_io;
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, on_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 1, socketio_close_count);
+    ASSERT_IS_FALSE(is_ring_open);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+/* socketio_uring_send */
+
+TEST_FUNCTION(the_sends_queued_between_doworks_are_gathered_in_one_sendmsg)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b' };
+    const unsigned char second[] = { 'c' };
+    const unsigned char third[] = { 'd', 'e' };
+    CONSTBUFFER buffers[2];
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    const TEST_REQUEST* send;
+
+    buffers[0].buffer = second;
+    buffers[0].size = sizeof(second);
+    buffers[1].buffer = third;
+    buffers[1].size = sizeof(third);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send(socket_io, first, sizeof(first), on_send_complete, NULL));
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send_vectored(socket_io, buffers, 2, on_send_complete, NULL));
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, enter_count);
+    ASSERT_ARE_EQUAL(size_t, 1, get_request_count(IORING_OP_SENDMSG));
+    send = get_last_request(IORING_OP_SENDMSG);
+    ASSERT_ARE_EQUAL(int32_t, TEST_SOCKET, send->fd);
+    ASSERT_ARE_EQUAL(uint32_t, MSG_NOSIGNAL, send->msg_flags);
+    ASSERT_ARE_EQUAL(size_t, 3, send->iov_count);
+    ASSERT_ARE_EQUAL(size_t, 5, sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcde", 5));
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
+    socketio_uring_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, send_results[0]);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, send_results[1]);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_send_copies_the_data)
+{
+    // arrange
+    unsigned char data[] = { 'a', 'b', 'c' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send(socket_io, data, sizeof(data), on_send_complete, NULL));
+    data[0] = 'x';
+
+    // act
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abc", 3));
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_partial_send_is_resumed_with_the_bytes_left)
+{
+    // arrange
+    const unsigned char first[] = { 'a', 'b', 'c' };
+    const unsigned char second[] = { 'd', 'e' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send(socket_io, first, sizeof(first), on_send_complete, NULL));
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send(socket_io, second, sizeof(second), on_send_complete, NULL));
+    send_capacity = 4;
+
+    // act
+    socketio_uring_dowork(socket_io);
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 2, get_request_count(IORING_OP_SENDMSG));
+    ASSERT_ARE_EQUAL(size_t, 1, get_last_request(IORING_OP_SENDMSG)->iov_count);
+    ASSERT_ARE_EQUAL(size_t, 5, sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcde", 5));
+    socketio_uring_dowork(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 2, send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(a_failed_send_is_reported_as_an_error)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send(socket_io, data, sizeof(data), on_send_complete, NULL));
+    send_error = EPIPE;
+
+    // act
+    socketio_uring_dowork(socket_io);
+    socketio_uring_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 0, send_complete_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_send_before_the_open_completes_fails)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+
+    // act
+    int result = socketio_uring_send(socket_io, data, sizeof(data), on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_destroy_cancels_the_vectored_sends_still_queued)
+{
+    // arrange
+    const unsigned char data[] = { 'a' };
+    CONSTBUFFER buffer;
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+
+    buffer.buffer = data;
+    buffer.size = sizeof(data);
+    ASSERT_ARE_EQUAL(int, 0, socketio_uring_send_vectored(socket_io, &buffer, 1, on_send_complete, NULL));
+
+    // act
+    socketio_uring_destroy(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, send_complete_count);
+    ASSERT_ARE_EQUAL(int, IO_SEND_CANCELLED, send_results[0]);
+    ASSERT_ARE_EQUAL(size_t, 0, sent_byte_count);
+}
+
+/* socketio_uring_close */
+
+TEST_FUNCTION(socketio_uring_close_cancels_the_requests_in_flight_and_releases_the_ring)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    const TEST_REQUEST* cancel;
+    socketio_uring_dowork(socket_io);
+
+    // act
+    int result = socketio_uring_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    cancel = get_last_request(IORING_OP_ASYNC_CANCEL);
+    ASSERT_ARE_EQUAL(int32_t, -1, cancel->fd);
+    ASSERT_ARE_EQUAL(uint32_t, IORING_ASYNC_CANCEL_ANY, cancel->cancel_flags);
+    ASSERT_ARE_EQUAL(uint32_t, 1, last_min_complete);
+    ASSERT_IS_FALSE(is_receive_pending);
+    ASSERT_ARE_EQUAL(size_t, 0, shutdown_count);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+    ASSERT_ARE_EQUAL(size_t, 3, munmap_count);
+    ASSERT_ARE_EQUAL(size_t, 1, socketio_close_count);
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_close_shuts_the_socket_down_when_the_kernel_cannot_cancel_any_request)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+    socketio_uring_dowork(socket_io);
+    cancel_result = -EINVAL;
+
+    // act
+    int result = socketio_uring_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, shutdown_count);
+    ASSERT_IS_FALSE(is_receive_pending);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_close_without_requests_in_flight_releases_the_ring_without_waiting)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socket_io();
+
+    // act
+    int result = socketio_uring_close(socket_io, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, enter_count);
+    ASSERT_ARE_EQUAL(size_t, 1, ring_close_count);
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+/* socketio_uring_setoption */
+
+TEST_FUNCTION(socketio_uring_setoption_rejects_the_event_loop)
+{
+    // arrange
+    bool use_event_loop = true;
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = socketio_uring_setoption(socket_io, OPTION_SOCKETIO_USE_EVENT_LOOP, &use_event_loop);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_uring_setoption_gives_the_other_options_to_socketio_berkeley)
+{
+    // arrange
+    int keep_alive = 1;
+    CONCRETE_IO_HANDLE socket_io = socketio_uring_create(&TEST_CREATE_PARAMETERS);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(socketio_setoption(TEST_SOCKET_IO, "tcp_keepalive", &keep_alive));
+
+    // act
+    int result = socketio_uring_setoption(socket_io, "tcp_keepalive", &keep_alive);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_uring_destroy(socket_io);
+}
+
+END_TEST_SUITE(socketio_uring_unittests)
@@ -52,6 +52,10 @@ static const char* EMPTY_STRING = "";
 static const char* MODIFIED_STRING_VALUE = "Initial*";
 static const char* MODIFIED_STRING_VALUE2 = "*nitial_";
 
+/*too long to be kept inside the handle*/
+static const char LONG_STRING_VALUE[] = "0123456789012345678901234567890123456789";
+#define LONG_STRING_LENGTH              (sizeof(LONG_STRING_VALUE) - 1)
+
 #define NUMBER_OF_CHAR_TOCOPY           8
 #define TEST_INTEGER_VALUE              1234
 
@@ -136,7 +140,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(1));
 
         ///act
         g_hString = STRING_new();
@@ -160,7 +163,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(1));
 
         umock_c_negative_tests_snapshot();
 
@@ -231,7 +233,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_VALUE) + 1));
 
         ///act
         g_hString = STRING_construct(TEST_STRING_VALUE);
@@ -256,7 +257,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_VALUE) + 1));
 
         umock_c_negative_tests_snapshot();
 
@@ -303,7 +303,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 + strlen(TEST_STRING_VALUE) + 1));
 
         ///act
         g_hString = STRING_new_quoted(TEST_STRING_VALUE);
@@ -352,7 +351,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         ///arrange
         STRING_HANDLE str_handle;
 
-        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
         EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
         ///act
@@ -374,7 +372,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         ///arrange
         STRING_HANDLE str_handle;
 
-        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
         EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
         ///act
@@ -399,7 +396,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         int negativeTestsInitResult = umock_c_negative_tests_init();
         ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
-        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
         EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
         umock_c_negative_tests_snapshot();
@@ -434,9 +430,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(INITIAL_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(INITIAL_STRING_VALUE) + strlen(TEST_STRING_VALUE) + 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_concat(g_hString, TEST_STRING_VALUE);
 
@@ -513,10 +506,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_copy(g_hString, TEST_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(TEST_STRING_VALUE) + strlen(TEST_STRING_VALUE)+1))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
         ///act
         STRING_concat(g_hString, TEST_STRING_VALUE);
 
@@ -528,6 +517,59 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_delete(g_hString);
     }
 
+    /* Tests_SRS_STRING_07_012: [STRING_concat shall concatenate the given STRING_HANDLE and the const char* value and place the value in the handle.] */
+    TEST_FUNCTION(STRING_Concat_past_the_inline_buffer_moves_the_value_to_its_own_allocation)
+    {
+        ///arrange
+        int nResult;
+        STRING_HANDLE g_hString;
+        g_hString = STRING_construct(TEST_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        /*twice the size of the buffer inside the handle*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(64));
+
+        ///act
+        nResult = STRING_concat(g_hString, LONG_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, nResult);
+        ASSERT_ARE_EQUAL(size_t, strlen(TEST_STRING_VALUE) + LONG_STRING_LENGTH, STRING_length(g_hString));
+        ASSERT_ARE_EQUAL(char_ptr, LONG_STRING_VALUE, STRING_c_str(g_hString) + strlen(TEST_STRING_VALUE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(g_hString);
+    }
+
+    /* Tests_SRS_STRING_07_012: [STRING_concat shall concatenate the given STRING_HANDLE and the const char* value and place the value in the handle.] */
+    TEST_FUNCTION(STRING_Concat_doubles_the_capacity_when_growing)
+    {
+        ///arrange
+        int nResult1;
+        int nResult2;
+        STRING_HANDLE g_hString;
+        g_hString = STRING_construct(LONG_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * (LONG_STRING_LENGTH + 1)))
+            .IgnoreArgument(1);
+
+        ///act
+        nResult1 = STRING_concat(g_hString, "a");
+        nResult2 = STRING_concat(g_hString, "b");
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, nResult1);
+        ASSERT_ARE_EQUAL(int, 0, nResult2);
+        ASSERT_ARE_EQUAL(size_t, LONG_STRING_LENGTH + 2, STRING_length(g_hString));
+        ASSERT_ARE_EQUAL(char_ptr, "ab", STRING_c_str(g_hString) + LONG_STRING_LENGTH);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(g_hString);
+    }
+
     /* Tests_SRS_STRING_07_034: [String_Concat_with_STRING shall concatenate a given STRING_HANDLE variable with a source STRING_HANDLE.] */
     TEST_FUNCTION(STRING_Concat_With_STRING_SUCCEED)
     {
@@ -537,9 +579,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_HANDLE hAppend = STRING_construct(TEST_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(INITIAL_STRING_VALUE) + strlen(TEST_STRING_VALUE) + 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_concat_with_STRING(g_hString, hAppend);
 
@@ -614,9 +653,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(INITIAL_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(TEST_STRING_VALUE) + 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_copy(g_hString, TEST_STRING_VALUE);
 
@@ -658,9 +694,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(INITIAL_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, NUMBER_OF_CHAR_TOCOPY + 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_copy_n(g_hString, COMBINED_STRING_VALUE, NUMBER_OF_CHAR_TOCOPY);
 
@@ -715,9 +748,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(INITIAL_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_copy_n(g_hString, COMBINED_STRING_VALUE, 0);
 
@@ -739,9 +769,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(TEST_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 + strlen(TEST_STRING_VALUE) + 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_quote(g_hString);
 
@@ -763,10 +790,10 @@ BEGIN_TEST_SUITE(strings_unittests)
         int negativeTestsInitResult = umock_c_negative_tests_init();
         ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
-        str_handle = STRING_construct(TEST_STRING_VALUE);
+        str_handle = STRING_construct(LONG_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 + strlen(TEST_STRING_VALUE) + 1))
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * (LONG_STRING_LENGTH + 1)))
             .IgnoreArgument(1);
 
         umock_c_negative_tests_snapshot();
@@ -829,7 +856,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_VALUE) + 1));
 
         ///act
         g_hString = STRING_construct(TEST_STRING_VALUE);
@@ -852,9 +878,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_construct(TEST_STRING_VALUE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument(1);
-
         ///act
         nResult = STRING_empty(g_hString);
 
@@ -867,6 +890,29 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_delete(g_hString);
     }
 
+    /* Tests_SRS_STRING_07_022: [STRING_empty shall revert the STRING_HANDLE to an empty state.] */
+    TEST_FUNCTION(STRING_empty_keeps_the_allocated_capacity)
+    {
+        ///arrange
+        int nResult;
+        STRING_HANDLE g_hString;
+        g_hString = STRING_construct(LONG_STRING_VALUE);
+        (void)STRING_empty(g_hString);
+        umock_c_reset_all_calls();
+
+        ///act
+        nResult = STRING_copy(g_hString, LONG_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, nResult);
+        ASSERT_ARE_EQUAL(char_ptr, LONG_STRING_VALUE, STRING_c_str(g_hString));
+        ASSERT_ARE_EQUAL(size_t, LONG_STRING_LENGTH, STRING_length(g_hString));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(g_hString);
+    }
+
     /* Tests_SRS_STRING_07_023: [STRING_empty shall return a nonzero value if the STRING_HANDLE is NULL.] */
     TEST_FUNCTION(STRING_empty_NULL_HANDLE_Fail)
     {
@@ -900,6 +946,24 @@ BEGIN_TEST_SUITE(strings_unittests)
         g_hString = STRING_new();
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        STRING_delete(g_hString);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_07_010: [STRING_delete will free the memory allocated by the STRING_HANDLE.] */
+    TEST_FUNCTION(STRING_delete_long_string_frees_value_and_handle)
+    {
+        ///arrange
+        STRING_HANDLE g_hString;
+        g_hString = STRING_construct(LONG_STRING_VALUE);
+        umock_c_reset_all_calls();
+
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
@@ -966,7 +1030,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("aa")));
 
         ///act
         result = STRING_clone(hSource);
@@ -997,7 +1060,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("aa")));
 
         umock_c_negative_tests_snapshot();
 
@@ -1058,8 +1120,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(3))
-            .IgnoreArgument(1);
 
         ///act
         result = STRING_construct_n("qq", 2);
@@ -1080,8 +1140,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_HANDLE result;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(4))
-            .IgnoreArgument(1);
 
         ///act
         result = STRING_construct_n("12345", 3);
@@ -1105,8 +1163,6 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(3))
-            .IgnoreArgument(1);
 
         umock_c_negative_tests_snapshot();
 
@@ -1283,7 +1339,11 @@ BEGIN_TEST_SUITE(strings_unittests)
 
             STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
                 .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(gballoc_malloc(strlen(JSONtests[i].expectedJSON) + 1));
+            if (strlen(JSONtests[i].expectedJSON) + 1 > 32)
+            {
+                /*longer strings do not fit in the handle*/
+                STRICT_EXPECTED_CALL(gballoc_malloc(strlen(JSONtests[i].expectedJSON) + 1));
+            }
 
             ///act
             result = STRING_new_JSON(JSONtests[i].source);
@@ -1307,7 +1367,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen("ab") + 2+1));
 
         umock_c_negative_tests_snapshot();
 
@@ -1371,8 +1430,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(1 + 1));
-
         ///act
         result = STRING_from_byte_array((const unsigned char*)"a", 1);
 
@@ -1393,8 +1450,6 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(1 + 0));
-
         ///act
         result = STRING_from_byte_array(NULL, 0);
 
@@ -1415,14 +1470,14 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(1 + 1))
+        STRICT_EXPECTED_CALL(gballoc_malloc(LONG_STRING_LENGTH + 1))
             .SetReturn(NULL);
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
 
         ///act
-        result = STRING_from_byte_array((const unsigned char*)"a", 1);
+        result = STRING_from_byte_array((const unsigned char*)LONG_STRING_VALUE, LONG_STRING_LENGTH);
 
         ///assert
         ASSERT_IS_NULL(result);
@@ -1494,7 +1549,7 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         umock_c_reset_all_calls();
 
-        EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
         ///act
         str_result = STRING_sprintf(str_handle, FORMAT_STRING, TEST_STRING_VALUE);
@@ -1545,7 +1600,7 @@ BEGIN_TEST_SUITE(strings_unittests)
 
         umock_c_reset_all_calls();
 
-        EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
         umock_c_negative_tests_snapshot();
 
@@ -1654,6 +1709,28 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_delete(str_handle);
     }
 
+    /* Tests_SRS_STRING_07_050: [ If replace is '\0', the string shall end at the first replaced character. ] */
+    TEST_FUNCTION(STRING_replace_with_NUL_truncates_the_length)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct("ab_cd_ef");
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        //act
+        str_result = STRING_replace(str_handle, '_', '\0');
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, "ab", STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(size_t, strlen(STRING_c_str(str_handle)), STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
     /* Tests_SRS_STRING_07_048: [ If target and replace are equal STRING_replace, shall do nothing shall return zero. ] */
     TEST_FUNCTION(STRING_replace_same_string_succeed)
     {
@@ -16,6 +16,7 @@
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
 #include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
 #include "umock_c_negative_tests.h"
 
 /* Requirements not needed as they are optional:
@@ -61,6 +62,7 @@ Tests_SRS_UWS_CLIENT_01_211: [ One implication of this is that in absence of ext
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/uws_permessage_deflate.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
@@ -76,6 +78,8 @@ static const OPTIONHANDLER_HANDLE TEST_IO_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_
 static const OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4447;
 static const STRING_HANDLE BASE64_ENCODED_STRING = (STRING_HANDLE)0x4447;
 static const MAP_HANDLE TEST_REQUEST_HEADERS_MAP = (MAP_HANDLE)0x4448;
+static const UWS_PERMESSAGE_DEFLATE_HANDLE TEST_PERMESSAGE_DEFLATE_HANDLE = (UWS_PERMESSAGE_DEFLATE_HANDLE)0x4449;
+static const UWS_PERMESSAGE_DEFLATE_CONFIG test_permessage_deflate_config = { false, false, 0, 0, 0 };
 
 static size_t currentmalloc_call;
 static size_t whenShallmalloc_fail;
@@ -194,17 +198,17 @@ static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_hand
 static LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle, LIST_MATCH_FUNCTION match_function, const void* match_context)
 {
     size_t i;
-    const void* found_item = NULL;
+    LIST_ITEM_HANDLE found_item = NULL;
     (void)handle;
     for (i = 0; i < list_item_count; i++)
     {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
+        if (match_function((LIST_ITEM_HANDLE)(i + 1), match_context))
         {
-            found_item = list_items[i];
+            found_item = (LIST_ITEM_HANDLE)(i + 1);
             break;
         }
     }
-    return (LIST_ITEM_HANDLE)found_item;
+    return found_item;
 }
 
 static MAP_RESULT my_Map_GetInternals_return;
@@ -339,6 +343,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_open_complete, void*, context, WS_OPE
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_frame_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_fragment_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size, uint64_t, message_offset, bool, is_final)
+MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_peer_closed, void*, context, uint16_t*, close_code, const unsigned char*, extra_data, size_t, extra_data_length)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_error, void*, context, WS_ERROR, error_code);
@@ -390,6 +396,32 @@ static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_
     return g_xio_send_result;
 }
 
+static unsigned char g_sent_frame_bytes[64];
+static size_t g_sent_frame_byte_count;
+static CONSTBUFFER g_sent_frame_buffers[2];
+
+static int my_xio_send_vectored(XIO_HANDLE xio, const CONSTBUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    size_t i;
+    (void)xio;
+    g_sent_frame_byte_count = 0;
+    for (i = 0; i < buffer_count; i++)
+    {
+        if (i < sizeof(g_sent_frame_buffers) / sizeof(g_sent_frame_buffers[0]))
+        {
+            g_sent_frame_buffers[i] = buffers[i];
+        }
+        if (g_sent_frame_byte_count + buffers[i].size <= sizeof(g_sent_frame_bytes))
+        {
+            (void)memcpy(g_sent_frame_bytes + g_sent_frame_byte_count, buffers[i].buffer, buffers[i].size);
+        }
+        g_sent_frame_byte_count += buffers[i].size;
+    }
+    g_on_io_send_complete = on_send_complete;
+    g_on_io_send_complete_context = callback_context;
+    return g_xio_send_result;
+}
+
 static pfCloneOption g_clone_option;
 static pfDestroyOption g_destroy_option;
 static pfSetOption g_set_option;
@@ -428,6 +460,54 @@ extern "C" {
         return real_BUFFER_new();
     }
 
+    /* writes a header with the fixed masking key 0x01 0x02 0x03 0x04 so that the sent bytes are predictable */
+    size_t my_uws_frame_encoder_encode_header(unsigned char* header, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved)
+    {
+        (void)is_masked;
+        (void)reserved;
+        header[0] = (unsigned char)opcode | (is_final ? 0x80 : 0x00);
+        header[1] = 0x80 | (unsigned char)length;
+        header[2] = 0x01;
+        header[3] = 0x02;
+        header[4] = 0x03;
+        header[5] = 0x04;
+        return 6;
+    }
+
+    void my_uws_frame_encoder_mask_payload(unsigned char* destination, const unsigned char* payload, size_t length, const unsigned char* masking_key)
+    {
+        size_t i;
+        for (i = 0; i < length; i++)
+        {
+            destination[i] = payload[i] ^ masking_key[i % 4];
+        }
+    }
+
+    static const unsigned char test_compressed_payload[] = { 0x4B, 0x04, 0x00 };
+    static const unsigned char test_decompressed_payload[] = { 'a', 'a', 'a', 'a' };
+
+    int my_uws_permessage_deflate_compress(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** compressed_payload, size_t* compressed_size)
+    {
+        (void)permessage_deflate;
+        (void)payload;
+        (void)size;
+        (void)is_final;
+        *compressed_payload = test_compressed_payload;
+        *compressed_size = sizeof(test_compressed_payload);
+        return 0;
+    }
+
+    int my_uws_permessage_deflate_decompress(UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** decompressed_payload, size_t* decompressed_size)
+    {
+        (void)permessage_deflate;
+        (void)payload;
+        (void)size;
+        (void)is_final;
+        *decompressed_payload = test_decompressed_payload;
+        *decompressed_size = sizeof(test_decompressed_payload);
+        return 0;
+    }
+
 #ifdef __cplusplus
 }
 #endif
@@ -455,6 +535,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     ASSERT_ARE_EQUAL(int, 0, result);
     result = umocktypes_bool_register_types();
     ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
@@ -463,6 +545,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
     REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
     REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send_vectored, my_xio_send_vectored);
     REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
@@ -484,6 +567,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
     REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode, my_uws_frame_encoder_encode);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode_header, my_uws_frame_encoder_encode_header);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_mask_payload, my_uws_frame_encoder_mask_payload);
     REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, "test_str");
     REGISTER_GLOBAL_MOCK_RETURN(Map_Create, TEST_REQUEST_HEADERS_MAP);
@@ -492,6 +577,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_AddOrUpdate, MAP_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(Map_GetInternals, MAP_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_GetInternals, MAP_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(uws_permessage_deflate_create, TEST_PERMESSAGE_DEFLATE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(uws_permessage_deflate_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(uws_permessage_deflate_get_offer, "permessage-deflate; client_max_window_bits");
+    REGISTER_GLOBAL_MOCK_RETURN(uws_permessage_deflate_is_negotiated, true);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_permessage_deflate_compress, my_uws_permessage_deflate_compress);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_permessage_deflate_decompress, my_uws_permessage_deflate_decompress);
     REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
     REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
     REGISTER_TYPE(WS_OPEN_RESULT, WS_OPEN_RESULT);
@@ -514,6 +605,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(UWS_FRAME_DECODER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_FRAME_DECODED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const CONSTBUFFER*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
@@ -521,6 +613,9 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(UWS_PERMESSAGE_DEFLATE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const UWS_PERMESSAGE_DEFLATE_CONFIG*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(UWS_PERMESSAGE_DEFLATE_STATISTICS*, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -545,6 +640,7 @@ TEST_FUNCTION_INITIALIZE(method_init)
     whenShallrealloc_fail = 0;
     singlylinkedlist_remove_result = 0;
     g_xio_send_result = 0;
+    g_sent_frame_byte_count = 0;
 
     memset(my_Map_GetInternals_keys, 0, sizeof(my_Map_GetInternals_keys));
     memset(my_Map_GetInternals_values, 0, sizeof(my_Map_GetInternals_values));
@@ -1434,6 +1530,7 @@ TEST_FUNCTION(uws_client_create_with_io_with_a_NULL_protocol_name_for_second_pro
 
 /* Tests_SRS_UWS_CLIENT_01_019: [ `uws_client_destroy` shall free all resources associated with the uws instance. ]*/
 /* Tests_SRS_UWS_CLIENT_01_023: [ `uws_client_destroy` shall ensure the underlying IO created in `uws_client_open_async` is destroyed by calling `xio_destroy`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_579: [ After destroying the underlying IO, `uws_client_destroy` shall free the pending send frames that the underlying IO did not complete. ]*/
 /* Tests_SRS_UWS_CLIENT_01_024: [ `uws_client_destroy` shall free the list used to track the pending sends by calling `singlylinkedlist_destroy`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_424: [ `uws_client_destroy` shall free the buffer allocated in `uws_client_create` by calling `BUFFER_delete`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_437: [ `uws_client_destroy` shall free the protocols array allocated in `uws_client_create`. ]*/
@@ -1454,6 +1551,7 @@ TEST_FUNCTION(uws_client_destroy_fress_the_resources)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1487,6 +1585,7 @@ TEST_FUNCTION(uws_client_destroy_with_2_protocols_fress_both_protocols)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1516,6 +1615,7 @@ TEST_FUNCTION(uws_client_destroy_with_no_protocols_frees_all_other_resources)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1566,6 +1666,7 @@ TEST_FUNCTION(uws_client_destroy_also_performs_a_close)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -2390,7 +2491,54 @@ TEST_FUNCTION(uws_client_close_handshake_async_sends_the_close_frame)
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, NULL));
+
+    // act
+    result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x4445);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_578: [ Each pending send frame that still has a send complete callback shall be indicated with `WS_SEND_FRAME_CANCELLED` and stay queued without a callback until the underlying IO completes it, since the underlying IO may still reference its header and payload. ]*/
+TEST_FUNCTION(uws_client_close_handshake_async_cancels_a_pending_send_and_keeps_it_until_the_underlying_send_completes)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    int result;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    ON_SEND_COMPLETE frame_on_send_complete;
+    void* frame_on_send_complete_context;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    frame_on_send_complete = g_on_io_send_complete;
+    frame_on_send_complete_context = g_on_io_send_complete_context;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, IGNORED_NUM_ARG, true, true, 0));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x4445);
@@ -2399,6 +2547,18 @@ TEST_FUNCTION(uws_client_close_handshake_async_sends_the_close_frame)
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    frame_on_send_complete(frame_on_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
     // cleanup
     uws_client_destroy(uws_client);
 }
@@ -2451,7 +2611,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_close_complete_callback
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, NULL));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", NULL, NULL);
@@ -2498,7 +2658,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_context_is_allowed)
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, NULL));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, NULL);
@@ -3874,6 +4034,7 @@ TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indica
 /* Tests_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
 /* Tests_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
 /* Tests_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+/* Tests_SRS_UWS_CLIENT_01_532: [ If no bytes are accumulated from a previous call, frames shall be decoded directly from `buffer` without copying the bytes. ]*/
 TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
@@ -3892,7 +4053,6 @@ TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_th
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3929,7 +4089,6 @@ TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3963,7 +4122,6 @@ TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_t
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -3997,7 +4155,6 @@ TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -4051,9 +4208,6 @@ TEST_FUNCTION(when_a_fragmented_text_frame_is_received_it_shall_be_indicated_to_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
@@ -4113,9 +4267,6 @@ TEST_FUNCTION(when_a_fragmented_binary_frame_is_received_it_shall_be_indicated_t
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
@@ -4154,8 +4305,6 @@ TEST_FUNCTION(when_a_fragmented_frame_is_interleaved_within_another_fragmented_f
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
@@ -4196,7 +4345,6 @@ TEST_FUNCTION(when_a_fragmented_frame_is_received_all_at_once_the_frame_is_indic
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
         .IgnoreArgument_buffer();
 
@@ -4254,10 +4402,8 @@ TEST_FUNCTION(pong_frame_can_be_injected_in_middle_of_fragmented_message)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
         .IgnoreArgument_payload()
         .CaptureReturn(&buffer_handle);
@@ -4272,8 +4418,6 @@ TEST_FUNCTION(pong_frame_can_be_injected_in_middle_of_fragmented_message)
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 255))
@@ -4311,7 +4455,6 @@ TEST_FUNCTION(when_a_fragmented_control_frame_is_received_there_is_an_error)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4351,7 +4494,6 @@ TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 125))
         .ValidateArgumentBuffer(3, &test_frame[2], 125);
 
@@ -4390,7 +4532,6 @@ TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 126))
         .ValidateArgumentBuffer(3, &test_frame[4], 126);
 
@@ -4429,7 +4570,6 @@ TEST_FUNCTION(when_a_127_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 127))
         .ValidateArgumentBuffer(3, &test_frame[4], 127);
 
@@ -4472,7 +4612,6 @@ TEST_FUNCTION(when_a_65535_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65535))
         .ValidateArgumentBuffer(3, &test_frame[4], 65535);
 
@@ -4522,7 +4661,6 @@ TEST_FUNCTION(when_a_65536_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65536))
         .ValidateArgumentBuffer(3, &test_frame[10], 65536);
 
@@ -4572,7 +4710,6 @@ TEST_FUNCTION(when_a_65537_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65537))
         .ValidateArgumentBuffer(3, &test_frame[10], 65537);
 
@@ -4606,7 +4743,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4676,7 +4812,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4757,7 +4892,6 @@ TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4789,7 +4923,6 @@ TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4858,7 +4991,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x00 };
+    unsigned char test_frame[64] = { 0x82, 0x7E, 0x00, 0x80 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4905,7 +5038,6 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)upgrade_response_frame, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -4920,6 +5052,80 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
     free(upgrade_response_frame);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_533: [ Any bytes left over from `buffer` that do not form a complete frame shall be accumulated for decoding when more bytes are received. ]*/
+TEST_FUNCTION(when_a_frame_is_split_across_2_calls_the_frame_is_indicated_once_fully_received)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame_part_1[] = { 0x82, 0x02, 0x42 };
+    const unsigned char test_frame_part_2[] = { 0x43 };
+    const unsigned char expected_payload[] = { 0x42, 0x43 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_part_1, sizeof(test_frame_part_1));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_part_2, sizeof(test_frame_part_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_533: [ Any bytes left over from `buffer` that do not form a complete frame shall be accumulated for decoding when more bytes are received. ]*/
+TEST_FUNCTION(when_a_partial_frame_larger_than_the_accumulated_bytes_buffer_is_received_the_buffer_is_grown)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_frame[126 + 4] = { 0x82, 0x7E, 0x00, 0x7E };
+    unsigned char* expected_payload = test_frame + 4;
+    size_t i;
+
+    for (i = 0; i < 126; i++)
+    {
+        test_frame[4 + i] = (unsigned char)i;
+    }
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 126))
+        .ValidateArgumentBuffer(3, expected_payload, 126);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 100);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame + 100, sizeof(test_frame) - 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
 TEST_FUNCTION(when_a_complete_frame_is_received_together_with_the_upgrade_request_the_frame_is_indicated_as_received)
 {
@@ -5065,7 +5271,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connecti
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -5117,7 +5322,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .SetReturn(NULL);
@@ -5157,7 +5361,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_fram
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -5215,7 +5418,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5268,7 +5470,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5319,7 +5520,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_pass
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(1, &close_frame[4], 2);
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
@@ -5369,7 +5569,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_conn
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(1, &close_frame[4], 1)
         .SetReturn(false);
@@ -5410,7 +5609,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outg
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -5452,7 +5650,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgo
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5652,9 +5849,13 @@ TEST_FUNCTION(uws_client_send_frame_async_when_waiting_for_upgrade_response_fail
 /* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
 /* Tests_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
 /* Tests_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
-/* Tests_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
-/* Tests_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
+/* Tests_SRS_UWS_CLIENT_01_534: [ The frame header shall be encoded into the `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes header storage of the queued structure by calling `uws_frame_encoder_encode_header` and passing to it `size` as payload length, the `is_final` flag and setting `is_masked` to true. ]*/
+/* Tests_SRS_UWS_CLIENT_01_536: [ The queued structure shall be allocated together with the storage for the masked payload, so that the encoded header and the masked payload stay valid until the underlying IO completes the send. ]*/
+/* Tests_SRS_UWS_CLIENT_01_538: [ The payload shall be masked with the masking key at the end of the encoded header by calling `uws_frame_encoder_mask_payload`, writing into the payload storage of the queued structure. ]*/
+/* Tests_SRS_UWS_CLIENT_01_431: [ Once encoded the frame shall be sent by using `xio_send_vectored` with the following arguments: ]*/
+/* Tests_SRS_UWS_CLIENT_01_053: [ - the io handle shall be the underlyiong IO handle created in `uws_client_create`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_054: [ - the `buffers` argument shall point to the encoded header followed by the masked payload. ]*/
+/* Tests_SRS_UWS_CLIENT_01_055: [ - the `buffer_count` argument shall be 2, or 1 when `size` is 0 and there is no payload to send. ]*/
 /* Tests_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
 /* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
@@ -5671,9 +5872,8 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x01, 0x02, 0x03, 0x04, 0x43 };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5685,22 +5885,11 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5708,6 +5897,8 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(encoded_frame), g_sent_frame_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(encoded_frame, g_sent_frame_bytes, sizeof(encoded_frame)));
 
     // cleanup
     uws_client_destroy(uws_client);
@@ -5721,9 +5912,8 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 'a' };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 'a' };
+    unsigned char encoded_frame[] = { 0x81, 0x81, 0x01, 0x02, 0x03, 0x04, 'a' ^ 0x01 };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5735,22 +5925,11 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_TEXT_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_TEXT_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5758,19 +5937,21 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(encoded_frame), g_sent_frame_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(encoded_frame, g_sent_frame_bytes, sizeof(encoded_frame)));
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_055: [ - the `buffer_count` argument shall be 2, or 1 when `size` is 0 and there is no payload to send. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_an_empty_payload_sends_only_the_header)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x80, 0x01, 0x02, 0x03, 0x04 };
     int result;
 
     tlsio_config.hostname = "test_host";
@@ -5782,29 +5963,40 @@ TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, 0, true, true, 0));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 0, true, test_on_ws_send_frame_complete, (void*)0x4248);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(encoded_frame), g_sent_frame_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(encoded_frame, g_sent_frame_bytes, sizeof(encoded_frame)));
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_536: [ The queued structure shall be allocated together with the storage for the masked payload, so that the encoded header and the masked payload stay valid until the underlying IO completes the send. ]*/
+TEST_FUNCTION(a_frame_whose_underlying_send_completes_after_a_second_frame_is_sent_keeps_its_bytes)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    int result;
+    unsigned char test_payload_1[] = { 0x42, 0x43 };
+    unsigned char test_payload_2[] = { 0x44, 0x45, 0x46 };
+    unsigned char encoded_header_1[] = { 0x82, 0x82, 0x01, 0x02, 0x03, 0x04 };
+    unsigned char masked_payload_1[] = { 0x43, 0x41 };
+    unsigned char encoded_frame_2[] = { 0x82, 0x83, 0x01, 0x02, 0x03, 0x04, 0x45, 0x47, 0x45 };
+    CONSTBUFFER frame_1_buffers[2];
+    ON_SEND_COMPLETE frame_1_on_send_complete;
+    void* frame_1_on_send_complete_context;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5813,75 +6005,58 @@ TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_1, sizeof(test_payload_1), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    frame_1_buffers[0] = g_sent_frame_buffers[0];
+    frame_1_buffers[1] = g_sent_frame_buffers[1];
+    frame_1_on_send_complete = g_on_io_send_complete;
+    frame_1_on_send_complete_context = g_on_io_send_complete_context;
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_2, sizeof(test_payload_2), true, test_on_ws_send_frame_complete, (void*)0x4249);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
+    // assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(encoded_frame_2), g_sent_frame_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(encoded_frame_2, g_sent_frame_bytes, sizeof(encoded_frame_2)));
+    ASSERT_ARE_EQUAL(size_t, sizeof(encoded_header_1), frame_1_buffers[0].size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(encoded_header_1, frame_1_buffers[0].buffer, sizeof(encoded_header_1)));
+    ASSERT_ARE_EQUAL(size_t, sizeof(masked_payload_1), frame_1_buffers[1].size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(masked_payload_1, frame_1_buffers[1].buffer, sizeof(masked_payload_1)));
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    frame_1_on_send_complete(frame_1_on_send_complete_context, IO_SEND_OK);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send_frame_async_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
-    LIST_ITEM_HANDLE new_item_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .CaptureReturn(&new_item_handle);
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn((LIST_ITEM_HANDLE)0x1234);
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&new_item_handle);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5894,25 +6069,130 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
+/* Tests_SRS_UWS_CLIENT_01_535: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0))
+        .SetReturn(0);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_577: [ If the size of the queued structure together with the masked payload does not fit in a `size_t`, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_payload_size_is_too_large_for_the_queued_item_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, SIZE_MAX, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_058: [ If `xio_send_vectored` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send_vectored` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
     LIST_ITEM_HANDLE new_item_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)0x1234);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send_vectored` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+    LIST_ITEM_HANDLE new_item_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
@@ -5921,25 +6201,14 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_remo
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item()
         .CaptureReturn(&new_item_handle);
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // section for on_io_send_complete()
     g_xio_send_result = 1;
@@ -5968,9 +6237,7 @@ TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5982,20 +6249,12 @@ TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item()
         .SetReturn(NULL);
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -6016,9 +6275,7 @@ TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -6030,22 +6287,11 @@ TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, NULL, NULL);
@@ -6772,7 +7018,6 @@ TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
         .IgnoreArgument_payload()
         .CaptureReturn(&buffer_handle);
@@ -6823,7 +7068,6 @@ TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_s
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -6869,7 +7113,6 @@ TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -7398,7 +7641,6 @@ TEST_FUNCTION(underlying_io_close_after_a_send_close_frame_failed_puts_the_uws_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7450,7 +7692,6 @@ TEST_FUNCTION(underlying_io_close_due_to_CLOSE_frame_being_received_doe_not_trig
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7493,7 +7734,6 @@ TEST_FUNCTION(underlying_io_close_complete_with_NULL_context_does_nothing)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7713,4 +7953,817 @@ TEST_FUNCTION(uws_client_set_request_header_success)
     uws_client_destroy(uws_client);
 }
 
+/* uws_client_set_fragment_received_callback */
+
+/* Tests_SRS_UWS_CLIENT_01_565: [ If `uws_client` is NULL, `uws_client_set_fragment_received_callback` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_fragment_received_callback_with_NULL_uws_client_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_client_set_fragment_received_callback(NULL, test_on_ws_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_575: [ `uws_client_set_fragment_received_callback` shall store `on_ws_fragment_received` and `on_ws_fragment_received_context` and return 0. ]*/
+TEST_FUNCTION(uws_client_set_fragment_received_callback_succeeds)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_566: [ If the uws instance is not CLOSED, `uws_client_set_fragment_received_callback` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_fragment_received_callback_while_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_567: [ When a fragment received callback is set, the payload bytes of data frames shall be indicated by calling `on_ws_fragment_received` as soon as they are received, without waiting for the whole frame or message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_568: [ `message_offset` shall be the position of the first indicated byte in the message and `is_final` shall be true only for the last slice of the final frame of the message. ]*/
+TEST_FUNCTION(a_partially_received_binary_frame_is_indicated_as_it_arrives)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame_start[] = { 0x82, 0x03, 0x42, 0x43 };
+    const unsigned char test_frame_end[] = { 0x44 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 2, 0, false))
+        .ValidateArgumentBuffer(3, test_frame_start + 2, 2);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1, 2, true))
+        .ValidateArgumentBuffer(3, test_frame_end, 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_start, sizeof(test_frame_start));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_end, sizeof(test_frame_end));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_568: [ `message_offset` shall be the position of the first indicated byte in the message and `is_final` shall be true only for the last slice of the final frame of the message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_569: [ Slices without payload bytes shall not be indicated, except for the last slice of a message. ]*/
+TEST_FUNCTION(the_slices_of_a_fragmented_text_message_carry_the_message_offset)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x02, 0x42, 0x43, 0x00, 0x00, 0x00, 0x01, 0x44, 0x80, 0x00 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 2, 0, false))
+        .ValidateArgumentBuffer(3, test_frames + 2, 2);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1, 2, false))
+        .ValidateArgumentBuffer(3, test_frames + 8, 1);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0, 3, true));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_570: [ When a fragment received callback is set, only the bytes needed to complete a partially received frame header or control frame shall be accumulated, the remaining bytes in `buffer` shall be decoded without copying them. ]*/
+TEST_FUNCTION(a_frame_header_split_across_receives_is_completed_before_the_payload_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame_start[] = { 0x82 };
+    const unsigned char test_frame_end[] = { 0x03, 0x42, 0x43, 0x44 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 3, 0, true))
+        .ValidateArgumentBuffer(3, test_frame_end + 1, 3);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_start, sizeof(test_frame_start));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_end, sizeof(test_frame_end));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_571: [ If a continuation frame is received while no fragmented message is in progress, or a text or binary frame is received while one is, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and the payload of the frame shall be discarded. ]*/
+TEST_FUNCTION(a_streamed_continuation_frame_without_a_message_in_progress_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frames[] = { 0x80, 0x01, 0x42, 0x82, 0x01, 0x43 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1, 0, true))
+        .ValidateArgumentBuffer(3, test_frames + 5, 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_573: [ When a fragment received callback is set, a control frame with a payload longer than 125 bytes shall be indicated as an error by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(a_streamed_control_frame_longer_than_125_bytes_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0x89, 0x7E, 0x00, 0x7E };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_fragment_received_callback(uws_client, test_on_ws_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_get_permessage_deflate_statistics */
+
+/* Tests_SRS_UWS_CLIENT_01_562: [ If `uws_client` or `statistics` is NULL, `uws_client_get_permessage_deflate_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_permessage_deflate_statistics_with_NULL_uws_client_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+    int result;
+
+    // act
+    result = uws_client_get_permessage_deflate_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_562: [ If `uws_client` or `statistics` is NULL, `uws_client_get_permessage_deflate_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_permessage_deflate_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_permessage_deflate_statistics(uws_client, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_563: [ If permessage-deflate is not configured, `uws_client_get_permessage_deflate_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_permessage_deflate_statistics_when_not_configured_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_permessage_deflate_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_557: [ `uws_client_clone_option` called with `name` being `permessage_deflate` shall return a newly allocated copy of the `UWS_PERMESSAGE_DEFLATE_CONFIG` pointed to by `value`. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_permessage_deflate_copies_the_config)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { true, false, 10, 6, 64 };
+    UWS_PERMESSAGE_DEFLATE_CONFIG* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(UWS_PERMESSAGE_DEFLATE_CONFIG)));
+
+    // act
+    result = (UWS_PERMESSAGE_DEFLATE_CONFIG*)g_clone_option(OPTION_WS_PERMESSAGE_DEFLATE, &config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(result->client_no_context_takeover);
+    ASSERT_ARE_EQUAL(int, 10, result->server_max_window_bits);
+    ASSERT_ARE_EQUAL(size_t, 64, result->min_compressed_message_size);
+
+    // cleanup
+    g_destroy_option(OPTION_WS_PERMESSAGE_DEFLATE, result);
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_558: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_fails_uws_client_clone_option_with_permessage_deflate_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(UWS_PERMESSAGE_DEFLATE_CONFIG)))
+        .SetReturn(NULL);
+
+    // act
+    result = g_clone_option(OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+#ifdef USE_PERMESSAGE_DEFLATE
+
+/* Tests_SRS_UWS_CLIENT_01_540: [ If the option name is `permessage_deflate`, `uws_client_set_option` shall create a permessage-deflate instance by calling `uws_permessage_deflate_create` with `value` as config. ]*/
+/* Tests_SRS_UWS_CLIENT_01_544: [ The extension offer obtained with `uws_permessage_deflate_get_offer` shall be added as the `Sec-WebSocket-Extensions` request header, so that it is sent in the upgrade request. ]*/
+/* Tests_SRS_UWS_CLIENT_01_100: [ The request MAY include a header field with the name |Sec-WebSocket-Extensions|. ]*/
+TEST_FUNCTION(uws_client_set_option_permessage_deflate_creates_the_instance_and_adds_the_extensions_header)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_create(&test_permessage_deflate_config));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_get_offer(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_REQUEST_HEADERS_MAP, "Sec-WebSocket-Extensions", "permessage-deflate; client_max_window_bits"));
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_543: [ If creating the permessage-deflate instance or adding the request header fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_uws_permessage_deflate_create_fails_uws_client_set_option_permessage_deflate_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_create(&test_permessage_deflate_config))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_543: [ If creating the permessage-deflate instance or adding the request header fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_adding_the_extensions_header_fails_uws_client_set_option_permessage_deflate_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_create(&test_permessage_deflate_config));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_get_offer(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_REQUEST_HEADERS_MAP, "Sec-WebSocket-Extensions", "permessage-deflate; client_max_window_bits"))
+        .SetReturn(MAP_ERROR);
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_destroy(TEST_PERMESSAGE_DEFLATE_HANDLE));
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_542: [ If `value` is NULL, the permessage-deflate instance shall be destroyed and the `Sec-WebSocket-Extensions` request header removed. ]*/
+TEST_FUNCTION(uws_client_set_option_permessage_deflate_with_NULL_value_destroys_the_instance)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_Delete(TEST_REQUEST_HEADERS_MAP, "Sec-WebSocket-Extensions"));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_destroy(TEST_PERMESSAGE_DEFLATE_HANDLE));
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_541: [ If the uws instance is not CLOSED, setting the `permessage_deflate` option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_permessage_deflate_while_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_546: [ If permessage-deflate is configured, the value of the `Sec-WebSocket-Extensions` header of the upgrade response shall be passed to `uws_permessage_deflate_accept_response`. ]*/
+TEST_FUNCTION(the_extensions_header_of_the_upgrade_response_is_passed_to_uws_permessage_deflate_accept_response)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nsec-websocket-extensions: permessage-deflate; server_no_context_takeover\r\n\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_accept_response(TEST_PERMESSAGE_DEFLATE_HANDLE, "permessage-deflate; server_no_context_takeover"));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_548: [ If `uws_permessage_deflate_accept_response` fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_111: [ If the response includes a |Sec-WebSocket-Extensions| header field and this header field indicates the use of an extension that was not present in the client's handshake (the server has indicated an extension not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+TEST_FUNCTION(when_uws_permessage_deflate_accept_response_fails_the_open_completes_with_BAD_UPGRADE_RESPONSE)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: x-webkit-deflate-frame\r\n\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_accept_response(TEST_PERMESSAGE_DEFLATE_HANDLE, "x-webkit-deflate-frame"))
+        .SetReturn(1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_547: [ If the upgrade response has no `Sec-WebSocket-Extensions` header, uws shall call `uws_permessage_deflate_reset` and exchange uncompressed messages. ]*/
+TEST_FUNCTION(an_upgrade_response_without_extensions_header_resets_permessage_deflate)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_reset(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_553: [ When sending the first frame of a message, uws shall call `uws_permessage_deflate_should_compress` to decide whether all the frames of the message are compressed. ]*/
+/* Tests_SRS_UWS_CLIENT_01_554: [ The RSV1 bit shall be set on the first frame of a compressed message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_555: [ The payload of each frame of a compressed message shall be compressed by calling `uws_permessage_deflate_compress` and the compressed bytes shall be masked and sent instead of `buffer`. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_permessage_deflate_sends_the_compressed_payload_with_RSV1)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    unsigned char test_payload[] = { 'a', 'a', 'a', 'a' };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_should_compress(TEST_PERMESSAGE_DEFLATE_HANDLE, sizeof(test_payload), true))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_compress(TEST_PERMESSAGE_DEFLATE_HANDLE, test_payload, sizeof(test_payload), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, WS_BINARY_FRAME, sizeof(test_compressed_payload), true, true, RESERVED_1));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(test_compressed_payload)));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask_payload(IGNORED_PTR_ARG, test_compressed_payload, sizeof(test_compressed_payload), IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send_vectored(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_556: [ If `uws_permessage_deflate_compress` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_uws_permessage_deflate_compress_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    unsigned char test_payload[] = { 'a', 'a', 'a', 'a' };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_should_compress(TEST_PERMESSAGE_DEFLATE_HANDLE, sizeof(test_payload), true))
+        .SetReturn(true);
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_compress(TEST_PERMESSAGE_DEFLATE_HANDLE, test_payload, sizeof(test_payload), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_149: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+/* Tests_SRS_UWS_CLIENT_01_550: [ RSV1 on the first frame of a message shall mark all the frames of the message as compressed. ]*/
+/* Tests_SRS_UWS_CLIENT_01_551: [ The payload of each frame of a compressed message shall be decompressed by calling `uws_permessage_deflate_decompress` before being delivered or accumulated. ]*/
+TEST_FUNCTION(a_received_frame_with_RSV1_is_decompressed_before_being_indicated_to_the_user)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    const unsigned char test_frame[] = { 0xC2, 0x03, 0x4B, 0x04, 0x00 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_is_negotiated(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_decompress(TEST_PERMESSAGE_DEFLATE_HANDLE, IGNORED_PTR_ARG, 3, true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_frame + 2, 3);
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_decompressed_payload)))
+        .ValidateArgumentBuffer(3, test_decompressed_payload, sizeof(test_decompressed_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_552: [ If `uws_permessage_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_uws_permessage_deflate_decompress_fails_an_error_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    const unsigned char test_frame[] = { 0xC2, 0x03, 0x4B, 0x04, 0x00 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_is_negotiated(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_decompress(TEST_PERMESSAGE_DEFLATE_HANDLE, IGNORED_PTR_ARG, 3, true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_150: [ If a nonzero value is received and none of the negotiated extensions defines the meaning of such a nonzero value, the receiving endpoint MUST _Fail the WebSocket Connection_. ]*/
+/* Tests_SRS_UWS_CLIENT_01_549: [ If RSV1 is set on a continuation frame or while permessage-deflate is not negotiated, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(RSV1_on_a_continuation_frame_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    const unsigned char first_fragment[] = { 0x02, 0x01, 0x42 };
+    const unsigned char last_fragment[] = { 0xC0, 0x01, 0x43 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, first_fragment, sizeof(first_fragment));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, last_fragment, sizeof(last_fragment));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_549: [ If RSV1 is set on a continuation frame or while permessage-deflate is not negotiated, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(RSV1_when_permessage_deflate_was_not_negotiated_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0xC2, 0x03, 0x4B, 0x04, 0x00 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_is_negotiated(TEST_PERMESSAGE_DEFLATE_HANDLE))
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_561: [ `uws_client_get_permessage_deflate_statistics` shall fill `statistics` by calling `uws_permessage_deflate_get_statistics`. ]*/
+TEST_FUNCTION(uws_client_get_permessage_deflate_statistics_gets_the_statistics_of_the_instance)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_get_statistics(TEST_PERMESSAGE_DEFLATE_HANDLE, &statistics));
+
+    // act
+    result = uws_client_get_permessage_deflate_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_564: [ `uws_client_destroy` shall destroy the permessage-deflate instance, if any, by calling `uws_permessage_deflate_destroy`. ]*/
+TEST_FUNCTION(uws_client_destroy_destroys_the_permessage_deflate_instance)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(uws_permessage_deflate_destroy(TEST_PERMESSAGE_DEFLATE_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+#else
+
+/* Tests_SRS_UWS_CLIENT_01_545: [ If uws was built without permessage-deflate support, setting the `permessage_deflate` option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_permessage_deflate_fails_when_built_without_permessage_deflate)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &test_permessage_deflate_config);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+#endif
+
 END_TEST_SUITE(uws_client_ut)
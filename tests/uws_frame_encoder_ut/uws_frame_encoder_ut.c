@@ -5,11 +5,13 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -1417,4 +1419,204 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_
     real_BUFFER_delete(result);
 }
 
+/* uws_frame_encoder_encode_header */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_055: [ `uws_frame_encoder_encode_header` shall write in `header` only the frame header (including the masking key when `is_masked` is true) for a frame with the given `opcode`, payload `length`, `is_masked`, `is_final` and `reserved`, encoded the same way as `uws_frame_encoder_encode` does. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_059: [ On success `uws_frame_encoder_encode_header` shall return the number of header bytes written, which is at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE`. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_for_an_unmasked_1_byte_frame_writes_2_bytes)
+{
+    // arrange
+    size_t result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x82, 0x01 };
+
+    // act
+    result = uws_frame_encoder_encode_header(header, WS_BINARY_FRAME, 1, false, true, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), result);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(header, result, actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_055: [ `uws_frame_encoder_encode_header` shall write in `header` only the frame header (including the masking key when `is_masked` is true) for a frame with the given `opcode`, payload `length`, `is_masked`, `is_final` and `reserved`, encoded the same way as `uws_frame_encoder_encode` does. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_059: [ On success `uws_frame_encoder_encode_header` shall return the number of header bytes written, which is at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE`. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_for_a_masked_126_byte_frame_writes_8_bytes)
+{
+    // arrange
+    size_t result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x01, 0xFE, 0x00, 0x7E, 0x01, 0x02, 0x03, 0x04 };
+
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x01);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x02);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x03);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x04);
+
+    // act
+    result = uws_frame_encoder_encode_header(header, WS_TEXT_FRAME, 126, true, false, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), result);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(header, result, actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_059: [ On success `uws_frame_encoder_encode_header` shall return the number of header bytes written, which is at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE`. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_for_a_masked_65536_byte_frame_writes_the_max_header_size)
+{
+    // arrange
+    size_t result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0xC2, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0xAA, 0xBB, 0xCC, 0xDD };
+
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xAA);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xBB);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xCC);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xDD);
+
+    // act
+    result = uws_frame_encoder_encode_header(header, WS_BINARY_FRAME, 65536, true, true, RESERVED_1);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, result);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(header, result, actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If `header` is NULL, `uws_frame_encoder_encode_header` shall fail and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_fails)
+{
+    // arrange
+    size_t result;
+
+    // act
+    result = uws_frame_encoder_encode_header(NULL, WS_BINARY_FRAME, 1, true, true, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_057: [ If `reserved` has any bits set except the lowest 3 then `uws_frame_encoder_encode_header` shall fail and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_bad_reserved_bits_fails)
+{
+    // arrange
+    size_t result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+
+    // act
+    result = uws_frame_encoder_encode_header(header, WS_BINARY_FRAME, 1, true, true, 8);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_058: [ If `opcode` is bigger than 0x0F then `uws_frame_encoder_encode_header` shall fail and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_bad_opcode_fails)
+{
+    // arrange
+    size_t result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+
+    // act
+    result = uws_frame_encoder_encode_header(header, (WS_FRAME_TYPE)0x10, 1, true, true, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_encoder_mask_payload */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_060: [ `uws_frame_encoder_mask_payload` shall write to `destination` the `length` bytes of `payload`, each XOR-ed with the octet at index i modulo 4 of the 4 bytes pointed to by `masking_key`. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_062: [ `destination` and `payload` may point to the same memory and need not be aligned. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_payload_masks_all_lengths_at_all_alignments)
+{
+    // arrange
+    unsigned char payload[80];
+    unsigned char expected_bytes[80];
+    unsigned char destination[84];
+    unsigned char masking_key[] = { 0x12, 0x34, 0x56, 0x78 };
+    size_t offset;
+    size_t length;
+    size_t i;
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)(i * 7 + 3);
+    }
+
+    for (offset = 0; offset < 4; offset++)
+    {
+        for (length = 0; length <= sizeof(payload) - offset; length++)
+        {
+            (void)memset(destination, 0xEE, sizeof(destination));
+            for (i = 0; i < length; i++)
+            {
+                expected_bytes[i] = payload[offset + i] ^ masking_key[i % 4];
+            }
+
+            // act
+            uws_frame_encoder_mask_payload(destination + offset, payload + offset, length, masking_key);
+
+            // assert
+            ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, destination + offset, length));
+            ASSERT_ARE_EQUAL(int, 0xEE, (int)destination[offset + length]);
+        }
+    }
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_062: [ `destination` and `payload` may point to the same memory and need not be aligned. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_payload_masks_in_place)
+{
+    // arrange
+    unsigned char payload[] = { 0x42, 0x43, 0x44, 0x45, 0x01, 0x02, 0xFF, 0xAA, 0x42, 0x43, 0x44, 0x45, 0x01, 0x02, 0xFF, 0xAA, 0x00, 0x01, 0x02 };
+    unsigned char expected_bytes[] = { 0x42, 0xBC, 0xEE, 0x07, 0x01, 0xFD, 0x55, 0xE8, 0x42, 0xBC, 0xEE, 0x07, 0x01, 0xFD, 0x55, 0xE8, 0x00, 0xFE, 0xA8 };
+    unsigned char masking_key[] = { 0x00, 0xFF, 0xAA, 0x42 };
+
+    // act
+    uws_frame_encoder_mask_payload(payload, payload, sizeof(payload), masking_key);
+
+    // assert
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(payload, sizeof(payload), actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_061: [ If `destination`, `payload` or `masking_key` is NULL, `uws_frame_encoder_mask_payload` shall return without touching `destination`. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_payload_with_NULL_masking_key_does_not_touch_destination)
+{
+    // arrange
+    unsigned char payload[] = { 0x42, 0x43 };
+    unsigned char destination[] = { 0xEE, 0xEE };
+
+    // act
+    uws_frame_encoder_mask_payload(destination, payload, sizeof(payload), NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0xEE, (int)destination[0]);
+    ASSERT_ARE_EQUAL(int, 0xEE, (int)destination[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(uws_frame_encoder_ut)
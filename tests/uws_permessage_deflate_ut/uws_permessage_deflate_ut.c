@@ -0,0 +1,753 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/uws_permessage_deflate.h"
+
+static const UWS_PERMESSAGE_DEFLATE_CONFIG test_default_config = { false, false, 0, 0, 0 };
+static const unsigned char test_message[] = "Hello Hello Hello Hello Hello Hello Hello Hello Hello Hello";
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static UWS_PERMESSAGE_DEFLATE_HANDLE create_negotiated_instance(const UWS_PERMESSAGE_DEFLATE_CONFIG* config, const char* response)
+{
+    UWS_PERMESSAGE_DEFLATE_HANDLE result = uws_permessage_deflate_create(config);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_accept_response(result, response));
+    umock_c_reset_all_calls();
+    return result;
+}
+
+BEGIN_TEST_SUITE(uws_permessage_deflate_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* uws_permessage_deflate_create */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_001: [ `uws_permessage_deflate_create` shall allocate a new permessage-deflate instance and on success return a non-NULL handle to it. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_005: [ `uws_permessage_deflate_create` shall build the extension offer `permessage-deflate; client_max_window_bits`, followed by `; client_no_context_takeover` and `; server_no_context_takeover` when the matching config flags are set and by `; server_max_window_bits=N` when `server_max_window_bits` is not 0. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_008: [ `uws_permessage_deflate_get_offer` shall return the extension offer to be sent in the `Sec-WebSocket-Extensions` header of the upgrade request. ]*/
+TEST_FUNCTION(uws_permessage_deflate_create_succeeds)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = uws_permessage_deflate_create(&test_default_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "permessage-deflate; client_max_window_bits", uws_permessage_deflate_get_offer(result));
+    ASSERT_IS_FALSE(uws_permessage_deflate_is_negotiated(result));
+
+    // cleanup
+    uws_permessage_deflate_destroy(result);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_005: [ `uws_permessage_deflate_create` shall build the extension offer `permessage-deflate; client_max_window_bits`, followed by `; client_no_context_takeover` and `; server_no_context_takeover` when the matching config flags are set and by `; server_max_window_bits=N` when `server_max_window_bits` is not 0. ]*/
+TEST_FUNCTION(uws_permessage_deflate_create_with_all_parameters_builds_the_offer)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { true, true, 10, 9, 0 };
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_permessage_deflate_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, "permessage-deflate; client_max_window_bits; client_no_context_takeover; server_no_context_takeover; server_max_window_bits=10", uws_permessage_deflate_get_offer(result));
+
+    // cleanup
+    uws_permessage_deflate_destroy(result);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_002: [ If `config` is NULL, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_permessage_deflate_create_with_NULL_config_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_permessage_deflate_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_003: [ If `server_max_window_bits` is not 0 and not between 8 and 15, or `compression_level` is not between 0 and 9, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_permessage_deflate_create_with_invalid_server_max_window_bits_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { false, false, 16, 0, 0 };
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_permessage_deflate_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_003: [ If `server_max_window_bits` is not 0 and not between 8 and 15, or `compression_level` is not between 0 and 9, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_permessage_deflate_create_with_invalid_compression_level_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { false, false, 0, 10, 0 };
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_permessage_deflate_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_004: [ If allocating memory fails, `uws_permessage_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_uws_permessage_deflate_create_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_permessage_deflate_create(&test_default_config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_permessage_deflate_destroy */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_007: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_destroy` shall do nothing. ]*/
+TEST_FUNCTION(uws_permessage_deflate_destroy_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    uws_permessage_deflate_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_006: [ `uws_permessage_deflate_destroy` shall end the zlib contexts, if any, and free all resources of the instance. ]*/
+TEST_FUNCTION(uws_permessage_deflate_destroy_frees_the_instance)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(permessage_deflate));
+
+    // act
+    uws_permessage_deflate_destroy(permessage_deflate);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_permessage_deflate_get_offer */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_009: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_get_offer` shall return NULL. ]*/
+TEST_FUNCTION(uws_permessage_deflate_get_offer_with_NULL_handle_returns_NULL)
+{
+    // arrange
+    const char* result;
+
+    // act
+    result = uws_permessage_deflate_get_offer(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* uws_permessage_deflate_accept_response */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_011: [ If `permessage_deflate` or `extensions` is NULL, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(NULL, "permessage-deflate");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_011: [ If `permessage_deflate` or `extensions` is NULL, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_NULL_extensions_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(uws_permessage_deflate_is_negotiated(permessage_deflate));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_010: [ `uws_permessage_deflate_accept_response` shall parse `extensions`, the value of the `Sec-WebSocket-Extensions` header of the upgrade response, as a comma separated list of extensions with semicolon separated parameters. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_013: [ `server_no_context_takeover` shall make the inflate context be reset after each received message. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_014: [ `client_no_context_takeover` shall make the deflate context be reset after each sent message. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_015: [ `server_max_window_bits` shall have a value between 8 and 15, not bigger than the one offered, if any, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_016: [ `client_max_window_bits` shall have a value between 9 and 15, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_018: [ When `permessage-deflate` was accepted, `uws_permessage_deflate_accept_response` shall create a raw deflate context with `deflateInit2` and a window of `client_max_window_bits` and a raw inflate context with `inflateInit2`. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_023: [ `uws_permessage_deflate_is_negotiated` shall return true if `permessage_deflate` is not NULL and the server accepted the extension. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_all_parameters_succeeds)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate; server_no_context_takeover; client_no_context_takeover; server_max_window_bits=10; client_max_window_bits=\"12\"");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(uws_permessage_deflate_is_negotiated(permessage_deflate));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_020: [ If `extensions` does not contain any extension, `uws_permessage_deflate_accept_response` shall succeed and leave the extension not negotiated. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_no_extension_leaves_the_extension_not_negotiated)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(uws_permessage_deflate_is_negotiated(permessage_deflate));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_012: [ If the response contains any extension other than a single `permessage-deflate`, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_an_unknown_extension_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "x-webkit-deflate-frame");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(uws_permessage_deflate_is_negotiated(permessage_deflate));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_012: [ If the response contains any extension other than a single `permessage-deflate`, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_permessage_deflate_twice_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate, permessage-deflate");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_017: [ If the response contains an unknown parameter, `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_an_unknown_parameter_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate; x_max_window_bits=10");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_015: [ `server_max_window_bits` shall have a value between 8 and 15, not bigger than the one offered, if any, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_a_server_window_bigger_than_offered_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { false, false, 10, 0, 0 };
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate; server_max_window_bits=12");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_016: [ `client_max_window_bits` shall have a value between 9 and 15, otherwise `uws_permessage_deflate_accept_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_accept_response_with_a_client_window_of_8_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    int result;
+
+    // act
+    result = uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate; client_max_window_bits=8");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* uws_permessage_deflate_reset */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_021: [ `uws_permessage_deflate_reset` shall end the zlib contexts, if any, and mark the extension as not negotiated. ]*/
+TEST_FUNCTION(uws_permessage_deflate_reset_marks_the_extension_as_not_negotiated)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+
+    // act
+    uws_permessage_deflate_reset(permessage_deflate);
+
+    // assert
+    ASSERT_IS_FALSE(uws_permessage_deflate_is_negotiated(permessage_deflate));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_022: [ If `permessage_deflate` is NULL, `uws_permessage_deflate_reset` shall do nothing. ]*/
+TEST_FUNCTION(uws_permessage_deflate_reset_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    uws_permessage_deflate_reset(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_permessage_deflate_should_compress */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_024: [ `uws_permessage_deflate_should_compress` shall return true if the extension is negotiated and the first frame of a message is not final or carries at least `min_compressed_message_size` bytes. ]*/
+TEST_FUNCTION(uws_permessage_deflate_should_compress_honours_min_compressed_message_size)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_CONFIG config = { false, false, 0, 0, 32 };
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&config);
+
+    // act
+    // assert
+    ASSERT_IS_FALSE(uws_permessage_deflate_should_compress(permessage_deflate, 64, true));
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_accept_response(permessage_deflate, "permessage-deflate"));
+    ASSERT_IS_FALSE(uws_permessage_deflate_should_compress(permessage_deflate, 31, true));
+    ASSERT_IS_TRUE(uws_permessage_deflate_should_compress(permessage_deflate, 31, false));
+    ASSERT_IS_TRUE(uws_permessage_deflate_should_compress(permessage_deflate, 32, true));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* uws_permessage_deflate_compress */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_025: [ `uws_permessage_deflate_compress` shall compress `payload` with `deflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which stays valid until the next call. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_029: [ For the final frame of a message the trailing `0x00 0x00 0xFF 0xFF` bytes shall be removed from the compressed payload. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_032: [ On success, `uws_permessage_deflate_compress` shall return 0. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_033: [ `uws_permessage_deflate_decompress` shall decompress `payload` with `inflate` into a buffer owned by the instance, which stays valid until the next call. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_036: [ For the final frame of a message the bytes `0x00 0x00 0xFF 0xFF` shall be decompressed after `payload`. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_039: [ On success, `uws_permessage_deflate_decompress` shall return 0. ]*/
+TEST_FUNCTION(a_compressed_message_decompresses_to_the_original_payload)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE sender = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    UWS_PERMESSAGE_DEFLATE_HANDLE receiver = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_permessage_deflate_compress(sender, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(compressed_size < sizeof(test_message));
+    ASSERT_IS_FALSE((compressed_size >= 4) && (memcmp(compressed_payload + compressed_size - 4, "\x00\x00\xFF\xFF", 4) == 0));
+    result = uws_permessage_deflate_decompress(receiver, compressed_payload, compressed_size, true, &decompressed_payload, &decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_message), decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(test_message, decompressed_payload, decompressed_size));
+
+    // cleanup
+    uws_permessage_deflate_destroy(sender);
+    uws_permessage_deflate_destroy(receiver);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_030: [ If `client_no_context_takeover` is in effect, the deflate context shall be reset with `deflateReset` after the final frame of a message. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_037: [ If `server_no_context_takeover` is in effect, the inflate context shall be reset with `inflateReset` after the final frame of a message. ]*/
+TEST_FUNCTION(with_no_context_takeover_every_message_is_compressed_independently)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE sender = create_negotiated_instance(&test_default_config, "permessage-deflate; client_no_context_takeover");
+    UWS_PERMESSAGE_DEFLATE_HANDLE receiver = create_negotiated_instance(&test_default_config, "permessage-deflate; server_no_context_takeover");
+    unsigned char first_message[64];
+    size_t first_size;
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_compress(sender, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size));
+    ASSERT_IS_TRUE(compressed_size <= sizeof(first_message));
+    (void)memcpy(first_message, compressed_payload, compressed_size);
+    first_size = compressed_size;
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_decompress(receiver, compressed_payload, compressed_size, true, &decompressed_payload, &decompressed_size));
+
+    // act
+    result = uws_permessage_deflate_compress(sender, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, first_size, compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(first_message, compressed_payload, compressed_size));
+    result = uws_permessage_deflate_decompress(receiver, compressed_payload, compressed_size, true, &decompressed_payload, &decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_message), decompressed_size);
+
+    // cleanup
+    uws_permessage_deflate_destroy(sender);
+    uws_permessage_deflate_destroy(receiver);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_045: [ If the final frame would carry no compressed bytes, a single `0x00` byte shall be sent so that the receiver can append the trailing bytes to it. ]*/
+TEST_FUNCTION(an_empty_final_frame_is_compressed_to_a_single_byte)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE sender = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    UWS_PERMESSAGE_DEFLATE_HANDLE receiver = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_compress(sender, test_message, sizeof(test_message), false, &compressed_payload, &compressed_size));
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_decompress(receiver, compressed_payload, compressed_size, false, &decompressed_payload, &decompressed_size));
+
+    // act
+    result = uws_permessage_deflate_compress(sender, NULL, 0, true, &compressed_payload, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, (int)compressed_payload[0]);
+    result = uws_permessage_deflate_decompress(receiver, compressed_payload, compressed_size, true, &decompressed_payload, &decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, decompressed_size);
+
+    // cleanup
+    uws_permessage_deflate_destroy(sender);
+    uws_permessage_deflate_destroy(receiver);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_026: [ If `permessage_deflate`, `compressed_payload` or `compressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_compress_with_NULL_arguments_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_compress(NULL, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_compress(permessage_deflate, NULL, sizeof(test_message), true, &compressed_payload, &compressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_compress(permessage_deflate, test_message, sizeof(test_message), true, NULL, &compressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_compress(permessage_deflate, test_message, sizeof(test_message), true, &compressed_payload, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_027: [ If the extension is not negotiated, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_compress_when_not_negotiated_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    int result;
+
+    // act
+    result = uws_permessage_deflate_compress(permessage_deflate, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_028: [ If `deflate` fails or the output buffer cannot be grown, `uws_permessage_deflate_compress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_output_buffer_fails_uws_permessage_deflate_compress_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    int result;
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_permessage_deflate_compress(permessage_deflate, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* uws_permessage_deflate_decompress */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_034: [ If `permessage_deflate`, `decompressed_payload` or `decompressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_decompress_with_NULL_arguments_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_decompress(NULL, test_message, sizeof(test_message), true, &decompressed_payload, &decompressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_decompress(permessage_deflate, NULL, sizeof(test_message), true, &decompressed_payload, &decompressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_decompress(permessage_deflate, test_message, sizeof(test_message), true, NULL, &decompressed_size));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_decompress(permessage_deflate, test_message, sizeof(test_message), true, &decompressed_payload, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_035: [ If the extension is not negotiated, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_decompress_when_not_negotiated_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_permessage_deflate_decompress(permessage_deflate, test_message, sizeof(test_message), true, &decompressed_payload, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_042: [ If `inflate` fails, `uws_permessage_deflate_decompress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_decompress_with_invalid_deflate_data_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    const unsigned char invalid_payload[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_permessage_deflate_decompress(permessage_deflate, invalid_payload, sizeof(invalid_payload), true, &decompressed_payload, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* uws_permessage_deflate_get_statistics */
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_031: [ `uws_permessage_deflate_compress` shall add `size` and the compressed size to the sent byte counters and the processor time spent to `compress_time_us`. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_038: [ `uws_permessage_deflate_decompress` shall add `size` and the decompressed size to the received byte counters and the processor time spent to `decompress_time_us`. ]*/
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_043: [ `uws_permessage_deflate_get_statistics` shall copy the counters accumulated since the instance was created to `statistics` and return 0. ]*/
+TEST_FUNCTION(uws_permessage_deflate_get_statistics_returns_the_byte_counters)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = create_negotiated_instance(&test_default_config, "permessage-deflate");
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    int result;
+
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_compress(permessage_deflate, test_message, sizeof(test_message), true, &compressed_payload, &compressed_size));
+    ASSERT_ARE_EQUAL(int, 0, uws_permessage_deflate_decompress(permessage_deflate, compressed_payload, compressed_size, true, &decompressed_payload, &decompressed_size));
+
+    // act
+    result = uws_permessage_deflate_get_statistics(permessage_deflate, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)sizeof(test_message), (int)statistics.sent_uncompressed_bytes);
+    ASSERT_ARE_EQUAL(int, (int)compressed_size, (int)statistics.sent_compressed_bytes);
+    ASSERT_ARE_EQUAL(int, (int)compressed_size, (int)statistics.received_compressed_bytes);
+    ASSERT_ARE_EQUAL(int, (int)sizeof(test_message), (int)statistics.received_uncompressed_bytes);
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+/* Tests_SRS_UWS_PERMESSAGE_DEFLATE_01_044: [ If `permessage_deflate` or `statistics` is NULL, `uws_permessage_deflate_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_permessage_deflate_get_statistics_with_NULL_arguments_fails)
+{
+    // arrange
+    UWS_PERMESSAGE_DEFLATE_HANDLE permessage_deflate = uws_permessage_deflate_create(&test_default_config);
+    UWS_PERMESSAGE_DEFLATE_STATISTICS statistics;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_get_statistics(NULL, &statistics));
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_permessage_deflate_get_statistics(permessage_deflate, NULL));
+
+    // cleanup
+    uws_permessage_deflate_destroy(permessage_deflate);
+}
+
+END_TEST_SUITE(uws_permessage_deflate_ut)
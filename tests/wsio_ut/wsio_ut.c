@@ -195,6 +195,17 @@ static void* g_on_ws_error_context;
 static ON_WS_CLOSE_COMPLETE g_on_ws_close_complete;
 static void* g_on_ws_close_complete_context;
 
+static ON_WS_FRAGMENT_RECEIVED g_on_ws_fragment_received;
+static void* g_on_ws_fragment_received_context;
+
+static int my_uws_client_set_fragment_received_callback(UWS_CLIENT_HANDLE uws, ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received, void* on_ws_fragment_received_context)
+{
+    (void)uws;
+    g_on_ws_fragment_received = on_ws_fragment_received;
+    g_on_ws_fragment_received_context = on_ws_fragment_received_context;
+    return 0;
+}
+
 static int my_uws_open_async(UWS_CLIENT_HANDLE uws, ON_WS_OPEN_COMPLETE on_ws_open_complete, void* on_ws_open_complete_context, ON_WS_FRAME_RECEIVED on_ws_frame_received, void* on_ws_frame_received_context, ON_WS_PEER_CLOSED on_ws_peer_closed, void* on_ws_peer_closed_context, ON_WS_ERROR on_ws_error, void* on_ws_error_context)
 {
     (void)uws;
@@ -275,6 +286,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, my_singlylinkedlist_find);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_open_async, my_uws_open_async);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_client_set_fragment_received_callback, my_uws_client_set_fragment_received_callback);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_close_async, my_uws_close_async);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_send_frame_async, my_uws_send_frame_async);
     REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
@@ -294,6 +306,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(UWS_CLIENT_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_FRAME_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_WS_FRAGMENT_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_ERROR, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_CLOSE_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_SEND_FRAME_COMPLETE, void*);
@@ -571,6 +584,7 @@ TEST_FUNCTION(wsio_destroy_with_NULL_does_nothing)
 
 /* Tests_SRS_WSIO_01_082: [ `wsio_open` shall open the underlying uws instance by calling `uws_client_open_async` and providing the uws handle created in `wsio_create` as argument. ]*/
 /* Tests_SRS_WSIO_01_083: [ On success, `wsio_open` shall return 0. ]*/
+/* Tests_SRS_WSIO_01_187: [ Before opening the uws instance, `wsio_open` shall call `uws_client_set_fragment_received_callback` so that received bytes are indicated as they arrive instead of once per WebSocket message. ]*/
 TEST_FUNCTION(wsio_open_opens_the_underlying_uws_instance)
 {
     // arrange
@@ -579,6 +593,7 @@ TEST_FUNCTION(wsio_open_opens_the_underlying_uws_instance)
     wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(uws_client_set_fragment_received_callback(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(uws_client_open_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
@@ -601,6 +616,7 @@ TEST_FUNCTION(when_opening_the_uws_instance_fails_wsio_open_fails)
     wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(uws_client_set_fragment_received_callback(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(uws_client_open_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .SetReturn(1);
 
@@ -615,6 +631,29 @@ TEST_FUNCTION(when_opening_the_uws_instance_fails_wsio_open_fails)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* Tests_SRS_WSIO_01_190: [ If `uws_client_set_fragment_received_callback` fails, `wsio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_setting_the_fragment_received_callback_fails_wsio_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    int result;
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_set_fragment_received_callback(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* Tests_SRS_WSIO_01_131: [ `wsio_open` when already OPEN or OPENING shall fail and return a non-zero value. ]*/
 TEST_FUNCTION(wsio_open_when_already_opening_fails)
 {
@@ -746,6 +785,7 @@ TEST_FUNCTION(wsio_open_after_close_succeeds)
     g_on_ws_close_complete(g_on_ws_close_complete_context);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(uws_client_set_fragment_received_callback(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(uws_client_open_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
@@ -1602,6 +1642,58 @@ TEST_FUNCTION(when_on_underlying_ws_open_complete_is_called_when_CLOSING_it_does
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* on_ws_fragment_received */
+
+/* Tests_SRS_WSIO_01_188: [ Each slice indicated by `on_underlying_ws_fragment_received` shall be handled exactly as a frame indicated by `on_underlying_ws_frame_received`. ]*/
+/* Tests_SRS_WSIO_01_189: [ The `message_offset` and `is_final` arguments shall be ignored, the IO being a byte stream. ]*/
+TEST_FUNCTION(when_on_underlying_ws_fragment_received_is_called_the_slice_is_indicated_up)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    const unsigned char test_buffer[] = { 0x42, 0x43 };
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(test_buffer)))
+        .ValidateArgumentBuffer(2, test_buffer, sizeof(test_buffer));
+
+    // act
+    g_on_ws_fragment_received(g_on_ws_fragment_received_context, WS_FRAME_TYPE_BINARY, test_buffer, sizeof(test_buffer), 4096, false);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_188: [ Each slice indicated by `on_underlying_ws_fragment_received` shall be handled exactly as a frame indicated by `on_underlying_ws_frame_received`. ]*/
+TEST_FUNCTION(when_on_underlying_ws_fragment_received_is_called_with_a_text_slice_an_error_is_indicated)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    const unsigned char test_buffer[] = { 0x42 };
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_error((void*)0x4244));
+
+    // act
+    g_on_ws_fragment_received(g_on_ws_fragment_received_context, WS_FRAME_TYPE_TEXT, test_buffer, sizeof(test_buffer), 0, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* on_ws_frame_received */
 
 /* Tests_SRS_WSIO_01_124: [ When `on_underlying_ws_frame_received` is called the bytes in the frame shall be indicated by calling the `on_bytes_received` callback passed to `wsio_open`. ]*/
@@ -53,6 +53,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
 MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send_vectored, CONCRETE_IO_HANDLE, handle, const CONSTBUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+MOCK_FUNCTION_END(0)
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 /*this function will clone an option given by name and value*/
@@ -113,6 +115,19 @@ const IO_INTERFACE_DESCRIPTION test_io_description =
     test_xio_setoption
 };
 
+const IO_INTERFACE_DESCRIPTION test_io_description_with_send_vectored =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_send_vectored
+};
+
 static TEST_MUTEX_HANDLE g_testByTest;
 
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
@@ -172,6 +187,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const CONSTBUFFER*, void*);
 
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
@@ -774,6 +790,235 @@ TEST_FUNCTION(xio_send_with_non_NULL_buffer_and_zero_length_passes_the_args_down
     xio_destroy(handle);
 }
 
+/* xio_send_vectored */
+
+/* Tests_SRS_XIO_01_028: [ If xio is NULL, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(xio_send_vectored_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 43 };
+    CONSTBUFFER buffers[1];
+    buffers[0].buffer = send_data;
+    buffers[0].size = sizeof(send_data);
+
+    // act
+    result = xio_send_vectored(NULL, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_029: [ If buffers is NULL or buffer_count is 0, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(xio_send_vectored_with_NULL_buffers_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_vectored, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_vectored(handle, NULL, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_029: [ If buffers is NULL or buffer_count is 0, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(xio_send_vectored_with_zero_buffer_count_fails)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 43 };
+    CONSTBUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_vectored, NULL);
+    buffers[0].buffer = send_data;
+    buffers[0].size = sizeof(send_data);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_vectored(handle, buffers, 0, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_030: [ If the concrete IO implements concrete_io_send_vectored, xio_send_vectored shall pass buffers, buffer_count, on_send_complete and callback_context to it. ]*/
+/* Tests_SRS_XIO_01_037: [ On success, xio_send_vectored shall return 0. ]*/
+TEST_FUNCTION(xio_send_vectored_calls_the_underlying_concrete_io_send_vectored_and_succeeds)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x82, 0x02 };
+    unsigned char payload[] = { 0x42, 43 };
+    CONSTBUFFER buffers[2];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_vectored, NULL);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = sizeof(payload);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_vectored(TEST_CONCRETE_IO_HANDLE, buffers, 2, test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_031: [ If concrete_io_send_vectored fails, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(when_the_concrete_io_send_vectored_fails_then_xio_send_vectored_fails)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 43 };
+    CONSTBUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_vectored, NULL);
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_vectored(TEST_CONCRETE_IO_HANDLE, buffers, 1, test_on_send_complete, (void*)0x4242))
+        .SetReturn(42);
+
+    // act
+    result = xio_send_vectored(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_032: [ Otherwise xio_send_vectored shall concatenate the buffers into one allocated buffer and pass it to concrete_io_send. ]*/
+/* Tests_SRS_XIO_01_036: [ The concatenated buffer shall be freed once concrete_io_send returns. ]*/
+/* Tests_SRS_XIO_01_037: [ On success, xio_send_vectored shall return 0. ]*/
+TEST_FUNCTION(xio_send_vectored_without_concrete_io_send_vectored_concatenates_and_calls_concrete_io_send)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x82, 0x02 };
+    unsigned char payload[] = { 0x42, 43 };
+    unsigned char expected_bytes[] = { 0x82, 0x02, 0x42, 43 };
+    CONSTBUFFER buffers[3];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = NULL;
+    buffers[1].size = 0;
+    buffers[2].buffer = payload;
+    buffers[2].size = sizeof(payload);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(expected_bytes)));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, sizeof(expected_bytes), test_on_send_complete, (void*)0x4242))
+        .ValidateArgumentBuffer(2, expected_bytes, sizeof(expected_bytes));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 3, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_033: [ If the concrete IO does not implement concrete_io_send_vectored and all buffers are empty, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(xio_send_vectored_without_concrete_io_send_vectored_and_all_buffers_empty_fails)
+{
+    // arrange
+    int result;
+    CONSTBUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = NULL;
+    buffers[0].size = 0;
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_vectored(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_034: [ If allocating the concatenated buffer fails, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_concatenated_buffer_fails_then_xio_send_vectored_fails)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 43 };
+    CONSTBUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(payload)))
+        .SetReturn(NULL);
+
+    // act
+    result = xio_send_vectored(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_035: [ If concrete_io_send fails, xio_send_vectored shall return a non-zero value. ]*/
+TEST_FUNCTION(when_concrete_io_send_fails_then_xio_send_vectored_fails)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 43 };
+    CONSTBUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(payload)));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, sizeof(payload), test_on_send_complete, (void*)0x4242))
+        .SetReturn(42);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
 /* xio_dowork */
 
 /* Tests_SRS_XIO_01_012: [xio_dowork shall call the concrete IO implementation specified in xio_create, by calling the concrete_xio_dowork function.] */